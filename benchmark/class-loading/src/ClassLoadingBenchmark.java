@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import dalvik.system.PathClassLoader;
+import java.io.File;
+
+public class ClassLoadingBenchmark {
+    // Each class loader lists the dex file of the benchmark this many times, which gives
+    // class paths as long as those of apps with many shared libraries.
+    private static final int DEX_FILES_PER_LOADER = 8;
+    // Depth of the delegation chain, 48 dex files in total.
+    private static final int CHAIN_DEPTH = 6;
+
+    private static final String[] MISSING_CLASSES = new String[16];
+    static {
+        for (int i = 0; i < MISSING_CLASSES.length; ++i) {
+            MISSING_CLASSES[i] = "benchmark.missing.Class" + i;
+        }
+    }
+
+    private final ClassLoader singleLoader;
+    private final ClassLoader deepChain;
+
+    public ClassLoadingBenchmark() {
+        String dexPath = System.getProperty("java.class.path");
+        StringBuilder classPath = new StringBuilder(dexPath);
+        for (int i = 1; i < DEX_FILES_PER_LOADER; ++i) {
+            classPath.append(File.pathSeparator).append(dexPath);
+        }
+        singleLoader = new PathClassLoader(classPath.toString(), null);
+        ClassLoader loader = null;
+        for (int i = 0; i < CHAIN_DEPTH; ++i) {
+            loader = new PathClassLoader(classPath.toString(), loader);
+        }
+        deepChain = loader;
+    }
+
+    // Every lookup misses in all dex files of the class loader.
+    public void timeMissSingleLoader(int count) {
+        lookUpMissingClasses(singleLoader, count);
+    }
+
+    // Every lookup misses in all dex files of each class loader of the chain.
+    public void timeMissDeepChain(int count) {
+        lookUpMissingClasses(deepChain, count);
+    }
+
+    private static void lookUpMissingClasses(ClassLoader loader, int count) {
+        for (int i = 0; i < count; ++i) {
+            try {
+                Class.forName(MISSING_CLASSES[i & (MISSING_CLASSES.length - 1)], false, loader);
+                throw new Error("Unexpected class");
+            } catch (ClassNotFoundException expected) {
+            }
+        }
+    }
+
+    // Standalone runner. Prints the time per lookup of each benchmark.
+    public static void main(String[] args) {
+        int count = (args.length > 0) ? Integer.parseInt(args[0]) : 10000;
+        ClassLoadingBenchmark benchmark = new ClassLoadingBenchmark();
+        // Warm up, which also builds the class path indexes.
+        benchmark.timeMissSingleLoader(count / 10 + 1);
+        benchmark.timeMissDeepChain(count / 10 + 1);
+        long start = System.nanoTime();
+        benchmark.timeMissSingleLoader(count);
+        System.out.println("MissSingleLoader: " + (System.nanoTime() - start) / count + " ns");
+        start = System.nanoTime();
+        benchmark.timeMissDeepChain(count);
+        System.out.println("MissDeepChain: " + (System.nanoTime() - start) / count + " ns");
+    }
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.reflect.Method;
+
+public class LoopKernelsBenchmark {
+    private static final int SIZE = 1024;
+
+    private final int[] ints1 = new int[SIZE];
+    private final int[] ints2 = new int[SIZE];
+    private final long[] longs = new long[SIZE];
+    private final float[] floats1 = new float[SIZE];
+    private final float[] floats2 = new float[SIZE];
+    private final double[] doubles = new double[SIZE];
+
+    public long result;
+
+    public LoopKernelsBenchmark() {
+        for (int i = 0; i < SIZE; ++i) {
+            ints1[i] = i * 31 + 7;
+            ints2[i] = (i ^ 0x5a5a) + 1;
+            longs[i] = i * 0x9e3779b97f4a7c15L;
+            floats1[i] = i * 0.5f + 1.0f;
+            floats2[i] = i * 0.25f + 2.0f;
+            doubles[i] = i * 0.125 + 3.0;
+        }
+    }
+
+    // Independent loads feeding a multiply-add: the loads should be issued early.
+    public void timeDotProduct(int count) {
+        int[] a = ints1;
+        int[] b = ints2;
+        long sum = 0;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < a.length; ++i) {
+                sum += a[i] * b[i];
+            }
+        }
+        result = sum;
+    }
+
+    // Array accesses whose bounds checks are not eliminated, so that on x86-64 the
+    // length is read by the memory operand of the bounds check.
+    public void timeIndirectSum(int count) {
+        int[] a = ints1;
+        int[] idx = ints2;
+        long sum = 0;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < SIZE; ++i) {
+                sum += a[idx[i] & (SIZE - 1)];
+            }
+        }
+        result = sum;
+    }
+
+    // Long-latency integer divisions interleaved with independent arithmetic.
+    public void timeDivideAndAccumulate(int count) {
+        int[] a = ints1;
+        int[] b = ints2;
+        long sum = 0;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < a.length; ++i) {
+                int q = a[i] / b[i];
+                int r = (a[i] << 3) - (a[i] >> 2) + i;
+                sum += q + r;
+            }
+        }
+        result = sum;
+    }
+
+    // Constant divisors, which code generation turns into multiplications.
+    public void timeDivideByConstant(int count) {
+        long[] a = longs;
+        long sum = 0;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < a.length; ++i) {
+                sum += a[i] / 7 + a[i] % 10;
+            }
+        }
+        result = sum;
+    }
+
+    // Floating point multiplications and additions from two streams.
+    public void timeSaxpy(int count) {
+        float[] x = floats1;
+        float[] y = floats2;
+        float alpha = 1.0001f;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < x.length; ++i) {
+                y[i] = alpha * x[i] + y[i];
+            }
+        }
+        result = (long) y[SIZE - 1];
+    }
+
+    // A polynomial evaluation with a long dependency chain and a division.
+    public void timePolynomial(int count) {
+        double[] a = doubles;
+        double sum = 0.0;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < a.length; ++i) {
+                double v = a[i];
+                sum += ((v * 0.5 + 1.5) * v + 2.5) * v / (v + 1.0);
+            }
+        }
+        result = (long) sum;
+    }
+
+    // Type conversions between integer and floating point values.
+    public void timeConversions(int count) {
+        int[] a = ints1;
+        float[] f = floats1;
+        long sum = 0;
+        for (int n = 0; n < count; ++n) {
+            for (int i = 0; i < a.length; ++i) {
+                sum += (long) (a[i] * f[i]) + (int) f[i];
+            }
+        }
+        result = sum;
+    }
+
+    // Standalone runner, used by tools/compare-instruction-scheduling.sh to run the kernels
+    // outside of a benchmarking harness. Prints the time per iteration of each kernel.
+    public static void main(String[] args) throws Exception {
+        int count = (args.length > 0) ? Integer.parseInt(args[0]) : 1000;
+        LoopKernelsBenchmark benchmark = new LoopKernelsBenchmark();
+        for (Method method : LoopKernelsBenchmark.class.getDeclaredMethods()) {
+            if (!method.getName().startsWith("time")) {
+                continue;
+            }
+            // Warm up, then keep the best of a few runs to reduce noise.
+            method.invoke(benchmark, count / 10 + 1);
+            long best = Long.MAX_VALUE;
+            for (int run = 0; run < 5; ++run) {
+                long start = System.nanoTime();
+                method.invoke(benchmark, count);
+                best = Math.min(best, System.nanoTime() - start);
+            }
+            System.out.println(method.getName().substring(4) + ": " + (best / count) + " ns");
+        }
+    }
+}
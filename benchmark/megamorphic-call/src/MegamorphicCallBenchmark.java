@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class MegamorphicCallBenchmark {
+    public void timeVirtualCallSkewed(int count) {
+        int sum = 0;
+        Shape[] arr = skewedShapes;
+        for (int i = 0; i < count; ++i) {
+            sum += arr[i & 1023].sides();
+        }
+        result = sum;
+    }
+
+    public void timeVirtualCallUniform(int count) {
+        int sum = 0;
+        Shape[] arr = uniformShapes;
+        for (int i = 0; i < count; ++i) {
+            sum += arr[i & 1023].sides();
+        }
+        result = sum;
+    }
+
+    public void timeInterfaceCallSkewed(int count) {
+        int sum = 0;
+        Shape[] arr = skewedShapes;
+        for (int i = 0; i < count; ++i) {
+            Named named = arr[i & 1023];
+            sum += named.nameLength();
+        }
+        result = sum;
+    }
+
+    public void timeInterfaceCallUniform(int count) {
+        int sum = 0;
+        Shape[] arr = uniformShapes;
+        for (int i = 0; i < count; ++i) {
+            Named named = arr[i & 1023];
+            sum += named.nameLength();
+        }
+        result = sum;
+    }
+
+    // Creates 1024 shapes of 8 different classes. If `skewed`, 80% of them are triangles
+    // and 10% are squares, otherwise all classes are equally frequent.
+    public static Shape[] createArray(boolean skewed) {
+        Shape[] shapes = {
+                new Triangle(),
+                new Square(),
+                new Pentagon(),
+                new Hexagon(),
+                new Heptagon(),
+                new Octagon(),
+                new Nonagon(),
+                new Decagon(),
+        };
+        Shape[] array = new Shape[1024];
+        for (int i = 0; i < array.length; ++i) {
+            int percent = (i * 37) % 100;
+            if (!skewed) {
+                array[i] = shapes[i % shapes.length];
+            } else if (percent < 80) {
+                array[i] = shapes[0];
+            } else if (percent < 90) {
+                array[i] = shapes[1];
+            } else {
+                array[i] = shapes[2 + (i % (shapes.length - 2))];
+            }
+        }
+        return array;
+    }
+    Shape[] skewedShapes = createArray(/* skewed= */ true);
+    Shape[] uniformShapes = createArray(/* skewed= */ false);
+    int result;
+}
+
+interface Named {
+    int nameLength();
+}
+
+abstract class Shape implements Named {
+    public abstract int sides();
+    public int nameLength() { return getClass().getSimpleName().length(); }
+}
+
+class Triangle extends Shape {
+    public int sides() { return 3; }
+    public int nameLength() { return 8; }
+}
+class Square extends Shape {
+    public int sides() { return 4; }
+    public int nameLength() { return 6; }
+}
+class Pentagon extends Shape { public int sides() { return 5; } }
+class Hexagon extends Shape { public int sides() { return 6; } }
+class Heptagon extends Shape { public int sides() { return 7; } }
+class Octagon extends Shape { public int sides() { return 8; } }
+class Nonagon extends Shape { public int sides() { return 9; } }
+class Decagon extends Shape { public int sides() { return 10; } }
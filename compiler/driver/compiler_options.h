@@ -49,6 +49,7 @@ class DexFile;
 enum class InstructionSet;
 class InstructionSetFeatures;
 class ProfileCompilationInfo;
+class RegisterAllocatorTest;
 
 // Enum for CheckProfileMethodsCompiled. Outside CompilerOptions so it can be forward-declared.
 enum class ProfileMethodsCheck : uint8_t {
@@ -132,6 +133,12 @@ class CompilerOptions final {
     return num_dalvik_instructions > huge_method_threshold_;
   }
 
+  // Returns the maximum number of instructions in a region when compiling huge methods
+  // by regions, or zero if huge methods are not compiled by regions.
+  size_t GetHugeMethodRegionSize() const {
+    return huge_method_region_size_;
+  }
+
   bool IsLargeMethod(size_t num_dalvik_instructions) const {
     return num_dalvik_instructions > large_method_threshold_;
   }
@@ -362,6 +369,10 @@ class CompilerOptions final {
     return resolve_startup_const_strings_;
   }
 
+  bool IsInstructionSchedulingEnabled() const {
+    return instruction_scheduling_;
+  }
+
   ProfileMethodsCheck CheckProfiledMethodsCompiled() const {
     return check_profiled_methods_;
   }
@@ -395,6 +406,7 @@ class CompilerOptions final {
 
   CompilerFilter::Filter compiler_filter_;
   size_t huge_method_threshold_;
+  size_t huge_method_region_size_;
   size_t large_method_threshold_;
   size_t num_dex_methods_threshold_;
   size_t inline_max_code_units_;
@@ -481,6 +493,10 @@ class CompilerOptions final {
   // Whether we attempt to run class initializers for app image classes.
   bool initialize_app_image_classes_;
 
+  // Whether instructions are reordered within basic blocks according to the latency model of
+  // the target instruction set.
+  bool instruction_scheduling_;
+
   // When running profile-guided compilation, check that methods intended to be compiled end
   // up compiled and are not punted.
   ProfileMethodsCheck check_profiled_methods_;
@@ -501,6 +517,7 @@ class CompilerOptions final {
   friend class Dex2Oat;
   friend class CommonCompilerDriverTest;
   friend class CommonCompilerTestImpl;
+  friend class RegisterAllocatorTest;
   friend class jit::JitCompiler;
   friend class verifier::VerifierDepsTest;
   friend class linker::Arm64RelativePatcherTest;
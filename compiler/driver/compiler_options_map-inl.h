@@ -57,6 +57,7 @@ inline bool ReadCompilerOptions(Base& map, CompilerOptions* options, std::string
   }
   map.AssignIfExists(Base::CompileArtTest, &options->compile_art_test_);
   map.AssignIfExists(Base::HugeMethodMaxThreshold, &options->huge_method_threshold_);
+  map.AssignIfExists(Base::HugeMethodRegionSize, &options->huge_method_region_size_);
   map.AssignIfExists(Base::LargeMethodMaxThreshold, &options->large_method_threshold_);
   map.AssignIfExists(Base::NumDexMethodsThreshold, &options->num_dex_methods_threshold_);
   map.AssignIfExists(Base::InlineMaxCodeUnitsThreshold, &options->inline_max_code_units_);
@@ -82,7 +83,8 @@ inline bool ReadCompilerOptions(Base& map, CompilerOptions* options, std::string
     options->dump_cfg_append_ = true;
   }
   if (map.Exists(Base::RegisterAllocationStrategy)) {
-    if (!options->ParseRegisterAllocationStrategy(*map.Get(Base::DumpInitFailures), error_msg)) {
+    if (!options->ParseRegisterAllocationStrategy(*map.Get(Base::RegisterAllocationStrategy),
+                                                  error_msg)) {
       return false;
     }
   }
@@ -93,6 +95,7 @@ inline bool ReadCompilerOptions(Base& map, CompilerOptions* options, std::string
   }
   map.AssignIfExists(Base::ResolveStartupConstStrings, &options->resolve_startup_const_strings_);
   map.AssignIfExists(Base::InitializeAppImageClasses, &options->initialize_app_image_classes_);
+  map.AssignIfExists(Base::InstructionScheduling, &options->instruction_scheduling_);
   if (map.Exists(Base::CheckProfiledMethods)) {
     options->check_profiled_methods_ = *map.Get(Base::CheckProfiledMethods);
   }
@@ -133,6 +136,12 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
           .template WithType<unsigned int>()
           .WithHelp("threshold size for a huge method for compiler filter tuning.")
           .IntoKey(Map::HugeMethodMaxThreshold)
+      .Define("--huge-method-region-size=_")
+          .template WithType<unsigned int>()
+          .WithHelp("If non-zero, compile huge methods instead of skipping them, restricting the\n"
+                    "optimizations with superlinear cost to regions of at most this many\n"
+                    "instructions.")
+          .IntoKey(Map::HugeMethodRegionSize)
       .Define("--large-method-max=_")
           .template WithType<unsigned int>()
           .WithHelp("threshold size for a large method for compiler filter tuning.")
@@ -195,7 +204,8 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
           .IntoKey(Map::DumpPassTimings)
 
       .Define({"--dump-stats"})
-          .WithHelp("Display overall compilation statistics.")
+          .WithHelp("Display overall compilation statistics, including the time spent in each\n"
+                    "optimization pass and the slowest methods to compile.")
           .IntoKey(Map::DumpStats)
 
       .Define("--debuggable")
@@ -233,6 +243,10 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
 
       .Define("--register-allocation-strategy=_")
           .template WithType<std::string>()
+          .WithHelp("linear-scan (default), graph-color, or graph-color-hot to use graph\n"
+                    "coloring only for methods that are hot in the profile and for JIT\n"
+                    "compilations of hot methods. Graph coloring trades compile time for\n"
+                    "fewer spills; methods too large for it fall back to linear-scan.")
           .IntoKey(Map::RegisterAllocationStrategy)
 
       .Define("--resolve-startup-const-strings=_")
@@ -247,6 +261,13 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
           .WithValueMap({{"false", false}, {"true", true}})
           .IntoKey(Map::InitializeAppImageClasses)
 
+      .Define("--instruction-scheduling=_")
+          .template WithType<bool>()
+          .WithValueMap({{"false", false}, {"true", true}})
+          .WithHelp("If true (the default), the compiler reorders instructions in loops to hide\n"
+                    "latencies on instruction sets that have a scheduler (arm, arm64, x86_64).")
+          .IntoKey(Map::InstructionScheduling)
+
       .Define("--verbose-methods=_")
           .template WithType<ParseStringList<','>>()
           .WithHelp("Restrict the dumped CFG data to methods whose name is listed.\n"
@@ -71,11 +71,21 @@ bool HGraphBuilder::SkipCompilation(size_t number_of_branches) {
 
   const CompilerOptions& compiler_options = code_generator_->GetCompilerOptions();
   CompilerFilter::Filter compiler_filter = compiler_options.GetCompilerFilter();
+  const uint32_t code_units = code_item_accessor_.InsnsSizeInCodeUnits();
+  if (compiler_options.IsHugeMethod(code_units) &&
+      compiler_options.GetHugeMethodRegionSize() != 0u) {
+    VLOG(compiler) << "Compile huge method by regions "
+                   << dex_file_->PrettyMethod(dex_compilation_unit_->GetDexMethodIndex())
+                   << ": " << code_units << " code units";
+    graph_->SetMaxRegionSize(compiler_options.GetHugeMethodRegionSize());
+    MaybeRecordStat(compilation_stats_, MethodCompilationStat::kCompiledHugeMethodByRegions);
+    return false;
+  }
+
   if (compiler_filter == CompilerFilter::kEverything) {
     return false;
   }
 
-  const uint32_t code_units = code_item_accessor_.InsnsSizeInCodeUnits();
   if (compiler_options.IsHugeMethod(code_units)) {
     VLOG(compiler) << "Skip compilation of huge method "
                    << dex_file_->PrettyMethod(dex_compilation_unit_->GetDexMethodIndex())
@@ -51,6 +51,7 @@
 #include "gc/space/image_space.h"
 #include "intern_table.h"
 #include "intrinsics.h"
+#include "jit/profiling_info.h"
 #include "mirror/array-inl.h"
 #include "mirror/object_array-inl.h"
 #include "mirror/object_reference.h"
@@ -308,6 +309,33 @@ uint32_t CodeGenerator::GetArrayDataOffset(HArrayGet* array_get) {
       : mirror::Array::DataOffset(DataType::Size(array_get->GetType())).Uint32Value();
 }
 
+BranchCache* CodeGenerator::GetBranchCacheToUpdate(HGraph* graph, HIf* if_instruction) {
+  if (!graph->IsCompilingBaseline()) {
+    return nullptr;
+  }
+  // Only the JIT attaches a `ProfilingInfo` to the graph.
+  ProfilingInfo* info = graph->GetProfilingInfo();
+  if (info == nullptr || if_instruction->InputAt(0)->IsConstant()) {
+    return nullptr;
+  }
+  return info->GetBranchCache(if_instruction->GetDexPc());
+}
+
+uint16_t* CodeGenerator::GetSwitchCountsToUpdate(HGraph* graph, HPackedSwitch* packed_switch) {
+  if (!graph->IsCompilingBaseline()) {
+    return nullptr;
+  }
+  ProfilingInfo* info = graph->GetProfilingInfo();
+  if (info == nullptr) {
+    return nullptr;
+  }
+  SwitchCache* cache = info->GetSwitchCache(packed_switch->GetDexPc());
+  if (cache == nullptr || cache->GetNumberOfEntries() != packed_switch->GetNumEntries()) {
+    return nullptr;
+  }
+  return info->GetSwitchCounts(cache);
+}
+
 bool CodeGenerator::GoesToNextBlock(HBasicBlock* current, HBasicBlock* next) const {
   DCHECK_EQ((*block_order_)[current_block_index_], current);
   return GetNextBlockToEmit() == FirstNonEmptyBlock(next);
@@ -73,6 +73,7 @@ constexpr uint32_t shifted_initialized_value =
     enum_cast<uint32_t>(ClassStatus::kInitialized) << (status_lsb_position % kBitsPerByte);
 
 class Assembler;
+class BranchCache;
 class CodeGenerator;
 class CompilerOptions;
 class StackMapStream;
@@ -462,6 +463,12 @@ class CodeGenerator : public DeletableArenaObject<kArenaAllocCodeGenerator> {
   // accessing the String's `value` field in String intrinsics.
   static uint32_t GetArrayDataOffset(HArrayGet* array_get);
 
+  // Helpers that return the counters that baseline JIT code must update when executing
+  // the given branch, or null if the branch is not profiled. The counters of a switch are
+  // indexed by the switch entry, followed by the counter for the default target.
+  static BranchCache* GetBranchCacheToUpdate(HGraph* graph, HIf* if_instruction);
+  static uint16_t* GetSwitchCountsToUpdate(HGraph* graph, HPackedSwitch* packed_switch);
+
   void EmitParallelMoves(Location from1,
                          Location to1,
                          DataType::Type type1,
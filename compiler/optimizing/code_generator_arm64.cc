@@ -3825,6 +3825,27 @@ void LocationsBuilderARM64::VisitIf(HIf* if_instr) {
 }
 
 void InstructionCodeGeneratorARM64::VisitIf(HIf* if_instr) {
+  BranchCache* cache = CodeGenerator::GetBranchCacheToUpdate(GetGraph(), if_instr);
+  if (cache != nullptr) {
+    static_assert(
+        BranchCache::TrueOffset().Int32Value() - BranchCache::FalseOffset().Int32Value() == 2);
+    DCHECK(IsBooleanValueOrMaterializedCondition(if_instr->InputAt(0)));
+    uint64_t address =
+        reinterpret_cast64<uint64_t>(cache) + BranchCache::FalseOffset().Int32Value();
+    vixl::aarch64::Label done;
+    UseScratchRegisterScope temps(codegen_->GetVIXLAssembler());
+    Register temp = temps.AcquireX();
+    Register counter = temps.AcquireW();
+    __ Mov(temp, address);
+    __ Add(temp, temp, Operand(InputRegisterAt(if_instr, 0), UXTW, 1));
+    __ Ldrh(counter, MemOperand(temp));
+    __ Add(counter, counter, 1);
+    // Saturate the counter.
+    __ Tbnz(counter, 16, &done);
+    __ Strh(counter, MemOperand(temp));
+    __ Bind(&done);
+  }
+
   HBasicBlock* true_successor = if_instr->IfTrueSuccessor();
   HBasicBlock* false_successor = if_instr->IfFalseSuccessor();
   vixl::aarch64::Label* true_target = codegen_->GetLabelOf(true_successor);
@@ -4576,12 +4597,18 @@ void CodeGeneratorARM64::MaybeGenerateInlineCacheCheck(HInstruction* instruction
     DCHECK(info != nullptr);
     InlineCache* cache = info->GetInlineCache(instruction->GetDexPc());
     uint64_t address = reinterpret_cast64<uint64_t>(cache);
-    vixl::aarch64::Label done;
+    vixl::aarch64::Label done, update_cache;
     __ Mov(x8, address);
     __ Ldr(x9, MemOperand(x8, InlineCache::ClassesOffset().Int32Value()));
-    // Fast path for a monomorphic cache.
+    // Fast path for a monomorphic cache: just count the receiver.
     __ Cmp(klass, x9);
-    __ B(eq, &done);
+    __ B(ne, &update_cache);
+    __ Ldrh(w9, MemOperand(x8, InlineCache::CountsOffset().Int32Value()));
+    __ Add(w9, w9, 1);
+    __ Tbnz(w9, 16, &done);
+    __ Strh(w9, MemOperand(x8, InlineCache::CountsOffset().Int32Value()));
+    __ B(&done);
+    __ Bind(&update_cache);
     InvokeRuntime(kQuickUpdateInlineCache, instruction, instruction->GetDexPc());
     __ Bind(&done);
   }
@@ -6498,6 +6525,28 @@ void InstructionCodeGeneratorARM64::VisitPackedSwitch(HPackedSwitch* switch_inst
   // ranges and emit the tables only as required.
   static constexpr int32_t kJumpTableInstructionThreshold = 1* MB / kMaxExpectedSizePerHInstruction;
 
+  uint16_t* counts = CodeGenerator::GetSwitchCountsToUpdate(GetGraph(), switch_instr);
+  if (counts != nullptr) {
+    // Count the taken target, using `num_entries` as the index of the default target.
+    vixl::aarch64::Label done;
+    UseScratchRegisterScope temps(codegen_->GetVIXLAssembler());
+    Register index = temps.AcquireW();
+    Register temp = temps.AcquireX();
+    __ Mov(index, lower_bound);
+    __ Sub(index, value_reg, index);
+    __ Mov(temp.W(), num_entries);
+    __ Cmp(index, temp.W());
+    __ Csel(index, index, temp.W(), lo);
+    __ Mov(temp, reinterpret_cast64<uint64_t>(counts));
+    __ Add(temp, temp, Operand(index, UXTW, 1));
+    __ Ldrh(index, MemOperand(temp));
+    __ Add(index, index, 1);
+    // Saturate the counter.
+    __ Tbnz(index, 16, &done);
+    __ Strh(index, MemOperand(temp));
+    __ Bind(&done);
+  }
+
   if (num_entries <= kPackedSwitchCompareJumpThreshold ||
       // Current instruction id is an upper bound of the number of HIRs in the graph.
       GetGraph()->GetCurrentInstructionId() > kJumpTableInstructionThreshold) {
@@ -2967,6 +2967,28 @@ void LocationsBuilderARMVIXL::VisitIf(HIf* if_instr) {
 }
 
 void InstructionCodeGeneratorARMVIXL::VisitIf(HIf* if_instr) {
+  BranchCache* cache = CodeGenerator::GetBranchCacheToUpdate(GetGraph(), if_instr);
+  if (cache != nullptr) {
+    static_assert(
+        BranchCache::TrueOffset().Int32Value() - BranchCache::FalseOffset().Int32Value() == 2);
+    DCHECK(IsBooleanValueOrMaterializedCondition(if_instr->InputAt(0)));
+    DCHECK(!codegen_->HasEmptyFrame());
+    uint32_t address =
+        reinterpret_cast32<uint32_t>(cache) + BranchCache::FalseOffset().Int32Value();
+    vixl32::Label done;
+    UseScratchRegisterScope temps(GetVIXLAssembler());
+    vixl32::Register counter = temps.Acquire();
+    __ Mov(lr, address);
+    __ Add(lr, lr, Operand(InputRegisterAt(if_instr, 0), ShiftType::LSL, 1));
+    __ Ldrh(counter, MemOperand(lr));
+    __ Add(counter, counter, 1);
+    // Saturate the counter.
+    __ Tst(counter, 0x10000);
+    __ B(ne, &done, /* is_far_target= */ false);
+    __ Strh(counter, MemOperand(lr));
+    __ Bind(&done);
+  }
+
   HBasicBlock* true_successor = if_instr->IfTrueSuccessor();
   HBasicBlock* false_successor = if_instr->IfFalseSuccessor();
   vixl32::Label* true_target = codegen_->GoesToNextBlock(if_instr->GetBlock(), true_successor) ?
@@ -3622,14 +3644,21 @@ void CodeGeneratorARMVIXL::MaybeGenerateInlineCacheCheck(HInstruction* instructi
     DCHECK(info != nullptr);
     InlineCache* cache = info->GetInlineCache(instruction->GetDexPc());
     uint32_t address = reinterpret_cast32<uint32_t>(cache);
-    vixl32::Label done;
+    vixl32::Label done, update_cache;
     UseScratchRegisterScope temps(GetVIXLAssembler());
     temps.Exclude(ip);
     __ Mov(r4, address);
     __ Ldr(ip, MemOperand(r4, InlineCache::ClassesOffset().Int32Value()));
-    // Fast path for a monomorphic cache.
+    // Fast path for a monomorphic cache: just count the receiver.
     __ Cmp(klass, ip);
-    __ B(eq, &done, /* is_far_target= */ false);
+    __ B(ne, &update_cache, /* is_far_target= */ false);
+    __ Ldrh(ip, MemOperand(r4, InlineCache::CountsOffset().Int32Value()));
+    __ Add(ip, ip, 1);
+    __ Tst(ip, 0x10000);
+    __ B(ne, &done, /* is_far_target= */ false);
+    __ Strh(ip, MemOperand(r4, InlineCache::CountsOffset().Int32Value()));
+    __ B(&done, /* is_far_target= */ false);
+    __ Bind(&update_cache);
     InvokeRuntime(kQuickUpdateInlineCache, instruction, instruction->GetDexPc());
     __ Bind(&done);
   }
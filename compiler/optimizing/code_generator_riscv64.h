@@ -20,4 +20,8 @@
 #include "code_generator.h"
 #include "driver/compiler_options.h"
 
+// There is no optimizing code generator for riscv64 yet. `OptimizingCompiler` does not accept
+// the instruction set, so methods run in nterp, and only JNI stubs are compiled, with the
+// `Riscv64JNIMacroAssembler`.
+
 #endif  // ART_COMPILER_OPTIMIZING_CODE_GENERATOR_RISCV64_H_
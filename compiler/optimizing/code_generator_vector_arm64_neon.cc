@@ -278,6 +278,34 @@ void InstructionCodeGeneratorARM64Neon::VisitVecReduce(HVecReduce* instruction)
           UNREACHABLE();
       }
       break;
+    case DataType::Type::kFloat32:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      switch (instruction->GetReductionKind()) {
+        case HVecReduce::kMin:
+          __ Fminv(dst.S(), src.V4S());
+          break;
+        case HVecReduce::kMax:
+          __ Fmaxv(dst.S(), src.V4S());
+          break;
+        default:
+          LOG(FATAL) << "Unsupported SIMD floating-point sum";
+          UNREACHABLE();
+      }
+      break;
+    case DataType::Type::kFloat64:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      switch (instruction->GetReductionKind()) {
+        case HVecReduce::kMin:
+          __ Fminp(dst.D(), src.V2D());
+          break;
+        case HVecReduce::kMax:
+          __ Fmaxp(dst.D(), src.V2D());
+          break;
+        default:
+          LOG(FATAL) << "Unsupported SIMD floating-point sum";
+          UNREACHABLE();
+      }
+      break;
     default:
       LOG(FATAL) << "Unsupported SIMD type: " << instruction->GetPackedType();
       UNREACHABLE();
@@ -2151,11 +2151,33 @@ void InstructionCodeGeneratorX86::GenerateTestAndBranch(HInstruction* instructio
 void LocationsBuilderX86::VisitIf(HIf* if_instr) {
   LocationSummary* locations = new (GetGraph()->GetAllocator()) LocationSummary(if_instr);
   if (IsBooleanValueOrMaterializedCondition(if_instr->InputAt(0))) {
-    locations->SetInAt(0, Location::Any());
+    if (CodeGenerator::GetBranchCacheToUpdate(GetGraph(), if_instr) != nullptr) {
+      // The condition indexes the branch counters.
+      locations->SetInAt(0, Location::RequiresRegister());
+    } else {
+      locations->SetInAt(0, Location::Any());
+    }
   }
 }
 
 void InstructionCodeGeneratorX86::VisitIf(HIf* if_instr) {
+  BranchCache* cache = CodeGenerator::GetBranchCacheToUpdate(GetGraph(), if_instr);
+  if (cache != nullptr) {
+    static_assert(
+        BranchCache::TrueOffset().Int32Value() - BranchCache::FalseOffset().Int32Value() == 2);
+    DCHECK(IsBooleanValueOrMaterializedCondition(if_instr->InputAt(0)));
+    Register condition = if_instr->GetLocations()->InAt(0).AsRegister<Register>();
+    uint32_t address =
+        reinterpret_cast32<uint32_t>(cache) + BranchCache::FalseOffset().Int32Value();
+    NearLabel done;
+    Address counter(condition, TIMES_2, address);
+    // Saturate the counter.
+    __ cmpw(counter, Immediate(-1));
+    __ j(kEqual, &done);
+    __ addw(counter, Immediate(1));
+    __ Bind(&done);
+  }
+
   HBasicBlock* true_successor = if_instr->IfTrueSuccessor();
   HBasicBlock* false_successor = if_instr->IfFalseSuccessor();
   Label* true_target = codegen_->GoesToNextBlock(if_instr->GetBlock(), true_successor) ?
@@ -2759,11 +2781,17 @@ void CodeGeneratorX86::MaybeGenerateInlineCacheCheck(HInstruction* instruction,
       CHECK_EQ(EBP, instruction->GetLocations()->GetTemp(temp_index).AsRegister<Register>());
     }
     Register temp = EBP;
-    NearLabel done;
+    NearLabel done, update_cache;
     __ movl(temp, Immediate(address));
-    // Fast path for a monomorphic cache.
+    // Fast path for a monomorphic cache: just count the receiver.
     __ cmpl(klass, Address(temp, InlineCache::ClassesOffset().Int32Value()));
+    __ j(kNotEqual, &update_cache);
+    Address count(temp, InlineCache::CountsOffset().Int32Value());
+    __ cmpw(count, Immediate(-1));
     __ j(kEqual, &done);
+    __ addw(count, Immediate(1));
+    __ jmp(&done);
+    __ Bind(&update_cache);
     GenerateInvokeRuntime(GetThreadOffset<kX86PointerSize>(kQuickUpdateInlineCache).Int32Value());
     __ Bind(&done);
   }
@@ -2215,11 +2215,34 @@ void InstructionCodeGeneratorX86_64::GenerateTestAndBranch(HInstruction* instruc
 void LocationsBuilderX86_64::VisitIf(HIf* if_instr) {
   LocationSummary* locations = new (GetGraph()->GetAllocator()) LocationSummary(if_instr);
   if (IsBooleanValueOrMaterializedCondition(if_instr->InputAt(0))) {
-    locations->SetInAt(0, Location::Any());
+    if (CodeGenerator::GetBranchCacheToUpdate(GetGraph(), if_instr) != nullptr) {
+      // The condition indexes the branch counters.
+      locations->SetInAt(0, Location::RequiresRegister());
+    } else {
+      locations->SetInAt(0, Location::Any());
+    }
   }
 }
 
 void InstructionCodeGeneratorX86_64::VisitIf(HIf* if_instr) {
+  BranchCache* cache = CodeGenerator::GetBranchCacheToUpdate(GetGraph(), if_instr);
+  if (cache != nullptr) {
+    static_assert(
+        BranchCache::TrueOffset().Int32Value() - BranchCache::FalseOffset().Int32Value() == 2);
+    DCHECK(IsBooleanValueOrMaterializedCondition(if_instr->InputAt(0)));
+    CpuRegister condition = if_instr->GetLocations()->InAt(0).AsRegister<CpuRegister>();
+    uint64_t address =
+        reinterpret_cast64<uint64_t>(cache) + BranchCache::FalseOffset().Int32Value();
+    NearLabel done;
+    __ movq(CpuRegister(TMP), Immediate(address));
+    Address counter(CpuRegister(TMP), condition, TIMES_2, 0);
+    // Saturate the counter.
+    __ cmpw(counter, Immediate(-1));
+    __ j(kEqual, &done);
+    __ addw(counter, Immediate(1));
+    __ Bind(&done);
+  }
+
   HBasicBlock* true_successor = if_instr->IfTrueSuccessor();
   HBasicBlock* false_successor = if_instr->IfFalseSuccessor();
   Label* true_target = codegen_->GoesToNextBlock(if_instr->GetBlock(), true_successor) ?
@@ -3005,11 +3028,17 @@ void CodeGeneratorX86_64::MaybeGenerateInlineCacheCheck(HInstruction* instructio
     DCHECK(info != nullptr);
     InlineCache* cache = info->GetInlineCache(instruction->GetDexPc());
     uint64_t address = reinterpret_cast64<uint64_t>(cache);
-    NearLabel done;
+    NearLabel done, update_cache;
     __ movq(CpuRegister(TMP), Immediate(address));
-    // Fast path for a monomorphic cache.
+    // Fast path for a monomorphic cache: just count the receiver.
     __ cmpl(Address(CpuRegister(TMP), InlineCache::ClassesOffset().Int32Value()), klass);
+    __ j(kNotEqual, &update_cache);
+    Address count(CpuRegister(TMP), InlineCache::CountsOffset().Int32Value());
+    __ cmpw(count, Immediate(-1));
     __ j(kEqual, &done);
+    __ addw(count, Immediate(1));
+    __ jmp(&done);
+    __ Bind(&update_cache);
     GenerateInvokeRuntime(
         GetThreadOffset<kX86_64PointerSize>(kQuickUpdateInlineCache).Int32Value());
     __ Bind(&done);
@@ -7858,6 +7887,24 @@ void InstructionCodeGeneratorX86_64::VisitPackedSwitch(HPackedSwitch* switch_ins
   CpuRegister base_reg = locations->GetTemp(1).AsRegister<CpuRegister>();
   HBasicBlock* default_block = switch_instr->GetDefaultBlock();
 
+  uint16_t* counts = CodeGenerator::GetSwitchCountsToUpdate(GetGraph(), switch_instr);
+  if (counts != nullptr) {
+    // Count the taken target, using `num_entries` as the index of the default target.
+    NearLabel in_range, done;
+    __ leal(temp_reg, Address(value_reg_in, -lower_bound));
+    __ cmpl(temp_reg, Immediate(num_entries));
+    __ j(kBelow, &in_range);
+    __ movl(temp_reg, Immediate(num_entries));
+    __ Bind(&in_range);
+    __ movq(base_reg, Immediate(reinterpret_cast64<uint64_t>(counts)));
+    Address counter(base_reg, temp_reg, TIMES_2, 0);
+    // Saturate the counter.
+    __ cmpw(counter, Immediate(-1));
+    __ j(kEqual, &done);
+    __ addw(counter, Immediate(1));
+    __ Bind(&done);
+  }
+
   // Should we generate smaller inline compare/jumps?
   if (num_entries <= kPackedSwitchJumpTableThreshold) {
     // Figure out the correct compare values and jump conditions.
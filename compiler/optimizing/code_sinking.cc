@@ -42,8 +42,8 @@ bool CodeSinking::Run() {
 void CodeSinking::UncommonBranchSinking() {
   HBasicBlock* exit = graph_->GetExitBlock();
   DCHECK(exit != nullptr);
-  // TODO(ngeoffray): we do not profile branches yet, so use throw instructions
-  // as an indicator of an uncommon branch.
+  // Use throw instructions as an indicator of an uncommon branch. Branches that the
+  // profile says are rarely taken are handled below.
   for (HBasicBlock* exit_predecessor : exit->GetPredecessors()) {
     HInstruction* last = exit_predecessor->GetLastInstruction();
 
@@ -68,6 +68,30 @@ void CodeSinking::UncommonBranchSinking() {
       SinkCodeToUncommonBranch(exit_predecessor);
     }
   }
+
+  // Sink code to the successors of profiled branches that are rarely taken. We only consider
+  // successors with a single predecessor, so that the sunk code does not execute on other paths.
+  // Like exit predecessors, the blocks we sink to must come after the exit block in post order.
+  ScopedArenaAllocator allocator(graph_->GetArenaStack());
+  ScopedArenaVector<HBasicBlock*> cold_successors(allocator.Adapter(kArenaAllocMisc));
+  bool found_exit = false;
+  for (HBasicBlock* block : graph_->GetPostOrder()) {
+    if (block == exit) {
+      found_exit = true;
+      continue;
+    }
+    if (!found_exit || block->GetPredecessors().size() != 1u) {
+      continue;
+    }
+    HBasicBlock* predecessor = block->GetSinglePredecessor();
+    HInstruction* last = predecessor->GetLastInstruction();
+    if ((last->IsIf() || last->IsPackedSwitch()) && predecessor->IsColdSuccessor(block)) {
+      cold_successors.push_back(block);
+    }
+  }
+  for (HBasicBlock* cold_successor : cold_successors) {
+    SinkCodeToUncommonBranch(cold_successor);
+  }
 }
 
 static bool IsInterestingInstruction(HInstruction* instruction) {
@@ -341,10 +365,11 @@ void CodeSinking::SinkCodeToUncommonBranch(HBasicBlock* end_block) {
   ScopedArenaVector<HInstruction*> move_in_order(allocator.Adapter(kArenaAllocMisc));
 
   // Step (1): Visit post order to get a subset of blocks post dominated by `end_block`.
+  // `end_block` is either a block ending with a throw or, when the method has branch
+  // profiles, the single-predecessor successor of a rarely taken branch, see
+  // `UncommonBranchSinking()`.
   // TODO(ngeoffray): Getting the full set of post-dominated should be done by
-  // computing the post dominator tree, but that could be too time consuming. Also,
-  // we should start the analysis from blocks dominated by an uncommon branch, but we
-  // don't profile branches yet.
+  // computing the post dominator tree, but that could be too time consuming.
   bool found_block = false;
   for (HBasicBlock* block : graph_->GetPostOrder()) {
     if (block == end_block) {
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_sinking.h"
+
+#include "base/macros.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+
+namespace art HIDDEN {
+
+class CodeSinkingTest : public OptimizingUnitTest {
+ protected:
+  // Builds the graph below and returns the addition, which is only used in `left`,
+  // the true successor of the HIf.
+  //
+  //            entry
+  //              |
+  //            start       add = p0 + p1; if (p2)
+  //           /     \
+  //        left     right  return add / return p0
+  //           \     /
+  //            exit
+  HAdd* BuildGraph(HIf** if_instruction, HBasicBlock** left) {
+    CreateGraph();
+    AdjacencyListGraph blks(SetupFromAdjacencyList("entry",
+                                                   "exit",
+                                                   {{"entry", "start"},
+                                                    {"start", "left"},
+                                                    {"start", "right"},
+                                                    {"left", "exit"},
+                                                    {"right", "exit"}}));
+    HBasicBlock* entry = blks.Get("entry");
+    HBasicBlock* start = blks.Get("start");
+    HBasicBlock* right = blks.Get("right");
+    *left = blks.Get("left");
+
+    HInstruction* p0 = MakeParam(DataType::Type::kInt32);
+    HInstruction* p1 = MakeParam(DataType::Type::kInt32);
+    HInstruction* p2 = MakeParam(DataType::Type::kBool);
+    entry->AddInstruction(new (GetAllocator()) HGoto());
+
+    HAdd* add = new (GetAllocator()) HAdd(DataType::Type::kInt32, p0, p1);
+    *if_instruction = new (GetAllocator()) HIf(p2);
+    start->AddInstruction(add);
+    start->AddInstruction(*if_instruction);
+    // The first successor of `start` is the true successor.
+    EXPECT_EQ((*if_instruction)->IfTrueSuccessor(), *left);
+
+    (*left)->AddInstruction(new (GetAllocator()) HReturn(add));
+    right->AddInstruction(new (GetAllocator()) HReturn(p0));
+    SetupExit(blks.Get("exit"));
+    return add;
+  }
+
+  void PerformCodeSinking() {
+    graph_->ClearDominanceInformation();
+    graph_->BuildDominatorTree();
+    CodeSinking(graph_, /*stats=*/ nullptr).Run();
+  }
+};
+
+TEST_F(CodeSinkingTest, NoSinkingWithoutProfile) {
+  HIf* if_instruction;
+  HBasicBlock* left;
+  HAdd* add = BuildGraph(&if_instruction, &left);
+  HBasicBlock* start = add->GetBlock();
+
+  PerformCodeSinking();
+
+  EXPECT_EQ(add->GetBlock(), start);
+}
+
+TEST_F(CodeSinkingTest, SinkToProfiledColdSuccessor) {
+  HIf* if_instruction;
+  HBasicBlock* left;
+  HAdd* add = BuildGraph(&if_instruction, &left);
+  if_instruction->SetProfiledCounts(/*true_count=*/ 1u, /*false_count=*/ 1000u);
+
+  PerformCodeSinking();
+
+  EXPECT_EQ(add->GetBlock(), left);
+}
+
+TEST_F(CodeSinkingTest, NoSinkingToProfiledHotSuccessor) {
+  HIf* if_instruction;
+  HBasicBlock* left;
+  HAdd* add = BuildGraph(&if_instruction, &left);
+  HBasicBlock* start = add->GetBlock();
+  // The only user of the addition is on the frequently taken path.
+  if_instruction->SetProfiledCounts(/*true_count=*/ 1000u, /*false_count=*/ 1u);
+
+  PerformCodeSinking();
+
+  EXPECT_EQ(add->GetBlock(), start);
+}
+
+}  // namespace art
@@ -24,6 +24,7 @@
 #include "dex/dex_file.h"
 #include "dex/dex_instruction.h"
 #include "driver/compiler_options.h"
+#include "jit/profiling_info.h"
 #include "nodes.h"
 #include "optimizing_unit_test.h"
 #include "register_allocator_linear_scan.h"
@@ -220,6 +221,56 @@ TEST_F(CodegenTest, ReturnIf2) {
   TestCode(data, true, 0);
 }
 
+TEST_F(CodegenTest, BaselineBranchCounters) {
+  // The IF_EQ at dex pc 2 is taken in `taken` and not taken in `not_taken`.
+  const std::vector<uint16_t> taken = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::IF_EQ, 3,
+    Instruction::RETURN | 0 << 8,
+    Instruction::RETURN | 1 << 8);
+  const std::vector<uint16_t> not_taken = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::IF_EQ | 0 << 4 | 1 << 8, 3,
+    Instruction::RETURN | 0 << 8,
+    Instruction::RETURN | 1 << 8);
+  static constexpr uint32_t kBranchDexPc = 2u;
+
+  for (bool branch_taken : {true, false}) {
+    for (const CodegenTargetConfig& target_config : GetTargetConfigs()) {
+      // The generated code updates the counters at their address in this process.
+      if (target_config.GetInstructionSet() != kRuntimeISA) {
+        continue;
+      }
+      ResetPoolAndAllocator();
+      HGraph* graph = CreateCFG(branch_taken ? taken : not_taken,
+                                DataType::Type::kInt32,
+                                CompilationKind::kBaseline);
+      // Remove suspend checks, they cannot be executed in this context.
+      RemoveSuspendChecks(graph);
+      std::vector<uint64_t> storage(
+          RoundUp(ProfilingInfo::ComputeSize(0u, 1u, {}), sizeof(uint64_t)) / sizeof(uint64_t));
+      ProfilingInfo* info = ProfilingInfo::CreateForTesting(
+          storage.data(), /*method=*/ nullptr, {kBranchDexPc}, {});
+      graph->SetProfilingInfo(info);
+      std::unique_ptr<CompilerOptions> compiler_options =
+          CommonCompilerTest::CreateCompilerOptions(target_config.GetInstructionSet(), "default");
+      RunCode(target_config,
+              *compiler_options,
+              graph,
+              [](HGraph*) {},
+              /*has_result=*/ true,
+              branch_taken ? 1 : 0);
+
+      BranchCache* cache = info->GetBranchCache(kBranchDexPc);
+      ASSERT_TRUE(cache != nullptr);
+      EXPECT_EQ(cache->GetTrue(), branch_taken ? 1u : 0u);
+      EXPECT_EQ(cache->GetFalse(), branch_taken ? 0u : 1u);
+    }
+  }
+}
+
 // Exercise bit-wise (one's complement) not-int instruction.
 #define NOT_INT_TEST(TEST_NAME, INPUT, EXPECTED_OUTPUT)           \
 TEST_F(CodegenTest, TEST_NAME) {                                  \
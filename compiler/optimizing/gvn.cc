@@ -16,11 +16,14 @@
 
 #include "gvn.h"
 
+#include <optional>
+
 #include "base/arena_bit_vector.h"
 #include "base/bit_vector-inl.h"
 #include "base/scoped_arena_allocator.h"
 #include "base/scoped_arena_containers.h"
 #include "base/utils.h"
+#include "region_partition.h"
 #include "side_effects_analysis.h"
 
 namespace art HIDDEN {
@@ -362,6 +365,9 @@ class GlobalValueNumberer : public ValueObject {
         visited_blocks_(
             &allocator_, graph->GetBlocks().size(), /* expandable= */ false, kArenaAllocGvn) {
     visited_blocks_.ClearAllBits();
+    if (graph->GetMaxRegionSize() != 0u) {
+      regions_.emplace(graph, graph->GetMaxRegionSize(), &allocator_);
+    }
   }
 
   bool Run();
@@ -406,6 +412,10 @@ class GlobalValueNumberer : public ValueObject {
   // visited/unvisited Boolean.
   ArenaBitVector visited_blocks_;
 
+  // Regions of the graph when compiling a huge method by regions. Value sets are not
+  // propagated across region boundaries.
+  std::optional<RegionPartition> regions_;
+
   DISALLOW_COPY_AND_ASSIGN(GlobalValueNumberer);
 };
 
@@ -415,7 +425,15 @@ bool GlobalValueNumberer::Run() {
 
   // Use the reverse post order to ensure the non back-edge predecessors of a block are
   // visited before the block itself.
+  uint32_t current_region = 0u;
   for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    if (regions_.has_value() && regions_->GetRegion(block) != current_region) {
+      // Blocks of previous regions only dominate blocks still to visit through region entries,
+      // which start with an empty set. Forget them, so that looking for a recyclable set only
+      // scans the current region. Their sets stay available for intersecting at merge points.
+      current_region = regions_->GetRegion(block);
+      visited_blocks_.ClearAllBits();
+    }
     VisitBasicBlock(block);
   }
   return true;
@@ -430,6 +448,9 @@ void GlobalValueNumberer::VisitBasicBlock(HBasicBlock* block) {
     // the builder puts constants only in the entry block.
     // Therefore, there is no need to propagate the value set to the next block.
     set = new (&allocator_) ValueSet(&allocator_);
+  } else if (regions_.has_value() && regions_->IsRegionEntry(block)) {
+    // Do not carry values over from another region.
+    set = new (&allocator_) ValueSet(&allocator_);
   } else {
     HBasicBlock* dominator = block->GetDominator();
     ValueSet* dominator_set = FindSetFor(dominator);
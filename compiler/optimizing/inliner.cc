@@ -16,6 +16,8 @@
 
 #include "inliner.h"
 
+#include <numeric>
+
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "base/logging.h"
@@ -69,6 +71,13 @@ static constexpr size_t kMaximumNumberOfRecursiveCalls = 4;
 // recursive calls at all.
 static constexpr size_t kMaximumNumberOfPolymorphicRecursiveCalls = 0;
 
+// Limits for inlining the dominant targets of a megamorphic call: a target is only inlined if it
+// is the receiver of at least 1 / kMegamorphicTargetFrequencyDivisor of the calls, and only if
+// enough calls were profiled for the frequencies to be meaningful.
+static constexpr size_t kMaximumNumberOfMegamorphicTargets = 2;
+static constexpr uint32_t kMegamorphicTargetFrequencyDivisor = 4;
+static constexpr uint32_t kMinimumNumberOfMegamorphicCalls = 100;
+
 // Controls the use of inline caches in AOT mode.
 static constexpr bool kUseAOTInlineCaches = true;
 
@@ -590,12 +599,14 @@ bool HInliner::TryInlineFromInlineCache(HInvoke* invoke_instruction)
   }
 
   StackHandleScope<InlineCache::kIndividualCacheSize> classes(Thread::Current());
+  uint32_t counts[InlineCache::kIndividualCacheSize] = {};
+  uint32_t total_count = 0u;
   // The Zygote JIT compiles based on a profile, so we shouldn't use runtime inline caches
   // for it.
   InlineCacheType inline_cache_type =
       (Runtime::Current()->IsAotCompiler() || Runtime::Current()->IsZygote())
-          ? GetInlineCacheAOT(invoke_instruction, &classes)
-          : GetInlineCacheJIT(invoke_instruction, &classes);
+          ? GetInlineCacheAOT(invoke_instruction, &classes, counts, &total_count)
+          : GetInlineCacheJIT(invoke_instruction, &classes, counts, &total_count);
 
   switch (inline_cache_type) {
     case kInlineCacheNoData: {
@@ -628,11 +639,14 @@ bool HInliner::TryInlineFromInlineCache(HInvoke* invoke_instruction)
     }
 
     case kInlineCacheMegamorphic: {
+      MaybeRecordStat(stats_, MethodCompilationStat::kMegamorphicCall);
+      if (TryInlineMegamorphicCall(invoke_instruction, classes, counts, total_count)) {
+        return true;
+      }
       LOG_FAIL_NO_STAT()
           << "Interface or virtual call to "
           << invoke_instruction->GetMethodReference().PrettyMethod()
           << " is megamorphic and not inlined";
-      MaybeRecordStat(stats_, MethodCompilationStat::kMegamorphicCall);
       return false;
     }
 
@@ -649,7 +663,9 @@ bool HInliner::TryInlineFromInlineCache(HInvoke* invoke_instruction)
 
 HInliner::InlineCacheType HInliner::GetInlineCacheJIT(
     HInvoke* invoke_instruction,
-    /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes) {
+    /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes,
+    /*out*/uint32_t* counts,
+    /*out*/uint32_t* total_count) {
   DCHECK(codegen_->GetCompilerOptions().IsJitCompiler());
 
   ArtMethod* caller = graph_->GetArtMethod();
@@ -662,13 +678,23 @@ HInliner::InlineCacheType HInliner::GetInlineCacheJIT(
 
   Runtime::Current()->GetJit()->GetCodeCache()->CopyInlineCacheInto(
       *profiling_info->GetInlineCache(invoke_instruction->GetDexPc()),
-      classes);
-  return GetInlineCacheType(*classes);
+      classes,
+      counts);
+  *total_count = std::accumulate(counts, counts + InlineCache::kIndividualCacheSize, 0u);
+  InlineCacheType inline_cache_type = GetInlineCacheType(*classes);
+  if (inline_cache_type == kInlineCacheMegamorphic) {
+    // The last entry of a megamorphic cache counts all the receivers that are not in the
+    // other entries, not only its own class.
+    counts[InlineCache::kIndividualCacheSize - 1u] = 0u;
+  }
+  return inline_cache_type;
 }
 
 HInliner::InlineCacheType HInliner::GetInlineCacheAOT(
     HInvoke* invoke_instruction,
-    /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes) {
+    /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes,
+    /*out*/uint32_t* counts,
+    /*out*/uint32_t* total_count) {
   DCHECK_EQ(classes->NumberOfReferences(), InlineCache::kIndividualCacheSize);
   DCHECK_EQ(classes->RemainingSlots(), InlineCache::kIndividualCacheSize);
 
@@ -694,14 +720,28 @@ HInliner::InlineCacheType HInliner::GetInlineCacheAOT(
   if (dex_pc_data.is_missing_types) {
     return kInlineCacheMissingTypes;
   }
+  ClassLinker* class_linker = caller_compilation_unit_.GetClassLinker();
   if (dex_pc_data.is_megamorphic) {
+    // Look up the classes with receiver counts, so that we can still inline the dominant
+    // targets. Classes that cannot be found are simply not considered.
+    DCHECK_LE(dex_pc_data.receiver_counts.size(), InlineCache::kIndividualCacheSize);
+    *total_count = dex_pc_data.total_count;
+    for (const auto& [type_index, count] : dex_pc_data.receiver_counts) {
+      const char* descriptor =
+          pci->GetTypeDescriptor(caller_compilation_unit_.GetDexFile(), type_index);
+      ObjPtr<mirror::ClassLoader> class_loader = caller_compilation_unit_.GetClassLoader().Get();
+      ObjPtr<mirror::Class> clazz = class_linker->LookupResolvedType(descriptor, class_loader);
+      if (clazz != nullptr) {
+        counts[InlineCache::kIndividualCacheSize - classes->RemainingSlots()] = count;
+        classes->NewHandle(clazz);
+      }
+    }
     return kInlineCacheMegamorphic;
   }
   DCHECK_LE(dex_pc_data.classes.size(), InlineCache::kIndividualCacheSize);
 
   // Walk over the class descriptors and look up the actual classes.
   // If we cannot find a type we return kInlineCacheMissingTypes.
-  ClassLinker* class_linker = caller_compilation_unit_.GetClassLinker();
   for (const dex::TypeIndex& type_index : dex_pc_data.classes) {
     const DexFile* dex_file = caller_compilation_unit_.GetDexFile();
     const char* descriptor = pci->GetTypeDescriptor(dex_file, type_index);
@@ -950,13 +990,50 @@ static void MaybeReplaceAndRemove(HInstruction* new_instruction, HInstruction* o
   old_instruction->GetBlock()->RemoveInstruction(old_instruction);
 }
 
+bool HInliner::TryInlineMegamorphicCall(
+    HInvoke* invoke_instruction,
+    const StackHandleScope<InlineCache::kIndividualCacheSize>& classes,
+    const uint32_t* counts,
+    uint32_t total_count) {
+  if (total_count < kMinimumNumberOfMegamorphicCalls) {
+    return false;
+  }
+
+  // Pick the most frequent receivers, most frequent first as the type guards are tested in
+  // the order they are added.
+  uint8_t number_of_types = InlineCache::kIndividualCacheSize - classes.RemainingSlots();
+  std::array<size_t, InlineCache::kIndividualCacheSize> order;
+  std::iota(order.begin(), order.begin() + number_of_types, 0u);
+  std::stable_sort(order.begin(),
+                   order.begin() + number_of_types,
+                   [counts](size_t lhs, size_t rhs) { return counts[lhs] > counts[rhs]; });
+  StackHandleScope<InlineCache::kIndividualCacheSize> dominant_classes(Thread::Current());
+  for (size_t i = 0; i != number_of_types && i != kMaximumNumberOfMegamorphicTargets; ++i) {
+    uint32_t count = counts[order[i]];
+    if (count == 0u || count < total_count / kMegamorphicTargetFrequencyDivisor) {
+      break;
+    }
+    dominant_classes.NewHandle(classes.GetReference(order[i])->AsClass());
+  }
+  if (dominant_classes.RemainingSlots() == InlineCache::kIndividualCacheSize) {
+    LOG_FAIL_NO_STAT()
+        << "Megamorphic call to " << invoke_instruction->GetMethodReference().PrettyMethod()
+        << " has no dominant receiver";
+    return false;
+  }
+  return TryInlinePolymorphicCall(invoke_instruction, dominant_classes, /*is_megamorphic=*/ true);
+}
+
 bool HInliner::TryInlinePolymorphicCall(
     HInvoke* invoke_instruction,
-    const StackHandleScope<InlineCache::kIndividualCacheSize>& classes) {
+    const StackHandleScope<InlineCache::kIndividualCacheSize>& classes,
+    bool is_megamorphic) {
   DCHECK(invoke_instruction->IsInvokeVirtual() || invoke_instruction->IsInvokeInterface())
       << invoke_instruction->DebugName();
 
-  if (TryInlinePolymorphicCallToSameTarget(invoke_instruction, classes)) {
+  // For megamorphic calls, `classes` only contains some of the receivers, so we cannot
+  // replace the call even if they all have the same target.
+  if (!is_megamorphic && TryInlinePolymorphicCallToSameTarget(invoke_instruction, classes)) {
     return true;
   }
 
@@ -989,7 +1066,7 @@ bool HInliner::TryInlinePolymorphicCall(
 
     // In monomorphic cases when UseOnlyPolymorphicInliningWithNoDeopt() is true, we call
     // `TryInlinePolymorphicCall` even though we are monomorphic.
-    const bool actually_monomorphic = number_of_types == 1;
+    const bool actually_monomorphic = !is_megamorphic && number_of_types == 1;
     DCHECK_IMPLIES(actually_monomorphic, UseOnlyPolymorphicInliningWithNoDeopt());
 
     // We only want to limit recursive polymorphic cases, not monomorphic ones.
@@ -1020,8 +1097,10 @@ bool HInliner::TryInlinePolymorphicCall(
                     << " has inlined " << ArtMethod::PrettyMethod(method);
 
       // If we have inlined all targets before, and this receiver is the last seen,
-      // we deoptimize instead of keeping the original invoke instruction.
-      bool deoptimize = !UseOnlyPolymorphicInliningWithNoDeopt() &&
+      // we deoptimize instead of keeping the original invoke instruction. Megamorphic
+      // calls always keep it for the other receivers.
+      bool deoptimize = !is_megamorphic &&
+          !UseOnlyPolymorphicInliningWithNoDeopt() &&
           all_targets_inlined &&
           (i + 1 == number_of_types);
 
@@ -1048,7 +1127,9 @@ bool HInliner::TryInlinePolymorphicCall(
     return false;
   }
 
-  MaybeRecordStat(stats_, MethodCompilationStat::kInlinedPolymorphicCall);
+  MaybeRecordStat(stats_,
+                  is_megamorphic ? MethodCompilationStat::kInlinedMegamorphicCall
+                                 : MethodCompilationStat::kInlinedPolymorphicCall);
 
   // Run type propagation to get the guards typed.
   ReferenceTypePropagation rtp_fixup(graph_,
@@ -183,17 +183,24 @@ class HInliner : public HOptimization {
   // Try getting the inline cache from JIT code cache.
   // Return true if the inline cache was successfully allocated and the
   // invoke info was found in the profile info.
+  // `counts` receives the number of times each of `classes` was seen, and `total_count`
+  // the number of calls with any receiver.
   InlineCacheType GetInlineCacheJIT(
       HInvoke* invoke_instruction,
-      /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes)
+      /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes,
+      /*out*/uint32_t* counts,
+      /*out*/uint32_t* total_count)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Try getting the inline cache from AOT offline profile.
   // Return true if the inline cache was successfully allocated and the
   // invoke info was found in the profile info.
+  // For megamorphic calls, `classes` and `counts` are those of the most frequent receivers.
   InlineCacheType GetInlineCacheAOT(
       HInvoke* invoke_instruction,
-      /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes)
+      /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes,
+      /*out*/uint32_t* counts,
+      /*out*/uint32_t* total_count)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Compute the inline cache type.
@@ -209,9 +216,22 @@ class HInliner : public HOptimization {
                                 const StackHandleScope<InlineCache::kIndividualCacheSize>& classes)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Try to inline targets of a polymorphic call.
+  // Try to inline targets of a polymorphic call. If `is_megamorphic`, `classes` are only
+  // some of the receivers and the call is always kept for the others.
   bool TryInlinePolymorphicCall(HInvoke* invoke_instruction,
-                                const StackHandleScope<InlineCache::kIndividualCacheSize>& classes)
+                                const StackHandleScope<InlineCache::kIndividualCacheSize>& classes,
+                                bool is_megamorphic = false)
+    REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Try to inline the dominant targets of a megamorphic call, guarded like polymorphic
+  // targets and falling back to the virtual or interface call:
+  // if (receiver.getClass() == dominant_class) ... // inlined code
+  // else if (receiver.getClass() == second_dominant_class) ... // inlined code
+  // else invoke
+  bool TryInlineMegamorphicCall(HInvoke* invoke_instruction,
+                                const StackHandleScope<InlineCache::kIndividualCacheSize>& classes,
+                                const uint32_t* counts,
+                                uint32_t total_count)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
   bool TryInlinePolymorphicCallToSameTarget(
@@ -33,6 +33,7 @@
 #include "intrinsics.h"
 #include "intrinsics_utils.h"
 #include "jit/jit.h"
+#include "jit/profiling_info.h"
 #include "mirror/dex_cache.h"
 #include "oat_file.h"
 #include "optimizing_compiler_stats.h"
@@ -111,6 +112,8 @@ HInstructionBuilder::HInstructionBuilder(HGraph* graph,
       latest_result_(nullptr),
       current_this_parameter_(nullptr),
       loop_headers_(local_allocator->Adapter(kArenaAllocGraphBuilder)),
+      aot_branch_counts_(nullptr),
+      aot_branch_counts_initialized_(false),
       class_cache_(std::less<dex::TypeIndex>(), local_allocator->Adapter(kArenaAllocGraphBuilder)) {
   loop_headers_.reserve(kDefaultNumberOfLoops);
 }
@@ -671,7 +674,9 @@ void HInstructionBuilder::If_22t(const Instruction& instruction, uint32_t dex_pc
   HInstruction* second = LoadLocal(instruction.VRegB(), DataType::Type::kInt32);
   T* comparison = new (allocator_) T(first, second, dex_pc);
   AppendInstruction(comparison);
-  AppendInstruction(new (allocator_) HIf(comparison, dex_pc));
+  HIf* if_instruction = new (allocator_) HIf(comparison, dex_pc);
+  MaybeSetProfiledCounts(if_instruction, dex_pc);
+  AppendInstruction(if_instruction);
   current_block_ = nullptr;
 }
 
@@ -680,7 +685,9 @@ void HInstructionBuilder::If_21t(const Instruction& instruction, uint32_t dex_pc
   HInstruction* value = LoadLocal(instruction.VRegA(), DataType::Type::kInt32);
   T* comparison = new (allocator_) T(value, graph_->GetIntConstant(0, dex_pc), dex_pc);
   AppendInstruction(comparison);
-  AppendInstruction(new (allocator_) HIf(comparison, dex_pc));
+  HIf* if_instruction = new (allocator_) HIf(comparison, dex_pc);
+  MaybeSetProfiledCounts(if_instruction, dex_pc);
+  AppendInstruction(if_instruction);
   current_block_ = nullptr;
 }
 
@@ -819,13 +826,74 @@ void HInstructionBuilder::BuildSwitch(const Instruction& instruction, uint32_t d
       }
     }
   } else {
-    AppendInstruction(
-        new (allocator_) HPackedSwitch(table.GetEntryAt(0), table.GetNumEntries(), value, dex_pc));
+    HPackedSwitch* packed_switch =
+        new (allocator_) HPackedSwitch(table.GetEntryAt(0), table.GetNumEntries(), value, dex_pc);
+    size_t number_of_counts = table.GetNumEntries() + 1u;
+    uint32_t* counts = allocator_->AllocArray<uint32_t>(number_of_counts, kArenaAllocGraphBuilder);
+    if (GetProfiledBranchCounts(dex_pc, ArrayRef<uint32_t>(counts, number_of_counts))) {
+      packed_switch->SetProfiledCounts(counts);
+    }
+    AppendInstruction(packed_switch);
   }
 
   current_block_ = nullptr;
 }
 
+bool HInstructionBuilder::GetProfiledBranchCounts(uint32_t dex_pc,
+                                                  /*out*/ ArrayRef<uint32_t> counts) {
+  if (graph_->IsCompilingBaseline() || code_generator_ == nullptr) {
+    // Baseline code collects the counts, it does not use them.
+    return false;
+  }
+  ProfilingInfo* info = graph_->GetProfilingInfo();
+  if (info != nullptr) {
+    // JIT compilation, use the counts collected by baseline code.
+    if (counts.size() == 2u) {
+      BranchCache* cache = info->GetBranchCache(dex_pc);
+      if (cache == nullptr) {
+        return false;
+      }
+      counts[0] = cache->GetFalse();
+      counts[1] = cache->GetTrue();
+    } else {
+      SwitchCache* cache = info->GetSwitchCache(dex_pc);
+      if (cache == nullptr || cache->GetNumberOfEntries() + 1u != counts.size()) {
+        return false;
+      }
+      const uint16_t* switch_counts = info->GetSwitchCounts(cache);
+      std::copy_n(switch_counts, counts.size(), counts.begin());
+    }
+  } else {
+    // AOT compilation, use the counts from the profile.
+    if (!aot_branch_counts_initialized_) {
+      aot_branch_counts_initialized_ = true;
+      const ProfileCompilationInfo* pci =
+          code_generator_->GetCompilerOptions().GetProfileCompilationInfo();
+      if (pci != nullptr) {
+        aot_branch_counts_ = pci->GetMethodHotness(MethodReference(
+            dex_file_, dex_compilation_unit_->GetDexMethodIndex())).GetBranchCountMap();
+      }
+    }
+    if (aot_branch_counts_ == nullptr || dex_pc > std::numeric_limits<uint16_t>::max()) {
+      return false;
+    }
+    auto it = aot_branch_counts_->find(dex_pc);
+    if (it == aot_branch_counts_->end() || it->second.size() != counts.size()) {
+      return false;
+    }
+    std::copy(it->second.begin(), it->second.end(), counts.begin());
+  }
+  return std::any_of(counts.begin(), counts.end(), [](uint32_t count) { return count != 0u; });
+}
+
+void HInstructionBuilder::MaybeSetProfiledCounts(HIf* if_instruction, uint32_t dex_pc) {
+  uint32_t counts[2];
+  if (GetProfiledBranchCounts(dex_pc, ArrayRef<uint32_t>(counts))) {
+    // The true successor of the HIf is the branch target.
+    if_instruction->SetProfiledCounts(/*true_count=*/ counts[1], /*false_count=*/ counts[0]);
+  }
+}
+
 void HInstructionBuilder::BuildReturn(const Instruction& instruction,
                                       DataType::Type type,
                                       uint32_t dex_pc) {
@@ -27,6 +27,7 @@
 #include "dex/dex_file_types.h"
 #include "handle.h"
 #include "nodes.h"
+#include "profile/profile_compilation_info.h"
 
 namespace art HIDDEN {
 
@@ -211,6 +212,14 @@ class HInstructionBuilder : public ValueObject {
   // Builds an instruction sequence for a switch statement.
   void BuildSwitch(const Instruction& instruction, uint32_t dex_pc);
 
+  // Fills `counts` with the profiled counts of the IF_* instruction (not taken, taken) or of
+  // the PACKED_SWITCH instruction (entries, default) at `dex_pc`, from the JIT profiling info
+  // or from the AOT profile. Returns false if there is no profile for the instruction.
+  bool GetProfiledBranchCounts(uint32_t dex_pc, /*out*/ ArrayRef<uint32_t> counts);
+
+  // Records the profiled counts of the IF_* instruction at `dex_pc` in `if_instruction`.
+  void MaybeSetProfiledCounts(HIf* if_instruction, uint32_t dex_pc);
+
   // Builds a `HLoadString` loading the given `string_index`.
   void BuildLoadString(dex::StringIndex string_index, uint32_t dex_pc);
 
@@ -335,6 +344,10 @@ class HInstructionBuilder : public ValueObject {
 
   ScopedArenaVector<HBasicBlock*> loop_headers_;
 
+  // Branch counts of the method in the AOT profile, looked up on first use.
+  const ProfileCompilationInfo::BranchCountMap* aot_branch_counts_;
+  bool aot_branch_counts_initialized_;
+
   // Cached resolved types for the current compilation unit's DexFile.
   // Handle<>s reference entries in the `graph_->GetHandleCache()`.
   ScopedArenaSafeMap<dex::TypeIndex, Handle<mirror::Class>> class_cache_;
@@ -16,6 +16,9 @@
 
 #include "linear_order.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "base/scoped_arena_allocator.h"
 #include "base/scoped_arena_containers.h"
 
@@ -54,6 +57,82 @@ static void AddToListForLinearization(ScopedArenaVector<HBasicBlock*>* worklist,
   worklist->insert(insert_pos.base(), block);
 }
 
+// Helper method to add a block that the profile says is rarely executed to the work list.
+// The block is placed as deep as possible so that it is laid out after the hot blocks of
+// its loop, or after all other blocks if it is not in a loop.
+static void AddColdBlockToListForLinearization(ScopedArenaVector<HBasicBlock*>* worklist,
+                                               HBasicBlock* block) {
+  HLoopInformation* block_loop = block->GetLoopInformation();
+  auto insert_pos = worklist->rbegin();  // insert_pos.base() will be the actual position.
+  if (IsLoop(block_loop)) {
+    for (auto end = worklist->rend(); insert_pos != end; ++insert_pos) {
+      HLoopInformation* current_loop = (*insert_pos)->GetLoopInformation();
+      if (!InSameLoop(block_loop, current_loop) && !IsInnerLoop(block_loop, current_loop)) {
+        // The block must be processed before leaving its loop.
+        break;
+      }
+    }
+  } else {
+    insert_pos = worklist->rend();
+  }
+  worklist->insert(insert_pos.base(), block);
+}
+
+// Helper method to check whether a block ends up throwing an exception whenever it executes.
+static bool AlwaysThrows(const HGraph* graph, HBasicBlock* block) {
+  if (block->GetLastInstruction()->IsThrow()) {
+    return true;
+  }
+  if (graph->HasAlwaysThrowingInvokes()) {
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      if (it.Current()->AlwaysThrows()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Helper method to compute the blocks that are rarely executed:
+// - exception handlers and blocks that always throw, as well as blocks that only lead
+//   to such blocks,
+// - blocks that the profile says are only reached through cold branches or from other
+//   cold blocks.
+static void ComputeColdBlocks(const HGraph* graph, ScopedArenaVector<bool>* is_cold) {
+  // Without irreducible loops, the successors of a block have all been visited in post
+  // order, except for loop headers which are never cold.
+  for (HBasicBlock* block : graph->GetPostOrder()) {
+    if (block->IsEntryBlock() || block->IsLoopHeader()) {
+      continue;
+    }
+    bool cold = block->IsCatchBlock() || AlwaysThrows(graph, block);
+    if (!cold) {
+      ArrayRef<HBasicBlock* const> successors = block->GetNormalSuccessors();
+      cold = !successors.empty() &&
+             std::all_of(successors.begin(),
+                         successors.end(),
+                         [is_cold](HBasicBlock* successor) {
+                           return (*is_cold)[successor->GetBlockId()];
+                         });
+    }
+    (*is_cold)[block->GetBlockId()] = cold;
+  }
+  for (HBasicBlock* block : graph->GetReversePostOrder()) {
+    if (block->IsEntryBlock() || block->IsLoopHeader() || (*is_cold)[block->GetBlockId()]) {
+      continue;
+    }
+    // Without irreducible loops, the predecessors of other blocks have all been visited.
+    bool cold = true;
+    for (HBasicBlock* predecessor : block->GetPredecessors()) {
+      if (!(*is_cold)[predecessor->GetBlockId()] && !predecessor->IsColdSuccessor(block)) {
+        cold = false;
+        break;
+      }
+    }
+    (*is_cold)[block->GetBlockId()] = cold;
+  }
+}
+
 // Helper method to validate linear order.
 static bool IsLinearOrderWellFormed(const HGraph* graph, ArrayRef<HBasicBlock*> linear_order) {
   for (HBasicBlock* header : graph->GetBlocks()) {
@@ -104,11 +183,25 @@ void LinearizeGraphInternal(const HGraph* graph, ArrayRef<HBasicBlock*> linear_o
     }
     forward_predecessors[block->GetBlockId()] = number_of_forward_predecessors;
   }
-  // (2): Following a worklist approach, first start with the entry block, and
+  // (2): Find the blocks that are rarely executed, using the branch profile, if any,
+  //      and the blocks that throw. We do not move blocks around in the presence of
+  //      irreducible loops.
+  ScopedArenaVector<bool> is_cold(graph->GetBlocks().size(),
+                                  false,
+                                  allocator.Adapter(kArenaAllocLinearOrder));
+  if (!graph->HasIrreducibleLoops()) {
+    ComputeColdBlocks(graph, &is_cold);
+  }
+  // (3): Following a worklist approach, first start with the entry block, and
   //      iterate over the successors. When all non-back edge predecessors of a
   //      successor block are visited, the successor block is added in the worklist
   //      following an order that satisfies the requirements to build our linear graph.
+  //      Successors are visited from the least to the most frequently taken one, so that
+  //      the hottest successor is processed next and becomes the fall-through, while
+  //      cold blocks are moved out of line.
   ScopedArenaVector<HBasicBlock*> worklist(allocator.Adapter(kArenaAllocLinearOrder));
+  ScopedArenaVector<std::pair<uint64_t, HBasicBlock*>> successors(
+      allocator.Adapter(kArenaAllocLinearOrder));
   worklist.push_back(graph->GetEntryBlock());
   size_t num_added = 0u;
   do {
@@ -116,11 +209,27 @@ void LinearizeGraphInternal(const HGraph* graph, ArrayRef<HBasicBlock*> linear_o
     worklist.pop_back();
     linear_order[num_added] = current;
     ++num_added;
+    successors.clear();
     for (HBasicBlock* successor : current->GetSuccessors()) {
+      uint64_t total;
+      successors.emplace_back(current->GetProfiledSuccessorCount(successor, &total), successor);
+    }
+    std::stable_sort(successors.begin(),
+                     successors.end(),
+                     [](const std::pair<uint64_t, HBasicBlock*>& lhs,
+                        const std::pair<uint64_t, HBasicBlock*>& rhs) {
+                       return lhs.first < rhs.first;
+                     });
+    for (const std::pair<uint64_t, HBasicBlock*>& entry : successors) {
+      HBasicBlock* successor = entry.second;
       int block_id = successor->GetBlockId();
       size_t number_of_remaining_predecessors = forward_predecessors[block_id];
       if (number_of_remaining_predecessors == 1) {
-        AddToListForLinearization(&worklist, successor);
+        if (is_cold[block_id]) {
+          AddColdBlockToListForLinearization(&worklist, successor);
+        } else {
+          AddToListForLinearization(&worklist, successor);
+        }
       }
       forward_predecessors[block_id] = number_of_remaining_predecessors - 1;
     }
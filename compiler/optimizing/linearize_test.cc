@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <fstream>
 
 #include "base/arena_allocator.h"
@@ -24,6 +25,7 @@
 #include "dex/dex_instruction.h"
 #include "driver/compiler_options.h"
 #include "graph_visualizer.h"
+#include "linear_order.h"
 #include "nodes.h"
 #include "optimizing_unit_test.h"
 #include "pretty_printer.h"
@@ -36,6 +38,7 @@ class LinearizeTest : public CommonCompilerTest, public OptimizingUnitTestHelper
   template <size_t number_of_blocks>
   void TestCode(const std::vector<uint16_t>& data,
                 const uint32_t (&expected_order)[number_of_blocks]);
+  void TestColdBlockLaidOutLast(HGraph* graph, HBasicBlock* cold_block);
 };
 
 template <size_t number_of_blocks>
@@ -54,6 +57,28 @@ void LinearizeTest::TestCode(const std::vector<uint16_t>& data,
   }
 }
 
+void LinearizeTest::TestColdBlockLaidOutLast(HGraph* graph, HBasicBlock* cold_block) {
+  ScopedArenaVector<HBasicBlock*> linear_order(
+      GetScopedAllocator()->Adapter(kArenaAllocLinearOrder));
+  LinearizeGraph(graph, &linear_order);
+
+  // The cold block is only followed by the exit block.
+  ASSERT_GE(linear_order.size(), 2u);
+  ASSERT_EQ(linear_order.back(), graph->GetExitBlock());
+  ASSERT_EQ(linear_order[linear_order.size() - 2u], cold_block);
+}
+
+// Returns the block ending with the first HIf or HPackedSwitch in reverse post order.
+static HBasicBlock* FindBranchBlock(HGraph* graph) {
+  for (HBasicBlock* block : graph->GetReversePostOrder()) {
+    HInstruction* last = block->GetLastInstruction();
+    if (last->IsIf() || last->IsPackedSwitch()) {
+      return block;
+    }
+  }
+  return nullptr;
+}
+
 TEST_F(LinearizeTest, CFG1) {
   // Structure of this graph (+ are back edges)
   //            Block0
@@ -245,4 +270,88 @@ TEST_F(LinearizeTest, CFG7) {
   TestCode(data, blocks);
 }
 
+TEST_F(LinearizeTest, ThrowingBlockLaidOutLast) {
+  // The block that throws is the fall-through of the condition, but it is
+  // rarely executed and should be moved after the returning block.
+  const std::vector<uint16_t> data = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_NE, 3,
+    Instruction::THROW | 0 << 8,
+    Instruction::RETURN_VOID);
+
+  HGraph* graph = CreateCFG(data);
+  std::unique_ptr<CompilerOptions> compiler_options =
+      CommonCompilerTest::CreateCompilerOptions(kRuntimeISA, "default");
+  std::unique_ptr<CodeGenerator> codegen = CodeGenerator::Create(graph, *compiler_options);
+  SsaLivenessAnalysis liveness(graph, codegen.get(), GetScopedAllocator());
+  liveness.Analyze();
+
+  size_t throw_position = graph->GetLinearOrder().size();
+  size_t return_position = graph->GetLinearOrder().size();
+  for (size_t i = 0; i < graph->GetLinearOrder().size(); ++i) {
+    HInstruction* last = graph->GetLinearOrder()[i]->GetLastInstruction();
+    if (last->IsThrow()) {
+      throw_position = i;
+    } else if (last->IsReturnVoid()) {
+      return_position = i;
+    }
+  }
+  ASSERT_LT(return_position, graph->GetLinearOrder().size());
+  ASSERT_LT(throw_position, graph->GetLinearOrder().size());
+  ASSERT_LT(return_position, throw_position);
+}
+
+TEST_F(LinearizeTest, ProfiledColdBranchTargetLaidOutLast) {
+  const std::vector<uint16_t> data = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::IF_EQ | 0 << 4 | 1 << 8, 3,
+    Instruction::RETURN_VOID,
+    Instruction::RETURN_VOID);
+
+  for (bool true_successor_is_cold : {false, true}) {
+    HGraph* graph = CreateCFG(data);
+    HBasicBlock* branch_block = FindBranchBlock(graph);
+    ASSERT_TRUE(branch_block != nullptr);
+    HIf* if_instruction = branch_block->GetLastInstruction()->AsIf();
+    if (true_successor_is_cold) {
+      if_instruction->SetProfiledCounts(/*true_count=*/ 1u, /*false_count=*/ 1000u);
+      TestColdBlockLaidOutLast(graph, if_instruction->IfTrueSuccessor());
+    } else {
+      if_instruction->SetProfiledCounts(/*true_count=*/ 1000u, /*false_count=*/ 1u);
+      TestColdBlockLaidOutLast(graph, if_instruction->IfFalseSuccessor());
+    }
+  }
+}
+
+TEST_F(LinearizeTest, ProfiledColdSwitchTargetLaidOutLast) {
+  // A switch with enough entries not to be built as a decision tree. The default
+  // target is the RETURN_VOID following the switch.
+  const std::vector<uint16_t> data = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::PACKED_SWITCH | 0 << 8, 9, 0,
+    Instruction::RETURN_VOID,
+    Instruction::RETURN_VOID,
+    Instruction::RETURN_VOID,
+    Instruction::RETURN_VOID,
+    Instruction::RETURN_VOID,
+    Instruction::NOP,
+    // Payload: 4 entries starting at key 0, targets relative to the switch.
+    0x0100, 4, 0, 0, 4, 0, 5, 0, 6, 0, 7, 0);
+
+  for (size_t cold_index = 0u; cold_index != 5u; ++cold_index) {
+    HGraph* graph = CreateCFG(data);
+    HBasicBlock* branch_block = FindBranchBlock(graph);
+    ASSERT_TRUE(branch_block != nullptr);
+    HPackedSwitch* packed_switch = branch_block->GetLastInstruction()->AsPackedSwitch();
+    ASSERT_EQ(packed_switch->GetNumEntries(), 4u);
+    // The last count is for the default target.
+    uint32_t* counts = graph->GetAllocator()->AllocArray<uint32_t>(5u);
+    std::fill_n(counts, 5u, 1000u);
+    counts[cold_index] = 1u;
+    packed_switch->SetProfiledCounts(counts);
+    TestColdBlockLaidOutLast(graph, branch_block->GetSuccessors()[cold_index]);
+  }
+}
+
 }  // namespace art
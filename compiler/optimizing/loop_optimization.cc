@@ -339,8 +339,10 @@ static bool IsSubConst2(HGraph* graph,
 // Detect reductions of the following forms,
 //   x = x_phi + ..
 //   x = x_phi - ..
+//   x = min(x_phi, ..)
+//   x = max(x_phi, ..)
 static bool HasReductionFormat(HInstruction* reduction, HInstruction* phi) {
-  if (reduction->IsAdd()) {
+  if (reduction->IsAdd() || reduction->IsMin() || reduction->IsMax()) {
     return (reduction->InputAt(0) == phi && reduction->InputAt(1) != phi) ||
            (reduction->InputAt(0) != phi && reduction->InputAt(1) == phi);
   } else if (reduction->IsSub()) {
@@ -356,6 +358,10 @@ static HVecReduce::ReductionKind GetReductionKind(HVecOperation* reduction) {
       reduction->IsVecSADAccumulate() ||
       reduction->IsVecDotProd()) {
     return HVecReduce::kSum;
+  } else if (reduction->IsVecMin()) {
+    return HVecReduce::kMin;
+  } else if (reduction->IsVecMax()) {
+    return HVecReduce::kMax;
   }
   LOG(FATAL) << "Unsupported SIMD reduction " << reduction->GetId();
   UNREACHABLE();
@@ -793,6 +799,7 @@ bool HLoopOptimization::TryOptimizeInnerLoopFinite(LoopNode* node) {
   // Ensure loop header logic is finite.
   int64_t trip_count = 0;
   if (!induction_range_.IsFinite(node->loop_info, &trip_count)) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedUnknownTripCount);
     return false;
   }
   // Ensure there is only a single loop-body (besides the header).
@@ -800,6 +807,7 @@ bool HLoopOptimization::TryOptimizeInnerLoopFinite(LoopNode* node) {
   for (HBlocksInLoopIterator it(*node->loop_info); !it.Done(); it.Advance()) {
     if (it.Current() != header) {
       if (body != nullptr) {
+        MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedControlFlow);
         return false;
       }
       body = it.Current();
@@ -808,6 +816,7 @@ bool HLoopOptimization::TryOptimizeInnerLoopFinite(LoopNode* node) {
   CHECK(body != nullptr);
   // Ensure there is only a single exit point.
   if (header->GetSuccessors().size() != 2) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedControlFlow);
     return false;
   }
   HBasicBlock* exit = (header->GetSuccessors()[0] == body)
@@ -815,6 +824,7 @@ bool HLoopOptimization::TryOptimizeInnerLoopFinite(LoopNode* node) {
       : header->GetSuccessors()[0];
   // Ensure exit can only be reached by exiting loop.
   if (exit->GetPredecessors().size() != 1) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedControlFlow);
     return false;
   }
   // Detect either an empty loop (no side effects other than plain iteration) or
@@ -845,21 +855,29 @@ bool HLoopOptimization::TryOptimizeInnerLoopFinite(LoopNode* node) {
     }
   }
   // Vectorize loop, if possible and valid.
-  if (kEnableVectorization &&
+  if (!kEnableVectorization ||
       // Disable vectorization for debuggable graphs: this is a workaround for the bug
       // in 'GenerateNewLoop' which caused the SuspendCheck environment to be invalid.
       // TODO: b/138601207, investigate other possible cases with wrong environment values and
       // possibly switch back vectorization on for debuggable graphs.
-      !graph_->IsDebuggable() &&
-      TrySetSimpleLoopHeader(header, &main_phi) &&
-      ShouldVectorize(node, body, trip_count) &&
-      TryAssignLastValue(node->loop_info, main_phi, preheader, /*collect_loop_uses*/ true)) {
-    Vectorize(node, body, exit, trip_count);
-    graph_->SetHasSIMD(true);  // flag SIMD usage
-    MaybeRecordStat(stats_, MethodCompilationStat::kLoopVectorized);
-    return true;
+      graph_->IsDebuggable()) {
+    return false;
   }
-  return false;
+  if (!TrySetSimpleLoopHeader(header, &main_phi)) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedComplexHeader);
+    return false;
+  }
+  if (!ShouldVectorize(node, body, trip_count)) {
+    return false;  // reason recorded in ShouldVectorize()
+  }
+  if (!TryAssignLastValue(node->loop_info, main_phi, preheader, /*collect_loop_uses*/ true)) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedLiveOut);
+    return false;
+  }
+  Vectorize(node, body, exit, trip_count);
+  graph_->SetHasSIMD(true);  // flag SIMD usage
+  MaybeRecordStat(stats_, MethodCompilationStat::kLoopVectorized);
+  return true;
 }
 
 bool HLoopOptimization::OptimizeInnerLoop(LoopNode* node) {
@@ -1017,6 +1035,7 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
 
   // Phis in the loop-body prevent vectorization.
   if (!block->GetPhis().IsEmpty()) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedPhiInBody);
     return false;
   }
 
@@ -1024,6 +1043,7 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
   // occurrence, which allows passing down attributes down the use tree.
   for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
     if (!VectorizeDef(node, it.Current(), /*generate_code*/ false)) {
+      MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedUnsupportedOperation);
       return false;  // failure to vectorize a left-hand-side
     }
   }
@@ -1062,6 +1082,7 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
           // Found a[i+x] vs. a[i+y]. Accept if x == y (loop-independent data dependence).
           // Conservatively assume a loop-carried data dependence otherwise, and reject.
           if (x != y) {
+            MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedDataDependence);
             return false;
           }
           // Count the number of references that have the same alignment (since
@@ -1080,6 +1101,7 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
               vector_runtime_test_b_ = b;
             } else if ((vector_runtime_test_a_ != a || vector_runtime_test_b_ != b) &&
                        (vector_runtime_test_a_ != b || vector_runtime_test_b_ != a)) {
+              MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedDataDependence);
               return false;  // second test would be needed
             }
           }
@@ -1118,6 +1140,7 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
 
   // Does vectorization seem profitable?
   if (!IsVectorizationProfitable(trip_count)) {
+    MaybeRecordStat(stats_, MethodCompilationStat::kLoopNotVectorizedUnprofitable);
     return false;
   }
 
@@ -1437,6 +1460,11 @@ bool HLoopOptimization::VectorizeDef(LoopNode* node,
   auto redit = reductions_->find(instruction);
   if (redit != reductions_->end()) {
     DataType::Type type = instruction->GetType();
+    // Floating-point addition is not associative, so a sum cannot be split over vector
+    // lanes without changing the result. Min/max can, since they are exact.
+    if (DataType::IsFloatingPointType(type) && !instruction->IsMin() && !instruction->IsMax()) {
+      return false;
+    }
     // Recognize SAD idiom or direct reduction.
     if (VectorizeSADIdiom(node, instruction, generate_code, type, restrictions) ||
         VectorizeDotProdIdiom(node, instruction, generate_code, type, restrictions) ||
@@ -1661,6 +1689,35 @@ bool HLoopOptimization::VectorizeUse(LoopNode* node,
       }
       return true;
     }
+  } else if (instruction->IsMin() || instruction->IsMax()) {
+    // Deal with vector restrictions.
+    HInstruction* opa = instruction->InputAt(0);
+    HInstruction* opb = instruction->InputAt(1);
+    HInstruction* r = opa;
+    HInstruction* s = opb;
+    bool is_unsigned = false;
+    if (HasVectorRestrictions(restrictions, kNoMinMax)) {
+      return false;
+    } else if (HasVectorRestrictions(restrictions, kNoHiBits) &&
+               !IsNarrowerOperands(opa, opb, type, &r, &s, &is_unsigned)) {
+      return false;  // reject, unless all operands are same-extension narrower
+    }
+    // Accept MIN/MAX(x, y) for vectorizable operands.
+    DCHECK(r != nullptr && s != nullptr);
+    if (generate_code && vector_mode_ != kVector) {  // de-idiom
+      r = opa;
+      s = opb;
+    }
+    if (VectorizeUse(node, r, generate_code, type, restrictions) &&
+        VectorizeUse(node, s, generate_code, type, restrictions)) {
+      if (generate_code) {
+        GenerateVecOp(instruction,
+                      vector_map_->Get(r),
+                      vector_map_->Get(s),
+                      HVecOperation::ToProperType(type, is_unsigned));
+      }
+      return true;
+    }
   }
   return false;
 }
@@ -1707,7 +1764,8 @@ bool HLoopOptimization::TrySetVectorType(DataType::Type type, uint64_t* restrict
                              kNoSignedHAdd |
                              kNoUnsignedHAdd |
                              kNoUnroundedHAdd |
-                             kNoSAD;
+                             kNoSAD |
+                             kNoMinMax;
             return TrySetVectorLength(type, vector_length);
           case DataType::Type::kUint16:
           case DataType::Type::kInt16:
@@ -1716,19 +1774,20 @@ bool HLoopOptimization::TrySetVectorType(DataType::Type type, uint64_t* restrict
                              kNoUnsignedHAdd |
                              kNoUnroundedHAdd |
                              kNoSAD |
-                             kNoDotProd;
+                             kNoDotProd |
+                             kNoMinMax;
             return TrySetVectorLength(type, vector_length);
           case DataType::Type::kInt32:
-            *restrictions |= kNoDiv | kNoSAD;
+            *restrictions |= kNoDiv | kNoSAD | kNoMinMax;
             return TrySetVectorLength(type, vector_length);
           case DataType::Type::kInt64:
-            *restrictions |= kNoDiv | kNoSAD;
+            *restrictions |= kNoDiv | kNoSAD | kNoMinMax;
             return TrySetVectorLength(type, vector_length);
           case DataType::Type::kFloat32:
-            *restrictions |= kNoReduction;
+            *restrictions |= kNoReduction | kNoMinMax;
             return TrySetVectorLength(type, vector_length);
           case DataType::Type::kFloat64:
-            *restrictions |= kNoReduction;
+            *restrictions |= kNoReduction | kNoMinMax;
             return TrySetVectorLength(type, vector_length);
           default:
             break;
@@ -1751,13 +1810,11 @@ bool HLoopOptimization::TrySetVectorType(DataType::Type type, uint64_t* restrict
             *restrictions |= kNoDiv;
             return TrySetVectorLength(type, 4);
           case DataType::Type::kInt64:
-            *restrictions |= kNoDiv | kNoMul;
+            *restrictions |= kNoDiv | kNoMul | kNoMinMax;
             return TrySetVectorLength(type, 2);
           case DataType::Type::kFloat32:
-            *restrictions |= kNoReduction;
             return TrySetVectorLength(type, 4);
           case DataType::Type::kFloat64:
-            *restrictions |= kNoReduction;
             return TrySetVectorLength(type, 2);
           default:
             break;
@@ -1779,7 +1836,8 @@ bool HLoopOptimization::TrySetVectorType(DataType::Type type, uint64_t* restrict
                              kNoSignedHAdd |
                              kNoUnroundedHAdd |
                              kNoSAD |
-                             kNoDotProd;
+                             kNoDotProd |
+                             kNoMinMax;
             return TrySetVectorLength(type, 16);
           case DataType::Type::kUint16:
             *restrictions |= kNoDiv |
@@ -1787,26 +1845,28 @@ bool HLoopOptimization::TrySetVectorType(DataType::Type type, uint64_t* restrict
                              kNoSignedHAdd |
                              kNoUnroundedHAdd |
                              kNoSAD |
-                             kNoDotProd;
+                             kNoDotProd |
+                             kNoMinMax;
             return TrySetVectorLength(type, 8);
           case DataType::Type::kInt16:
             *restrictions |= kNoDiv |
                              kNoAbs |
                              kNoSignedHAdd |
                              kNoUnroundedHAdd |
-                             kNoSAD;
+                             kNoSAD |
+                             kNoMinMax;
             return TrySetVectorLength(type, 8);
           case DataType::Type::kInt32:
-            *restrictions |= kNoDiv | kNoSAD;
+            *restrictions |= kNoDiv | kNoSAD | kNoMinMax;
             return TrySetVectorLength(type, 4);
           case DataType::Type::kInt64:
-            *restrictions |= kNoMul | kNoDiv | kNoShr | kNoAbs | kNoSAD;
+            *restrictions |= kNoMul | kNoDiv | kNoShr | kNoAbs | kNoSAD | kNoMinMax;
             return TrySetVectorLength(type, 2);
           case DataType::Type::kFloat32:
-            *restrictions |= kNoReduction;
+            *restrictions |= kNoReduction | kNoMinMax;
             return TrySetVectorLength(type, 4);
           case DataType::Type::kFloat64:
-            *restrictions |= kNoReduction;
+            *restrictions |= kNoReduction | kNoMinMax;
             return TrySetVectorLength(type, 2);
           default:
             break;
@@ -2130,6 +2190,14 @@ void HLoopOptimization::GenerateVecOp(HInstruction* org,
       GENERATE_VEC(
         new (global_allocator_) HVecAbs(global_allocator_, opa, type, vector_length_, dex_pc),
         new (global_allocator_) HAbs(org_type, opa, dex_pc));
+    case HInstruction::kMin:
+      GENERATE_VEC(
+        new (global_allocator_) HVecMin(global_allocator_, opa, opb, type, vector_length_, dex_pc),
+        new (global_allocator_) HMin(org_type, opa, opb, dex_pc));
+    case HInstruction::kMax:
+      GENERATE_VEC(
+        new (global_allocator_) HVecMax(global_allocator_, opa, opb, type, vector_length_, dex_pc),
+        new (global_allocator_) HMax(org_type, opa, opb, dex_pc));
     default:
       break;
   }  // switch
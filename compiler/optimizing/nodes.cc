@@ -2330,6 +2330,46 @@ bool HBasicBlock::EndsWithTryBoundary() const {
   return !GetInstructions().IsEmpty() && GetLastInstruction()->IsTryBoundary();
 }
 
+uint64_t HBasicBlock::GetProfiledSuccessorCount(const HBasicBlock* successor,
+                                                /*out*/ uint64_t* total) const {
+  uint64_t count = 0u;
+  *total = 0u;
+  HInstruction* last = GetInstructions().IsEmpty() ? nullptr : GetLastInstruction();
+  if (last == nullptr) {
+    return 0u;
+  } else if (last->IsIf()) {
+    HIf* if_instruction = last->AsIf();
+    *total = static_cast<uint64_t>(if_instruction->GetTrueCount()) +
+             if_instruction->GetFalseCount();
+    if (if_instruction->IfTrueSuccessor() == successor) {
+      count += if_instruction->GetTrueCount();
+    }
+    if (if_instruction->IfFalseSuccessor() == successor) {
+      count += if_instruction->GetFalseCount();
+    }
+  } else if (last->IsPackedSwitch() && last->AsPackedSwitch()->GetProfiledCounts() != nullptr) {
+    // Several entries of the switch may branch to the same successor.
+    const uint32_t* counts = last->AsPackedSwitch()->GetProfiledCounts();
+    for (size_t i = 0, e = successors_.size(); i != e; ++i) {
+      *total += counts[i];
+      if (successors_[i] == successor) {
+        count += counts[i];
+      }
+    }
+  }
+  return count;
+}
+
+bool HBasicBlock::IsColdSuccessor(const HBasicBlock* successor) const {
+  // Ignore branches that did not execute often enough for their profile to be meaningful.
+  static constexpr uint64_t kMinimumProfiledExecutions = 100u;
+  // A successor taken at most once every `kColdSuccessorRatio` executions is cold.
+  static constexpr uint64_t kColdSuccessorRatio = 64u;
+  uint64_t total;
+  uint64_t count = GetProfiledSuccessorCount(successor, &total);
+  return total >= kMinimumProfiledExecutions && count * kColdSuccessorRatio <= total;
+}
+
 bool HBasicBlock::HasSinglePhi() const {
   return !GetPhis().IsEmpty() && GetFirstPhi()->GetNext() == nullptr;
 }
@@ -416,6 +416,7 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
         invoke_type_(invoke_type),
         in_ssa_form_(false),
         number_of_cha_guards_(0),
+        max_region_size_(0u),
         instruction_set_(instruction_set),
         cached_null_constant_(nullptr),
         cached_int_constants_(std::less<int32_t>(), allocator->Adapter(kArenaAllocConstantsMap)),
@@ -742,6 +743,11 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
   void SetNumberOfCHAGuards(uint32_t num) { number_of_cha_guards_ = num; }
   void IncrementNumberOfCHAGuards() { number_of_cha_guards_++; }
 
+  // Passes with superlinear cost restrict their work to regions of at most this many
+  // instructions, see `RegionPartition`. Zero means the whole graph is a single region.
+  size_t GetMaxRegionSize() const { return max_region_size_; }
+  void SetMaxRegionSize(size_t size) { max_region_size_ = size; }
+
  private:
   void RemoveDeadBlocksInstructionsAsUsersAndDisconnect(const ArenaBitVector& visited) const;
   void RemoveDeadBlocks(const ArenaBitVector& visited);
@@ -875,6 +881,10 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
   // CHA guard optimization pass when there is no CHA guard left.
   uint32_t number_of_cha_guards_;
 
+  // Maximum number of instructions in a region for region-based compilation of huge
+  // methods, or zero if the graph is not compiled by regions.
+  size_t max_region_size_;
+
   const InstructionSet instruction_set_;
 
   // Cached constants.
@@ -1288,6 +1298,14 @@ class HBasicBlock : public ArenaObject<kArenaAllocBasicBlock> {
     return GetSuccessors()[0];
   }
 
+  // Returns how many times control flowed to `successor` according to the branch
+  // profile of the last instruction of this block, and the total number of times that
+  // instruction executed in `total`. Both are zero without a profile.
+  uint64_t GetProfiledSuccessorCount(const HBasicBlock* successor, /*out*/ uint64_t* total) const;
+
+  // Returns whether the branch profile shows that control rarely flows to `successor`.
+  bool IsColdSuccessor(const HBasicBlock* successor) const;
+
   // Returns whether the first occurrence of `predecessor` in the list of
   // predecessors is at index `idx`.
   bool IsFirstIndexOfPredecessor(HBasicBlock* predecessor, size_t idx) const {
@@ -3512,10 +3530,28 @@ class HIf final : public HExpression<1> {
     return GetBlock()->GetSuccessors()[1];
   }
 
+  // Number of times the true and false successors were taken according to the profile.
+  uint32_t GetTrueCount() const { return true_count_; }
+  uint32_t GetFalseCount() const { return false_count_; }
+
+  void SetProfiledCounts(uint32_t true_count, uint32_t false_count) {
+    true_count_ = true_count;
+    false_count_ = false_count;
+  }
+
+  bool HasProfiledCounts() const { return true_count_ != 0u || false_count_ != 0u; }
+
+  // Must be called when the successors are swapped.
+  void SwapProfiledCounts() { std::swap(true_count_, false_count_); }
+
   DECLARE_INSTRUCTION(If);
 
  protected:
   DEFAULT_COPY_CONSTRUCTOR(If);
+
+ private:
+  uint32_t true_count_ = 0u;
+  uint32_t false_count_ = 0u;
 };
 
 
@@ -3800,6 +3836,14 @@ class HPackedSwitch final : public HExpression<1> {
     // Last entry is the default block.
     return GetBlock()->GetSuccessors()[num_entries_];
   }
+
+  // Number of times each successor, indexed like the successors of the block, was taken
+  // according to the profile, or null if there is no profile.
+  const uint32_t* GetProfiledCounts() const { return profiled_counts_; }
+
+  // `counts` must have `num_entries_ + 1` elements and outlive the graph.
+  void SetProfiledCounts(const uint32_t* counts) { profiled_counts_ = counts; }
+
   DECLARE_INSTRUCTION(PackedSwitch);
 
  protected:
@@ -3808,6 +3852,7 @@ class HPackedSwitch final : public HExpression<1> {
  private:
   const int32_t start_value_;
   const uint32_t num_entries_;
+  const uint32_t* profiled_counts_ = nullptr;
 };
 
 class HUnaryOperation : public HExpression<1> {
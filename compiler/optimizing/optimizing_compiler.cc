@@ -30,6 +30,7 @@
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "base/scoped_arena_allocator.h"
+#include "base/time_utils.h"
 #include "base/timing_logger.h"
 #include "builder.h"
 #include "code_generator.h"
@@ -103,12 +104,15 @@ class PassObserver : public ValueObject {
   PassObserver(HGraph* graph,
                CodeGenerator* codegen,
                std::ostream* visualizer_output,
-               const CompilerOptions& compiler_options)
+               const CompilerOptions& compiler_options,
+               OptimizingCompilerStats* compilation_stats)
       : graph_(graph),
         last_seen_graph_size_(0),
         cached_method_name_(),
         timing_logger_enabled_(compiler_options.GetDumpPassTimings()),
         timing_logger_(timing_logger_enabled_ ? GetMethodName() : "", true, true),
+        compilation_stats_(compilation_stats),
+        pass_start_ns_(0u),
         disasm_info_(graph->GetAllocator()),
         visualizer_oss_(),
         visualizer_output_(visualizer_output),
@@ -132,6 +136,9 @@ class PassObserver : public ValueObject {
       LOG(INFO) << "TIMINGS " << GetMethodName();
       LOG(INFO) << Dumpable<TimingLogger>(timing_logger_);
     }
+    if (compilation_stats_ != nullptr && !pass_timings_.empty()) {
+      compilation_stats_->RecordPassTimings(GetMethodName(), pass_timings_);
+    }
     if (visualizer_enabled_) {
       FlushVisualizer();
     }
@@ -166,6 +173,9 @@ class PassObserver : public ValueObject {
     if (timing_logger_enabled_) {
       timing_logger_.StartTiming(pass_name);
     }
+    if (compilation_stats_ != nullptr) {
+      pass_start_ns_ = NanoTime();
+    }
   }
 
   void FlushVisualizer() {
@@ -180,6 +190,9 @@ class PassObserver : public ValueObject {
     if (timing_logger_enabled_) {
       timing_logger_.EndTiming();
     }
+    if (compilation_stats_ != nullptr) {
+      pass_timings_.emplace_back(pass_name, NanoTime() - pass_start_ns_);
+    }
     if (visualizer_enabled_) {
       visualizer_.DumpGraph(pass_name, /* is_after_pass= */ true, graph_in_bad_state_);
       FlushVisualizer();
@@ -226,6 +239,11 @@ class PassObserver : public ValueObject {
   bool timing_logger_enabled_;
   TimingLogger timing_logger_;
 
+  // Time spent in each pass, reported to `compilation_stats_` for the compile-time profile.
+  OptimizingCompilerStats* const compilation_stats_;
+  uint64_t pass_start_ns_;
+  PassTimingStats::MethodPassTimings pass_timings_;
+
   DisassemblyInformation disasm_info_;
 
   std::ostringstream visualizer_oss_;
@@ -558,7 +576,8 @@ bool OptimizingCompiler::RunArchOptimizations(HGraph* graph,
         OptDef(OptimizationPass::kInstructionSimplifierX86_64),
         OptDef(OptimizationPass::kSideEffectsAnalysis),
         OptDef(OptimizationPass::kGlobalValueNumbering, "GVN$after_arch"),
-        OptDef(OptimizationPass::kX86MemoryOperandGeneration)
+        OptDef(OptimizationPass::kX86MemoryOperandGeneration),
+        OptDef(OptimizationPass::kScheduling)
       };
       return RunOptimizations(graph,
                               codegen,
@@ -575,6 +594,34 @@ bool OptimizingCompiler::RunArchOptimizations(HGraph* graph,
   }
 }
 
+// Record the number of moves to and from the stack inserted by the register allocator.
+static void RecordStackMoves(HGraph* graph, OptimizingCompilerStats* stats) {
+  if (stats == nullptr) {
+    return;
+  }
+  uint32_t stack_moves = 0u;
+  for (HBasicBlock* block : graph->GetLinearOrder()) {
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HParallelMove* parallel_move = it.Current()->AsParallelMove();
+      if (parallel_move == nullptr) {
+        continue;
+      }
+      for (size_t i = 0, e = parallel_move->NumMoves(); i != e; ++i) {
+        MoveOperands* move = parallel_move->MoveOperandsAt(i);
+        if (move->GetSource().IsStackSlot() ||
+            move->GetSource().IsDoubleStackSlot() ||
+            move->GetSource().IsSIMDStackSlot() ||
+            move->GetDestination().IsStackSlot() ||
+            move->GetDestination().IsDoubleStackSlot() ||
+            move->GetDestination().IsSIMDStackSlot()) {
+          ++stack_moves;
+        }
+      }
+    }
+  }
+  MaybeRecordStat(stats, MethodCompilationStat::kRegisterAllocatorStackMoves, stack_moves);
+}
+
 NO_INLINE  // Avoid increasing caller's frame size by large stack-allocated objects.
 static void AllocateRegisters(HGraph* graph,
                               CodeGenerator* codegen,
@@ -594,12 +641,14 @@ static void AllocateRegisters(HGraph* graph,
     PassScope scope(SsaLivenessAnalysis::kLivenessPassName, pass_observer);
     liveness.Analyze();
   }
+  strategy = RegisterAllocator::ApplyCompileTimeBudget(strategy, liveness, stats);
   {
     PassScope scope(RegisterAllocator::kRegisterAllocatorPassName, pass_observer);
     std::unique_ptr<RegisterAllocator> register_allocator =
         RegisterAllocator::Create(&local_allocator, codegen, liveness, strategy);
     register_allocator->AllocateRegisters();
   }
+  RecordStackMoves(graph, stats);
 }
 
 // Strip pass name suffix to get optimization name.
@@ -846,7 +895,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
   PassObserver pass_observer(graph,
                              codegen.get(),
                              visualizer_output_.get(),
-                             compiler_options);
+                             compiler_options,
+                             compilation_stats_.get());
 
   {
     VLOG(compiler) << "Building " << pass_observer.GetMethodName();
@@ -906,8 +956,14 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
     WriteBarrierElimination(graph, compilation_stats_.get()).Run();
   }
 
-  RegisterAllocator::Strategy regalloc_strategy =
-    compiler_options.GetRegisterAllocationStrategy();
+  RegisterAllocator::Strategy regalloc_strategy = RegisterAllocator::GetStrategyForMethod(
+      compiler_options,
+      MethodReference(dex_compilation_unit.GetDexFile(), dex_compilation_unit.GetDexMethodIndex()),
+      compilation_kind);
+  if (graph->GetMaxRegionSize() != 0u) {
+    // Keep the register allocation time of huge methods compiled by regions linear.
+    regalloc_strategy = RegisterAllocator::kRegisterAllocatorLinearScan;
+  }
   AllocateRegisters(graph,
                     codegen.get(),
                     &pass_observer,
@@ -918,6 +974,9 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
   pass_observer.DumpDisassembly();
 
   MaybeRecordStat(compilation_stats_.get(), MethodCompilationStat::kCompiledBytecode);
+  MaybeRecordStat(compilation_stats_.get(),
+                  MethodCompilationStat::kCompiledBytecodeCodeSize,
+                  codegen->GetAssembler()->CodeSize());
   return codegen.release();
 }
 
@@ -971,7 +1030,8 @@ CodeGenerator* OptimizingCompiler::TryCompileIntrinsic(
   PassObserver pass_observer(graph,
                              codegen.get(),
                              visualizer_output_.get(),
-                             compiler_options);
+                             compiler_options,
+                             compilation_stats_.get());
 
   {
     VLOG(compiler) << "Building intrinsic graph " << pass_observer.GetMethodName();
@@ -1005,7 +1065,11 @@ CodeGenerator* OptimizingCompiler::TryCompileIntrinsic(
   AllocateRegisters(graph,
                     codegen.get(),
                     &pass_observer,
-                    compiler_options.GetRegisterAllocationStrategy(),
+                    RegisterAllocator::GetStrategyForMethod(
+                        compiler_options,
+                        MethodReference(dex_compilation_unit.GetDexFile(),
+                                        dex_compilation_unit.GetDexMethodIndex()),
+                        CompilationKind::kOptimized),
                     compilation_stats_.get());
   if (!codegen->IsLeafMethod()) {
     VLOG(compiler) << "Intrinsic method is not leaf: " << method->GetIntrinsic()
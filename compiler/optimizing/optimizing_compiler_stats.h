@@ -17,10 +17,15 @@
 #ifndef ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_STATS_H_
 #define ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_STATS_H_
 
+#include <algorithm>
 #include <atomic>
 #include <iomanip>
+#include <map>
+#include <mutex>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <android-base/logging.h>
 
@@ -66,6 +71,7 @@ enum class MethodCompilationStat {
   kNotCompiledPhiEquivalentInOsr,
   kInlinedMonomorphicCall,
   kInlinedPolymorphicCall,
+  kInlinedMegamorphicCall,
   kMonomorphicCall,
   kPolymorphicCall,
   kMegamorphicCall,
@@ -74,6 +80,14 @@ enum class MethodCompilationStat {
   kLoopInvariantMoved,
   kLoopVectorized,
   kLoopVectorizedIdiom,
+  kLoopNotVectorizedUnknownTripCount,
+  kLoopNotVectorizedControlFlow,
+  kLoopNotVectorizedComplexHeader,
+  kLoopNotVectorizedPhiInBody,
+  kLoopNotVectorizedUnsupportedOperation,
+  kLoopNotVectorizedDataDependence,
+  kLoopNotVectorizedUnprofitable,
+  kLoopNotVectorizedLiveOut,
   kSelectGenerated,
   kRemovedInstanceOf,
   kPropagatedIfValue,
@@ -133,10 +147,102 @@ enum class MethodCompilationStat {
   kPredicatedLoadAdded,
   kPredicatedStoreAdded,
   kDevirtualized,
+  kRegisterAllocatorGraphColor,
+  kRegisterAllocatorGraphColorOverBudget,
+  kRegisterAllocatorStackMoves,
+  kCompiledBytecodeCodeSize,
+  kCompiledHugeMethodByRegions,
   kLastStat
 };
 std::ostream& operator<<(std::ostream& os, MethodCompilationStat rhs);
 
+// Compile-time profile of the optimizing compiler: the time spent in each pass over all
+// compiled methods, and the per-pass breakdown of the methods that took longest to compile.
+class PassTimingStats {
+ public:
+  // Pass names with the time spent in them in nanoseconds, in execution order.
+  using MethodPassTimings = std::vector<std::pair<const char*, uint64_t>>;
+
+  PassTimingStats() {}
+
+  void RecordMethod(const std::string& method_name, const MethodPassTimings& pass_timings) {
+    uint64_t method_ns = 0u;
+    for (const std::pair<const char*, uint64_t>& pass_timing : pass_timings) {
+      method_ns += pass_timing.second;
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    for (const std::pair<const char*, uint64_t>& pass_timing : pass_timings) {
+      PassTime& pass_time = passes_[pass_timing.first];
+      pass_time.total_ns += pass_timing.second;
+      pass_time.max_ns = std::max(pass_time.max_ns, pass_timing.second);
+      ++pass_time.count;
+    }
+    if (slowest_methods_.size() == kNumberOfSlowestMethods &&
+        slowest_methods_.back().total_ns >= method_ns) {
+      return;
+    }
+    MethodTime method_time = {method_name, method_ns, {}};
+    for (const std::pair<const char*, uint64_t>& pass_timing : pass_timings) {
+      method_time.passes.emplace_back(pass_timing.first, pass_timing.second);
+    }
+    auto it = std::upper_bound(slowest_methods_.begin(),
+                               slowest_methods_.end(),
+                               method_ns,
+                               [](uint64_t ns, const MethodTime& other) {
+                                 return ns > other.total_ns;
+                               });
+    slowest_methods_.insert(it, std::move(method_time));
+    if (slowest_methods_.size() > kNumberOfSlowestMethods) {
+      slowest_methods_.pop_back();
+    }
+  }
+
+  void Log() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (passes_.empty()) {
+      return;
+    }
+    std::vector<std::pair<std::string, PassTime>> passes(passes_.begin(), passes_.end());
+    std::sort(passes.begin(), passes.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.second.total_ns > rhs.second.total_ns;
+    });
+    for (const std::pair<std::string, PassTime>& pass : passes) {
+      LOG(INFO) << "PassTime#" << pass.first << ": total " << pass.second.total_ns / 1000u
+          << "us, max " << pass.second.max_ns / 1000u << "us, runs " << pass.second.count;
+    }
+    for (const MethodTime& method : slowest_methods_) {
+      LOG(INFO) << "SlowMethod#" << method.name << ": " << method.total_ns / 1000u << "us";
+      for (const std::pair<std::string, uint64_t>& pass : method.passes) {
+        LOG(INFO) << "SlowMethod#  " << pass.first << ": " << pass.second / 1000u << "us";
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kNumberOfSlowestMethods = 10u;
+
+  struct PassTime {
+    uint64_t total_ns = 0u;
+    uint64_t max_ns = 0u;
+    size_t count = 0u;
+  };
+
+  struct MethodTime {
+    std::string name;
+    uint64_t total_ns;
+    std::vector<std::pair<std::string, uint64_t>> passes;
+  };
+
+  mutable std::mutex lock_;
+  // Keyed by pass name, so that each occurrence of a pass (e.g. "GVN" and "GVN$after_arch")
+  // is reported separately.
+  std::map<std::string, PassTime> passes_;
+  // Sorted by decreasing compile time.
+  std::vector<MethodTime> slowest_methods_;
+
+  DISALLOW_COPY_AND_ASSIGN(PassTimingStats);
+};
+
 class OptimizingCompilerStats {
  public:
   OptimizingCompilerStats() {
@@ -183,9 +289,15 @@ class OptimizingCompilerStats {
               << compile_stats_[i];
         }
       }
+      pass_timings_.Log();
     }
   }
 
+  void RecordPassTimings(const std::string& method_name,
+                         const PassTimingStats::MethodPassTimings& pass_timings) {
+    pass_timings_.RecordMethod(method_name, pass_timings);
+  }
+
   void AddTo(OptimizingCompilerStats* other_stats) {
     for (size_t i = 0; i != arraysize(compile_stats_); ++i) {
       uint32_t count = compile_stats_[i];
@@ -203,6 +315,7 @@ class OptimizingCompilerStats {
 
  private:
   std::atomic<uint32_t> compile_stats_[static_cast<size_t>(MethodCompilationStat::kLastStat)];
+  PassTimingStats pass_timings_;
 
   DISALLOW_COPY_AND_ASSIGN(OptimizingCompilerStats);
 };
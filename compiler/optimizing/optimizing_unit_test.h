@@ -232,7 +232,8 @@ class OptimizingUnitTestHelper {
     pool_and_allocator_.reset(new ArenaPoolAndAllocator());
   }
 
-  HGraph* CreateGraph(VariableSizedHandleScope* handles = nullptr) {
+  HGraph* CreateGraph(VariableSizedHandleScope* handles = nullptr,
+                      CompilationKind compilation_kind = CompilationKind::kOptimized) {
     ArenaAllocator* const allocator = pool_and_allocator_->GetAllocator();
 
     // Reserve a big array of 0s so the dex file constructor can offsets from the header.
@@ -256,16 +257,21 @@ class OptimizingUnitTestHelper {
         handles,
         *dex_files_.back(),
         /*method_idx*/-1,
-        kRuntimeISA);
+        kRuntimeISA,
+        kInvalidInvokeType,
+        /*dead_reference_safe*/ false,
+        /*debuggable*/ false,
+        compilation_kind);
     return graph_;
   }
 
   // Create a control-flow graph from Dex instructions.
   HGraph* CreateCFG(const std::vector<uint16_t>& data,
-                    DataType::Type return_type = DataType::Type::kInt32) {
+                    DataType::Type return_type = DataType::Type::kInt32,
+                    CompilationKind compilation_kind = CompilationKind::kOptimized) {
     ScopedObjectAccess soa(Thread::Current());
     VariableSizedHandleScope handles(soa.Self());
-    HGraph* graph = CreateGraph(&handles);
+    HGraph* graph = CreateGraph(&handles, compilation_kind);
 
     // The code item data might not aligned to 4 bytes, copy it to ensure that.
     const size_t code_item_size = data.size() * sizeof(data.front());
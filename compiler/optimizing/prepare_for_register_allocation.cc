@@ -16,6 +16,7 @@
 
 #include "prepare_for_register_allocation.h"
 
+#include "code_generator.h"
 #include "dex/dex_file_types.h"
 #include "driver/compiler_options.h"
 #include "jni/jni_internal.h"
@@ -180,6 +181,12 @@ bool PrepareForRegisterAllocation::CanEmitConditionAt(HCondition* condition,
     return false;
   }
 
+  if (user->IsIf() &&
+      CodeGenerator::GetBranchCacheToUpdate(GetGraph(), user->AsIf()) != nullptr) {
+    // Profiled branches index their counters with the materialized condition.
+    return false;
+  }
+
   if (user->IsIf() || user->IsDeoptimize()) {
     return true;
   }
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "region_partition.h"
+
+namespace art HIDDEN {
+
+static size_t CountInstructionsAndPhis(const HBasicBlock* block) {
+  size_t count = 0u;
+  for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+    ++count;
+  }
+  for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    ++count;
+  }
+  return count;
+}
+
+bool RegionPartition::CanStartRegion(const HBasicBlock* block) {
+  if (!block->IsInLoop()) {
+    return true;
+  }
+  return block->IsLoopHeader() && !block->GetLoopInformation()->GetPreHeader()->IsInLoop();
+}
+
+RegionPartition::RegionPartition(const HGraph* graph,
+                                 size_t max_region_size,
+                                 ScopedArenaAllocator* allocator)
+    : regions_(graph->GetBlocks().size(), kNoRegion, allocator->Adapter(kArenaAllocOptimization)),
+      number_of_regions_(0u) {
+  DCHECK_NE(max_region_size, 0u);
+  size_t current_region_size = 0u;
+  for (HBasicBlock* block : graph->GetReversePostOrder()) {
+    size_t block_size = CountInstructionsAndPhis(block);
+    if (number_of_regions_ == 0u ||
+        (current_region_size != 0u &&
+         current_region_size + block_size > max_region_size &&
+         CanStartRegion(block))) {
+      ++number_of_regions_;
+      current_region_size = 0u;
+    }
+    regions_[block->GetBlockId()] = number_of_regions_ - 1u;
+    current_region_size += block_size;
+  }
+}
+
+}  // namespace art
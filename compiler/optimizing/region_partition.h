@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_REGION_PARTITION_H_
+#define ART_COMPILER_OPTIMIZING_REGION_PARTITION_H_
+
+#include "base/macros.h"
+#include "base/scoped_arena_allocator.h"
+#include "base/scoped_arena_containers.h"
+#include "nodes.h"
+
+namespace art HIDDEN {
+
+// Partitions the blocks of a graph into regions for region-based compilation of huge methods.
+//
+// Regions are contiguous ranges of the reverse post order holding at most `max_region_size`
+// instructions and phis, unless a single block or loop is bigger. A region only starts at a
+// block outside of any loop or at the header of an outermost loop, so that a loop is kept in
+// one region.
+//
+// Passes whose cost is superlinear in the size of the graph use the partition to bound their
+// work: they do not propagate information from one region into the next. This gives up some
+// optimizations across region boundaries in exchange for a bounded compile time.
+class RegionPartition : public ValueObject {
+ public:
+  RegionPartition(const HGraph* graph, size_t max_region_size, ScopedArenaAllocator* allocator);
+
+  size_t GetNumberOfRegions() const { return number_of_regions_; }
+
+  // Returns the region of `block`. Regions are numbered in reverse post order.
+  uint32_t GetRegion(const HBasicBlock* block) const {
+    DCHECK_LT(block->GetBlockId(), regions_.size());
+    DCHECK_NE(regions_[block->GetBlockId()], kNoRegion);
+    return regions_[block->GetBlockId()];
+  }
+
+  // Returns whether `block` is dominated by a block of another region, in which case
+  // passes start from scratch at `block`.
+  bool IsRegionEntry(const HBasicBlock* block) const {
+    return !block->IsEntryBlock() && GetRegion(block) != GetRegion(block->GetDominator());
+  }
+
+ private:
+  static constexpr uint32_t kNoRegion = static_cast<uint32_t>(-1);
+
+  static bool CanStartRegion(const HBasicBlock* block);
+
+  ScopedArenaVector<uint32_t> regions_;
+  size_t number_of_regions_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegionPartition);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_REGION_PARTITION_H_
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "region_partition.h"
+
+#include "base/macros.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+
+namespace art HIDDEN {
+
+class RegionPartitionTest : public OptimizingUnitTest {
+ protected:
+  RegionPartitionTest() : graph_(CreateGraph()) {}
+
+  AdjacencyListGraph SetupFromAdjacencyList(const std::string_view entry_name,
+                                            const std::string_view exit_name,
+                                            const std::vector<AdjacencyListGraph::Edge>& adj) {
+    AdjacencyListGraph blks(graph_, GetAllocator(), entry_name, exit_name, adj);
+    // Give every block a single instruction so that region sizes count blocks.
+    for (HBasicBlock* block : graph_->GetBlocks()) {
+      if (block == graph_->GetExitBlock()) {
+        block->AddInstruction(new (GetAllocator()) HExit());
+      } else {
+        block->AddInstruction(new (GetAllocator()) HGoto());
+      }
+    }
+    return blks;
+  }
+
+  HGraph* graph_;
+};
+
+TEST_F(RegionPartitionTest, StraightLine) {
+  AdjacencyListGraph blks(SetupFromAdjacencyList("entry",
+                                                 "exit",
+                                                 {{"entry", "a"},
+                                                  {"a", "b"},
+                                                  {"b", "c"},
+                                                  {"c", "exit"}}));
+  RegionPartition regions(graph_, /* max_region_size= */ 2u, GetScopedAllocator());
+
+  ASSERT_EQ(regions.GetNumberOfRegions(), 3u);
+  EXPECT_EQ(regions.GetRegion(blks.Get("entry")), 0u);
+  EXPECT_EQ(regions.GetRegion(blks.Get("a")), 0u);
+  EXPECT_EQ(regions.GetRegion(blks.Get("b")), 1u);
+  EXPECT_EQ(regions.GetRegion(blks.Get("c")), 1u);
+  EXPECT_EQ(regions.GetRegion(blks.Get("exit")), 2u);
+
+  EXPECT_FALSE(regions.IsRegionEntry(blks.Get("entry")));
+  EXPECT_FALSE(regions.IsRegionEntry(blks.Get("a")));
+  EXPECT_TRUE(regions.IsRegionEntry(blks.Get("b")));
+  EXPECT_FALSE(regions.IsRegionEntry(blks.Get("c")));
+  EXPECT_TRUE(regions.IsRegionEntry(blks.Get("exit")));
+}
+
+TEST_F(RegionPartitionTest, SingleRegionWhenLargeEnough) {
+  AdjacencyListGraph blks(SetupFromAdjacencyList("entry",
+                                                 "exit",
+                                                 {{"entry", "left"},
+                                                  {"entry", "right"},
+                                                  {"left", "exit"},
+                                                  {"right", "exit"}}));
+  RegionPartition regions(graph_, /* max_region_size= */ 100u, GetScopedAllocator());
+
+  ASSERT_EQ(regions.GetNumberOfRegions(), 1u);
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    EXPECT_EQ(regions.GetRegion(block), 0u) << blks.GetName(block);
+    EXPECT_FALSE(regions.IsRegionEntry(block)) << blks.GetName(block);
+  }
+}
+
+}  // namespace art
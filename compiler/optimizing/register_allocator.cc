@@ -23,6 +23,9 @@
 #include "base/scoped_arena_containers.h"
 #include "base/bit_vector-inl.h"
 #include "code_generator.h"
+#include "driver/compiler_options.h"
+#include "optimizing_compiler_stats.h"
+#include "profile/profile_compilation_info.h"
 #include "register_allocator_graph_color.h"
 #include "register_allocator_linear_scan.h"
 #include "ssa_liveness_analysis.h"
@@ -53,6 +56,43 @@ std::unique_ptr<RegisterAllocator> RegisterAllocator::Create(ScopedArenaAllocato
   }
 }
 
+RegisterAllocator::Strategy RegisterAllocator::GetStrategyForMethod(
+    const CompilerOptions& compiler_options,
+    MethodReference method_ref,
+    CompilationKind compilation_kind) {
+  Strategy strategy = compiler_options.GetRegisterAllocationStrategy();
+  if (strategy != kRegisterAllocatorGraphColorForHotMethods) {
+    return strategy;
+  }
+  bool is_hot = false;
+  if (compilation_kind == CompilationKind::kBaseline) {
+    // Baseline code is short-lived, the method is recompiled once it gets hot.
+  } else if (compiler_options.IsJitCompiler()) {
+    // The JIT only optimizes methods that are hot.
+    is_hot = true;
+  } else {
+    const ProfileCompilationInfo* pci = compiler_options.GetProfileCompilationInfo();
+    is_hot = pci != nullptr && pci->GetMethodHotness(method_ref).IsHot();
+  }
+  return is_hot ? kRegisterAllocatorGraphColor : kRegisterAllocatorLinearScan;
+}
+
+RegisterAllocator::Strategy RegisterAllocator::ApplyCompileTimeBudget(
+    Strategy strategy,
+    const SsaLivenessAnalysis& liveness,
+    OptimizingCompilerStats* stats) {
+  DCHECK_NE(strategy, kRegisterAllocatorGraphColorForHotMethods);
+  if (strategy == kRegisterAllocatorGraphColor) {
+    if (RegisterAllocatorGraphColor::IsWithinCompileTimeBudget(liveness)) {
+      MaybeRecordStat(stats, MethodCompilationStat::kRegisterAllocatorGraphColor);
+    } else {
+      MaybeRecordStat(stats, MethodCompilationStat::kRegisterAllocatorGraphColorOverBudget);
+      strategy = kRegisterAllocatorLinearScan;
+    }
+  }
+  return strategy;
+}
+
 RegisterAllocator::~RegisterAllocator() {
   if (kIsDebugBuild) {
     // Poison live interval pointers with "Error: BAD 71ve1nt3rval."
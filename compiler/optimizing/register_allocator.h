@@ -21,16 +21,20 @@
 #include "base/array_ref.h"
 #include "base/arena_object.h"
 #include "base/macros.h"
+#include "compilation_kind.h"
+#include "dex/method_reference.h"
 
 namespace art HIDDEN {
 
 class CodeGenerator;
+class CompilerOptions;
 class HBasicBlock;
 class HGraph;
 class HInstruction;
 class HParallelMove;
 class LiveInterval;
 class Location;
+class OptimizingCompilerStats;
 class SsaLivenessAnalysis;
 
 /**
@@ -40,7 +44,10 @@ class RegisterAllocator : public DeletableArenaObject<kArenaAllocRegisterAllocat
  public:
   enum Strategy {
     kRegisterAllocatorLinearScan,
-    kRegisterAllocatorGraphColor
+    kRegisterAllocatorGraphColor,
+    // Graph coloring for hot methods, linear scan for the others. The compiler resolves this
+    // to one of the strategies above for each method before creating the allocator.
+    kRegisterAllocatorGraphColorForHotMethods
   };
 
   static constexpr Strategy kRegisterAllocatorDefault = kRegisterAllocatorLinearScan;
@@ -50,6 +57,18 @@ class RegisterAllocator : public DeletableArenaObject<kArenaAllocRegisterAllocat
                                                    const SsaLivenessAnalysis& analysis,
                                                    Strategy strategy = kRegisterAllocatorDefault);
 
+  // Resolve `kRegisterAllocatorGraphColorForHotMethods` to the strategy to use for the method
+  // `method_ref` compiled with `compilation_kind`. Other strategies are returned unchanged.
+  static Strategy GetStrategyForMethod(const CompilerOptions& compiler_options,
+                                       MethodReference method_ref,
+                                       CompilationKind compilation_kind);
+
+  // Return the strategy to use for the graph analyzed by `liveness`. Graph coloring falls
+  // back to linear scan for graphs that exceed its compile time budget.
+  static Strategy ApplyCompileTimeBudget(Strategy strategy,
+                                         const SsaLivenessAnalysis& liveness,
+                                         OptimizingCompilerStats* stats);
+
   virtual ~RegisterAllocator();
 
   // Main entry point for the register allocator. Given the liveness analysis,
@@ -48,6 +48,29 @@ static constexpr size_t kSingleJumpBlockWeightMultiplier = 2;
 // be executed on every path through the method.
 static constexpr size_t kDominatesExitBlockWeightMultiplier = 2;
 
+// The cost of a move in a block outside of loops. The weight multipliers above scale it up,
+// and it is large enough to keep the relative cost of moves in cold blocks after dividing
+// it by kColdBlockWeightDivisor.
+static constexpr size_t kBaseMoveCost = 8;
+
+// Moves in blocks that are rarely executed, because they handle or throw exceptions or
+// because the branch profile says so, are much cheaper than moves in other blocks.
+static constexpr size_t kColdBlockWeightDivisor = 8;
+static_assert(kBaseMoveCost >= kColdBlockWeightDivisor, "Moves must have a non-zero cost");
+
+// Spilling a constant does not need a store and its reloads can be rematerialized as
+// immediates, so constants are cheaper to spill than other values with the same uses.
+static constexpr float kRematerializableSpillWeightDivisor = 2.0f;
+
+// Iterative move coalescing is the most expensive part of a coloring attempt. When the
+// interference graph is hard to color, we stop coalescing after this many attempts so that
+// the remaining attempts, which only split intervals, finish quickly.
+static constexpr size_t kMaxIterativeCoalescingAttempts = 8;
+
+// Building the interference graph is quadratic in the number of live intervals in the worst
+// case. Methods with more SSA values than this are left to the linear scan allocator.
+static constexpr size_t kMaxSsaValuesForGraphColoring = 5000;
+
 enum class CoalesceKind {
   kAdjacentSibling,       // Prevents moves at interval split points.
   kFixedOutputSibling,    // Prevents moves from a fixed output location.
@@ -72,11 +95,20 @@ static size_t LoopDepthAt(HBasicBlock* block) {
   return depth;
 }
 
+// Return whether the block is expected to be rarely executed.
+static bool IsColdBlock(HBasicBlock* block) {
+  if (block->IsCatchBlock() || block->GetLastInstruction()->IsThrow()) {
+    return true;
+  }
+  return block->GetPredecessors().size() == 1u &&
+         block->GetSinglePredecessor()->IsColdSuccessor(block);
+}
+
 // Return the runtime cost of inserting a move instruction at the specified location.
 static size_t CostForMoveAt(size_t position, const SsaLivenessAnalysis& liveness) {
   HBasicBlock* block = liveness.GetBlockFromPosition(position / 2);
   DCHECK(block != nullptr);
-  size_t cost = 1;
+  size_t cost = kBaseMoveCost;
   if (block->IsSingleJump()) {
     cost *= kSingleJumpBlockWeightMultiplier;
   }
@@ -86,6 +118,10 @@ static size_t CostForMoveAt(size_t position, const SsaLivenessAnalysis& liveness
   for (size_t loop_depth = LoopDepthAt(block); loop_depth > 0; --loop_depth) {
     cost *= kLoopSpillWeightMultiplier;
   }
+  if (IsColdBlock(block)) {
+    // A cold block inside a loop may still run more often than a hot block outside of it.
+    cost /= kColdBlockWeightDivisor;
+  }
   return cost;
 }
 
@@ -193,7 +229,12 @@ static float ComputeSpillWeight(LiveInterval* interval, const SsaLivenessAnalysi
 
   // We divide by the length of the interval because we want to prioritize
   // short intervals; we do not benefit much if we split them further.
-  return static_cast<float>(use_weight) / static_cast<float>(length);
+  float weight = static_cast<float>(use_weight) / static_cast<float>(length);
+  HInstruction* defined_by = interval->GetParent()->GetDefinedBy();
+  if (defined_by != nullptr && defined_by->IsConstant()) {
+    weight /= kRematerializableSpillWeightDivisor;
+  }
+  return weight;
 }
 
 // Interference nodes make up the interference graph, which is the primary data structure in
@@ -410,10 +451,10 @@ class InterferenceNode : public ArenaObject<kArenaAllocRegisterAllocator> {
 // short intervals. That way, if we fail to color a node, it either won't require a
 // register, or it will be a long interval that can be split in order to make the
 // interference graph sparser.
-// To improve code quality, we prioritize intervals used frequently in deeply nested loops.
+// To improve code quality, we prioritize intervals used frequently in deeply nested loops
+// and outside of cold blocks, and deprioritize constants since they can be rematerialized.
 // (This metric is secondary to the forward progress requirements above.)
 // TODO: May also want to consider:
-// - Constants (since they can be rematerialized)
 // - Allocated spill slots
 static bool HasGreaterNodePriority(const InterferenceNode* lhs,
                                    const InterferenceNode* rhs) {
@@ -622,6 +663,10 @@ RegisterAllocatorGraphColor::RegisterAllocatorGraphColor(ScopedArenaAllocator* a
 
 RegisterAllocatorGraphColor::~RegisterAllocatorGraphColor() {}
 
+bool RegisterAllocatorGraphColor::IsWithinCompileTimeBudget(const SsaLivenessAnalysis& liveness) {
+  return liveness.GetNumberOfSsaValues() <= kMaxSsaValuesForGraphColoring;
+}
+
 void RegisterAllocatorGraphColor::AllocateRegisters() {
   // (1) Collect and prepare live intervals.
   ProcessInstructions();
@@ -658,10 +703,10 @@ void RegisterAllocatorGraphColor::AllocateRegisters() {
       iteration.BuildInterferenceGraph(intervals, physical_nodes);
 
       // (3) Add coalesce opportunities.
-      //     If we have tried coloring the graph a suspiciously high number of times, give
-      //     up on move coalescing, just in case the coalescing heuristics are not conservative.
-      //     (This situation will be caught if DCHECKs are turned on.)
-      if (iterative_move_coalescing_ && attempt <= kMaxGraphColoringAttemptsDebug) {
+      //     If we have tried coloring the graph many times, give up on move coalescing to
+      //     bound the compile time. This also guards against coalescing heuristics that are
+      //     not conservative. (A lack of forward progress is caught if DCHECKs are turned on.)
+      if (iterative_move_coalescing_ && attempt <= kMaxIterativeCoalescingAttempts) {
         iteration.FindCoalesceOpportunities();
       }
 
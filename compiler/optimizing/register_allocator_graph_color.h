@@ -96,6 +96,10 @@ class RegisterAllocatorGraphColor : public RegisterAllocator {
 
   bool Validate(bool log_fatal_on_failure) override;
 
+  // Return whether graph coloring can allocate registers for the method analyzed by `liveness`
+  // in a reasonable amount of time. Otherwise, the linear scan allocator should be used.
+  static bool IsWithinCompileTimeBudget(const SsaLivenessAnalysis& liveness);
+
  private:
   // Collect all intervals and prepare for register allocation.
   void ProcessInstructions();
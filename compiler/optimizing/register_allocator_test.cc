@@ -25,9 +25,11 @@
 #include "dex/dex_file.h"
 #include "dex/dex_file_types.h"
 #include "dex/dex_instruction.h"
+#include "dex/method_reference.h"
 #include "driver/compiler_options.h"
 #include "nodes.h"
 #include "optimizing_unit_test.h"
+#include "profile/profile_compilation_info.h"
 #include "register_allocator_linear_scan.h"
 #include "ssa_liveness_analysis.h"
 #include "ssa_phi_elimination.h"
@@ -66,6 +68,22 @@ class RegisterAllocatorTest : public CommonCompilerTest, public OptimizingUnitTe
   HGraph* BuildDiv(HInstruction** div);
   void ExpectedExactInRegisterAndSameOutputHint(Strategy strategy);
 
+  // Set up the compiler options used for resolving the strategy for a method.
+  void SetStrategyOptions(Strategy strategy,
+                          CompilerOptions::CompilerType compiler_type,
+                          const ProfileCompilationInfo* profile) {
+    compiler_options_->register_allocation_strategy_ = strategy;
+    compiler_options_->compiler_type_ = compiler_type;
+    compiler_options_->profile_compilation_info_ = profile;
+  }
+
+  Strategy ApplyCompileTimeBudget(Strategy strategy, HGraph* graph) {
+    x86::CodeGeneratorX86 codegen(graph, *compiler_options_);
+    SsaLivenessAnalysis liveness(graph, &codegen, GetScopedAllocator());
+    liveness.Analyze();
+    return RegisterAllocator::ApplyCompileTimeBudget(strategy, liveness, /*stats=*/ nullptr);
+  }
+
   bool ValidateIntervals(const ScopedArenaVector<LiveInterval*>& intervals,
                          const CodeGenerator& codegen) {
     return RegisterAllocator::ValidateIntervals(ArrayRef<LiveInterval* const>(intervals),
@@ -942,4 +960,94 @@ TEST_F(RegisterAllocatorTest, SpillInactive) {
   ASSERT_TRUE(ValidateIntervals(intervals, codegen));
 }
 
+TEST_F(RegisterAllocatorTest, GetStrategyForMethod) {
+  using Hotness = ProfileCompilationInfo::MethodHotness;
+  using CompilerType = CompilerOptions::CompilerType;
+  std::unique_ptr<const DexFile> dex_file(OpenTestDexFile("Main"));
+  ASSERT_GE(dex_file->NumMethodIds(), 2u);
+  MethodReference hot_method(dex_file.get(), 0u);
+  MethodReference cold_method(dex_file.get(), 1u);
+  ProfileCompilationInfo profile;
+  std::vector<uint16_t> hot_methods = {hot_method.index};
+  ASSERT_TRUE(profile.AddMethodsForDex(
+      Hotness::kFlagHot, dex_file.get(), hot_methods.begin(), hot_methods.end()));
+
+  auto get_strategy = [&](MethodReference method_ref, CompilationKind compilation_kind) {
+    return RegisterAllocator::GetStrategyForMethod(
+        *compiler_options_, method_ref, compilation_kind);
+  };
+
+  // Explicit strategies are used for all methods.
+  SetStrategyOptions(Strategy::kRegisterAllocatorGraphColor, CompilerType::kAotCompiler, &profile);
+  EXPECT_EQ(Strategy::kRegisterAllocatorGraphColor,
+            get_strategy(cold_method, CompilationKind::kBaseline));
+  SetStrategyOptions(Strategy::kRegisterAllocatorLinearScan, CompilerType::kAotCompiler, &profile);
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            get_strategy(hot_method, CompilationKind::kOptimized));
+
+  // AOT compilation uses graph coloring for methods that are hot in the profile.
+  SetStrategyOptions(
+      Strategy::kRegisterAllocatorGraphColorForHotMethods, CompilerType::kAotCompiler, &profile);
+  EXPECT_EQ(Strategy::kRegisterAllocatorGraphColor,
+            get_strategy(hot_method, CompilationKind::kOptimized));
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            get_strategy(cold_method, CompilationKind::kOptimized));
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            get_strategy(hot_method, CompilationKind::kBaseline));
+  SetStrategyOptions(
+      Strategy::kRegisterAllocatorGraphColorForHotMethods, CompilerType::kAotCompiler, nullptr);
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            get_strategy(hot_method, CompilationKind::kOptimized));
+
+  // The JIT uses graph coloring for optimized and OSR compilations, but not for baseline ones.
+  SetStrategyOptions(
+      Strategy::kRegisterAllocatorGraphColorForHotMethods, CompilerType::kJitCompiler, nullptr);
+  EXPECT_EQ(Strategy::kRegisterAllocatorGraphColor,
+            get_strategy(cold_method, CompilationKind::kOptimized));
+  EXPECT_EQ(Strategy::kRegisterAllocatorGraphColor,
+            get_strategy(cold_method, CompilationKind::kOsr));
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            get_strategy(cold_method, CompilationKind::kBaseline));
+}
+
+TEST_F(RegisterAllocatorTest, GraphColorCompileTimeBudget) {
+  HInstruction* div;
+  HGraph* small_graph = BuildDiv(&div);
+  EXPECT_EQ(Strategy::kRegisterAllocatorGraphColor,
+            ApplyCompileTimeBudget(Strategy::kRegisterAllocatorGraphColor, small_graph));
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            ApplyCompileTimeBudget(Strategy::kRegisterAllocatorLinearScan, small_graph));
+
+  // Constants are SSA values, add enough of them to exceed the budget of 5000 SSA values.
+  HGraph* large_graph = BuildDiv(&div);
+  for (int32_t i = 0; i != 5000; ++i) {
+    large_graph->GetIntConstant(i);
+  }
+  EXPECT_EQ(Strategy::kRegisterAllocatorLinearScan,
+            ApplyCompileTimeBudget(Strategy::kRegisterAllocatorGraphColor, large_graph));
+}
+
+TEST_F(RegisterAllocatorTest, ParseRegisterAllocationStrategy) {
+  static const std::pair<const char*, Strategy> kStrategies[] = {
+      {"linear-scan", Strategy::kRegisterAllocatorLinearScan},
+      {"graph-color", Strategy::kRegisterAllocatorGraphColor},
+      {"graph-color-hot", Strategy::kRegisterAllocatorGraphColorForHotMethods},
+  };
+  for (const auto& [name, strategy] : kStrategies) {
+    CompilerOptions options;
+    std::string error_msg;
+    ASSERT_TRUE(options.ParseCompilerOptions(
+        {std::string("--register-allocation-strategy=") + name},
+        /*ignore_unrecognized=*/ false,
+        &error_msg)) << error_msg;
+    EXPECT_EQ(strategy, options.GetRegisterAllocationStrategy()) << name;
+  }
+
+  CompilerOptions options;
+  std::string error_msg;
+  EXPECT_FALSE(options.ParseCompilerOptions({"--register-allocation-strategy=bogus"},
+                                            /*ignore_unrecognized=*/ false,
+                                            &error_msg));
+}
+
 }  // namespace art
@@ -35,6 +35,10 @@
 #include "scheduler_arm.h"
 #endif
 
+#ifdef ART_ENABLE_CODEGEN_x86_64
+#include "scheduler_x86_64.h"
+#endif
+
 namespace art HIDDEN {
 
 // Return all combinations of ISA and code generator that are executable on
@@ -420,6 +424,64 @@ TEST_F(SchedulerTest, ArrayAccessAliasingARM) {
 }
 #endif
 
+#if defined(ART_ENABLE_CODEGEN_x86_64)
+TEST_F(SchedulerTest, DependencyGraphAndSchedulerX86_64) {
+  CriticalPathSchedulingNodeSelector critical_path_selector;
+  x86_64::HSchedulerX86_64 scheduler(&critical_path_selector);
+  TestBuildDependencyGraphAndSchedule(&scheduler);
+}
+
+TEST_F(SchedulerTest, ArrayAccessAliasingX86_64) {
+  CriticalPathSchedulingNodeSelector critical_path_selector;
+  x86_64::HSchedulerX86_64 scheduler(&critical_path_selector);
+  TestDependencyGraphOnAliasingArrayAccesses(&scheduler);
+}
+
+// An `HArrayLength` emitted at its use site by `X86MemoryOperandGeneration` must stay
+// right before the `HBoundsCheck` that reads the length from memory.
+TEST_F(SchedulerTest, MemoryOperandPairX86_64) {
+  HBasicBlock* entry = new (GetAllocator()) HBasicBlock(graph_);
+  graph_->AddBlock(entry);
+  graph_->SetEntryBlock(entry);
+  graph_->BuildDominatorTree();
+
+  HInstruction* arr = new (GetAllocator()) HParameterValue(graph_->GetDexFile(),
+                                                           dex::TypeIndex(0),
+                                                           0,
+                                                           DataType::Type::kReference);
+  HInstruction* i = new (GetAllocator()) HParameterValue(graph_->GetDexFile(),
+                                                         dex::TypeIndex(1),
+                                                         1,
+                                                         DataType::Type::kInt32);
+  HInstruction* length = new (GetAllocator()) HArrayLength(arr, 0);
+  HInstruction* bounds_check = new (GetAllocator()) HBoundsCheck(i, length, 0);
+  HInstruction* arr_get =
+      new (GetAllocator()) HArrayGet(arr, bounds_check, DataType::Type::kInt32, 0);
+  HInstruction* mul = new (GetAllocator()) HMul(DataType::Type::kInt32, i, i);
+  HInstruction* add = new (GetAllocator()) HAdd(DataType::Type::kInt32, arr_get, mul);
+
+  HInstruction* instructions[] = {arr, i, length, bounds_check, arr_get, mul, add};
+  for (HInstruction* instr : instructions) {
+    entry->AddInstruction(instr);
+  }
+
+  CriticalPathSchedulingNodeSelector critical_path_selector;
+  x86_64::HSchedulerX86_64 scheduler(&critical_path_selector);
+  ASSERT_FALSE(scheduler.IsSchedulingBarrier(length));
+  ASSERT_FALSE(scheduler.IsSchedulingBarrier(bounds_check));
+
+  length->MarkEmittedAtUseSite();
+  ASSERT_TRUE(scheduler.IsSchedulingBarrier(length));
+  ASSERT_TRUE(scheduler.IsSchedulingBarrier(bounds_check));
+  ASSERT_FALSE(scheduler.IsSchedulingBarrier(arr_get));
+
+  scheduler.SetOnlyOptimizeLoopBlocks(false);
+  scheduler.Schedule(graph_);
+  ASSERT_EQ(length->GetNext(), bounds_check);
+  ASSERT_EQ(entry->GetLastInstruction(), add);
+}
+#endif
+
 TEST_F(SchedulerTest, RandomScheduling) {
   //
   // Java source: crafted code to make sure (random) scheduling should get correct result.
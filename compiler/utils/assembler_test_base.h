@@ -145,6 +145,15 @@ class AssemblerTestBase : public testing::Test {
         return {FindTool("clang"), "--compile", "-target", "i386-linux-gnu"};
       case InstructionSet::kX86_64:
         return {FindTool("clang"), "--compile", "-target", "x86_64-linux-gnu"};
+      case InstructionSet::kRiscv64:
+        // Disable linker relaxation so that branches to local labels are resolved
+        // by the assembler, like the branches emitted by our assembler.
+        return {FindTool("clang"),
+                "--compile",
+                "-target",
+                "riscv64-linux-gnu",
+                "-march=rv64imafd_zba_zbb",
+                "-mno-relax"};
       default:
         LOG(FATAL) << "Unknown instruction set: " << isa;
         UNREACHABLE();
@@ -159,6 +168,12 @@ class AssemblerTestBase : public testing::Test {
                 "--no-print-imm-hex",
                 "--triple",
                 "thumbv7a-linux-gnueabi"};
+      case InstructionSet::kRiscv64:
+        return {FindTool("llvm-objdump"),
+                "--disassemble",
+                "--no-print-imm-hex",
+                "--no-show-raw-insn",
+                "--mattr=+f,+d,+a,+zba,+zbb"};
       default:
         return {
             FindTool("llvm-objdump"), "--disassemble", "--no-print-imm-hex", "--no-show-raw-insn"};
@@ -0,0 +1,1278 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "assembler_riscv64.h"
+
+#include "base/casts.h"
+#include "base/stl_util.h"
+#include "utils/assembler_test.h"
+
+#define __ GetAssembler()->
+
+namespace art HIDDEN {
+namespace riscv64 {
+
+class AssemblerRISCV64Test : public AssemblerTest<Riscv64Assembler,
+                                                  uint32_t,  // Unused address type.
+                                                  XRegister,
+                                                  FRegister,
+                                                  int64_t> {
+ public:
+  using Base = AssemblerTest<Riscv64Assembler, uint32_t, XRegister, FRegister, int64_t>;
+
+ protected:
+  InstructionSet GetIsa() override { return InstructionSet::kRiscv64; }
+
+  void SetUpHelpers() override {
+    if (registers_.size() == 0) {
+      for (uint32_t i = 0; i != enum_cast<uint32_t>(kNumberOfXRegisters); ++i) {
+        registers_.push_back(new XRegister(enum_cast<XRegister>(i)));
+      }
+      for (uint32_t i = 0; i != enum_cast<uint32_t>(kNumberOfFRegisters); ++i) {
+        fp_registers_.push_back(new FRegister(enum_cast<FRegister>(i)));
+      }
+    }
+  }
+
+  void TearDown() override {
+    AssemblerTest::TearDown();
+    STLDeleteElements(&registers_);
+    STLDeleteElements(&fp_registers_);
+  }
+
+  std::vector<uint32_t> GetAddresses() override {
+    UNIMPLEMENTED(FATAL) << "Addresses are not used for RISC-V 64";
+    UNREACHABLE();
+  }
+
+  std::vector<XRegister*> GetRegisters() override { return registers_; }
+
+  std::vector<FRegister*> GetFPRegisters() override { return fp_registers_; }
+
+  int64_t CreateImmediate(int64_t imm_value) override { return imm_value; }
+
+  // A small set of registers for instructions with many operands, to keep the number
+  // of combinations (and the size of the generated assembly) reasonable.
+  std::vector<XRegister> GetSomeRegisters() { return {Zero, RA, SP, A0, S11, T6}; }
+  std::vector<FRegister> GetSomeFPRegisters() { return {FT0, FS1, FA0, FT11}; }
+
+  std::string RepeatRFF(void (Riscv64Assembler::*f)(XRegister, FRegister, FRegister),
+                        const std::string& fmt) {
+    return RepeatTemplatedRegisters<XRegister, FRegister, FRegister>(
+        f,
+        GetRegisters(),
+        GetFPRegisters(),
+        GetFPRegisters(),
+        &AssemblerRISCV64Test::GetRegName<RegisterView::kUsePrimaryName>,
+        &AssemblerRISCV64Test::GetFPRegName,
+        &AssemblerRISCV64Test::GetFPRegName,
+        fmt);
+  }
+
+  std::string RepeatFFFF(void (Riscv64Assembler::*f)(FRegister, FRegister, FRegister, FRegister),
+                         const std::string& fmt) {
+    std::string str;
+    for (FRegister reg1 : GetSomeFPRegisters()) {
+      for (FRegister reg2 : GetSomeFPRegisters()) {
+        for (FRegister reg3 : GetSomeFPRegisters()) {
+          for (FRegister reg4 : GetSomeFPRegisters()) {
+            (GetAssembler()->*f)(reg1, reg2, reg3, reg4);
+            str += ReplaceRegisters(fmt, {GetFPRegName(reg1),
+                                          GetFPRegName(reg2),
+                                          GetFPRegName(reg3),
+                                          GetFPRegName(reg4)});
+          }
+        }
+      }
+    }
+    return str;
+  }
+
+  // Atomic instructions are printed as "<op>{aqrl} rd, rs2, (rs1)" with the suffix empty,
+  // ".aq", ".rl" or ".aqrl".
+  std::string RepeatRRRAqRl(void (Riscv64Assembler::*f)(XRegister, XRegister, XRegister, AqRl),
+                            const std::string& fmt) {
+    std::string str;
+    for (XRegister rd : GetSomeRegisters()) {
+      for (XRegister rs2 : GetSomeRegisters()) {
+        for (XRegister rs1 : GetSomeRegisters()) {
+          for (AqRl aqrl : {AqRl::kNone, AqRl::kRelease, AqRl::kAcquire, AqRl::kAqRl}) {
+            (GetAssembler()->*f)(rd, rs2, rs1, aqrl);
+            str += ReplaceRegisters(ReplaceAqRl(fmt, aqrl),
+                                    {GetRegName<RegisterView::kUsePrimaryName>(rd),
+                                     GetRegName<RegisterView::kUsePrimaryName>(rs2),
+                                     GetRegName<RegisterView::kUsePrimaryName>(rs1)});
+          }
+        }
+      }
+    }
+    return str;
+  }
+
+  std::string RepeatRRAqRl(void (Riscv64Assembler::*f)(XRegister, XRegister, AqRl),
+                           const std::string& fmt) {
+    std::string str;
+    for (XRegister rd : GetSomeRegisters()) {
+      for (XRegister rs1 : GetSomeRegisters()) {
+        // LR with only the release bit set is reserved by the ISA.
+        for (AqRl aqrl : {AqRl::kNone, AqRl::kAcquire, AqRl::kAqRl}) {
+          (GetAssembler()->*f)(rd, rs1, aqrl);
+          str += ReplaceRegisters(ReplaceAqRl(fmt, aqrl),
+                                  {GetRegName<RegisterView::kUsePrimaryName>(rd),
+                                   GetRegName<RegisterView::kUsePrimaryName>(rs1)});
+        }
+      }
+    }
+    return str;
+  }
+
+  // Splits a PC-relative `offset` into the AUIPC immediate and the 12-bit offset
+  // of the following instruction.
+  static std::pair<uint32_t, int32_t> SplitOffset(int32_t offset) {
+    uint32_t imm20 = (static_cast<uint32_t>(offset) + 0x800u) >> 12;
+    int32_t imm12 = offset - static_cast<int32_t>(imm20 << 12);
+    return {imm20, imm12};
+  }
+
+  static std::string RepeatInsn(size_t count, const std::string& insn) {
+    std::string result;
+    for (; count != 0u; --count) {
+      result += insn;
+    }
+    return result;
+  }
+
+ private:
+  static std::string ReplaceAqRl(const std::string& fmt, AqRl aqrl) {
+    static constexpr const char* kAqRlSuffixes[] = {"", ".rl", ".aq", ".aqrl"};
+    std::string result = fmt;
+    size_t index = result.find(kAqRlToken);
+    CHECK_NE(index, std::string::npos);
+    result.replace(index, ConstexprStrLen(kAqRlToken), kAqRlSuffixes[enum_cast<uint32_t>(aqrl)]);
+    return result;
+  }
+
+  static std::string ReplaceRegisters(const std::string& fmt,
+                                      const std::vector<std::string>& names) {
+    static constexpr const char* kTokens[] = {REG1_TOKEN, REG2_TOKEN, REG3_TOKEN, "{reg4}"};
+    std::string result = fmt;
+    for (size_t i = 0; i != names.size(); ++i) {
+      size_t index;
+      while ((index = result.find(kTokens[i])) != std::string::npos) {
+        result.replace(index, strlen(kTokens[i]), names[i]);
+      }
+    }
+    return result + "\n";
+  }
+
+  static constexpr const char* kAqRlToken = "{aqrl}";
+
+  std::vector<XRegister*> registers_;
+  std::vector<FRegister*> fp_registers_;
+};
+
+TEST_F(AssemblerRISCV64Test, Toolchain) {
+  EXPECT_TRUE(CheckTools());
+}
+
+TEST_F(AssemblerRISCV64Test, Lui) {
+  DriverStr(RepeatRIb(&Riscv64Assembler::Lui, 20, "lui {reg}, {imm}"), "Lui");
+}
+
+TEST_F(AssemblerRISCV64Test, Auipc) {
+  DriverStr(RepeatRIb(&Riscv64Assembler::Auipc, 20, "auipc {reg}, {imm}"), "Auipc");
+}
+
+TEST_F(AssemblerRISCV64Test, Jalr) {
+  auto jalr = static_cast<void (Riscv64Assembler::*)(XRegister, XRegister, int32_t)>(
+      &Riscv64Assembler::Jalr);
+  DriverStr(RepeatRRIb(jalr, -12, "jalr {reg1}, {imm}({reg2})"), "Jalr");
+}
+
+TEST_F(AssemblerRISCV64Test, BranchesWithOffsets) {
+  std::string expected;
+  for (int32_t offset : {-4096, -2048, -4, 0, 2, 8, 2046, 4094}) {
+    __ Beq(A0, A1, offset);
+    __ Bne(A2, S1, offset);
+    __ Blt(T0, Zero, offset);
+    __ Bge(Zero, T6, offset);
+    __ Bltu(RA, SP, offset);
+    __ Bgeu(S11, A7, offset);
+    __ Jal(RA, offset);
+    __ Jal(Zero, offset);
+    std::string ofs = std::to_string(offset);
+    expected += "beq a0, a1, " + ofs + "\n" +
+                "bne a2, s1, " + ofs + "\n" +
+                "blt t0, zero, " + ofs + "\n" +
+                "bge zero, t6, " + ofs + "\n" +
+                "bltu ra, sp, " + ofs + "\n" +
+                "bgeu s11, a7, " + ofs + "\n" +
+                "jal ra, " + ofs + "\n" +
+                "jal zero, " + ofs + "\n";
+  }
+  for (int32_t offset : {-0x100000, -0x800, 0x7fe, 0xffffe}) {
+    __ Jal(A0, offset);
+    expected += "jal a0, " + std::to_string(offset) + "\n";
+  }
+  DriverStr(expected, "BranchesWithOffsets");
+}
+
+TEST_F(AssemblerRISCV64Test, Lb) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Lb, -12, "lb {reg1}, {imm}({reg2})"), "Lb");
+}
+
+TEST_F(AssemblerRISCV64Test, Lh) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Lh, -12, "lh {reg1}, {imm}({reg2})"), "Lh");
+}
+
+TEST_F(AssemblerRISCV64Test, Lw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Lw, -12, "lw {reg1}, {imm}({reg2})"), "Lw");
+}
+
+TEST_F(AssemblerRISCV64Test, Ld) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Ld, -12, "ld {reg1}, {imm}({reg2})"), "Ld");
+}
+
+TEST_F(AssemblerRISCV64Test, Lbu) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Lbu, -12, "lbu {reg1}, {imm}({reg2})"), "Lbu");
+}
+
+TEST_F(AssemblerRISCV64Test, Lhu) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Lhu, -12, "lhu {reg1}, {imm}({reg2})"), "Lhu");
+}
+
+TEST_F(AssemblerRISCV64Test, Lwu) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Lwu, -12, "lwu {reg1}, {imm}({reg2})"), "Lwu");
+}
+
+TEST_F(AssemblerRISCV64Test, Sb) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Sb, -12, "sb {reg1}, {imm}({reg2})"), "Sb");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Sh, -12, "sh {reg1}, {imm}({reg2})"), "Sh");
+}
+
+TEST_F(AssemblerRISCV64Test, Sw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Sw, -12, "sw {reg1}, {imm}({reg2})"), "Sw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sd) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Sd, -12, "sd {reg1}, {imm}({reg2})"), "Sd");
+}
+
+TEST_F(AssemblerRISCV64Test, Addi) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Addi, -12, "addi {reg1}, {reg2}, {imm}"), "Addi");
+}
+
+TEST_F(AssemblerRISCV64Test, Slti) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Slti, -12, "slti {reg1}, {reg2}, {imm}"), "Slti");
+}
+
+TEST_F(AssemblerRISCV64Test, Sltiu) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Sltiu, -12, "sltiu {reg1}, {reg2}, {imm}"), "Sltiu");
+}
+
+TEST_F(AssemblerRISCV64Test, Xori) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Xori, -12, "xori {reg1}, {reg2}, {imm}"), "Xori");
+}
+
+TEST_F(AssemblerRISCV64Test, Ori) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Ori, -12, "ori {reg1}, {reg2}, {imm}"), "Ori");
+}
+
+TEST_F(AssemblerRISCV64Test, Andi) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Andi, -12, "andi {reg1}, {reg2}, {imm}"), "Andi");
+}
+
+TEST_F(AssemblerRISCV64Test, Slli) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Slli, 6, "slli {reg1}, {reg2}, {imm}"), "Slli");
+}
+
+TEST_F(AssemblerRISCV64Test, Srli) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Srli, 6, "srli {reg1}, {reg2}, {imm}"), "Srli");
+}
+
+TEST_F(AssemblerRISCV64Test, Srai) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Srai, 6, "srai {reg1}, {reg2}, {imm}"), "Srai");
+}
+
+TEST_F(AssemblerRISCV64Test, Add) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Add, "add {reg1}, {reg2}, {reg3}"), "Add");
+}
+
+TEST_F(AssemblerRISCV64Test, Sub) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sub, "sub {reg1}, {reg2}, {reg3}"), "Sub");
+}
+
+TEST_F(AssemblerRISCV64Test, Slt) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Slt, "slt {reg1}, {reg2}, {reg3}"), "Slt");
+}
+
+TEST_F(AssemblerRISCV64Test, Sltu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sltu, "sltu {reg1}, {reg2}, {reg3}"), "Sltu");
+}
+
+TEST_F(AssemblerRISCV64Test, Xor) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Xor, "xor {reg1}, {reg2}, {reg3}"), "Xor");
+}
+
+TEST_F(AssemblerRISCV64Test, Or) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Or, "or {reg1}, {reg2}, {reg3}"), "Or");
+}
+
+TEST_F(AssemblerRISCV64Test, And) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::And, "and {reg1}, {reg2}, {reg3}"), "And");
+}
+
+TEST_F(AssemblerRISCV64Test, Sll) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sll, "sll {reg1}, {reg2}, {reg3}"), "Sll");
+}
+
+TEST_F(AssemblerRISCV64Test, Srl) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Srl, "srl {reg1}, {reg2}, {reg3}"), "Srl");
+}
+
+TEST_F(AssemblerRISCV64Test, Sra) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sra, "sra {reg1}, {reg2}, {reg3}"), "Sra");
+}
+
+TEST_F(AssemblerRISCV64Test, Addiw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Addiw, -12, "addiw {reg1}, {reg2}, {imm}"), "Addiw");
+}
+
+TEST_F(AssemblerRISCV64Test, Slliw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Slliw, 5, "slliw {reg1}, {reg2}, {imm}"), "Slliw");
+}
+
+TEST_F(AssemblerRISCV64Test, Srliw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Srliw, 5, "srliw {reg1}, {reg2}, {imm}"), "Srliw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sraiw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Sraiw, 5, "sraiw {reg1}, {reg2}, {imm}"), "Sraiw");
+}
+
+TEST_F(AssemblerRISCV64Test, Addw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Addw, "addw {reg1}, {reg2}, {reg3}"), "Addw");
+}
+
+TEST_F(AssemblerRISCV64Test, Subw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Subw, "subw {reg1}, {reg2}, {reg3}"), "Subw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sllw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sllw, "sllw {reg1}, {reg2}, {reg3}"), "Sllw");
+}
+
+TEST_F(AssemblerRISCV64Test, Srlw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Srlw, "srlw {reg1}, {reg2}, {reg3}"), "Srlw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sraw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sraw, "sraw {reg1}, {reg2}, {reg3}"), "Sraw");
+}
+
+TEST_F(AssemblerRISCV64Test, SystemAndFences) {
+  __ Ecall();
+  __ Ebreak();
+  __ Fence();
+  __ Fence(kFenceRead | kFenceWrite, kFenceWrite);
+  __ Fence(kFenceInput | kFenceOutput, kFenceRead);
+  __ FenceTso();
+  __ FenceI();
+  DriverStr("ecall\n"
+            "ebreak\n"
+            "fence iorw, iorw\n"
+            "fence rw, w\n"
+            "fence io, r\n"
+            "fence.tso\n"
+            "fence.i\n",
+            "SystemAndFences");
+}
+
+TEST_F(AssemblerRISCV64Test, Mul) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Mul, "mul {reg1}, {reg2}, {reg3}"), "Mul");
+}
+
+TEST_F(AssemblerRISCV64Test, Mulh) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Mulh, "mulh {reg1}, {reg2}, {reg3}"), "Mulh");
+}
+
+TEST_F(AssemblerRISCV64Test, Mulhsu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Mulhsu, "mulhsu {reg1}, {reg2}, {reg3}"), "Mulhsu");
+}
+
+TEST_F(AssemblerRISCV64Test, Mulhu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Mulhu, "mulhu {reg1}, {reg2}, {reg3}"), "Mulhu");
+}
+
+TEST_F(AssemblerRISCV64Test, Div) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Div, "div {reg1}, {reg2}, {reg3}"), "Div");
+}
+
+TEST_F(AssemblerRISCV64Test, Divu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Divu, "divu {reg1}, {reg2}, {reg3}"), "Divu");
+}
+
+TEST_F(AssemblerRISCV64Test, Rem) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Rem, "rem {reg1}, {reg2}, {reg3}"), "Rem");
+}
+
+TEST_F(AssemblerRISCV64Test, Remu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Remu, "remu {reg1}, {reg2}, {reg3}"), "Remu");
+}
+
+TEST_F(AssemblerRISCV64Test, Mulw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Mulw, "mulw {reg1}, {reg2}, {reg3}"), "Mulw");
+}
+
+TEST_F(AssemblerRISCV64Test, Divw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Divw, "divw {reg1}, {reg2}, {reg3}"), "Divw");
+}
+
+TEST_F(AssemblerRISCV64Test, Divuw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Divuw, "divuw {reg1}, {reg2}, {reg3}"), "Divuw");
+}
+
+TEST_F(AssemblerRISCV64Test, Remw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Remw, "remw {reg1}, {reg2}, {reg3}"), "Remw");
+}
+
+TEST_F(AssemblerRISCV64Test, Remuw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Remuw, "remuw {reg1}, {reg2}, {reg3}"), "Remuw");
+}
+
+TEST_F(AssemblerRISCV64Test, LrW) {
+  DriverStr(RepeatRRAqRl(&Riscv64Assembler::LrW, "lr.w{aqrl} {reg1}, ({reg2})"), "LrW");
+}
+
+TEST_F(AssemblerRISCV64Test, LrD) {
+  DriverStr(RepeatRRAqRl(&Riscv64Assembler::LrD, "lr.d{aqrl} {reg1}, ({reg2})"), "LrD");
+}
+
+TEST_F(AssemblerRISCV64Test, ScW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::ScW, "sc.w{aqrl} {reg1}, {reg2}, ({reg3})"), "ScW");
+}
+
+TEST_F(AssemblerRISCV64Test, ScD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::ScD, "sc.d{aqrl} {reg1}, {reg2}, ({reg3})"), "ScD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoSwapW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoSwapW, "amoswap.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoSwapW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoSwapD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoSwapD, "amoswap.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoSwapD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoAddW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoAddW, "amoadd.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoAddW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoAddD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoAddD, "amoadd.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoAddD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoXorW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoXorW, "amoxor.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoXorW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoXorD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoXorD, "amoxor.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoXorD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoAndW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoAndW, "amoand.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoAndW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoAndD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoAndD, "amoand.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoAndD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoOrW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoOrW, "amoor.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoOrW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoOrD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoOrD, "amoor.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoOrD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMinW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoMinW, "amomin.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoMinW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMinD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoMinD, "amomin.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoMinD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMaxW) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoMaxW, "amomax.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoMaxW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMaxD) {
+  DriverStr(RepeatRRRAqRl(&Riscv64Assembler::AmoMaxD, "amomax.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+            "AmoMaxD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMinuW) {
+  DriverStr(
+      RepeatRRRAqRl(&Riscv64Assembler::AmoMinuW, "amominu.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+      "AmoMinuW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMinuD) {
+  DriverStr(
+      RepeatRRRAqRl(&Riscv64Assembler::AmoMinuD, "amominu.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+      "AmoMinuD");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMaxuW) {
+  DriverStr(
+      RepeatRRRAqRl(&Riscv64Assembler::AmoMaxuW, "amomaxu.w{aqrl} {reg1}, {reg2}, ({reg3})"),
+      "AmoMaxuW");
+}
+
+TEST_F(AssemblerRISCV64Test, AmoMaxuD) {
+  DriverStr(
+      RepeatRRRAqRl(&Riscv64Assembler::AmoMaxuD, "amomaxu.d{aqrl} {reg1}, {reg2}, ({reg3})"),
+      "AmoMaxuD");
+}
+
+TEST_F(AssemblerRISCV64Test, Csr) {
+  // fflags = 0x1, frm = 0x2, fcsr = 0x3, cycle = 0xc00, time = 0xc01, instret = 0xc02.
+  __ Csrrw(A0, 0x1, A1);
+  __ Csrrs(Zero, 0x2, T6);
+  __ Csrrc(S11, 0x3, Zero);
+  __ Csrrs(A0, 0xc00, Zero);
+  __ Csrrs(A0, 0xc01, Zero);
+  __ Csrrs(A0, 0xc02, Zero);
+  __ Csrrwi(T0, 0x3, 0);
+  __ Csrrsi(T1, 0x2, 31);
+  __ Csrrci(Zero, 0x1, 17);
+  DriverStr("csrrw a0, fflags, a1\n"
+            "csrrs zero, frm, t6\n"
+            "csrrc s11, fcsr, zero\n"
+            "csrrs a0, cycle, zero\n"
+            "csrrs a0, time, zero\n"
+            "csrrs a0, instret, zero\n"
+            "csrrwi t0, fcsr, 0\n"
+            "csrrsi t1, frm, 31\n"
+            "csrrci zero, fflags, 17\n",
+            "Csr");
+}
+
+TEST_F(AssemblerRISCV64Test, FLw) {
+  DriverStr(RepeatFRIb(&Riscv64Assembler::FLw, -12, "flw {reg1}, {imm}({reg2})"), "FLw");
+}
+
+TEST_F(AssemblerRISCV64Test, FLd) {
+  DriverStr(RepeatFRIb(&Riscv64Assembler::FLd, -12, "fld {reg1}, {imm}({reg2})"), "FLd");
+}
+
+TEST_F(AssemblerRISCV64Test, FSw) {
+  DriverStr(RepeatFRIb(&Riscv64Assembler::FSw, -12, "fsw {reg1}, {imm}({reg2})"), "FSw");
+}
+
+TEST_F(AssemblerRISCV64Test, FSd) {
+  DriverStr(RepeatFRIb(&Riscv64Assembler::FSd, -12, "fsd {reg1}, {imm}({reg2})"), "FSd");
+}
+
+TEST_F(AssemblerRISCV64Test, FMAddS) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FMAddS, "fmadd.s {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FMAddS");
+}
+
+TEST_F(AssemblerRISCV64Test, FMAddD) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FMAddD, "fmadd.d {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FMAddD");
+}
+
+TEST_F(AssemblerRISCV64Test, FMSubS) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FMSubS, "fmsub.s {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FMSubS");
+}
+
+TEST_F(AssemblerRISCV64Test, FMSubD) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FMSubD, "fmsub.d {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FMSubD");
+}
+
+TEST_F(AssemblerRISCV64Test, FNMSubS) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FNMSubS, "fnmsub.s {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FNMSubS");
+}
+
+TEST_F(AssemblerRISCV64Test, FNMSubD) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FNMSubD, "fnmsub.d {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FNMSubD");
+}
+
+TEST_F(AssemblerRISCV64Test, FNMAddS) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FNMAddS, "fnmadd.s {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FNMAddS");
+}
+
+TEST_F(AssemblerRISCV64Test, FNMAddD) {
+  DriverStr(RepeatFFFF(&Riscv64Assembler::FNMAddD, "fnmadd.d {reg1}, {reg2}, {reg3}, {reg4}"),
+            "FNMAddD");
+}
+
+TEST_F(AssemblerRISCV64Test, FAddS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FAddS, "fadd.s {reg1}, {reg2}, {reg3}"), "FAddS");
+}
+
+TEST_F(AssemblerRISCV64Test, FAddD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FAddD, "fadd.d {reg1}, {reg2}, {reg3}"), "FAddD");
+}
+
+TEST_F(AssemblerRISCV64Test, FSubS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSubS, "fsub.s {reg1}, {reg2}, {reg3}"), "FSubS");
+}
+
+TEST_F(AssemblerRISCV64Test, FSubD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSubD, "fsub.d {reg1}, {reg2}, {reg3}"), "FSubD");
+}
+
+TEST_F(AssemblerRISCV64Test, FMulS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FMulS, "fmul.s {reg1}, {reg2}, {reg3}"), "FMulS");
+}
+
+TEST_F(AssemblerRISCV64Test, FMulD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FMulD, "fmul.d {reg1}, {reg2}, {reg3}"), "FMulD");
+}
+
+TEST_F(AssemblerRISCV64Test, FDivS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FDivS, "fdiv.s {reg1}, {reg2}, {reg3}"), "FDivS");
+}
+
+TEST_F(AssemblerRISCV64Test, FDivD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FDivD, "fdiv.d {reg1}, {reg2}, {reg3}"), "FDivD");
+}
+
+TEST_F(AssemblerRISCV64Test, FSqrtS) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FSqrtS, "fsqrt.s {reg1}, {reg2}"), "FSqrtS");
+}
+
+TEST_F(AssemblerRISCV64Test, FSqrtD) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FSqrtD, "fsqrt.d {reg1}, {reg2}"), "FSqrtD");
+}
+
+TEST_F(AssemblerRISCV64Test, FPRoundingModes) {
+  __ FAddS(FA0, FA1, FA2, FPRoundingMode::kRNE);
+  __ FSubD(FT0, FS0, FT11, FPRoundingMode::kRTZ);
+  __ FMulS(FS11, FS10, FS9, FPRoundingMode::kRDN);
+  __ FDivD(FA7, FA6, FA5, FPRoundingMode::kRUP);
+  __ FSqrtS(FT1, FT2, FPRoundingMode::kRMM);
+  __ FMAddD(FA0, FA1, FA2, FA3, FPRoundingMode::kRTZ);
+  __ FCvtWS(A0, FA0, FPRoundingMode::kRTZ);
+  __ FCvtLD(A1, FA1, FPRoundingMode::kRTZ);
+  __ FCvtSL(FA2, A2, FPRoundingMode::kRNE);
+  __ FCvtSD(FA3, FA4, FPRoundingMode::kRMM);
+  DriverStr("fadd.s fa0, fa1, fa2, rne\n"
+            "fsub.d ft0, fs0, ft11, rtz\n"
+            "fmul.s fs11, fs10, fs9, rdn\n"
+            "fdiv.d fa7, fa6, fa5, rup\n"
+            "fsqrt.s ft1, ft2, rmm\n"
+            "fmadd.d fa0, fa1, fa2, fa3, rtz\n"
+            "fcvt.w.s a0, fa0, rtz\n"
+            "fcvt.l.d a1, fa1, rtz\n"
+            "fcvt.s.l fa2, a2, rne\n"
+            "fcvt.s.d fa3, fa4, rmm\n",
+            "FPRoundingModes");
+}
+
+TEST_F(AssemblerRISCV64Test, FSgnjS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSgnjS, "fsgnj.s {reg1}, {reg2}, {reg3}"), "FSgnjS");
+}
+
+TEST_F(AssemblerRISCV64Test, FSgnjD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSgnjD, "fsgnj.d {reg1}, {reg2}, {reg3}"), "FSgnjD");
+}
+
+TEST_F(AssemblerRISCV64Test, FSgnjnS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSgnjnS, "fsgnjn.s {reg1}, {reg2}, {reg3}"), "FSgnjnS");
+}
+
+TEST_F(AssemblerRISCV64Test, FSgnjnD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSgnjnD, "fsgnjn.d {reg1}, {reg2}, {reg3}"), "FSgnjnD");
+}
+
+TEST_F(AssemblerRISCV64Test, FSgnjxS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSgnjxS, "fsgnjx.s {reg1}, {reg2}, {reg3}"), "FSgnjxS");
+}
+
+TEST_F(AssemblerRISCV64Test, FSgnjxD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FSgnjxD, "fsgnjx.d {reg1}, {reg2}, {reg3}"), "FSgnjxD");
+}
+
+TEST_F(AssemblerRISCV64Test, FMinS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FMinS, "fmin.s {reg1}, {reg2}, {reg3}"), "FMinS");
+}
+
+TEST_F(AssemblerRISCV64Test, FMinD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FMinD, "fmin.d {reg1}, {reg2}, {reg3}"), "FMinD");
+}
+
+TEST_F(AssemblerRISCV64Test, FMaxS) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FMaxS, "fmax.s {reg1}, {reg2}, {reg3}"), "FMaxS");
+}
+
+TEST_F(AssemblerRISCV64Test, FMaxD) {
+  DriverStr(RepeatFFF(&Riscv64Assembler::FMaxD, "fmax.d {reg1}, {reg2}, {reg3}"), "FMaxD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtSD) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FCvtSD, "fcvt.s.d {reg1}, {reg2}"), "FCvtSD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtDS) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FCvtDS, "fcvt.d.s {reg1}, {reg2}"), "FCvtDS");
+}
+
+TEST_F(AssemblerRISCV64Test, FEqS) {
+  DriverStr(RepeatRFF(&Riscv64Assembler::FEqS, "feq.s {reg1}, {reg2}, {reg3}"), "FEqS");
+}
+
+TEST_F(AssemblerRISCV64Test, FEqD) {
+  DriverStr(RepeatRFF(&Riscv64Assembler::FEqD, "feq.d {reg1}, {reg2}, {reg3}"), "FEqD");
+}
+
+TEST_F(AssemblerRISCV64Test, FLtS) {
+  DriverStr(RepeatRFF(&Riscv64Assembler::FLtS, "flt.s {reg1}, {reg2}, {reg3}"), "FLtS");
+}
+
+TEST_F(AssemblerRISCV64Test, FLtD) {
+  DriverStr(RepeatRFF(&Riscv64Assembler::FLtD, "flt.d {reg1}, {reg2}, {reg3}"), "FLtD");
+}
+
+TEST_F(AssemblerRISCV64Test, FLeS) {
+  DriverStr(RepeatRFF(&Riscv64Assembler::FLeS, "fle.s {reg1}, {reg2}, {reg3}"), "FLeS");
+}
+
+TEST_F(AssemblerRISCV64Test, FLeD) {
+  DriverStr(RepeatRFF(&Riscv64Assembler::FLeD, "fle.d {reg1}, {reg2}, {reg3}"), "FLeD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtWS) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtWS, "fcvt.w.s {reg1}, {reg2}"), "FCvtWS");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtWD) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtWD, "fcvt.w.d {reg1}, {reg2}"), "FCvtWD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtWuS) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtWuS, "fcvt.wu.s {reg1}, {reg2}"), "FCvtWuS");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtWuD) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtWuD, "fcvt.wu.d {reg1}, {reg2}"), "FCvtWuD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtLS) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtLS, "fcvt.l.s {reg1}, {reg2}"), "FCvtLS");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtLD) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtLD, "fcvt.l.d {reg1}, {reg2}"), "FCvtLD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtLuS) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtLuS, "fcvt.lu.s {reg1}, {reg2}"), "FCvtLuS");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtLuD) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FCvtLuD, "fcvt.lu.d {reg1}, {reg2}"), "FCvtLuD");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtSW) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtSW, "fcvt.s.w {reg1}, {reg2}"), "FCvtSW");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtDW) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtDW, "fcvt.d.w {reg1}, {reg2}"), "FCvtDW");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtSWu) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtSWu, "fcvt.s.wu {reg1}, {reg2}"), "FCvtSWu");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtDWu) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtDWu, "fcvt.d.wu {reg1}, {reg2}"), "FCvtDWu");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtSL) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtSL, "fcvt.s.l {reg1}, {reg2}"), "FCvtSL");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtDL) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtDL, "fcvt.d.l {reg1}, {reg2}"), "FCvtDL");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtSLu) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtSLu, "fcvt.s.lu {reg1}, {reg2}"), "FCvtSLu");
+}
+
+TEST_F(AssemblerRISCV64Test, FCvtDLu) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FCvtDLu, "fcvt.d.lu {reg1}, {reg2}"), "FCvtDLu");
+}
+
+TEST_F(AssemblerRISCV64Test, FMvXW) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FMvXW, "fmv.x.w {reg1}, {reg2}"), "FMvXW");
+}
+
+TEST_F(AssemblerRISCV64Test, FMvXD) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FMvXD, "fmv.x.d {reg1}, {reg2}"), "FMvXD");
+}
+
+TEST_F(AssemblerRISCV64Test, FMvWX) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FMvWX, "fmv.w.x {reg1}, {reg2}"), "FMvWX");
+}
+
+TEST_F(AssemblerRISCV64Test, FMvDX) {
+  DriverStr(RepeatFR(&Riscv64Assembler::FMvDX, "fmv.d.x {reg1}, {reg2}"), "FMvDX");
+}
+
+TEST_F(AssemblerRISCV64Test, FClassS) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FClassS, "fclass.s {reg1}, {reg2}"), "FClassS");
+}
+
+TEST_F(AssemblerRISCV64Test, FClassD) {
+  DriverStr(RepeatRF(&Riscv64Assembler::FClassD, "fclass.d {reg1}, {reg2}"), "FClassD");
+}
+
+TEST_F(AssemblerRISCV64Test, AddUw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::AddUw, "add.uw {reg1}, {reg2}, {reg3}"), "AddUw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh1Add) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sh1Add, "sh1add {reg1}, {reg2}, {reg3}"), "Sh1Add");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh1AddUw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sh1AddUw, "sh1add.uw {reg1}, {reg2}, {reg3}"),
+            "Sh1AddUw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh2Add) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sh2Add, "sh2add {reg1}, {reg2}, {reg3}"), "Sh2Add");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh2AddUw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sh2AddUw, "sh2add.uw {reg1}, {reg2}, {reg3}"),
+            "Sh2AddUw");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh3Add) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sh3Add, "sh3add {reg1}, {reg2}, {reg3}"), "Sh3Add");
+}
+
+TEST_F(AssemblerRISCV64Test, Sh3AddUw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Sh3AddUw, "sh3add.uw {reg1}, {reg2}, {reg3}"),
+            "Sh3AddUw");
+}
+
+TEST_F(AssemblerRISCV64Test, SlliUw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::SlliUw, 6, "slli.uw {reg1}, {reg2}, {imm}"), "SlliUw");
+}
+
+TEST_F(AssemblerRISCV64Test, Andn) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Andn, "andn {reg1}, {reg2}, {reg3}"), "Andn");
+}
+
+TEST_F(AssemblerRISCV64Test, Orn) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Orn, "orn {reg1}, {reg2}, {reg3}"), "Orn");
+}
+
+TEST_F(AssemblerRISCV64Test, Xnor) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Xnor, "xnor {reg1}, {reg2}, {reg3}"), "Xnor");
+}
+
+TEST_F(AssemblerRISCV64Test, Clz) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Clz, "clz {reg1}, {reg2}"), "Clz");
+}
+
+TEST_F(AssemblerRISCV64Test, Clzw) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Clzw, "clzw {reg1}, {reg2}"), "Clzw");
+}
+
+TEST_F(AssemblerRISCV64Test, Ctz) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Ctz, "ctz {reg1}, {reg2}"), "Ctz");
+}
+
+TEST_F(AssemblerRISCV64Test, Ctzw) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Ctzw, "ctzw {reg1}, {reg2}"), "Ctzw");
+}
+
+TEST_F(AssemblerRISCV64Test, Cpop) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Cpop, "cpop {reg1}, {reg2}"), "Cpop");
+}
+
+TEST_F(AssemblerRISCV64Test, Cpopw) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Cpopw, "cpopw {reg1}, {reg2}"), "Cpopw");
+}
+
+TEST_F(AssemblerRISCV64Test, Min) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Min, "min {reg1}, {reg2}, {reg3}"), "Min");
+}
+
+TEST_F(AssemblerRISCV64Test, Minu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Minu, "minu {reg1}, {reg2}, {reg3}"), "Minu");
+}
+
+TEST_F(AssemblerRISCV64Test, Max) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Max, "max {reg1}, {reg2}, {reg3}"), "Max");
+}
+
+TEST_F(AssemblerRISCV64Test, Maxu) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Maxu, "maxu {reg1}, {reg2}, {reg3}"), "Maxu");
+}
+
+TEST_F(AssemblerRISCV64Test, Rol) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Rol, "rol {reg1}, {reg2}, {reg3}"), "Rol");
+}
+
+TEST_F(AssemblerRISCV64Test, Rolw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Rolw, "rolw {reg1}, {reg2}, {reg3}"), "Rolw");
+}
+
+TEST_F(AssemblerRISCV64Test, Ror) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Ror, "ror {reg1}, {reg2}, {reg3}"), "Ror");
+}
+
+TEST_F(AssemblerRISCV64Test, Rorw) {
+  DriverStr(RepeatRRR(&Riscv64Assembler::Rorw, "rorw {reg1}, {reg2}, {reg3}"), "Rorw");
+}
+
+TEST_F(AssemblerRISCV64Test, Rori) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Rori, 6, "rori {reg1}, {reg2}, {imm}"), "Rori");
+}
+
+TEST_F(AssemblerRISCV64Test, Roriw) {
+  DriverStr(RepeatRRIb(&Riscv64Assembler::Roriw, 5, "roriw {reg1}, {reg2}, {imm}"), "Roriw");
+}
+
+TEST_F(AssemblerRISCV64Test, OrcB) {
+  DriverStr(RepeatRR(&Riscv64Assembler::OrcB, "orc.b {reg1}, {reg2}"), "OrcB");
+}
+
+TEST_F(AssemblerRISCV64Test, Rev8) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Rev8, "rev8 {reg1}, {reg2}"), "Rev8");
+}
+
+TEST_F(AssemblerRISCV64Test, ZbbSextB) {
+  DriverStr(RepeatRR(&Riscv64Assembler::ZbbSextB, "sext.b {reg1}, {reg2}"), "ZbbSextB");
+}
+
+TEST_F(AssemblerRISCV64Test, ZbbSextH) {
+  DriverStr(RepeatRR(&Riscv64Assembler::ZbbSextH, "sext.h {reg1}, {reg2}"), "ZbbSextH");
+}
+
+TEST_F(AssemblerRISCV64Test, ZbbZextH) {
+  DriverStr(RepeatRR(&Riscv64Assembler::ZbbZextH, "zext.h {reg1}, {reg2}"), "ZbbZextH");
+}
+
+// Pseudo instructions are checked against their expansion, as the reference assembler
+// picks the Zba/Zbb forms for some of them.
+
+TEST_F(AssemblerRISCV64Test, Mv) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Mv, "addi {reg1}, {reg2}, 0"), "Mv");
+}
+
+TEST_F(AssemblerRISCV64Test, Not) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Not, "xori {reg1}, {reg2}, -1"), "Not");
+}
+
+TEST_F(AssemblerRISCV64Test, Neg) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Neg, "sub {reg1}, zero, {reg2}"), "Neg");
+}
+
+TEST_F(AssemblerRISCV64Test, NegW) {
+  DriverStr(RepeatRR(&Riscv64Assembler::NegW, "subw {reg1}, zero, {reg2}"), "NegW");
+}
+
+TEST_F(AssemblerRISCV64Test, SextB) {
+  DriverStr(RepeatRR(&Riscv64Assembler::SextB,
+                     "slli {reg1}, {reg2}, 56\n"
+                     "srai {reg1}, {reg1}, 56"),
+            "SextB");
+}
+
+TEST_F(AssemblerRISCV64Test, SextH) {
+  DriverStr(RepeatRR(&Riscv64Assembler::SextH,
+                     "slli {reg1}, {reg2}, 48\n"
+                     "srai {reg1}, {reg1}, 48"),
+            "SextH");
+}
+
+TEST_F(AssemblerRISCV64Test, SextW) {
+  DriverStr(RepeatRR(&Riscv64Assembler::SextW, "addiw {reg1}, {reg2}, 0"), "SextW");
+}
+
+TEST_F(AssemblerRISCV64Test, ZextB) {
+  DriverStr(RepeatRR(&Riscv64Assembler::ZextB, "andi {reg1}, {reg2}, 255"), "ZextB");
+}
+
+TEST_F(AssemblerRISCV64Test, ZextH) {
+  DriverStr(RepeatRR(&Riscv64Assembler::ZextH,
+                     "slli {reg1}, {reg2}, 48\n"
+                     "srli {reg1}, {reg1}, 48"),
+            "ZextH");
+}
+
+TEST_F(AssemblerRISCV64Test, ZextW) {
+  DriverStr(RepeatRR(&Riscv64Assembler::ZextW,
+                     "slli {reg1}, {reg2}, 32\n"
+                     "srli {reg1}, {reg1}, 32"),
+            "ZextW");
+}
+
+TEST_F(AssemblerRISCV64Test, Seqz) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Seqz, "sltiu {reg1}, {reg2}, 1"), "Seqz");
+}
+
+TEST_F(AssemblerRISCV64Test, Snez) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Snez, "sltu {reg1}, zero, {reg2}"), "Snez");
+}
+
+TEST_F(AssemblerRISCV64Test, Sltz) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Sltz, "slt {reg1}, {reg2}, zero"), "Sltz");
+}
+
+TEST_F(AssemblerRISCV64Test, Sgtz) {
+  DriverStr(RepeatRR(&Riscv64Assembler::Sgtz, "slt {reg1}, zero, {reg2}"), "Sgtz");
+}
+
+TEST_F(AssemblerRISCV64Test, FMvS) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FMvS, "fsgnj.s {reg1}, {reg2}, {reg2}"), "FMvS");
+}
+
+TEST_F(AssemblerRISCV64Test, FAbsS) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FAbsS, "fsgnjx.s {reg1}, {reg2}, {reg2}"), "FAbsS");
+}
+
+TEST_F(AssemblerRISCV64Test, FNegS) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FNegS, "fsgnjn.s {reg1}, {reg2}, {reg2}"), "FNegS");
+}
+
+TEST_F(AssemblerRISCV64Test, FMvD) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FMvD, "fsgnj.d {reg1}, {reg2}, {reg2}"), "FMvD");
+}
+
+TEST_F(AssemblerRISCV64Test, FAbsD) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FAbsD, "fsgnjx.d {reg1}, {reg2}, {reg2}"), "FAbsD");
+}
+
+TEST_F(AssemblerRISCV64Test, FNegD) {
+  DriverStr(RepeatFF(&Riscv64Assembler::FNegD, "fsgnjn.d {reg1}, {reg2}, {reg2}"), "FNegD");
+}
+
+TEST_F(AssemblerRISCV64Test, JumpPseudos) {
+  __ Nop();
+  __ J(-8);
+  __ Jal(2048);
+  __ Jr(A0);
+  __ Jalr(T6);
+  __ Jalr(A1, S0);
+  __ Ret();
+  __ Beqz(A0, 16);
+  __ Bnez(A1, -16);
+  __ Blez(A2, 32);
+  __ Bgez(A3, 64);
+  __ Bltz(A4, 128);
+  __ Bgtz(A5, 256);
+  __ Bgt(A0, A1, 512);
+  __ Ble(A2, A3, 1024);
+  __ Bgtu(A4, A5, 2048);
+  __ Bleu(A6, A7, -4096);
+  DriverStr("addi zero, zero, 0\n"
+            "jal zero, -8\n"
+            "jal ra, 2048\n"
+            "jalr zero, 0(a0)\n"
+            "jalr ra, 0(t6)\n"
+            "jalr a1, 0(s0)\n"
+            "jalr zero, 0(ra)\n"
+            "beq a0, zero, 16\n"
+            "bne a1, zero, -16\n"
+            "bge zero, a2, 32\n"
+            "bge a3, zero, 64\n"
+            "blt a4, zero, 128\n"
+            "blt zero, a5, 256\n"
+            "blt a1, a0, 512\n"
+            "bge a3, a2, 1024\n"
+            "bltu a5, a4, 2048\n"
+            "bgeu a7, a6, -4096\n",
+            "JumpPseudos");
+}
+
+TEST_F(AssemblerRISCV64Test, Li) {
+  __ Li(A0, 0);
+  __ Li(A0, 1);
+  __ Li(A0, -1);
+  __ Li(A0, 2047);
+  __ Li(A0, 2048);
+  __ Li(A0, -2048);
+  __ Li(A0, -2049);
+  __ Li(A0, 0x12345678);
+  __ Li(A0, 0x7fffffff);
+  __ Li(A0, 0x7ffff800);
+  __ Li(A0, std::numeric_limits<int32_t>::min());
+  __ Li(A0, INT64_C(0x80000000));
+  __ Li(A0, INT64_C(0xfedcba987));
+  __ Li(A0, INT64_C(0x123456789abcdef0));
+  __ Li(A0, std::numeric_limits<int64_t>::min());
+  __ Li(A0, std::numeric_limits<int64_t>::max());
+  DriverStr("addi a0, zero, 0\n"
+            "addi a0, zero, 1\n"
+            "addi a0, zero, -1\n"
+            "addi a0, zero, 2047\n"
+            "lui a0, 1\n"
+            "addiw a0, a0, -2048\n"
+            "addi a0, zero, -2048\n"
+            "lui a0, 1048575\n"
+            "addiw a0, a0, 2047\n"
+            "lui a0, 74565\n"
+            "addiw a0, a0, 1656\n"
+            "lui a0, 524288\n"
+            "addiw a0, a0, -1\n"
+            "lui a0, 524288\n"
+            "addiw a0, a0, -2048\n"
+            "lui a0, 524288\n"
+            "addi a0, zero, 1\n"
+            "slli a0, a0, 31\n"
+            "lui a0, 4078\n"
+            "addiw a0, a0, -837\n"
+            "slli a0, a0, 12\n"
+            "addi a0, a0, -1657\n"
+            "lui a0, 583\n"
+            "addiw a0, a0, -1875\n"
+            "slli a0, a0, 14\n"
+            "addi a0, a0, -947\n"
+            "slli a0, a0, 12\n"
+            "addi a0, a0, 1511\n"
+            "slli a0, a0, 13\n"
+            "addi a0, a0, -272\n"
+            "addi a0, zero, -1\n"
+            "slli a0, a0, 63\n"
+            "addi a0, zero, -1\n"
+            "slli a0, a0, 63\n"
+            "addi a0, a0, -1\n",
+            "Li");
+}
+
+TEST_F(AssemblerRISCV64Test, LabelBranches) {
+  Riscv64Label label1, label2;
+  __ Beqz(A0, &label1);
+  __ Bnez(A1, &label2);
+  __ Blt(A2, A3, &label1);
+  __ Bind(&label1);
+  __ Bge(A4, A5, &label1);
+  __ Bgtu(S0, S1, &label2);
+  __ Jal(&label1);
+  __ Bind(&label2);
+  __ J(&label2);
+  __ Jal(T0, &label1);
+  // Branches that are never taken are dropped, unconditional ones become jumps.
+  __ Bne(A0, A0, &label1);
+  __ Bgeu(A0, A0, &label2);
+  DriverStr("beq a0, zero, 1f\n"
+            "bne a1, zero, 2f\n"
+            "blt a2, a3, 1f\n"
+            "1:\n"
+            "bge a4, a5, 1b\n"
+            "bltu s1, s0, 2f\n"
+            "jal ra, 1b\n"
+            "2:\n"
+            "jal zero, 2b\n"
+            "jal t0, 1b\n"
+            "jal zero, 2b\n",
+            "LabelBranches");
+}
+
+TEST_F(AssemblerRISCV64Test, CondBranch21) {
+  // Forward and backward conditional branches beyond the range of B-type instructions are
+  // emitted as an inverted branch over a JAL.
+  constexpr size_t kNopCount = 1100u;  // More than 4KiB.
+  Riscv64Label label1, label2;
+  __ Bind(&label1);
+  __ Beq(A0, A1, &label2);
+  for (size_t i = 0; i != kNopCount; ++i) {
+    __ Nop();
+  }
+  __ Bltu(A2, A3, &label1);
+  __ Bind(&label2);
+  DriverStr("1:\n"
+            "bne a0, a1, 3f\n"
+            "jal zero, 2f\n"
+            "3:\n" +
+            RepeatInsn(kNopCount, "addi zero, zero, 0\n") +
+            "bgeu a2, a3, 4f\n"
+            "jal zero, 1b\n"
+            "4:\n"
+            "2:\n",
+            "CondBranch21");
+}
+
+TEST_F(AssemblerRISCV64Test, LongBranches) {
+  // Branches beyond the range of JAL use AUIPC with the temporary register,
+  // calls use the link register instead.
+  constexpr size_t kNopCount = (1u << 18) + 16u;  // More than 1MiB.
+  Riscv64Label label;
+  __ Bgt(A0, A1, &label);
+  __ J(&label);
+  __ Jal(&label);
+  for (size_t i = 0; i != kNopCount; ++i) {
+    __ Nop();
+  }
+  __ Bind(&label);
+
+  // Offsets are relative to the AUIPC instructions at 4, 12 and 20 bytes.
+  const int32_t end = 12 + 8 + 8 + kNopCount * 4;
+  auto [imm20_1, imm12_1] = SplitOffset(end - 4);
+  auto [imm20_2, imm12_2] = SplitOffset(end - 12);
+  auto [imm20_3, imm12_3] = SplitOffset(end - 20);
+  std::string expected =
+      "bge a1, a0, 1f\n"
+      "auipc t6, " + std::to_string(imm20_1) + "\n"
+      "jalr zero, " + std::to_string(imm12_1) + "(t6)\n"
+      "1:\n"
+      "auipc t6, " + std::to_string(imm20_2) + "\n"
+      "jalr zero, " + std::to_string(imm12_2) + "(t6)\n"
+      "auipc ra, " + std::to_string(imm20_3) + "\n"
+      "jalr ra, " + std::to_string(imm12_3) + "(ra)\n" +
+      RepeatInsn(kNopCount, "addi zero, zero, 0\n");
+  DriverStr(expected, "LongBranches");
+}
+
+#undef __
+
+}  // namespace riscv64
+}  // namespace art
@@ -0,0 +1,760 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jni_macro_assembler_riscv64.h"
+
+#include "base/bit_utils_iterator.h"
+#include "entrypoints/quick/quick_entrypoints.h"
+#include "indirect_reference_table.h"
+#include "lock_word.h"
+#include "managed_register_riscv64.h"
+#include "offsets.h"
+#include "thread.h"
+
+namespace art HIDDEN {
+namespace riscv64 {
+
+#ifdef __
+#error "RISCV64 Assembler macro already defined."
+#else
+#define __ asm_.
+#endif
+
+static dwarf::Reg DWARFReg(XRegister reg) {
+  return dwarf::Reg::Riscv64Core(static_cast<int>(reg));
+}
+
+static dwarf::Reg DWARFReg(FRegister reg) {
+  return dwarf::Reg::Riscv64Fp(static_cast<int>(reg));
+}
+
+static constexpr size_t kSpillSize = 8u;  // Both GPRs and FPRs are spilled as 64-bit values.
+
+Riscv64JNIMacroAssembler::~Riscv64JNIMacroAssembler() {
+}
+
+void Riscv64JNIMacroAssembler::FinalizeCode() {
+  __ FinalizeCode();
+}
+
+void Riscv64JNIMacroAssembler::BuildFrame(size_t frame_size,
+                                          ManagedRegister method_reg,
+                                          ArrayRef<const ManagedRegister> callee_save_regs) {
+  // Collect the core and FP callee-save registers.
+  uint32_t core_spill_mask = 0u;
+  uint32_t fp_spill_mask = 0u;
+  for (ManagedRegister r : callee_save_regs) {
+    Riscv64ManagedRegister reg = r.AsRiscv64();
+    if (reg.IsXRegister()) {
+      core_spill_mask |= 1u << reg.AsXRegister();
+    } else {
+      DCHECK(reg.IsFRegister());
+      fp_spill_mask |= 1u << reg.AsFRegister();
+    }
+  }
+  size_t spill_size = (POPCOUNT(core_spill_mask) + POPCOUNT(fp_spill_mask)) * kSpillSize;
+
+  // Increase frame to required size.
+  DCHECK_ALIGNED(frame_size, kStackAlignment);
+  // Must at least have space for Method* if we're going to spill it.
+  DCHECK_GE(frame_size,
+            spill_size + (method_reg.IsRegister() ? static_cast<size_t>(kRiscv64PointerSize) : 0u));
+  IncreaseFrameSize(frame_size);
+
+  // Save callee-saves. Use the same layout as the runtime: RA at the top of the frame,
+  // followed by the other core registers and then FP registers, from high to low.
+  int32_t offset = dchecked_integral_cast<int32_t>(frame_size);
+  if ((core_spill_mask & (1u << RA)) != 0u) {
+    offset -= kSpillSize;
+    StoreToOffset(Riscv64ManagedRegister::FromXRegister(RA), SP, offset, kSpillSize);
+    cfi().RelOffset(DWARFReg(RA), offset);
+  }
+  for (uint32_t reg : HighToLowBits(core_spill_mask & ~(1u << RA))) {
+    offset -= kSpillSize;
+    XRegister xreg = enum_cast<XRegister>(reg);
+    StoreToOffset(Riscv64ManagedRegister::FromXRegister(xreg), SP, offset, kSpillSize);
+    cfi().RelOffset(DWARFReg(xreg), offset);
+  }
+  for (uint32_t reg : HighToLowBits(fp_spill_mask)) {
+    offset -= kSpillSize;
+    FRegister freg = enum_cast<FRegister>(reg);
+    StoreToOffset(Riscv64ManagedRegister::FromFRegister(freg), SP, offset, kSpillSize);
+    cfi().RelOffset(DWARFReg(freg), offset);
+  }
+
+  if (method_reg.IsRegister()) {
+    // Write ArtMethod*.
+    DCHECK_EQ(A0, method_reg.AsRiscv64().AsXRegister());
+    StoreToOffset(method_reg.AsRiscv64(), SP, 0, static_cast<size_t>(kRiscv64PointerSize));
+  }
+}
+
+void Riscv64JNIMacroAssembler::RemoveFrame(size_t frame_size,
+                                           ArrayRef<const ManagedRegister> callee_save_regs,
+                                           [[maybe_unused]] bool may_suspend) {
+  uint32_t core_spill_mask = 0u;
+  uint32_t fp_spill_mask = 0u;
+  for (ManagedRegister r : callee_save_regs) {
+    Riscv64ManagedRegister reg = r.AsRiscv64();
+    if (reg.IsXRegister()) {
+      core_spill_mask |= 1u << reg.AsXRegister();
+    } else {
+      DCHECK(reg.IsFRegister());
+      fp_spill_mask |= 1u << reg.AsFRegister();
+    }
+  }
+
+  // For now we only check that the size of the frame is large enough to hold spills.
+  DCHECK_GE(frame_size, (POPCOUNT(core_spill_mask) + POPCOUNT(fp_spill_mask)) * kSpillSize);
+  DCHECK_ALIGNED(frame_size, kStackAlignment);
+
+  cfi().RememberState();
+
+  // Restore callee-saves.
+  int32_t offset = dchecked_integral_cast<int32_t>(frame_size);
+  if ((core_spill_mask & (1u << RA)) != 0u) {
+    offset -= kSpillSize;
+    LoadFromOffset(Riscv64ManagedRegister::FromXRegister(RA), SP, offset, kSpillSize);
+    cfi().Restore(DWARFReg(RA));
+  }
+  for (uint32_t reg : HighToLowBits(core_spill_mask & ~(1u << RA))) {
+    offset -= kSpillSize;
+    XRegister xreg = enum_cast<XRegister>(reg);
+    LoadFromOffset(Riscv64ManagedRegister::FromXRegister(xreg), SP, offset, kSpillSize);
+    cfi().Restore(DWARFReg(xreg));
+  }
+  for (uint32_t reg : HighToLowBits(fp_spill_mask)) {
+    offset -= kSpillSize;
+    FRegister freg = enum_cast<FRegister>(reg);
+    LoadFromOffset(Riscv64ManagedRegister::FromFRegister(freg), SP, offset, kSpillSize);
+    cfi().Restore(DWARFReg(freg));
+  }
+
+  // Note: There is no marking register on riscv64, so there is nothing to refresh
+  // even if the method may have been suspended.
+
+  // Decrease frame size to start of callee saved regs.
+  DecreaseFrameSize(frame_size);
+
+  // Return to RA.
+  __ Ret();
+
+  // The CFI should be restored for any code that follows the exit block.
+  cfi().RestoreState();
+  cfi().DefCFAOffset(frame_size);
+}
+
+void Riscv64JNIMacroAssembler::IncreaseFrameSize(size_t adjust) {
+  if (adjust != 0u) {
+    CHECK_ALIGNED(adjust, kStackAlignment);
+    AddConstant(SP, SP, -static_cast<int64_t>(adjust));
+    cfi().AdjustCFAOffset(adjust);
+  }
+}
+
+void Riscv64JNIMacroAssembler::DecreaseFrameSize(size_t adjust) {
+  if (adjust != 0u) {
+    CHECK_ALIGNED(adjust, kStackAlignment);
+    AddConstant(SP, SP, static_cast<int64_t>(adjust));
+    cfi().AdjustCFAOffset(-adjust);
+  }
+}
+
+ManagedRegister Riscv64JNIMacroAssembler::CoreRegisterWithSize(ManagedRegister m_src, size_t size) {
+  DCHECK(size == 4u || size == 8u) << size;
+  // There are no separate 32-bit views of the core registers on riscv64.
+  DCHECK(m_src.AsRiscv64().IsXRegister());
+  return m_src;
+}
+
+void Riscv64JNIMacroAssembler::Store(FrameOffset offs, ManagedRegister m_src, size_t size) {
+  StoreToOffset(m_src.AsRiscv64(), SP, offs.Int32Value(), size);
+}
+
+void Riscv64JNIMacroAssembler::Store(ManagedRegister m_base,
+                                     MemberOffset offs,
+                                     ManagedRegister m_src,
+                                     size_t size) {
+  StoreToOffset(m_src.AsRiscv64(), m_base.AsRiscv64().AsXRegister(), offs.Int32Value(), size);
+}
+
+void Riscv64JNIMacroAssembler::StoreRawPtr(FrameOffset offs, ManagedRegister m_src) {
+  StoreToOffset(m_src.AsRiscv64(), SP, offs.Int32Value(), static_cast<size_t>(kRiscv64PointerSize));
+}
+
+void Riscv64JNIMacroAssembler::StoreStackPointerToThread(ThreadOffset64 offs, bool tag_sp) {
+  __ Mv(TMP, SP);
+  if (tag_sp) {
+    __ Ori(TMP, TMP, 0x2);
+  }
+  StoreToOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                TR,
+                offs.Int32Value(),
+                static_cast<size_t>(kRiscv64PointerSize));
+}
+
+void Riscv64JNIMacroAssembler::Load(ManagedRegister m_dest, FrameOffset offs, size_t size) {
+  LoadFromOffset(m_dest.AsRiscv64(), SP, offs.Int32Value(), size);
+}
+
+void Riscv64JNIMacroAssembler::Load(ManagedRegister m_dest,
+                                    ManagedRegister m_base,
+                                    MemberOffset offs,
+                                    size_t size) {
+  LoadFromOffset(m_dest.AsRiscv64(), m_base.AsRiscv64().AsXRegister(), offs.Int32Value(), size);
+}
+
+void Riscv64JNIMacroAssembler::LoadRawPtrFromThread(ManagedRegister m_dest, ThreadOffset64 offs) {
+  LoadFromOffset(
+      m_dest.AsRiscv64(), TR, offs.Int32Value(), static_cast<size_t>(kRiscv64PointerSize));
+}
+
+void Riscv64JNIMacroAssembler::MoveArguments(ArrayRef<ArgumentLocation> dests,
+                                             ArrayRef<ArgumentLocation> srcs,
+                                             ArrayRef<FrameOffset> refs) {
+  size_t arg_count = dests.size();
+  DCHECK_EQ(arg_count, srcs.size());
+  DCHECK_EQ(arg_count, refs.size());
+  auto get_mask = [](ManagedRegister reg) -> uint64_t {
+    Riscv64ManagedRegister riscv64_reg = reg.AsRiscv64();
+    if (riscv64_reg.IsXRegister()) {
+      size_t core_reg_number = static_cast<size_t>(riscv64_reg.AsXRegister());
+      DCHECK_LT(core_reg_number, 32u);
+      return UINT64_C(1) << core_reg_number;
+    } else {
+      DCHECK(riscv64_reg.IsFRegister());
+      size_t fp_reg_number = static_cast<size_t>(riscv64_reg.AsFRegister());
+      DCHECK_LT(fp_reg_number, 32u);
+      return (UINT64_C(1) << 32u) << fp_reg_number;
+    }
+  };
+  // Collect registers to move while storing/copying args to stack slots.
+  // Convert processed references to `jobject`.
+  uint64_t src_regs = 0u;
+  uint64_t dest_regs = 0u;
+  for (size_t i = 0; i != arg_count; ++i) {
+    const ArgumentLocation& src = srcs[i];
+    const ArgumentLocation& dest = dests[i];
+    const FrameOffset ref = refs[i];
+    if (ref != kInvalidReferenceOffset) {
+      DCHECK_EQ(src.GetSize(), kObjectReferenceSize);
+      DCHECK_EQ(dest.GetSize(), static_cast<size_t>(kRiscv64PointerSize));
+    } else {
+      DCHECK_EQ(src.GetSize(), dest.GetSize());
+    }
+    if (dest.IsRegister()) {
+      if (src.IsRegister() && src.GetRegister().Equals(dest.GetRegister())) {
+        // No move is necessary but we may need to convert a reference to a `jobject`.
+        if (ref != kInvalidReferenceOffset) {
+          CreateJObject(dest.GetRegister(), ref, src.GetRegister(), /*null_allowed=*/ i != 0u);
+        }
+      } else {
+        if (src.IsRegister()) {
+          src_regs |= get_mask(src.GetRegister());
+        }
+        dest_regs |= get_mask(dest.GetRegister());
+      }
+    } else {
+      // The native ABI requires 32-bit integral arguments to be sign-extended to 64 bits
+      // also when passed on the stack. The managed ABI keeps them sign-extended in core
+      // registers, so we store them as 64-bit values. (The upper half of a stack slot
+      // holding a `float` is undefined, so FP values are stored with their own size.)
+      if (ref != kInvalidReferenceOffset) {
+        if (src.IsRegister()) {
+          // Note: We can clobber `src` here as the register cannot hold more than one argument.
+          CreateJObject(src.GetRegister(), ref, src.GetRegister(), /*null_allowed=*/ i != 0u);
+          Store(dest.GetFrameOffset(), src.GetRegister(), dest.GetSize());
+        } else {
+          CreateJObject(dest.GetFrameOffset(), ref, /*null_allowed=*/ i != 0u);
+        }
+      } else if (src.IsRegister()) {
+        Riscv64ManagedRegister src_reg = src.GetRegister().AsRiscv64();
+        size_t store_size = src_reg.IsXRegister() ? kSpillSize : dest.GetSize();
+        StoreToOffset(src_reg, SP, dest.GetFrameOffset().Int32Value(), store_size);
+      } else {
+        XRegister base = SP;
+        int32_t offset = src.GetFrameOffset().Int32Value();
+        AdjustBaseAndOffset(&base, &offset);
+        if (src.GetSize() == 4u) {
+          __ Lw(TMP, base, offset);
+        } else {
+          DCHECK_EQ(src.GetSize(), 8u);
+          __ Ld(TMP, base, offset);
+        }
+        StoreToOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                      SP,
+                      dest.GetFrameOffset().Int32Value(),
+                      kSpillSize);
+      }
+    }
+  }
+  // Fill destination registers. We should never have circular dependencies.
+  while (dest_regs != 0u) {
+    uint64_t old_dest_regs = dest_regs;
+    for (size_t i = 0; i != arg_count; ++i) {
+      const ArgumentLocation& src = srcs[i];
+      const ArgumentLocation& dest = dests[i];
+      const FrameOffset ref = refs[i];
+      if (!dest.IsRegister()) {
+        continue;  // Stored in first loop above.
+      }
+      uint64_t dest_reg_mask = get_mask(dest.GetRegister());
+      if ((dest_reg_mask & dest_regs) == 0u) {
+        continue;  // Equals source, or already filled in one of previous iterations.
+      }
+      if ((dest_reg_mask & src_regs) != 0u) {
+        continue;  // Cannot clobber this register yet.
+      }
+      if (src.IsRegister()) {
+        if (ref != kInvalidReferenceOffset) {
+          CreateJObject(dest.GetRegister(), ref, src.GetRegister(), /*null_allowed=*/ i != 0u);
+        } else {
+          Move(dest.GetRegister(), src.GetRegister(), dest.GetSize());
+        }
+        src_regs &= ~get_mask(src.GetRegister());  // Allow clobbering source register.
+      } else if (ref != kInvalidReferenceOffset) {
+        CreateJObject(
+            dest.GetRegister(), ref, ManagedRegister::NoRegister(), /*null_allowed=*/ i != 0u);
+      } else {
+        Riscv64ManagedRegister dest_reg = dest.GetRegister().AsRiscv64();
+        if (dest_reg.IsXRegister() && dest.GetSize() == 4u) {
+          // Sign-extend 32-bit integral arguments, see above.
+          XRegister base = SP;
+          int32_t offset = src.GetFrameOffset().Int32Value();
+          AdjustBaseAndOffset(&base, &offset);
+          __ Lw(dest_reg.AsXRegister(), base, offset);
+        } else {
+          LoadFromOffset(dest_reg, SP, src.GetFrameOffset().Int32Value(), dest.GetSize());
+        }
+      }
+      dest_regs &= ~get_mask(dest.GetRegister());  // Destination register was filled.
+    }
+    CHECK_NE(old_dest_regs, dest_regs);
+    DCHECK_EQ(0u, dest_regs & ~old_dest_regs);
+  }
+}
+
+void Riscv64JNIMacroAssembler::Move(ManagedRegister m_dest, ManagedRegister m_src, size_t size) {
+  DCHECK(size == 4u || size == 8u) << size;
+  Riscv64ManagedRegister dest = m_dest.AsRiscv64();
+  Riscv64ManagedRegister src = m_src.AsRiscv64();
+  if (dest.Equals(src)) {
+    return;
+  }
+  if (dest.IsXRegister()) {
+    if (src.IsXRegister()) {
+      __ Mv(dest.AsXRegister(), src.AsXRegister());
+    } else if (size == 4u) {
+      __ FMvXW(dest.AsXRegister(), src.AsFRegister());
+    } else {
+      __ FMvXD(dest.AsXRegister(), src.AsFRegister());
+    }
+  } else {
+    if (src.IsFRegister()) {
+      if (size == 4u) {
+        __ FMvS(dest.AsFRegister(), src.AsFRegister());
+      } else {
+        __ FMvD(dest.AsFRegister(), src.AsFRegister());
+      }
+    } else if (size == 4u) {
+      __ FMvWX(dest.AsFRegister(), src.AsXRegister());
+    } else {
+      __ FMvDX(dest.AsFRegister(), src.AsXRegister());
+    }
+  }
+}
+
+void Riscv64JNIMacroAssembler::Move(ManagedRegister m_dest, size_t value) {
+  __ Li(m_dest.AsRiscv64().AsXRegister(), static_cast<int64_t>(value));
+}
+
+void Riscv64JNIMacroAssembler::SignExtend(ManagedRegister mreg, size_t size) {
+  XRegister reg = mreg.AsRiscv64().AsXRegister();
+  if (size == 1u) {
+    __ SextB(reg, reg);
+  } else {
+    CHECK_EQ(size, 2u) << "Unexpected size " << size;
+    __ SextH(reg, reg);
+  }
+}
+
+void Riscv64JNIMacroAssembler::ZeroExtend(ManagedRegister mreg, size_t size) {
+  XRegister reg = mreg.AsRiscv64().AsXRegister();
+  if (size == 1u) {
+    __ ZextB(reg, reg);
+  } else {
+    CHECK_EQ(size, 2u) << "Unexpected size " << size;
+    __ ZextH(reg, reg);
+  }
+}
+
+void Riscv64JNIMacroAssembler::GetCurrentThread(ManagedRegister dest) {
+  __ Mv(dest.AsRiscv64().AsXRegister(), TR);
+}
+
+void Riscv64JNIMacroAssembler::GetCurrentThread(FrameOffset offset) {
+  StoreToOffset(Riscv64ManagedRegister::FromXRegister(TR),
+                SP,
+                offset.Int32Value(),
+                static_cast<size_t>(kRiscv64PointerSize));
+}
+
+void Riscv64JNIMacroAssembler::DecodeJNITransitionOrLocalJObject(ManagedRegister m_reg,
+                                                                 JNIMacroLabel* slow_path,
+                                                                 JNIMacroLabel* resume) {
+  constexpr int32_t kGlobalOrWeakGlobalMask =
+      dchecked_integral_cast<int32_t>(IndirectReferenceTable::GetGlobalOrWeakGlobalMask());
+  constexpr int32_t kIndirectRefKindMask =
+      dchecked_integral_cast<int32_t>(IndirectReferenceTable::GetIndirectRefKindMask());
+  static_assert(IsInt<12>(kGlobalOrWeakGlobalMask));
+  static_assert(IsInt<12>(~kIndirectRefKindMask));
+  XRegister reg = m_reg.AsRiscv64().AsXRegister();
+  __ Andi(TMP, reg, kGlobalOrWeakGlobalMask);
+  __ Bnez(TMP, Riscv64JNIMacroLabel::Cast(slow_path)->AsRiscv64());
+  __ Andi(reg, reg, ~kIndirectRefKindMask);
+  __ Beqz(reg, Riscv64JNIMacroLabel::Cast(resume)->AsRiscv64());  // Skip load for null.
+  __ Lwu(reg, reg, 0);
+}
+
+void Riscv64JNIMacroAssembler::VerifyObject([[maybe_unused]] ManagedRegister m_src,
+                                            [[maybe_unused]] bool could_be_null) {
+  // Nothing to do, JNI stubs do not verify references on any architecture.
+}
+
+void Riscv64JNIMacroAssembler::VerifyObject([[maybe_unused]] FrameOffset src,
+                                            [[maybe_unused]] bool could_be_null) {
+  // Nothing to do, JNI stubs do not verify references on any architecture.
+}
+
+void Riscv64JNIMacroAssembler::Jump(ManagedRegister m_base, Offset offs) {
+  Riscv64ManagedRegister base = m_base.AsRiscv64();
+  CHECK(base.IsXRegister()) << base;
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                 base.AsXRegister(),
+                 offs.Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  __ Jr(TMP);
+}
+
+void Riscv64JNIMacroAssembler::Call(ManagedRegister m_base, Offset offs) {
+  Riscv64ManagedRegister base = m_base.AsRiscv64();
+  CHECK(base.IsXRegister()) << base;
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(RA),
+                 base.AsXRegister(),
+                 offs.Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  __ Jalr(RA);
+}
+
+void Riscv64JNIMacroAssembler::CallFromThread(ThreadOffset64 offset) {
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(RA),
+                 TR,
+                 offset.Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  __ Jalr(RA);
+}
+
+void Riscv64JNIMacroAssembler::TryToTransitionFromRunnableToNative(
+    JNIMacroLabel* label, [[maybe_unused]] ArrayRef<const ManagedRegister> scratch_regs) {
+  constexpr uint32_t kNativeStateValue = Thread::StoredThreadStateValue(ThreadState::kNative);
+  constexpr uint32_t kRunnableStateValue = Thread::StoredThreadStateValue(ThreadState::kRunnable);
+  constexpr ThreadOffset64 thread_flags_offset = Thread::ThreadFlagsOffset<kRiscv64PointerSize>();
+  constexpr ThreadOffset64 thread_held_mutex_mutator_lock_offset =
+      Thread::HeldMutexOffset<kRiscv64PointerSize>(kMutatorLock);
+
+  // CAS release, old_value = kRunnableStateValue, new_value = kNativeStateValue, no flags.
+  Riscv64Label retry;
+  __ Bind(&retry);
+  static_assert(thread_flags_offset.Int32Value() == 0);  // LR/SC require exact address.
+  __ LrW(TMP, TR, AqRl::kNone);
+  __ Li(TMP2, kNativeStateValue);
+  // If any flags are set, go to the slow path.
+  static_assert(kRunnableStateValue == 0u);
+  __ Bnez(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+  __ ScW(TMP, TMP2, TR, AqRl::kRelease);
+  __ Bnez(TMP, &retry);
+
+  // Clear `self->tlsPtr_.held_mutexes[kMutatorLock]`.
+  StoreToOffset(Riscv64ManagedRegister::FromXRegister(Zero),
+                TR,
+                thread_held_mutex_mutator_lock_offset.Int32Value(),
+                static_cast<size_t>(kRiscv64PointerSize));
+}
+
+void Riscv64JNIMacroAssembler::TryToTransitionFromNativeToRunnable(
+    JNIMacroLabel* label,
+    [[maybe_unused]] ArrayRef<const ManagedRegister> scratch_regs,
+    [[maybe_unused]] ManagedRegister return_reg) {
+  constexpr uint32_t kNativeStateValue = Thread::StoredThreadStateValue(ThreadState::kNative);
+  constexpr uint32_t kRunnableStateValue = Thread::StoredThreadStateValue(ThreadState::kRunnable);
+  constexpr ThreadOffset64 thread_flags_offset = Thread::ThreadFlagsOffset<kRiscv64PointerSize>();
+  constexpr ThreadOffset64 thread_held_mutex_mutator_lock_offset =
+      Thread::HeldMutexOffset<kRiscv64PointerSize>(kMutatorLock);
+  constexpr ThreadOffset64 thread_mutator_lock_offset =
+      Thread::MutatorLockOffset<kRiscv64PointerSize>();
+
+  // CAS acquire, old_value = kNativeStateValue, new_value = kRunnableStateValue, no flags.
+  Riscv64Label retry;
+  __ Bind(&retry);
+  static_assert(thread_flags_offset.Int32Value() == 0);  // LR/SC require exact address.
+  __ LrW(TMP, TR, AqRl::kAcquire);
+  __ Li(TMP2, kNativeStateValue);
+  // If any flags are set, or the state is not Native, go to the slow path.
+  // (While the thread can theoretically transition between different Suspended states,
+  // it would be very unexpected to see a state other than Native at this point.)
+  __ Bne(TMP, TMP2, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+  static_assert(kRunnableStateValue == 0u);
+  __ ScW(TMP, Zero, TR, AqRl::kNone);
+  __ Bnez(TMP, &retry);
+
+  // Set `self->tlsPtr_.held_mutexes[kMutatorLock]` to the mutator lock.
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                 TR,
+                 thread_mutator_lock_offset.Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  StoreToOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                TR,
+                thread_held_mutex_mutator_lock_offset.Int32Value(),
+                static_cast<size_t>(kRiscv64PointerSize));
+}
+
+void Riscv64JNIMacroAssembler::SuspendCheck(JNIMacroLabel* label) {
+  constexpr int32_t kSuspendOrCheckpointRequestFlags =
+      dchecked_integral_cast<int32_t>(Thread::SuspendOrCheckpointRequestFlags());
+  static_assert(IsInt<12>(kSuspendOrCheckpointRequestFlags));
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                 TR,
+                 Thread::ThreadFlagsOffset<kRiscv64PointerSize>().Int32Value(),
+                 sizeof(uint32_t));
+  __ Andi(TMP, TMP, kSuspendOrCheckpointRequestFlags);
+  __ Bnez(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+}
+
+void Riscv64JNIMacroAssembler::ExceptionPoll(JNIMacroLabel* label) {
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                 TR,
+                 Thread::ExceptionOffset<kRiscv64PointerSize>().Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  __ Bnez(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+}
+
+void Riscv64JNIMacroAssembler::DeliverPendingException() {
+  // Pass exception object as argument.
+  // Don't care about preserving A0 as this won't return.
+  // Note: The scratch register from `ExceptionPoll()` may have been clobbered.
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(A0),
+                 TR,
+                 Thread::ExceptionOffset<kRiscv64PointerSize>().Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(RA),
+                 TR,
+                 QUICK_ENTRYPOINT_OFFSET(kRiscv64PointerSize, pDeliverException).Int32Value(),
+                 static_cast<size_t>(kRiscv64PointerSize));
+  __ Jalr(RA);
+  // Call should never return.
+  __ Ebreak();
+}
+
+std::unique_ptr<JNIMacroLabel> Riscv64JNIMacroAssembler::CreateLabel() {
+  return std::unique_ptr<JNIMacroLabel>(new Riscv64JNIMacroLabel());
+}
+
+void Riscv64JNIMacroAssembler::Jump(JNIMacroLabel* label) {
+  CHECK(label != nullptr);
+  __ J(Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+}
+
+void Riscv64JNIMacroAssembler::TestGcMarking(JNIMacroLabel* label, JNIMacroUnaryCondition cond) {
+  CHECK(label != nullptr);
+  DCHECK_EQ(Thread::IsGcMarkingSize(), 4u);
+  DCHECK(gUseReadBarrier);
+  // There is no marking register on riscv64, load the flag from the thread.
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                 TR,
+                 Thread::IsGcMarkingOffset<kRiscv64PointerSize>().Int32Value(),
+                 Thread::IsGcMarkingSize());
+  // The switch covers all `JNIMacroUnaryCondition` values, -Wswitch flags any new one.
+  switch (cond) {
+    case JNIMacroUnaryCondition::kZero:
+      __ Beqz(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+      break;
+    case JNIMacroUnaryCondition::kNotZero:
+      __ Bnez(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+      break;
+  }
+}
+
+void Riscv64JNIMacroAssembler::TestMarkBit(ManagedRegister m_ref,
+                                           JNIMacroLabel* label,
+                                           JNIMacroUnaryCondition cond) {
+  DCHECK(kUseBakerReadBarrier);
+  XRegister ref = m_ref.AsRiscv64().AsXRegister();
+  LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                 ref,
+                 mirror::Object::MonitorOffset().Int32Value(),
+                 sizeof(uint32_t));
+  // Move the mark bit to the sign bit and test the sign.
+  static_assert(LockWord::kMarkBitStateSize == 1u);
+  __ Slliw(TMP, TMP, 31 - LockWord::kMarkBitStateShift);
+  switch (cond) {
+    case JNIMacroUnaryCondition::kZero:
+      __ Bgez(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+      break;
+    case JNIMacroUnaryCondition::kNotZero:
+      __ Bltz(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+      break;
+  }
+}
+
+void Riscv64JNIMacroAssembler::TestByteAndJumpIfNotZero(uintptr_t address, JNIMacroLabel* label) {
+  __ Li(TMP, dchecked_integral_cast<int64_t>(address));
+  __ Lb(TMP, TMP, 0);
+  __ Bnez(TMP, Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+}
+
+void Riscv64JNIMacroAssembler::Bind(JNIMacroLabel* label) {
+  CHECK(label != nullptr);
+  __ Bind(Riscv64JNIMacroLabel::Cast(label)->AsRiscv64());
+}
+
+void Riscv64JNIMacroAssembler::AdjustBaseAndOffset(XRegister* base, int32_t* offset) {
+  if (!IsInt<12>(*offset)) {
+    AddConstant(TMP2, *base, *offset);
+    *base = TMP2;
+    *offset = 0;
+  }
+}
+
+void Riscv64JNIMacroAssembler::StoreToOffset(Riscv64ManagedRegister src,
+                                             XRegister base,
+                                             int32_t offset,
+                                             size_t size) {
+  AdjustBaseAndOffset(&base, &offset);
+  if (src.IsNoRegister()) {
+    CHECK_EQ(0u, size);
+  } else if (src.IsXRegister()) {
+    if (size == 4u) {
+      __ Sw(src.AsXRegister(), base, offset);
+    } else {
+      CHECK_EQ(8u, size);
+      __ Sd(src.AsXRegister(), base, offset);
+    }
+  } else {
+    CHECK(src.IsFRegister()) << src;
+    if (size == 4u) {
+      __ FSw(src.AsFRegister(), base, offset);
+    } else {
+      CHECK_EQ(8u, size);
+      __ FSd(src.AsFRegister(), base, offset);
+    }
+  }
+}
+
+void Riscv64JNIMacroAssembler::LoadFromOffset(Riscv64ManagedRegister dest,
+                                              XRegister base,
+                                              int32_t offset,
+                                              size_t size) {
+  AdjustBaseAndOffset(&base, &offset);
+  if (dest.IsNoRegister()) {
+    CHECK_EQ(0u, size) << dest;
+  } else if (dest.IsXRegister()) {
+    if (size == 1u) {
+      __ Lbu(dest.AsXRegister(), base, offset);
+    } else if (size == 4u) {
+      // 32-bit values in core registers are references, cookies and flags; zero-extend.
+      __ Lwu(dest.AsXRegister(), base, offset);
+    } else {
+      CHECK_EQ(8u, size);
+      __ Ld(dest.AsXRegister(), base, offset);
+    }
+  } else {
+    CHECK(dest.IsFRegister()) << dest;
+    if (size == 4u) {
+      __ FLw(dest.AsFRegister(), base, offset);
+    } else {
+      CHECK_EQ(8u, size);
+      __ FLd(dest.AsFRegister(), base, offset);
+    }
+  }
+}
+
+void Riscv64JNIMacroAssembler::AddConstant(XRegister rd, XRegister rs, int64_t value) {
+  if (IsInt<12>(value)) {
+    __ Addi(rd, rs, value);
+  } else {
+    DCHECK_NE(rs, TMP2);
+    __ Li(TMP2, value);
+    __ Add(rd, rs, TMP2);
+  }
+}
+
+void Riscv64JNIMacroAssembler::CreateJObject(ManagedRegister m_out_reg,
+                                             FrameOffset spilled_reference_offset,
+                                             ManagedRegister m_in_reg,
+                                             bool null_allowed) {
+  Riscv64ManagedRegister out_reg = m_out_reg.AsRiscv64();
+  Riscv64ManagedRegister in_reg = m_in_reg.AsRiscv64();
+  CHECK(in_reg.IsNoRegister() || in_reg.IsXRegister()) << in_reg;
+  CHECK(out_reg.IsXRegister()) << out_reg;
+  // Note: This function does not use TMP, see `MoveArguments()`. Large offsets use TMP2.
+  if (null_allowed) {
+    Riscv64Label null_label;
+    // Null values get a jobject value null. Otherwise, the jobject is
+    // the address of the spilled reference.
+    // e.g. out_reg = (in == 0) ? 0 : (SP+spilled_reference_offset)
+    if (in_reg.IsNoRegister()) {
+      LoadFromOffset(out_reg, SP, spilled_reference_offset.Int32Value(), kObjectReferenceSize);
+      in_reg = out_reg;
+    }
+    if (!out_reg.Equals(in_reg)) {
+      __ Mv(out_reg.AsXRegister(), in_reg.AsXRegister());
+    }
+    __ Beqz(out_reg.AsXRegister(), &null_label);
+    AddConstant(out_reg.AsXRegister(), SP, spilled_reference_offset.Int32Value());
+    __ Bind(&null_label);
+  } else {
+    AddConstant(out_reg.AsXRegister(), SP, spilled_reference_offset.Int32Value());
+  }
+}
+
+void Riscv64JNIMacroAssembler::CreateJObject(FrameOffset out_off,
+                                             FrameOffset spilled_reference_offset,
+                                             bool null_allowed) {
+  // Use TMP for the `jobject`, TMP2 is used only for large offsets.
+  if (null_allowed) {
+    Riscv64Label null_label;
+    LoadFromOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                   SP,
+                   spilled_reference_offset.Int32Value(),
+                   kObjectReferenceSize);
+    // Null values get a jobject value null. Otherwise, the jobject is
+    // the address of the spilled reference.
+    __ Beqz(TMP, &null_label);
+    AddConstant(TMP, SP, spilled_reference_offset.Int32Value());
+    __ Bind(&null_label);
+  } else {
+    AddConstant(TMP, SP, spilled_reference_offset.Int32Value());
+  }
+  StoreToOffset(Riscv64ManagedRegister::FromXRegister(TMP),
+                SP,
+                out_off.Int32Value(),
+                static_cast<size_t>(kRiscv64PointerSize));
+}
+
+#undef __
+
+}  // namespace riscv64
+}  // namespace art
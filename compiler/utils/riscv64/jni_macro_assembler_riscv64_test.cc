@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "jni_macro_assembler_riscv64.h"
+
+#include "base/malloc_arena_pool.h"
+#include "entrypoints/quick/quick_entrypoints.h"
+#include "indirect_reference_table.h"
+#include "thread.h"
+#include "utils/assembler_test_base.h"
+
+namespace art HIDDEN {
+namespace riscv64 {
+
+class JniMacroAssemblerRiscv64Test : public AssemblerTestBase {
+ public:
+  JniMacroAssemblerRiscv64Test() : pool_(), allocator_(&pool_), assembler_(&allocator_) { }
+
+ protected:
+  InstructionSet GetIsa() override { return InstructionSet::kRiscv64; }
+
+  void DriverStr(const std::string& assembly_text, const std::string& test_name) {
+    assembler_.FinalizeCode();
+    size_t cs = assembler_.CodeSize();
+    std::vector<uint8_t> data(cs);
+    MemoryRegion code(&data[0], data.size());
+    assembler_.FinalizeInstructions(code);
+    Driver(data, assembly_text, test_name);
+  }
+
+  static ManagedRegister AsManaged(XRegister reg) {
+    return Riscv64ManagedRegister::FromXRegister(reg);
+  }
+
+  static ManagedRegister AsManaged(FRegister reg) {
+    return Riscv64ManagedRegister::FromFRegister(reg);
+  }
+
+  // Expected code for a load or store with an offset that may not fit into 12 bits.
+  static std::string MemOp(const std::string& insn,
+                           const std::string& reg,
+                           int32_t offset,
+                           const std::string& base) {
+    if (IsInt<12>(offset)) {
+      return insn + " " + reg + ", " + std::to_string(offset) + "(" + base + ")\n";
+    }
+    return "li t5, " + std::to_string(offset) + "\n" +
+           "add t5, " + base + ", t5\n" +
+           insn + " " + reg + ", 0(t5)\n";
+  }
+
+  MallocArenaPool pool_;
+  ArenaAllocator allocator_;
+  Riscv64JNIMacroAssembler assembler_;
+};
+
+TEST_F(JniMacroAssemblerRiscv64Test, StackFrame) {
+  const ManagedRegister callee_save_regs[] = {
+      AsManaged(S0), AsManaged(S2), AsManaged(RA), AsManaged(FS0), AsManaged(FS1)
+  };
+  ArrayRef<const ManagedRegister> regs(callee_save_regs);
+
+  assembler_.BuildFrame(64u, AsManaged(A0), regs);
+  assembler_.IncreaseFrameSize(32u);
+  assembler_.DecreaseFrameSize(32u);
+  assembler_.RemoveFrame(64u, regs, /*may_suspend=*/ true);
+
+  // RA is at the top of the frame, followed by other core and FP registers from high to low.
+  DriverStr("addi sp, sp, -64\n"
+            "sd ra, 56(sp)\n"
+            "sd s2, 48(sp)\n"
+            "sd s0, 40(sp)\n"
+            "fsd fs1, 32(sp)\n"
+            "fsd fs0, 24(sp)\n"
+            "sd a0, 0(sp)\n"
+            "addi sp, sp, -32\n"
+            "addi sp, sp, 32\n"
+            "ld ra, 56(sp)\n"
+            "ld s2, 48(sp)\n"
+            "ld s0, 40(sp)\n"
+            "fld fs1, 32(sp)\n"
+            "fld fs0, 24(sp)\n"
+            "addi sp, sp, 64\n"
+            "jalr zero, 0(ra)\n",
+            "StackFrame");
+}
+
+TEST_F(JniMacroAssemblerRiscv64Test, LoadStoreMove) {
+  assembler_.Store(FrameOffset(16), AsManaged(A1), 4u);
+  assembler_.Store(FrameOffset(24), AsManaged(FA0), 8u);
+  assembler_.Store(FrameOffset(4096), AsManaged(A1), 8u);
+  assembler_.Store(AsManaged(A2), MemberOffset(8), AsManaged(A3), 4u);
+  assembler_.StoreRawPtr(FrameOffset(32), AsManaged(A4));
+  assembler_.StoreStackPointerToThread(ThreadOffset64(128), /*tag_sp=*/ true);
+  assembler_.Load(AsManaged(A2), FrameOffset(16), 4u);
+  assembler_.Load(AsManaged(FA1), FrameOffset(24), 8u);
+  assembler_.Load(AsManaged(A5), AsManaged(A6), MemberOffset(1), 1u);
+  assembler_.LoadRawPtrFromThread(AsManaged(A7), ThreadOffset64(136));
+  assembler_.GetCurrentThread(AsManaged(A0));
+  assembler_.GetCurrentThread(FrameOffset(40));
+  assembler_.Move(AsManaged(A0), AsManaged(A1), 8u);
+  assembler_.Move(AsManaged(FA0), AsManaged(A1), 4u);
+  assembler_.Move(AsManaged(A2), AsManaged(FA3), 8u);
+  assembler_.Move(AsManaged(FA4), AsManaged(FA5), 8u);
+  assembler_.Move(AsManaged(A3), 42u);
+  assembler_.SignExtend(AsManaged(A4), 1u);
+  assembler_.ZeroExtend(AsManaged(A5), 2u);
+
+  DriverStr("sw a1, 16(sp)\n"
+            "fsd fa0, 24(sp)\n"
+            "lui t5, 1\n"
+            "add t5, sp, t5\n"
+            "sd a1, 0(t5)\n"
+            "sw a3, 8(a2)\n"
+            "sd a4, 32(sp)\n"
+            "addi t6, sp, 0\n"
+            "ori t6, t6, 2\n"
+            "sd t6, 128(s1)\n"
+            "lwu a2, 16(sp)\n"
+            "fld fa1, 24(sp)\n"
+            "lbu a5, 1(a6)\n"
+            "ld a7, 136(s1)\n"
+            "addi a0, s1, 0\n"
+            "sd s1, 40(sp)\n"
+            "addi a0, a1, 0\n"
+            "fmv.w.x fa0, a1\n"
+            "fmv.x.d a2, fa3\n"
+            "fsgnj.d fa4, fa5, fa5\n"
+            "addi a3, zero, 42\n"
+            "slli a4, a4, 56\n"
+            "srai a4, a4, 56\n"
+            "slli a5, a5, 48\n"
+            "srli a5, a5, 48\n",
+            "LoadStoreMove");
+}
+
+TEST_F(JniMacroAssemblerRiscv64Test, MoveArguments) {
+  static constexpr FrameOffset kInvalidReferenceOffset =
+      JNIMacroAssembler<kRiscv64PointerSize>::kInvalidReferenceOffset;
+  ArgumentLocation dests[] = {
+      ArgumentLocation(AsManaged(A0), 8u),  // `jclass`.
+      ArgumentLocation(AsManaged(A1), 4u),
+      ArgumentLocation(AsManaged(FA0), 4u),
+      ArgumentLocation(FrameOffset(0), 4u),
+      ArgumentLocation(AsManaged(A2), 8u),  // `jobject`.
+      ArgumentLocation(AsManaged(A3), 4u),
+  };
+  ArgumentLocation srcs[] = {
+      ArgumentLocation(AsManaged(A1), kObjectReferenceSize),
+      ArgumentLocation(AsManaged(A2), 4u),
+      ArgumentLocation(AsManaged(FA1), 4u),
+      ArgumentLocation(FrameOffset(96), 4u),
+      ArgumentLocation(FrameOffset(100), kObjectReferenceSize),
+      ArgumentLocation(FrameOffset(104), 4u),
+  };
+  FrameOffset refs[] = {
+      FrameOffset(88),
+      kInvalidReferenceOffset,
+      kInvalidReferenceOffset,
+      kInvalidReferenceOffset,
+      FrameOffset(100),
+      kInvalidReferenceOffset,
+  };
+  assembler_.MoveArguments(ArrayRef<ArgumentLocation>(dests),
+                           ArrayRef<ArgumentLocation>(srcs),
+                           ArrayRef<FrameOffset>(refs));
+
+  // Stack arguments are stored first. 32-bit integral arguments are sign-extended to 64 bits,
+  // both on the stack and in registers. Registers are filled without clobbering sources.
+  DriverStr("lw t6, 96(sp)\n"
+            "sd t6, 0(sp)\n"
+            "addi a0, sp, 88\n"
+            "addi a1, a2, 0\n"
+            "fsgnj.s fa0, fa1, fa1\n"
+            "lwu a2, 100(sp)\n"
+            "beq a2, zero, 1f\n"
+            "addi a2, sp, 100\n"
+            "1:\n"
+            "lw a3, 104(sp)\n",
+            "MoveArguments");
+}
+
+TEST_F(JniMacroAssemblerRiscv64Test, DecodeJNITransitionOrLocalJObject) {
+  std::unique_ptr<JNIMacroLabel> slow_path = assembler_.CreateLabel();
+  std::unique_ptr<JNIMacroLabel> resume = assembler_.CreateLabel();
+  assembler_.DecodeJNITransitionOrLocalJObject(AsManaged(A0), slow_path.get(), resume.get());
+  assembler_.Bind(resume.get());
+  assembler_.Jump(slow_path.get());
+  assembler_.Bind(slow_path.get());
+
+  int32_t global_or_weak_global_mask =
+      static_cast<int32_t>(IndirectReferenceTable::GetGlobalOrWeakGlobalMask());
+  int32_t indirect_ref_kind_mask =
+      static_cast<int32_t>(IndirectReferenceTable::GetIndirectRefKindMask());
+  DriverStr("andi t6, a0, " + std::to_string(global_or_weak_global_mask) + "\n"
+            "bne t6, zero, 2f\n"
+            "andi a0, a0, " + std::to_string(~indirect_ref_kind_mask) + "\n"
+            "beq a0, zero, 1f\n"
+            "lwu a0, 0(a0)\n"
+            "1:\n"
+            "jal zero, 2f\n"
+            "2:\n",
+            "DecodeJNITransitionOrLocalJObject");
+}
+
+TEST_F(JniMacroAssemblerRiscv64Test, TryToTransition) {
+  std::unique_ptr<JNIMacroLabel> slow_path = assembler_.CreateLabel();
+  assembler_.TryToTransitionFromRunnableToNative(slow_path.get(), {});
+  assembler_.TryToTransitionFromNativeToRunnable(slow_path.get(), {}, AsManaged(A0));
+  assembler_.Bind(slow_path.get());
+
+  std::string native_state_value =
+      std::to_string(Thread::StoredThreadStateValue(ThreadState::kNative));
+  int32_t held_mutex_offset =
+      Thread::HeldMutexOffset<kRiscv64PointerSize>(kMutatorLock).Int32Value();
+  int32_t mutator_lock_offset = Thread::MutatorLockOffset<kRiscv64PointerSize>().Int32Value();
+  DriverStr("1:\n"
+            "lr.w t6, (s1)\n"
+            "li t5, " + native_state_value + "\n"
+            "bne t6, zero, 3f\n"
+            "sc.w.rl t6, t5, (s1)\n"
+            "bne t6, zero, 1b\n" +
+            MemOp("sd", "zero", held_mutex_offset, "s1") +
+            "2:\n"
+            "lr.w.aq t6, (s1)\n"
+            "li t5, " + native_state_value + "\n"
+            "bne t6, t5, 3f\n"
+            "sc.w t6, zero, (s1)\n"
+            "bne t6, zero, 2b\n" +
+            MemOp("ld", "t6", mutator_lock_offset, "s1") +
+            MemOp("sd", "t6", held_mutex_offset, "s1") +
+            "3:\n",
+            "TryToTransition");
+}
+
+TEST_F(JniMacroAssemblerRiscv64Test, ChecksAndCalls) {
+  std::unique_ptr<JNIMacroLabel> suspend = assembler_.CreateLabel();
+  std::unique_ptr<JNIMacroLabel> exception = assembler_.CreateLabel();
+  assembler_.SuspendCheck(suspend.get());
+  assembler_.ExceptionPoll(exception.get());
+  assembler_.TestByteAndJumpIfNotZero(0x12345678u, suspend.get());
+  assembler_.Call(AsManaged(A1), Offset(16));
+  assembler_.CallFromThread(ThreadOffset64(256));
+  assembler_.Jump(AsManaged(A2), Offset(24));
+  assembler_.Bind(suspend.get());
+  assembler_.Bind(exception.get());
+  assembler_.DeliverPendingException();
+
+  int32_t flags_offset = Thread::ThreadFlagsOffset<kRiscv64PointerSize>().Int32Value();
+  int32_t exception_offset = Thread::ExceptionOffset<kRiscv64PointerSize>().Int32Value();
+  int32_t deliver_exception_offset =
+      QUICK_ENTRYPOINT_OFFSET(kRiscv64PointerSize, pDeliverException).Int32Value();
+  DriverStr(MemOp("lwu", "t6", flags_offset, "s1") +
+            "andi t6, t6, " + std::to_string(Thread::SuspendOrCheckpointRequestFlags()) + "\n"
+            "bne t6, zero, 1f\n" +
+            MemOp("ld", "t6", exception_offset, "s1") +
+            "bne t6, zero, 2f\n"
+            "li t6, 305419896\n"
+            "lb t6, 0(t6)\n"
+            "bne t6, zero, 1f\n"
+            "ld ra, 16(a1)\n"
+            "jalr ra, 0(ra)\n"
+            "ld ra, 256(s1)\n"
+            "jalr ra, 0(ra)\n"
+            "ld t6, 24(a2)\n"
+            "jalr zero, 0(t6)\n"
+            "1:\n"
+            "2:\n" +
+            MemOp("ld", "a0", exception_offset, "s1") +
+            MemOp("ld", "ra", deliver_exception_offset, "s1") +
+            "jalr ra, 0(ra)\n"
+            "ebreak\n",
+            "ChecksAndCalls");
+}
+
+}  // namespace riscv64
+}  // namespace art
@@ -532,6 +532,8 @@ class Dex2Oat final {
         passes_to_run_filename_(nullptr),
         dirty_image_objects_filename_(nullptr),
         dirty_image_objects_fd_(-1),
+        startup_image_objects_filename_(nullptr),
+        startup_image_objects_fd_(-1),
         is_host_(false),
         elf_writers_(),
         oat_writers_(),
@@ -840,6 +842,10 @@ class Dex2Oat final {
       Usage("--dirty-image-objects and --dirty-image-objects-fd should not be both specified");
     }
 
+    if (startup_image_objects_filename_ != nullptr && startup_image_objects_fd_ != -1) {
+      Usage("--startup-image-objects and --startup-image-objects-fd should not be both specified");
+    }
+
     if (!preloaded_classes_files_.empty() && !preloaded_classes_fds_.empty()) {
       Usage("--preloaded-classes and --preloaded-classes-fds should not be both specified");
     }
@@ -1108,6 +1114,8 @@ class Dex2Oat final {
     AssignIfExists(args, M::ClasspathDir, &classpath_dir_);
     AssignIfExists(args, M::DirtyImageObjects, &dirty_image_objects_filename_);
     AssignIfExists(args, M::DirtyImageObjectsFd, &dirty_image_objects_fd_);
+    AssignIfExists(args, M::StartupImageObjects, &startup_image_objects_filename_);
+    AssignIfExists(args, M::StartupImageObjectsFd, &startup_image_objects_fd_);
     AssignIfExists(args, M::ImageFormat, &image_storage_mode_);
     AssignIfExists(args, M::CompilationReason, &compilation_reason_);
     AssignTrueIfExists(args, M::CheckLinkageConditions, &check_linkage_conditions_);
@@ -1475,6 +1483,10 @@ class Dex2Oat final {
       return dex2oat::ReturnCode::kOther;
     }
 
+    if (!PrepareStartupObjects()) {
+      return dex2oat::ReturnCode::kOther;
+    }
+
     if (!PreparePreloadedClasses()) {
       return dex2oat::ReturnCode::kOther;
     }
@@ -2100,7 +2112,8 @@ class Dex2Oat final {
                                                   oat_filenames_,
                                                   dex_file_oat_index_map_,
                                                   class_loader,
-                                                  dirty_image_objects_.get()));
+                                                  dirty_image_objects_.get(),
+                                                  startup_image_objects_.get()));
 
       // We need to prepare method offsets in the image address space for resolving linker patches.
       TimingLogger::ScopedTiming t2("dex2oat Prepare image address space", timings_);
@@ -2577,6 +2590,32 @@ class Dex2Oat final {
     return true;
   }
 
+  bool PrepareStartupObjects() {
+    if (startup_image_objects_fd_ != -1) {
+      startup_image_objects_ = ReadCommentedInputFromFd<HashSet<std::string>>(
+          startup_image_objects_fd_,
+          nullptr);
+      // Close since we won't need it again.
+      close(startup_image_objects_fd_);
+      if (startup_image_objects_ == nullptr) {
+        LOG(ERROR) << "Failed to create list of startup objects from fd "
+            << startup_image_objects_fd_;
+        return false;
+      }
+      startup_image_objects_fd_ = -1;
+    } else if (startup_image_objects_filename_ != nullptr) {
+      startup_image_objects_ = ReadCommentedInputFromFile<HashSet<std::string>>(
+          startup_image_objects_filename_,
+          nullptr);
+      if (startup_image_objects_ == nullptr) {
+        LOG(ERROR) << "Failed to create list of startup objects from '"
+            << startup_image_objects_filename_ << "'";
+        return false;
+      }
+    }
+    return true;
+  }
+
   bool PreparePreloadedClasses() {
     if (!preloaded_classes_fds_.empty()) {
       for (int fd : preloaded_classes_fds_) {
@@ -2978,6 +3017,9 @@ class Dex2Oat final {
   const char* dirty_image_objects_filename_;
   int dirty_image_objects_fd_;
   std::unique_ptr<HashSet<std::string>> dirty_image_objects_;
+  const char* startup_image_objects_filename_;
+  int startup_image_objects_fd_;
+  std::unique_ptr<HashSet<std::string>> startup_image_objects_;
   std::unique_ptr<std::vector<std::string>> passes_to_run_;
   bool is_host_;
   std::string android_root_;
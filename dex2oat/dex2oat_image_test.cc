@@ -15,6 +15,7 @@
  */
 
 #include <fstream>
+#include <map>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -30,6 +31,7 @@
 
 #include "common_runtime_test.h"
 
+#include "art_field-inl.h"
 #include "base/array_ref.h"
 #include "base/file_utils.h"
 #include "base/macros.h"
@@ -42,7 +44,12 @@
 #include "dex/dex_file_loader.h"
 #include "dex/method_reference.h"
 #include "dex/type_reference.h"
+#include "dex/utf.h"
+#include "gc/accounting/space_bitmap-inl.h"
 #include "gc/space/image_space.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache-inl.h"
+#include "mirror/string-inl.h"
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
@@ -249,6 +256,282 @@ TEST_F(Dex2oatImageTest, TestModesAndFilters) {
   }
 }
 
+TEST_F(Dex2oatImageTest, TestStartupImageObjects) {
+  std::string error_msg;
+  MemMap reservation = ReserveCoreImageAddressSpace(&error_msg);
+  ASSERT_TRUE(reservation.IsValid()) << error_msg;
+
+  ScratchDir scratch;
+  const std::string& scratch_dir = scratch.GetPath();
+
+  // Copy the primary boot image dex files to a custom dir inside `scratch_dir` so that we do not
+  // accidentally load pre-compiled core images from their original directory based on BCP paths.
+  std::string jar_dir = scratch_dir + "jars";
+  int mkdir_result = mkdir(jar_dir.c_str(), 0700);
+  ASSERT_EQ(0, mkdir_result);
+  jar_dir += '/';
+  std::vector<std::string> libcore_dex_files = GetLibCoreDexFileNames();
+  // The primary image must contain at least core-oj and core-libart to initialize the runtime.
+  ASSERT_NE(std::string::npos, libcore_dex_files[0].find("core-oj"));
+  ASSERT_NE(std::string::npos, libcore_dex_files[1].find("core-libart"));
+  libcore_dex_files.resize(2u);
+  CopyDexFiles(jar_dir, &libcore_dex_files);
+  ArrayRef<const std::string> dex_files(libcore_dex_files);
+
+  // Prepare the directories for the images compiled without and with startup-image-objects.
+  const char* const kImageDirNames[] = { "unsorted", "sorted" };
+  std::string filename_prefixes[std::size(kImageDirNames)];
+  std::string image_locations[std::size(kImageDirNames)];
+  for (size_t i = 0; i != std::size(kImageDirNames); ++i) {
+    std::string dir = scratch_dir + kImageDirNames[i];
+    mkdir_result = mkdir(dir.c_str(), 0700);
+    ASSERT_EQ(0, mkdir_result);
+    dir += '/';
+    std::string image_dir = dir + GetInstructionSetString(kRuntimeISA);
+    mkdir_result = mkdir(image_dir.c_str(), 0700);
+    ASSERT_EQ(0, mkdir_result);
+    filename_prefixes[i] = image_dir + "/boot";
+    image_locations[i] = dir + "boot.art";
+  }
+
+  // Compile the image without startup-image-objects. The offsets in the startup-image-objects
+  // refer to this layout, which dex2oat calculates again before applying them.
+  ScratchFile profile_file;
+  GenerateBootProfile(dex_files,
+                      profile_file.GetFile(),
+                      /*method_frequency=*/ 5u,
+                      /*type_frequency=*/ 4u);
+  std::vector<std::string> extra_args;
+  extra_args.push_back("--profile-file=" + profile_file.GetFilename());
+  extra_args.push_back(android::base::StringPrintf("--base=0x%08x", kBaseAddress));
+  bool compile_ok = CompileBootImage(extra_args, filename_prefixes[0], dex_files, &error_msg);
+  ASSERT_TRUE(compile_ok) << error_msg;
+
+  std::vector<std::unique_ptr<gc::space::ImageSpace>> boot_image_spaces;
+  MemMap extra_reservation;
+  auto load = [&](const std::string& image_location) {
+    boot_image_spaces.clear();
+    extra_reservation = MemMap::Invalid();
+    ScopedObjectAccess soa(Thread::Current());
+    return gc::space::ImageSpace::LoadBootImage(/*boot_class_path=*/ libcore_dex_files,
+                                                /*boot_class_path_locations=*/ libcore_dex_files,
+                                                /*boot_class_path_fds=*/ std::vector<int>(),
+                                                /*boot_class_path_image_fds=*/ std::vector<int>(),
+                                                /*boot_class_path_vdex_fds=*/ std::vector<int>(),
+                                                /*boot_class_path_oat_fds=*/ std::vector<int>(),
+                                                { image_location },
+                                                kRuntimeISA,
+                                                /*relocate=*/ false,
+                                                /*executable=*/ true,
+                                                /*extra_reservation_size=*/ 0u,
+                                                /*allow_in_memory_compilation=*/ false,
+                                                &boot_image_spaces,
+                                                &extra_reservation);
+  };
+
+  // The dex caches of the loaded images are not registered with the class linker, so class
+  // descriptors are looked up in the dex files instead of using `Class::GetDescriptor()`.
+  std::vector<std::unique_ptr<const DexFile>> opened_dex_files;
+  for (const std::string& dex_file_name : libcore_dex_files) {
+    ArtDexFileLoader dex_file_loader(dex_file_name);
+    bool open_ok = dex_file_loader.Open(/*verify=*/ false,
+                                        /*verify_checksum=*/ false,
+                                        &error_msg,
+                                        &opened_dex_files);
+    ASSERT_TRUE(open_ok) << error_msg;
+  }
+  auto get_descriptor = [&](ObjPtr<mirror::Class> klass) REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::string location = klass->GetDexCache()->GetLocation()->ToModifiedUtf8();
+    for (const std::unique_ptr<const DexFile>& dex_file : opened_dex_files) {
+      if (dex_file->GetLocation() == location) {
+        return std::string(
+            dex_file->GetTypeDescriptor(dex_file->GetTypeId(klass->GetDexTypeIndex())));
+      }
+    }
+    ADD_FAILURE() << "Dex file not found: " << location;
+    return std::string();
+  };
+  // Visit the classes with fields and the strings with a unique value in an image component.
+  // Classes are identified by their descriptor and strings by their value.
+  auto visit_image_objects = [&](gc::space::ImageSpace* space,
+                                 auto&& class_visitor,
+                                 auto&& string_visitor) REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::map<std::string, size_t> string_counts;
+    space->GetLiveBitmap()->VisitAllMarked([&](mirror::Object* obj)
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      if (obj->IsString()) {
+        ++string_counts[obj->AsString()->ToModifiedUtf8()];
+      }
+    });
+    space->GetLiveBitmap()->VisitAllMarked([&](mirror::Object* obj)
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      if (obj->IsClass()) {
+        ObjPtr<mirror::Class> klass = obj->AsClass();
+        if (!klass->IsArrayClass() &&
+            !klass->IsPrimitive() &&
+            (klass->GetSFieldsPtr() != nullptr || klass->GetIFieldsPtr() != nullptr)) {
+          class_visitor(klass, get_descriptor(klass));
+        }
+      } else if (obj->IsString()) {
+        std::string value = obj->AsString()->ToModifiedUtf8();
+        if (string_counts[value] == 1u) {
+          string_visitor(obj->AsString(), value);
+        }
+      }
+    });
+  };
+
+  // Load the image and pick some classes and strings as startup objects. Give them first touch
+  // times in the reverse order of their offsets, so that the new order differs from the old one.
+  reservation = MemMap::Invalid();  // Free the reserved memory for loading images.
+  bool load_ok = load(image_locations[0]);
+  ASSERT_TRUE(load_ok);
+  ASSERT_EQ(dex_files.size(), boot_image_spaces.size());
+  constexpr size_t kNumStartupClasses = 16u;
+  constexpr size_t kNumStartupStrings = 16u;
+  std::vector<std::pair<std::string, uint32_t>> startup_classes;  // Descriptor and first touch.
+  std::vector<std::pair<std::string, uint32_t>> startup_strings;  // Value and first touch.
+  ScratchFile startup_objects;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    gc::space::ImageSpace* space = boot_image_spaces[0].get();
+    ASSERT_EQ(reinterpret_cast<uint8_t*>(static_cast<uintptr_t>(kBaseAddress)), space->Begin());
+    std::vector<std::pair<mirror::Object*, std::string>> classes;
+    std::vector<std::pair<mirror::Object*, std::string>> strings;
+    visit_image_objects(
+        space,
+        [&](ObjPtr<mirror::Class> klass, const std::string& descriptor)
+            REQUIRES_SHARED(Locks::mutator_lock_) {
+          classes.emplace_back(klass.Ptr(), descriptor);
+        },
+        [&](ObjPtr<mirror::String> string, const std::string& value)
+            REQUIRES_SHARED(Locks::mutator_lock_) {
+          strings.emplace_back(string.Ptr(), value);
+        });
+    ASSERT_GE(classes.size(), kNumStartupClasses);
+    ASSERT_GE(strings.size(), kNumStartupStrings);
+    auto add_startup_objects = [&](const std::vector<std::pair<mirror::Object*, std::string>>& objs,
+                                   size_t count,
+                                   bool is_class,
+                                   /*out*/ std::vector<std::pair<std::string, uint32_t>>* out) {
+      size_t step = objs.size() / count;
+      for (size_t i = 0; i != count; ++i) {
+        const auto& [obj, id] = objs[i * step];
+        uint32_t offset = dchecked_integral_cast<uint32_t>(
+            reinterpret_cast<uint8_t*>(obj) - space->Begin());
+        // The hash of the descriptor of the class itself, or of the class of the instance.
+        uint32_t descriptor_hash = ComputeModifiedUtf8Hash(
+            is_class ? std::string_view(id) : std::string_view("Ljava/lang/String;"));
+        uint32_t first_touch_ms = 10u * dchecked_integral_cast<uint32_t>(count - i);
+        WriteLine(startup_objects.GetFile(),
+                  android::base::StringPrintf("startup_obj: %u %s %u %u",
+                                              offset,
+                                              is_class ? "class" : "instance",
+                                              descriptor_hash,
+                                              first_touch_ms));
+        out->emplace_back(id, first_touch_ms);
+      }
+    };
+    add_startup_objects(classes, kNumStartupClasses, /*is_class=*/ true, &startup_classes);
+    add_startup_objects(strings, kNumStartupStrings, /*is_class=*/ false, &startup_strings);
+  }
+  boot_image_spaces.clear();
+
+  // Compile the image with startup-image-objects.
+  reservation = ReserveCoreImageAddressSpace(&error_msg);
+  ASSERT_TRUE(reservation.IsValid()) << error_msg;
+  extra_args.push_back("--startup-image-objects=" + startup_objects.GetFilename());
+  compile_ok = CompileBootImage(extra_args, filename_prefixes[1], dex_files, &error_msg);
+  ASSERT_TRUE(compile_ok) << error_msg;
+
+  // The new image must load.
+  reservation = MemMap::Invalid();
+  load_ok = load(image_locations[1]);
+  ASSERT_TRUE(load_ok);
+  ASSERT_EQ(dex_files.size(), boot_image_spaces.size());
+
+  // Check that the startup objects come first in their bins, in the order of the first touch.
+  // Classes are in one of the class bins based on their status, see
+  // `ImageWriter::AssignImageBinSlot()`, and their field arrays are in the ArtField bin in the
+  // order in which the classes are visited.
+  ScopedObjectAccess soa(Thread::Current());
+  auto get_class_bin = [](ObjPtr<mirror::Class> klass) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (!klass->IsVisiblyInitialized()) {
+      return 0u;  // Bin::kClassVerified.
+    }
+    for (uint32_t i = 0, num_fields = klass->NumStaticFields(); i != num_fields; ++i) {
+      if (!klass->GetStaticField(i)->IsFinal()) {
+        return 1u;  // Bin::kClassInitialized.
+      }
+    }
+    return 2u;  // Bin::kClassInitializedFinalStatics.
+  };
+  auto get_field_array = [](ObjPtr<mirror::Class> klass) REQUIRES_SHARED(Locks::mutator_lock_) {
+    // Static fields are recorded before instance fields.
+    return (klass->GetSFieldsPtr() != nullptr)
+        ? reinterpret_cast<uintptr_t>(klass->GetSFieldsPtr())
+        : reinterpret_cast<uintptr_t>(klass->GetIFieldsPtr());
+  };
+  struct ClassInfo {
+    uintptr_t address;
+    uint32_t bin;
+    uintptr_t field_array;
+  };
+  std::map<std::string, uint32_t> class_first_touch(startup_classes.begin(),
+                                                    startup_classes.end());
+  std::map<std::string, uint32_t> string_first_touch(startup_strings.begin(),
+                                                     startup_strings.end());
+  std::map<uint32_t, ClassInfo> found_classes;  // By first touch.
+  std::map<uint32_t, uintptr_t> found_strings;  // By first touch.
+  uintptr_t min_other_class[3] = { UINTPTR_MAX, UINTPTR_MAX, UINTPTR_MAX };
+  uintptr_t min_other_field_array = UINTPTR_MAX;
+  uintptr_t min_other_string = UINTPTR_MAX;
+  visit_image_objects(
+      boot_image_spaces[0].get(),
+      [&](ObjPtr<mirror::Class> klass, const std::string& descriptor)
+          REQUIRES_SHARED(Locks::mutator_lock_) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(klass.Ptr());
+        uint32_t bin = get_class_bin(klass);
+        uintptr_t field_array = get_field_array(klass);
+        auto it = class_first_touch.find(descriptor);
+        if (it != class_first_touch.end()) {
+          found_classes.emplace(it->second, ClassInfo{address, bin, field_array});
+        } else {
+          min_other_class[bin] = std::min(min_other_class[bin], address);
+          min_other_field_array = std::min(min_other_field_array, field_array);
+        }
+      },
+      [&](ObjPtr<mirror::String> string, const std::string& value)
+          REQUIRES_SHARED(Locks::mutator_lock_) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(string.Ptr());
+        auto it = string_first_touch.find(value);
+        if (it != string_first_touch.end()) {
+          found_strings.emplace(it->second, address);
+        } else {
+          min_other_string = std::min(min_other_string, address);
+        }
+      });
+  ASSERT_EQ(startup_classes.size(), found_classes.size());
+  ASSERT_EQ(startup_strings.size(), found_strings.size());
+
+  uintptr_t last_class[3] = { 0u, 0u, 0u };
+  uintptr_t last_field_array = 0u;
+  for (const auto& [first_touch_ms, info] : found_classes) {
+    EXPECT_LT(last_class[info.bin], info.address) << first_touch_ms;
+    EXPECT_LT(info.address, min_other_class[info.bin]) << first_touch_ms;
+    last_class[info.bin] = info.address;
+    EXPECT_LT(last_field_array, info.field_array) << first_touch_ms;
+    EXPECT_LT(info.field_array, min_other_field_array) << first_touch_ms;
+    last_field_array = info.field_array;
+  }
+  uintptr_t last_string = 0u;
+  for (const auto& [first_touch_ms, address] : found_strings) {
+    EXPECT_LT(last_string, address) << first_touch_ms;
+    EXPECT_LT(address, min_other_string) << first_touch_ms;
+    last_string = address;
+  }
+}
+
 TEST_F(Dex2oatImageTest, TestExtension) {
   std::string error_msg;
   MemMap reservation = ReserveCoreImageAddressSpace(&error_msg);
@@ -203,6 +203,17 @@ static void AddImageMappings(Builder& builder) {
           .WithHelp("Specify a file descriptor for reading the list of known dirty objects in\n"
                     "the image. The image writer will group them together")
           .IntoKey(M::DirtyImageObjectsFd)
+      .Define("--startup-image-objects=_")
+          .WithType<std::string>()
+          .WithHelp("list of objects touched during startup, in the format printed by imgdiag\n"
+                    "--dump-startup-objects. The image writer will lay them out in the order\n"
+                    "of first touch within each bin.")
+          .IntoKey(M::StartupImageObjects)
+      .Define("--startup-image-objects-fd=_")
+          .WithType<int>()
+          .WithHelp("Specify a file descriptor for reading the list of objects touched during\n"
+                    "startup.")
+          .IntoKey(M::StartupImageObjectsFd)
       .Define("--updatable-bcp-packages-file=_")
           .WithType<std::string>()
           .WithHelp("Deprecated. No longer takes effect.")
@@ -37,6 +37,7 @@
 #include "base/enums.h"
 #include "base/hash_set.h"
 #include "base/logging.h"  // For VLOG
+#include "base/scoped_arena_allocator.h"
 #include "base/stl_util.h"
 #include "base/string_view_cpp20.h"
 #include "base/systrace.h"
@@ -1828,6 +1829,19 @@ void CompilerDriver::Verify(jobject jclass_loader,
   ThreadPool* verify_thread_pool =
       force_determinism ? single_thread_pool_.get() : parallel_thread_pool_.get();
   size_t verify_thread_count = force_determinism ? 1U : parallel_thread_count_;
+
+  // Give each verifying thread its own arena stack, so that the method verifiers reuse the same
+  // arenas across methods and classes instead of going through the shared arena pool each time.
+  std::vector<Thread*> verify_threads = { Thread::Current() };
+  for (ThreadPoolWorker* worker : verify_thread_pool->GetWorkers()) {
+    verify_threads.push_back(worker->GetThread());
+  }
+  std::vector<std::unique_ptr<ArenaStack>> verifier_arena_stacks;
+  for (Thread* thread : verify_threads) {
+    verifier_arena_stacks.emplace_back(new ArenaStack(Runtime::Current()->GetArenaPool()));
+    thread->SetVerifierArenaStack(verifier_arena_stacks.back().get());
+  }
+
   for (const DexFile* dex_file : dex_files) {
     CHECK(dex_file != nullptr);
     VerifyDexFile(jclass_loader,
@@ -1838,6 +1852,11 @@ void CompilerDriver::Verify(jobject jclass_loader,
                   timings);
   }
 
+  for (Thread* thread : verify_threads) {
+    thread->SetVerifierArenaStack(nullptr);
+  }
+  verifier_arena_stacks.clear();
+
   if (main_verifier_deps != nullptr) {
     // Merge all VerifierDeps into the main one.
     for (ThreadPoolWorker* worker : parallel_thread_pool_->GetWorkers()) {
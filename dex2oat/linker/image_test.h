@@ -212,7 +212,8 @@ inline void ImageTest::DoCompile(ImageHeader::StorageMode storage_mode,
                                                       oat_filenames,
                                                       dex_file_to_oat_index_map,
                                                       /*class_loader=*/ nullptr,
-                                                      /*dirty_image_objects=*/ nullptr));
+                                                      /*dirty_image_objects=*/ nullptr,
+                                                      /*startup_image_objects=*/ nullptr));
   {
     {
       jobject class_loader = nullptr;
@@ -38,6 +38,16 @@ void ImageWriteReadTest::TestWriteRead(ImageHeader::StorageMode storage_mode,
     const auto& bitmap_section = image_header.GetImageBitmapSection();
     ASSERT_GE(bitmap_section.Offset(), sizeof(image_header));
     ASSERT_NE(0U, bitmap_section.Size());
+    if (storage_mode != ImageHeader::kStorageModeUncompressed) {
+      // Blocks end at multiples of the maximum block size, or at the end of the image.
+      std::vector<uint8_t> data(file->GetLength());
+      ASSERT_TRUE(file->PreadFully(data.data(), data.size(), /*offset=*/ 0));
+      for (const ImageHeader::Block& block : image_header.GetBlocks(data.data())) {
+        uint32_t block_end = block.GetImageOffset() + block.GetImageSize();
+        EXPECT_TRUE(block_end == image_header.GetImageSize() ||
+                    block_end % max_image_block_size == 0u) << block_end;
+      }
+    }
 
     gc::Heap* heap = Runtime::Current()->GetHeap();
     ASSERT_TRUE(heap->HaveContinuousSpaces());
@@ -156,5 +166,9 @@ TEST_F(ImageWriteReadTest, WriteReadLZ4HCKBBlock) {
   TestWriteRead(ImageHeader::kStorageModeLZ4HC, /*max_image_block_size=*/KB);
 }
 
+TEST_F(ImageWriteReadTest, WriteReadLZ4PageBlocks) {
+  TestWriteRead(ImageHeader::kStorageModeLZ4, /*max_image_block_size=*/4 * kPageSize);
+}
+
 }  // namespace linker
 }  // namespace art
@@ -22,6 +22,7 @@
 #include <zlib.h>
 
 #include <charconv>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <vector>
@@ -275,11 +276,12 @@ bool ImageWriter::PrepareImageAddressSpace(TimingLogger* timings) {
     ScopedObjectAccess soa(self);
     CalculateNewObjectOffsets();
 
-    // If dirty_image_objects_ is present - try optimizing object layout.
-    // It can only be done after the first CalculateNewObjectOffsets,
-    // because calculated offsets are used to match dirty objects between imgdiag and dex2oat.
-    if (compiler_options_.IsBootImage() && dirty_image_objects_ != nullptr) {
-      TryRecalculateOffsetsWithDirtyObjects();
+    // If dirty_image_objects_ or startup_image_objects_ is present - try optimizing object
+    // layout. It can only be done after the first CalculateNewObjectOffsets, because calculated
+    // offsets are used to match objects between imgdiag and dex2oat.
+    if (compiler_options_.IsBootImage() &&
+        (dirty_image_objects_ != nullptr || startup_image_objects_ != nullptr)) {
+      TryRecalculateOffsetsWithProfiledObjects();
     }
   }
 
@@ -1343,8 +1345,12 @@ class ImageWriter::LayoutHelper {
   void ProcessDexFileObjects(Thread* self) REQUIRES_SHARED(Locks::mutator_lock_);
   void ProcessRoots(Thread* self) REQUIRES_SHARED(Locks::mutator_lock_);
   void FinalizeInternTables() REQUIRES_SHARED(Locks::mutator_lock_);
-  // Recreate dirty object offsets (kKnownDirty bin) with objects sorted by sort_key.
-  void SortDirtyObjects(const HashMap<mirror::Object*, uint32_t>& dirty_objects, size_t oat_index)
+  // Recreate object offsets of the `bin` with objects sorted by sort_key. Objects without
+  // a sort_key in `sort_keys` use the `default_sort_key`.
+  void SortBinObjects(Bin bin,
+                      const HashMap<mirror::Object*, uint32_t>& sort_keys,
+                      uint32_t default_sort_key,
+                      size_t oat_index)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   void VerifyImageBinSlotsAssigned() REQUIRES_SHARED(Locks::mutator_lock_);
@@ -1431,6 +1437,21 @@ class ImageWriter::LayoutHelper::CollectClassesVisitor {
     std::sort(klasses_.begin(), klasses_.end());
 
     ImageWriter* image_writer = image_writer_;
+    const HashMap<mirror::Object*, uint32_t>& startup_objects = image_writer->startup_objects_;
+    if (!startup_objects.empty()) {
+      // Classes touched during startup go first, in the order of the first touch, so that
+      // their fields and methods are laid out next to each other in the native bins.
+      auto startup_key = [&](const ClassEntry& entry) REQUIRES_SHARED(Locks::mutator_lock_) {
+        auto it = startup_objects.find(entry.klass.Ptr());
+        return (it != startup_objects.end()) ? it->second : std::numeric_limits<uint32_t>::max();
+      };
+      std::stable_sort(klasses_.begin(),
+                       klasses_.end(),
+                       [&](const ClassEntry& lhs, const ClassEntry& rhs)
+                           REQUIRES_SHARED(Locks::mutator_lock_) {
+                         return startup_key(lhs) < startup_key(rhs);
+                       });
+    }
     WorkQueue work_queue;
     size_t last_dex_file_index = static_cast<size_t>(-1);
     size_t last_oat_index = static_cast<size_t>(-1);
@@ -1974,13 +1995,15 @@ void ImageWriter::LayoutHelper::ProcessWorkQueue() {
   }
 }
 
-void ImageWriter::LayoutHelper::SortDirtyObjects(
-    const HashMap<mirror::Object*, uint32_t>& dirty_objects, size_t oat_index) {
-  constexpr Bin bin = Bin::kKnownDirty;
+void ImageWriter::LayoutHelper::SortBinObjects(
+    Bin bin,
+    const HashMap<mirror::Object*, uint32_t>& sort_keys,
+    uint32_t default_sort_key,
+    size_t oat_index) {
   ImageInfo& image_info = image_writer_->GetImageInfo(oat_index);
 
-  dchecked_vector<mirror::Object*>& known_dirty = bin_objects_[oat_index][enum_cast<size_t>(bin)];
-  if (known_dirty.empty()) {
+  dchecked_vector<mirror::Object*>& bin_objects = bin_objects_[oat_index][enum_cast<size_t>(bin)];
+  if (bin_objects.empty()) {
     return;
   }
 
@@ -1989,12 +2012,12 @@ void ImageWriter::LayoutHelper::SortDirtyObjects(
   using CombinedKey = std::pair<uint32_t, uint32_t>;
   using ObjSortPair = std::pair<mirror::Object*, CombinedKey>;
   dchecked_vector<ObjSortPair> objects;
-  objects.reserve(known_dirty.size());
-  for (mirror::Object* obj : known_dirty) {
+  objects.reserve(bin_objects.size());
+  for (mirror::Object* obj : bin_objects) {
     const BinSlot bin_slot = image_writer_->GetImageBinSlot(obj, oat_index);
     const uint32_t original_offset = bin_slot.GetOffset();
-    const auto it = dirty_objects.find(obj);
-    const uint32_t sort_key = (it != dirty_objects.end()) ? it->second : 0;
+    const auto it = sort_keys.find(obj);
+    const uint32_t sort_key = (it != sort_keys.end()) ? it->second : default_sort_key;
     objects.emplace_back(obj, std::make_pair(sort_key, original_offset));
   }
   // Sort by combined sort_key.
@@ -2002,13 +2025,13 @@ void ImageWriter::LayoutHelper::SortDirtyObjects(
     return lhs.second < rhs.second;
   });
 
-  // Fill known_dirty objects in sorted order, update bin offsets.
-  known_dirty.clear();
+  // Fill bin objects in sorted order, update bin offsets.
+  bin_objects.clear();
   size_t offset = 0;
   for (const ObjSortPair& entry : objects) {
     mirror::Object* obj = entry.first;
 
-    known_dirty.push_back(obj);
+    bin_objects.push_back(obj);
     image_writer_->UpdateImageBinSlotOffset(obj, oat_index, offset);
 
     const size_t aligned_object_size = RoundUp(obj->SizeOf<kVerifyNone>(), kObjectAlignment);
@@ -2342,7 +2365,21 @@ void ImageWriter::CalculateNewObjectOffsets() {
   // Sort objects in dirty bin.
   if (!dirty_objects_.empty()) {
     for (size_t oat_index = 0; oat_index < image_infos_.size(); ++oat_index) {
-      layout_helper.SortDirtyObjects(dirty_objects_, oat_index);
+      layout_helper.SortBinObjects(Bin::kKnownDirty, dirty_objects_, 0u, oat_index);
+    }
+  }
+
+  // Move objects touched during startup to the start of their bins, in the order of first touch.
+  // Dirty objects keep the order from the dirty-image-objects.
+  if (!startup_objects_.empty()) {
+    for (size_t oat_index = 0; oat_index < image_infos_.size(); ++oat_index) {
+      for (size_t i = 0; i != enum_cast<size_t>(Bin::kMirrorCount); ++i) {
+        Bin bin = enum_cast<Bin>(i);
+        if (bin != Bin::kKnownDirty || dirty_objects_.empty()) {
+          layout_helper.SortBinObjects(
+              bin, startup_objects_, std::numeric_limits<uint32_t>::max(), oat_index);
+        }
+      }
     }
   }
 
@@ -2457,37 +2494,60 @@ void ImageWriter::ResetObjectOffsets() {
   saved_hashcode_map_.clear();
 }
 
-void ImageWriter::TryRecalculateOffsetsWithDirtyObjects() {
-  const std::optional<HashMap<uint32_t, ImageWriter::DirtyEntry>> dirty_entries =
-      ParseDirtyObjectOffsets(*dirty_image_objects_);
-  if (!dirty_entries || dirty_entries->empty()) {
-    return;
+void ImageWriter::TryRecalculateOffsetsWithProfiledObjects() {
+  // Both lists refer to the offsets of the current layout, match them before changing it.
+  bool recalculate = false;
+  if (dirty_image_objects_ != nullptr) {
+    recalculate |= TryMatchProfiledObjects(*dirty_image_objects_, "dirty_obj:", &dirty_objects_);
   }
-
-  std::optional<HashMap<mirror::Object*, uint32_t>> dirty_objects =
-      MatchDirtyObjectOffsets(*dirty_entries);
-  if (!dirty_objects || dirty_objects->empty()) {
+  if (startup_image_objects_ != nullptr) {
+    recalculate |=
+        TryMatchProfiledObjects(*startup_image_objects_, "startup_obj:", &startup_objects_);
+  }
+  if (!recalculate) {
     return;
   }
-  // Calculate offsets again, now with dirty object offsets.
-  LOG(INFO) << "Recalculating object offsets using dirty-image-objects";
-  dirty_objects_ = std::move(*dirty_objects);
+  // Calculate offsets again, now with dirty and startup object offsets.
+  LOG(INFO) << "Recalculating object offsets using"
+            << (dirty_objects_.empty() ? "" : " dirty-image-objects")
+            << (startup_objects_.empty() ? "" : " startup-image-objects");
   ResetObjectOffsets();
   CalculateNewObjectOffsets();
 }
 
+bool ImageWriter::TryMatchProfiledObjects(const HashSet<std::string>& image_objects,
+                                          std::string_view prefix,
+                                          /*out*/ HashMap<mirror::Object*, uint32_t>* objects) {
+  const std::optional<HashMap<uint32_t, ImageWriter::DirtyEntry>> entries =
+      ParseDirtyObjectOffsets(image_objects, prefix);
+  if (!entries || entries->empty()) {
+    return false;
+  }
+
+  std::optional<HashMap<mirror::Object*, uint32_t>> matched_objects =
+      MatchDirtyObjectOffsets(*entries);
+  if (!matched_objects || matched_objects->empty()) {
+    return false;
+  }
+  *objects = std::move(*matched_objects);
+  return true;
+}
+
 std::optional<HashMap<uint32_t, ImageWriter::DirtyEntry>> ImageWriter::ParseDirtyObjectOffsets(
-    const HashSet<std::string>& dirty_image_objects) REQUIRES_SHARED(Locks::mutator_lock_) {
+    const HashSet<std::string>& image_objects, std::string_view prefix)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
   HashMap<uint32_t, DirtyEntry> dirty_entries;
 
-  // Go through each dirty-image-object line, parse only lines of the format:
-  // "dirty_obj: <offset> <type> <descriptor_hash> <sort_key>"
+  // Go through each dirty-image-object or startup-image-object line, parse only lines of
+  // the format:
+  // "<prefix> <offset> <type> <descriptor_hash> <sort_key>"
+  // <prefix> -- "dirty_obj:" or "startup_obj:".
   // <offset> -- decimal uint32.
   // <type> -- "class" or "instance" (defines if descriptor is referring to a class or an instance).
   // <descriptor_hash> -- decimal uint32 (from DescriptorHash() method).
-  // <sort_key> -- decimal uint32 (defines order of the object inside the dirty bin).
-  const std::string prefix = "dirty_obj:";
-  for (const std::string& entry_str : dirty_image_objects) {
+  // <sort_key> -- decimal uint32 (defines order of the object inside the dirty bin, or the time
+  //               of the first touch in milliseconds for startup objects).
+  for (const std::string& entry_str : image_objects) {
     // Skip the lines of old dirty-image-object format.
     if (std::strncmp(entry_str.data(), prefix.data(), prefix.size()) != 0) {
       continue;
@@ -3589,7 +3649,8 @@ ImageWriter::ImageWriter(
     const std::vector<std::string>& oat_filenames,
     const HashMap<const DexFile*, size_t>& dex_file_oat_index_map,
     jobject class_loader,
-    const HashSet<std::string>* dirty_image_objects)
+    const HashSet<std::string>* dirty_image_objects,
+    const HashSet<std::string>* startup_image_objects)
     : compiler_options_(compiler_options),
       boot_image_begin_(Runtime::Current()->GetHeap()->GetBootImagesStartAddress()),
       boot_image_size_(Runtime::Current()->GetHeap()->GetBootImagesSize()),
@@ -3605,7 +3666,8 @@ ImageWriter::ImageWriter(
       image_storage_mode_(image_storage_mode),
       oat_filenames_(oat_filenames),
       dex_file_oat_index_map_(dex_file_oat_index_map),
-      dirty_image_objects_(dirty_image_objects) {
+      dirty_image_objects_(dirty_image_objects),
+      startup_image_objects_(startup_image_objects) {
   DCHECK(compiler_options.IsBootImage() ||
          compiler_options.IsBootImageExtension() ||
          compiler_options.IsAppImage());
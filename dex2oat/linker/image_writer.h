@@ -26,6 +26,7 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <string_view>
 
 #include "art_method.h"
 #include "base/bit_utils.h"
@@ -83,7 +84,8 @@ class ImageWriter final {
               const std::vector<std::string>& oat_filenames,
               const HashMap<const DexFile*, size_t>& dex_file_oat_index_map,
               jobject class_loader,
-              const HashSet<std::string>* dirty_image_objects);
+              const HashSet<std::string>* dirty_image_objects,
+              const HashSet<std::string>* startup_image_objects);
   ~ImageWriter();
 
   /*
@@ -453,19 +455,27 @@ class ImageWriter final {
       REQUIRES_SHARED(Locks::mutator_lock_);
   // Undo the changes of CalculateNewObjectOffsets.
   void ResetObjectOffsets() REQUIRES_SHARED(Locks::mutator_lock_);
-  // Reset and calculate new offsets with dirty objects optimization.
-  // Does nothing if dirty object offsets don't match with current offsets.
-  void TryRecalculateOffsetsWithDirtyObjects() REQUIRES_SHARED(Locks::mutator_lock_);
+  // Reset and calculate new offsets with dirty and startup objects optimizations.
+  // Does nothing if neither dirty nor startup object offsets match with current offsets.
+  void TryRecalculateOffsetsWithProfiledObjects() REQUIRES_SHARED(Locks::mutator_lock_);
+  // Parse and match the `prefix` lines of `image_objects` into `objects`.
+  // Returns false and leaves `objects` empty if the lines don't match current offsets.
+  bool TryMatchProfiledObjects(const HashSet<std::string>& image_objects,
+                               std::string_view prefix,
+                               /*out*/ HashMap<mirror::Object*, uint32_t>* objects)
+      REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Dirty object data from dirty-image-objects.
+  // Object data from dirty-image-objects or startup-image-objects.
   struct DirtyEntry {
     uint32_t descriptor_hash = 0;
     bool is_class = false;
     uint32_t sort_key = 0;
   };
-  // Parse dirty-image-objects into (offset->entry) map. Returns nullopt on parse error.
+  // Parse the `prefix` lines of dirty-image-objects or startup-image-objects into
+  // (offset->entry) map. Returns nullopt on parse error.
   static std::optional<HashMap<uint32_t, DirtyEntry>> ParseDirtyObjectOffsets(
-      const HashSet<std::string>& dirty_image_objects) REQUIRES_SHARED(Locks::mutator_lock_);
+      const HashSet<std::string>& image_objects, std::string_view prefix)
+      REQUIRES_SHARED(Locks::mutator_lock_);
   // Get all objects that match dirty_entries by offset. Returns nullopt if there is a mismatch.
   // Map values are sort_keys from DirtyEntry.
   std::optional<HashMap<mirror::Object*, uint32_t>> MatchDirtyObjectOffsets(
@@ -701,6 +711,14 @@ class ImageWriter final {
   // Dirty object instances and their sort keys parsed from dirty_image_object_
   HashMap<mirror::Object*, uint32_t> dirty_objects_;
 
+  // Objects touched during startup as offsets and descriptor hashes, with the time of the
+  // first touch as the sort key. Can be nullptr if there are none.
+  const HashSet<std::string>* startup_image_objects_;
+
+  // Startup object instances and their sort keys parsed from startup_image_objects_.
+  // Objects of each bin and classes with their native data are laid out in sort key order.
+  HashMap<mirror::Object*, uint32_t> startup_objects_;
+
   // Objects are guaranteed to not cross the region size boundary.
   size_t region_size_ = 0u;
 
@@ -384,6 +384,7 @@ OatWriter::OatWriter(const CompilerOptions& compiler_options,
       size_trampoline_alignment_(0),
       size_method_header_(0),
       size_code_(0),
+      size_code_in_profile_(0),
       size_code_alignment_(0),
       size_data_bimg_rel_ro_(0),
       size_data_bimg_rel_ro_alignment_(0),
@@ -966,19 +967,38 @@ struct OatWriter::OrderedMethodData {
     return debug_info_idx != kDebugInfoIdxInvalid;
   }
 
-  // Bin each method according to the profile flags.
+  // Bin each method according to the profile flags, so that the code executed during
+  // startup and the hot code are laid out densely at the start of the code section,
+  // followed by the rest of the profiled code. Methods that are not in the profile are
+  // assumed to be cold and are laid out last, so that they do not share pages with the
+  // hot code apart from the boundary page.
   //
-  // Groups by e.g.
-  //  -- not hot at all
-  //  -- hot
-  //  -- hot and startup
-  //  -- hot and post-startup
-  //  -- hot and startup and poststartup
-  //  -- startup
-  //  -- startup and post-startup
+  // Groups by
+  //  -- hot and startup (with or without post-startup)
+  //  -- startup (with or without post-startup)
+  //  -- hot (with or without post-startup)
   //  -- post-startup
+  //  -- not in the profile
   //
-  // (See MethodHotness enum definition for up-to-date binning order.)
+  // (See MethodHotness enum definition for the meaning of the flags.)
+  uint32_t GetCodeLayoutBin() const {
+    const bool hot = (hotness_bits & kHotBit) != 0u;
+    const bool startup = (hotness_bits & kStartupBit) != 0u;
+    if (startup) {
+      return hot ? 0u : 1u;
+    } else if (hot) {
+      return 2u;
+    } else if ((hotness_bits & kPostStartupBit) != 0u) {
+      return 3u;
+    } else {
+      return 4u;
+    }
+  }
+
+  bool IsInProfile() const {
+    return hotness_bits != 0u;
+  }
+
   bool operator<(const OrderedMethodData& other) const {
     if (kOatWriterForceOatCodeLayout) {
       // Development flag: Override default behavior by sorting by name.
@@ -989,13 +1009,18 @@ struct OatWriter::OrderedMethodData {
     }
 
     // Use the profile's method hotness to determine sort order.
-    if (hotness_bits < other.hotness_bits) {
+    if (GetCodeLayoutBin() < other.GetCodeLayoutBin()) {
       return true;
     }
 
     // Default: retain the original order.
     return false;
   }
+
+  // Flags for `hotness_bits`.
+  static constexpr uint32_t kHotBit = 1u;
+  static constexpr uint32_t kStartupBit = 2u;
+  static constexpr uint32_t kPostStartupBit = 4u;
 };
 
 // Given a queue of CompiledMethod in some total order,
@@ -1112,12 +1137,9 @@ class OatWriter::LayoutCodeMethodVisitor final : public OatDexMethodVisitor {
       if (profile_index_ != ProfileCompilationInfo::MaxProfileIndex()) {
         ProfileCompilationInfo* pci = writer_->profile_compilation_info_;
         DCHECK(pci != nullptr);
-        // Note: Bin-to-bin order does not matter. If the kernel does or does not read-ahead
-        // any memory, it only goes into the buffer cache and does not grow the PSS until the
-        // first time that memory is referenced in the process.
-        constexpr uint32_t kHotBit = 1u;
-        constexpr uint32_t kStartupBit = 2u;
-        constexpr uint32_t kPostStartupBit = 4u;
+        constexpr uint32_t kHotBit = OrderedMethodData::kHotBit;
+        constexpr uint32_t kStartupBit = OrderedMethodData::kStartupBit;
+        constexpr uint32_t kPostStartupBit = OrderedMethodData::kPostStartupBit;
         hotness_bits =
             (pci->IsHotMethod(profile_index_, method_index) ? kHotBit : 0u) |
             (pci->IsStartupMethod(profile_index_, method_index) ? kStartupBit : 0u) |
@@ -1824,6 +1846,9 @@ class OatWriter::WriteCodeMethodVisitor : public OrderedMethodVisitor {
         return false;
       }
       writer_->size_code_ += code_size;
+      if (method_data.IsInProfile()) {
+        writer_->size_code_in_profile_ += code_size;
+      }
       offset_ += code_size;
     }
     DCHECK_OFFSET_();
@@ -2687,6 +2712,10 @@ bool OatWriter::CheckOatSize(OutputStream* out, size_t file_offset, size_t relat
     DO_STAT(size_string_bss_mappings_);
     #undef DO_STAT
 
+    // Not part of the total, this is the part of `size_code_` laid out before the cold code.
+    VLOG(compiler) << "size_code_in_profile_=" << PrettySize(size_code_in_profile_)
+                   << " (" << size_code_in_profile_ << "B)";
+
     VLOG(compiler) << "size_total=" << PrettySize(size_total) << " (" << size_total << "B)";
 
     CHECK_EQ(vdex_size_ + oat_size_, size_total);
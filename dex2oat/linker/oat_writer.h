@@ -523,6 +523,7 @@ class OatWriter {
   uint32_t size_trampoline_alignment_;
   uint32_t size_method_header_;
   uint32_t size_code_;
+  uint32_t size_code_in_profile_;  // Included in `size_code_`.
   uint32_t size_code_alignment_;
   uint32_t size_data_bimg_rel_ro_;
   uint32_t size_data_bimg_rel_ro_alignment_;
@@ -17,12 +17,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <array>
 #include <functional>
+#include <limits>
 #include <map>
 #include <optional>
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -32,8 +35,11 @@
 #include "art_field-inl.h"
 #include "art_method-inl.h"
 #include "base/array_ref.h"
+#include "base/bit_utils.h"
+#include "base/casts.h"
 #include "base/os.h"
 #include "base/string_view_cpp20.h"
+#include "base/time_utils.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "gc/heap.h"
@@ -49,9 +55,11 @@
 #include "procinfo/process_map.h"
 #include "cmdline.h"
 
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 namespace art {
 
@@ -1111,17 +1119,27 @@ class ImgDiagDumper {
   explicit ImgDiagDumper(std::ostream* os,
                          pid_t image_diff_pid,
                          pid_t zygote_diff_pid,
-                         bool dump_dirty_objects)
+                         bool dump_dirty_objects,
+                         uint32_t startup_trace_ms,
+                         bool dump_startup_objects)
       : os_(os),
         image_diff_pid_(image_diff_pid),
         zygote_diff_pid_(zygote_diff_pid),
         dump_dirty_objects_(dump_dirty_objects),
-        zygote_pid_only_(false) {}
+        zygote_pid_only_(false),
+        startup_trace_ms_(startup_trace_ms),
+        dump_startup_objects_(dump_startup_objects) {}
 
   bool Init() {
     std::ostream& os = *os_;
 
-    if (image_diff_pid_ < 0 || zygote_diff_pid_ < 0) {
+    if (startup_trace_ms_ != 0u) {
+      // Startup tracing needs only one process that maps the boot image.
+      if (image_diff_pid_ < 0 && zygote_diff_pid_ < 0) {
+        os << "Either --image-diff-pid or --zygote-diff-pid must be specified.\n";
+        return false;
+      }
+    } else if (image_diff_pid_ < 0 || zygote_diff_pid_ < 0) {
       // TODO: ComputeDirtyBytes must be modified
       // to support single app/zygote to bootimage comparison
       os << "Both --image-diff-pid and --zygote-diff-pid must be specified.\n";
@@ -1236,7 +1254,10 @@ class ImgDiagDumper {
     os << "\n\n";
     PrintPidLine("ZYGOTE", zygote_diff_pid_);
     bool ret = true;
-    if (image_diff_pid_ >= 0 || zygote_diff_pid_ >= 0) {
+    if (startup_trace_ms_ != 0u) {
+      ret = DumpStartupPages(image_header, image_location);
+      os << "\n\n";
+    } else if (image_diff_pid_ >= 0 || zygote_diff_pid_ >= 0) {
       ret = DumpImageDiff(image_header, image_location);
       os << "\n\n";
     }
@@ -1246,6 +1267,92 @@ class ImgDiagDumper {
     return ret;
   }
 
+  // Mark the resident boot image pages of the image process idle, then poll the page idle
+  // bitmap and record when each page is first touched by any process, for example by an app
+  // started while tracing. Requires a kernel with CONFIG_IDLE_PAGE_TRACKING.
+  bool TraceStartupPages(const std::vector<gc::space::ImageSpace*>& image_spaces) {
+    std::ostream& os = *os_;
+    CHECK_NE(startup_trace_ms_, 0u);
+
+    std::unique_ptr<File> page_idle_file(
+        OS::OpenFileWithFlags(kPageIdleBitmapPath, O_RDWR, /*auto_flush=*/ false));
+    if (page_idle_file == nullptr) {
+      os << "Failed to open " << kPageIdleBitmapPath << " for reading and writing";
+      return false;
+    }
+
+    // Page frames of the resident image pages, grouped by words of the page idle bitmap.
+    std::map<uint64_t, uint64_t> idle_bitmap_words;
+    std::unordered_map<uint64_t, size_t> virtual_page_indexes;
+    for (gc::space::ImageSpace* image_space : image_spaces) {
+      std::optional<android::procinfo::MapInfo> boot_map =
+          FindBootMap(image_proc_maps_, image_space->GetImageLocation(), "image");
+      if (!boot_map) {
+        return false;
+      }
+      size_t begin_page = boot_map->start / kPageSize;
+      size_t num_pages =
+          RoundUp(image_space->GetImageHeader().GetImageSize(), kPageSize) / kPageSize;
+      std::vector<uint64_t> page_map_entries(num_pages);
+      if (!image_pagemap_file_.PreadFully(page_map_entries.data(),
+                                          num_pages * kPageMapEntrySize,
+                                          begin_page * kPageMapEntrySize)) {
+        os << "Failed to read the virtual page index entries from "
+           << image_pagemap_file_.GetPath() << ", error: " << strerror(errno);
+        return false;
+      }
+      for (size_t i = 0; i != num_pages; ++i) {
+        // Pages that are not resident have no page frame that we could trace.
+        if ((page_map_entries[i] & kPageMapEntryPresentMask) == 0u) {
+          continue;
+        }
+        uint64_t page_frame_number = page_map_entries[i] & kPageFrameNumberMask;
+        idle_bitmap_words[page_frame_number / kBitsPerIdleBitmapWord] |=
+            UINT64_C(1) << (page_frame_number % kBitsPerIdleBitmapWord);
+        virtual_page_indexes.emplace(page_frame_number, begin_page + i);
+        startup_pages_.emplace(begin_page + i, kNotTouched);
+      }
+    }
+
+    for (const auto& [word_index, bits] : idle_bitmap_words) {
+      if (!page_idle_file->PwriteFully(&bits, sizeof(bits), word_index * sizeof(uint64_t))) {
+        os << "Failed to mark pages idle in " << kPageIdleBitmapPath << ", error: "
+           << strerror(errno);
+        return false;
+      }
+    }
+
+    os << "Tracing " << startup_pages_.size() << " resident image pages for "
+       << startup_trace_ms_ << " ms, start the app now.\n" << std::flush;
+    const uint64_t start_ms = MilliTime();
+    uint64_t elapsed_ms;
+    do {
+      usleep(kStartupTraceIntervalMs * 1000u);
+      elapsed_ms = MilliTime() - start_ms;
+      for (auto& [word_index, idle_bits] : idle_bitmap_words) {
+        if (idle_bits == 0u) {
+          continue;
+        }
+        // A page that was accessed since it was marked idle reads as not idle.
+        uint64_t bits;
+        if (!page_idle_file->PreadFully(&bits, sizeof(bits), word_index * sizeof(uint64_t))) {
+          os << "Failed to read " << kPageIdleBitmapPath << ", error: " << strerror(errno);
+          return false;
+        }
+        for (uint64_t touched_bits = idle_bits & ~bits;
+             touched_bits != 0u;
+             touched_bits &= touched_bits - 1u) {
+          uint64_t page_frame_number = word_index * kBitsPerIdleBitmapWord + CTZ(touched_bits);
+          startup_pages_[virtual_page_indexes[page_frame_number]] =
+              dchecked_integral_cast<uint32_t>(elapsed_ms);
+        }
+        idle_bits &= bits;
+      }
+    } while (elapsed_ms < startup_trace_ms_);
+
+    return true;
+  }
+
  private:
   bool DumpImageDiff(const ImageHeader& image_header, const std::string& image_location)
       REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -1359,38 +1466,39 @@ class ImgDiagDumper {
     os << "\n";
   }
 
+  // Find the memory map for a boot image component.
+  std::optional<android::procinfo::MapInfo> FindBootMap(
+      const std::vector<android::procinfo::MapInfo>& maps,
+      const std::string& image_location,
+      const char* tag) {
+    std::string image_location_base_name = GetImageLocationBaseName(image_location);
+    for (const android::procinfo::MapInfo& map_info : maps) {
+      // The map name ends with ']' if it's an anonymous memmap. We need to special case that
+      // to find the boot image map in some cases.
+      if (EndsWith(map_info.name, image_location_base_name) ||
+          EndsWith(map_info.name, image_location_base_name + "]")) {
+        if ((map_info.flags & PROT_WRITE) != 0) {
+          return map_info;
+        }
+        // In actuality there's more than 1 map, but the second one is read-only.
+        // The one we care about is the write-able map.
+        // The readonly maps are guaranteed to be identical, so its not interesting to compare
+        // them.
+      }
+    }
+    *os_ << "Could not find map for " << image_location_base_name << " in " << tag;
+    return std::nullopt;
+  }
+
   // Look at /proc/$pid/mem and only diff the things from there
   bool DumpImageDiffMap(const ImageHeader& image_header, const std::string& image_location)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     std::ostream& os = *os_;
     std::string error_msg;
 
-    std::string image_location_base_name = GetImageLocationBaseName(image_location);
-    auto find_boot_map = [&os, &image_location_base_name](
-                             const std::vector<android::procinfo::MapInfo>& maps,
-                             const char* tag) -> std::optional<android::procinfo::MapInfo> {
-      // Find the memory map for the current boot image component.
-      for (const android::procinfo::MapInfo& map_info : maps) {
-        // The map name ends with ']' if it's an anonymous memmap. We need to special case that
-        // to find the boot image map in some cases.
-        if (EndsWith(map_info.name, image_location_base_name) ||
-            EndsWith(map_info.name, image_location_base_name + "]")) {
-          if ((map_info.flags & PROT_WRITE) != 0) {
-            return map_info;
-          }
-          // In actuality there's more than 1 map, but the second one is read-only.
-          // The one we care about is the write-able map.
-          // The readonly maps are guaranteed to be identical, so its not interesting to compare
-          // them.
-        }
-      }
-      os << "Could not find map for " << image_location_base_name << " in " << tag;
-      return std::nullopt;
-    };
-
     // Find the current boot image mapping.
     std::optional<android::procinfo::MapInfo> maybe_boot_map =
-        find_boot_map(image_proc_maps_, "image");
+        FindBootMap(image_proc_maps_, image_location, "image");
     if (!maybe_boot_map) {
       return false;
     }
@@ -1407,7 +1515,7 @@ class ImgDiagDumper {
     // If zygote_diff_pid_ != -1, check that the zygote boot map is the same.
     if (zygote_diff_pid_ != -1) {
       std::optional<android::procinfo::MapInfo> maybe_zygote_boot_map =
-          find_boot_map(zygote_proc_maps_, "zygote");
+          FindBootMap(zygote_proc_maps_, image_location, "zygote");
       if (!maybe_zygote_boot_map) {
         return false;
       }
@@ -1548,6 +1656,128 @@ class ImgDiagDumper {
     return true;
   }
 
+  // Report the pages of the image touched while tracing startup, and optionally the objects
+  // on them in the format of the dex2oat --startup-image-objects list.
+  bool DumpStartupPages(const ImageHeader& image_header, const std::string& image_location)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::ostream& os = *os_;
+    std::optional<android::procinfo::MapInfo> boot_map =
+        FindBootMap(image_proc_maps_, image_location, "image");
+    if (!boot_map) {
+      return false;
+    }
+    const size_t begin_page = boot_map->start / kPageSize;
+    const size_t num_pages = RoundUp(image_header.GetImageSize(), kPageSize) / kPageSize;
+    // Returns the time of the first touch of the page at `page_offset` in the image.
+    auto first_touch = [&](size_t page_offset) {
+      auto it = startup_pages_.find(begin_page + page_offset / kPageSize);
+      return (it != startup_pages_.end()) ? it->second : kNotTouched;
+    };
+
+    size_t traced_pages = 0u;
+    size_t touched_pages = 0u;
+    std::array<size_t, ImageHeader::kSectionCount> touched_pages_for_section = {};
+    for (size_t offset = 0; offset != num_pages * kPageSize; offset += kPageSize) {
+      if (startup_pages_.find(begin_page + offset / kPageSize) == startup_pages_.end()) {
+        continue;
+      }
+      ++traced_pages;
+      if (first_touch(offset) != kNotTouched) {
+        ++touched_pages;
+        for (size_t i = 0; i < ImageHeader::kSectionCount; ++i) {
+          const ImageHeader::ImageSections section = static_cast<ImageHeader::ImageSections>(i);
+          if (image_header.GetImageSection(section).Contains(offset)) {
+            touched_pages_for_section[i] += 1;
+          }
+        }
+      }
+    }
+    os << "Startup trace of " << startup_trace_ms_ << " ms:\n  "
+       << num_pages << " pages in the image,\n  "
+       << traced_pages << " pages were resident and traced,\n  "
+       << touched_pages << " pages were touched;\n  "
+       << "\n";
+    os << "Image sections (total touched pages " << touched_pages << ")\n";
+    for (size_t i = 0; i < ImageHeader::kSectionCount; ++i) {
+      const ImageHeader::ImageSections section = static_cast<ImageHeader::ImageSections>(i);
+      os << section << " " << image_header.GetImageSection(section)
+         << " touched pages=" << touched_pages_for_section[i] << "\n";
+    }
+    os << "\n";
+
+    if (!dump_startup_objects_) {
+      return true;
+    }
+    // Returns the first touch of the pages spanned by an entry at `offset` in the image.
+    auto entry_first_touch = [&](size_t offset, size_t size) {
+      uint32_t result = kNotTouched;
+      for (size_t page_offset = AlignDown(offset, kPageSize);
+           page_offset < offset + size;
+           page_offset += kPageSize) {
+        result = std::min(result, first_touch(page_offset));
+      }
+      return result;
+    };
+    uint8_t* image_begin = const_cast<uint8_t*>(image_header.GetImageBegin());
+    PointerSize pointer_size = InstructionSetPointerSize(Runtime::Current()->GetInstructionSet());
+    const std::set<size_t> no_dirty_pages;
+    std::map<mirror::Object*, uint32_t> startup_objects;
+    ImgObjectVisitor object_visitor(
+        [&](mirror::Object* object,
+            const uint8_t* begin_image_ptr,
+            const std::set<size_t>& dirty_pages ATTRIBUTE_UNUSED)
+            REQUIRES_SHARED(Locks::mutator_lock_) {
+          size_t offset = reinterpret_cast<uint8_t*>(object) - begin_image_ptr;
+          uint32_t touch = entry_first_touch(offset, object->SizeOf());
+          if (touch != kNotTouched) {
+            startup_objects.emplace(object, touch);
+          }
+        },
+        image_begin,
+        no_dirty_pages);
+    image_header.VisitObjects(&object_visitor, image_begin, pointer_size);
+    // dex2oat lays out ArtMethods with their declaring classes, so order the classes by the
+    // first touch of their methods as well.
+    ImgArtMethodVisitor method_visitor(
+        [&](ArtMethod* method,
+            const uint8_t* begin_image_ptr,
+            const std::set<size_t>& dirty_pages ATTRIBUTE_UNUSED)
+            REQUIRES_SHARED(Locks::mutator_lock_) {
+          size_t offset = reinterpret_cast<uint8_t*>(method) - begin_image_ptr;
+          uint32_t touch = entry_first_touch(offset, ArtMethod::Size(pointer_size));
+          mirror::Class* klass = method->GetDeclaringClassUnchecked<kWithoutReadBarrier>().Ptr();
+          if (touch == kNotTouched ||
+              klass == nullptr ||
+              !image_header.GetObjectsSection().Contains(
+                  reinterpret_cast<uint8_t*>(klass) - begin_image_ptr)) {
+            return;
+          }
+          auto [it, inserted] = startup_objects.emplace(klass, touch);
+          if (!inserted) {
+            it->second = std::min(it->second, touch);
+          }
+        },
+        image_begin,
+        no_dirty_pages);
+    image_header.VisitPackedArtMethods(method_visitor, image_begin, pointer_size);
+
+    // The offsets are relative to the first boot image component, like in dex2oat.
+    const uint8_t* boot_image_begin =
+        Runtime::Current()->GetHeap()->GetBootImageSpaces().front()->Begin();
+    os << startup_objects.size() << " objects on touched pages:\n";
+    for (const auto& [object, touch] : startup_objects) {
+      size_t offset = reinterpret_cast<uint8_t*>(object) - boot_image_begin;
+      if (object->IsClass()) {
+        os << "startup_obj: " << offset << " class " << object->AsClass()->DescriptorHash()
+           << " " << touch << "\n";
+      } else {
+        os << "startup_obj: " << offset << " instance " << object->GetClass()->DescriptorHash()
+           << " " << touch << "\n";
+      }
+    }
+    return true;
+  }
+
   // Note: On failure, `*page_frame_number` shall be clobbered.
   static bool GetPageFrameNumber(File* page_map_file,
                                  size_t virtual_page_index,
@@ -1718,6 +1948,8 @@ class ImgDiagDumper {
   }
 
   static constexpr size_t kPageMapEntrySize = sizeof(uint64_t);
+  // bit 63 [in /proc/$pid/pagemap]
+  static constexpr uint64_t kPageMapEntryPresentMask = (1ULL << 63);
   // bits 0-54 [in /proc/$pid/pagemap]
   static constexpr uint64_t kPageFrameNumberMask = (1ULL << 55) - 1;
 
@@ -1727,12 +1959,23 @@ class ImgDiagDumper {
   static constexpr uint64_t kPageFlagsNoPageMask = (1ULL << 20);  // in /proc/kpageflags
   static constexpr uint64_t kPageFlagsMmapMask = (1ULL << 11);  // in /proc/kpageflags
 
+  // See https://www.kernel.org/doc/Documentation/admin-guide/mm/idle_page_tracking.rst
+  static constexpr const char* kPageIdleBitmapPath = "/sys/kernel/mm/page_idle/bitmap";
+  static constexpr size_t kBitsPerIdleBitmapWord = BitSizeOf<uint64_t>();
+  static constexpr uint32_t kStartupTraceIntervalMs = 10u;
+  static constexpr uint32_t kNotTouched = std::numeric_limits<uint32_t>::max();
 
   std::ostream* os_;
   pid_t image_diff_pid_;  // Dump image diff against boot.art if pid is non-negative
   pid_t zygote_diff_pid_;  // Dump image diff against zygote boot.art if pid is non-negative
   bool dump_dirty_objects_;  // Adds dumping of objects that are dirty.
   bool zygote_pid_only_;  // The user only specified a pid for the zygote.
+  uint32_t startup_trace_ms_;  // Trace the image pages touched during startup if non-zero.
+  bool dump_startup_objects_;  // Adds dumping of objects on pages touched during startup.
+
+  // Time of the first touch in ms of the image pages traced by TraceStartupPages(),
+  // or kNotTouched. Indexed by the virtual page index in the image process.
+  std::unordered_map<size_t, uint32_t> startup_pages_;
 
   // Used for finding the memory mapping of the image file.
   std::vector<android::procinfo::MapInfo> image_proc_maps_;
@@ -1760,7 +2003,9 @@ static int DumpImage(Runtime* runtime,
                      std::ostream* os,
                      pid_t image_diff_pid,
                      pid_t zygote_diff_pid,
-                     bool dump_dirty_objects) {
+                     bool dump_dirty_objects,
+                     uint32_t startup_trace_ms,
+                     bool dump_startup_objects) {
   ScopedObjectAccess soa(Thread::Current());
   gc::Heap* heap = runtime->GetHeap();
   const std::vector<gc::space::ImageSpace*>& image_spaces = heap->GetBootImageSpaces();
@@ -1768,10 +2013,15 @@ static int DumpImage(Runtime* runtime,
   ImgDiagDumper img_diag_dumper(os,
                                 image_diff_pid,
                                 zygote_diff_pid,
-                                dump_dirty_objects);
+                                dump_dirty_objects,
+                                startup_trace_ms,
+                                dump_startup_objects);
   if (!img_diag_dumper.Init()) {
     return EXIT_FAILURE;
   }
+  if (startup_trace_ms != 0u && !img_diag_dumper.TraceStartupPages(image_spaces)) {
+    return EXIT_FAILURE;
+  }
   for (gc::space::ImageSpace* image_space : image_spaces) {
     const ImageHeader& image_header = image_space->GetImageHeader();
     if (!image_header.IsValid()) {
@@ -1818,6 +2068,16 @@ struct ImgDiagArgs : public CmdlineArgs {
       }
     } else if (option == "--dump-dirty-objects") {
       dump_dirty_objects_ = true;
+    } else if (StartsWith(option, "--startup-trace-ms=")) {
+      const char* startup_trace_ms = raw_option + strlen("--startup-trace-ms=");
+
+      if (!android::base::ParseUint(startup_trace_ms, &startup_trace_ms_) ||
+          startup_trace_ms_ == 0u) {
+        *error_msg = "Startup trace duration out of range";
+        return kParseError;
+      }
+    } else if (option == "--dump-startup-objects") {
+      dump_startup_objects_ = true;
     } else {
       return kParseUnknownArgument;
     }
@@ -1871,6 +2131,12 @@ struct ImgDiagArgs : public CmdlineArgs {
         "against.\n"
         "      Example: --zygote-diff-pid=$(pid zygote)\n"
         "  --dump-dirty-objects: additionally output dirty objects of interest.\n"
+        "  --startup-trace-ms=<ms>: instead of diffing, mark the resident boot image pages of\n"
+        "      the process idle and report the pages touched in the next <ms> milliseconds.\n"
+        "      Start the app to measure right after imgdiag prints that it is tracing.\n"
+        "      Example: --zygote-diff-pid=$(pid zygote64) --startup-trace-ms=5000\n"
+        "  --dump-startup-objects: with --startup-trace-ms, additionally output the objects on\n"
+        "      touched pages for the dex2oat --startup-image-objects list.\n"
         "\n";
 
     return usage;
@@ -1880,6 +2146,8 @@ struct ImgDiagArgs : public CmdlineArgs {
   pid_t image_diff_pid_ = -1;
   pid_t zygote_diff_pid_ = -1;
   bool dump_dirty_objects_ = false;
+  uint32_t startup_trace_ms_ = 0u;
+  bool dump_startup_objects_ = false;
 };
 
 struct ImgDiagMain : public CmdlineMain<ImgDiagArgs> {
@@ -1890,7 +2158,9 @@ struct ImgDiagMain : public CmdlineMain<ImgDiagArgs> {
                      args_->os_,
                      args_->image_diff_pid_,
                      args_->zygote_diff_pid_,
-                     args_->dump_dirty_objects_) == EXIT_SUCCESS;
+                     args_->dump_dirty_objects_,
+                     args_->startup_trace_ms_,
+                     args_->dump_startup_objects_) == EXIT_SUCCESS;
   }
 };
 
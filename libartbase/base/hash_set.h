@@ -672,6 +672,13 @@ class HashSet {
     return num_buckets_;
   }
 
+  // The bucket array, with `NumBuckets()` elements. Elements are found by linear probing from
+  // index `hash % NumBuckets()` until an empty bucket. Used for lookups without locking by users
+  // that keep replaced bucket arrays alive until no such lookup can use them anymore.
+  const T* GetBuckets() const {
+    return data_;
+  }
+
  private:
   T& ElementForIndex(size_t index) {
     DCHECK_LT(index, NumBuckets());
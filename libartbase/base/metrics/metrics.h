@@ -67,7 +67,13 @@
   METRIC(YoungGcDuration, MetricsCounter)                           \
   METRIC(FullGcScannedBytes, MetricsCounter)                        \
   METRIC(FullGcFreedBytes, MetricsCounter)                          \
-  METRIC(FullGcDuration, MetricsCounter)
+  METRIC(FullGcDuration, MetricsCounter)                            \
+  METRIC(JitCompileRequestsCoalesced, MetricsCounter)               \
+  METRIC(JitCompileRequestsUpgraded, MetricsCounter)                \
+  METRIC(JitCompileTasksDropped, MetricsCounter)                    \
+  METRIC(JitOsrQueueLatency, MetricsHistogram, 15, 0, 750)          \
+  METRIC(JitOptimizedQueueLatency, MetricsHistogram, 15, 0, 750)    \
+  METRIC(JitBaselineQueueLatency, MetricsHistogram, 15, 0, 750)
 
 // Increasing counter metrics, reported as Value Metrics in delta increments.
 #define ART_VALUE_METRICS(METRIC)                              \
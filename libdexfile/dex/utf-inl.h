@@ -71,6 +71,23 @@ inline uint32_t GetUtf16FromUtf8(const char** utf8_data_in) {
 
 inline int CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues(const char* utf8_1,
                                                                    const char* utf8_2) {
+  // Skip the common prefix without decoding it, as equal bytes decode to equal code points.
+  // The strings are only NUL-terminated, so wide loads could read past their ends and trip
+  // memory tagging and sanitizers; comparing single bytes is still much cheaper than decoding.
+  const char* const start_1 = utf8_1;
+  while (*utf8_1 == *utf8_2 && *utf8_1 != '\0') {
+    ++utf8_1;
+    ++utf8_2;
+  }
+  // Back up to the start of the sequence containing the first difference.
+  auto is_continuation = [](char c) ALWAYS_INLINE {
+    return (static_cast<uint8_t>(c) & 0xc0u) == 0x80u;
+  };
+  while (utf8_1 != start_1 && (is_continuation(*utf8_1) || is_continuation(*utf8_2))) {
+    --utf8_1;
+    --utf8_2;
+  }
+
   uint32_t c1, c2;
   do {
     c1 = *utf8_1;
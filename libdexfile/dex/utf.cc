@@ -20,6 +20,15 @@
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 
+#include <array>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "base/bit_utils.h"
 #include "base/casts.h"
 #include "utf-inl.h"
 
@@ -27,6 +36,194 @@ namespace art {
 
 using android::base::StringAppendF;
 
+namespace {
+
+// Almost all of the strings in dex files (descriptors, member names, shorty strings) are ASCII.
+// The helpers below process runs of ASCII bytes and compute hashes a vector at a time, using
+// the instructions available in the baseline for the target (SSE2 on x86, NEON on arm64, and
+// SSE4.1 or AVX2 when the compiler is told they are available). There is no runtime dispatch.
+// All loads stay within the bounds given by the caller.
+
+// Returns the number of leading ASCII bytes in `utf8[0, byte_count)`.
+ALWAYS_INLINE inline size_t CountLeadingAsciiBytes(const char* utf8, size_t byte_count) {
+  size_t i = 0u;
+#if defined(__AVX2__)
+  for (; i + 32u <= byte_count; i += 32u) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(utf8 + i));
+    uint32_t non_ascii = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+    if (non_ascii != 0u) {
+      return i + CTZ(non_ascii);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 16u <= byte_count; i += 16u) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+    uint32_t non_ascii = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+    if (non_ascii != 0u) {
+      return i + CTZ(non_ascii);
+    }
+  }
+#elif defined(__aarch64__)
+  for (; i + 16u <= byte_count; i += 16u) {
+    uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(utf8 + i));
+    if (vmaxvq_u8(bytes) >= 0x80u) {
+      break;  // Find the exact position below.
+    }
+  }
+#else
+  for (; i + sizeof(uint64_t) <= byte_count; i += sizeof(uint64_t)) {
+    uint64_t bytes;
+    memcpy(&bytes, utf8 + i, sizeof(bytes));
+    if ((bytes & UINT64_C(0x8080808080808080)) != 0u) {
+      break;  // Find the exact position below.
+    }
+  }
+#endif
+  while (i != byte_count && (static_cast<uint8_t>(utf8[i]) & 0x80u) == 0u) {
+    ++i;
+  }
+  return i;
+}
+
+// Converts the leading ASCII bytes of `utf8[0, byte_count)` to UTF-16 and returns their number.
+ALWAYS_INLINE inline size_t ConvertLeadingAsciiToUtf16(uint16_t* utf16_out,
+                                                       const char* utf8,
+                                                       size_t byte_count) {
+  size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16u <= byte_count; i += 16u) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16_out + i), _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16_out + i + 8u),
+                     _mm_unpackhi_epi8(bytes, zero));
+  }
+#elif defined(__aarch64__)
+  for (; i + 16u <= byte_count; i += 16u) {
+    uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(utf8 + i));
+    if (vmaxvq_u8(bytes) >= 0x80u) {
+      break;
+    }
+    vst1q_u16(utf16_out + i, vmovl_u8(vget_low_u8(bytes)));
+    vst1q_u16(utf16_out + i + 8u, vmovl_high_u8(bytes));
+  }
+#endif
+  for (; i != byte_count && (static_cast<uint8_t>(utf8[i]) & 0x80u) == 0u; ++i) {
+    utf16_out[i] = static_cast<uint8_t>(utf8[i]);
+  }
+  return i;
+}
+
+// Returns `[31^(n-1), ..., 31^1, 31^0]`, the factors of the bytes of an n-byte block in
+// `hash * 31 + c` hashes.
+template <size_t n>
+constexpr std::array<uint32_t, n> DescendingPowersOf31() {
+  std::array<uint32_t, n> powers = {};
+  uint32_t power = 1u;
+  for (size_t i = n; i != 0u; --i) {
+    powers[i - 1u] = power;
+    power *= 31u;
+  }
+  return powers;
+}
+
+template <size_t n>
+constexpr uint32_t PowerOf31() {
+  return DescendingPowersOf31<n + 1u>()[0];
+}
+
+// Whether `UpdateHash()` processes whole blocks with vector instructions. 32-bit vector
+// multiplication needs at least SSE4.1 on x86.
+#if defined(__SSE4_1__) || defined(__aarch64__)
+constexpr bool kUseVectorHash = true;
+#else
+constexpr bool kUseVectorHash = false;
+#endif
+
+#if defined(__SSE4_1__)
+ALWAYS_INLINE inline uint32_t HorizontalSum(__m128i values) {
+  values = _mm_add_epi32(values, _mm_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2)));
+  values = _mm_add_epi32(values, _mm_shuffle_epi32(values, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(values));
+}
+#endif
+
+// Equivalent to calling `UpdateModifiedUtf8Hash(hash, c)` for each byte `c` of `data[0, size)`.
+//
+// The hash of a block of bytes `c[0..n)` following a hash `h` is
+// `h * 31^n + sum(c[i] * 31^(n-1-i))`, so we keep per-lane partial sums for whole blocks
+// (multiplying them by `31^n` for each new block) and add them up at the end.
+ALWAYS_INLINE inline uint32_t UpdateHash(uint32_t hash, const uint8_t* data, size_t size) {
+  size_t i = 0u;
+#if defined(__AVX2__)
+  static constexpr size_t kBlockSize = 32u;
+  static constexpr std::array<uint32_t, kBlockSize> kPowers = DescendingPowersOf31<kBlockSize>();
+  if (size >= kBlockSize) {
+    const __m256i* powers = reinterpret_cast<const __m256i*>(kPowers.data());
+    const __m256i block_power = _mm256_set1_epi32(PowerOf31<kBlockSize>());
+    __m256i sums = _mm256_setzero_si256();
+    uint32_t hash_power = 1u;
+    for (; i + kBlockSize <= size; i += kBlockSize) {
+      sums = _mm256_mullo_epi32(sums, block_power);
+      for (size_t j = 0u; j != 4u; ++j) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i + 8u * j));
+        __m256i words = _mm256_cvtepu8_epi32(bytes);
+        sums = _mm256_add_epi32(sums, _mm256_mullo_epi32(words, _mm256_loadu_si256(powers + j)));
+      }
+      hash_power *= PowerOf31<kBlockSize>();
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    hash = hash * hash_power + HorizontalSum(sum);
+  }
+#elif defined(__SSE4_1__) || defined(__aarch64__)
+  static constexpr size_t kBlockSize = 16u;
+  static constexpr std::array<uint32_t, kBlockSize> kPowers = DescendingPowersOf31<kBlockSize>();
+  if (size >= kBlockSize) {
+    uint32_t hash_power = 1u;
+#if defined(__SSE4_1__)
+    const __m128i* powers = reinterpret_cast<const __m128i*>(kPowers.data());
+    const __m128i block_power = _mm_set1_epi32(PowerOf31<kBlockSize>());
+    __m128i sums = _mm_setzero_si128();
+    for (; i + kBlockSize <= size; i += kBlockSize) {
+      sums = _mm_mullo_epi32(sums, block_power);
+      for (size_t j = 0u; j != 4u; ++j) {
+        int32_t four_bytes;
+        memcpy(&four_bytes, data + i + 4u * j, sizeof(four_bytes));
+        __m128i words = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(four_bytes));
+        sums = _mm_add_epi32(sums, _mm_mullo_epi32(words, _mm_loadu_si128(powers + j)));
+      }
+      hash_power *= PowerOf31<kBlockSize>();
+    }
+    hash = hash * hash_power + HorizontalSum(sums);
+#else
+    uint32x4_t sums = vdupq_n_u32(0u);
+    for (; i + kBlockSize <= size; i += kBlockSize) {
+      uint8x16_t bytes = vld1q_u8(data + i);
+      uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+      uint16x8_t high = vmovl_high_u8(bytes);
+      sums = vmulq_n_u32(sums, PowerOf31<kBlockSize>());
+      sums = vmlaq_u32(sums, vmovl_u16(vget_low_u16(low)), vld1q_u32(kPowers.data() + 0u));
+      sums = vmlaq_u32(sums, vmovl_high_u16(low), vld1q_u32(kPowers.data() + 4u));
+      sums = vmlaq_u32(sums, vmovl_u16(vget_low_u16(high)), vld1q_u32(kPowers.data() + 8u));
+      sums = vmlaq_u32(sums, vmovl_high_u16(high), vld1q_u32(kPowers.data() + 12u));
+      hash_power *= PowerOf31<kBlockSize>();
+    }
+    hash = hash * hash_power + vaddvq_u32(sums);
+#endif
+  }
+#endif
+  for (; i != size; ++i) {
+    hash = UpdateModifiedUtf8Hash(hash, static_cast<char>(data[i]));
+  }
+  return hash;
+}
+
+}  // namespace
+
 // This is used only from debugger and test code.
 size_t CountModifiedUtf8Chars(const char* utf8) {
   return CountModifiedUtf8Chars(utf8, strlen(utf8));
@@ -51,15 +248,18 @@ size_t CountModifiedUtf8Chars(const char* utf8, size_t byte_count) {
   DCHECK_LE(byte_count, strlen(utf8));
   size_t len = 0;
   const char* end = utf8 + byte_count;
-  for (; utf8 < end; ++utf8) {
+  while (utf8 < end) {
     int ic = *utf8;
-    len++;
     if (LIKELY((ic & 0x80) == 0)) {
-      // One-byte encoding.
+      // One-byte encoding. Skip the whole run of them.
+      size_t ascii_count = CountLeadingAsciiBytes(utf8, end - utf8);
+      len += ascii_count;
+      utf8 += ascii_count;
       continue;
     }
+    len++;
     // Two- or three-byte encoding.
-    utf8++;
+    utf8 += 2;
     if ((ic & 0x20) == 0) {
       // Two-byte encoding.
       continue;
@@ -100,16 +300,19 @@ void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, size_t out_chars,
 
   if (LIKELY(out_chars == in_bytes)) {
     // Common case where all characters are ASCII.
-    for (const char *p = in_start; p < in_end;) {
-      // Safe even if char is signed because ASCII characters always have
-      // the high bit cleared.
-      *out_p++ = dchecked_integral_cast<uint16_t>(*p++);
-    }
+    size_t converted = ConvertLeadingAsciiToUtf16(out_p, in_start, in_bytes);
+    DCHECK_EQ(converted, in_bytes);
     return;
   }
 
   // String contains non-ASCII characters.
   for (const char *p = in_start; p < in_end;) {
+    if ((static_cast<uint8_t>(*p) & 0x80u) == 0u) {
+      size_t converted = ConvertLeadingAsciiToUtf16(out_p, p, in_end - p);
+      out_p += converted;
+      p += converted;
+      continue;
+    }
     const uint32_t ch = GetUtf16FromUtf8(&p);
     const uint16_t leading = GetLeadingUtf16Char(ch);
     const uint16_t trailing = GetTrailingUtf16Char(ch);
@@ -143,6 +346,15 @@ void ConvertUtf16ToModifiedUtf8(char* utf8_out, size_t byte_count,
 int32_t ComputeUtf16HashFromModifiedUtf8(const char* utf8, size_t utf16_length) {
   uint32_t hash = 0;
   while (utf16_length != 0u) {
+    if ((static_cast<uint8_t>(*utf8) & 0x80u) == 0u) {
+      // ASCII characters are the same in UTF-16. Each remaining UTF-16 character takes at least
+      // one byte, so there are at least `utf16_length` bytes left.
+      size_t ascii_count = CountLeadingAsciiBytes(utf8, utf16_length);
+      hash = UpdateHash(hash, reinterpret_cast<const uint8_t*>(utf8), ascii_count);
+      utf8 += ascii_count;
+      utf16_length -= ascii_count;
+      continue;
+    }
     const uint32_t pair = GetUtf16FromUtf8(&utf8);
     const uint16_t first = GetLeadingUtf16Char(pair);
     hash = hash * 31 + first;
@@ -158,6 +370,11 @@ int32_t ComputeUtf16HashFromModifiedUtf8(const char* utf8, size_t utf16_length)
 }
 
 uint32_t ComputeModifiedUtf8Hash(const char* chars) {
+  if (kUseVectorHash) {
+    // The C library's `strlen()` is vectorized and safe to use with memory tagging, so finding
+    // the length first does not cost much compared to the hashing it speeds up.
+    return ComputeModifiedUtf8Hash(std::string_view(chars));
+  }
   uint32_t hash = StartModifiedUtf8Hash();
   while (*chars != '\0') {
     hash = UpdateModifiedUtf8Hash(hash, *chars);
@@ -167,7 +384,8 @@ uint32_t ComputeModifiedUtf8Hash(const char* chars) {
 }
 
 uint32_t ComputeModifiedUtf8Hash(std::string_view chars) {
-  return UpdateModifiedUtf8Hash(StartModifiedUtf8Hash(), chars);
+  return UpdateHash(
+      StartModifiedUtf8Hash(), reinterpret_cast<const uint8_t*>(chars.data()), chars.size());
 }
 
 int CompareModifiedUtf8ToUtf16AsCodePointValues(const char* utf8, const uint16_t* utf16,
@@ -16,11 +16,16 @@
 
 #include "utf.h"
 
+#include <algorithm>
 #include <map>
+#include <string_view>
 #include <vector>
 
 #include <android-base/stringprintf.h>
 
+#include "base/common_art_test.h"
+#include "base/time_utils.h"
+#include "dex/dex_file-inl.h"
 #include "gtest/gtest.h"
 #include "utf-inl.h"
 
@@ -387,6 +392,91 @@ TEST_F(UtfTest, NonAscii) {
   EXPECT_EQ(static_cast<uint8_t>(kNonAsciiCharacter), hash);
 }
 
+// Reference implementations decoding one character at a time, for checking the vectorized
+// fast paths.
+static std::vector<uint16_t> DecodeModifiedUtf8(std::string_view utf8) {
+  std::vector<uint16_t> utf16;
+  const char* end = utf8.data() + utf8.size();
+  for (const char* p = utf8.data(); p < end;) {
+    const uint32_t pair = GetUtf16FromUtf8(&p);
+    utf16.push_back(GetLeadingUtf16Char(pair));
+    if (GetTrailingUtf16Char(pair) != 0u) {
+      utf16.push_back(GetTrailingUtf16Char(pair));
+    }
+  }
+  return utf16;
+}
+
+static int Sign(int value) {
+  return (value > 0) - (value < 0);
+}
+
+static void CheckFastPaths(const std::string& utf8, const std::string& other) {
+  std::vector<uint16_t> expected = DecodeModifiedUtf8(utf8);
+  ASSERT_EQ(expected.size(), CountModifiedUtf8Chars(utf8.c_str(), utf8.size())) << utf8;
+
+  // Check that the conversion does not write past the end of the output.
+  std::vector<uint16_t> utf16(expected.size() + 1u, 0xffffu);
+  ConvertModifiedUtf8ToUtf16(utf16.data(), expected.size(), utf8.c_str(), utf8.size());
+  EXPECT_EQ(0xffffu, utf16.back()) << utf8;
+  utf16.pop_back();
+  EXPECT_EQ(expected, utf16) << utf8;
+
+  EXPECT_EQ(ComputeUtf16Hash(expected.data(), expected.size()),
+            ComputeUtf16HashFromModifiedUtf8(utf8.c_str(), expected.size())) << utf8;
+  uint32_t expected_hash = StartModifiedUtf8Hash();
+  for (char c : utf8) {
+    expected_hash = UpdateModifiedUtf8Hash(expected_hash, c);
+  }
+  EXPECT_EQ(expected_hash, ComputeModifiedUtf8Hash(utf8.c_str())) << utf8;
+  EXPECT_EQ(expected_hash, ComputeModifiedUtf8Hash(std::string_view(utf8))) << utf8;
+
+  std::vector<uint16_t> other_utf16 = DecodeModifiedUtf8(other);
+  int expected_order = (expected < other_utf16) ? -1 : (expected == other_utf16 ? 0 : 1);
+  EXPECT_EQ(expected_order,
+            Sign(CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues(utf8.c_str(),
+                                                                          other.c_str())))
+      << utf8 << " " << other;
+}
+
+TEST_F(UtfTest, VectorizedFastPaths) {
+  // Place each kind of sequence at every offset of strings long enough to cover full vectors
+  // and tails of all the vector widths.
+  const char* const kSequences[] = {
+      "\x7f",                      // One byte.
+      "\xc0\x80",                  // Two bytes, encoded U+0000.
+      "\xc2\xa2",                  // Two bytes.
+      "\xe2\x82\xac",              // Three bytes.
+      "\xed\xa0\x81\xed\xb0\x80",  // Surrogate pair, encoded as two three byte sequences.
+      "\xf0\x9f\x8f\xa0",          // Four bytes.
+  };
+  const std::string ascii = "Ljava/lang/invoke/VarHandle$AccessDescriptor;0123456789abcdefghi";
+  for (size_t length = 0u; length <= ascii.size(); ++length) {
+    const std::string prefix = ascii.substr(0u, length);
+    CheckFastPaths(prefix, ascii);
+    for (const char* sequence : kSequences) {
+      for (size_t pos = 0u; pos <= length; ++pos) {
+        std::string utf8 = prefix;
+        utf8.insert(pos, sequence);
+        CheckFastPaths(utf8, prefix);
+        CheckFastPaths(prefix, utf8);
+        CheckFastPaths(utf8, utf8);
+        for (const char* other_sequence : kSequences) {
+          std::string other = prefix;
+          other.insert(pos, other_sequence);
+          CheckFastPaths(utf8, other);
+        }
+        // Mostly non-ASCII strings.
+        std::string repeated;
+        for (size_t i = 0u; i != pos; ++i) {
+          repeated += sequence;
+        }
+        CheckFastPaths(repeated + prefix, utf8);
+      }
+    }
+  }
+}
+
 TEST_F(UtfTest, PrintableStringUtf8) {
   // Note: This is UTF-8, not Modified-UTF-8.
   const uint8_t kTestSequence[] = { 0xf0, 0x90, 0x80, 0x80, 0 };
@@ -405,4 +495,119 @@ TEST_F(UtfTest, PrintableStringUtf8) {
   EXPECT_EQ(expected, printable);
 }
 
+// Measures the MUTF-8 helpers over the string data of real dex files. The throughput is
+// reported in bytes per nanosecond and, on x86, in bytes per time-stamp counter tick, which
+// runs at the nominal frequency of the CPU. Other architectures have no cycle counter readable
+// from user space.
+class UtfBenchmarkTest : public CommonArtTest {
+ protected:
+  static constexpr size_t kRepetitions = 20;
+
+  void SetUp() override {
+    CommonArtTest::SetUp();
+    dex_files_ = OpenDexFiles(GetLibCoreDexFileNames()[0].c_str());
+    ASSERT_FALSE(dex_files_.empty());
+    for (const std::unique_ptr<const DexFile>& dex_file : dex_files_) {
+      for (size_t i = 0; i != dex_file->NumStringIds(); ++i) {
+        uint32_t utf16_length;
+        const char* data =
+            dex_file->StringDataAndUtf16LengthByIdx(dex::StringIndex(i), &utf16_length);
+        strings_.push_back({std::string_view(data), utf16_length});
+        total_bytes_ += strings_.back().data.size();
+        max_utf16_length_ = std::max<size_t>(max_utf16_length_, utf16_length);
+      }
+    }
+  }
+
+  static uint64_t ReadCycleCounter() {
+#if defined(__i386__) || defined(__x86_64__)
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+    return 0u;
+#endif
+  }
+
+  // Runs `fn(index)` for all the strings, `kRepetitions` times, and reports the throughput.
+  template <typename Fn>
+  void Run(const char* name, Fn&& fn) {
+    uint64_t sink = 0u;
+    const uint64_t start_ns = NanoTime();
+    const uint64_t start_cycles = ReadCycleCounter();
+    for (size_t repetition = 0; repetition != kRepetitions; ++repetition) {
+      for (size_t i = 0; i != strings_.size(); ++i) {
+        sink += fn(i);
+      }
+    }
+    const uint64_t cycles = ReadCycleCounter() - start_cycles;
+    const uint64_t duration_ns = std::max<uint64_t>(NanoTime() - start_ns, 1u);
+    const double bytes = static_cast<double>(total_bytes_ * kRepetitions);
+    std::string cycles_info = (cycles != 0u)
+        ? android::base::StringPrintf(" %.3f bytes/cycle", bytes / cycles)
+        : std::string();
+    LOG(INFO) << "UTF benchmark " << name << ": " << strings_.size() << " strings, "
+              << total_bytes_ << " bytes, "
+              << android::base::StringPrintf("%.3f bytes/ns", bytes / duration_ns)
+              << cycles_info << " (" << sink << ")";
+  }
+
+  struct StringData {
+    std::string_view data;
+    uint32_t utf16_length;
+  };
+
+  std::vector<std::unique_ptr<const DexFile>> dex_files_;
+  std::vector<StringData> strings_;
+  size_t total_bytes_ = 0u;
+  size_t max_utf16_length_ = 0u;
+};
+
+TEST_F(UtfBenchmarkTest, CountModifiedUtf8Chars) {
+  for (const StringData& string : strings_) {
+    ASSERT_EQ(string.utf16_length, CountModifiedUtf8Chars(string.data.data(), string.data.size()));
+  }
+  Run("CountModifiedUtf8Chars", [&](size_t i) {
+    return CountModifiedUtf8Chars(strings_[i].data.data(), strings_[i].data.size());
+  });
+}
+
+TEST_F(UtfBenchmarkTest, ConvertModifiedUtf8ToUtf16) {
+  std::vector<uint16_t> utf16(max_utf16_length_);
+  Run("ConvertModifiedUtf8ToUtf16", [&](size_t i) {
+    ConvertModifiedUtf8ToUtf16(
+        utf16.data(), strings_[i].utf16_length, strings_[i].data.data(), strings_[i].data.size());
+    return (strings_[i].utf16_length != 0u) ? utf16[strings_[i].utf16_length - 1u] : 0u;
+  });
+}
+
+TEST_F(UtfBenchmarkTest, ComputeModifiedUtf8Hash) {
+  Run("ComputeModifiedUtf8Hash", [&](size_t i) {
+    return ComputeModifiedUtf8Hash(strings_[i].data);
+  });
+}
+
+TEST_F(UtfBenchmarkTest, ComputeModifiedUtf8HashNullTerminated) {
+  Run("ComputeModifiedUtf8Hash(const char*)", [&](size_t i) {
+    return ComputeModifiedUtf8Hash(strings_[i].data.data());
+  });
+}
+
+TEST_F(UtfBenchmarkTest, ComputeUtf16HashFromModifiedUtf8) {
+  Run("ComputeUtf16HashFromModifiedUtf8", [&](size_t i) {
+    return static_cast<uint32_t>(
+        ComputeUtf16HashFromModifiedUtf8(strings_[i].data.data(), strings_[i].utf16_length));
+  });
+}
+
+TEST_F(UtfBenchmarkTest, CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues) {
+  // The string data of each dex file is sorted, so neighbours often share long prefixes, as in
+  // the binary searches of `DexFile::FindStringId()`.
+  Run("CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues", [&](size_t i) {
+    size_t next = (i + 1u != strings_.size()) ? i + 1u : 0u;
+    return static_cast<uint32_t>(CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues(
+        strings_[i].data.data(), strings_[next].data.data()));
+  });
+}
+
 }  // namespace art
@@ -23,6 +23,10 @@
 #include <unistd.h>
 #include <zlib.h>
 
+#ifdef _WIN32
+#include <io.h>
+#endif
+
 #include <algorithm>
 #include <cerrno>
 #include <climits>
@@ -45,6 +49,7 @@
 #include "base/globals.h"
 #include "base/logging.h"  // For VLOG.
 #include "base/malloc_arena_pool.h"
+#include "base/mman.h"
 #include "base/os.h"
 #include "base/safe_map.h"
 #include "base/scoped_flock.h"
@@ -121,6 +126,13 @@ static constexpr uint32_t kSizeErrorThresholdBytes = 1500000U;
 static constexpr uint32_t kSizeWarningThresholdBootBytes = 25000000U;
 static constexpr uint32_t kSizeErrorThresholdBootBytes = 100000000U;
 
+// Sections of profiles in the mappable format start at this alignment so that the
+// `uint32_t` and `uint16_t` arrays of the method index section can be accessed in place.
+static constexpr uint32_t kMappableSectionAlignment = sizeof(uint32_t);
+
+// Existing profile data is compared and rewritten in blocks of this size by in-place saves.
+static constexpr size_t kInPlaceWriteBlockSize = 4 * KB;
+
 static bool ChecksumMatch(uint32_t dex_file_checksum, uint32_t checksum) {
   return kDebugIgnoreChecksum || dex_file_checksum == checksum;
 }
@@ -231,8 +243,18 @@ enum class ProfileCompilationInfo::FileSectionType : uint32_t {
   // an optional reserved section not implemented on client yet.
   kAggregationCounts = 4,
 
+  // Uncompressed index of the hot methods and method flag bitmaps, written only
+  // for profiles in the mappable format. The data duplicates the methods section.
+  kMethodIndex = 5,
+
+  // Branch and packed switch target counts of hot methods.
+  kBranchProfiles = 6,
+
+  // Receiver class counts of the inline caches of hot methods.
+  kReceiverCounts = 7,
+
   // The number of known sections.
-  kNumberOfSections = 5
+  kNumberOfSections = 8
 };
 
 class ProfileCompilationInfo::FileSectionInfo {
@@ -610,6 +632,42 @@ void ProfileCompilationInfo::DexPcData::AddClass(const dex::TypeIndex& type_idx)
   classes.emplace_hint(lb, type_idx);
 }
 
+static uint32_t MergeCount(uint32_t existing, uint32_t count, bool keep_max) {
+  return keep_max
+      ? std::max(existing, count)
+      : static_cast<uint32_t>(std::min<uint64_t>(
+            static_cast<uint64_t>(existing) + count, std::numeric_limits<uint32_t>::max()));
+}
+
+void ProfileCompilationInfo::DexPcData::MergeReceiverCount(dex::TypeIndex type_idx,
+                                                           uint32_t count,
+                                                           bool keep_max) {
+  auto it = receiver_counts.find(type_idx);
+  if (it != receiver_counts.end()) {
+    it->second = MergeCount(it->second, count, keep_max);
+    return;
+  }
+  if (receiver_counts.size() < ProfileCompilationInfo::kIndividualInlineCacheSize) {
+    receiver_counts.Put(type_idx, count);
+    return;
+  }
+  // Replace the least frequent receiver if the new one is more frequent. The receivers
+  // that are not recorded are still accounted for by the total count.
+  auto min_it = std::min_element(receiver_counts.begin(),
+                                 receiver_counts.end(),
+                                 [](const auto& lhs, const auto& rhs) {
+                                   return lhs.second < rhs.second;
+                                 });
+  if (min_it->second < count) {
+    receiver_counts.erase(min_it);
+    receiver_counts.Put(type_idx, count);
+  }
+}
+
+void ProfileCompilationInfo::DexPcData::MergeTotalCount(uint32_t count, bool keep_max) {
+  total_count = MergeCount(total_count, count, keep_max);
+}
+
 // Transform the actual dex location into a key used to index the dex file in the profile.
 // See ProfileCompilationInfo#GetProfileDexFileBaseKey as well.
 std::string ProfileCompilationInfo::GetProfileDexFileAugmentedKey(
@@ -805,6 +863,8 @@ bool ProfileCompilationInfo::Load(const std::string& filename, bool clear_if_inv
     LOG(WARNING) << "Clearing bad or obsolete profile data from file "
                  << filename << ": " << error;
     // When ART Service is enabled, this is the only place where we mutate a profile in place.
+    // Without ART Service, profiles in the mappable format are also saved in place, see
+    // `SaveFallback()`.
     // TODO(jiakaiz): Get rid of this.
     if (profile_file->ClearContent()) {
       return true;
@@ -883,14 +943,16 @@ bool ProfileCompilationInfo::Save(const std::string& filename, uint64_t* bytes_w
 
 bool ProfileCompilationInfo::SaveFallback(const std::string& filename, uint64_t* bytes_written) {
   std::string error;
+  // Profiles in the mappable format are updated in place and need to be readable.
 #ifdef _WIN32
-  int flags = O_WRONLY | O_CREAT;
+  int flags = (mappable_format_ ? O_RDWR : O_WRONLY) | O_CREAT;
 #else
-  int flags = O_WRONLY | O_NOFOLLOW | O_CLOEXEC | O_CREAT;
+  int flags = (mappable_format_ ? O_RDWR : O_WRONLY) | O_NOFOLLOW | O_CLOEXEC | O_CREAT;
 #endif
   // There's no need to fsync profile data right away. We get many chances
   // to write it again in case something goes wrong. We can rely on a simple
   // close(), no sync, and let to the kernel decide when to write to disk.
+  // In-place saves are the exception, they sync to order the header writes.
   ScopedFlock profile_file =
       LockedFile::Open(filename.c_str(), flags, /*block=*/false, &error);
   if (profile_file.get() == nullptr) {
@@ -900,6 +962,25 @@ bool ProfileCompilationInfo::SaveFallback(const std::string& filename, uint64_t*
 
   int fd = profile_file->Fd();
 
+  if (mappable_format_) {
+    // Overwrite the existing data, skipping the blocks that did not change since the last save,
+    // and drop whatever is left of the previous profile past the new end of the data.
+    uint64_t file_size = 0u;
+    uint64_t changed_bytes = 0u;
+    bool result = SaveInternal(fd, /*in_place=*/ true, &file_size, &changed_bytes) &&
+                  profile_file->SetLength(file_size) == 0;
+    if (result) {
+      VLOG(profiler) << "Successfully saved profile info in place to " << filename
+                     << " Size: " << file_size << " Changed: " << changed_bytes;
+      if (bytes_written != nullptr) {
+        *bytes_written = changed_bytes;
+      }
+    } else {
+      VLOG(profiler) << "Failed to save profile info in place to " << filename;
+    }
+    return result;
+  }
+
   // We need to clear the data because we don't support appending to the profiles yet.
   if (!profile_file->ClearContent()) {
     PLOG(WARNING) << "Could not clear profile file: " << filename;
@@ -941,6 +1022,53 @@ static bool WriteBuffer(int fd, const void* buffer, size_t byte_count) {
   return true;
 }
 
+// Returns true if the data written to the file descriptor so far reached the storage device.
+static bool SyncFile(int fd) {
+#if defined(_WIN32)
+  return _commit(fd) == 0;
+#elif defined(__linux__)
+  return TEMP_FAILURE_RETRY(fdatasync(fd)) == 0;
+#else
+  return TEMP_FAILURE_RETRY(fsync(fd)) == 0;
+#endif
+}
+
+// Like `WriteBuffer()` but the file may already contain data at the current position. The data
+// is compared block by block and only the blocks that differ are written. The number of bytes
+// actually written is added to `bytes_written`.
+static bool WriteBufferInPlace(int fd,
+                               const void* buffer,
+                               size_t byte_count,
+                               /*inout*/ uint64_t* bytes_written) {
+  std::unique_ptr<uint8_t[]> existing(new uint8_t[kInPlaceWriteBlockSize]);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer);
+  while (byte_count > 0) {
+    size_t block_size = std::min(byte_count, kInPlaceWriteBlockSize);
+    size_t existing_size = 0u;
+    while (existing_size != block_size) {
+      int bytes_read =
+          TEMP_FAILURE_RETRY(read(fd, existing.get() + existing_size, block_size - existing_size));
+      if (bytes_read == -1) {
+        return false;
+      }
+      if (bytes_read == 0) {
+        break;  // Reached the end of the existing data.
+      }
+      existing_size += bytes_read;
+    }
+    if (existing_size != block_size || memcmp(existing.get(), data, block_size) != 0) {
+      off_t block_offset = lseek(fd, -static_cast<off_t>(existing_size), SEEK_CUR);
+      if (block_offset == static_cast<off_t>(-1) || !WriteBuffer(fd, data, block_size)) {
+        return false;
+      }
+      *bytes_written += block_size;
+    }
+    data += block_size;
+    byte_count -= block_size;
+  }
+  return true;
+}
+
 /**
  * Serialization format:
  *
@@ -957,7 +1085,13 @@ static bool WriteBuffer(int fd, const void* buffer, size_t byte_count) {
  *   ExtraDescriptors - optional, zipped
  *   Classes - optional, zipped
  *   Methods - optional, zipped
+ *   BranchProfiles - optional, zipped
+ *   ReceiverCounts - optional, zipped
  *   AggregationCounts - optional, zipped, server-side
+ * In the mappable format, all sections are plaintext and aligned to
+ * `kMappableSectionAlignment`, and the Methods and BranchProfiles
+ * sections are followed by:
+ *   MethodIndex - optional, plaintext
  *
  * DexFiles:
  *    number_of_dex_files
@@ -996,8 +1130,57 @@ static bool WriteBuffer(int fd, const void* buffer, size_t byte_count) {
  *    type_index_diff[dex_map_size]
  * where `M` stands for special encodings indicating missing types (kIsMissingTypesEncoding)
  * or memamorphic call (kIsMegamorphicEncoding) which both imply `dex_map_size == 0`.
+ *
+ * BranchProfiles contains records for any number of dex files, each consisting of:
+ *    profile_index  // Index of the dex file in DexFiles section.
+ *    following_data_size  // For easy skipping of remaining data when dex file is filtered out.
+ *    branch_method_encoding[]  // Until the size indicated by `following_data_size`.
+ * where the `branch_method_encoding` is:
+ *    method_index_diff
+ *    number_of_branches
+ *    branch_encoding[number_of_branches]
+ * and the `branch_encoding`, sorted by dex pc, is:
+ *    dex_pc
+ *    number_of_counts
+ *    count[number_of_counts]  // As `uint32_t`.
+ * with the counts of `ProfileMethodInfo::ProfileBranchCounts`.
+ *
+ * ReceiverCounts contains records for any number of dex files, each consisting of:
+ *    profile_index  // Index of the dex file in DexFiles section.
+ *    following_data_size  // For easy skipping of remaining data when dex file is filtered out.
+ *    receiver_method_encoding[]  // Until the size indicated by `following_data_size`.
+ * where the `receiver_method_encoding` is:
+ *    method_index_diff
+ *    number_of_call_sites
+ *    call_site_encoding[number_of_call_sites]
+ * and the `call_site_encoding`, sorted by dex pc, is:
+ *    dex_pc
+ *    total_count  // As `uint32_t`.
+ *    number_of_receivers  // As `uint8_t`.
+ *    (type_index,count)[number_of_receivers]  // The count as `uint32_t`.
+ * where type indexes are sorted and may refer to extra descriptors as in the Methods section.
+ * The receiver counts are kept for megamorphic inline caches which have no classes.
+ *
+ * MethodIndex contains records for the same dex files as Methods, each consisting of:
+ *    profile_index  // Index of the dex file in DexFiles section, as `uint32_t`.
+ *    method_flags  // As `uint32_t`.
+ *    number_of_hot_methods
+ *    method_index[number_of_hot_methods]
+ *    bitmap_data
+ * where `method_index[]` is a sorted `uint16_t` array and `bitmap_data` has the same layout
+ * as in the Methods section. Both arrays are padded to a multiple of 4 bytes. The method
+ * indexes are not diff-encoded so that they can be binary searched in the mapped file.
  **/
 bool ProfileCompilationInfo::Save(int fd) {
+  uint64_t file_size = 0u;
+  uint64_t bytes_written = 0u;
+  return SaveInternal(fd, /*in_place=*/ false, &file_size, &bytes_written);
+}
+
+bool ProfileCompilationInfo::SaveInternal(int fd,
+                                          bool in_place,
+                                          /*out*/ uint64_t* file_size,
+                                          /*out*/ uint64_t* bytes_written) {
   uint64_t start = NanoTime();
   ScopedTrace trace(__PRETTY_FUNCTION__);
   DCHECK_GE(fd, 0);
@@ -1015,6 +1198,9 @@ bool ProfileCompilationInfo::Save(int fd) {
   uint64_t dex_files_section_size = sizeof(ProfileIndexType);  // Number of dex files.
   uint64_t classes_section_size = 0u;
   uint64_t methods_section_size = 0u;
+  uint64_t method_index_section_size = 0u;
+  uint64_t branch_profiles_section_size = 0u;
+  uint64_t receiver_counts_section_size = 0u;
   DCHECK_LE(info_.size(), MaxProfileIndex());
   for (const std::unique_ptr<DexFileData>& dex_data : info_) {
     if (dex_data->profile_key.size() > kMaxDexFileKeyLength) {
@@ -1027,13 +1213,21 @@ bool ProfileCompilationInfo::Save(int fd) {
         sizeof(uint16_t) + dex_data->profile_key.size();
     classes_section_size += dex_data->ClassesDataSize();
     methods_section_size += dex_data->MethodsDataSize();
+    branch_profiles_section_size += dex_data->BranchProfilesDataSize();
+    receiver_counts_section_size += dex_data->ReceiverCountsDataSize();
+    if (mappable_format_) {
+      method_index_section_size += dex_data->MethodIndexDataSize();
+    }
   }
 
   const uint32_t file_section_count =
       /* dex files */ 1u +
       /* extra descriptors */ (extra_descriptors_section_size != 0u ? 1u : 0u) +
       /* classes */ (classes_section_size != 0u ? 1u : 0u) +
-      /* methods */ (methods_section_size != 0u ? 1u : 0u);
+      /* methods */ (methods_section_size != 0u ? 1u : 0u) +
+      /* branch profiles */ (branch_profiles_section_size != 0u ? 1u : 0u) +
+      /* receiver counts */ (receiver_counts_section_size != 0u ? 1u : 0u) +
+      /* method index */ (method_index_section_size != 0u ? 1u : 0u);
   uint64_t header_and_infos_size =
       sizeof(FileHeader) + file_section_count * sizeof(FileSectionInfo);
 
@@ -1044,7 +1238,10 @@ bool ProfileCompilationInfo::Save(int fd) {
       dex_files_section_size +
       extra_descriptors_section_size +
       classes_section_size +
-      methods_section_size;
+      methods_section_size +
+      branch_profiles_section_size +
+      receiver_counts_section_size +
+      method_index_section_size;
   VLOG(profiler) << "Required capacity: " << total_uncompressed_size << " bytes.";
   if (total_uncompressed_size > GetSizeErrorThresholdBytes()) {
     LOG(WARNING) << "Profile data size exceeds "
@@ -1054,26 +1251,67 @@ bool ProfileCompilationInfo::Save(int fd) {
     return false;
   }
 
-  // Start with an invalid file header and section infos.
+  *bytes_written = 0u;
+  auto write_buffer = [&](const void* buffer, size_t byte_count) {
+    if (in_place) {
+      return WriteBufferInPlace(fd, buffer, byte_count, bytes_written);
+    }
+    *bytes_written += byte_count;
+    return WriteBuffer(fd, buffer, byte_count);
+  };
+
+  // Start with an invalid file header and section infos. When saving in place, keep the
+  // existing section infos instead, they are compared with the new ones at the end, but
+  // invalidate the header and make sure that it reaches the disk before any section is
+  // modified. If we crash in the middle of the save, the profile is then rejected as having
+  // a bad magic instead of being read with a mix of old and new data.
   DCHECK_EQ(lseek(fd, 0, SEEK_CUR), 0);
   constexpr uint32_t kMaxNumberOfSections = enum_cast<uint32_t>(FileSectionType::kNumberOfSections);
   constexpr uint64_t kMaxHeaderAndInfosSize =
       sizeof(FileHeader) + kMaxNumberOfSections * sizeof(FileSectionInfo);
   DCHECK_LE(header_and_infos_size, kMaxHeaderAndInfosSize);
-  std::array<uint8_t, kMaxHeaderAndInfosSize> placeholder;
-  memset(placeholder.data(), 0, header_and_infos_size);
-  if (!WriteBuffer(fd, placeholder.data(), header_and_infos_size)) {
-    return false;
+  if (in_place) {
+    static constexpr uint8_t kInvalidHeader[sizeof(FileHeader)] = {};
+    if (!WriteBuffer(fd, kInvalidHeader, sizeof(kInvalidHeader)) || !SyncFile(fd)) {
+      return false;
+    }
+    if (lseek(fd, header_and_infos_size, SEEK_SET) != static_cast<off_t>(header_and_infos_size)) {
+      return false;
+    }
+  } else {
+    std::array<uint8_t, kMaxHeaderAndInfosSize> placeholder;
+    memset(placeholder.data(), 0, header_and_infos_size);
+    if (!write_buffer(placeholder.data(), header_and_infos_size)) {
+      return false;
+    }
   }
 
   std::array<FileSectionInfo, kMaxNumberOfSections> section_infos;
   size_t section_index = 0u;
   uint32_t file_offset = header_and_infos_size;
-  auto add_section_info = [&](FileSectionType type, uint32_t file_size, uint32_t inflated_size) {
+  static_assert(IsAligned<kMappableSectionAlignment>(sizeof(FileHeader)));
+  static_assert(IsAligned<kMappableSectionAlignment>(sizeof(FileSectionInfo)));
+  auto write_section = [&](FileSectionType type, SafeBuffer& buffer, uint32_t inflated_size) {
+    if (mappable_format_) {
+      // Store the section uncompressed at an aligned offset.
+      static constexpr uint8_t kPadding[kMappableSectionAlignment] = {};
+      uint32_t padding_size = RoundUp(file_offset, kMappableSectionAlignment) - file_offset;
+      if (padding_size != 0u && !write_buffer(kPadding, padding_size)) {
+        return false;
+      }
+      file_offset += padding_size;
+      inflated_size = 0u;
+    } else if (inflated_size != 0u && !buffer.Deflate()) {
+      return false;
+    }
+    if (!write_buffer(buffer.Get(), buffer.Size())) {
+      return false;
+    }
     DCHECK_LT(section_index, section_infos.size());
-    section_infos[section_index] = FileSectionInfo(type, file_offset, file_size, inflated_size);
-    file_offset += file_size;
+    section_infos[section_index] = FileSectionInfo(type, file_offset, buffer.Size(), inflated_size);
+    file_offset += buffer.Size();
     section_index += 1u;
+    return true;
   };
 
   // Write the dex files section.
@@ -1089,10 +1327,9 @@ bool ProfileCompilationInfo::Save(int fd) {
     }
     DCHECK_EQ(buffer.GetAvailableBytes(), 0u);
     // Write the dex files section uncompressed.
-    if (!WriteBuffer(fd, buffer.Get(), dex_files_section_size)) {
+    if (!write_section(FileSectionType::kDexFiles, buffer, /*inflated_size=*/ 0u)) {
       return false;
     }
-    add_section_info(FileSectionType::kDexFiles, dex_files_section_size, /*inflated_size=*/ 0u);
   }
 
   // Write the extra descriptors section.
@@ -1103,14 +1340,10 @@ bool ProfileCompilationInfo::Save(int fd) {
       buffer.WriteUintAndAdvance(dchecked_integral_cast<uint16_t>(descriptor.size()));
       buffer.WriteAndAdvance(descriptor.c_str(), descriptor.size());
     }
-    if (!buffer.Deflate()) {
-      return false;
-    }
-    if (!WriteBuffer(fd, buffer.Get(), buffer.Size())) {
+    if (!write_section(
+            FileSectionType::kExtraDescriptors, buffer, extra_descriptors_section_size)) {
       return false;
     }
-    add_section_info(
-        FileSectionType::kExtraDescriptors, buffer.Size(), extra_descriptors_section_size);
   }
 
   // Write the classes section.
@@ -1119,13 +1352,9 @@ bool ProfileCompilationInfo::Save(int fd) {
     for (const std::unique_ptr<DexFileData>& dex_data : info_) {
       dex_data->WriteClasses(buffer);
     }
-    if (!buffer.Deflate()) {
-      return false;
-    }
-    if (!WriteBuffer(fd, buffer.Get(), buffer.Size())) {
+    if (!write_section(FileSectionType::kClasses, buffer, classes_section_size)) {
       return false;
     }
-    add_section_info(FileSectionType::kClasses, buffer.Size(), classes_section_size);
   }
 
   // Write the methods section.
@@ -1134,14 +1363,50 @@ bool ProfileCompilationInfo::Save(int fd) {
     for (const std::unique_ptr<DexFileData>& dex_data : info_) {
       dex_data->WriteMethods(buffer);
     }
-    if (!buffer.Deflate()) {
+    if (!write_section(FileSectionType::kMethods, buffer, methods_section_size)) {
+      return false;
+    }
+  }
+
+  // Write the branch profiles section.
+  if (branch_profiles_section_size != 0u) {
+    SafeBuffer buffer(branch_profiles_section_size);
+    for (const std::unique_ptr<DexFileData>& dex_data : info_) {
+      dex_data->WriteBranchProfiles(buffer);
+    }
+    DCHECK_EQ(buffer.GetAvailableBytes(), 0u);
+    if (!write_section(
+            FileSectionType::kBranchProfiles, buffer, branch_profiles_section_size)) {
+      return false;
+    }
+  }
+
+  // Write the receiver counts section.
+  if (receiver_counts_section_size != 0u) {
+    SafeBuffer buffer(receiver_counts_section_size);
+    for (const std::unique_ptr<DexFileData>& dex_data : info_) {
+      dex_data->WriteReceiverCounts(buffer);
+    }
+    DCHECK_EQ(buffer.GetAvailableBytes(), 0u);
+    if (!write_section(
+            FileSectionType::kReceiverCounts, buffer, receiver_counts_section_size)) {
       return false;
     }
-    if (!WriteBuffer(fd, buffer.Get(), buffer.Size())) {
+  }
+
+  // Write the method index section.
+  if (method_index_section_size != 0u) {
+    DCHECK(mappable_format_);
+    SafeBuffer buffer(method_index_section_size);
+    for (const std::unique_ptr<DexFileData>& dex_data : info_) {
+      dex_data->WriteMethodIndex(buffer);
+    }
+    DCHECK_EQ(buffer.GetAvailableBytes(), 0u);
+    if (!write_section(FileSectionType::kMethodIndex, buffer, /*inflated_size=*/ 0u)) {
       return false;
     }
-    add_section_info(FileSectionType::kMethods, buffer.Size(), methods_section_size);
   }
+  DCHECK_EQ(section_index, file_section_count);
 
   if (file_offset > GetSizeWarningThresholdBytes()) {
     LOG(WARNING) << "Profile data size exceeds "
@@ -1162,19 +1427,26 @@ bool ProfileCompilationInfo::Save(int fd) {
     section_infos_buffer.WriteUintAndAdvance(info.GetInflatedSize());
   }
   DCHECK_EQ(section_infos_buffer.GetAvailableBytes(), 0u);
-  if (!WriteBuffer(fd, section_infos_buffer.Get(), section_infos_buffer.Size())) {
+  if (!write_buffer(section_infos_buffer.Get(), section_infos_buffer.Size())) {
     return false;
   }
 
-  // Write header.
+  // Write header. When saving in place, the sections and section infos must reach the disk
+  // before the header makes them valid again.
+  if (in_place && !SyncFile(fd)) {
+    return false;
+  }
   FileHeader header(version_, section_index);
   if (lseek(fd, 0, SEEK_SET) != 0) {
     return false;
   }
-  if (!WriteBuffer(fd, &header, sizeof(FileHeader))) {
+  // The header is rewritten by every in-place save, only count it for regular saves.
+  if (in_place ? !WriteBuffer(fd, &header, sizeof(FileHeader))
+               : !write_buffer(&header, sizeof(FileHeader))) {
     return false;
   }
 
+  *file_size = file_offset;
   uint64_t total_time = NanoTime() - start;
   VLOG(profiler) << "Compressed from "
                  << std::to_string(total_uncompressed_size)
@@ -1326,11 +1598,42 @@ bool ProfileCompilationInfo::AddMethod(const ProfileMethodInfo& pmi,
     return true;
   }
 
+  // Add branch counts. The runtime reports cumulative counts each time the profile
+  // is saved, so keep the maximum rather than adding them.
+  if (!pmi.branch_counts.empty()) {
+    BranchCountMap* branch_counts = data->FindOrAddBranchCounts(pmi.ref.index);
+    DCHECK(branch_counts != nullptr);
+    for (const ProfileMethodInfo::ProfileBranchCounts& branch : pmi.branch_counts) {
+      if (branch.dex_pc > std::numeric_limits<uint16_t>::max()) {
+        continue;  // Cannot be encoded in the profile.
+      }
+      MergeBranchCounts(branch_counts,
+                        static_cast<uint16_t>(branch.dex_pc),
+                        ArrayRef<const uint32_t>(branch.counts),
+                        /*keep_max=*/ true);
+    }
+  }
+
   // Add inline caches.
   InlineCacheMap* inline_cache = data->FindOrAddHotMethod(pmi.ref.index);
   DCHECK(inline_cache != nullptr);
 
   for (const ProfileMethodInfo::ProfileInlineCache& cache : pmi.inline_caches) {
+    // Add receiver counts. Like branch counts, they are cumulative.
+    if (cache.total_count != 0u && cache.dex_pc <= std::numeric_limits<uint16_t>::max()) {
+      DCHECK(cache.counts.empty() || cache.counts.size() == cache.classes.size());
+      DexPcData* dex_pc_data = FindOrAddDexPc(inline_cache, cache.dex_pc);
+      dex_pc_data->MergeTotalCount(cache.total_count, /*keep_max=*/ true);
+      for (size_t i = 0; i != cache.counts.size(); ++i) {
+        if (cache.counts[i] == 0u) {
+          continue;
+        }
+        dex::TypeIndex type_index = FindOrCreateTypeIndex(*pmi.ref.dex_file, cache.classes[i]);
+        if (type_index.IsValid()) {
+          dex_pc_data->MergeReceiverCount(type_index, cache.counts[i], /*keep_max=*/ true);
+        }
+      }
+    }
     if (cache.is_missing_types) {
       FindOrAddDexPc(inline_cache, cache.dex_pc)->SetIsMissingTypes();
       continue;
@@ -1755,6 +2058,77 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::ReadMethodsSec
   return ProfileLoadStatus::kSuccess;
 }
 
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::ReadBranchProfilesSection(
+    ProfileSource& source,
+    const FileSectionInfo& section_info,
+    const dchecked_vector<ProfileIndexType>& dex_profile_index_remap,
+    /*out*/ std::string* error) {
+  DCHECK(section_info.GetType() == FileSectionType::kBranchProfiles);
+  SafeBuffer buffer;
+  ProfileLoadStatus status = ReadSectionData(source, section_info, &buffer, error);
+  if (status != ProfileLoadStatus::kSuccess) {
+    return status;
+  }
+
+  while (buffer.GetAvailableBytes() != 0u) {
+    ProfileIndexType profile_index;
+    if (!buffer.ReadUintAndAdvance(&profile_index)) {
+      *error = "Error profile index in branch profiles section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    if (profile_index >= dex_profile_index_remap.size()) {
+      *error = "Invalid profile index in branch profiles section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    profile_index = dex_profile_index_remap[profile_index];
+    if (profile_index == MaxProfileIndex()) {
+      status = DexFileData::SkipBranchProfiles(buffer, error);
+    } else {
+      status = info_[profile_index]->ReadBranchProfiles(buffer, error);
+    }
+    if (status != ProfileLoadStatus::kSuccess) {
+      return status;
+    }
+  }
+  return ProfileLoadStatus::kSuccess;
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::ReadReceiverCountsSection(
+    ProfileSource& source,
+    const FileSectionInfo& section_info,
+    const dchecked_vector<ProfileIndexType>& dex_profile_index_remap,
+    const dchecked_vector<ExtraDescriptorIndex>& extra_descriptors_remap,
+    /*out*/ std::string* error) {
+  DCHECK(section_info.GetType() == FileSectionType::kReceiverCounts);
+  SafeBuffer buffer;
+  ProfileLoadStatus status = ReadSectionData(source, section_info, &buffer, error);
+  if (status != ProfileLoadStatus::kSuccess) {
+    return status;
+  }
+
+  while (buffer.GetAvailableBytes() != 0u) {
+    ProfileIndexType profile_index;
+    if (!buffer.ReadUintAndAdvance(&profile_index)) {
+      *error = "Error profile index in receiver counts section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    if (profile_index >= dex_profile_index_remap.size()) {
+      *error = "Invalid profile index in receiver counts section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    profile_index = dex_profile_index_remap[profile_index];
+    if (profile_index == MaxProfileIndex()) {
+      status = DexFileData::SkipReceiverCounts(buffer, error);
+    } else {
+      status = info_[profile_index]->ReadReceiverCounts(buffer, extra_descriptors_remap, error);
+    }
+    if (status != ProfileLoadStatus::kSuccess) {
+      return status;
+    }
+  }
+  return ProfileLoadStatus::kSuccess;
+}
+
 // TODO(calin): fail fast if the dex checksums don't match.
 ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::LoadInternal(
     int32_t fd,
@@ -1879,6 +2253,22 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::LoadInternal(
       case FileSectionType::kAggregationCounts:
         // This section is only used on server side.
         break;
+      case FileSectionType::kMethodIndex:
+        // This section is only used by `MappedProfile`, the methods section has the same data.
+        break;
+      case FileSectionType::kBranchProfiles:
+        // Skip if all dex files were filtered out.
+        if (!info_.empty()) {
+          status = ReadBranchProfilesSection(*source, section_info, dex_profile_index_remap, error);
+        }
+        break;
+      case FileSectionType::kReceiverCounts:
+        // Skip if all dex files were filtered out.
+        if (!info_.empty()) {
+          status = ReadReceiverCountsSection(
+              *source, section_info, dex_profile_index_remap, extra_descriptors_remap, error);
+        }
+        break;
       default:
         // Unknown section. Skip it. New versions of ART are allowed
         // to add sections that shall be ignored by old versions.
@@ -1893,67 +2283,403 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::LoadInternal(
   return ProfileLoadStatus::kSuccess;
 }
 
-bool ProfileCompilationInfo::MergeWith(const ProfileCompilationInfo& other,
-                                       bool merge_classes) {
-  if (!SameVersion(other)) {
-    LOG(WARNING) << "Cannot merge different profile versions";
-    return false;
+std::unique_ptr<ProfileCompilationInfo::MappedProfile> ProfileCompilationInfo::MappedProfile::Open(
+    int fd,
+    bool for_boot_image,
+    /*out*/ std::string* error,
+    const ProfileLoadFilterFn& filter_fn) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  DCHECK_GE(fd, 0);
+  struct stat stat_buffer;
+  if (fstat(fd, &stat_buffer) != 0) {
+    *error = std::string("Failed to stat profile: ") + strerror(errno);
+    return nullptr;
   }
-
-  // First verify that all checksums match. This will avoid adding garbage to
-  // the current profile info.
-  // Note that the number of elements should be very small, so this should not
-  // be a performance issue.
-  for (const std::unique_ptr<DexFileData>& other_dex_data : other.info_) {
-    // verify_checksum is false because we want to differentiate between a missing dex data and
-    // a mismatched checksum.
-    const DexFileData* dex_data = FindDexData(other_dex_data->profile_key,
-                                              /* checksum= */ 0u,
-                                              /* verify_checksum= */ false);
-    if ((dex_data != nullptr) && (dex_data->checksum != other_dex_data->checksum)) {
-      LOG(WARNING) << "Checksum mismatch for dex " << other_dex_data->profile_key;
-      return false;
-    }
+  if (static_cast<uint64_t>(stat_buffer.st_size) < sizeof(FileHeader)) {
+    *error = "Profile is too small.";
+    return nullptr;
   }
-  // All checksums match. Import the data.
+  MemMap map = MemMap::MapFile(stat_buffer.st_size,
+                               PROT_READ,
+                               MAP_PRIVATE,
+                               fd,
+                               /*start=*/ 0,
+                               /*low_4gb=*/ false,
+                               "mapped profile",
+                               error);
+  if (!map.IsValid()) {
+    return nullptr;
+  }
+  std::unique_ptr<MappedProfile> profile(new MappedProfile(std::move(map)));
+  if (profile->Parse(for_boot_image, filter_fn, error) != ProfileLoadStatus::kSuccess) {
+    DCHECK(!error->empty());
+    return nullptr;
+  }
+  return profile;
+}
 
-  // The other profile might have a different indexing of dex files.
-  // That is because each dex files gets a 'dex_profile_index' on a first come first served basis.
-  // That means that the order in with the methods are added to the profile matters for the
-  // actual indices.
-  // The reason we cannot rely on the actual multidex index is that a single profile may store
-  // data from multiple splits. This means that a profile may contain a classes2.dex from split-A
-  // and one from split-B.
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::MappedProfile::Parse(
+    bool for_boot_image,
+    const ProfileLoadFilterFn& filter_fn,
+    /*out*/ std::string* error) {
+  const uint8_t* begin = map_.Begin();
+  const size_t size = map_.Size();
 
-  // First, build a mapping from other_dex_profile_index to this_dex_profile_index.
-  dchecked_vector<ProfileIndexType> dex_profile_index_remap;
-  dex_profile_index_remap.reserve(other.info_.size());
-  for (const std::unique_ptr<DexFileData>& other_dex_data : other.info_) {
-    const DexFileData* dex_data = GetOrAddDexFileData(other_dex_data->profile_key,
-                                                      other_dex_data->checksum,
-                                                      other_dex_data->num_type_ids,
-                                                      other_dex_data->num_method_ids);
-    if (dex_data == nullptr) {
-      // Could happen if we exceed the number of allowed dex files or there is
-      // a mismatch in `num_type_ids` or `num_method_ids`.
-      return false;
-    }
-    DCHECK_EQ(other_dex_data->profile_index, dex_profile_index_remap.size());
-    dex_profile_index_remap.push_back(dex_data->profile_index);
+  // Read file header.
+  FileHeader header;
+  DCHECK_GE(size, sizeof(FileHeader));
+  memcpy(&header, begin, sizeof(FileHeader));
+  if (!header.IsValid()) {
+    return header.InvalidHeaderMessage(error);
+  }
+  const uint8_t* version = for_boot_image ? kProfileVersionForBootImage : kProfileVersion;
+  if (memcmp(header.GetVersion(), version, kProfileVersionSize) != 0) {
+    *error = for_boot_image ? "Expected boot profile, got app profile."
+                            : "Expected app profile, got boot profile.";
+    return ProfileLoadStatus::kVersionMismatch;
   }
 
-  // Then merge extra descriptors.
-  dchecked_vector<ExtraDescriptorIndex> extra_descriptors_remap;
-  extra_descriptors_remap.reserve(other.extra_descriptors_.size());
-  for (const std::string& other_extra_descriptor : other.extra_descriptors_) {
-    auto it = extra_descriptors_indexes_.find(std::string_view(other_extra_descriptor));
-    if (it != extra_descriptors_indexes_.end()) {
-      extra_descriptors_remap.push_back(*it);
-    } else {
-      ExtraDescriptorIndex extra_descriptor_index = AddExtraDescriptor(other_extra_descriptor);
-      if (extra_descriptor_index == kMaxExtraDescriptors) {
-        // Too many extra descriptors.
-        return false;
+  // Read section infos.
+  uint32_t section_count = header.GetFileSectionCount();
+  if (section_count > (size - sizeof(FileHeader)) / sizeof(FileSectionInfo)) {
+    *error = "Profile EOF reached prematurely for ReadSectionInfos";
+    return ProfileLoadStatus::kBadData;
+  }
+  dchecked_vector<FileSectionInfo> section_infos(section_count);
+  memcpy(section_infos.data(), begin + sizeof(FileHeader), section_count * sizeof(FileSectionInfo));
+  auto is_mapped_section = [&](const FileSectionInfo& section_info) {
+    return section_info.GetInflatedSize() == 0u &&
+           IsAligned<kMappableSectionAlignment>(section_info.GetFileOffset()) &&
+           section_info.GetFileOffset() <= size &&
+           section_info.GetFileSize() <= size - section_info.GetFileOffset();
+  };
+
+  // Read the dex files section. It is small, so simply copy it.
+  const FileSectionInfo& dex_files_section_info = section_infos[0];
+  if (dex_files_section_info.GetType() != FileSectionType::kDexFiles ||
+      !is_mapped_section(dex_files_section_info)) {
+    *error = "Invalid dex files section.";
+    return ProfileLoadStatus::kBadData;
+  }
+  SafeBuffer buffer(dex_files_section_info.GetFileSize());
+  memcpy(buffer.Get(), begin + dex_files_section_info.GetFileOffset(), buffer.Size());
+  ProfileIndexType num_dex_files;
+  if (!buffer.ReadUintAndAdvance(&num_dex_files)) {
+    *error = "Error reading number of dex files.";
+    return ProfileLoadStatus::kBadData;
+  }
+  dex_files_.reserve(num_dex_files);
+  for (ProfileIndexType i = 0u; i != num_dex_files; ++i) {
+    uint32_t checksum, num_type_ids, num_method_ids;
+    std::string_view profile_key;
+    if (!buffer.ReadUintAndAdvance(&checksum) ||
+        !buffer.ReadUintAndAdvance(&num_type_ids) ||
+        !buffer.ReadUintAndAdvance(&num_method_ids) ||
+        !buffer.ReadStringAndAdvance(&profile_key)) {
+      *error = "Error reading dex file data.";
+      return ProfileLoadStatus::kBadData;
+    }
+    std::string key(profile_key);
+    bool accepted = filter_fn(key, checksum);
+    dex_files_.push_back(DexFileEntry{std::move(key),
+                                      checksum,
+                                      num_type_ids,
+                                      num_method_ids,
+                                      /*method_flags=*/ 0u,
+                                      /*hot_methods=*/ {},
+                                      /*saved_bitmap=*/ nullptr,
+                                      /*class_diffs=*/ nullptr,
+                                      /*num_classes=*/ 0u,
+                                      accepted});
+  }
+
+  // Record where the classes of each dex file are. The classes section has no alignment
+  // within, so the type index diffs are read with `memcpy()` by `ContainsClass()`.
+  auto classes_it = std::find_if(section_infos.begin(),
+                                 section_infos.end(),
+                                 [](const FileSectionInfo& section_info) {
+                                   return section_info.GetType() == FileSectionType::kClasses;
+                                 });
+  if (classes_it != section_infos.end()) {
+    if (!is_mapped_section(*classes_it)) {
+      *error = "Invalid classes section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    const uint8_t* ptr = begin + classes_it->GetFileOffset();
+    const uint8_t* const end = ptr + classes_it->GetFileSize();
+    while (ptr != end) {
+      ProfileIndexType profile_index;
+      uint16_t num_classes;
+      if (static_cast<size_t>(end - ptr) < sizeof(profile_index) + sizeof(num_classes)) {
+        *error = "Error reading classes record.";
+        return ProfileLoadStatus::kBadData;
+      }
+      memcpy(&profile_index, ptr, sizeof(profile_index));
+      ptr += sizeof(profile_index);
+      memcpy(&num_classes, ptr, sizeof(num_classes));
+      ptr += sizeof(num_classes);
+      if (profile_index >= dex_files_.size() || dex_files_[profile_index].class_diffs != nullptr) {
+        *error = "Invalid profile index in classes section.";
+        return ProfileLoadStatus::kBadData;
+      }
+      if (static_cast<size_t>(num_classes) * sizeof(uint16_t) >
+              static_cast<size_t>(end - ptr)) {
+        *error = "Classes data exceeds section size.";
+        return ProfileLoadStatus::kBadData;
+      }
+      dex_files_[profile_index].class_diffs = ptr;
+      dex_files_[profile_index].num_classes = num_classes;
+      ptr += static_cast<size_t>(num_classes) * sizeof(uint16_t);
+    }
+  }
+
+  // Find the method index section. Profiles that do not have one were not saved in the
+  // mappable format and their methods cannot be looked up without inflating them.
+  auto it = std::find_if(section_infos.begin(),
+                         section_infos.end(),
+                         [](const FileSectionInfo& section_info) {
+                           return section_info.GetType() == FileSectionType::kMethodIndex;
+                         });
+  if (it == section_infos.end()) {
+    // A profile without any methods does not need a method index.
+    bool has_methods = std::any_of(section_infos.begin(),
+                                   section_infos.end(),
+                                   [](const FileSectionInfo& section_info) {
+                                     return section_info.GetType() == FileSectionType::kMethods;
+                                   });
+    if (has_methods) {
+      *error = "Profile is not in the mappable format.";
+      return ProfileLoadStatus::kBadData;
+    }
+    return ProfileLoadStatus::kSuccess;
+  }
+  if (!is_mapped_section(*it)) {
+    *error = "Invalid method index section.";
+    return ProfileLoadStatus::kBadData;
+  }
+
+  // Record where the data of each dex file is. Only the record headers are read here,
+  // the hot method indexes and bitmaps are accessed on demand by `GetMethodHotness()`.
+  const uint32_t max_method_flags = (for_boot_image ? MethodHotness::kFlagLastBoot
+                                                    : MethodHotness::kFlagLastRegular) * 2u - 1u;
+  const uint8_t* ptr = begin + it->GetFileOffset();
+  const uint8_t* const end = ptr + it->GetFileSize();
+  while (ptr != end) {
+    if (static_cast<size_t>(end - ptr) < 3u * sizeof(uint32_t)) {
+      *error = "Error reading method index record.";
+      return ProfileLoadStatus::kBadData;
+    }
+    const uint32_t* record = reinterpret_cast<const uint32_t*>(ptr);
+    uint32_t profile_index = record[0];
+    uint32_t method_flags = record[1];
+    uint32_t num_hot_methods = record[2];
+    ptr += 3u * sizeof(uint32_t);
+    if (profile_index >= dex_files_.size() || dex_files_[profile_index].method_flags != 0u) {
+      *error = "Invalid profile index in method index section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    DexFileEntry& entry = dex_files_[profile_index];
+    if (method_flags == 0u ||
+        method_flags > max_method_flags ||
+        ((method_flags & MethodHotness::kFlagHot) != 0u) != (num_hot_methods != 0u)) {
+      *error = "Invalid method flags in method index section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    uint64_t hot_methods_size = RoundUp(
+        static_cast<uint64_t>(num_hot_methods) * sizeof(uint16_t), sizeof(uint32_t));
+    uint64_t saved_bitmap_bit_size =
+        static_cast<uint64_t>(POPCOUNT(method_flags & ~MethodHotness::kFlagHot)) *
+        entry.num_method_ids;
+    uint64_t saved_bitmap_size =
+        RoundUp(BitsToBytesRoundUp(saved_bitmap_bit_size), sizeof(uint32_t));
+    if (hot_methods_size + saved_bitmap_size > static_cast<uint64_t>(end - ptr)) {
+      *error = "Method index data exceeds section size.";
+      return ProfileLoadStatus::kBadData;
+    }
+    entry.method_flags = method_flags;
+    entry.hot_methods =
+        ArrayRef<const uint16_t>(reinterpret_cast<const uint16_t*>(ptr), num_hot_methods);
+    ptr += hot_methods_size;
+    entry.saved_bitmap = ptr;
+    ptr += saved_bitmap_size;
+  }
+  return ProfileLoadStatus::kSuccess;
+}
+
+ProfileCompilationInfo::MethodHotness ProfileCompilationInfo::MappedProfile::GetMethodHotness(
+    const MethodReference& method_ref) const {
+  MethodHotness hotness;
+  std::string_view profile_key = GetProfileDexFileBaseKeyView(method_ref.dex_file->GetLocation());
+  for (const DexFileEntry& entry : dex_files_) {
+    if (!entry.accepted || profile_key != GetBaseKeyViewFromAugmentedKey(entry.profile_key)) {
+      continue;
+    }
+    if (!ChecksumMatch(entry.checksum, method_ref.dex_file->GetLocationChecksum()) ||
+        method_ref.index >= entry.num_method_ids) {
+      break;
+    }
+    if ((entry.method_flags & MethodHotness::kFlagHot) != 0u &&
+        IsHotMethod(entry, method_ref.index)) {
+      hotness.AddFlag(MethodHotness::kFlagHot);
+    }
+    // The saved bitmaps follow the order of the flags, see `DexFileData::WriteSavedBitmap()`.
+    uint32_t bitmap_flags = entry.method_flags & ~MethodHotness::kFlagHot;
+    BitMemoryRegion saved_bitmap(const_cast<uint8_t*>(entry.saved_bitmap),
+                                 /*bit_start=*/ 0,
+                                 POPCOUNT(bitmap_flags) * entry.num_method_ids);
+    size_t saved_bitmap_index = 0u;
+    for (uint32_t flags = bitmap_flags; flags != 0u; flags &= flags - 1u) {
+      if (saved_bitmap.LoadBit(saved_bitmap_index * entry.num_method_ids + method_ref.index)) {
+        hotness.AddFlag(enum_cast<MethodHotness::Flag>(LowestOneBitValue(flags)));
+      }
+      ++saved_bitmap_index;
+    }
+    break;
+  }
+  return hotness;
+}
+
+uint32_t ProfileCompilationInfo::MappedProfile::GetNumberOfMethods() const {
+  uint32_t total = 0u;
+  for (const DexFileEntry& entry : dex_files_) {
+    if (entry.accepted) {
+      total += entry.hot_methods.size();
+    }
+  }
+  return total;
+}
+
+uint32_t ProfileCompilationInfo::MappedProfile::GetNumberOfResolvedClasses() const {
+  uint32_t total = 0u;
+  for (const DexFileEntry& entry : dex_files_) {
+    if (entry.accepted) {
+      total += entry.num_classes;
+    }
+  }
+  return total;
+}
+
+const ProfileCompilationInfo::MappedProfile::DexFileEntry*
+ProfileCompilationInfo::MappedProfile::FindEntry(const std::string& profile_key,
+                                                 uint32_t checksum) const {
+  for (const DexFileEntry& entry : dex_files_) {
+    if (entry.accepted && entry.profile_key == profile_key && entry.checksum == checksum) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+bool ProfileCompilationInfo::MappedProfile::IsHotMethod(const DexFileEntry& entry,
+                                                        uint16_t method_index) const {
+  return std::binary_search(entry.hot_methods.begin(), entry.hot_methods.end(), method_index);
+}
+
+bool ProfileCompilationInfo::MappedProfile::ContainsClass(const DexFileEntry& entry,
+                                                          dex::TypeIndex type_index) const {
+  // Type indexes at or above `num_type_ids` refer to extra descriptors of this profile
+  // and cannot be compared with another profile's.
+  if (type_index.index_ >= entry.num_type_ids) {
+    return false;
+  }
+  uint32_t current = 0u;
+  for (uint16_t i = 0u; i != entry.num_classes; ++i) {
+    uint16_t type_index_diff;
+    memcpy(&type_index_diff, entry.class_diffs + i * sizeof(uint16_t), sizeof(uint16_t));
+    current += type_index_diff;
+    if (current >= type_index.index_) {
+      return current == type_index.index_;
+    }
+  }
+  return false;
+}
+
+void ProfileCompilationInfo::MappedProfile::CountNewData(const ProfileCompilationInfo& info,
+                                                         /*out*/ uint32_t* new_methods,
+                                                         /*out*/ uint32_t* new_classes) const {
+  *new_methods = 0u;
+  *new_classes = 0u;
+  for (const std::unique_ptr<DexFileData>& dex_data : info.info_) {
+    const DexFileEntry* entry = FindEntry(dex_data->profile_key, dex_data->checksum);
+    if (entry == nullptr) {
+      *new_methods += dex_data->method_map.size();
+      *new_classes += dex_data->class_set.size();
+      continue;
+    }
+    for (const auto& method_entry : dex_data->method_map) {
+      if (!IsHotMethod(*entry, method_entry.first)) {
+        ++*new_methods;
+      }
+    }
+    for (dex::TypeIndex type_index : dex_data->class_set) {
+      if (type_index.index_ >= dex_data->num_type_ids || !ContainsClass(*entry, type_index)) {
+        ++*new_classes;
+      }
+    }
+  }
+}
+
+bool ProfileCompilationInfo::MergeWith(const ProfileCompilationInfo& other,
+                                       bool merge_classes) {
+  if (!SameVersion(other)) {
+    LOG(WARNING) << "Cannot merge different profile versions";
+    return false;
+  }
+
+  // First verify that all checksums match. This will avoid adding garbage to
+  // the current profile info.
+  // Note that the number of elements should be very small, so this should not
+  // be a performance issue.
+  for (const std::unique_ptr<DexFileData>& other_dex_data : other.info_) {
+    // verify_checksum is false because we want to differentiate between a missing dex data and
+    // a mismatched checksum.
+    const DexFileData* dex_data = FindDexData(other_dex_data->profile_key,
+                                              /* checksum= */ 0u,
+                                              /* verify_checksum= */ false);
+    if ((dex_data != nullptr) && (dex_data->checksum != other_dex_data->checksum)) {
+      LOG(WARNING) << "Checksum mismatch for dex " << other_dex_data->profile_key;
+      return false;
+    }
+  }
+  // All checksums match. Import the data.
+
+  // The other profile might have a different indexing of dex files.
+  // That is because each dex files gets a 'dex_profile_index' on a first come first served basis.
+  // That means that the order in with the methods are added to the profile matters for the
+  // actual indices.
+  // The reason we cannot rely on the actual multidex index is that a single profile may store
+  // data from multiple splits. This means that a profile may contain a classes2.dex from split-A
+  // and one from split-B.
+
+  // First, build a mapping from other_dex_profile_index to this_dex_profile_index.
+  dchecked_vector<ProfileIndexType> dex_profile_index_remap;
+  dex_profile_index_remap.reserve(other.info_.size());
+  for (const std::unique_ptr<DexFileData>& other_dex_data : other.info_) {
+    const DexFileData* dex_data = GetOrAddDexFileData(other_dex_data->profile_key,
+                                                      other_dex_data->checksum,
+                                                      other_dex_data->num_type_ids,
+                                                      other_dex_data->num_method_ids);
+    if (dex_data == nullptr) {
+      // Could happen if we exceed the number of allowed dex files or there is
+      // a mismatch in `num_type_ids` or `num_method_ids`.
+      return false;
+    }
+    DCHECK_EQ(other_dex_data->profile_index, dex_profile_index_remap.size());
+    dex_profile_index_remap.push_back(dex_data->profile_index);
+  }
+
+  // Then merge extra descriptors.
+  dchecked_vector<ExtraDescriptorIndex> extra_descriptors_remap;
+  extra_descriptors_remap.reserve(other.extra_descriptors_.size());
+  for (const std::string& other_extra_descriptor : other.extra_descriptors_) {
+    auto it = extra_descriptors_indexes_.find(std::string_view(other_extra_descriptor));
+    if (it != extra_descriptors_indexes_.end()) {
+      extra_descriptors_remap.push_back(*it);
+    } else {
+      ExtraDescriptorIndex extra_descriptor_index = AddExtraDescriptor(other_extra_descriptor);
+      if (extra_descriptor_index == kMaxExtraDescriptors) {
+        // Too many extra descriptors.
+        return false;
       }
       extra_descriptors_remap.push_back(extra_descriptor_index);
     }
@@ -1995,6 +2721,20 @@ bool ProfileCompilationInfo::MergeWith(const ProfileCompilationInfo& other,
         uint16_t other_dex_pc = other_ic_it.first;
         const ArenaSet<dex::TypeIndex>& other_class_set = other_ic_it.second.classes;
         DexPcData* dex_pc_data = FindOrAddDexPc(inline_cache, other_dex_pc);
+        dex_pc_data->MergeTotalCount(other_ic_it.second.total_count, /*keep_max=*/ false);
+        for (const auto& receiver_it : other_ic_it.second.receiver_counts) {
+          dex::TypeIndex type_index = receiver_it.first;
+          if (type_index.index_ >= num_type_ids) {
+            ExtraDescriptorIndex new_extra_descriptor_index =
+                extra_descriptors_remap[type_index.index_ - num_type_ids];
+            if (new_extra_descriptor_index >= DexFile::kDexNoIndex16 - num_type_ids) {
+              // Cannot represent the type with new extra descriptor index.
+              return false;
+            }
+            type_index = dex::TypeIndex(num_type_ids + new_extra_descriptor_index);
+          }
+          dex_pc_data->MergeReceiverCount(type_index, receiver_it.second, /*keep_max=*/ false);
+        }
         if (other_ic_it.second.is_missing_types) {
           dex_pc_data->SetIsMissingTypes();
         } else if (other_ic_it.second.is_megamorphic) {
@@ -2016,6 +2756,20 @@ bool ProfileCompilationInfo::MergeWith(const ProfileCompilationInfo& other,
       }
     }
 
+    // Merge the branch counts.
+    for (const auto& other_method_it : other_dex_data->branch_profile_map) {
+      BranchCountMap* branch_counts = dex_data->FindOrAddBranchCounts(other_method_it.first);
+      if (branch_counts == nullptr) {
+        return false;
+      }
+      for (const auto& other_branch_it : other_method_it.second) {
+        MergeBranchCounts(branch_counts,
+                          other_branch_it.first,
+                          ArrayRef<const uint32_t>(other_branch_it.second),
+                          /*keep_max=*/ false);
+      }
+    }
+
     // Merge the method bitmaps.
     dex_data->MergeBitmap(*other_dex_data);
   }
@@ -2128,6 +2882,12 @@ std::string ProfileCompilationInfo::DumpInfo(const std::vector<const DexFile*>&
             separator = ",";
           }
         }
+        if (inline_cache_it.second.total_count != 0u) {
+          os << ";counts=" << inline_cache_it.second.total_count;
+          for (const auto& [type_index, count] : inline_cache_it.second.receiver_counts) {
+            os << "," << type_index.index_ << "=" << count;
+          }
+        }
         os << "}";
       }
       os << "], ";
@@ -2346,6 +3106,17 @@ ProfileCompilationInfo::DexFileData::FindOrAddHotMethod(uint16_t method_index) {
       InlineCacheMap(std::less<uint16_t>(), allocator_->Adapter(kArenaAllocProfile)))->second);
 }
 
+ProfileCompilationInfo::BranchCountMap*
+ProfileCompilationInfo::DexFileData::FindOrAddBranchCounts(uint16_t method_index) {
+  if (method_index >= num_method_ids) {
+    LOG(ERROR) << "Invalid method index " << method_index << ". num_method_ids=" << num_method_ids;
+    return nullptr;
+  }
+  return &(branch_profile_map.FindOrAdd(
+      method_index,
+      BranchCountMap(std::less<uint16_t>(), allocator_->Adapter(kArenaAllocProfile)))->second);
+}
+
 // Mark a method as executed at least once.
 bool ProfileCompilationInfo::DexFileData::AddMethod(MethodHotness::Flag flags, size_t index) {
   if (index >= num_method_ids || index > kMaxSupportedMethodIndex) {
@@ -2389,6 +3160,10 @@ ProfileCompilationInfo::MethodHotness ProfileCompilationInfo::DexFileData::GetHo
   if (it != method_map.end()) {
     ret.SetInlineCacheMap(&it->second);
     ret.AddFlag(MethodHotness::kFlagHot);
+    auto branch_it = branch_profile_map.find(dex_method_index);
+    if (branch_it != branch_profile_map.end()) {
+      ret.SetBranchCountMap(&branch_it->second);
+    }
   }
   return ret;
 }
@@ -2429,6 +3204,31 @@ ProfileCompilationInfo::FindOrAddDexPc(InlineCacheMap* inline_cache, uint32_t de
   return &(inline_cache->FindOrAdd(dex_pc, DexPcData(inline_cache->get_allocator()))->second);
 }
 
+void ProfileCompilationInfo::MergeBranchCounts(BranchCountMap* branch_counts,
+                                               uint16_t dex_pc,
+                                               ArrayRef<const uint32_t> counts,
+                                               bool keep_max) {
+  auto it = branch_counts->find(dex_pc);
+  if (it == branch_counts->end()) {
+    branch_counts->Put(
+        dex_pc,
+        ArenaVector<uint32_t>(counts.begin(), counts.end(), branch_counts->get_allocator()));
+    return;
+  }
+  ArenaVector<uint32_t>& existing = it->second;
+  if (existing.size() != counts.size()) {
+    return;
+  }
+  for (size_t i = 0; i != counts.size(); ++i) {
+    if (keep_max) {
+      existing[i] = std::max(existing[i], counts[i]);
+    } else {
+      existing[i] = static_cast<uint32_t>(std::min<uint64_t>(
+          static_cast<uint64_t>(existing[i]) + counts[i], std::numeric_limits<uint32_t>::max()));
+    }
+  }
+}
+
 HashSet<std::string> ProfileCompilationInfo::GetClassDescriptors(
     const std::vector<const DexFile*>& dex_files,
     const ProfileSampleAnnotation& annotation) {
@@ -2682,25 +3482,7 @@ void ProfileCompilationInfo::DexFileData::WriteMethods(SafeBuffer& buffer) const
   buffer.WriteUintAndAdvance(method_flags);
 
   // Write the bitmap data.
-  size_t saved_bitmap_byte_size = BitsToBytesRoundUp(saved_bitmap_bit_size);
-  DCHECK_LE(saved_bitmap_byte_size, buffer.GetAvailableBytes());
-  BitMemoryRegion saved_bitmap(buffer.GetCurrentPtr(), /*bit_start=*/ 0, saved_bitmap_bit_size);
-  size_t saved_bitmap_index = 0u;
-  ForMethodBitmapHotnessFlags([&](MethodHotness::Flag flag) {
-    if ((method_flags & flag) != 0u) {
-      size_t index = FlagBitmapIndex(static_cast<MethodHotness::Flag>(flag));
-      BitMemoryRegion src = method_bitmap.Subregion(index * num_method_ids, num_method_ids);
-      saved_bitmap.Subregion(saved_bitmap_index * num_method_ids, num_method_ids).CopyBits(src);
-      ++saved_bitmap_index;
-    }
-    return true;
-  });
-  DCHECK_EQ(saved_bitmap_index * num_method_ids, saved_bitmap_bit_size);
-  // Clear the padding bits.
-  size_t padding_bit_size = saved_bitmap_byte_size * kBitsPerByte - saved_bitmap_bit_size;
-  BitMemoryRegion padding_region(buffer.GetCurrentPtr(), saved_bitmap_bit_size, padding_bit_size);
-  padding_region.StoreBits(/*bit_offset=*/ 0u, /*value=*/ 0u, /*bit_length=*/ padding_bit_size);
-  buffer.Advance(saved_bitmap_byte_size);
+  WriteSavedBitmap(buffer, method_flags, saved_bitmap_bit_size);
 
   uint16_t last_method_index = 0;
   for (const auto& method_entry : method_map) {
@@ -2744,7 +3526,8 @@ void ProfileCompilationInfo::DexFileData::WriteMethods(SafeBuffer& buffer) const
       }
 
       DCHECK_LT(classes.size(), ProfileCompilationInfo::kIndividualInlineCacheSize);
-      DCHECK_NE(classes.size(), 0u) << "InlineCache contains a dex_pc with 0 classes";
+      DCHECK(classes.size() != 0u || dex_pc_data.total_count != 0u)
+          << "InlineCache contains a dex_pc with 0 classes";
 
       // Add the number of classes for the dex PC.
       buffer.WriteUintAndAdvance(dchecked_integral_cast<uint8_t>(classes.size()));
@@ -2757,6 +3540,65 @@ void ProfileCompilationInfo::DexFileData::WriteMethods(SafeBuffer& buffer) const
   DCHECK_EQ(buffer.GetAvailableBytes(), expected_available_bytes_at_end);
 }
 
+void ProfileCompilationInfo::DexFileData::WriteSavedBitmap(SafeBuffer& buffer,
+                                                           uint16_t method_flags,
+                                                           size_t saved_bitmap_bit_size) const {
+  size_t saved_bitmap_byte_size = BitsToBytesRoundUp(saved_bitmap_bit_size);
+  DCHECK_LE(saved_bitmap_byte_size, buffer.GetAvailableBytes());
+  BitMemoryRegion saved_bitmap(buffer.GetCurrentPtr(), /*bit_start=*/ 0, saved_bitmap_bit_size);
+  size_t saved_bitmap_index = 0u;
+  ForMethodBitmapHotnessFlags([&](MethodHotness::Flag flag) {
+    if ((method_flags & flag) != 0u) {
+      size_t index = FlagBitmapIndex(static_cast<MethodHotness::Flag>(flag));
+      BitMemoryRegion src = method_bitmap.Subregion(index * num_method_ids, num_method_ids);
+      saved_bitmap.Subregion(saved_bitmap_index * num_method_ids, num_method_ids).CopyBits(src);
+      ++saved_bitmap_index;
+    }
+    return true;
+  });
+  DCHECK_EQ(saved_bitmap_index * num_method_ids, saved_bitmap_bit_size);
+  // Clear the padding bits.
+  size_t padding_bit_size = saved_bitmap_byte_size * kBitsPerByte - saved_bitmap_bit_size;
+  BitMemoryRegion padding_region(buffer.GetCurrentPtr(), saved_bitmap_bit_size, padding_bit_size);
+  padding_region.StoreBits(/*bit_offset=*/ 0u, /*value=*/ 0u, /*bit_length=*/ padding_bit_size);
+  buffer.Advance(saved_bitmap_byte_size);
+}
+
+uint32_t ProfileCompilationInfo::DexFileData::MethodIndexDataSize() const {
+  uint16_t method_flags = GetUsedBitmapFlags();
+  size_t saved_bitmap_bit_size = POPCOUNT(method_flags) * num_method_ids;
+  if (method_flags == 0u && method_map.empty()) {
+    return 0u;
+  }
+  return 3u * sizeof(uint32_t) +  // Profile index, method flags, number of hot methods.
+         RoundUp(method_map.size() * sizeof(uint16_t), sizeof(uint32_t)) +
+         RoundUp(BitsToBytesRoundUp(saved_bitmap_bit_size), sizeof(uint32_t));
+}
+
+void ProfileCompilationInfo::DexFileData::WriteMethodIndex(SafeBuffer& buffer) const {
+  uint16_t method_flags = GetUsedBitmapFlags();
+  size_t saved_bitmap_bit_size = POPCOUNT(method_flags) * num_method_ids;
+  if (!method_map.empty()) {
+    method_flags |= enum_cast<uint16_t>(MethodHotness::kFlagHot);
+  }
+  if (method_flags == 0u) {
+    return;  // No data to write.
+  }
+  static constexpr uint8_t kPadding[sizeof(uint32_t)] = {};
+  buffer.WriteUintAndAdvance<uint32_t>(profile_index);
+  buffer.WriteUintAndAdvance<uint32_t>(method_flags);
+  buffer.WriteUintAndAdvance(dchecked_integral_cast<uint32_t>(method_map.size()));
+  for (const auto& method_entry : method_map) {
+    buffer.WriteUintAndAdvance(method_entry.first);
+  }
+  size_t hot_methods_size = method_map.size() * sizeof(uint16_t);
+  buffer.WriteAndAdvance(kPadding, RoundUp(hot_methods_size, sizeof(uint32_t)) - hot_methods_size);
+  WriteSavedBitmap(buffer, method_flags, saved_bitmap_bit_size);
+  size_t saved_bitmap_byte_size = BitsToBytesRoundUp(saved_bitmap_bit_size);
+  buffer.WriteAndAdvance(
+      kPadding, RoundUp(saved_bitmap_byte_size, sizeof(uint32_t)) - saved_bitmap_byte_size);
+}
+
 ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::ReadMethods(
     SafeBuffer& buffer,
     const dchecked_vector<ExtraDescriptorIndex>& extra_descriptors_remap,
@@ -2919,6 +3761,361 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::S
   return ProfileLoadStatus::kSuccess;
 }
 
+uint32_t ProfileCompilationInfo::DexFileData::BranchProfilesDataSize() const {
+  size_t num_methods = 0u;
+  size_t num_branches = 0u;
+  size_t num_counts = 0u;
+  for (const auto& method_entry : branch_profile_map) {
+    if (method_entry.second.empty()) {
+      continue;
+    }
+    ++num_methods;
+    num_branches += method_entry.second.size();
+    for (const auto& branch_entry : method_entry.second) {
+      num_counts += branch_entry.second.size();
+    }
+  }
+  if (num_methods == 0u) {
+    return 0u;
+  }
+
+  constexpr size_t kPerMethodSize =
+      sizeof(uint16_t) +  // Method index diff.
+      sizeof(uint16_t);   // Number of branches.
+  constexpr size_t kPerBranchSize =
+      sizeof(uint16_t) +  // Dex PC.
+      sizeof(uint16_t);   // Number of counts.
+  return sizeof(ProfileIndexType) +        // Which dex file.
+         sizeof(uint32_t) +                // Total size of following data.
+         num_methods * kPerMethodSize +    // Data for methods.
+         num_branches * kPerBranchSize +   // Data for branches.
+         num_counts * sizeof(uint32_t);    // Counts.
+}
+
+void ProfileCompilationInfo::DexFileData::WriteBranchProfiles(SafeBuffer& buffer) const {
+  uint32_t branch_profiles_data_size = BranchProfilesDataSize();
+  if (branch_profiles_data_size == 0u) {
+    return;  // No data to write.
+  }
+  DCHECK_GE(buffer.GetAvailableBytes(), branch_profiles_data_size);
+  uint32_t expected_available_bytes_at_end =
+      buffer.GetAvailableBytes() - branch_profiles_data_size;
+
+  buffer.WriteUintAndAdvance(profile_index);
+  uint32_t following_data_size =
+      branch_profiles_data_size - sizeof(ProfileIndexType) - sizeof(uint32_t);
+  buffer.WriteUintAndAdvance(following_data_size);
+
+  uint16_t last_method_index = 0;
+  for (const auto& method_entry : branch_profile_map) {
+    const BranchCountMap& branch_count_map = method_entry.second;
+    if (branch_count_map.empty()) {
+      continue;
+    }
+    // Store the difference between the method indices for better compression.
+    uint16_t method_index = method_entry.first;
+    DCHECK_GE(method_index, last_method_index);
+    buffer.WriteUintAndAdvance(static_cast<uint16_t>(method_index - last_method_index));
+    last_method_index = method_index;
+
+    buffer.WriteUintAndAdvance(dchecked_integral_cast<uint16_t>(branch_count_map.size()));
+    for (const auto& branch_entry : branch_count_map) {
+      buffer.WriteUintAndAdvance(branch_entry.first);
+      buffer.WriteUintAndAdvance(dchecked_integral_cast<uint16_t>(branch_entry.second.size()));
+      for (uint32_t count : branch_entry.second) {
+        buffer.WriteUintAndAdvance(count);
+      }
+    }
+  }
+
+  // Check if we've written the right number of bytes.
+  DCHECK_EQ(buffer.GetAvailableBytes(), expected_available_bytes_at_end);
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::ReadBranchProfiles(
+    SafeBuffer& buffer,
+    std::string* error) {
+  uint32_t following_data_size;
+  if (!buffer.ReadUintAndAdvance(&following_data_size)) {
+    *error = "Error reading branch profiles data size.";
+    return ProfileLoadStatus::kBadData;
+  }
+  if (following_data_size > buffer.GetAvailableBytes()) {
+    *error = "Branch profiles data size exceeds available data size.";
+    return ProfileLoadStatus::kBadData;
+  }
+  uint32_t expected_available_bytes_at_end = buffer.GetAvailableBytes() - following_data_size;
+
+  uint32_t num_valid_method_indexes =
+      std::min<uint32_t>(kMaxSupportedMethodIndex + 1u, num_method_ids);
+  uint16_t method_index = 0;
+  bool first_diff = true;
+  while (buffer.GetAvailableBytes() > expected_available_bytes_at_end) {
+    uint16_t diff_with_last_method_index;
+    uint16_t num_branches;
+    if (!buffer.ReadUintAndAdvance(&diff_with_last_method_index) ||
+        !buffer.ReadUintAndAdvance(&num_branches)) {
+      *error = "Error reading branch profile method data.";
+      return ProfileLoadStatus::kBadData;
+    }
+    if (diff_with_last_method_index == 0u && !first_diff) {
+      *error = "Duplicate branch profile method index.";
+      return ProfileLoadStatus::kBadData;
+    }
+    first_diff = false;
+    if (diff_with_last_method_index >= num_valid_method_indexes - method_index) {
+      *error = "Invalid branch profile method index.";
+      return ProfileLoadStatus::kBadData;
+    }
+    method_index += diff_with_last_method_index;
+    BranchCountMap* branch_counts = FindOrAddBranchCounts(method_index);
+    DCHECK(branch_counts != nullptr);
+
+    for (uint16_t i = 0; i != num_branches; ++i) {
+      uint16_t dex_pc;
+      uint16_t num_counts;
+      if (!buffer.ReadUintAndAdvance(&dex_pc) || !buffer.ReadUintAndAdvance(&num_counts)) {
+        *error = "Error reading branch profile data.";
+        return ProfileLoadStatus::kBadData;
+      }
+      if (num_counts < 2u || num_counts * sizeof(uint32_t) > buffer.GetAvailableBytes()) {
+        *error = "Invalid number of branch counts.";
+        return ProfileLoadStatus::kBadData;
+      }
+      dchecked_vector<uint32_t> counts(num_counts);
+      for (uint32_t& count : counts) {
+        if (!buffer.ReadUintAndAdvance(&count)) {
+          *error = "Error reading branch count.";
+          return ProfileLoadStatus::kBadData;
+        }
+      }
+      MergeBranchCounts(
+          branch_counts, dex_pc, ArrayRef<const uint32_t>(counts), /*keep_max=*/ false);
+    }
+  }
+
+  if (buffer.GetAvailableBytes() != expected_available_bytes_at_end) {
+    *error = "Branch profiles data did not end at expected position.";
+    return ProfileLoadStatus::kBadData;
+  }
+  return ProfileLoadStatus::kSuccess;
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::SkipBranchProfiles(
+    SafeBuffer& buffer,
+    std::string* error) {
+  uint32_t following_data_size;
+  if (!buffer.ReadUintAndAdvance(&following_data_size)) {
+    *error = "Error reading branch profiles data size to skip.";
+    return ProfileLoadStatus::kBadData;
+  }
+  if (following_data_size > buffer.GetAvailableBytes()) {
+    *error = "Branch profiles data size to skip exceeds remaining data.";
+    return ProfileLoadStatus::kBadData;
+  }
+  buffer.Advance(following_data_size);
+  return ProfileLoadStatus::kSuccess;
+}
+
+uint32_t ProfileCompilationInfo::DexFileData::ReceiverCountsDataSize() const {
+  size_t num_methods = 0u;
+  size_t num_call_sites = 0u;
+  size_t num_receivers = 0u;
+  for (const auto& method_entry : method_map) {
+    bool has_counts = false;
+    for (const auto& inline_cache_entry : method_entry.second) {
+      const DexPcData& dex_pc_data = inline_cache_entry.second;
+      if (dex_pc_data.total_count != 0u || !dex_pc_data.receiver_counts.empty()) {
+        has_counts = true;
+        ++num_call_sites;
+        num_receivers += dex_pc_data.receiver_counts.size();
+      }
+    }
+    if (has_counts) {
+      ++num_methods;
+    }
+  }
+  if (num_methods == 0u) {
+    return 0u;
+  }
+
+  constexpr size_t kPerMethodSize =
+      sizeof(uint16_t) +  // Method index diff.
+      sizeof(uint16_t);   // Number of call sites.
+  constexpr size_t kPerCallSiteSize =
+      sizeof(uint16_t) +  // Dex PC.
+      sizeof(uint32_t) +  // Total count.
+      sizeof(uint8_t);    // Number of receivers.
+  constexpr size_t kPerReceiverSize =
+      sizeof(uint16_t) +  // Type index.
+      sizeof(uint32_t);   // Count.
+  return sizeof(ProfileIndexType) +              // Which dex file.
+         sizeof(uint32_t) +                      // Total size of following data.
+         num_methods * kPerMethodSize +          // Data for methods.
+         num_call_sites * kPerCallSiteSize +     // Data for call sites.
+         num_receivers * kPerReceiverSize;       // Data for receivers.
+}
+
+void ProfileCompilationInfo::DexFileData::WriteReceiverCounts(SafeBuffer& buffer) const {
+  uint32_t receiver_counts_data_size = ReceiverCountsDataSize();
+  if (receiver_counts_data_size == 0u) {
+    return;  // No data to write.
+  }
+  DCHECK_GE(buffer.GetAvailableBytes(), receiver_counts_data_size);
+  uint32_t expected_available_bytes_at_end =
+      buffer.GetAvailableBytes() - receiver_counts_data_size;
+
+  buffer.WriteUintAndAdvance(profile_index);
+  uint32_t following_data_size =
+      receiver_counts_data_size - sizeof(ProfileIndexType) - sizeof(uint32_t);
+  buffer.WriteUintAndAdvance(following_data_size);
+
+  auto has_counts = [](const DexPcData& dex_pc_data) {
+    return dex_pc_data.total_count != 0u || !dex_pc_data.receiver_counts.empty();
+  };
+  uint16_t last_method_index = 0;
+  for (const auto& method_entry : method_map) {
+    const InlineCacheMap& inline_cache_map = method_entry.second;
+    size_t num_call_sites = std::count_if(
+        inline_cache_map.begin(),
+        inline_cache_map.end(),
+        [&](const auto& inline_cache_entry) { return has_counts(inline_cache_entry.second); });
+    if (num_call_sites == 0u) {
+      continue;
+    }
+    // Store the difference between the method indices for better compression.
+    uint16_t method_index = method_entry.first;
+    DCHECK_GE(method_index, last_method_index);
+    buffer.WriteUintAndAdvance(static_cast<uint16_t>(method_index - last_method_index));
+    last_method_index = method_index;
+
+    buffer.WriteUintAndAdvance(dchecked_integral_cast<uint16_t>(num_call_sites));
+    for (const auto& inline_cache_entry : inline_cache_map) {
+      const DexPcData& dex_pc_data = inline_cache_entry.second;
+      if (!has_counts(dex_pc_data)) {
+        continue;
+      }
+      buffer.WriteUintAndAdvance(inline_cache_entry.first);
+      buffer.WriteUintAndAdvance(dex_pc_data.total_count);
+      buffer.WriteUintAndAdvance(
+          dchecked_integral_cast<uint8_t>(dex_pc_data.receiver_counts.size()));
+      for (const auto& receiver_entry : dex_pc_data.receiver_counts) {
+        buffer.WriteUintAndAdvance(receiver_entry.first.index_);
+        buffer.WriteUintAndAdvance(receiver_entry.second);
+      }
+    }
+  }
+
+  // Check if we've written the right number of bytes.
+  DCHECK_EQ(buffer.GetAvailableBytes(), expected_available_bytes_at_end);
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::ReadReceiverCounts(
+    SafeBuffer& buffer,
+    const dchecked_vector<ExtraDescriptorIndex>& extra_descriptors_remap,
+    std::string* error) {
+  uint32_t following_data_size;
+  if (!buffer.ReadUintAndAdvance(&following_data_size)) {
+    *error = "Error reading receiver counts data size.";
+    return ProfileLoadStatus::kBadData;
+  }
+  if (following_data_size > buffer.GetAvailableBytes()) {
+    *error = "Receiver counts data size exceeds available data size.";
+    return ProfileLoadStatus::kBadData;
+  }
+  uint32_t expected_available_bytes_at_end = buffer.GetAvailableBytes() - following_data_size;
+
+  uint32_t num_valid_method_indexes =
+      std::min<uint32_t>(kMaxSupportedMethodIndex + 1u, num_method_ids);
+  size_t num_valid_type_indexes =
+      std::min<size_t>(num_type_ids + extra_descriptors_remap.size(), DexFile::kDexNoIndex16);
+  uint16_t method_index = 0;
+  bool first_diff = true;
+  while (buffer.GetAvailableBytes() > expected_available_bytes_at_end) {
+    uint16_t diff_with_last_method_index;
+    uint16_t num_call_sites;
+    if (!buffer.ReadUintAndAdvance(&diff_with_last_method_index) ||
+        !buffer.ReadUintAndAdvance(&num_call_sites)) {
+      *error = "Error reading receiver counts method data.";
+      return ProfileLoadStatus::kBadData;
+    }
+    if (diff_with_last_method_index == 0u && !first_diff) {
+      *error = "Duplicate receiver counts method index.";
+      return ProfileLoadStatus::kBadData;
+    }
+    first_diff = false;
+    if (diff_with_last_method_index >= num_valid_method_indexes - method_index) {
+      *error = "Invalid receiver counts method index.";
+      return ProfileLoadStatus::kBadData;
+    }
+    method_index += diff_with_last_method_index;
+    InlineCacheMap* inline_cache = FindOrAddHotMethod(method_index);
+    DCHECK(inline_cache != nullptr);
+
+    for (uint16_t i = 0; i != num_call_sites; ++i) {
+      uint16_t dex_pc;
+      uint32_t total_count;
+      uint8_t num_receivers;
+      if (!buffer.ReadUintAndAdvance(&dex_pc) ||
+          !buffer.ReadUintAndAdvance(&total_count) ||
+          !buffer.ReadUintAndAdvance(&num_receivers)) {
+        *error = "Error reading receiver counts call site data.";
+        return ProfileLoadStatus::kBadData;
+      }
+      if (num_receivers > kIndividualInlineCacheSize) {
+        *error = "Too many receiver counts.";
+        return ProfileLoadStatus::kBadData;
+      }
+      DexPcData* dex_pc_data = FindOrAddDexPc(inline_cache, dex_pc);
+      dex_pc_data->MergeTotalCount(total_count, /*keep_max=*/ false);
+      for (uint8_t j = 0; j != num_receivers; ++j) {
+        uint16_t type_index;
+        uint32_t count;
+        if (!buffer.ReadUintAndAdvance(&type_index) || !buffer.ReadUintAndAdvance(&count)) {
+          *error = "Error reading receiver count.";
+          return ProfileLoadStatus::kBadData;
+        }
+        if (type_index >= num_valid_type_indexes) {
+          *error = "Invalid receiver type index.";
+          return ProfileLoadStatus::kBadData;
+        }
+        if (type_index >= num_type_ids) {
+          ExtraDescriptorIndex new_extra_descriptor_index =
+              extra_descriptors_remap[type_index - num_type_ids];
+          if (new_extra_descriptor_index >= DexFile::kDexNoIndex16 - num_type_ids) {
+            *error = "Remapped receiver type index out of range.";
+            return ProfileLoadStatus::kMergeError;
+          }
+          type_index = num_type_ids + new_extra_descriptor_index;
+        }
+        dex_pc_data->MergeReceiverCount(dex::TypeIndex(type_index), count, /*keep_max=*/ false);
+      }
+    }
+  }
+
+  if (buffer.GetAvailableBytes() != expected_available_bytes_at_end) {
+    *error = "Receiver counts data did not end at expected position.";
+    return ProfileLoadStatus::kBadData;
+  }
+  return ProfileLoadStatus::kSuccess;
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::SkipReceiverCounts(
+    SafeBuffer& buffer,
+    std::string* error) {
+  uint32_t following_data_size;
+  if (!buffer.ReadUintAndAdvance(&following_data_size)) {
+    *error = "Error reading receiver counts data size to skip.";
+    return ProfileLoadStatus::kBadData;
+  }
+  if (following_data_size > buffer.GetAvailableBytes()) {
+    *error = "Receiver counts data size to skip exceeds remaining data.";
+    return ProfileLoadStatus::kBadData;
+  }
+  buffer.Advance(following_data_size);
+  return ProfileLoadStatus::kSuccess;
+}
+
 void ProfileCompilationInfo::DexFileData::WriteClassSet(
     SafeBuffer& buffer,
     const ArenaSet<dex::TypeIndex>& class_set) {
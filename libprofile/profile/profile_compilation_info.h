@@ -50,11 +50,15 @@ struct ProfileMethodInfo {
                        bool missing_types,
                        const std::vector<TypeReference>& profile_classes,
                        // Only used by profman for creating profiles from text
-                       bool megamorphic = false)
+                       bool megamorphic = false,
+                       const std::vector<uint32_t>& class_counts = {},
+                       uint32_t total = 0u)
         : dex_pc(pc),
           is_missing_types(missing_types),
           classes(profile_classes),
-          is_megamorphic(megamorphic) {}
+          is_megamorphic(megamorphic),
+          counts(class_counts),
+          total_count(total) {}
 
     const uint32_t dex_pc;
     const bool is_missing_types;
@@ -63,6 +67,23 @@ struct ProfileMethodInfo {
     // by the profman. See `ProfileCompilationInfo::FindOrCreateTypeIndex()`.
     const std::vector<TypeReference> classes;
     const bool is_megamorphic;
+    // The number of times each of `classes` was seen as the receiver, or empty if unknown.
+    // A zero count means that the class was seen but its count is unknown.
+    const std::vector<uint32_t> counts;
+    // The number of calls made at the dex pc, including those with other receivers.
+    const uint32_t total_count;
+  };
+
+  struct ProfileBranchCounts {
+    ProfileBranchCounts(uint32_t pc, const std::vector<uint32_t>& branch_counts)
+        : dex_pc(pc),
+          counts(branch_counts) {}
+
+    const uint32_t dex_pc;
+    // For an IF_* instruction, the number of times the branch was not taken and taken.
+    // For a PACKED_SWITCH instruction, the number of times each entry was taken followed
+    // by the number of times the default target was taken.
+    const std::vector<uint32_t> counts;
   };
 
   explicit ProfileMethodInfo(MethodReference reference) : ref(reference) {}
@@ -71,8 +92,16 @@ struct ProfileMethodInfo {
       : ref(reference),
         inline_caches(caches) {}
 
+  ProfileMethodInfo(MethodReference reference,
+                    const std::vector<ProfileInlineCache>& caches,
+                    const std::vector<ProfileBranchCounts>& branches)
+      : ref(reference),
+        inline_caches(caches),
+        branch_counts(branches) {}
+
   MethodReference ref;
   std::vector<ProfileInlineCache> inline_caches;
+  std::vector<ProfileBranchCounts> branch_counts;
 };
 
 class FlattenProfileData;
@@ -132,14 +161,22 @@ class ProfileCompilationInfo {
   // Encodes the actual inline cache for a given dex pc (whether or not the receiver is
   // megamorphic and its possible types).
   // If the receiver is megamorphic or is missing types the set of classes will be empty.
+  // The receiver counts are kept in both cases so that the compiler can still find the
+  // dominant receivers of a megamorphic call.
   struct DexPcData : public ArenaObject<kArenaAllocProfile> {
     explicit DexPcData(ArenaAllocator* allocator)
         : DexPcData(allocator->Adapter(kArenaAllocProfile)) {}
     explicit DexPcData(const ArenaAllocatorAdapter<void>& allocator)
         : is_missing_types(false),
           is_megamorphic(false),
-          classes(std::less<dex::TypeIndex>(), allocator) {}
+          classes(std::less<dex::TypeIndex>(), allocator),
+          receiver_counts(std::less<dex::TypeIndex>(), allocator),
+          total_count(0u) {}
     void AddClass(const dex::TypeIndex& type_idx);
+    // Merge the count of a receiver class and the total count of the call. The runtime reports
+    // cumulative counts, so `keep_max` is used when adding them, otherwise the counts are added.
+    void MergeReceiverCount(dex::TypeIndex type_idx, uint32_t count, bool keep_max);
+    void MergeTotalCount(uint32_t count, bool keep_max);
     void SetIsMegamorphic() {
       if (is_missing_types) return;
       is_megamorphic = true;
@@ -153,7 +190,9 @@ class ProfileCompilationInfo {
     bool operator==(const DexPcData& other) const {
       return is_megamorphic == other.is_megamorphic &&
           is_missing_types == other.is_missing_types &&
-          classes == other.classes;
+          classes == other.classes &&
+          receiver_counts == other.receiver_counts &&
+          total_count == other.total_count;
     }
 
     // Not all runtime types can be encoded in the profile. For example if the receiver
@@ -162,6 +201,10 @@ class ProfileCompilationInfo {
     bool is_missing_types;
     bool is_megamorphic;
     ArenaSet<dex::TypeIndex> classes;
+    // The number of times the most frequent receivers were seen, at most
+    // `kIndividualInlineCacheSize` of them, and the total number of calls.
+    ArenaSafeMap<dex::TypeIndex, uint32_t> receiver_counts;
+    uint32_t total_count;
   };
 
   // The inline cache map: DexPc -> DexPcData.
@@ -170,6 +213,13 @@ class ProfileCompilationInfo {
   // Maps a method dex index to its inline cache.
   using MethodMap = ArenaSafeMap<uint16_t, InlineCacheMap>;
 
+  // The branch count map: DexPc -> counts of the IF_* or PACKED_SWITCH instruction,
+  // in the same order as in `ProfileMethodInfo::ProfileBranchCounts`.
+  using BranchCountMap = ArenaSafeMap<uint16_t, ArenaVector<uint32_t>>;
+
+  // Maps a method dex index to its branch counts.
+  using BranchProfileMap = ArenaSafeMap<uint16_t, BranchCountMap>;
+
   // Profile method hotness information for a single method. Also includes a pointer to the inline
   // cache map.
   class MethodHotness {
@@ -244,14 +294,23 @@ class ProfileCompilationInfo {
       return inline_cache_map_;
     }
 
+    const BranchCountMap* GetBranchCountMap() const {
+      return branch_count_map_;
+    }
+
    private:
     const InlineCacheMap* inline_cache_map_ = nullptr;
+    const BranchCountMap* branch_count_map_ = nullptr;
     uint32_t flags_ = 0;
 
     void SetInlineCacheMap(const InlineCacheMap* info) {
       inline_cache_map_ = info;
     }
 
+    void SetBranchCountMap(const BranchCountMap* info) {
+      branch_count_map_ = info;
+    }
+
     friend class ProfileCompilationInfo;
   };
 
@@ -486,8 +545,26 @@ class ProfileCompilationInfo {
   bool Save(const std::string& filename, uint64_t* bytes_written);
 
   // A fallback implementation of `Save` that uses a flock.
+  // Profiles in the mappable format are updated in place and `bytes_written` is set to
+  // the number of bytes that actually changed, not counting the header. The header is
+  // invalidated while the update is in progress, so that an interrupted save leaves a
+  // profile that is rejected rather than one mixing old and new data.
   bool SaveFallback(const std::string& filename, uint64_t* bytes_written);
 
+  // Whether `Save` writes the mappable variant of the profile format. In this variant all
+  // sections are stored uncompressed and an additional method index section records the
+  // sorted hot method indexes and the method flag bitmaps of each dex file, so that hotness
+  // can be queried from the mapped file with `MappedProfile`. Old versions of ART can load
+  // the mappable variant as they ignore the method index section.
+  void SetMappableFormat(bool mappable_format) {
+    mappable_format_ = mappable_format;
+  }
+  bool IsMappableFormat() const {
+    return mappable_format_;
+  }
+
+  class MappedProfile;
+
   // Return the number of dex files referenced in the profile.
   size_t GetNumberOfDexFiles() const {
     return info_.size();
@@ -787,6 +864,7 @@ class ProfileCompilationInfo {
           profile_index(index),
           checksum(location_checksum),
           method_map(std::less<uint16_t>(), allocator->Adapter(kArenaAllocProfile)),
+          branch_profile_map(std::less<uint16_t>(), allocator->Adapter(kArenaAllocProfile)),
           class_set(std::less<dex::TypeIndex>(), allocator->Adapter(kArenaAllocProfile)),
           num_type_ids(num_types),
           num_method_ids(num_methods),
@@ -818,6 +896,7 @@ class ProfileCompilationInfo {
       return checksum == other.checksum &&
           num_method_ids == other.num_method_ids &&
           method_map == other.method_map &&
+          branch_profile_map == other.branch_profile_map &&
           class_set == other.class_set &&
           BitMemoryRegion::Equals(method_bitmap, other.method_bitmap);
     }
@@ -885,6 +964,22 @@ class ProfileCompilationInfo {
         std::string* error);
     static ProfileLoadStatus SkipMethods(SafeBuffer& buffer, std::string* error);
 
+    uint32_t MethodIndexDataSize() const;
+    void WriteMethodIndex(SafeBuffer& buffer) const;
+
+    uint32_t BranchProfilesDataSize() const;
+    void WriteBranchProfiles(SafeBuffer& buffer) const;
+    ProfileLoadStatus ReadBranchProfiles(SafeBuffer& buffer, std::string* error);
+    static ProfileLoadStatus SkipBranchProfiles(SafeBuffer& buffer, std::string* error);
+
+    uint32_t ReceiverCountsDataSize() const;
+    void WriteReceiverCounts(SafeBuffer& buffer) const;
+    ProfileLoadStatus ReadReceiverCounts(
+        SafeBuffer& buffer,
+        const dchecked_vector<ExtraDescriptorIndex>& extra_descriptors_remap,
+        std::string* error);
+    static ProfileLoadStatus SkipReceiverCounts(SafeBuffer& buffer, std::string* error);
+
     // The allocator used to allocate new inline cache maps.
     ArenaAllocator* const allocator_;
     // The profile key this data belongs to.
@@ -895,12 +990,17 @@ class ProfileCompilationInfo {
     uint32_t checksum;
     // The methods' profile information.
     MethodMap method_map;
+    // The branch counts of the methods.
+    BranchProfileMap branch_profile_map;
     // The classes which have been profiled. Note that these don't necessarily include
     // all the classes that can be found in the inline caches reference.
     ArenaSet<dex::TypeIndex> class_set;
     // Find the inline caches of the the given method index. Add an empty entry if
     // no previous data is found.
     InlineCacheMap* FindOrAddHotMethod(uint16_t method_index);
+    // Find the branch counts of the given method index. Add an empty entry if
+    // no previous data is found.
+    BranchCountMap* FindOrAddBranchCounts(uint16_t method_index);
     // Num type ids.
     uint32_t num_type_ids;
     // Num method ids.
@@ -947,6 +1047,11 @@ class ProfileCompilationInfo {
 
     static void WriteClassSet(SafeBuffer& buffer, const ArenaSet<dex::TypeIndex>& class_set);
 
+    // Write the bitmaps for the flags in `method_flags`, other than "hot", one after another.
+    void WriteSavedBitmap(SafeBuffer& buffer,
+                          uint16_t method_flags,
+                          size_t saved_bitmap_bit_size) const;
+
     uint16_t GetUsedBitmapFlags() const;
   };
 
@@ -987,6 +1092,15 @@ class ProfileCompilationInfo {
   // Add a new extra descriptor. Returns kMaxExtraDescriptors on failure.
   ExtraDescriptorIndex AddExtraDescriptor(std::string_view extra_descriptor);
 
+  // Serialize the profile to `fd`. If `in_place` is true, `fd` may hold a previous version of
+  // the profile and only the blocks that differ from it are written; the caller is responsible
+  // for truncating the file to `file_size`. The number of bytes actually written, except for
+  // the header of an in-place save, is returned in `bytes_written`.
+  bool SaveInternal(int fd,
+                    bool in_place,
+                    /*out*/ uint64_t* file_size,
+                    /*out*/ uint64_t* bytes_written);
+
   // Parsing functionality.
 
   ProfileLoadStatus OpenSource(int32_t fd,
@@ -1032,10 +1146,31 @@ class ProfileCompilationInfo {
       bool merge_classes = true,
       const ProfileLoadFilterFn& filter_fn = ProfileFilterFnAcceptAll);
 
+  ProfileLoadStatus ReadBranchProfilesSection(
+      ProfileSource& source,
+      const FileSectionInfo& section_info,
+      const dchecked_vector<ProfileIndexType>& dex_profile_index_remap,
+      /*out*/ std::string* error);
+
+  ProfileLoadStatus ReadReceiverCountsSection(
+      ProfileSource& source,
+      const FileSectionInfo& section_info,
+      const dchecked_vector<ProfileIndexType>& dex_profile_index_remap,
+      const dchecked_vector<ExtraDescriptorIndex>& extra_descriptors_remap,
+      /*out*/ std::string* error);
+
   // Find the data for the dex_pc in the inline cache. Adds an empty entry
   // if no previous data exists.
   static DexPcData* FindOrAddDexPc(InlineCacheMap* inline_cache, uint32_t dex_pc);
 
+  // Merges `counts` into the counts recorded for `dex_pc` in `branch_counts`, keeping the
+  // maximum of each counter if `keep_max` and adding the counters otherwise. Counts with
+  // a different number of counters cannot be for the same instruction and are ignored.
+  static void MergeBranchCounts(BranchCountMap* branch_counts,
+                                uint16_t dex_pc,
+                                ArrayRef<const uint32_t> counts,
+                                bool keep_max);
+
   // Initializes the profile version to the desired one.
   void InitProfileVersionInternal(const uint8_t version[]);
 
@@ -1088,6 +1223,82 @@ class ProfileCompilationInfo {
 
   // The version of the profile.
   uint8_t version_[kProfileVersionSize];
+
+  // Whether to save the profile in the mappable format.
+  bool mappable_format_ = false;
+};
+
+/**
+ * A read-only view of a profile saved in the mappable format. The file is memory mapped and
+ * method hotness is looked up directly in the method index section, without inflating any
+ * section or building the maps of a `ProfileCompilationInfo`. Inline caches and classes are
+ * not available through this view.
+ */
+class ProfileCompilationInfo::MappedProfile {
+ public:
+  // Map the profile from `fd`. Returns null if the file cannot be mapped or if it was not
+  // saved in the mappable format. Dex files rejected by `filter_fn` are ignored, as they
+  // are by `ProfileCompilationInfo::Load()`.
+  static std::unique_ptr<MappedProfile> Open(
+      int fd,
+      bool for_boot_image,
+      /*out*/ std::string* error,
+      const ProfileLoadFilterFn& filter_fn = ProfileFilterFnAcceptAll);
+
+  // Return the number of dex files referenced in the profile.
+  size_t GetNumberOfDexFiles() const {
+    return dex_files_.size();
+  }
+
+  // Return the number of hot methods and resolved classes in the profile, matching
+  // `ProfileCompilationInfo::GetNumberOfMethods()` and `GetNumberOfResolvedClasses()`
+  // of the loaded profile.
+  uint32_t GetNumberOfMethods() const;
+  uint32_t GetNumberOfResolvedClasses() const;
+
+  // Return the hotness flags of the given method. The first dex file with the same base key
+  // and a matching checksum is searched, like `ProfileCompilationInfo::GetMethodHotness()`
+  // without an annotation. The returned `MethodHotness` has no inline cache map.
+  MethodHotness GetMethodHotness(const MethodReference& method_ref) const;
+
+  // Count the hot methods and resolved classes of `info` that are not in this profile.
+  // Dex files are matched by profile key and checksum. Classes with extra descriptors
+  // cannot be matched and are always counted. The counts are an upper bound of how much
+  // `GetNumberOfMethods()` and `GetNumberOfResolvedClasses()` would grow if `info` was
+  // merged into the loaded profile, so they can be used to skip a merge of little value
+  // without loading the profile.
+  void CountNewData(const ProfileCompilationInfo& info,
+                    /*out*/ uint32_t* new_methods,
+                    /*out*/ uint32_t* new_classes) const;
+
+ private:
+  struct DexFileEntry {
+    std::string profile_key;
+    uint32_t checksum;
+    uint32_t num_type_ids;
+    uint32_t num_method_ids;
+    uint32_t method_flags;
+    ArrayRef<const uint16_t> hot_methods;
+    const uint8_t* saved_bitmap;
+    // Unaligned type index diffs of the classes record, see `DexFileData::WriteClasses()`.
+    const uint8_t* class_diffs;
+    uint16_t num_classes;
+    // Whether the dex file was accepted by the filter passed to `Open()`.
+    bool accepted;
+  };
+
+  const DexFileEntry* FindEntry(const std::string& profile_key, uint32_t checksum) const;
+  bool IsHotMethod(const DexFileEntry& entry, uint16_t method_index) const;
+  bool ContainsClass(const DexFileEntry& entry, dex::TypeIndex type_index) const;
+
+  explicit MappedProfile(MemMap&& map) : map_(std::move(map)) {}
+
+  ProfileLoadStatus Parse(bool for_boot_image,
+                          const ProfileLoadFilterFn& filter_fn,
+                          /*out*/ std::string* error);
+
+  MemMap map_;
+  std::vector<DexFileEntry> dex_files_;
 };
 
 /**
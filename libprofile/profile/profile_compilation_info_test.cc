@@ -18,8 +18,10 @@
 #include <algorithm>
 #include <stdio.h>
 
+#include "android-base/file.h"
 #include "base/arena_allocator.h"
 #include "base/common_art_test.h"
+#include "base/os.h"
 #include "base/unix_file/fd_file.h"
 #include "dex/compact_dex_file.h"
 #include "dex/dex_file.h"
@@ -1491,6 +1493,107 @@ TEST_F(ProfileCompilationInfoTest, AddMethodsProfileMethodInfoInlineCaches) {
   ASSERT_FALSE(GetMethod(info, dex1, startup.index).IsHot());
 }
 
+TEST_F(ProfileCompilationInfoTest, SaveAndMergeBranchCounts) {
+  using ProfileBranchCounts = ProfileMethodInfo::ProfileBranchCounts;
+  auto get_counts = [](const ProfileCompilationInfo::BranchCountMap* map, uint16_t dex_pc) {
+    const ArenaVector<uint32_t>& counts = map->Get(dex_pc);
+    return std::vector<uint32_t>(counts.begin(), counts.end());
+  };
+  ScratchFile profile;
+  ProfileCompilationInfo saved_info;
+  MethodReference hot(dex1, 1);
+  std::vector<ProfileBranchCounts> branch_counts = {
+      ProfileBranchCounts(/*pc=*/ 3, {10u, 1000u}),
+      ProfileBranchCounts(/*pc=*/ 7, {5u, 0u, 20u, 1u, 2u}),
+  };
+  ASSERT_TRUE(saved_info.AddMethod(ProfileMethodInfo(hot, {}, branch_counts), Hotness::kFlagHot));
+  // The runtime reports cumulative counts, adding them again keeps the maximum.
+  std::vector<ProfileBranchCounts> newer_branch_counts = {
+      ProfileBranchCounts(/*pc=*/ 3, {12u, 1200u}),
+  };
+  ASSERT_TRUE(
+      saved_info.AddMethod(ProfileMethodInfo(hot, {}, newer_branch_counts), Hotness::kFlagHot));
+
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(loaded_info.Load(GetFd(profile)));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+
+  const ProfileCompilationInfo::BranchCountMap* loaded_counts =
+      GetMethod(loaded_info, dex1, hot.index).GetBranchCountMap();
+  ASSERT_TRUE(loaded_counts != nullptr);
+  ASSERT_EQ(loaded_counts->size(), 2u);
+  EXPECT_EQ(get_counts(loaded_counts, 3), std::vector<uint32_t>({12u, 1200u}));
+  EXPECT_EQ(get_counts(loaded_counts, 7), std::vector<uint32_t>({5u, 0u, 20u, 1u, 2u}));
+  EXPECT_TRUE(GetMethod(loaded_info, dex1, /*method_idx=*/ 2).GetBranchCountMap() == nullptr);
+
+  // Merging profiles adds the counts.
+  ASSERT_TRUE(loaded_info.MergeWith(saved_info));
+  loaded_counts = GetMethod(loaded_info, dex1, hot.index).GetBranchCountMap();
+  ASSERT_TRUE(loaded_counts != nullptr);
+  EXPECT_EQ(get_counts(loaded_counts, 3), std::vector<uint32_t>({24u, 2400u}));
+  EXPECT_EQ(get_counts(loaded_counts, 7), std::vector<uint32_t>({10u, 0u, 40u, 2u, 4u}));
+}
+
+TEST_F(ProfileCompilationInfoTest, SaveAndMergeReceiverCounts) {
+  ScratchFile profile;
+  ProfileCompilationInfo saved_info;
+  MethodReference hot(dex1, 1);
+  // A megamorphic call site dominated by the first receiver. The last entry of a full
+  // runtime inline cache counts all other receivers, so its count is not reported.
+  std::vector<TypeReference> types = {
+      TypeReference(dex1, dex::TypeIndex(0)),
+      TypeReference(dex1, dex::TypeIndex(1)),
+      TypeReference(dex1, dex::TypeIndex(2)),
+      TypeReference(dex1, dex::TypeIndex(3)),
+      TypeReference(dex1, dex::TypeIndex(4))};
+  std::vector<ProfileInlineCache> inline_caches = {
+      ProfileInlineCache(/*pc=*/ 3,
+                         /*missing_types=*/ false,
+                         types,
+                         /*megamorphic=*/ false,
+                         /*class_counts=*/ {900u, 40u, 30u, 20u, 0u},
+                         /*total=*/ 1000u),
+  };
+  ASSERT_TRUE(saved_info.AddMethod(ProfileMethodInfo(hot, inline_caches), Hotness::kFlagHot));
+  // The runtime reports cumulative counts, adding them again keeps the maximum.
+  std::vector<ProfileInlineCache> newer_inline_caches = {
+      ProfileInlineCache(/*pc=*/ 3,
+                         /*missing_types=*/ false,
+                         {types[0]},
+                         /*megamorphic=*/ false,
+                         /*class_counts=*/ {950u},
+                         /*total=*/ 1100u),
+  };
+  ASSERT_TRUE(
+      saved_info.AddMethod(ProfileMethodInfo(hot, newer_inline_caches), Hotness::kFlagHot));
+
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(loaded_info.Load(GetFd(profile)));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+
+  const ProfileCompilationInfo::InlineCacheMap* loaded_caches =
+      GetMethod(loaded_info, dex1, hot.index).GetInlineCacheMap();
+  ASSERT_TRUE(loaded_caches != nullptr);
+  const ProfileCompilationInfo::DexPcData& dex_pc_data = loaded_caches->Get(3);
+  EXPECT_TRUE(dex_pc_data.is_megamorphic);
+  EXPECT_TRUE(dex_pc_data.classes.empty());
+  EXPECT_EQ(dex_pc_data.total_count, 1100u);
+  ASSERT_EQ(dex_pc_data.receiver_counts.size(), 4u);
+  EXPECT_EQ(dex_pc_data.receiver_counts.Get(dex::TypeIndex(0)), 950u);
+  EXPECT_EQ(dex_pc_data.receiver_counts.Get(dex::TypeIndex(3)), 20u);
+
+  // Merging profiles adds the counts.
+  ASSERT_TRUE(loaded_info.MergeWith(saved_info));
+  loaded_caches = GetMethod(loaded_info, dex1, hot.index).GetInlineCacheMap();
+  ASSERT_TRUE(loaded_caches != nullptr);
+  EXPECT_EQ(loaded_caches->Get(3).total_count, 2200u);
+  EXPECT_EQ(loaded_caches->Get(3).receiver_counts.Get(dex::TypeIndex(0)), 1900u);
+}
+
 // Verifies that we correctly add methods to the profile according to their flags.
 TEST_F(ProfileCompilationInfoTest, AddMethodsProfileMethodInfoFail) {
   ProfileCompilationInfo info;
@@ -1983,4 +2086,204 @@ TEST_F(ProfileCompilationInfoTest, MergeFlattenData) {
   }
 }
 
+TEST_F(ProfileCompilationInfoTest, MappableFormat) {
+  ScratchFile profile;
+
+  ProfileCompilationInfo saved_info;
+  saved_info.SetMappableFormat(true);
+  std::vector<ProfileInlineCache> inline_caches = GetTestInlineCaches();
+  for (uint16_t method_idx = 0; method_idx < 10; method_idx += 2) {
+    ASSERT_TRUE(AddMethod(&saved_info, dex1, method_idx, inline_caches));
+  }
+  ASSERT_TRUE(AddMethod(&saved_info, dex1, 3, Hotness::kFlagStartup));
+  ASSERT_TRUE(AddMethod(&saved_info, dex1, 4, Hotness::kFlagPostStartup));
+  ASSERT_TRUE(AddMethod(&saved_info, dex2, 100, Hotness::kFlagPostStartup));
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+
+  // The mappable format can be loaded like any other profile.
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(profile.GetFile()->ResetOffset());
+  ASSERT_TRUE(loaded_info.Load(GetFd(profile)));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+
+  // The mapped profile returns the same hotness as the loaded one.
+  std::string error;
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> mapped_profile =
+      ProfileCompilationInfo::MappedProfile::Open(
+          GetFd(profile), /*for_boot_image=*/ false, &error);
+  ASSERT_TRUE(mapped_profile != nullptr) << error;
+  ASSERT_EQ(2u, mapped_profile->GetNumberOfDexFiles());
+  for (const DexFile* dex : {dex1, dex2, dex3}) {
+    for (uint16_t method_idx = 0; method_idx != dex->NumMethodIds(); ++method_idx) {
+      MethodReference ref(dex, method_idx);
+      EXPECT_EQ(saved_info.GetMethodHotness(ref).GetFlags(),
+                mapped_profile->GetMethodHotness(ref).GetFlags())
+          << dex->GetLocation() << " " << method_idx;
+    }
+  }
+  EXPECT_FALSE(mapped_profile->GetMethodHotness(MethodReference(dex1_checksum_missmatch, 0))
+                   .IsInProfile());
+
+  // Profiles saved in the compressed format cannot be mapped.
+  ScratchFile compressed_profile;
+  saved_info.SetMappableFormat(false);
+  ASSERT_TRUE(saved_info.Save(GetFd(compressed_profile)));
+  ASSERT_EQ(0, compressed_profile.GetFile()->Flush());
+  ASSERT_TRUE(ProfileCompilationInfo::MappedProfile::Open(
+      GetFd(compressed_profile), /*for_boot_image=*/ false, &error) == nullptr);
+}
+
+TEST_F(ProfileCompilationInfoTest, MappedProfileCountNewData) {
+  ScratchFile profile;
+
+  ProfileCompilationInfo saved_info;
+  saved_info.SetMappableFormat(true);
+  for (uint16_t method_idx = 0; method_idx < 20; ++method_idx) {
+    ASSERT_TRUE(AddMethod(&saved_info, dex1, method_idx));
+  }
+  ASSERT_TRUE(AddMethod(&saved_info, dex1, 30, Hotness::kFlagStartup));
+  ASSERT_TRUE(AddClass(&saved_info, dex1, dex::TypeIndex(1)));
+  ASSERT_TRUE(AddClass(&saved_info, dex1, dex::TypeIndex(3)));
+  ASSERT_TRUE(AddClass(&saved_info, dex2, dex::TypeIndex(2)));
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+
+  std::string error;
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> mapped_profile =
+      ProfileCompilationInfo::MappedProfile::Open(
+          GetFd(profile), /*for_boot_image=*/ false, &error);
+  ASSERT_TRUE(mapped_profile != nullptr) << error;
+  EXPECT_EQ(saved_info.GetNumberOfMethods(), mapped_profile->GetNumberOfMethods());
+  EXPECT_EQ(saved_info.GetNumberOfResolvedClasses(),
+            mapped_profile->GetNumberOfResolvedClasses());
+
+  // Methods 10-29 are counted except those that are already hot. The startup method 30 is
+  // not hot in the profile, so it is new when it becomes hot.
+  ProfileCompilationInfo new_info;
+  for (uint16_t method_idx = 10; method_idx <= 30; ++method_idx) {
+    ASSERT_TRUE(AddMethod(&new_info, dex1, method_idx));
+  }
+  ASSERT_TRUE(AddMethod(&new_info, dex3, 1));
+  ASSERT_TRUE(AddClass(&new_info, dex1, dex::TypeIndex(1)));
+  ASSERT_TRUE(AddClass(&new_info, dex1, dex::TypeIndex(2)));
+  ASSERT_TRUE(AddClass(&new_info, dex1, dex::TypeIndex(3)));
+  ASSERT_TRUE(AddClass(&new_info, dex2, dex::TypeIndex(0)));
+  uint32_t new_methods;
+  uint32_t new_classes;
+  mapped_profile->CountNewData(new_info, &new_methods, &new_classes);
+  EXPECT_EQ(12u, new_methods);
+  EXPECT_EQ(2u, new_classes);
+
+  // The counts match the growth of the loaded profile after the merge.
+  ProfileCompilationInfo merged_info;
+  ASSERT_TRUE(merged_info.MergeWith(saved_info));
+  ASSERT_TRUE(merged_info.MergeWith(new_info));
+  EXPECT_EQ(saved_info.GetNumberOfMethods() + new_methods, merged_info.GetNumberOfMethods());
+  EXPECT_EQ(saved_info.GetNumberOfResolvedClasses() + new_classes,
+            merged_info.GetNumberOfResolvedClasses());
+
+  // Nothing is new in the saved profile itself.
+  mapped_profile->CountNewData(saved_info, &new_methods, &new_classes);
+  EXPECT_EQ(0u, new_methods);
+  EXPECT_EQ(0u, new_classes);
+
+  // Dex files rejected by the filter are ignored.
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> filtered_profile =
+      ProfileCompilationInfo::MappedProfile::Open(
+          GetFd(profile),
+          /*for_boot_image=*/ false,
+          &error,
+          [&](const std::string& profile_key, uint32_t checksum) {
+            return profile_key !=
+                       ProfileCompilationInfo::GetProfileDexFileBaseKey(dex1->GetLocation()) ||
+                   checksum != dex1->GetLocationChecksum();
+          });
+  ASSERT_TRUE(filtered_profile != nullptr) << error;
+  EXPECT_EQ(0u, filtered_profile->GetNumberOfMethods());
+  EXPECT_EQ(1u, filtered_profile->GetNumberOfResolvedClasses());
+  EXPECT_FALSE(filtered_profile->GetMethodHotness(MethodReference(dex1, 0)).IsInProfile());
+}
+
+TEST_F(ProfileCompilationInfoTest, SaveMappableInPlace) {
+  ScratchFile profile;
+  const std::string& filename = profile.GetFilename();
+
+  ProfileCompilationInfo saved_info;
+  saved_info.SetMappableFormat(true);
+  for (uint16_t method_idx = 0; method_idx < 50; method_idx++) {
+    ASSERT_TRUE(AddMethod(&saved_info, dex1, method_idx));
+    ASSERT_TRUE(AddMethod(&saved_info, dex2, method_idx, Hotness::kFlagStartup));
+  }
+  uint64_t bytes_written = 0u;
+  ASSERT_TRUE(saved_info.SaveFallback(filename, &bytes_written));
+  EXPECT_NE(0u, bytes_written);
+
+  // Saving the same data again only rewrites the header.
+  ASSERT_TRUE(saved_info.SaveFallback(filename, &bytes_written));
+  EXPECT_EQ(0u, bytes_written);
+
+  // Add more methods and save again.
+  for (uint16_t method_idx = 50; method_idx < 100; method_idx++) {
+    ASSERT_TRUE(AddMethod(&saved_info, dex1, method_idx));
+    ASSERT_TRUE(AddMethod(&saved_info, dex3, method_idx));
+  }
+  ASSERT_TRUE(saved_info.SaveFallback(filename, &bytes_written));
+  EXPECT_NE(0u, bytes_written);
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(loaded_info.Load(filename, /*clear_if_invalid=*/ false));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+
+  // A smaller profile truncates the data left from the previous one.
+  ProfileCompilationInfo small_info;
+  small_info.SetMappableFormat(true);
+  ASSERT_TRUE(AddMethod(&small_info, dex1, /*method_idx=*/ 1));
+  ASSERT_TRUE(small_info.SaveFallback(filename, &bytes_written));
+  ProfileCompilationInfo loaded_small_info;
+  ASSERT_TRUE(loaded_small_info.Load(filename, /*clear_if_invalid=*/ false));
+  ASSERT_TRUE(loaded_small_info.Equals(small_info));
+  std::unique_ptr<File> file(OS::OpenFileForReading(filename.c_str()));
+  ASSERT_TRUE(file != nullptr);
+  std::string error;
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> mapped_profile =
+      ProfileCompilationInfo::MappedProfile::Open(file->Fd(), /*for_boot_image=*/ false, &error);
+  ASSERT_TRUE(mapped_profile != nullptr) << error;
+  EXPECT_TRUE(mapped_profile->GetMethodHotness(MethodReference(dex1, 1)).IsHot());
+  EXPECT_FALSE(mapped_profile->GetMethodHotness(MethodReference(dex1, 2)).IsInProfile());
+  EXPECT_FALSE(mapped_profile->GetMethodHotness(MethodReference(dex2, 1)).IsInProfile());
+}
+
+TEST_F(ProfileCompilationInfoTest, InterruptedSaveMappableInPlace) {
+  ScratchFile profile;
+  const std::string& filename = profile.GetFilename();
+
+  ProfileCompilationInfo saved_info;
+  saved_info.SetMappableFormat(true);
+  for (uint16_t method_idx = 0; method_idx < 50; method_idx++) {
+    ASSERT_TRUE(AddMethod(&saved_info, dex1, method_idx));
+  }
+  ASSERT_TRUE(saved_info.SaveFallback(filename, /*bytes_written=*/ nullptr));
+
+  // An in-place save that does not complete leaves the first bytes of the file cleared,
+  // whatever happened to the sections.
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(filename, &contents));
+  std::fill_n(contents.begin(), 2 * sizeof(uint32_t), '\0');
+  contents.replace(contents.size() / 2, 4u, "junk");
+  ASSERT_TRUE(android::base::WriteStringToFile(contents, filename));
+
+  ProfileCompilationInfo loaded_info;
+  ASSERT_FALSE(loaded_info.Load(filename, /*clear_if_invalid=*/ false));
+  std::unique_ptr<File> file(OS::OpenFileForReading(filename.c_str()));
+  ASSERT_TRUE(file != nullptr);
+  std::string error;
+  EXPECT_TRUE(ProfileCompilationInfo::MappedProfile::Open(
+      file->Fd(), /*for_boot_image=*/ false, &error) == nullptr);
+
+  // The next save writes a valid profile again.
+  ASSERT_TRUE(saved_info.SaveFallback(filename, /*bytes_written=*/ nullptr));
+  ASSERT_TRUE(loaded_info.Load(filename, /*clear_if_invalid=*/ false));
+  EXPECT_TRUE(loaded_info.Equals(saved_info));
+}
+
 }  // namespace art
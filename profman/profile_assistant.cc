@@ -16,6 +16,8 @@
 
 #include "profile_assistant.h"
 
+#include <memory>
+
 #include "base/os.h"
 #include "base/unix_file/fd_file.h"
 #include "profman/profman_result.h"
@@ -33,45 +35,138 @@ ProfmanResult::ProcessingResult ProfileAssistant::ProcessProfilesInternal(
     const ProfileCompilationInfo::ProfileLoadFilterFn& filter_fn,
     const Options& options) {
   ProfileCompilationInfo info(options.IsBootImageMerge());
+  info.SetMappableFormat(options.IsMappableFormat());
 
-  // Load the reference profile.
-  if (!info.Load(reference_profile_file->Fd(), /*merge_classes=*/ true, filter_fn)) {
-    LOG(WARNING) << "Could not load reference profile file";
-    return ProfmanResult::kErrorBadProfiles;
+  // A reference profile in the mappable format is first checked through a read-only mapping,
+  // so that it is loaded only when the current profiles add enough to be merged into it.
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> mapped_reference;
+  if (!options.IsForceMerge()) {
+    std::string error;
+    mapped_reference = ProfileCompilationInfo::MappedProfile::Open(
+        reference_profile_file->Fd(), options.IsBootImageMerge(), &error, filter_fn);
+    if (mapped_reference != nullptr) {
+      // Keep the reference profile in the mappable format.
+      info.SetMappableFormat(true);
+    }
   }
+  auto load_reference_profile = [&]() {
+    if (!info.Load(reference_profile_file->Fd(), /*merge_classes=*/ true, filter_fn)) {
+      LOG(WARNING) << "Could not load reference profile file";
+      return false;
+    }
+    return true;
+  };
 
-  if (options.IsBootImageMerge() && !info.IsForBootImage()) {
-    LOG(WARNING) << "Requested merge for boot image profile but the reference profile is regular.";
-    return ProfmanResult::kErrorBadProfiles;
+  // Load the reference profile.
+  if (mapped_reference == nullptr) {
+    if (!load_reference_profile()) {
+      return ProfmanResult::kErrorBadProfiles;
+    }
+    if (options.IsBootImageMerge() && !info.IsForBootImage()) {
+      LOG(WARNING) << "Requested merge for boot image profile but the reference profile is "
+                   << "regular.";
+      return ProfmanResult::kErrorBadProfiles;
+    }
   }
 
   // Store the current state of the reference profile before merging with the current profiles.
-  uint32_t number_of_methods = info.GetNumberOfMethods();
-  uint32_t number_of_classes = info.GetNumberOfResolvedClasses();
+  uint32_t number_of_methods = (mapped_reference != nullptr)
+      ? mapped_reference->GetNumberOfMethods()
+      : info.GetNumberOfMethods();
+  uint32_t number_of_classes = (mapped_reference != nullptr)
+      ? mapped_reference->GetNumberOfResolvedClasses()
+      : info.GetNumberOfResolvedClasses();
+  uint32_t min_change_in_methods_for_compilation = std::max(
+      (options.GetMinNewMethodsPercentChangeForCompilation() * number_of_methods) / 100,
+      kMinNewMethodsForCompilation);
+  uint32_t min_change_in_classes_for_compilation = std::max(
+      (options.GetMinNewClassesPercentChangeForCompilation() * number_of_classes) / 100,
+      kMinNewClassesForCompilation);
 
-  // Merge all current profiles.
-  for (size_t i = 0; i < profile_files.size(); i++) {
-    ProfileCompilationInfo cur_info(options.IsBootImageMerge());
-    if (!cur_info.Load(profile_files[i]->Fd(), /*merge_classes=*/ true, filter_fn)) {
+  // Load a current profile. Returns false with the `result` to return on failure, or true
+  // with a null `cur_info` if the profile was ignored.
+  auto load_current_profile = [&](size_t i,
+                                  /*out*/ std::unique_ptr<ProfileCompilationInfo>* cur_info,
+                                  /*out*/ ProfmanResult::ProcessingResult* result) {
+    cur_info->reset(new ProfileCompilationInfo(options.IsBootImageMerge()));
+    if (!(*cur_info)->Load(profile_files[i]->Fd(), /*merge_classes=*/ true, filter_fn)) {
       LOG(WARNING) << "Could not load profile file at index " << i;
+      cur_info->reset();
       if (options.IsForceMerge()) {
         // If we have to merge forcefully, ignore load failures.
         // This is useful for boot image profiles to ignore stale profiles which are
         // cleared lazily.
-        continue;
+        return true;
       }
       // TODO: Do we really need to use a different error code for version mismatch?
       ProfileCompilationInfo wrong_info(!options.IsBootImageMerge());
       if (wrong_info.Load(profile_files[i]->Fd(), /*merge_classes=*/ true, filter_fn)) {
-        return ProfmanResult::kErrorDifferentVersions;
+        *result = ProfmanResult::kErrorDifferentVersions;
+        return false;
       }
-      return ProfmanResult::kErrorBadProfiles;
+      *result = ProfmanResult::kErrorBadProfiles;
+      return false;
     }
-
+    return true;
+  };
+  auto merge_current_profile = [&](size_t i, const ProfileCompilationInfo& cur_info) {
     if (!info.MergeWith(cur_info)) {
       LOG(WARNING) << "Could not merge profile file at index " << i;
+      return false;
+    }
+    return true;
+  };
+
+  if (mapped_reference != nullptr) {
+    // Load all current profiles and check the mapped reference profile. The counted new data
+    // is an upper bound of what the merge adds, so the results match those of the check after
+    // the merge below.
+    std::vector<std::unique_ptr<ProfileCompilationInfo>> cur_infos(profile_files.size());
+    uint32_t new_methods = 0u;
+    uint32_t new_classes = 0u;
+    for (size_t i = 0; i < profile_files.size(); i++) {
+      ProfmanResult::ProcessingResult result;
+      if (!load_current_profile(i, &cur_infos[i], &result)) {
+        return result;
+      }
+      if (cur_infos[i] != nullptr) {
+        uint32_t cur_new_methods;
+        uint32_t cur_new_classes;
+        mapped_reference->CountNewData(*cur_infos[i], &cur_new_methods, &cur_new_classes);
+        new_methods += cur_new_methods;
+        new_classes += cur_new_classes;
+      }
+    }
+    if (number_of_methods == 0u && number_of_classes == 0u &&
+        new_methods == 0u && new_classes == 0u) {
+      return ProfmanResult::kSkipCompilationEmptyProfiles;
+    }
+    if (new_methods < min_change_in_methods_for_compilation &&
+        new_classes < min_change_in_classes_for_compilation) {
+      return ProfmanResult::kSkipCompilationSmallDelta;
+    }
+
+    // Merge all current profiles into the loaded reference profile.
+    if (!load_reference_profile()) {
       return ProfmanResult::kErrorBadProfiles;
     }
+    for (size_t i = 0; i < cur_infos.size(); i++) {
+      if (cur_infos[i] != nullptr && !merge_current_profile(i, *cur_infos[i])) {
+        return ProfmanResult::kErrorBadProfiles;
+      }
+    }
+  } else {
+    // Merge all current profiles.
+    for (size_t i = 0; i < profile_files.size(); i++) {
+      std::unique_ptr<ProfileCompilationInfo> cur_info;
+      ProfmanResult::ProcessingResult result;
+      if (!load_current_profile(i, &cur_info, &result)) {
+        return result;
+      }
+      if (cur_info != nullptr && !merge_current_profile(i, *cur_info)) {
+        return ProfmanResult::kErrorBadProfiles;
+      }
+    }
   }
 
   // If we perform a forced merge do not analyze the difference between profiles.
@@ -79,12 +174,6 @@ ProfmanResult::ProcessingResult ProfileAssistant::ProcessProfilesInternal(
     if (info.IsEmpty()) {
       return ProfmanResult::kSkipCompilationEmptyProfiles;
     }
-    uint32_t min_change_in_methods_for_compilation = std::max(
-        (options.GetMinNewMethodsPercentChangeForCompilation() * number_of_methods) / 100,
-        kMinNewMethodsForCompilation);
-    uint32_t min_change_in_classes_for_compilation = std::max(
-        (options.GetMinNewClassesPercentChangeForCompilation() * number_of_classes) / 100,
-        kMinNewClassesForCompilation);
     // Check if there is enough new information added by the current profiles.
     if (((info.GetNumberOfMethods() - number_of_methods) < min_change_in_methods_for_compilation) &&
         ((info.GetNumberOfResolvedClasses() - number_of_classes)
@@ -32,12 +32,14 @@ class ProfileAssistant {
    public:
     static constexpr bool kForceMergeDefault = false;
     static constexpr bool kBootImageMergeDefault = false;
+    static constexpr bool kMappableFormatDefault = false;
     static constexpr uint32_t kMinNewMethodsPercentChangeForCompilation = 20;
     static constexpr uint32_t kMinNewClassesPercentChangeForCompilation = 20;
 
     Options()
         : force_merge_(kForceMergeDefault),
           boot_image_merge_(kBootImageMergeDefault),
+          mappable_format_(kMappableFormatDefault),
           min_new_methods_percent_change_for_compilation_(
               kMinNewMethodsPercentChangeForCompilation),
           min_new_classes_percent_change_for_compilation_(
@@ -46,6 +48,7 @@ class ProfileAssistant {
 
     bool IsForceMerge() const { return force_merge_; }
     bool IsBootImageMerge() const { return boot_image_merge_; }
+    bool IsMappableFormat() const { return mappable_format_; }
     uint32_t GetMinNewMethodsPercentChangeForCompilation() const {
         return min_new_methods_percent_change_for_compilation_;
     }
@@ -55,6 +58,7 @@ class ProfileAssistant {
 
     void SetForceMerge(bool value) { force_merge_ = value; }
     void SetBootImageMerge(bool value) { boot_image_merge_ = value; }
+    void SetMappableFormat(bool value) { mappable_format_ = value; }
     void SetMinNewMethodsPercentChangeForCompilation(uint32_t value) {
       min_new_methods_percent_change_for_compilation_ = value;
     }
@@ -70,6 +74,9 @@ class ProfileAssistant {
     // Signals that the merge is for boot image profiles. It will ignore differences
     // in profile versions (instead of aborting).
     bool boot_image_merge_;
+    // Save the reference profile in the mappable format. See
+    // ProfileCompilationInfo::SetMappableFormat.
+    bool mappable_format_;
     uint32_t min_new_methods_percent_change_for_compilation_;
     uint32_t min_new_classes_percent_change_for_compilation_;
   };
@@ -89,6 +96,9 @@ class ProfileAssistant {
   // this case no file will be updated. A variation of this code is
   // kSkipCompilationEmptyProfiles which indicates that all the profiles are empty.
   // This allow the caller to make fine grain decisions on the compilation strategy.
+  //
+  // If the reference profile is in the mappable format, these two results are
+  // determined from a read-only mapping of it, without loading the reference profile.
   static ProfmanResult::ProcessingResult ProcessProfiles(
       const std::vector<std::string>& profile_files,
       const std::string& reference_profile_file,
@@ -16,6 +16,7 @@
 
 #include "profile_assistant.h"
 
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -726,6 +727,78 @@ TEST_F(ProfileAssistantTest, DoNotAdviseCompilationClassPercentageWithNewMin) {
                                                kNumberOfClassesInRefProfile));
 }
 
+TEST_F(ProfileAssistantTest, MappableReferenceProfile) {
+  ScratchFile profile1;
+  ScratchFile profile2;
+  ScratchFile reference_profile;
+  int reference_profile_fd = GetFd(reference_profile);
+
+  // The reference profile contains the methods with indices 0-99.
+  ProfileCompilationInfo reference_info;
+  reference_info.SetMappableFormat(true);
+  SetupProfile(dex1, dex2, /*number_of_methods=*/ 100, /*number_of_classes=*/ 0,
+               reference_profile, &reference_info);
+  int64_t reference_length = reference_profile.GetFile()->GetLength();
+
+  // A current profile with the methods 0-119 adds too few new methods. The mapped
+  // reference profile is enough to decide and it is not updated.
+  ProfileCompilationInfo info1;
+  SetupProfile(dex1, dex2, /*number_of_methods=*/ 120, /*number_of_classes=*/ 0,
+               profile1, &info1);
+  ASSERT_EQ(ProfmanResult::kSkipCompilationSmallDelta,
+            ProcessProfiles({GetFd(profile1)}, reference_profile_fd));
+  ASSERT_EQ(reference_length, reference_profile.GetFile()->GetLength());
+  CheckProfileInfo(reference_profile, reference_info);
+
+  // A second current profile with the methods 150-249 adds enough.
+  ProfileCompilationInfo info2;
+  SetupProfile(dex1, dex2, /*number_of_methods=*/ 100, /*number_of_classes=*/ 0,
+               profile2, &info2, /*start_method_index=*/ 150);
+  ASSERT_EQ(ProfmanResult::kCompile,
+            ProcessProfiles({GetFd(profile1), GetFd(profile2)}, reference_profile_fd));
+  ProfileCompilationInfo expected;
+  ASSERT_TRUE(expected.MergeWith(reference_info));
+  ASSERT_TRUE(expected.MergeWith(info1));
+  ASSERT_TRUE(expected.MergeWith(info2));
+  CheckProfileInfo(reference_profile, expected);
+
+  // The updated reference profile is still in the mappable format.
+  std::string error;
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> mapped_profile =
+      ProfileCompilationInfo::MappedProfile::Open(
+          reference_profile_fd, /*for_boot_image=*/ false, &error);
+  ASSERT_TRUE(mapped_profile != nullptr) << error;
+  EXPECT_EQ(expected.GetNumberOfMethods(), mapped_profile->GetNumberOfMethods());
+}
+
+TEST_F(ProfileAssistantTest, MappableReferenceProfileOption) {
+  ScratchFile profile;
+  ScratchFile reference_profile;
+  int reference_profile_fd = GetFd(reference_profile);
+
+  ProfileCompilationInfo reference_info;
+  SetupProfile(dex1, dex2, /*number_of_methods=*/ 100, /*number_of_classes=*/ 0,
+               reference_profile, &reference_info);
+  ProfileCompilationInfo info;
+  SetupProfile(dex3, dex4, /*number_of_methods=*/ 100, /*number_of_classes=*/ 0,
+               profile, &info);
+
+  // The reference profile is converted to the mappable format by the merge.
+  std::string error;
+  ASSERT_TRUE(ProfileCompilationInfo::MappedProfile::Open(
+      reference_profile_fd, /*for_boot_image=*/ false, &error) == nullptr);
+  ASSERT_EQ(ProfmanResult::kCompile,
+            ProcessProfiles({GetFd(profile)},
+                            reference_profile_fd,
+                            {"--mappable-reference-profile"}));
+  ProfileCompilationInfo expected;
+  ASSERT_TRUE(expected.MergeWith(reference_info));
+  ASSERT_TRUE(expected.MergeWith(info));
+  CheckProfileInfo(reference_profile, expected);
+  ASSERT_TRUE(ProfileCompilationInfo::MappedProfile::Open(
+      reference_profile_fd, /*for_boot_image=*/ false, &error) != nullptr) << error;
+}
+
 TEST_F(ProfileAssistantTest, FailProcessingBecauseOfProfiles) {
   ScratchFile profile1;
   ScratchFile profile2;
@@ -1501,6 +1574,60 @@ TEST_F(ProfileAssistantTest, TestProfileCreateInlineCache) {
   }
 }
 
+TEST_F(ProfileAssistantTest, TestProfileCreateMegamorphicReceiverCounts) {
+  std::string input_file_contents =
+      "HLTestInline;->inlineMegamorphic(LSuper;)I+megamorphic_types=1000,LSubA;=900,LSubB;=50\n";
+
+  // Create the profile and save it to disk.
+  ScratchFile profile_file;
+  ASSERT_TRUE(CreateProfile(input_file_contents,
+                            profile_file.GetFilename(),
+                            GetTestDexFileName("ProfileTestMultiDex")));
+
+  // Load the profile from disk.
+  ProfileCompilationInfo info;
+  ASSERT_TRUE(info.Load(GetFd(profile_file)));
+
+  ScopedObjectAccess soa(Thread::Current());
+  jobject class_loader = LoadDex("ProfileTestMultiDex");
+  ASSERT_NE(class_loader, nullptr);
+  ArtMethod* inline_megamorphic =
+      GetVirtualMethod(class_loader, "LTestInline;", "inlineMegamorphic");
+  ASSERT_TRUE(inline_megamorphic != nullptr);
+  const DexFile* dex_file = inline_megamorphic->GetDexFile();
+  ProfileCompilationInfo::MethodHotness hotness = info.GetMethodHotness(
+      MethodReference(dex_file, inline_megamorphic->GetDexMethodIndex()));
+  ASSERT_TRUE(hotness.IsHot());
+  const ProfileCompilationInfo::InlineCacheMap* inline_caches = hotness.GetInlineCacheMap();
+  ASSERT_EQ(inline_caches->size(), 1u);
+
+  // The cache is megamorphic and keeps the receiver counts.
+  const ProfileCompilationInfo::DexPcData& dex_pc_data = inline_caches->begin()->second;
+  ASSERT_TRUE(dex_pc_data.is_megamorphic);
+  ASSERT_TRUE(dex_pc_data.classes.empty());
+  ASSERT_EQ(dex_pc_data.total_count, 1000u);
+  std::map<std::string, uint32_t> receiver_counts;
+  for (const auto& [type_index, count] : dex_pc_data.receiver_counts) {
+    receiver_counts.emplace(info.GetTypeDescriptor(dex_file, type_index), count);
+  }
+  std::map<std::string, uint32_t> expected_receiver_counts = {{"LSubA;", 900u}, {"LSubB;", 50u}};
+  ASSERT_EQ(receiver_counts, expected_receiver_counts);
+}
+
+TEST_F(ProfileAssistantTest, TestProfileCreateInvalidReceiverCounts) {
+  // The receiver counts exceed the total count, the line is ignored.
+  std::string input_file_contents =
+      "HLTestInline;->inlineMegamorphic(LSuper;)I+megamorphic_types=100,LSubA;=900\n";
+  ScratchFile profile_file;
+  ASSERT_TRUE(CreateProfile(input_file_contents,
+                            profile_file.GetFilename(),
+                            GetTestDexFileName("ProfileTestMultiDex")));
+
+  ProfileCompilationInfo info;
+  ASSERT_TRUE(info.Load(GetFd(profile_file)));
+  ASSERT_EQ(info.GetNumberOfMethods(), 0u);
+}
+
 TEST_F(ProfileAssistantTest, MergeProfilesWithDifferentDexOrder) {
   ScratchFile profile1;
   ScratchFile reference_profile;
@@ -34,6 +34,7 @@
 #include <vector>
 
 #include "android-base/parsebool.h"
+#include "android-base/parseint.h"
 #include "android-base/stringprintf.h"
 #include "android-base/strings.h"
 #include "base/array_ref.h"
@@ -191,6 +192,9 @@ NO_RETURN static void Usage(const char *fmt, ...) {
   UsageError("      In this case, the reference profile must have a boot profile version.");
   UsageError("  --force-merge: performs a forced merge, without analyzing if there is a");
   UsageError("      significant difference between the current profile and the reference profile.");
+  UsageError("  --mappable-reference-profile: save the merged reference profile in the mappable");
+  UsageError("      format, so that later merges can check it without loading it.");
+  UsageError("      A reference profile already in the mappable format stays in it.");
   UsageError("  --min-new-methods-percent-change=percentage between 0 and 100 (default 20)");
   UsageError("      the min percent of new methods to trigger a compilation.");
   UsageError("  --min-new-classes-percent-change=percentage between 0 and 100 (default 20)");
@@ -215,6 +219,7 @@ static constexpr char kAnnotationEnd = '}';
 static constexpr char kProfileParsingInlineChacheSep = '+';
 static constexpr char kProfileParsingInlineChacheTargetSep = ']';
 static constexpr char kProfileParsingTypeSep = ',';
+static constexpr char kProfileParsingCountSep = '=';
 static constexpr char kProfileParsingFirstCharInSignature = '(';
 static constexpr char kMethodFlagStringHot = 'H';
 static constexpr char kMethodFlagStringStartup = 'S';
@@ -470,6 +475,8 @@ class ProfMan final {
         profile_assistant_options_.SetBootImageMerge(true);
       } else if (option == "--force-merge") {
         profile_assistant_options_.SetForceMerge(true);
+      } else if (option == "--mappable-reference-profile") {
+        profile_assistant_options_.SetMappableFormat(true);
       } else {
         Usage("Unknown argument '%s'", raw_option);
       }
@@ -1344,6 +1351,50 @@ class ProfMan final {
     return std::nullopt;
   }
 
+  // Parse the receiver counts of a megamorphic inline cache, written as
+  // "megamorphic_types=<total count>,<class>=<count>,...". Classes that cannot be
+  // found are ignored.
+  bool ParseReceiverCounts(const std::vector<std::unique_ptr<const DexFile>>& dex_files,
+                           const InlineCacheSegment& segment,
+                           /*out*/ std::vector<TypeReference>* classes,
+                           /*out*/ std::vector<uint32_t>* counts,
+                           /*out*/ uint32_t* total_count) {
+    const InlineCacheSegment::IcArray& targets = segment.GetIcTargets();
+    std::string total_string(targets[0].substr(kMegamorphicTypesMarker.size() + 1u));
+    if (!android::base::ParseUint(total_string, total_count)) {
+      LOG(ERROR) << "Invalid total count for inline cache: " << segment;
+      return false;
+    }
+    uint64_t sum_of_counts = 0u;
+    for (size_t i = 1u; i != targets.size() && !targets[i].empty(); ++i) {
+      size_t count_start = targets[i].rfind(kProfileParsingCountSep);
+      uint32_t count = 0u;
+      if (count_start == std::string_view::npos ||
+          !android::base::ParseUint(std::string(targets[i].substr(count_start + 1u)), &count)) {
+        LOG(ERROR) << "Invalid receiver count for inline cache: " << targets[i];
+        return false;
+      }
+      std::string_view ic_class = targets[i].substr(0u, count_start);
+      if (!IsValidDescriptor(std::string(ic_class).c_str())) {
+        LOG(ERROR) << "Invalid descriptor for inline cache: " << ic_class;
+        return false;
+      }
+      TypeReference ic_class_ref(/* dex_file= */ nullptr, dex::TypeIndex());
+      if (!FindClass(dex_files, ic_class, &ic_class_ref)) {
+        LOG(WARNING) << "Could not find class: " << ic_class << " in " << segment;
+        continue;
+      }
+      classes->push_back(ic_class_ref);
+      counts->push_back(count);
+      sum_of_counts += count;
+    }
+    if (sum_of_counts > *total_count) {
+      LOG(ERROR) << "Receiver counts exceed the total count of inline cache: " << segment;
+      return false;
+    }
+    return true;
+  }
+
   // Process a line defining a class or a method and its inline caches.
   // Upon success return true and add the class or the method info to profile.
   // Inline caches are identified by the type of the declared receiver type.
@@ -1351,6 +1402,8 @@ class ProfMan final {
   // "LJustTheClass;".
   // "LTestInline;->inlinePolymorphic(LSuper;)I+LSubA;,LSubB;,LSubC;".
   // "LTestInline;->inlineMissingTypes(LSuper;)I+missing_types".
+  // // A megamorphic call made 1000 times, 900 of them with a LSubA; receiver.
+  // "LTestInline;->inlineMegamorphic(LSuper;)I+megamorphic_types=1000,LSubA;=900,LSubB;=50".
   // // Note no ',' after [LTarget;
   // "LTestInline;->multiInlinePolymorphic(LSuper;)I+]LTarget1;LResA;,LResB;]LTarget2;LResC;,LResD;".
   // "LTestInline;->multiInlinePolymorphic(LSuper;)I+]LTarget1;missing_types]LTarget2;LResC;,LResD;".
@@ -1546,7 +1599,15 @@ class ProfMan final {
         bool megamorphic_types =
             segment.GetIcTargets()[0] == kMegamorphicTypesMarker;
         std::vector<TypeReference> classes;
-        if (!missing_types && !megamorphic_types) {
+        std::vector<uint32_t> counts;
+        uint32_t total_count = 0u;
+        if (StartsWith(segment.GetIcTargets()[0],
+                       kMegamorphicTypesMarker + kProfileParsingCountSep)) {
+          megamorphic_types = true;
+          if (!ParseReceiverCounts(dex_files, segment, &classes, &counts, &total_count)) {
+            return false;
+          }
+        } else if (!missing_types && !megamorphic_types) {
           classes.reserve(segment.NumIcTargets());
           for (const std::string_view& ic_class : segment.GetIcTargets()) {
             if (ic_class.empty()) {
@@ -1574,7 +1635,8 @@ class ProfMan final {
           }
         }
         for (size_t dex_pc : dex_pcs) {
-          inline_caches.emplace_back(dex_pc, missing_types, classes, megamorphic_types);
+          inline_caches.emplace_back(
+              dex_pc, missing_types, classes, megamorphic_types, counts, total_count);
         }
       }
     }
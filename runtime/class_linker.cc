@@ -62,6 +62,7 @@
 #include "cha.h"
 #include "class_linker-inl.h"
 #include "class_loader_utils.h"
+#include "class_path_index.h"
 #include "class_root-inl.h"
 #include "class_table-inl.h"
 #include "compiler_callbacks.h"
@@ -2889,6 +2890,73 @@ ClassPathEntry FindInClassPath(const char* descriptor,
   return ClassPathEntry(nullptr, nullptr);
 }
 
+// Search a class path for a descriptor using the class path index of `class_table`, which is
+// built when the class path has enough dex files. Dex files can be appended to a class path, so
+// the index may cover only a prefix of it and the remaining dex files are searched linearly. An
+// index that does not match the class path, or that leaves many dex files out, is replaced.
+// `visit_class_path` calls its argument with each dex file of the class path in order, until
+// it returns false.
+template <typename VisitClassPath>
+ClassPathEntry FindInIndexedClassPath(ClassTable* class_table,
+                                      const char* descriptor,
+                                      size_t hash,
+                                      VisitClassPath&& visit_class_path)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  const ClassPathIndex* index = class_table->GetClassPathIndex();
+  size_t num_dex_files = 0u;
+  size_t num_indexed_dex_files = 0u;
+  visit_class_path([&](const DexFile* dex_file) {
+    if (index != nullptr &&
+        num_indexed_dex_files == num_dex_files &&
+        index->IsIndexed(num_dex_files, dex_file)) {
+      ++num_indexed_dex_files;
+    }
+    ++num_dex_files;
+    return true;  // Continue with the next DexFile.
+  });
+  if (index == nullptr ||
+      num_indexed_dex_files != index->NumDexFiles() ||
+      num_dex_files - num_indexed_dex_files >= ClassPathIndex::kMinDexFiles) {
+    if (num_dex_files < ClassPathIndex::kMinDexFiles ||
+        num_dex_files > ClassPathIndex::kMaxDexFiles) {
+      index = nullptr;
+      num_indexed_dex_files = 0u;
+    } else {
+      std::vector<const DexFile*> dex_files;
+      dex_files.reserve(num_dex_files);
+      visit_class_path([&](const DexFile* dex_file) {
+        dex_files.push_back(dex_file);
+        return true;  // Continue with the next DexFile.
+      });
+      num_indexed_dex_files = dex_files.size();
+      index = class_table->SetClassPathIndex(
+          std::make_unique<ClassPathIndex>(std::move(dex_files)));
+    }
+  }
+
+  if (index != nullptr) {
+    ClassPathEntry entry = index->Lookup(descriptor, static_cast<uint32_t>(hash));
+    if (entry.second != nullptr || num_indexed_dex_files == num_dex_files) {
+      return entry;
+    }
+  }
+  // Search the dex files that are not indexed.
+  ClassPathEntry result(nullptr, nullptr);
+  size_t position = 0u;
+  visit_class_path([&](const DexFile* dex_file) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (position++ < num_indexed_dex_files) {
+      return true;  // Indexed, continue with the next DexFile.
+    }
+    const dex::ClassDef* class_def = OatDexFile::FindClassDef(*dex_file, descriptor, hash);
+    if (class_def != nullptr) {
+      result = ClassPathEntry(dex_file, class_def);
+      return false;  // Found a class definition, stop visit.
+    }
+    return true;  // Continue with the next DexFile.
+  });
+  return result;
+}
+
 // Helper macro to make sure each class loader lookup call handles the case the
 // class loader is not recognized, or the lookup threw an exception.
 #define RETURN_IF_UNRECOGNIZED_OR_FOUND_OR_EXCEPTION(call_, result_, thread_) \
@@ -3065,7 +3133,15 @@ bool ClassLinker::FindClassInBootClassLoaderClassPath(Thread* self,
                                                       const char* descriptor,
                                                       size_t hash,
                                                       /*out*/ ObjPtr<mirror::Class>* result) {
-  ClassPathEntry pair = FindInClassPath(descriptor, hash, boot_class_path_);
+  auto visit_boot_class_path = [&](auto&& visitor) REQUIRES_SHARED(Locks::mutator_lock_) {
+    for (const DexFile* dex_file : boot_class_path_) {
+      if (!visitor(dex_file)) {
+        break;
+      }
+    }
+  };
+  ClassPathEntry pair = FindInIndexedClassPath(
+      ClassTableForClassLoader(nullptr), descriptor, hash, visit_boot_class_path);
   if (pair.second != nullptr) {
     ObjPtr<mirror::Class> klass = LookupClass(self, descriptor, hash, nullptr);
     if (klass != nullptr) {
@@ -3100,17 +3176,27 @@ bool ClassLinker::FindClassInBaseDexClassLoaderClassPath(
 
   const DexFile* dex_file = nullptr;
   const dex::ClassDef* class_def = nullptr;
-  ObjPtr<mirror::Class> ret;
-  auto find_class_def = [&](const DexFile* cp_dex_file) REQUIRES_SHARED(Locks::mutator_lock_) {
-    const dex::ClassDef* cp_class_def = OatDexFile::FindClassDef(*cp_dex_file, descriptor, hash);
-    if (cp_class_def != nullptr) {
-      dex_file = cp_dex_file;
-      class_def = cp_class_def;
-      return false;  // Found a class definition, stop visit.
-    }
-    return true;  // Continue with the next DexFile.
-  };
-  VisitClassLoaderDexFiles(self, class_loader, find_class_def);
+  ClassTable* class_table = ClassTableForClassLoader(class_loader.Get());
+  if (class_table != nullptr) {
+    auto visit_class_path = [&](auto&& visitor) REQUIRES_SHARED(Locks::mutator_lock_) {
+      VisitClassLoaderDexFiles(self, class_loader, visitor);
+    };
+    std::tie(dex_file, class_def) =
+        FindInIndexedClassPath(class_table, descriptor, hash, visit_class_path);
+  } else {
+    // No class was defined by this class loader yet. Search its dex files linearly.
+    auto find_class_def = [&](const DexFile* cp_dex_file) REQUIRES_SHARED(Locks::mutator_lock_) {
+      const dex::ClassDef* cp_class_def =
+          OatDexFile::FindClassDef(*cp_dex_file, descriptor, hash);
+      if (cp_class_def != nullptr) {
+        dex_file = cp_dex_file;
+        class_def = cp_class_def;
+        return false;  // Found a class definition, stop visit.
+      }
+      return true;  // Continue with the next DexFile.
+    };
+    VisitClassLoaderDexFiles(self, class_loader, find_class_def);
+  }
 
   if (class_def != nullptr) {
     *result = DefineClass(self, descriptor, hash, class_loader, *dex_file, *class_def);
@@ -10514,6 +10600,14 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
     }
   }
   os << "Done dumping class loaders\n";
+  os << "Dumping dex cache statistics\n";
+  for (const auto& entry : dex_caches_) {
+    ObjPtr<mirror::DexCache> dex_cache = DecodeDexCacheLocked(soa.Self(), &entry.second);
+    if (dex_cache != nullptr) {
+      dex_cache->DumpStatistics(os);
+    }
+  }
+  os << "Done dumping dex cache statistics\n";
   Runtime* runtime = Runtime::Current();
   os << "Classes initialized: " << runtime->GetStat(KIND_GLOBAL_CLASS_INIT_COUNT) << " in "
      << PrettyDuration(runtime->GetStat(KIND_GLOBAL_CLASS_INIT_TIME)) << "\n";
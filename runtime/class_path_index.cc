@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_path_index.h"
+
+#include <string.h>
+
+#include "base/casts.h"
+#include "base/logging.h"
+#include "dex/dex_file-inl.h"
+#include "dex/utf.h"
+
+namespace art {
+
+ClassPathIndex::ClassPathIndex(std::vector<const DexFile*>&& dex_files)
+    : dex_files_(std::move(dex_files)),
+      entries_(EntryHash(), EntryEquals(this)) {
+  DCHECK_LE(dex_files_.size(), kMaxDexFiles);
+  location_checksums_.reserve(dex_files_.size());
+  for (size_t i = 0; i != dex_files_.size(); ++i) {
+    const DexFile* dex_file = dex_files_[i];
+    location_checksums_.push_back(dex_file->GetLocationChecksum());
+    for (uint32_t class_def_index = 0; class_def_index != dex_file->NumClassDefs();
+         ++class_def_index) {
+      const char* descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(class_def_index));
+      Entry entry = { ComputeModifiedUtf8Hash(descriptor),
+                      dchecked_integral_cast<uint16_t>(i),
+                      dchecked_integral_cast<uint16_t>(class_def_index) };
+      // Does not replace an earlier definition of the same descriptor, which takes precedence.
+      entries_.insert(entry);
+    }
+  }
+  entries_.ShrinkToMaximumLoad();
+}
+
+std::pair<const DexFile*, const dex::ClassDef*> ClassPathIndex::Lookup(const char* descriptor,
+                                                                       uint32_t hash) const {
+  DCHECK_EQ(ComputeModifiedUtf8Hash(descriptor), hash);
+  auto it = entries_.FindWithHash(DescriptorHashPair(descriptor, hash), hash);
+  if (it == entries_.end()) {
+    return {nullptr, nullptr};
+  }
+  const DexFile* dex_file = dex_files_[it->dex_file_index];
+  return {dex_file, &dex_file->GetClassDef(it->class_def_index)};
+}
+
+bool ClassPathIndex::IsIndexed(size_t index, const DexFile* dex_file) const {
+  return index < dex_files_.size() &&
+         dex_files_[index] == dex_file &&
+         location_checksums_[index] == dex_file->GetLocationChecksum();
+}
+
+const char* ClassPathIndex::GetDescriptor(const Entry& entry) const {
+  const DexFile* dex_file = dex_files_[entry.dex_file_index];
+  return dex_file->GetClassDescriptor(dex_file->GetClassDef(entry.class_def_index));
+}
+
+bool ClassPathIndex::EntryEquals::operator()(const Entry& a, const Entry& b) const {
+  return a.hash == b.hash && strcmp(index_->GetDescriptor(a), index_->GetDescriptor(b)) == 0;
+}
+
+bool ClassPathIndex::EntryEquals::operator()(const Entry& a, const DescriptorHashPair& b) const {
+  return a.hash == b.second && strcmp(index_->GetDescriptor(a), b.first) == 0;
+}
+
+}  // namespace art
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_PATH_INDEX_H_
+#define ART_RUNTIME_CLASS_PATH_INDEX_H_
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/hash_set.h"
+#include "base/macros.h"
+
+namespace art {
+
+class DexFile;
+
+namespace dex {
+struct ClassDef;
+}  // namespace dex
+
+// An index of the class definitions of a class path, i.e. of an ordered list of dex files.
+//
+// Looking up a descriptor in a class path otherwise probes the type lookup table of each dex
+// file in turn, which is slow for misses in class paths with many dex files. The index maps
+// a descriptor to its first definition in the class path with a single hash lookup.
+//
+// The index is immutable once built and may be used concurrently without locking.
+class ClassPathIndex {
+ public:
+  // Class paths with fewer dex files are searched linearly, which is as fast as the index.
+  static constexpr size_t kMinDexFiles = 4u;
+
+  // The maximum number of dex files that an index can cover.
+  static constexpr size_t kMaxDexFiles = 0xffffu;
+
+  explicit ClassPathIndex(std::vector<const DexFile*>&& dex_files);
+
+  size_t NumDexFiles() const {
+    return dex_files_.size();
+  }
+
+  const DexFile* GetDexFile(size_t index) const {
+    return dex_files_[index];
+  }
+
+  // Returns whether `dex_file` is the dex file indexed at `index`. The location checksum guards
+  // against a different dex file allocated at the address of an indexed one that was closed.
+  bool IsIndexed(size_t index, const DexFile* dex_file) const;
+
+  // Returns the first definition of `descriptor` in the indexed dex files, or a pair of nulls.
+  std::pair<const DexFile*, const dex::ClassDef*> Lookup(const char* descriptor,
+                                                         uint32_t hash) const;
+
+  // Returns the number of distinct descriptors in the index.
+  size_t Size() const {
+    return entries_.size();
+  }
+
+ private:
+  // An indexed class definition. 8 bytes, to keep the index of a large class path small.
+  struct Entry {
+    uint32_t hash;
+    uint16_t dex_file_index;
+    uint16_t class_def_index;
+  };
+
+  using DescriptorHashPair = std::pair<const char*, uint32_t>;
+
+  class EntryEmptyFn {
+   public:
+    void MakeEmpty(Entry& item) const {
+      item.dex_file_index = kInvalidDexFileIndex;
+    }
+    bool IsEmpty(const Entry& item) const {
+      return item.dex_file_index == kInvalidDexFileIndex;
+    }
+  };
+
+  class EntryHash {
+   public:
+    size_t operator()(const Entry& entry) const {
+      return entry.hash;
+    }
+    size_t operator()(const DescriptorHashPair& pair) const {
+      return pair.second;
+    }
+  };
+
+  class EntryEquals {
+   public:
+    explicit EntryEquals(const ClassPathIndex* index) : index_(index) {}
+    bool operator()(const Entry& a, const Entry& b) const;
+    bool operator()(const Entry& a, const DescriptorHashPair& b) const;
+
+   private:
+    const ClassPathIndex* index_;
+  };
+
+  using EntrySet = HashSet<Entry, EntryEmptyFn, EntryHash, EntryEquals>;
+
+  static constexpr uint16_t kInvalidDexFileIndex = 0xffffu;
+
+  const char* GetDescriptor(const Entry& entry) const;
+
+  const std::vector<const DexFile*> dex_files_;
+  std::vector<uint32_t> location_checksums_;
+  EntrySet entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassPathIndex);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_PATH_INDEX_H_
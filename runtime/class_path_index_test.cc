@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_path_index.h"
+
+#include <memory>
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "dex/dex_file-inl.h"
+#include "dex/utf.h"
+
+namespace art {
+
+class ClassPathIndexTest : public CommonRuntimeTest {
+ protected:
+  std::pair<const DexFile*, const dex::ClassDef*> Lookup(const ClassPathIndex& index,
+                                                         const char* descriptor) {
+    return index.Lookup(descriptor, ComputeModifiedUtf8Hash(descriptor));
+  }
+};
+
+TEST_F(ClassPathIndexTest, Lookup) {
+  std::vector<std::unique_ptr<const DexFile>> multi_dex = OpenTestDexFiles("MultiDex");
+  std::unique_ptr<const DexFile> nested = OpenTestDexFile("Nested");
+  ASSERT_EQ(multi_dex.size(), 2u);
+
+  ClassPathIndex index(
+      std::vector<const DexFile*>{multi_dex[0].get(), multi_dex[1].get(), nested.get()});
+  ASSERT_EQ(index.NumDexFiles(), 3u);
+
+  auto [main_dex_file, main_class_def] = Lookup(index, "LMain;");
+  ASSERT_TRUE(main_class_def != nullptr);
+  EXPECT_EQ(main_dex_file, multi_dex[0].get());
+  EXPECT_STREQ(main_dex_file->GetClassDescriptor(*main_class_def), "LMain;");
+
+  auto [second_dex_file, second_class_def] = Lookup(index, "LSecond;");
+  ASSERT_TRUE(second_class_def != nullptr);
+  EXPECT_EQ(second_dex_file, multi_dex[1].get());
+  EXPECT_STREQ(second_dex_file->GetClassDescriptor(*second_class_def), "LSecond;");
+
+  auto [nested_dex_file, nested_class_def] = Lookup(index, "LNested;");
+  ASSERT_TRUE(nested_class_def != nullptr);
+  EXPECT_EQ(nested_dex_file, nested.get());
+
+  auto [missing_dex_file, missing_class_def] = Lookup(index, "LMissing;");
+  EXPECT_TRUE(missing_dex_file == nullptr);
+  EXPECT_TRUE(missing_class_def == nullptr);
+}
+
+TEST_F(ClassPathIndexTest, FirstDefinitionWins) {
+  std::vector<std::unique_ptr<const DexFile>> multi_dex = OpenTestDexFiles("MultiDex");
+  std::vector<std::unique_ptr<const DexFile>> modified =
+      OpenTestDexFiles("MultiDexModifiedSecondary");
+  ASSERT_EQ(multi_dex.size(), 2u);
+  ASSERT_EQ(modified.size(), 2u);
+
+  // Both class paths define `Main` and `Second`, the dex files listed first take precedence.
+  ClassPathIndex index(std::vector<const DexFile*>{
+      modified[1].get(), multi_dex[0].get(), multi_dex[1].get(), modified[0].get()});
+  EXPECT_EQ(Lookup(index, "LSecond;").first, modified[1].get());
+  EXPECT_EQ(Lookup(index, "LMain;").first, multi_dex[0].get());
+  EXPECT_EQ(index.Size(), 2u);
+}
+
+TEST_F(ClassPathIndexTest, IsIndexed) {
+  std::vector<std::unique_ptr<const DexFile>> multi_dex = OpenTestDexFiles("MultiDex");
+  ASSERT_EQ(multi_dex.size(), 2u);
+
+  ClassPathIndex index(std::vector<const DexFile*>{multi_dex[0].get()});
+  EXPECT_TRUE(index.IsIndexed(0u, multi_dex[0].get()));
+  EXPECT_FALSE(index.IsIndexed(0u, multi_dex[1].get()));
+  // The index covers only a prefix of a class path that has more dex files.
+  EXPECT_FALSE(index.IsIndexed(1u, multi_dex[1].get()));
+}
+
+}  // namespace art
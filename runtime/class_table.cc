@@ -23,7 +23,9 @@
 
 namespace art {
 
-ClassTable::ClassTable() : lock_("Class loader classes", kClassLoaderClassesLock) {
+ClassTable::ClassTable()
+    : lock_("Class loader classes", kClassLoaderClassesLock),
+      class_path_index_(nullptr) {
   Runtime* const runtime = Runtime::Current();
   classes_.push_back(ClassSet(runtime->GetHashTableMinLoadFactor(),
                               runtime->GetHashTableMaxLoadFactor()));
@@ -157,6 +159,14 @@ bool ClassTable::InsertOatFile(const OatFile* oat_file) {
   return InsertOatFileLocked(oat_file);
 }
 
+const ClassPathIndex* ClassTable::SetClassPathIndex(std::unique_ptr<ClassPathIndex> index) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  const ClassPathIndex* result = index.get();
+  class_path_indexes_.push_back(std::move(index));
+  class_path_index_.store(result, std::memory_order_release);
+  return result;
+}
+
 bool ClassTable::InsertOatFileLocked(const OatFile* oat_file) {
   if (ContainsElement(oat_files_, oat_file)) {
     return false;
@@ -17,14 +17,17 @@
 #ifndef ART_RUNTIME_CLASS_TABLE_H_
 #define ART_RUNTIME_CLASS_TABLE_H_
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "base/allocator.h"
+#include "base/atomic.h"
 #include "base/hash_set.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_path_index.h"
 #include "gc_root.h"
 #include "obj_ptr.h"
 
@@ -251,6 +254,16 @@ class ClassTable {
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns the most recently built index of the class path of the class loader, or null.
+  const ClassPathIndex* GetClassPathIndex() const {
+    return class_path_index_.load(std::memory_order_acquire);
+  }
+
+  // Make `index` the index of the class path of the class loader and return it. The indexes
+  // that it replaces stay alive with the class table since concurrent lookups may use them.
+  const ClassPathIndex* SetClassPathIndex(std::unique_ptr<ClassPathIndex> index)
+      REQUIRES(!lock_);
+
   // Read a table from ptr and put it at the front of the class set.
   size_t ReadFromMemory(uint8_t* ptr)
       REQUIRES(!lock_)
@@ -297,6 +310,10 @@ class ClassTable {
   std::vector<GcRoot<mirror::Object>> strong_roots_ GUARDED_BY(lock_);
   // Keep track of oat files with GC roots associated with dex caches in `strong_roots_`.
   std::vector<const OatFile*> oat_files_ GUARDED_BY(lock_);
+  // All indexes of the class path built so far, see `SetClassPathIndex()`.
+  std::vector<std::unique_ptr<ClassPathIndex>> class_path_indexes_ GUARDED_BY(lock_);
+  // The current index of the class path, the last one of `class_path_indexes_`.
+  Atomic<const ClassPathIndex*> class_path_index_;
 
   friend class linker::ImageWriter;  // for InsertWithoutLocks.
 };
@@ -27,6 +27,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
 #include <numeric>
 #include <string>
@@ -383,10 +384,15 @@ MarkCompact::MarkCompact(Heap* heap)
       uffd_minor_fault_supported_(false),
       use_uffd_sigbus_(IsSigbusFeatureAvailable()),
       minor_fault_initialized_(false),
-      map_linear_alloc_shared_(false) {
+      map_linear_alloc_shared_(false),
+      use_generational_(heap->GetUseGenerationalCMC()),
+      young_gen_(false) {
   if (kIsDebugBuild) {
     updated_roots_.reset(new std::unordered_set<void*>());
   }
+  old_gen_end_ = bump_pointer_space_->Begin();
+  next_old_gen_end_ = old_gen_end_;
+  old_gen_objects_ = 0;
   // TODO: When using minor-fault feature, the first GC after zygote-fork
   // requires mapping the linear-alloc again with MAP_SHARED. This leaves a
   // gap for suspended threads to access linear-alloc when it's empty (after
@@ -496,25 +502,51 @@ MarkCompact::MarkCompact(Heap* heap)
   // In most of the cases, we don't expect more than one LinearAlloc space.
   linear_alloc_spaces_data_.reserve(1);
 
-  // Initialize GC metrics.
+  InitializeMetrics(/*young_gen=*/false);
+}
+
+void MarkCompact::InitializeMetrics(bool young_gen) {
   metrics::ArtMetrics* metrics = GetMetrics();
-  // The mark-compact collector supports only full-heap collections at the moment.
-  gc_time_histogram_ = metrics->FullGcCollectionTime();
-  metrics_gc_count_ = metrics->FullGcCount();
-  metrics_gc_count_delta_ = metrics->FullGcCountDelta();
-  gc_throughput_histogram_ = metrics->FullGcThroughput();
-  gc_tracing_throughput_hist_ = metrics->FullGcTracingThroughput();
-  gc_throughput_avg_ = metrics->FullGcThroughputAvg();
-  gc_tracing_throughput_avg_ = metrics->FullGcTracingThroughputAvg();
-  gc_scanned_bytes_ = metrics->FullGcScannedBytes();
-  gc_scanned_bytes_delta_ = metrics->FullGcScannedBytesDelta();
-  gc_freed_bytes_ = metrics->FullGcFreedBytes();
-  gc_freed_bytes_delta_ = metrics->FullGcFreedBytesDelta();
-  gc_duration_ = metrics->FullGcDuration();
-  gc_duration_delta_ = metrics->FullGcDurationDelta();
+  if (young_gen) {
+    gc_time_histogram_ = metrics->YoungGcCollectionTime();
+    metrics_gc_count_ = metrics->YoungGcCount();
+    metrics_gc_count_delta_ = metrics->YoungGcCountDelta();
+    gc_throughput_histogram_ = metrics->YoungGcThroughput();
+    gc_tracing_throughput_hist_ = metrics->YoungGcTracingThroughput();
+    gc_throughput_avg_ = metrics->YoungGcThroughputAvg();
+    gc_tracing_throughput_avg_ = metrics->YoungGcTracingThroughputAvg();
+    gc_scanned_bytes_ = metrics->YoungGcScannedBytes();
+    gc_scanned_bytes_delta_ = metrics->YoungGcScannedBytesDelta();
+    gc_freed_bytes_ = metrics->YoungGcFreedBytes();
+    gc_freed_bytes_delta_ = metrics->YoungGcFreedBytesDelta();
+    gc_duration_ = metrics->YoungGcDuration();
+    gc_duration_delta_ = metrics->YoungGcDurationDelta();
+  } else {
+    gc_time_histogram_ = metrics->FullGcCollectionTime();
+    metrics_gc_count_ = metrics->FullGcCount();
+    metrics_gc_count_delta_ = metrics->FullGcCountDelta();
+    gc_throughput_histogram_ = metrics->FullGcThroughput();
+    gc_tracing_throughput_hist_ = metrics->FullGcTracingThroughput();
+    gc_throughput_avg_ = metrics->FullGcThroughputAvg();
+    gc_tracing_throughput_avg_ = metrics->FullGcTracingThroughputAvg();
+    gc_scanned_bytes_ = metrics->FullGcScannedBytes();
+    gc_scanned_bytes_delta_ = metrics->FullGcScannedBytesDelta();
+    gc_freed_bytes_ = metrics->FullGcFreedBytes();
+    gc_freed_bytes_delta_ = metrics->FullGcFreedBytesDelta();
+    gc_duration_ = metrics->FullGcDuration();
+    gc_duration_delta_ = metrics->FullGcDurationDelta();
+  }
   are_metrics_initialized_ = true;
 }
 
+void MarkCompact::ResetGenerations() {
+  old_gen_end_ = bump_pointer_space_->Begin();
+  next_old_gen_end_ = old_gen_end_;
+  old_gen_objects_ = 0;
+  young_gen_ = false;
+  moving_space_bitmap_->Clear();
+}
+
 void MarkCompact::AddLinearAllocSpaceData(uint8_t* begin, size_t len) {
   DCHECK_ALIGNED(begin, kPageSize);
   DCHECK_ALIGNED(len, kPageSize);
@@ -594,16 +626,58 @@ void MarkCompact::BindAndResetBitmaps() {
     } else {
       CHECK(!space->IsZygoteSpace());
       CHECK(!space->IsImageSpace());
-      // The card-table corresponding to bump-pointer and non-moving space can
-      // be cleared, because we are going to traverse all the reachable objects
-      // in these spaces. This card-table will eventually be used to track
-      // mutations while concurrent marking is going on.
-      card_table->ClearCardRange(space->Begin(), space->Limit());
+      if (young_gen_) {
+        // In a young collection the old generation (and the non-moving space)
+        // is not traced. Age the cards which were dirtied since the last GC
+        // so that they can be scanned for references into the young
+        // generation. The young portion of the moving space is traced in its
+        // entirety, so its cards can be cleared.
+        if (space == bump_pointer_space_) {
+          uint8_t* young_begin = AlignUp(old_gen_end_, accounting::CardTable::kCardSize);
+          card_table->ModifyCardsAtomic(
+              space->Begin(),
+              young_begin,
+              [](uint8_t card) {
+                return (card == gc::accounting::CardTable::kCardClean)
+                    ? card
+                    : gc::accounting::CardTable::kCardAged;
+              },
+              /* card modified visitor */ VoidFunctor());
+          card_table->ClearCardRange(young_begin, space->Limit());
+        } else {
+          card_table->ModifyCardsAtomic(space->Begin(),
+                                        space->End(),
+                                        AgeCardVisitor(),
+                                        /* card modified visitor */ VoidFunctor());
+        }
+      } else {
+        // The card-table corresponding to bump-pointer and non-moving space can
+        // be cleared, because we are going to traverse all the reachable objects
+        // in these spaces. This card-table will eventually be used to track
+        // mutations while concurrent marking is going on.
+        card_table->ClearCardRange(space->Begin(), space->Limit());
+      }
       if (space != bump_pointer_space_) {
         CHECK_EQ(space, heap_->GetNonMovingSpace());
         non_moving_space_ = space;
         non_moving_space_bitmap_ = space->GetMarkBitmap();
+        if (young_gen_) {
+          // Everything that was live in the non-moving space at the end of the
+          // last GC is retained.
+          non_moving_space_bitmap_->CopyFrom(space->GetLiveBitmap());
+        }
+      }
+    }
+  }
+  if (use_generational_) {
+    if (young_gen_) {
+      space::LargeObjectSpace* const los = heap_->GetLargeObjectsSpace();
+      if (los != nullptr) {
+        los->CopyLiveToMarked();
       }
+    } else {
+      // Full collections trace the old generation too, so drop its mark bits.
+      moving_space_bitmap_->Clear();
     }
   }
 }
@@ -645,6 +719,15 @@ void MarkCompact::InitializePhase() {
   from_space_slide_diff_ = from_space_begin_ - bump_pointer_space_->Begin();
   black_allocations_begin_ = bump_pointer_space_->Limit();
   walk_super_class_cache_ = nullptr;
+  // A young collection needs an old generation. Zygote collections are always
+  // full as the moving space is evacuated into the zygote space at fork.
+  young_gen_ = young_gen_ &&
+               use_generational_ &&
+               old_gen_end_ > bump_pointer_space_->Begin() &&
+               !Runtime::Current()->IsZygote();
+  if (use_generational_) {
+    InitializeMetrics(young_gen_);
+  }
   // TODO: Would it suffice to read it once in the constructor, which is called
   // in zygote process?
   pointer_size_ = Runtime::Current()->GetClassLinker()->GetImagePointerSize();
@@ -919,10 +1002,34 @@ class MarkCompact::ConcurrentCompactionGcTask : public SelfDeletingTask {
   size_t index_;
 };
 
+void MarkCompact::SetOldGenLiveWords() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  uint8_t* space_begin = bump_pointer_space_->Begin();
+  size_t old_gen_size = old_gen_end_ - space_begin;
+  DCHECK_GT(old_gen_size, 0u);
+  DCHECK_LE(old_gen_end_, black_allocations_begin_);
+  // The old generation is densely packed, so every word in it is live.
+  live_words_bitmap_->SetLiveWords(reinterpret_cast<uintptr_t>(space_begin), old_gen_size);
+  size_t full_chunks = old_gen_size / kOffsetChunkSize;
+  std::fill_n(chunk_info_vec_, full_chunks, kOffsetChunkSize);
+  // The last chunk may be shared with young objects, whose live-bytes have
+  // already been accounted for during marking.
+  size_t remainder = old_gen_size % kOffsetChunkSize;
+  if (remainder > 0) {
+    chunk_info_vec_[full_chunks] += remainder;
+  }
+  // The old objects were counted as allocated in MarkingPause(), but were never
+  // discovered by marking.
+  freed_objects_ -= static_cast<int32_t>(old_gen_objects_);
+}
+
 void MarkCompact::PrepareForCompaction() {
   uint8_t* space_begin = bump_pointer_space_->Begin();
   size_t vector_len = (black_allocations_begin_ - space_begin) / kOffsetChunkSize;
   DCHECK_LE(vector_len, vector_length_);
+  if (young_gen_) {
+    SetOldGenLiveWords();
+  }
   for (size_t i = 0; i < vector_len; i++) {
     DCHECK_LE(chunk_info_vec_[i], kOffsetChunkSize);
     DCHECK_EQ(chunk_info_vec_[i], live_words_bitmap_->LiveBytesInBitmapWord(i));
@@ -971,6 +1078,8 @@ void MarkCompact::PrepareForCompaction() {
     DCHECK_EQ(chunk_info_vec_[i], 0u);
   }
   post_compact_end_ = AlignUp(space_begin + total, kPageSize);
+  // All the objects surviving this GC cycle are promoted to the old generation.
+  next_old_gen_end_ = space_begin + total;
   CHECK_EQ(post_compact_end_, space_begin + moving_first_objs_count_ * kPageSize);
   black_objs_slide_diff_ = black_allocations_begin_ - post_compact_end_;
   // How do we handle compaction of heap portion used for allocations after the
@@ -1487,6 +1596,20 @@ void MarkCompact::CompactPage(mirror::Object* obj,
                               bool needs_memset_zero) {
   DCHECK(moving_space_bitmap_->Test(obj)
          && live_words_bitmap_->Test(obj));
+  if (young_gen_) {
+    // Old generation pages stay in place. If none of their objects refer to
+    // the young generation, then they can be copied as is.
+    uint8_t* space_begin = bump_pointer_space_->Begin();
+    uint8_t* pre_compact_page = space_begin + offset * kAlignment;
+    if (pre_compact_page + kPageSize <= old_gen_end_) {
+      DCHECK_ALIGNED(pre_compact_page, kPageSize);
+      size_t page_idx = (pre_compact_page - space_begin) / kPageSize;
+      if (!old_gen_page_needs_update_[page_idx]) {
+        memcpy(addr, pre_compact_page + from_space_slide_diff_, kPageSize);
+        return;
+      }
+    }
+  }
   DCHECK(live_words_bitmap_->Test(offset)) << "obj=" << obj
                                            << " offset=" << offset
                                            << " addr=" << static_cast<void*>(addr)
@@ -2108,6 +2231,12 @@ void MarkCompact::FreeFromSpacePages(size_t cur_page_idx, int mode) {
   }
 
   DCHECK_NE(reclaim_begin, nullptr);
+  if (young_gen_) {
+    // The old generation pages are compacted last, and their objects may need
+    // their classes (which are also old, but could be at a higher address)
+    // from the from-space. So retain them until the compaction is finished.
+    reclaim_begin = std::max(reclaim_begin, AlignUp(old_gen_end_, kPageSize));
+  }
   DCHECK_ALIGNED(reclaim_begin, kPageSize);
   DCHECK_ALIGNED(last_reclaimed_page_, kPageSize);
   // Check if the 'class_after_obj_map_' map allows pages to be freed.
@@ -2658,6 +2787,60 @@ class MarkCompact::LinearAllocPageUpdater {
   bool last_page_touched_;
 };
 
+void MarkCompact::UpdateCardsForGenerations() {
+  TimingLogger::ScopedTiming t("(Paused)UpdateCardsForGenerations", GetTimings());
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  uint8_t* const space_begin = bump_pointer_space_->Begin();
+  uint8_t* young_begin = space_begin;
+  if (young_gen_) {
+    // The pages entirely within the old generation don't move. Such a page
+    // needs its references updated only if some object starting in it, or
+    // overlapping with its beginning, is on a card which was modified since
+    // the last GC.
+    size_t old_gen_pages = (old_gen_end_ - space_begin) / kPageSize;
+    DCHECK_LE(old_gen_pages, moving_first_objs_count_);
+    old_gen_page_needs_update_.assign(old_gen_pages, false);
+    for (size_t i = 0; i < old_gen_pages; i++) {
+      uint8_t* card = card_table->CardFromAddr(first_objs_moving_space_[i].AsMirrorPtr());
+      uint8_t* card_end = card_table->CardFromAddr(space_begin + (i + 1) * kPageSize);
+      old_gen_page_needs_update_[i] =
+          std::any_of(card, card_end, [](uint8_t c) {
+            return c != accounting::CardTable::kCardClean;
+          });
+    }
+    // The objects referred by the old generation from the aged cards are
+    // getting promoted. So only the cards dirtied after the marking pause, which
+    // may refer to black allocations, need to be remembered.
+    young_begin = AlignDown(old_gen_end_, accounting::CardTable::kCardSize);
+    card_table->ModifyCardsAtomic(space_begin,
+                                  young_begin,
+                                  [](uint8_t card) {
+                                    return (card == accounting::CardTable::kCardDirty)
+                                        ? card
+                                        : accounting::CardTable::kCardClean;
+                                  },
+                                  /* card modified visitor */ VoidFunctor());
+  }
+  // The objects being compacted would be at a different address after
+  // compaction. Move their dirty cards accordingly. Everything allocated after
+  // the marking pause is going to be in the young generation in the next GC
+  // cycle, so their cards can be cleared.
+  std::vector<mirror::Object*> dirty_objs;
+  WriterMutexLock wmu(thread_running_gc_, *Locks::heap_bitmap_lock_);
+  card_table->Scan</*kClearCard*/ false>(
+      moving_space_bitmap_,
+      young_begin,
+      black_allocations_begin_,
+      [this, &dirty_objs](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+        dirty_objs.push_back(PostCompactAddress(obj));
+      },
+      accounting::CardTable::kCardDirty);
+  card_table->ClearCardRange(young_begin, bump_pointer_space_->Limit());
+  for (mirror::Object* obj : dirty_objs) {
+    card_table->MarkCard(obj);
+  }
+}
+
 void MarkCompact::CompactionPause() {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   Runtime* runtime = Runtime::Current();
@@ -2710,6 +2893,9 @@ void MarkCompact::CompactionPause() {
     // Start updating roots and system weaks now.
     heap_->GetReferenceProcessor()->UpdateRoots(this);
   }
+  if (use_generational_) {
+    UpdateCardsForGenerations();
+  }
   {
     TimingLogger::ScopedTiming t2("(Paused)UpdateClassLoaderRoots", GetTimings());
     ReaderMutexLock rmu(thread_running_gc_, *Locks::classlinker_classes_lock_);
@@ -3803,10 +3989,33 @@ void MarkCompact::UpdateAndMarkModUnion() {
 
 void MarkCompact::MarkReachableObjects() {
   UpdateAndMarkModUnion();
+  if (young_gen_) {
+    ScanOldGenCards();
+  }
   // Recursively mark all the non-image bits set in the mark bitmap.
   ProcessMarkStack();
 }
 
+void MarkCompact::ScanOldGenCards() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  // The old generation is already marked in moving_space_bitmap_, and
+  // everything live at the end of the last GC is marked in the non-moving
+  // space's bitmap (see BindAndResetBitmaps()). So scanning the objects on the
+  // aged cards is sufficient to find all the references into the young
+  // generation.
+  card_table->Scan</*kClearCard*/ false>(moving_space_bitmap_,
+                                         bump_pointer_space_->Begin(),
+                                         AlignUp(old_gen_end_, accounting::CardTable::kCardSize),
+                                         ScanObjectVisitor(this),
+                                         accounting::CardTable::kCardAged);
+  card_table->Scan</*kClearCard*/ false>(non_moving_space_bitmap_,
+                                         non_moving_space_->Begin(),
+                                         non_moving_space_->End(),
+                                         ScanObjectVisitor(this),
+                                         accounting::CardTable::kCardAged);
+}
+
 class MarkCompact::CardModifiedVisitor {
  public:
   explicit CardModifiedVisitor(MarkCompact* const mark_compact,
@@ -3852,8 +4061,10 @@ void MarkCompact::ScanDirtyObjects(bool paused, uint8_t minimum_age) {
     const bool is_immune_space = space->IsZygoteSpace() || space->IsImageSpace();
     if (paused) {
       DCHECK_EQ(minimum_age, gc::accounting::CardTable::kCardDirty);
-      // We can clear the card-table for any non-immune space.
-      if (is_immune_space) {
+      // We can clear the card-table for any non-immune space. Except for the
+      // moving space in young collections, where the cards are retained until
+      // the compaction pause.
+      if (is_immune_space || (young_gen_ && space == bump_pointer_space_)) {
         card_table->Scan</*kClearCard*/false>(space->GetMarkBitmap(),
                                               space->Begin(),
                                               space->End(),
@@ -3883,7 +4094,10 @@ void MarkCompact::ScanDirtyObjects(bool paused, uint8_t minimum_age) {
         // cards but keep the already aged cards unchanged.
         // In either case, visit the objects on the cards that were changed from
         // dirty to aged.
-        if (is_immune_space) {
+        // In young collections the same applies to the moving space, as its
+        // aged cards are required in the compaction pause to find the old
+        // generation pages whose references need updating.
+        if (is_immune_space || (young_gen_ && space == bump_pointer_space_)) {
           card_table->ModifyCardsAtomic(space->Begin(),
                                         space->End(),
                                         [](uint8_t card) {
@@ -4234,6 +4448,32 @@ void MarkCompact::DelayReferenceReferent(ObjPtr<mirror::Class> klass,
   heap_->GetReferenceProcessor()->DelayReferenceReferent(klass, ref, this);
 }
 
+void MarkCompact::MarkPromotedObjects() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  uint8_t* begin;
+  if (young_gen_) {
+    // Retain the marks of the old generation, which didn't move.
+    begin = old_gen_end_;
+    moving_space_bitmap_->ClearRange(reinterpret_cast<mirror::Object*>(begin),
+                                     reinterpret_cast<mirror::Object*>(
+                                         bump_pointer_space_->Limit()));
+  } else {
+    begin = bump_pointer_space_->Begin();
+    old_gen_objects_ = 0;
+    moving_space_bitmap_->Clear();
+  }
+  // The compacted objects are densely packed, so walk them linearly.
+  uint8_t* addr = begin;
+  while (addr < next_old_gen_end_) {
+    mirror::Object* obj = reinterpret_cast<mirror::Object*>(addr);
+    moving_space_bitmap_->Set(obj);
+    addr += RoundUp(obj->SizeOf<kDefaultVerifyFlags>(), kAlignment);
+    old_gen_objects_++;
+  }
+  DCHECK_EQ(addr, next_old_gen_end_);
+  old_gen_end_ = next_old_gen_end_;
+}
+
 void MarkCompact::FinishPhase() {
   GetCurrentIteration()->SetScannedBytes(bytes_scanned_);
   bool is_zygote = Runtime::Current()->IsZygote();
@@ -4256,11 +4496,13 @@ void MarkCompact::FinishPhase() {
   }
   info_map_.MadviseDontNeedAndZero();
   live_words_bitmap_->ClearBitmap();
-  // TODO: We can clear this bitmap right before compaction pause. But in that
-  // case we need to ensure that we don't assert on this bitmap afterwards.
-  // Also, we would still need to clear it here again as we may have to use the
-  // bitmap for black-allocations (see UpdateMovingSpaceBlackAllocations()).
-  moving_space_bitmap_->Clear();
+  if (!use_generational_) {
+    // TODO: We can clear this bitmap right before compaction pause. But in that
+    // case we need to ensure that we don't assert on this bitmap afterwards.
+    // Also, we would still need to clear it here again as we may have to use the
+    // bitmap for black-allocations (see UpdateMovingSpaceBlackAllocations()).
+    moving_space_bitmap_->Clear();
+  }
 
   if (UNLIKELY(is_zygote && IsValidFd(uffd_))) {
     heap_->DeleteThreadPool();
@@ -4284,6 +4526,9 @@ void MarkCompact::FinishPhase() {
   {
     ReaderMutexLock mu(thread_running_gc_, *Locks::mutator_lock_);
     WriterMutexLock mu2(thread_running_gc_, *Locks::heap_bitmap_lock_);
+    if (use_generational_) {
+      MarkPromotedObjects();
+    }
     heap_->ClearMarkedObjects();
   }
   std::swap(moving_to_space_fd_, moving_from_space_fd_);
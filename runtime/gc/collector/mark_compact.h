@@ -23,6 +23,7 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "barrier.h"
 #include "base/atomic.h"
@@ -88,9 +89,20 @@ class MarkCompact final : public GarbageCollector {
   bool SigbusHandler(siginfo_t* info) REQUIRES(!lock_) NO_THREAD_SAFETY_ANALYSIS;
 
   GcType GetGcType() const override {
-    return kGcTypeFull;
+    return young_gen_ ? kGcTypeSticky : kGcTypeFull;
   }
 
+  // Called by the heap before running a GC cycle to request a young-generation
+  // (minor) collection, which compacts only the portion of the moving space
+  // allocated since the last GC. The request is honored in InitializePhase()
+  // only if generational mode is enabled and an old generation exists.
+  void SetYoungGen(bool young_gen) { young_gen_ = young_gen; }
+
+  // Forget the old generation, making the next collection a full one. Called
+  // when the moving space is evacuated by some other collector, like in
+  // Heap::PreZygoteFork().
+  void ResetGenerations();
+
   CollectorType GetCollectorType() const override {
     return kCollectorTypeCMC;
   }
@@ -306,6 +318,19 @@ class MarkCompact final : public GarbageCollector {
   // Compute offsets (in chunk_info_vec_) and other data structures required
   // during concurrent compaction.
   void PrepareForCompaction() REQUIRES_SHARED(Locks::mutator_lock_);
+  // For young collections, treat all of the old generation as live by setting
+  // the corresponding live-words and chunk-info entries in one go.
+  void SetOldGenLiveWords() REQUIRES_SHARED(Locks::mutator_lock_);
+  // Maintain the card-table as the old-to-young remembered set across
+  // compaction. For young collections, record which old-generation pages need
+  // their references updated and clean the cards which don't need to be
+  // remembered anymore. Then move the dirty cards of the objects being compacted
+  // to their post-compact addresses.
+  void UpdateCardsForGenerations() REQUIRES(Locks::mutator_lock_, !Locks::heap_bitmap_lock_);
+  // Mark all the objects promoted to the old generation in this GC cycle in
+  // the moving-space bitmap, so that the next young collection sees them as
+  // already marked.
+  void MarkPromotedObjects() REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Copy kPageSize live bytes starting from 'offset' (within the moving space),
   // which must be within 'obj', into the kPageSize sized memory pointed by 'addr'.
@@ -389,6 +414,10 @@ class MarkCompact final : public GarbageCollector {
   // Traverse through the reachable objects and mark them.
   void MarkReachableObjects() REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::heap_bitmap_lock_);
+  // Scan aged cards of the old generation and non-moving space for references
+  // into the young generation. Only used in young collections.
+  void ScanOldGenCards() REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(Locks::heap_bitmap_lock_);
   // Scan (only) immune spaces looking for references into the garbage collected
   // spaces.
   void UpdateAndMarkModUnion() REQUIRES_SHARED(Locks::mutator_lock_)
@@ -517,6 +546,9 @@ class MarkCompact final : public GarbageCollector {
   void MarkZygoteLargeObjects() REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::heap_bitmap_lock_);
 
+  // Point the GC metrics to either the young-generation or the full-heap ones.
+  void InitializeMetrics(bool young_gen);
+
   void ZeropageIoctl(void* addr, bool tolerate_eexist, bool tolerate_enoent);
   void CopyIoctl(void* dst, void* buffer);
   // Called after updating a linear-alloc page to either map a zero-page if the
@@ -703,6 +735,22 @@ class MarkCompact final : public GarbageCollector {
   // Cache (from_space_begin_ - bump_pointer_space_->Begin()) so that we can
   // compute from-space address of a given pre-comapct addr efficiently.
   ptrdiff_t from_space_slide_diff_;
+  // End of the old generation in the moving space. Objects in
+  // [bump_pointer_space_->Begin(), old_gen_end_) survived at least one GC cycle
+  // and are densely packed. They are kept marked in moving_space_bitmap_ across
+  // GC cycles, and are neither traced nor moved by young collections. Equal to
+  // the space's begin when there is no old generation.
+  uint8_t* old_gen_end_;
+  // End of the old generation once the ongoing GC cycle finishes, which is the
+  // end of the compacted (non-black) objects.
+  uint8_t* next_old_gen_end_;
+  // Number of objects in the old generation.
+  size_t old_gen_objects_;
+  // For every page entirely in the old generation, whether any of its objects
+  // may hold a reference into the young generation, as per the card-table, and
+  // hence needs its references updated during compaction. Only used in young
+  // collections.
+  std::vector<bool> old_gen_page_needs_update_;
 
   // TODO: Remove once an efficient mechanism to deal with double root updation
   // is incorporated.
@@ -761,6 +809,11 @@ class MarkCompact final : public GarbageCollector {
   // non-zygote processes during first GC, which sets up everyting for using
   // minor-fault from next GC.
   bool map_linear_alloc_shared_;
+  // Whether generational mode is enabled (-Xgc:generational_cmc). If so, every
+  // object surviving a GC cycle is promoted to the old generation.
+  const bool use_generational_;
+  // True if the current GC cycle is a young-generation collection.
+  bool young_gen_;
 
   class FlipCallback;
   class ThreadFlipVisitor;
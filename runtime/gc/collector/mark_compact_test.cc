@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc/collector/mark_compact.h"
+
+#include "android-base/stringprintf.h"
+#include "base/metrics/metrics.h"
+#include "base/time_utils.h"
+#include "base/utils.h"
+#include "class_linker-inl.h"
+#include "class_root-inl.h"
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "handle_scope-inl.h"
+#include "jni/java_vm_ext.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/object_array-alloc-inl.h"
+#include "mirror/object_array-inl.h"
+#include "mirror/string-inl.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace gc {
+namespace collector {
+
+using android::base::StringPrintf;
+
+class MarkCompactTest : public CommonRuntimeTest {
+ public:
+  MarkCompactTest() {
+    use_boot_image_ = true;  // Make the Runtime creation cheaper.
+  }
+
+ protected:
+  static constexpr size_t kRetainedObjects = 4096;
+  static constexpr size_t kRounds = 32;
+  static constexpr size_t kGarbageObjectsPerRound = 8192;
+  // Every round, replace one in kUpdateStride of the retained objects. Once the
+  // retained array is in the old generation, this exercises the old-to-young
+  // references tracked by the card-table.
+  static constexpr size_t kUpdateStride = 64;
+
+  static std::string RetainedString(size_t index, size_t round) {
+    return StringPrintf("retained %zu %zu", index, round);
+  }
+
+  // Keep a set of objects alive across GCs while allocating plenty of
+  // short-lived ones, running a (non-explicit) GC after every round. Verify
+  // that the long-lived objects are intact, and report pause times and
+  // throughput of the collector.
+  void RunGcBenchmark(const char* mode) {
+    Runtime* runtime = Runtime::Current();
+    Heap* heap = runtime->GetHeap();
+    if (heap->CurrentCollectorType() != kCollectorTypeCMC) {
+      printf("WARNING: TEST DISABLED FOR NON-CMC GC\n");
+      return;
+    }
+    MarkCompact* collector = heap->MarkCompactCollector();
+    ASSERT_NE(collector, nullptr);
+    Thread* self = Thread::Current();
+    jobject retained;
+    {
+      ScopedObjectAccess soa(self);
+      StackHandleScope<1> hs(self);
+      Handle<mirror::Class> klass =
+          hs.NewHandle(GetClassRoot<mirror::ObjectArray<mirror::Object>>());
+      ObjPtr<mirror::ObjectArray<mirror::Object>> array =
+          mirror::ObjectArray<mirror::Object>::Alloc(self, klass.Get(), kRetainedObjects);
+      ASSERT_NE(array, nullptr);
+      retained = soa.Vm()->AddGlobalRef(self, array);
+      for (size_t i = 0; i < kRetainedObjects; ++i) {
+        ObjPtr<mirror::String> string =
+            mirror::String::AllocFromModifiedUtf8(self, RetainedString(i, 0).c_str());
+        ASSERT_NE(string, nullptr);
+        soa.Decode<mirror::ObjectArray<mirror::Object>>(retained)->Set<false>(i, string);
+      }
+    }
+    // Start measuring from a full collection, which also creates the old
+    // generation in generational mode.
+    heap->CollectGarbage(/* clear_soft_references= */ false);
+    const uint64_t gc_count_before = heap->GetGcCount();
+    const uint64_t pause_time_before = collector->GetTotalPausedTimeNs();
+    const uint64_t gc_time_before = heap->GetGcTime();
+    const uint64_t start_time = NanoTime();
+    size_t bytes_allocated = 0;
+    for (size_t round = 1; round <= kRounds; ++round) {
+      {
+        ScopedObjectAccess soa(self);
+        for (size_t i = 0; i < kGarbageObjectsPerRound; ++i) {
+          ObjPtr<mirror::String> string =
+              mirror::String::AllocFromModifiedUtf8(self, "short-lived garbage string");
+          ASSERT_NE(string, nullptr);
+          bytes_allocated += string->SizeOf();
+        }
+        ObjPtr<mirror::ObjectArray<mirror::Object>> array =
+            soa.Decode<mirror::ObjectArray<mirror::Object>>(retained);
+        for (size_t i = round % kUpdateStride; i < kRetainedObjects; i += kUpdateStride) {
+          ObjPtr<mirror::String> string =
+              mirror::String::AllocFromModifiedUtf8(self, RetainedString(i, round).c_str());
+          ASSERT_NE(string, nullptr);
+          bytes_allocated += string->SizeOf();
+          // The array may have been moved by the allocation above.
+          array = soa.Decode<mirror::ObjectArray<mirror::Object>>(retained);
+          array->Set<false>(i, string);
+        }
+      }
+      // Uses the heap's choice of young or full collection.
+      heap->ConcurrentGC(
+          self, kGcCauseBackground, /*force_full=*/ false, heap->GetCurrentGcNum() + 1);
+    }
+    const uint64_t duration_ns = NanoTime() - start_time;
+    const uint64_t gc_count = heap->GetGcCount() - gc_count_before;
+    const uint64_t pause_time_ns = collector->GetTotalPausedTimeNs() - pause_time_before;
+    const uint64_t gc_time_ns = heap->GetGcTime() - gc_time_before;
+    EXPECT_GE(gc_count, kRounds);
+
+    // Check that the retained objects survived all the collections.
+    {
+      ScopedObjectAccess soa(self);
+      ObjPtr<mirror::ObjectArray<mirror::Object>> array =
+          soa.Decode<mirror::ObjectArray<mirror::Object>>(retained);
+      for (size_t i = 0; i < kRetainedObjects; ++i) {
+        size_t last_round = 0;
+        for (size_t round = 1; round <= kRounds; ++round) {
+          if (round % kUpdateStride == i % kUpdateStride) {
+            last_round = round;
+          }
+        }
+        ObjPtr<mirror::Object> obj = array->Get(i);
+        ASSERT_NE(obj, nullptr) << "index=" << i;
+        ASSERT_TRUE(obj->IsString()) << "index=" << i;
+        EXPECT_EQ(obj->AsString()->ToModifiedUtf8(), RetainedString(i, last_round));
+      }
+      soa.Vm()->DeleteGlobalRef(self, retained);
+    }
+
+    metrics::ArtMetrics* metrics = runtime->GetMetrics();
+    LOG(INFO) << "MarkCompact benchmark (" << mode << "):"
+              << " gcs=" << gc_count
+              << " young_gcs=" << metrics->YoungGcCount()->Value()
+              << " total_pause=" << PrettyDuration(pause_time_ns)
+              << " mean_pause=" << PrettyDuration(pause_time_ns / std::max<uint64_t>(gc_count, 1))
+              << " gc_time=" << PrettyDuration(gc_time_ns)
+              << " duration=" << PrettyDuration(duration_ns)
+              << " throughput=" << PrettySize(bytes_allocated * UINT64_C(1000000000) /
+                                              std::max<uint64_t>(duration_ns, 1)) << "/s";
+  }
+};
+
+class GenerationalMarkCompactTest : public MarkCompactTest {
+ public:
+  void SetUpRuntimeOptions(RuntimeOptions* options) override {
+    MarkCompactTest::SetUpRuntimeOptions(options);
+    options->push_back(std::make_pair("-Xgc:generational_cmc", nullptr));
+  }
+};
+
+TEST_F(MarkCompactTest, FullGcBenchmark) {
+  RunGcBenchmark("full-only");
+  if (Runtime::Current()->GetHeap()->CurrentCollectorType() == kCollectorTypeCMC) {
+    EXPECT_TRUE(Runtime::Current()->GetMetrics()->YoungGcCount()->IsNull());
+  }
+}
+
+TEST_F(GenerationalMarkCompactTest, GenerationalGcBenchmark) {
+  RunGcBenchmark("generational");
+  Heap* heap = Runtime::Current()->GetHeap();
+  if (heap->CurrentCollectorType() == kCollectorTypeCMC) {
+    EXPECT_TRUE(heap->GetUseGenerationalCMC());
+    // The first collection after a full one is always a young one.
+    EXPECT_FALSE(Runtime::Current()->GetMetrics()->YoungGcCount()->IsNull());
+  }
+}
+
+}  // namespace collector
+}  // namespace gc
+}  // namespace art
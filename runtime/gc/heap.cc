@@ -285,6 +285,7 @@ Heap::Heap(size_t initial_size,
            bool ignore_target_footprint,
            bool always_log_explicit_gcs,
            bool use_tlab,
+           bool use_adaptive_tlab_sizing,
            bool verify_pre_gc_heap,
            bool verify_pre_sweeping_heap,
            bool verify_post_gc_heap,
@@ -295,6 +296,7 @@ Heap::Heap(size_t initial_size,
            bool measure_gc_performance,
            bool use_homogeneous_space_compaction_for_oom,
            bool use_generational_cc,
+           bool use_generational_cmc,
            uint64_t min_interval_homogeneous_space_compaction_by_oom,
            bool dump_region_info_before_gc,
            bool dump_region_info_after_gc)
@@ -384,6 +386,7 @@ Heap::Heap(size_t initial_size,
       concurrent_copying_collector_(nullptr),
       is_running_on_memory_tool_(Runtime::Current()->IsRunningOnMemoryTool()),
       use_tlab_(use_tlab),
+      use_adaptive_tlab_sizing_(use_adaptive_tlab_sizing),
       main_space_backup_(nullptr),
       min_interval_homogeneous_space_compaction_by_oom_(
           min_interval_homogeneous_space_compaction_by_oom),
@@ -394,6 +397,7 @@ Heap::Heap(size_t initial_size,
       pending_heap_trim_(nullptr),
       use_homogeneous_space_compaction_for_oom_(use_homogeneous_space_compaction_for_oom),
       use_generational_cc_(use_generational_cc),
+      use_generational_cmc_(use_generational_cmc),
       running_collection_is_blocking_(false),
       blocking_gc_count_(0U),
       blocking_gc_time_(0U),
@@ -415,7 +419,10 @@ Heap::Heap(size_t initial_size,
       boot_image_spaces_(),
       boot_images_start_address_(0u),
       boot_images_size_(0u),
-      pre_oome_gc_count_(0u) {
+      pre_oome_gc_count_(0u),
+      tlabs_retired_(0u),
+      tlab_bytes_used_(0u),
+      tlab_bytes_wasted_(0u) {
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "Heap() entering";
   }
@@ -1116,7 +1123,13 @@ void Heap::CreateThreadPool(size_t num_threads) {
     num_threads = std::max(parallel_gc_threads_, conc_gc_threads_);
   }
   if (num_threads != 0) {
-    thread_pool_.reset(new ThreadPool("Heap thread pool", num_threads));
+    // Parallel marking tasks split their mark stacks from worker threads, let the workers keep
+    // those tasks in their own deques.
+    thread_pool_.reset(new ThreadPool("Heap thread pool",
+                                      num_threads,
+                                      /*create_peers=*/ false,
+                                      ThreadPoolWorker::kDefaultStackSize,
+                                      /*work_stealing=*/ true));
   }
 }
 
@@ -1305,6 +1318,17 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
     }
   }
 
+  const uint64_t tlabs_retired = tlabs_retired_.load(std::memory_order_relaxed);
+  if (tlabs_retired != 0u) {
+    const uint64_t tlab_bytes_used = tlab_bytes_used_.load(std::memory_order_relaxed);
+    const uint64_t tlab_bytes_wasted = tlab_bytes_wasted_.load(std::memory_order_relaxed);
+    const uint64_t tlab_bytes = std::max<uint64_t>(tlab_bytes_used + tlab_bytes_wasted, 1u);
+    os << "Total TLABs retired: " << tlabs_retired
+       << " mean size: " << PrettySize(tlab_bytes / tlabs_retired)
+       << " wasted: " << PrettySize(tlab_bytes_wasted)
+       << " (" << (100.0 * tlab_bytes_wasted / tlab_bytes) << "%)\n";
+  }
+
   if (kDumpRosAllocStatsOnSigQuit && rosalloc_space_ != nullptr) {
     rosalloc_space_->DumpStats(os);
   }
@@ -1337,6 +1361,9 @@ void Heap::ResetGcPerformanceInfo() {
   blocking_gc_count_ = 0;
   blocking_gc_time_ = 0;
   pre_oome_gc_count_.store(0, std::memory_order_relaxed);
+  tlabs_retired_.store(0u, std::memory_order_relaxed);
+  tlab_bytes_used_.store(0u, std::memory_order_relaxed);
+  tlab_bytes_wasted_.store(0u, std::memory_order_relaxed);
   gc_count_last_window_ = 0;
   blocking_gc_count_last_window_ = 0;
   last_update_time_gc_count_rate_histograms_ =  // Round down by the window duration.
@@ -2257,6 +2284,9 @@ void Heap::ChangeCollector(CollectorType collector_type) {
         break;
       }
       case kCollectorTypeCMC: {
+        if (use_generational_cmc_) {
+          gc_plan_.push_back(collector::kGcTypeSticky);
+        }
         gc_plan_.push_back(collector::kGcTypeFull);
         if (use_tlab_) {
           ChangeAllocator(kAllocatorTypeTLAB);
@@ -2496,6 +2526,11 @@ void Heap::PreZygoteFork() {
         region_space_->GetMarkBitmap()->Clear();
       } else {
         bump_pointer_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
+        if (mark_compact_ != nullptr) {
+          // Evacuated everything out of the bump-pointer space, so there is no
+          // old generation anymore.
+          mark_compact_->ResetGenerations();
+        }
       }
     }
     if (temp_space_ != nullptr) {
@@ -2775,6 +2810,7 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
         collector = semi_space_collector_;
         break;
       case kCollectorTypeCMC:
+        mark_compact_->SetYoungGen(gc_type == collector::kGcTypeSticky);
         collector = mark_compact_;
         break;
       case kCollectorTypeCC:
@@ -3720,6 +3756,9 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
         non_sticky_collector = FindCollectorByGcType(collector::kGcTypePartial);
       }
       CHECK(non_sticky_collector != nullptr);
+    } else if (collector_type_ == kCollectorTypeCMC) {
+      // The same collector performs both young and full collections.
+      non_sticky_collector = mark_compact_;
     }
     double sticky_gc_throughput_adjustment = GetStickyGcThroughputAdjustment(use_generational_cc_);
 
@@ -4385,6 +4424,51 @@ void Heap::AdjustSampleOffset(size_t adjustment) {
   GetHeapSampler().AdjustSampleOffset(adjustment);
 }
 
+void Heap::UpdateTlabSizing(Thread* thread) {
+  Thread::TlabSizing* sizing = thread->GetTlabSizing();
+  const uint32_t gc_num = GetCurrentGcNum();
+  if (sizing->gc_num == gc_num) {
+    return;
+  }
+  if (sizing->desired_size != 0u || sizing->bytes_used != 0u) {
+    // Threads that did not use any TLAB during a whole GC cycle are considered idle.
+    const size_t bytes_per_gc = (gc_num - sizing->gc_num == 1u) ? sizing->bytes_used : 0u;
+    const size_t target_size = std::max(bytes_per_gc / kTlabRefillsPerGc, kPartialTlabSize);
+    // Average with the previous size to smooth out phase changes of the thread.
+    sizing->desired_size = (sizing->desired_size == 0u)
+        ? target_size
+        : (sizing->desired_size + target_size) / 2u;
+  }
+  sizing->gc_num = gc_num;
+  sizing->bytes_used = 0u;
+}
+
+size_t Heap::GetAdaptiveTlabSize(Thread* self, size_t default_size, size_t max_size) {
+  if (!use_adaptive_tlab_sizing_) {
+    return default_size;
+  }
+  UpdateTlabSizing(self);
+  const size_t desired_size = self->GetTlabSizing()->desired_size;
+  if (desired_size == 0u) {
+    return default_size;
+  }
+  return std::min(RoundUp(desired_size, kPartialTlabSize), max_size);
+}
+
+void Heap::RetireTlab(Thread* thread) {
+  const size_t used_bytes = thread->GetTlabPos() - thread->GetTlabStart();
+  const size_t wasted_bytes = thread->GetTlabEnd() - thread->GetTlabPos();
+  if (use_adaptive_tlab_sizing_) {
+    // The bytes belong to the window of the current GC, if any: GCs revoke all TLABs before
+    // they complete.
+    UpdateTlabSizing(thread);
+    thread->GetTlabSizing()->bytes_used += used_bytes;
+  }
+  tlabs_retired_.fetch_add(1u, std::memory_order_relaxed);
+  tlab_bytes_used_.fetch_add(used_bytes, std::memory_order_relaxed);
+  tlab_bytes_wasted_.fetch_add(wasted_bytes, std::memory_order_relaxed);
+}
+
 void Heap::CheckGcStressMode(Thread* self, ObjPtr<mirror::Object>* obj) {
   DCHECK(gc_stress_mode_);
   auto* const runtime = Runtime::Current();
@@ -4483,8 +4567,10 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
     // There is enough space if we grow the TLAB. Lets do that. This increases the
     // TLAB bytes.
     const size_t min_expand_size = alloc_size - self->TlabSize();
+    const size_t tlab_size =
+        GetAdaptiveTlabSize(self, kPartialTlabSize, space::RegionSpace::kRegionSize);
     size_t next_tlab_size = JHPCalculateNextTlabSize(self,
-                                                     kPartialTlabSize,
+                                                     tlab_size,
                                                      alloc_size,
                                                      &take_sample,
                                                      &bytes_until_sample);
@@ -4503,7 +4589,8 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
     // TODO: for large allocations, which are rare, maybe we should allocate
     // that object and return. There is no need to revoke the current TLAB,
     // particularly if it's mostly unutilized.
-    size_t def_pr_tlab_size = RoundDown(alloc_size + kDefaultTLABSize, kPageSize) - alloc_size;
+    const size_t tlab_size = GetAdaptiveTlabSize(self, kDefaultTLABSize, kMaxAdaptiveTlabSize);
+    size_t def_pr_tlab_size = RoundDown(alloc_size + tlab_size, kPageSize) - alloc_size;
     size_t next_tlab_size = JHPCalculateNextTlabSize(self,
                                                      def_pr_tlab_size,
                                                      alloc_size,
@@ -4530,9 +4617,11 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
       if (LIKELY(!IsOutOfMemoryOnAllocation(allocator_type,
                                             space::RegionSpace::kRegionSize,
                                             grow))) {
-        size_t def_pr_tlab_size = kUsePartialTlabs
-                                      ? kPartialTlabSize
-                                      : gc::space::RegionSpace::kRegionSize;
+        // The busiest threads get whole regions, see GetAdaptiveTlabSize().
+        size_t def_pr_tlab_size =
+            kUsePartialTlabs
+                ? GetAdaptiveTlabSize(self, kPartialTlabSize, gc::space::RegionSpace::kRegionSize)
+                : gc::space::RegionSpace::kRegionSize;
         size_t next_pr_tlab_size = JHPCalculateNextTlabSize(self,
                                                             def_pr_tlab_size,
                                                             alloc_size,
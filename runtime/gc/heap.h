@@ -133,6 +133,14 @@ class Heap {
   // How much we grow the TLAB if we can do it.
   static constexpr size_t kPartialTlabSize = 16 * KB;
   static constexpr bool kUsePartialTlabs = true;
+  // Default for -XX:AdaptiveTlabSizing, which sizes TLABs according to the allocation rate of
+  // each thread, see GetAdaptiveTlabSize().
+  static constexpr bool kDefaultAdaptiveTlabSizing = true;
+  // Adaptive TLAB sizing aims for this many TLAB refills per thread between two GCs.
+  static constexpr size_t kTlabRefillsPerGc = 32;
+  // Largest TLAB handed out to the busiest threads by the bump pointer space. The region space
+  // is limited to one region per TLAB as objects cannot straddle region boundaries.
+  static constexpr size_t kMaxAdaptiveTlabSize = 1 * MB;
 
   static constexpr size_t kDefaultStartingSize = kPageSize;
   static constexpr size_t kDefaultInitialSize = 2 * MB;
@@ -218,6 +226,7 @@ class Heap {
        bool ignore_target_footprint,
        bool always_log_explicit_gcs,
        bool use_tlab,
+       bool use_adaptive_tlab_sizing,
        bool verify_pre_gc_heap,
        bool verify_pre_sweeping_heap,
        bool verify_post_gc_heap,
@@ -228,6 +237,7 @@ class Heap {
        bool measure_gc_performance,
        bool use_homogeneous_space_compaction,
        bool use_generational_cc,
+       bool use_generational_cmc,
        uint64_t min_interval_homogeneous_space_compaction_by_oom,
        bool dump_region_info_before_gc,
        bool dump_region_info_after_gc);
@@ -554,6 +564,10 @@ class Heap {
     return use_generational_cc_;
   }
 
+  bool GetUseGenerationalCMC() const {
+    return use_generational_cmc_;
+  }
+
   // Returns the number of objects currently allocated.
   size_t GetObjectsAllocated() const
       REQUIRES(!Locks::heap_bitmap_lock_);
@@ -915,6 +929,13 @@ class Heap {
   // Reduce the number of bytes to the next sample position by this adjustment.
   void AdjustSampleOffset(size_t adjustment);
 
+  // Returns the size of the next TLAB of `self`, derived from the bytes the thread allocated in
+  // TLABs between the last two GCs and clamped to [kPartialTlabSize, max_size]. Returns
+  // `default_size` while the allocation rate of the thread is not known.
+  size_t GetAdaptiveTlabSize(Thread* self, size_t default_size, size_t max_size);
+  // Record the usage and waste of the TLAB of `thread`, which is about to be reset.
+  void RetireTlab(Thread* thread);
+
   // Allocation tracking support
   // Callers to this function use double-checked locking to ensure safety on allocation_records_
   bool IsAllocTrackingEnabled() const {
@@ -1118,6 +1139,10 @@ class Heap {
                                    size_t* bytes_tl_bulk_allocated)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Start a new allocation rate window for `thread` if a GC completed since the last one, and
+  // recompute the desired TLAB size of the thread from the previous window.
+  void UpdateTlabSizing(Thread* thread);
+
   void ThrowOutOfMemoryError(Thread* self, size_t byte_count, AllocatorType allocator_type)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -1607,6 +1632,7 @@ class Heap {
 
   const bool is_running_on_memory_tool_;
   const bool use_tlab_;
+  const bool use_adaptive_tlab_sizing_;
 
   // Pointer to the space which becomes the new main space when we do homogeneous space compaction.
   // Use unique_ptr since the space is only added during the homogeneous compaction phase.
@@ -1653,6 +1679,11 @@ class Heap {
   // for major collections. Set in Heap constructor.
   const bool use_generational_cc_;
 
+  // If true, enable generational collection when using the Concurrent
+  // Mark-Compact (CMC) collector, i.e. compact only the young generation in
+  // minor collections. Set in Heap constructor.
+  const bool use_generational_cmc_;
+
   // True if the currently running collection has made some thread wait.
   bool running_collection_is_blocking_ GUARDED_BY(gc_complete_lock_);
   // The number of blocking GC runs.
@@ -1712,6 +1743,12 @@ class Heap {
   // The number of times we initiated a GC of last resort to try to avoid an OOME.
   Atomic<uint64_t> pre_oome_gc_count_;
 
+  // TLAB statistics for DumpGcPerformanceInfo(): the number of TLABs retired, and the bytes of
+  // those TLABs that were used by objects and that were left unused.
+  Atomic<uint64_t> tlabs_retired_;
+  Atomic<uint64_t> tlab_bytes_used_;
+  Atomic<uint64_t> tlab_bytes_wasted_;
+
   // An installed allocation listener.
   Atomic<AllocationListener*> alloc_listener_;
   // An installed GC Pause listener.
@@ -15,6 +15,7 @@
  */
 
 #include <algorithm>
+#include <sstream>
 
 #include "base/metrics/metrics.h"
 #include "class_linker-inl.h"
@@ -106,6 +107,68 @@ TEST_F(HeapTest, DumpGCPerformanceOnShutdown) {
   Runtime::Current()->SetDumpGCPerformanceOnShutdown(true);
 }
 
+TEST_F(HeapTest, AdaptiveTlabSizing) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  AllocatorType allocator = heap->GetCurrentAllocator();
+  if (allocator != kAllocatorTypeTLAB && allocator != kAllocatorTypeRegionTLAB) {
+    printf("WARNING: TEST DISABLED FOR NON-TLAB ALLOCATOR\n");
+    return;
+  }
+  Thread* self = Thread::Current();
+  {
+    ScopedObjectAccess soa(self);
+    for (size_t i = 0; i < 64 * KB; ++i) {
+      ASSERT_NE(mirror::String::AllocFromModifiedUtf8(self, "short-lived string"), nullptr);
+    }
+  }
+  // The GC revokes the TLAB, which completes the allocation rate window of this thread.
+  heap->CollectGarbage(/* clear_soft_references= */ false);
+  {
+    ScopedObjectAccess soa(self);
+    ASSERT_NE(mirror::String::AllocFromModifiedUtf8(self, "short-lived string"), nullptr);
+  }
+  EXPECT_GE(self->GetTlabSizing()->desired_size, Heap::kPartialTlabSize);
+  EXPECT_EQ(self->GetTlabSizing()->gc_num, heap->GetCurrentGcNum());
+
+  // Replay GC windows on the sizing state of this thread to check how the size adapts.
+  {
+    ScopedObjectAccess soa(self);
+    Thread::TlabSizing* sizing = self->GetTlabSizing();
+    const Thread::TlabSizing saved_sizing = *sizing;
+    constexpr size_t kBusyTlabSize = 256 * KB;
+    sizing->desired_size = Heap::kPartialTlabSize;
+    // The size grows towards the target of a thread that keeps refilling its TLAB.
+    for (size_t i = 0; i != 4u; ++i) {
+      const size_t previous_size = sizing->desired_size;
+      sizing->gc_num = heap->GetCurrentGcNum() - 1u;
+      sizing->bytes_used = Heap::kTlabRefillsPerGc * kBusyTlabSize;
+      size_t tlab_size =
+          heap->GetAdaptiveTlabSize(self, Heap::kPartialTlabSize, Heap::kMaxAdaptiveTlabSize);
+      EXPECT_GT(sizing->desired_size, previous_size);
+      EXPECT_LE(tlab_size, kBusyTlabSize);
+      EXPECT_EQ(sizing->bytes_used, 0u);
+    }
+    // The size is clamped to the largest TLAB the space can hand out.
+    sizing->gc_num = heap->GetCurrentGcNum() - 1u;
+    sizing->bytes_used = Heap::kTlabRefillsPerGc * kBusyTlabSize;
+    EXPECT_EQ(heap->GetAdaptiveTlabSize(self, Heap::kPartialTlabSize, 64 * KB), 64 * KB);
+    // The size shrinks back to the minimum once the thread stays idle for whole GC cycles.
+    size_t tlab_size = kBusyTlabSize;
+    for (size_t i = 0; i != 20u; ++i) {
+      const size_t previous_size = sizing->desired_size;
+      sizing->gc_num = heap->GetCurrentGcNum() - 2u;
+      tlab_size = heap->GetAdaptiveTlabSize(self, kBusyTlabSize, Heap::kMaxAdaptiveTlabSize);
+      EXPECT_LE(sizing->desired_size, previous_size);
+    }
+    EXPECT_EQ(tlab_size, Heap::kPartialTlabSize);
+    *sizing = saved_sizing;
+  }
+
+  std::ostringstream oss;
+  heap->DumpGcPerformanceInfo(oss);
+  EXPECT_NE(oss.str().find("Total TLABs retired: "), std::string::npos) << oss.str();
+}
+
 bool AnyIsFalse(bool x, bool y) { return !x || !y; }
 
 TEST_F(HeapTest, GCMetrics) {
@@ -271,5 +334,36 @@ TEST_F(ZygoteHeapTest, PreZygoteFork) {
   Runtime::Current()->GetHeap()->PreZygoteFork();
 }
 
+class NoAdaptiveTlabSizingHeapTest : public CommonRuntimeTest {
+ public:
+  NoAdaptiveTlabSizingHeapTest() {
+    use_boot_image_ = true;  // Make the Runtime creation cheaper.
+  }
+
+  void SetUpRuntimeOptions(RuntimeOptions* options) override {
+    CommonRuntimeTest::SetUpRuntimeOptions(options);
+    options->push_back(std::make_pair("-XX:AdaptiveTlabSizing:false", nullptr));
+  }
+};
+
+TEST_F(NoAdaptiveTlabSizingHeapTest, DefaultTlabSize) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  Thread* self = Thread::Current();
+  {
+    ScopedObjectAccess soa(self);
+    for (size_t i = 0; i < 64 * KB; ++i) {
+      ASSERT_NE(mirror::String::AllocFromModifiedUtf8(self, "short-lived string"), nullptr);
+    }
+  }
+  heap->CollectGarbage(/* clear_soft_references= */ false);
+  ScopedObjectAccess soa(self);
+  ASSERT_NE(mirror::String::AllocFromModifiedUtf8(self, "short-lived string"), nullptr);
+  // No allocation rate is recorded and TLABs keep their default size.
+  EXPECT_EQ(self->GetTlabSizing()->bytes_used, 0u);
+  EXPECT_EQ(self->GetTlabSizing()->desired_size, 0u);
+  EXPECT_EQ(heap->GetAdaptiveTlabSize(self, Heap::kPartialTlabSize, Heap::kMaxAdaptiveTlabSize),
+            Heap::kPartialTlabSize);
+}
+
 }  // namespace gc
 }  // namespace art
@@ -16,13 +16,26 @@
 
 #include "image_space.h"
 
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include <sys/statvfs.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "android-base/logging.h"
@@ -67,6 +80,7 @@
 #include "profile/profile_compilation_info.h"
 #include "runtime.h"
 #include "space-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace gc {
@@ -87,6 +101,7 @@ static constexpr size_t kMaxTotalImageReservationSize = 1 * GB;
 }  // namespace
 
 Atomic<uint32_t> ImageSpace::bitmap_index_(0);
+Atomic<bool> ImageSpace::parallel_relocation_enabled_(true);
 
 ImageSpace::ImageSpace(const std::string& image_filename,
                        const char* image_location,
@@ -266,6 +281,427 @@ std::ostream& operator<<(std::ostream& os, const RelocationRange& reloc) {
             << reinterpret_cast<const void*>(reloc.Dest() + reloc.Length()) << ")";
 }
 
+// Runs independent parts of image relocation in parallel. The relocation is split into tasks
+// that write disjoint memory, such as chunks of the objects section or the ArtMethod arrays.
+//
+// The runtime thread pool runs the tasks when it is available, e.g. for app images. The boot
+// image is relocated before threads can attach to the runtime, so short-lived threads that are
+// not attached run the tasks instead and are joined before `Run()` returns. Tasks must therefore
+// not use `Thread::Current()` nor `ObjPtr<>`s created on another thread.
+class ImageSpace::ParallelRelocation {
+ public:
+  // Images with less memory to relocate are relocated on the calling thread.
+  static constexpr size_t kMinParallelSize = 1 * MB;
+  // Objects sections are split into chunks with boundaries aligned to this size, which is a
+  // multiple of the memory covered by a bitmap word, so that chunks do not share bitmap words.
+  static constexpr size_t kObjectsChunkSize = 256 * KB;
+  // Same limit as the number of runtime thread pool workers.
+  static constexpr size_t kMaxThreads = 4u;
+
+  explicit ParallelRelocation(size_t relocated_size)
+      : use_parallel_(relocated_size >= kMinParallelSize &&
+                      parallel_relocation_enabled_.load(std::memory_order_relaxed)) {}
+
+  template <typename Task>
+  void AddTask(Task&& task) {
+    tasks_.emplace_back(std::forward<Task>(task));
+  }
+
+  // Add tasks calling `visitor` for the objects marked in `bitmap` in the range [begin, end).
+  template <typename Visitor>
+  void AddObjectTasks(accounting::ContinuousSpaceBitmap* bitmap,
+                      uintptr_t begin,
+                      uintptr_t end,
+                      const Visitor& visitor) {
+    for (uintptr_t chunk_begin = begin; chunk_begin < end; ) {
+      uintptr_t chunk_end =
+          std::min(RoundDown(chunk_begin, kObjectsChunkSize) + kObjectsChunkSize, end);
+      AddTask([=]() NO_THREAD_SAFETY_ANALYSIS {
+        bitmap->VisitMarkedRange(chunk_begin, chunk_end, visitor);
+      });
+      chunk_begin = chunk_end;
+    }
+  }
+
+  // Run the tasks added so far and wait for them to complete.
+  void Run() {
+    size_t num_threads = use_parallel_
+        ? std::min({static_cast<size_t>(std::thread::hardware_concurrency()),
+                    kMaxThreads,
+                    tasks_.size()})
+        : 1u;
+    std::atomic<size_t> next_task(0u);
+    auto run_tasks = [&]() {
+      for (size_t i; (i = next_task.fetch_add(1u, std::memory_order_relaxed)) < tasks_.size(); ) {
+        tasks_[i]();
+      }
+    };
+    if (num_threads <= 1u) {
+      run_tasks();
+    } else {
+      ScopedTrace trace("Parallel relocation");
+      Thread* self = Thread::Current();
+      std::optional<Runtime::ScopedThreadPoolUsage> stpu;
+      if (self != nullptr && Runtime::Current() != nullptr) {
+        stpu.emplace();
+      }
+      ThreadPool* pool = stpu.has_value() ? stpu->GetThreadPool() : nullptr;
+      if (pool != nullptr) {
+        for (size_t i = 1u; i != num_threads; ++i) {
+          pool->AddTask(self, new FunctionTask([&](Thread*) { run_tasks(); }));
+        }
+        run_tasks();
+        // The workers do not need the mutator lock, so the caller may keep holding it.
+        pool->Wait(self, /*do_work=*/ true, /*may_hold_locks=*/ true);
+      } else {
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1u);
+        for (size_t i = 1u; i != num_threads; ++i) {
+          threads.emplace_back(run_tasks);
+        }
+        run_tasks();
+        for (std::thread& thread : threads) {
+          thread.join();
+        }
+      }
+      VLOG(image) << "Relocated " << tasks_.size() << " ranges on " << num_threads << " threads";
+    }
+    tasks_.clear();
+  }
+
+ private:
+  const bool use_parallel_;
+  std::vector<std::function<void()>> tasks_;
+};
+
+// Decompresses the blocks of a compressed app image on first access to their pages. The image
+// memory is registered with userfaultfd in missing mode and a dedicated thread, not attached to
+// the runtime, resolves the page faults by decompressing the whole block containing the faulting
+// page and copying it in. Once all blocks are decompressed, the thread unregisters the image and
+// exits, and the image behaves like any anonymous mapping.
+//
+// Blocks must cover whole pages, i.e. all block boundaries other than the end of the image header
+// and the end of the image must be page aligned. The first block shares its first page with the
+// image header and is decompressed eagerly. Pages that are released with madvise() after their
+// block was decompressed, such as the image metadata, are resolved as zero pages.
+//
+// The userfaultfd also handles faults in kernel mode, so that system calls that access pages
+// that were not decompressed yet wait for them instead of failing with EFAULT. The kernel only
+// allows this for privileged processes; otherwise, the image is decompressed when it is loaded.
+//
+// A forked child does not inherit the fault handling thread, so all images are decompressed
+// completely by a pthread_atfork() handler before any fork().
+class ImageSpace::LazyDecompressor {
+ public:
+  // Images with fewer blocks are decompressed when they are loaded.
+  static constexpr size_t kMinBlocks = 4u;
+
+  // Set up lazy decompression of the image in `image_map`, which holds the image header, from
+  // the image file data in `data_map`. Returns null and leaves `data_map` unchanged if the image
+  // blocks are not suitable or userfaultfd is not available.
+  static std::unique_ptr<LazyDecompressor> Create(const char* image_filename,
+                                                  MemMap* image_map,
+                                                  MemMap* data_map,
+                                                  /*out*/std::string* error_msg) {
+    const ImageHeader& image_header = *reinterpret_cast<const ImageHeader*>(image_map->Begin());
+    ArrayRef<const ImageHeader::Block> blocks(image_header.GetBlocks(data_map->Begin()).begin(),
+                                              image_header.GetBlockCount());
+    if (blocks.size() < kMinBlocks) {
+      *error_msg = StringPrintf("Too few blocks: %zu", blocks.size());
+      return nullptr;
+    }
+    uint32_t offset = sizeof(ImageHeader);
+    for (const ImageHeader::Block& block : blocks) {
+      if (block.GetImageOffset() != offset ||
+          (offset != sizeof(ImageHeader) && !IsAligned<kPageSize>(offset))) {
+        *error_msg = StringPrintf("Block at offset %u does not start a page",
+                                  block.GetImageOffset());
+        return nullptr;
+      }
+      offset += block.GetImageSize();
+    }
+    if (offset != image_header.GetImageSize()) {
+      *error_msg = StringPrintf("Blocks end at %u, image size %u",
+                                offset,
+                                image_header.GetImageSize());
+      return nullptr;
+    }
+
+    android::base::unique_fd uffd(CreateUserfaultfd());
+    if (uffd.get() == -1) {
+      *error_msg = StringPrintf("Userfaultfd is not available: %s", strerror(errno));
+      return nullptr;
+    }
+    android::base::unique_fd stop_fd(eventfd(/*initval=*/ 0u, EFD_CLOEXEC));
+    if (stop_fd.get() == -1) {
+      *error_msg = StringPrintf("Failed to create eventfd: %s", strerror(errno));
+      return nullptr;
+    }
+
+    // Decompress the first block, which shares a page with the image header, and register the
+    // pages of the other blocks.
+    if (!blocks[0].Decompress(image_map->Begin(), data_map->Begin(), error_msg)) {
+      return nullptr;
+    }
+    uint8_t* lazy_begin = image_map->Begin() + blocks[1].GetImageOffset();
+    uint8_t* lazy_end = image_map->Begin() + RoundUp(image_header.GetImageSize(), kPageSize);
+    struct uffdio_register uffd_register;
+    uffd_register.range.start = reinterpret_cast<uintptr_t>(lazy_begin);
+    uffd_register.range.len = lazy_end - lazy_begin;
+    uffd_register.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if (ioctl(uffd.get(), UFFDIO_REGISTER, &uffd_register) != 0) {
+      *error_msg = StringPrintf("Failed to register image with userfaultfd: %s", strerror(errno));
+      return nullptr;
+    }
+
+    return std::unique_ptr<LazyDecompressor>(new LazyDecompressor(image_filename,
+                                                                  image_map->Begin(),
+                                                                  blocks,
+                                                                  std::move(*data_map),
+                                                                  std::move(uffd),
+                                                                  std::move(stop_fd)));
+  }
+
+  ~LazyDecompressor() {
+    {
+      std::lock_guard<std::mutex> lock(InstancesLock());
+      std::vector<LazyDecompressor*>& instances = Instances();
+      instances.erase(std::find(instances.begin(), instances.end(), this));
+    }
+    Stop();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  // Decompress all remaining blocks on the calling thread.
+  void Finish() {
+    std::lock_guard<std::mutex> lock(InstancesLock());
+    FinishLocked();
+  }
+
+ private:
+  // Requires `InstancesLock()`, which also keeps concurrent calls from joining the thread twice.
+  void FinishLocked() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      for (size_t i = 0; i != blocks_.size(); ++i) {
+        if (!decompressed_[i]) {
+          DecompressBlock(i);
+        }
+      }
+    }
+    // Let the fault handling thread unregister the image.
+    Stop();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  LazyDecompressor(const char* image_filename,
+                   uint8_t* image_begin,
+                   ArrayRef<const ImageHeader::Block> blocks,
+                   MemMap&& data_map,
+                   android::base::unique_fd&& uffd,
+                   android::base::unique_fd&& stop_fd)
+      : image_filename_(image_filename),
+        image_begin_(image_begin),
+        blocks_(blocks),
+        data_map_(std::move(data_map)),
+        uffd_(std::move(uffd)),
+        stop_fd_(std::move(stop_fd)),
+        decompressed_(blocks.size(), false),
+        remaining_blocks_(blocks.size() - 1u) {
+    decompressed_[0] = true;
+    size_t buffer_size = 0u;
+    for (const ImageHeader::Block& block : blocks_) {
+      buffer_size = std::max<size_t>(buffer_size, RoundUp(block.GetImageSize(), kPageSize));
+    }
+    buffer_.reset(new uint8_t[buffer_size]);
+    thread_ = std::thread([this]() { HandleFaults(); });
+
+    static std::once_flag at_fork_once;
+    std::call_once(at_fork_once, []() {
+      CHECK_EQ(pthread_atfork(&FinishAllBeforeFork, /*parent=*/ nullptr, /*child=*/ nullptr), 0);
+    });
+    std::lock_guard<std::mutex> lock(InstancesLock());
+    Instances().push_back(this);
+  }
+
+  // All live decompressors, finished before fork().
+  static std::mutex& InstancesLock() {
+    static std::mutex instances_lock;
+    return instances_lock;
+  }
+  static std::vector<LazyDecompressor*>& Instances() {
+    static std::vector<LazyDecompressor*>* instances = new std::vector<LazyDecompressor*>();
+    return *instances;
+  }
+
+  static void FinishAllBeforeFork() {
+    std::lock_guard<std::mutex> lock(InstancesLock());
+    for (LazyDecompressor* instance : Instances()) {
+      instance->FinishLocked();
+    }
+  }
+
+  static int CreateUserfaultfd() {
+#ifdef __NR_userfaultfd
+    // The fd is non-blocking because a fault reported by poll() can be resolved by Finish()
+    // before the fault handling thread reads it, in which case the message is dropped.
+    //
+    // Do not pass UFFD_USER_MODE_ONLY, kernel mode faults must be handled too. Unless the
+    // vm.unprivileged_userfaultfd sysctl is set, the kernel requires CAP_SYS_PTRACE for this and
+    // fails with EPERM otherwise.
+    int fd = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+#ifdef USERFAULTFD_IOC_NEW
+    // Newer kernels also let processes that can open /dev/userfaultfd handle kernel mode faults.
+    if (fd == -1 && errno == EPERM) {
+      android::base::unique_fd dev_fd(open("/dev/userfaultfd", O_RDWR | O_CLOEXEC));
+      if (dev_fd.get() != -1) {
+        fd = ioctl(dev_fd.get(), USERFAULTFD_IOC_NEW, O_CLOEXEC | O_NONBLOCK);
+      } else {
+        errno = EPERM;
+      }
+    }
+#endif
+    if (fd != -1) {
+      struct uffdio_api api = {.api = UFFD_API, .features = 0, .ioctls = 0};
+      if (ioctl(fd, UFFDIO_API, &api) != 0) {
+        close(fd);
+        return -1;
+      }
+    }
+    return fd;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+  }
+
+  void Stop() {
+    uint64_t value = 1u;
+    CHECK_EQ(TEMP_FAILURE_RETRY(write(stop_fd_.get(), &value, sizeof(value))),
+             static_cast<ssize_t>(sizeof(value)))
+        << "Failed to write eventfd: " << strerror(errno);
+  }
+
+  void HandleFaults() {
+    struct pollfd fds[] = {{uffd_.get(), POLLIN, 0}, {stop_fd_.get(), POLLIN, 0}};
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (remaining_blocks_ == 0u) {
+          break;
+        }
+      }
+      CHECK_NE(TEMP_FAILURE_RETRY(poll(fds, std::size(fds), /*timeout=*/ -1)), -1)
+          << "Failed to poll userfaultfd: " << strerror(errno);
+      if (fds[1].revents != 0) {
+        break;
+      }
+      struct uffd_msg msg;
+      ssize_t read_size = TEMP_FAILURE_RETRY(read(uffd_.get(), &msg, sizeof(msg)));
+      if (read_size == -1 && errno == EAGAIN) {
+        // The fault was resolved by another thread since poll() returned.
+        continue;
+      }
+      CHECK_EQ(read_size, static_cast<ssize_t>(sizeof(msg)))
+          << "Failed to read userfaultfd: " << strerror(errno);
+      CHECK_EQ(msg.event, UFFD_EVENT_PAGEFAULT);
+      HandleFault(reinterpret_cast<uint8_t*>(msg.arg.pagefault.address));
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    if (remaining_blocks_ == 0u) {
+      struct uffdio_range range;
+      range.start = reinterpret_cast<uintptr_t>(image_begin_ + blocks_[1].GetImageOffset());
+      range.len = RoundUp(blocks_.back().GetImageOffset() + blocks_.back().GetImageSize(),
+                          kPageSize) - blocks_[1].GetImageOffset();
+      CHECK_EQ(ioctl(uffd_.get(), UFFDIO_UNREGISTER, &range), 0)
+          << "ioctl_userfaultfd: unregister failed: " << strerror(errno);
+      data_map_.Reset();
+      buffer_.reset();
+      VLOG(image) << "Decompressed all blocks of " << image_filename_;
+    }
+  }
+
+  void HandleFault(uint8_t* fault_address) {
+    uint8_t* page = AlignDown(fault_address, kPageSize);
+    uint32_t offset = dchecked_integral_cast<uint32_t>(page - image_begin_);
+    // The blocks are sorted by image offset.
+    auto it = std::upper_bound(
+        blocks_.begin(),
+        blocks_.end(),
+        offset,
+        [](uint32_t value, const ImageHeader::Block& block) {
+          return value < block.GetImageOffset();
+        });
+    DCHECK(it != blocks_.begin());
+    size_t index = std::distance(blocks_.begin(), it) - 1u;
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!decompressed_[index]) {
+      DecompressBlock(index);
+    } else {
+      // Another thread faulted on the page before the block was decompressed, or the page was
+      // released since. Resolve the fault like it would be resolved without userfaultfd.
+      struct uffdio_zeropage uffd_zeropage;
+      uffd_zeropage.range.start = reinterpret_cast<uintptr_t>(page);
+      uffd_zeropage.range.len = kPageSize;
+      uffd_zeropage.mode = 0;
+      if (ioctl(uffd_.get(), UFFDIO_ZEROPAGE, &uffd_zeropage) != 0) {
+        CHECK_EQ(errno, EEXIST) << "ioctl_userfaultfd: zeropage failed: " << strerror(errno);
+        CHECK_EQ(ioctl(uffd_.get(), UFFDIO_WAKE, &uffd_zeropage.range), 0)
+            << "ioctl_userfaultfd: wake failed: " << strerror(errno);
+      }
+    }
+  }
+
+  // Requires `lock_`.
+  void DecompressBlock(size_t index) {
+    DCHECK(!decompressed_[index]);
+    const ImageHeader::Block& block = blocks_[index];
+    const size_t size = RoundUp(block.GetImageSize(), kPageSize);
+    std::string error_msg;
+    if (!block.DecompressTo(buffer_.get(), data_map_.Begin(), &error_msg)) {
+      // The faulting thread cannot continue without the contents of the block.
+      LOG(FATAL) << "Failed to decompress block of image " << image_filename_ << ": "
+                 << error_msg;
+      UNREACHABLE();
+    }
+    // Only the last block may end in the middle of a page.
+    std::fill(buffer_.get() + block.GetImageSize(), buffer_.get() + size, 0u);
+    struct uffdio_copy uffd_copy;
+    uffd_copy.dst = reinterpret_cast<uintptr_t>(image_begin_ + block.GetImageOffset());
+    uffd_copy.src = reinterpret_cast<uintptr_t>(buffer_.get());
+    uffd_copy.len = size;
+    uffd_copy.mode = 0;
+    uffd_copy.copy = 0;
+    CHECK_EQ(ioctl(uffd_.get(), UFFDIO_COPY, &uffd_copy), 0)
+        << "ioctl_userfaultfd: copy failed: " << strerror(errno);
+    DCHECK_EQ(uffd_copy.copy, static_cast<ssize_t>(size));
+    decompressed_[index] = true;
+    --remaining_blocks_;
+  }
+
+  const std::string image_filename_;
+  uint8_t* const image_begin_;
+  const ArrayRef<const ImageHeader::Block> blocks_;
+  // The image file data, including the compressed blocks and the block table.
+  MemMap data_map_;
+  const android::base::unique_fd uffd_;
+  // Signalled to stop the fault handling thread.
+  const android::base::unique_fd stop_fd_;
+  // Buffer for decompressing a block before copying it to the image.
+  std::unique_ptr<uint8_t[]> buffer_;
+
+  std::mutex lock_;
+  std::vector<bool> decompressed_;
+  size_t remaining_blocks_;
+
+  std::thread thread_;
+};
+
 template <PointerSize kPointerSize, typename HeapVisitor, typename NativeVisitor>
 class ImageSpace::PatchObjectVisitor final {
  public:
@@ -569,6 +1005,7 @@ class ImageSpace::Loader {
 
     std::unique_ptr<ImageSpace> space = Init(image_filename,
                                              image_location,
+                                             /*allow_lazy_decompression=*/ true,
                                              &logger,
                                              /*image_reservation=*/ nullptr,
                                              error_msg);
@@ -659,6 +1096,7 @@ class ImageSpace::Loader {
 
   static std::unique_ptr<ImageSpace> Init(const char* image_filename,
                                           const char* image_location,
+                                          bool allow_lazy_decompression,
                                           TimingLogger* logger,
                                           /*inout*/MemMap* image_reservation,
                                           /*out*/std::string* error_msg)
@@ -680,6 +1118,7 @@ class ImageSpace::Loader {
                 image_location,
                 /*profile_files=*/ {},
                 /*allow_direct_mapping=*/ true,
+                allow_lazy_decompression,
                 logger,
                 image_reservation,
                 error_msg);
@@ -690,6 +1129,7 @@ class ImageSpace::Loader {
                                           const char* image_location,
                                           const std::vector<std::string>& profile_files,
                                           bool allow_direct_mapping,
+                                          bool allow_lazy_decompression,
                                           TimingLogger* logger,
                                           /*inout*/MemMap* image_reservation,
                                           /*out*/std::string* error_msg)
@@ -749,6 +1189,7 @@ class ImageSpace::Loader {
     // avoid reading proc maps for a mapping failure and slowing everything down.
     // For the boot image, we have already reserved the memory and we load the image
     // into the `image_reservation`.
+    std::unique_ptr<LazyDecompressor> lazy_decompressor;
     MemMap map = LoadImageFile(
         image_filename,
         image_location,
@@ -757,6 +1198,7 @@ class ImageSpace::Loader {
         allow_direct_mapping,
         logger,
         image_reservation,
+        allow_lazy_decompression ? &lazy_decompressor : nullptr,
         error_msg);
     if (!map.IsValid()) {
       DCHECK(!error_msg->empty());
@@ -805,6 +1247,7 @@ class ImageSpace::Loader {
                                                      std::move(map),
                                                      std::move(bitmap),
                                                      image_end));
+    space->lazy_decompressor_ = std::move(lazy_decompressor);
     return space;
   }
 
@@ -985,6 +1428,14 @@ class ImageSpace::Loader {
     return true;
   }
 
+  static bool CanDecompressLazily(const ImageHeader& image_header) {
+    Runtime* runtime = Runtime::Current();
+    return runtime != nullptr &&
+           runtime->IsLazyAppImageDecompressionEnabled() &&
+           !runtime->GetHeap()->GetBootImageSpaces().empty() &&
+           image_header.GetBootImageBegin() == runtime->GetHeap()->GetBootImagesStartAddress();
+  }
+
   static MemMap LoadImageFile(const char* image_filename,
                               const char* image_location,
                               const ImageHeader& image_header,
@@ -992,6 +1443,7 @@ class ImageSpace::Loader {
                               bool allow_direct_mapping,
                               TimingLogger* logger,
                               /*inout*/MemMap* image_reservation,
+                              /*out*/std::unique_ptr<LazyDecompressor>* lazy_decompressor,
                               /*out*/std::string* error_msg)
         REQUIRES_SHARED(Locks::mutator_lock_) {
     TimingLogger::ScopedTiming timing("MapImageFile", logger);
@@ -1012,13 +1464,36 @@ class ImageSpace::Loader {
                                       error_msg);
     }
 
+    // Compressed images may be decompressed on first access to their pages instead. This only
+    // pays off if the image needs no relocation, which writes to every object, so the image must
+    // be mapped at its preferred address and the boot image at the address it was compiled for.
+    const bool try_lazy_decompression =
+        is_compressed && lazy_decompressor != nullptr && CanDecompressLazily(image_header);
+    MemMap map;
+    if (try_lazy_decompression) {
+      map = MemMap::MapAnonymous(image_location,
+                                 image_header.GetImageBegin(),
+                                 image_header.GetImageSize(),
+                                 PROT_READ | PROT_WRITE,
+                                 /*low_4gb=*/ true,
+                                 /*reuse=*/ false,
+                                 /*reservation=*/ nullptr,
+                                 &temp_error_msg);
+      if (!map.IsValid()) {
+        VLOG(image) << "Cannot map " << image_filename << " at its preferred address for lazy "
+                    << "decompression: " << temp_error_msg;
+      }
+    }
+
     // Reserve output and copy/decompress into it.
-    MemMap map = MemMap::MapAnonymous(image_location,
-                                      image_header.GetImageSize(),
-                                      PROT_READ | PROT_WRITE,
-                                      /*low_4gb=*/ true,
-                                      image_reservation,
-                                      error_msg);
+    if (!map.IsValid()) {
+      map = MemMap::MapAnonymous(image_location,
+                                 image_header.GetImageSize(),
+                                 PROT_READ | PROT_WRITE,
+                                 /*low_4gb=*/ true,
+                                 image_reservation,
+                                 error_msg);
+    }
     if (map.IsValid()) {
       const size_t stored_size = image_header.GetDataSize();
       MemMap temp_map = MemMap::MapFile(sizeof(ImageHeader) + stored_size,
@@ -1049,6 +1524,16 @@ class ImageSpace::Loader {
       if (is_compressed) {
         memcpy(map.Begin(), &image_header, sizeof(ImageHeader));
 
+        if (try_lazy_decompression && map.Begin() == image_header.GetImageBegin()) {
+          *lazy_decompressor =
+              LazyDecompressor::Create(image_filename, &map, &temp_map, &temp_error_msg);
+          if (*lazy_decompressor != nullptr) {
+            VLOG(image) << "Decompressing " << image_filename << " lazily";
+            return map;
+          }
+          VLOG(image) << "Cannot decompress " << image_filename << " lazily: " << temp_error_msg;
+        }
+
         Runtime::ScopedThreadPoolUsage stpu;
         ThreadPool* const pool = stpu.GetThreadPool();
         const uint64_t start = NanoTime();
@@ -1351,15 +1836,55 @@ class ImageSpace::Loader {
         }
       }
 
-      // Fixup objects may read fields in the boot image so we hold the mutator lock (although it is
-      // probably not required).
-      TimingLogger::ScopedTiming timing("Fixup objects", &logger);
+      // Objects, methods, fields and IMT and conflict tables do not depend on each other once
+      // classes are fixed up, so fix them up in parallel. Fixup objects may read fields in the
+      // boot image so we hold the mutator lock (although it is probably not required).
+      TimingLogger::ScopedTiming timing("Fixup objects and native structures", &logger);
       ScopedObjectAccess soa(Thread::Current());
+      ParallelRelocation parallel_relocation(image_header->GetImageSize());
       // Need to update the image to be at the target base.
       uintptr_t objects_begin = reinterpret_cast<uintptr_t>(target_base + objects_section.Offset());
       uintptr_t objects_end = reinterpret_cast<uintptr_t>(target_base + objects_section.End());
       FixupObjectVisitor<ForwardObject> fixup_object_visitor(&visited_bitmap, forward_object);
-      bitmap->VisitMarkedRange(objects_begin, objects_end, fixup_object_visitor);
+      parallel_relocation.AddObjectTasks(bitmap, objects_begin, objects_end, fixup_object_visitor);
+      // Only touches objects in the app image, no need for mutator lock.
+      parallel_relocation.AddTask([&]() NO_THREAD_SAFETY_ANALYSIS {
+        image_header->VisitPackedArtMethods([&](ArtMethod& method) NO_THREAD_SAFETY_ANALYSIS {
+          // TODO: Consider a separate visitor for runtime vs normal methods.
+          if (UNLIKELY(method.IsRuntimeMethod())) {
+            ImtConflictTable* table = method.GetImtConflictTable(kPointerSize);
+            if (table != nullptr) {
+              ImtConflictTable* new_table = forward_metadata(table);
+              if (table != new_table) {
+                method.SetImtConflictTable(new_table, kPointerSize);
+              }
+            }
+            const void* old_code = method.GetEntryPointFromQuickCompiledCodePtrSize(kPointerSize);
+            const void* new_code = forward_code(old_code);
+            if (old_code != new_code) {
+              method.SetEntryPointFromQuickCompiledCodePtrSize(new_code, kPointerSize);
+            }
+          } else {
+            patch_object_visitor.PatchGcRoot(&method.DeclaringClassRoot());
+            method.UpdateEntrypoints(forward_code, kPointerSize);
+          }
+        }, target_base, kPointerSize);
+      });
+      // Only touches objects in the app image, no need for mutator lock.
+      parallel_relocation.AddTask([&]() NO_THREAD_SAFETY_ANALYSIS {
+        image_header->VisitPackedArtFields([&](ArtField& field) NO_THREAD_SAFETY_ANALYSIS {
+          patch_object_visitor.template PatchGcRoot</*kMayBeNull=*/ false>(
+              &field.DeclaringClassRoot());
+        }, target_base);
+      });
+      parallel_relocation.AddTask([&]() {
+        image_header->VisitPackedImTables(forward_metadata, target_base, kPointerSize);
+      });
+      parallel_relocation.AddTask([&]() {
+        image_header->VisitPackedImtConflictTables(forward_metadata, target_base, kPointerSize);
+      });
+      parallel_relocation.Run();
+
       // Fixup image roots.
       CHECK(app_image_objects.InSource(reinterpret_cast<uintptr_t>(
           image_header->GetImageRoots<kWithoutReadBarrier>().Ptr())));
@@ -1367,57 +1892,19 @@ class ImageSpace::Loader {
       image_header->RelocateBootImageReferences(boot_image.Delta());
       CHECK_EQ(image_header->GetImageBegin(), target_base);
 
-      // Fix up dex cache arrays.
+      // Fix up dex cache arrays, which are independent of each other.
       ObjPtr<mirror::ObjectArray<mirror::DexCache>> dex_caches =
           image_header->GetImageRoot<kWithoutReadBarrier>(ImageHeader::kDexCaches)
               ->AsObjectArray<mirror::DexCache, kVerifyNone>();
       for (int32_t i = 0, count = dex_caches->GetLength(); i < count; ++i) {
-        ObjPtr<mirror::DexCache> dex_cache =
-            dex_caches->GetWithoutChecks<kVerifyNone, kWithoutReadBarrier>(i);
-        patch_object_visitor.VisitDexCacheArrays(dex_cache);
-      }
-    }
-    {
-      // Only touches objects in the app image, no need for mutator lock.
-      TimingLogger::ScopedTiming timing("Fixup methods", &logger);
-      image_header->VisitPackedArtMethods([&](ArtMethod& method) NO_THREAD_SAFETY_ANALYSIS {
-        // TODO: Consider a separate visitor for runtime vs normal methods.
-        if (UNLIKELY(method.IsRuntimeMethod())) {
-          ImtConflictTable* table = method.GetImtConflictTable(kPointerSize);
-          if (table != nullptr) {
-            ImtConflictTable* new_table = forward_metadata(table);
-            if (table != new_table) {
-              method.SetImtConflictTable(new_table, kPointerSize);
-            }
-          }
-          const void* old_code = method.GetEntryPointFromQuickCompiledCodePtrSize(kPointerSize);
-          const void* new_code = forward_code(old_code);
-          if (old_code != new_code) {
-            method.SetEntryPointFromQuickCompiledCodePtrSize(new_code, kPointerSize);
-          }
-        } else {
-          patch_object_visitor.PatchGcRoot(&method.DeclaringClassRoot());
-          method.UpdateEntrypoints(forward_code, kPointerSize);
-        }
-      }, target_base, kPointerSize);
-    }
-    if (fixup_image) {
-      {
-        // Only touches objects in the app image, no need for mutator lock.
-        TimingLogger::ScopedTiming timing("Fixup fields", &logger);
-        image_header->VisitPackedArtFields([&](ArtField& field) NO_THREAD_SAFETY_ANALYSIS {
-          patch_object_visitor.template PatchGcRoot</*kMayBeNull=*/ false>(
-              &field.DeclaringClassRoot());
-        }, target_base);
-      }
-      {
-        TimingLogger::ScopedTiming timing("Fixup imt", &logger);
-        image_header->VisitPackedImTables(forward_metadata, target_base, kPointerSize);
-      }
-      {
-        TimingLogger::ScopedTiming timing("Fixup conflict tables", &logger);
-        image_header->VisitPackedImtConflictTables(forward_metadata, target_base, kPointerSize);
+        mirror::DexCache* dex_cache =
+            dex_caches->GetWithoutChecks<kVerifyNone, kWithoutReadBarrier>(i).Ptr();
+        parallel_relocation.AddTask([&, dex_cache]() NO_THREAD_SAFETY_ANALYSIS {
+          patch_object_visitor.VisitDexCacheArrays(dex_cache);
+        });
       }
+      parallel_relocation.Run();
+
       // Fix up the intern table.
       const auto& intern_table_section = image_header->GetInternedStringsSection();
       if (intern_table_section.Size() > 0u) {
@@ -2566,50 +3053,79 @@ class ImageSpace::BootImageLoader {
       }
     }
 
+    // Tasks must not use `ObjPtr<>`s created on this thread, see `ParallelRelocation`.
+    mirror::Class* const class_class_ptr = class_class.Ptr();
+    mirror::Class* const method_class_ptr = method_class.Ptr();
+    mirror::Class* const constructor_class_ptr = constructor_class.Ptr();
+    mirror::Class* const field_var_handle_class_ptr = field_var_handle_class.Ptr();
+    mirror::Class* const static_field_var_handle_class_ptr = static_field_var_handle_class.Ptr();
+
+    // The native structures of each space do not depend on each other nor on the objects, so
+    // patch them in parallel with the class tables.
+    ParallelRelocation parallel_relocation(image_size);
     for (const std::unique_ptr<ImageSpace>& space : spaces) {
       // First patch the image header.
       reinterpret_cast<ImageHeader*>(space->Begin())->RelocateImageReferences(current_diff64);
       reinterpret_cast<ImageHeader*>(space->Begin())->RelocateBootImageReferences(base_diff64);
 
       // Patch fields and methods.
-      const ImageHeader& image_header = space->GetImageHeader();
-      image_header.VisitPackedArtFields([&](ArtField& field) REQUIRES_SHARED(Locks::mutator_lock_) {
-        // Fields always reference class in the current image.
-        simple_patch_object_visitor.template PatchGcRoot</*kMayBeNull=*/ false>(
-            &field.DeclaringClassRoot());
-      }, space->Begin());
-      image_header.VisitPackedArtMethods([&](ArtMethod& method)
-          REQUIRES_SHARED(Locks::mutator_lock_) {
-        main_patch_object_visitor.PatchGcRoot(&method.DeclaringClassRoot());
-        if (!method.HasCodeItem()) {
-          void** data_address = PointerAddress(&method, ArtMethod::DataOffset(kPointerSize));
-          main_patch_object_visitor.PatchNativePointer(data_address);
-        }
-        void** entrypoint_address =
-            PointerAddress(&method, ArtMethod::EntryPointFromQuickCompiledCodeOffset(kPointerSize));
-        main_patch_object_visitor.PatchNativePointer(entrypoint_address);
-      }, space->Begin(), kPointerSize);
-      auto method_table_visitor = [&](ArtMethod* method) {
-        DCHECK(method != nullptr);
-        return main_relocate_visitor(method);
-      };
-      image_header.VisitPackedImTables(method_table_visitor, space->Begin(), kPointerSize);
-      image_header.VisitPackedImtConflictTables(method_table_visitor, space->Begin(), kPointerSize);
+      ImageSpace* const image_space = space.get();
+      parallel_relocation.AddTask([&, image_space]() NO_THREAD_SAFETY_ANALYSIS {
+        image_space->GetImageHeader().VisitPackedArtFields([&](ArtField& field)
+            NO_THREAD_SAFETY_ANALYSIS {
+          // Fields always reference class in the current image.
+          simple_patch_object_visitor.template PatchGcRoot</*kMayBeNull=*/ false>(
+              &field.DeclaringClassRoot());
+        }, image_space->Begin());
+      });
+      parallel_relocation.AddTask([&, image_space]() NO_THREAD_SAFETY_ANALYSIS {
+        image_space->GetImageHeader().VisitPackedArtMethods([&](ArtMethod& method)
+            NO_THREAD_SAFETY_ANALYSIS {
+          main_patch_object_visitor.PatchGcRoot(&method.DeclaringClassRoot());
+          if (!method.HasCodeItem()) {
+            void** data_address = PointerAddress(&method, ArtMethod::DataOffset(kPointerSize));
+            main_patch_object_visitor.PatchNativePointer(data_address);
+          }
+          void** entrypoint_address = PointerAddress(
+              &method, ArtMethod::EntryPointFromQuickCompiledCodeOffset(kPointerSize));
+          main_patch_object_visitor.PatchNativePointer(entrypoint_address);
+        }, image_space->Begin(), kPointerSize);
+      });
+      parallel_relocation.AddTask([&, image_space]() {
+        const ImageHeader& image_header = image_space->GetImageHeader();
+        auto method_table_visitor = [&](ArtMethod* method) {
+          DCHECK(method != nullptr);
+          return main_relocate_visitor(method);
+        };
+        image_header.VisitPackedImTables(method_table_visitor, image_space->Begin(), kPointerSize);
+        image_header.VisitPackedImtConflictTables(
+            method_table_visitor, image_space->Begin(), kPointerSize);
+      });
 
       // Patch the intern table.
-      if (image_header.GetInternedStringsSection().Size() != 0u) {
-        const uint8_t* data = space->Begin() + image_header.GetInternedStringsSection().Offset();
-        size_t read_count;
-        InternTable::UnorderedSet temp_set(data, /*make_copy_of_data=*/ false, &read_count);
-        for (GcRoot<mirror::String>& slot : temp_set) {
-          // The intern table contains only strings in the current image.
-          simple_patch_object_visitor.template PatchGcRoot</*kMayBeNull=*/ false>(&slot);
-        }
+      if (space->GetImageHeader().GetInternedStringsSection().Size() != 0u) {
+        parallel_relocation.AddTask([&, image_space]() NO_THREAD_SAFETY_ANALYSIS {
+          const uint8_t* data = image_space->Begin() +
+              image_space->GetImageHeader().GetInternedStringsSection().Offset();
+          size_t read_count;
+          InternTable::UnorderedSet temp_set(data, /*make_copy_of_data=*/ false, &read_count);
+          for (GcRoot<mirror::String>& slot : temp_set) {
+            // The intern table contains only strings in the current image.
+            simple_patch_object_visitor.template PatchGcRoot</*kMayBeNull=*/ false>(&slot);
+          }
+        });
       }
+    }
 
-      // Patch the class table and classes, so that we can traverse class hierarchy to
-      // determine the types of other objects when we visit them later.
-      if (image_header.GetClassTableSection().Size() != 0u) {
+    // Patch the class table and classes, so that we can traverse class hierarchy to
+    // determine the types of other objects when we visit them later. This is the only
+    // task that marks `patched_objects`.
+    parallel_relocation.AddTask([&]() NO_THREAD_SAFETY_ANALYSIS {
+      for (const std::unique_ptr<ImageSpace>& space : spaces) {
+        const ImageHeader& image_header = space->GetImageHeader();
+        if (image_header.GetClassTableSection().Size() == 0u) {
+          continue;
+        }
         uint8_t* data = space->Begin() + image_header.GetClassTableSection().Offset();
         size_t read_count;
         ClassTable::ClassSet temp_set(data, /*make_copy_of_data=*/ false, &read_count);
@@ -2622,7 +3138,7 @@ class ImageSpace::BootImageLoader {
           DCHECK(klass != nullptr);
           DCHECK(!patched_objects->Test(klass.Ptr()));
           patched_objects->Set(klass.Ptr());
-          main_patch_object_visitor.VisitClass(klass, class_class);
+          main_patch_object_visitor.VisitClass(klass, class_class_ptr);
           // Then patch the non-embedded vtable and iftable.
           ObjPtr<mirror::PointerArray> vtable =
               klass->GetVTable<kVerifyNone, kWithoutReadBarrier>();
@@ -2649,42 +3165,49 @@ class ImageSpace::BootImageLoader {
           }
         }
       }
-    }
-
+    });
+    parallel_relocation.Run();
+
+    // Patch the remaining objects in chunks. This only tests `patched_objects`.
+    auto patch_object = [&](mirror::Object* object) NO_THREAD_SAFETY_ANALYSIS {
+      // Note: use Test() rather than Set() as this is the last time we're checking this object.
+      if (!patched_objects->Test(object)) {
+        // This is the last pass over objects, so we do not need to Set().
+        main_patch_object_visitor.VisitObject(object);
+        ObjPtr<mirror::Class> klass = object->GetClass<kVerifyNone, kWithoutReadBarrier>();
+        if (klass == method_class_ptr || klass == constructor_class_ptr) {
+          // Patch the ArtMethod* in the mirror::Executable subobject.
+          ObjPtr<mirror::Executable> as_executable =
+              ObjPtr<mirror::Executable>::DownCast(object);
+          ArtMethod* unpatched_method = as_executable->GetArtMethod<kVerifyNone>();
+          ArtMethod* patched_method = main_relocate_visitor(unpatched_method);
+          as_executable->SetArtMethod</*kTransactionActive=*/ false,
+                                      /*kCheckTransaction=*/ true,
+                                      kVerifyNone>(patched_method);
+        } else if (klass == field_var_handle_class_ptr ||
+                   klass == static_field_var_handle_class_ptr) {
+          // Patch the ArtField* in the mirror::FieldVarHandle subobject.
+          ObjPtr<mirror::FieldVarHandle> as_field_var_handle =
+              ObjPtr<mirror::FieldVarHandle>::DownCast(object);
+          ArtField* unpatched_field = as_field_var_handle->GetArtField<kVerifyNone>();
+          ArtField* patched_field = main_relocate_visitor(unpatched_field);
+          as_field_var_handle->SetArtField<kVerifyNone>(patched_field);
+        }
+      }
+    };
     for (const std::unique_ptr<ImageSpace>& space : spaces) {
       const ImageHeader& image_header = space->GetImageHeader();
 
       static_assert(IsAligned<kObjectAlignment>(sizeof(ImageHeader)), "Header alignment check");
       uint32_t objects_end = image_header.GetObjectsSection().Size();
       DCHECK_ALIGNED(objects_end, kObjectAlignment);
-      for (uint32_t pos = sizeof(ImageHeader); pos != objects_end; ) {
-        mirror::Object* object = reinterpret_cast<mirror::Object*>(space->Begin() + pos);
-        // Note: use Test() rather than Set() as this is the last time we're checking this object.
-        if (!patched_objects->Test(object)) {
-          // This is the last pass over objects, so we do not need to Set().
-          main_patch_object_visitor.VisitObject(object);
-          ObjPtr<mirror::Class> klass = object->GetClass<kVerifyNone, kWithoutReadBarrier>();
-          if (klass == method_class || klass == constructor_class) {
-            // Patch the ArtMethod* in the mirror::Executable subobject.
-            ObjPtr<mirror::Executable> as_executable =
-                ObjPtr<mirror::Executable>::DownCast(object);
-            ArtMethod* unpatched_method = as_executable->GetArtMethod<kVerifyNone>();
-            ArtMethod* patched_method = main_relocate_visitor(unpatched_method);
-            as_executable->SetArtMethod</*kTransactionActive=*/ false,
-                                        /*kCheckTransaction=*/ true,
-                                        kVerifyNone>(patched_method);
-          } else if (klass == field_var_handle_class || klass == static_field_var_handle_class) {
-            // Patch the ArtField* in the mirror::FieldVarHandle subobject.
-            ObjPtr<mirror::FieldVarHandle> as_field_var_handle =
-                ObjPtr<mirror::FieldVarHandle>::DownCast(object);
-            ArtField* unpatched_field = as_field_var_handle->GetArtField<kVerifyNone>();
-            ArtField* patched_field = main_relocate_visitor(unpatched_field);
-            as_field_var_handle->SetArtField<kVerifyNone>(patched_field);
-          }
-        }
-        pos += RoundUp(object->SizeOf<kVerifyNone>(), kObjectAlignment);
-      }
+      parallel_relocation.AddObjectTasks(
+          space->GetLiveBitmap(),
+          reinterpret_cast<uintptr_t>(space->Begin() + sizeof(ImageHeader)),
+          reinterpret_cast<uintptr_t>(space->Begin() + objects_end),
+          patch_object);
     }
+    parallel_relocation.Run();
     if (kIsDebugBuild && !kExtension) {
       // We used just Test() instead of Set() above but we need to use Set()
       // for class roots to satisfy a DCHECK() for extensions.
@@ -2796,6 +3319,7 @@ class ImageSpace::BootImageLoader {
                                                         image_location.c_str(),
                                                         profile_files,
                                                         /*allow_direct_mapping=*/ false,
+                                                        /*allow_lazy_decompression=*/ false,
                                                         logger,
                                                         image_reservation,
                                                         error_msg);
@@ -2824,6 +3348,7 @@ class ImageSpace::BootImageLoader {
     // file name.
     return Loader::Init(image_filename.c_str(),
                         image_location.c_str(),
+                        /*allow_lazy_decompression=*/ false,
                         logger,
                         image_reservation,
                         error_msg);
@@ -3775,6 +4300,12 @@ void ImageSpace::DumpSections(std::ostream& os) const {
   }
 }
 
+void ImageSpace::FinishLazyDecompression() {
+  if (lazy_decompressor_ != nullptr) {
+    lazy_decompressor_->Finish();
+  }
+}
+
 void ImageSpace::ReleaseMetadata() {
   const ImageSection& metadata = GetImageHeader().GetMetadataSection();
   VLOG(image) << "Releasing " << metadata.Size() << " image metadata bytes";
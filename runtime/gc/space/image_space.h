@@ -292,6 +292,25 @@ class ImageSpace : public MemMapSpace {
                               ArrayRef<const int> dex_fds,
                               const std::string& apex_versions);
 
+  // Enable or disable relocating images on several threads. Enabled by default.
+  //
+  // This function is exposed for testing purposes.
+  static void SetParallelRelocationEnabled(bool enabled) {
+    parallel_relocation_enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  // Decompress the remaining blocks of an app image that is decompressed on first access to its
+  // pages. A forked child process does not inherit the handler of these page faults, so this is
+  // done for all images by a pthread_atfork() handler before any fork().
+  void FinishLazyDecompression();
+
+  // Returns whether the blocks of the image are decompressed on first access to their pages.
+  //
+  // This function is exposed for testing purposes.
+  bool IsDecompressedLazily() const {
+    return lazy_decompressor_ != nullptr;
+  }
+
   // Return the end of the image which includes non-heap objects such as ArtMethods and ArtFields.
   uint8_t* GetImageEnd() const {
     return Begin() + GetImageHeader().GetImageSize();
@@ -495,6 +514,8 @@ class ImageSpace : public MemMapSpace {
 
   static Atomic<uint32_t> bitmap_index_;
 
+  static Atomic<bool> parallel_relocation_enabled_;
+
   accounting::ContinuousSpaceBitmap live_bitmap_;
 
   ImageSpace(const std::string& name,
@@ -530,6 +551,11 @@ class ImageSpace : public MemMapSpace {
   class PatchArtMethodVisitor;
   template <PointerSize kPointerSize, typename HeapVisitor, typename NativeVisitor>
   class PatchObjectVisitor;
+  class ParallelRelocation;
+  class LazyDecompressor;
+
+  // Decompresses the image on page faults, null if the image was decompressed when loaded.
+  std::unique_ptr<LazyDecompressor> lazy_decompressor_;
 
   DISALLOW_COPY_AND_ASSIGN(ImageSpace);
 };
@@ -14,17 +14,31 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include "android-base/logging.h"
 #include "android-base/stringprintf.h"
 #include "android-base/strings.h"
+#include "android-base/unique_fd.h"
 #include "base/globals.h"
+#include "base/iteration_range.h"
+#include "base/os.h"
 #include "base/stl_util.h"
+#include "base/time_utils.h"
 #include "class_linker.h"
+#include "class_root-inl.h"
 #include "dex/utf.h"
 #include "dexopt_test.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "image-inl.h"
 #include "intern_table-inl.h"
+#include "mirror/object_array-inl.h"
 #include "noop_compiler_callbacks.h"
 #include "oat_file.h"
 
@@ -224,6 +238,201 @@ TEST_F(ImageSpaceTest, StringDeduplication) {
   EXPECT_FALSE(contains_test_string(app_image_space.get()));
 }
 
+TEST_F(ImageSpaceTest, ParallelRelocation) {
+  // Prepare boot class path variables, exclude core-icu4j and conscrypt
+  // which are not in the primary boot image.
+  std::vector<std::string> bcp = GetLibCoreDexFileNames();
+  std::vector<std::string> bcp_locations = GetLibCoreDexLocations();
+  CHECK_EQ(bcp.size(), bcp_locations.size());
+  ASSERT_NE(std::string::npos, bcp.back().find("conscrypt"));
+  bcp.pop_back();
+  bcp_locations.pop_back();
+  ASSERT_NE(std::string::npos, bcp.back().find("core-icu4j"));
+  bcp.pop_back();
+  bcp_locations.pop_back();
+  std::vector<std::string> image_locations = {GetImageLocation()};
+
+  ScopedObjectAccess soa(Thread::Current());
+  auto relocate_boot_image = [&](bool parallel) REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::vector<std::unique_ptr<ImageSpace>> boot_image_spaces;
+    MemMap extra_reservation;
+    ImageSpace::SetParallelRelocationEnabled(parallel);
+    uint64_t start = NanoTime();
+    bool success = ImageSpace::LoadBootImage(bcp,
+                                             bcp_locations,
+                                             /*boot_class_path_fds=*/std::vector<int>(),
+                                             /*boot_class_path_image_fds=*/std::vector<int>(),
+                                             /*boot_class_path_vdex_fds=*/std::vector<int>(),
+                                             /*boot_class_path_oat_fds=*/std::vector<int>(),
+                                             image_locations,
+                                             kRuntimeISA,
+                                             /*relocate=*/true,
+                                             /*executable=*/true,
+                                             /*extra_reservation_size=*/0u,
+                                             /*allow_in_memory_compilation=*/false,
+                                             &boot_image_spaces,
+                                             &extra_reservation);
+    uint64_t time = NanoTime() - start;
+    ImageSpace::SetParallelRelocationEnabled(true);
+    EXPECT_TRUE(success);
+    EXPECT_FALSE(boot_image_spaces.empty());
+    for (const std::unique_ptr<ImageSpace>& space : boot_image_spaces) {
+      const ImageHeader& image_header = space->GetImageHeader();
+      EXPECT_EQ(image_header.GetImageBegin(), space->Begin());
+      // Class roots are patched by the class table pass and Class.class by the object pass.
+      ObjPtr<mirror::ObjectArray<mirror::Class>> class_roots =
+          image_header.GetImageRoot<kWithoutReadBarrier>(ImageHeader::kClassRoots)
+              ->AsObjectArray<mirror::Class, kVerifyNone>();
+      ObjPtr<mirror::Class> class_class =
+          GetClassRoot<mirror::Class, kWithoutReadBarrier>(class_roots);
+      EXPECT_TRUE(boot_image_spaces.front()->Contains(class_class.Ptr()));
+      EXPECT_EQ(class_class, (class_class->GetClass<kVerifyNone, kWithoutReadBarrier>()));
+    }
+    return time;
+  };
+
+  uint64_t serial_time = relocate_boot_image(/*parallel=*/ false);
+  uint64_t parallel_time = relocate_boot_image(/*parallel=*/ true);
+  double speedup = static_cast<double>(serial_time) / std::max<uint64_t>(parallel_time, 1u);
+  LOG(INFO) << "Boot image loading with relocation took " << PrettyDuration(serial_time)
+            << " with serial relocation and " << PrettyDuration(parallel_time)
+            << " with parallel relocation, speedup "
+            << android::base::StringPrintf("%.2f", speedup);
+}
+
+class ImageSpaceLazyDecompressionTest : public ImageSpaceTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) override {
+    ImageSpaceTest::SetUpRuntimeOptions(options);
+    options->emplace_back("-Xlazy-app-image-decompression:true", nullptr);
+  }
+
+  // Mirrors the userfaultfd creation in ImageSpace::LazyDecompressor.
+  static bool IsUserfaultfdAvailable() {
+#ifdef __NR_userfaultfd
+    int fd = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+#ifdef USERFAULTFD_IOC_NEW
+    if (fd == -1 && errno == EPERM) {
+      android::base::unique_fd dev_fd(open("/dev/userfaultfd", O_RDWR | O_CLOEXEC));
+      if (dev_fd.get() != -1) {
+        fd = ioctl(dev_fd.get(), USERFAULTFD_IOC_NEW, O_CLOEXEC | O_NONBLOCK);
+      } else {
+        errno = EPERM;
+      }
+    }
+#endif
+    if (fd == -1) {
+      return false;
+    }
+    close(fd);
+    return true;
+#else
+    return false;
+#endif
+  }
+};
+
+TEST_F(ImageSpaceLazyDecompressionTest, LoadAppImage) {
+  if (!IsUserfaultfdAvailable()) {
+    GTEST_SKIP() << "Userfaultfd is not available: " << strerror(errno);
+  }
+
+  // Compile an app image with LZ4 blocks of one page each.
+  ScratchDir scratch;
+  const std::string& scratch_dir = scratch.GetPath();
+  const char* app_base_name = "AllFields";
+  std::string app_jar_name = GetTestDexFileName(app_base_name);
+  std::string app_odex_name = scratch_dir + app_base_name + ".odex";
+  std::string app_image_name = scratch_dir + app_base_name + ".art";
+  {
+    ArrayRef<const std::string> dex_files(&app_jar_name, /*size=*/1u);
+    ScratchFile profile_file;
+    GenerateProfile(dex_files, profile_file.GetFile());
+    std::vector<std::string> argv;
+    std::string error_msg;
+    bool success = StartDex2OatCommandLine(&argv, &error_msg);
+    ASSERT_TRUE(success) << error_msg;
+    argv.insert(argv.end(),
+                {
+                    "--profile-file=" + profile_file.GetFilename(),
+                    "--dex-file=" + app_jar_name,
+                    "--dex-location=" + app_jar_name,
+                    "--oat-file=" + app_odex_name,
+                    "--app-image-file=" + app_image_name,
+                    "--image-format=lz4",
+                    "--max-image-block-size=" + std::to_string(kPageSize),
+                });
+    success = RunDex2Oat(argv, &error_msg);
+    ASSERT_TRUE(success) << error_msg;
+  }
+
+  // Decompress the image file eagerly for reference.
+  std::unique_ptr<File> image_file(OS::OpenFileForReading(app_image_name.c_str()));
+  ASSERT_TRUE(image_file != nullptr);
+  std::vector<uint8_t> image_data(image_file->GetLength());
+  ASSERT_TRUE(image_file->ReadFully(image_data.data(), image_data.size()));
+  const ImageHeader& file_header = *reinterpret_cast<const ImageHeader*>(image_data.data());
+  ASSERT_TRUE(file_header.HasCompressedBlock());
+  ArrayRef<const ImageHeader::Block> blocks(file_header.GetBlocks(image_data.data()).begin(),
+                                            file_header.GetBlockCount());
+  ASSERT_GE(blocks.size(), 4u);
+  std::vector<uint8_t> expected(file_header.GetImageSize());
+  std::string error_msg;
+  for (const ImageHeader::Block& block : blocks) {
+    bool success = block.Decompress(expected.data(), image_data.data(), &error_msg);
+    ASSERT_TRUE(success) << error_msg;
+  }
+
+  std::unique_ptr<OatFile> odex_file(OatFile::Open(/*zip_fd=*/-1,
+                                                   app_odex_name,
+                                                   app_odex_name,
+                                                   /*executable=*/false,
+                                                   /*low_4gb=*/false,
+                                                   app_jar_name,
+                                                   &error_msg));
+  ASSERT_TRUE(odex_file != nullptr) << error_msg;
+  ScopedObjectAccess soa(Thread::Current());
+  std::unique_ptr<ImageSpace> app_image_space =
+      ImageSpace::CreateFromAppImage(app_image_name.c_str(), odex_file.get(), &error_msg);
+  ASSERT_TRUE(app_image_space != nullptr) << error_msg;
+  if (!app_image_space->IsDecompressedLazily()) {
+    // Lazy decompression requires the image to be mapped at the address it was compiled for.
+    GTEST_SKIP() << "Cannot map " << app_image_name << " at its preferred address";
+  }
+  const ImageHeader& image_header = app_image_space->GetImageHeader();
+  uint8_t* const image_begin = app_image_space->Begin();
+  ASSERT_EQ(image_header.GetImageBegin(), image_begin);
+
+  // Touch the objects in reverse block order, so that each access faults on a different block.
+  const ImageSection& objects = image_header.GetObjectsSection();
+  size_t object_blocks = 0u;
+  for (const ImageHeader::Block& block : MakeIterationRange(blocks.rbegin(), blocks.rend())) {
+    uint32_t begin = std::max<uint32_t>(block.GetImageOffset(), objects.Offset());
+    uint32_t end = std::min(block.GetImageOffset() + block.GetImageSize(), objects.End());
+    if (begin < end) {
+      EXPECT_EQ(0, memcmp(image_begin + begin, expected.data() + begin, end - begin))
+          << "Block at offset " << block.GetImageOffset();
+      ++object_blocks;
+    }
+  }
+  EXPECT_GE(object_blocks, 2u);
+  size_t num_objects = 0u;
+  app_image_space->GetLiveBitmap()->VisitAllMarked([&](mirror::Object* obj)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    EXPECT_TRUE(obj->GetClass() != nullptr);
+    ++num_objects;
+  });
+  EXPECT_NE(num_objects, 0u);
+
+  // Decompress the remaining blocks and compare everything up to the metadata, which the image
+  // space may release.
+  app_image_space->FinishLazyDecompression();
+  const uint32_t compared_end = image_header.GetMetadataSection().Offset();
+  EXPECT_EQ(0, memcmp(image_begin + objects.Offset(),
+                      expected.data() + objects.Offset(),
+                      compared_end - objects.Offset()));
+}
+
 TEST_F(DexoptTest, ValidateOatFile) {
   std::string dex1 = GetScratchDir() + "/Dex1.jar";
   std::string multidex1 = GetScratchDir() + "/MultiDex1.jar";
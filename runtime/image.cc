@@ -196,13 +196,13 @@ bool LZ4_decompress_safe_checked(const char* source,
   }
 }
 
-bool ImageHeader::Block::Decompress(uint8_t* out_ptr,
-                                    const uint8_t* in_ptr,
-                                    std::string* error_msg) const {
+bool ImageHeader::Block::DecompressTo(uint8_t* out,
+                                      const uint8_t* in_ptr,
+                                      std::string* error_msg) const {
   switch (storage_mode_) {
     case kStorageModeUncompressed: {
       CHECK_EQ(image_size_, data_size_);
-      memcpy(out_ptr + image_offset_, in_ptr + data_offset_, data_size_);
+      memcpy(out, in_ptr + data_offset_, data_size_);
       break;
     }
     case kStorageModeLZ4:
@@ -211,7 +211,7 @@ bool ImageHeader::Block::Decompress(uint8_t* out_ptr,
       size_t decompressed_size;
       bool ok = LZ4_decompress_safe_checked(
           reinterpret_cast<const char*>(in_ptr) + data_offset_,
-          reinterpret_cast<char*>(out_ptr) + image_offset_,
+          reinterpret_cast<char*>(out),
           data_size_,
           image_size_,
           &decompressed_size,
@@ -327,10 +327,13 @@ bool ImageHeader::WriteData(const ImageFileGuard& image_file,
   dchecked_vector<ImageHeader::Block> blocks;
 
   // Add a set of solid blocks such that no block is larger than the maximum size. A solid block
-  // is a block that must be decompressed all at once.
+  // is a block that must be decompressed all at once. Blocks end at multiples of the maximum
+  // size, so that a maximum size that is a multiple of the page size yields blocks that cover
+  // whole pages and can be decompressed independently on first access.
   auto add_blocks = [&](uint32_t offset, uint32_t size) {
     while (size != 0u) {
-      const uint32_t cur_size = std::min(size, max_image_block_size);
+      const uint32_t cur_size =
+          std::min(size, max_image_block_size - offset % max_image_block_size);
       block_sources.emplace_back(offset, cur_size);
       offset += cur_size;
       size -= cur_size;
@@ -100,12 +100,23 @@ class PACKED(8) ImageHeader {
           image_offset_(image_offset),
           image_size_(image_size) {}
 
-    bool Decompress(uint8_t* out_ptr, const uint8_t* in_ptr, std::string* error_msg) const;
+    // Decompress the block to `out_ptr + GetImageOffset()`, reading from the image file data
+    // at `in_ptr`.
+    bool Decompress(uint8_t* out_ptr, const uint8_t* in_ptr, std::string* error_msg) const {
+      return DecompressTo(out_ptr + image_offset_, in_ptr, error_msg);
+    }
+
+    // Decompress the block to `out`, which must have room for `GetImageSize()` bytes.
+    bool DecompressTo(uint8_t* out, const uint8_t* in_ptr, std::string* error_msg) const;
 
     StorageMode GetStorageMode() const {
       return storage_mode_;
     }
 
+    uint32_t GetImageOffset() const {
+      return image_offset_;
+    }
+
     uint32_t GetDataSize() const {
       return data_size_;
     }
@@ -139,6 +139,7 @@ inline void InternTable::Table::AddInternStrings(UnorderedSet&& intern_strings,
   // the number of searched frozen tables and not search them again.
   DCHECK(!tables_.empty());
   tables_.insert(tables_.end() - 1, InternalTable(std::move(intern_strings), is_boot_image));
+  PublishSnapshot();
 }
 
 template <typename Visitor>
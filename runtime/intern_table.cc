@@ -18,6 +18,7 @@
 
 #include <memory>
 
+#include "barrier.h"
 #include "dex/utf.h"
 #include "gc/collector/garbage_collector.h"
 #include "gc/space/image_space.h"
@@ -33,12 +34,16 @@
 #include "scoped_thread_state_change-inl.h"
 #include "thread.h"
 #include "thread-inl.h"
+#include "thread_list.h"
+#include "thread_pool.h"
 
 namespace art {
 
 InternTable::InternTable()
     : log_new_roots_(false),
       weak_intern_condition_("New intern condition", *Locks::intern_table_lock_),
+      strong_interns_(/*allow_concurrent_lookups=*/ true),
+      weak_interns_(/*allow_concurrent_lookups=*/ false),
       weak_root_state_(gc::kWeakRootStateNormal) {
 }
 
@@ -114,6 +119,10 @@ ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self, ObjPtr<mirror::St
   DCHECK(s != nullptr);
   // `String::GetHashCode()` ensures that the stored hash is calculated.
   uint32_t hash = static_cast<uint32_t>(s->GetHashCode());
+  ObjPtr<mirror::String> result = strong_interns_.FindConcurrent(GcRoot<mirror::String>(s), hash);
+  if (result != nullptr) {
+    return result;
+  }
   MutexLock mu(self, *Locks::intern_table_lock_);
   return strong_interns_.Find(s, hash);
 }
@@ -122,8 +131,13 @@ ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self,
                                                  uint32_t utf16_length,
                                                  const char* utf8_data) {
   uint32_t hash = Utf8String::Hash(utf16_length, utf8_data);
+  Utf8String string(utf16_length, utf8_data);
+  ObjPtr<mirror::String> result = strong_interns_.FindConcurrent(string, hash);
+  if (result != nullptr) {
+    return result;
+  }
   MutexLock mu(self, *Locks::intern_table_lock_);
-  return strong_interns_.Find(Utf8String(utf16_length, utf8_data), hash);
+  return strong_interns_.Find(string, hash);
 }
 
 ObjPtr<mirror::String> InternTable::LookupWeakLocked(ObjPtr<mirror::String> s) {
@@ -179,6 +193,30 @@ void InternTable::RemoveWeak(ObjPtr<mirror::String> s, uint32_t hash) {
   weak_interns_.Remove(s, hash);
 }
 
+void InternTable::ReclaimRetiredStorage(Thread* self) {
+  std::vector<UnorderedSet> sets;
+  std::vector<std::unique_ptr<Table::Snapshot>> snapshots;
+  {
+    MutexLock mu(self, *Locks::intern_table_lock_);
+    strong_interns_.TakeRetiredStorage(&sets, &snapshots);
+  }
+  if (sets.empty() && snapshots.empty()) {
+    return;  // Another thread took the storage.
+  }
+  // Concurrent lookups do not have suspend points, so once every thread has passed a checkpoint,
+  // no lookup can still be using the storage retired before we requested it.
+  Barrier barrier(0);
+  FunctionClosure closure([&barrier](Thread* thread ATTRIBUTE_UNUSED) {
+    barrier.Pass(Thread::Current());
+  });
+  size_t threads_running_checkpoint = Runtime::Current()->GetThreadList()->RunCheckpoint(&closure);
+  ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+  if (threads_running_checkpoint != 0) {
+    barrier.Increment(self, threads_running_checkpoint);
+  }
+  // The storage is freed when `sets` and `snapshots` go out of scope.
+}
+
 void InternTable::BroadcastForNewInterns() {
   Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::intern_table_lock_);
@@ -206,7 +244,25 @@ ObjPtr<mirror::String> InternTable::Insert(ObjPtr<mirror::String> s,
   DCHECK_EQ(hash, static_cast<uint32_t>(s->GetStoredHashCode()));
   DCHECK_IMPLIES(hash == 0u, s->ComputeHashCode() == 0);
   Thread* const self = Thread::Current();
-  MutexLock mu(self, *Locks::intern_table_lock_);
+  bool has_retired_storage;
+  {
+    MutexLock mu(self, *Locks::intern_table_lock_);
+    s = InsertLocked(self, s, hash, is_strong, num_searched_strong_frozen_tables);
+    has_retired_storage = strong_interns_.HasRetiredStorage();
+  }
+  if (UNLIKELY(has_retired_storage)) {
+    StackHandleScope<1> hs(self);
+    auto h = hs.NewHandleWrapper(&s);
+    ReclaimRetiredStorage(self);
+  }
+  return s;
+}
+
+ObjPtr<mirror::String> InternTable::InsertLocked(Thread* self,
+                                                 ObjPtr<mirror::String> s,
+                                                 uint32_t hash,
+                                                 bool is_strong,
+                                                 size_t num_searched_strong_frozen_tables) {
   if (kDebugLocking) {
     Locks::mutator_lock_->AssertSharedHeld(self);
     CHECK_EQ(2u, self->NumberOfHeldMutexes()) << "may only safely hold the mutator lock";
@@ -253,15 +309,10 @@ ObjPtr<mirror::String> InternTable::InternStrong(uint32_t utf16_length, const ch
   DCHECK(utf8_data != nullptr);
   uint32_t hash = Utf8String::Hash(utf16_length, utf8_data);
   Thread* self = Thread::Current();
-  ObjPtr<mirror::String> s;
+  // Try to avoid allocation. A miss here is rechecked with the lock held by `Insert()`.
   size_t num_searched_strong_frozen_tables;
-  {
-    // Try to avoid allocation. If we need to allocate, release the mutex before the allocation.
-    MutexLock mu(self, *Locks::intern_table_lock_);
-    DCHECK(!strong_interns_.tables_.empty());
-    num_searched_strong_frozen_tables = strong_interns_.tables_.size() - 1u;
-    s = strong_interns_.Find(Utf8String(utf16_length, utf8_data), hash);
-  }
+  ObjPtr<mirror::String> s = strong_interns_.FindConcurrent(
+      Utf8String(utf16_length, utf8_data), hash, &num_searched_strong_frozen_tables);
   if (s != nullptr) {
     return s;
   }
@@ -292,7 +343,13 @@ ObjPtr<mirror::String> InternTable::InternStrong(ObjPtr<mirror::String> s) {
   DCHECK(s != nullptr);
   // `String::GetHashCode()` ensures that the stored hash is calculated.
   uint32_t hash = static_cast<uint32_t>(s->GetHashCode());
-  return Insert(s, hash, /*is_strong=*/ true);
+  size_t num_searched_strong_frozen_tables;
+  ObjPtr<mirror::String> strong = strong_interns_.FindConcurrent(
+      GcRoot<mirror::String>(s), hash, &num_searched_strong_frozen_tables);
+  if (strong != nullptr) {
+    return strong;
+  }
+  return Insert(s, hash, /*is_strong=*/ true, num_searched_strong_frozen_tables);
 }
 
 ObjPtr<mirror::String> InternTable::InternWeak(const char* utf8_data) {
@@ -310,7 +367,13 @@ ObjPtr<mirror::String> InternTable::InternWeak(ObjPtr<mirror::String> s) {
   DCHECK(s != nullptr);
   // `String::GetHashCode()` ensures that the stored hash is calculated.
   uint32_t hash = static_cast<uint32_t>(s->GetHashCode());
-  return Insert(s, hash, /*is_strong=*/ false);
+  size_t num_searched_strong_frozen_tables;
+  ObjPtr<mirror::String> strong = strong_interns_.FindConcurrent(
+      GcRoot<mirror::String>(s), hash, &num_searched_strong_frozen_tables);
+  if (strong != nullptr) {
+    return strong;
+  }
+  return Insert(s, hash, /*is_strong=*/ false, num_searched_strong_frozen_tables);
 }
 
 void InternTable::SweepInternTableWeaks(IsMarkedVisitor* visitor) {
@@ -365,6 +428,60 @@ ObjPtr<mirror::String> InternTable::Table::Find(const Utf8String& string, uint32
   return nullptr;
 }
 
+template <typename Key>
+ObjPtr<mirror::String> InternTable::Table::FindConcurrent(const Key& key,
+                                                          uint32_t hash,
+                                                          size_t* num_searched_frozen_tables) {
+  DCHECK(allow_concurrent_lookups_);
+  const Snapshot* snapshot = snapshot_.load(std::memory_order_acquire);
+  DCHECK(!snapshot->tables.empty());
+  if (num_searched_frozen_tables != nullptr) {
+    *num_searched_frozen_tables = snapshot->tables.size() - 1u;
+  }
+  StringEquals equals;
+  // Search from the last table like `Find()`. The probing matches `HashSet<>`. Entries can be
+  // written concurrently, so read them atomically. A string seen in an entry is fully
+  // initialized, see `Insert()`.
+  for (const Snapshot::Buckets& buckets : ReverseRange(snapshot->tables)) {
+    if (buckets.size == 0u) {
+      continue;
+    }
+    auto* data = reinterpret_cast<const std::atomic<GcRoot<mirror::String>>*>(buckets.data);
+    for (size_t index = hash % buckets.size; ; index = (index + 1u) % buckets.size) {
+      GcRoot<mirror::String> root = data[index].load(std::memory_order_relaxed);
+      if (root.IsNull()) {
+        break;
+      }
+      if (equals(root, key)) {
+        return root.Read();
+      }
+    }
+  }
+  return nullptr;
+}
+
+void InternTable::Table::TakeRetiredStorage(
+    /*out*/ std::vector<UnorderedSet>* sets,
+    /*out*/ std::vector<std::unique_ptr<Snapshot>>* snapshots) {
+  sets->swap(retired_sets_);
+  snapshots->swap(retired_snapshots_);
+}
+
+void InternTable::Table::PublishSnapshot() {
+  if (!allow_concurrent_lookups_) {
+    return;
+  }
+  std::unique_ptr<Snapshot> snapshot(new Snapshot());
+  snapshot->tables.reserve(tables_.size());
+  for (const InternalTable& table : tables_) {
+    snapshot->tables.push_back({table.set_.GetBuckets(), table.set_.NumBuckets()});
+  }
+  Snapshot* old_snapshot = snapshot_.exchange(snapshot.release(), std::memory_order_release);
+  if (old_snapshot != nullptr) {
+    retired_snapshots_.emplace_back(old_snapshot);
+  }
+}
+
 void InternTable::Table::AddNewTable() {
   // Propagate the min/max load factor from the old active set.
   DCHECK(!tables_.empty());
@@ -372,13 +489,32 @@ void InternTable::Table::AddNewTable() {
   InternalTable new_table;
   new_table.set_.SetLoadFactor(last_set.GetMinLoadFactor(), last_set.GetMaxLoadFactor());
   tables_.push_back(std::move(new_table));
+  PublishSnapshot();
 }
 
 void InternTable::Table::Insert(ObjPtr<mirror::String> s, uint32_t hash) {
   // Always insert the last table, the image tables are before and we avoid inserting into these
   // to prevent dirty pages.
   DCHECK(!tables_.empty());
-  tables_.back().set_.PutWithHash(GcRoot<mirror::String>(s), hash);
+  UnorderedSet& set = tables_.back().set_;
+  if (!allow_concurrent_lookups_) {
+    set.PutWithHash(GcRoot<mirror::String>(s), hash);
+    return;
+  }
+  if (set.size() >= set.ElementsUntilExpand()) {
+    // The set would be resized and its buckets freed while concurrent lookups may be using them.
+    // Grow a copy instead and retire the old buckets until `ReclaimRetiredStorage()`.
+    UnorderedSet new_set(set);
+    new_set.PutWithHash(GcRoot<mirror::String>(s), hash);
+    set.swap(new_set);
+    retired_sets_.push_back(std::move(new_set));
+    PublishSnapshot();
+  } else {
+    // Make sure that concurrent lookups that see the new entry also see the string's contents
+    // and hash code.
+    std::atomic_thread_fence(std::memory_order_release);
+    set.PutWithHash(GcRoot<mirror::String>(s), hash);
+  }
 }
 
 void InternTable::Table::VisitRoots(RootVisitor* visitor) {
@@ -436,12 +572,20 @@ void InternTable::ChangeWeakRootStateLocked(gc::WeakRootState new_state) {
   }
 }
 
-InternTable::Table::Table() {
+InternTable::Table::Table(bool allow_concurrent_lookups)
+    : allow_concurrent_lookups_(allow_concurrent_lookups), snapshot_(nullptr) {
   Runtime* const runtime = Runtime::Current();
   InternalTable initial_table;
   initial_table.set_.SetLoadFactor(runtime->GetHashTableMinLoadFactor(),
                                    runtime->GetHashTableMaxLoadFactor());
   tables_.push_back(std::move(initial_table));
+  // No other thread can see this table yet.
+  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
+  PublishSnapshot();
+}
+
+InternTable::Table::~Table() {
+  delete snapshot_.load(std::memory_order_relaxed);
 }
 
 }  // namespace art
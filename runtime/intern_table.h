@@ -17,6 +17,10 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "base/allocator.h"
 #include "base/dchecked_vector.h"
 #include "base/hash_set.h"
@@ -235,7 +239,20 @@ class InternTable {
       ART_FRIEND_TEST(InternTableTest, CrossHash);
     };
 
-    Table();
+    // The bucket arrays of `tables_`, published for `FindConcurrent()`. A new snapshot replaces
+    // the old one whenever a bucket array is replaced or a table is added.
+    struct Snapshot {
+      struct Buckets {
+        const GcRoot<mirror::String>* data;
+        size_t size;
+      };
+      dchecked_vector<Buckets> tables;
+    };
+
+    // With `allow_concurrent_lookups`, `FindConcurrent()` can be used without holding the lock.
+    explicit Table(bool allow_concurrent_lookups);
+    ~Table();
+
     ObjPtr<mirror::String> Find(ObjPtr<mirror::String> s,
                                 uint32_t hash,
                                 size_t num_searched_frozen_tables = 0u)
@@ -253,6 +270,28 @@ class InternTable {
     // Add a new intern table that will only be inserted into from now on.
     void AddNewTable() REQUIRES(Locks::intern_table_lock_);
     size_t Size() const REQUIRES(Locks::intern_table_lock_);
+
+    // Lookups without holding the lock. A string inserted concurrently may or may not be found.
+    // Strings are never missed otherwise, except while a concurrent removal (only done for
+    // transaction rollback) moves other strings around, so callers that do not insert the string
+    // afterwards must confirm a miss with the lock held.
+    template <typename Key>
+    ObjPtr<mirror::String> FindConcurrent(const Key& key,
+                                          uint32_t hash,
+                                          /*out*/ size_t* num_searched_frozen_tables = nullptr)
+        REQUIRES_SHARED(Locks::mutator_lock_);
+
+    // Whether there is storage replaced since the last `TakeRetiredStorage()`.
+    bool HasRetiredStorage() const REQUIRES(Locks::intern_table_lock_) {
+      return !retired_sets_.empty() || !retired_snapshots_.empty();
+    }
+
+    // Move the replaced storage to `sets` and `snapshots`, to be freed once concurrent lookups
+    // cannot use it anymore.
+    void TakeRetiredStorage(/*out*/ std::vector<UnorderedSet>* sets,
+                            /*out*/ std::vector<std::unique_ptr<Snapshot>>* snapshots)
+        REQUIRES(Locks::intern_table_lock_);
+
     // Read and add an intern table from ptr.
     // Tables read are inserted at the front of the table array. Only checks for conflicts in
     // debug builds. Returns how many bytes were read.
@@ -262,6 +301,9 @@ class InternTable {
         REQUIRES(!Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
    private:
+    // Publish a new `Snapshot` of the current `tables_`, if concurrent lookups are allowed.
+    void PublishSnapshot() REQUIRES(Locks::intern_table_lock_);
+
     void SweepWeaks(UnorderedSet* set, IsMarkedVisitor* visitor)
         REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
 
@@ -273,6 +315,13 @@ class InternTable {
     // modifying the zygote intern table. The back of table is modified when strings are interned.
     dchecked_vector<InternalTable> tables_;
 
+    const bool allow_concurrent_lookups_;
+    std::atomic<Snapshot*> snapshot_;
+    // Sets and snapshots that have been replaced but may still be in use by concurrent lookups.
+    // Sets that grow are copied instead of resized in place, so that the old buckets stay valid.
+    std::vector<UnorderedSet> retired_sets_;
+    std::vector<std::unique_ptr<Snapshot>> retired_snapshots_;
+
     friend class InternTable;
     friend class linker::ImageWriter;
     ART_FRIEND_TEST(InternTableTest, CrossHash);
@@ -284,6 +333,12 @@ class InternTable {
                                 bool is_strong,
                                 size_t num_searched_strong_frozen_tables = 0u)
       REQUIRES(!Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+  ObjPtr<mirror::String> InsertLocked(Thread* self,
+                                      ObjPtr<mirror::String> s,
+                                      uint32_t hash,
+                                      bool is_strong,
+                                      size_t num_searched_strong_frozen_tables)
+      REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Add a table from memory to the strong interns.
   template <typename Visitor>
@@ -304,6 +359,11 @@ class InternTable {
   void ChangeWeakRootStateLocked(gc::WeakRootState new_state)
       REQUIRES(Locks::intern_table_lock_);
 
+  // Free the storage replaced in `strong_interns_` once no concurrent lookup can use it anymore.
+  // May cause thread suspension.
+  void ReclaimRetiredStorage(Thread* self)
+      REQUIRES(!Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Wait until we can read weak roots.
   void WaitUntilAccessible(Thread* self)
       REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
@@ -314,7 +374,9 @@ class InternTable {
   // enable concurrent intern table (strong) root scan. Do not
   // directly access the strings in it. Use functions that contain
   // read barriers.
-  Table strong_interns_ GUARDED_BY(Locks::intern_table_lock_);
+  // Not GUARDED_BY(Locks::intern_table_lock_) as `Table::FindConcurrent()` does not need the
+  // lock. All other `Table` functions require it.
+  Table strong_interns_;
   dchecked_vector<GcRoot<mirror::String>> new_strong_intern_roots_
       GUARDED_BY(Locks::intern_table_lock_);
   // Since this contains (weak) roots, they need a read barrier. Do
@@ -16,7 +16,12 @@
 
 #include "intern_table-inl.h"
 
+#include <algorithm>
+#include <atomic>
+
+#include "android-base/stringprintf.h"
 #include "base/hash_set.h"
+#include "base/time_utils.h"
 #include "common_runtime_test.h"
 #include "dex/utf.h"
 #include "gc_root-inl.h"
@@ -24,6 +29,7 @@
 #include "mirror/object.h"
 #include "mirror/string.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -263,4 +269,62 @@ TEST_F(InternTableTest, InternStrongFrozenWeak) {
   ASSERT_TRUE(strong_foo == foo.Get());
 }
 
+// Many threads interning the same strings, as during app startup. The first round inserts the
+// strings, so the table grows while other threads look them up; later rounds only find them.
+TEST_F(InternTableTest, ConcurrentInternBenchmark) {
+  static constexpr size_t kNumStrings = 4096;
+  static constexpr size_t kRounds = 32;
+  static constexpr size_t kMaxThreads = 8;
+  Thread* self = Thread::Current();
+  // Use the runtime's table, which is visited by the GC, as the threads allocate strings.
+  InternTable* intern_table = Runtime::Current()->GetInternTable();
+  for (size_t num_threads = 1; num_threads <= kMaxThreads; num_threads *= 2) {
+    std::vector<std::string> strings;
+    strings.reserve(kNumStrings);
+    for (size_t i = 0; i != kNumStrings; ++i) {
+      strings.push_back(android::base::StringPrintf("intern benchmark %zu %zu", num_threads, i));
+    }
+    const size_t size_before = intern_table->StrongSize();
+    std::atomic<size_t> failures(0u);
+    ThreadPool thread_pool("Intern benchmark thread pool", num_threads);
+    for (size_t t = 0; t != num_threads; ++t) {
+      thread_pool.AddTask(self, new FunctionTask([&, t](Thread* worker) {
+        ScopedObjectAccess soa(worker);
+        for (size_t round = 0; round != kRounds; ++round) {
+          // Start at different strings in each thread.
+          for (size_t j = 0; j != kNumStrings; ++j) {
+            const std::string& string = strings[(j + t * kNumStrings / num_threads) % kNumStrings];
+            ObjPtr<mirror::String> interned =
+                intern_table->InternStrong(string.length(), string.c_str());
+            if (interned == nullptr || !interned->Equals(string.c_str())) {
+              failures.fetch_add(1u, std::memory_order_relaxed);
+            }
+          }
+        }
+      }));
+    }
+    const uint64_t start_ns = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, /*do_work=*/ false, /*may_hold_locks=*/ false);
+    const uint64_t duration_ns = std::max<uint64_t>(NanoTime() - start_ns, 1u);
+    EXPECT_EQ(0u, failures.load());
+    // Each string was inserted exactly once.
+    EXPECT_EQ(size_before + kNumStrings, intern_table->StrongSize());
+    {
+      ScopedObjectAccess soa(self);
+      for (const std::string& string : strings) {
+        ObjPtr<mirror::String> interned =
+            intern_table->InternStrong(string.length(), string.c_str());
+        ASSERT_TRUE(interned != nullptr);
+        EXPECT_OBJ_PTR_EQ(interned,
+                          intern_table->LookupStrong(self, string.length(), string.c_str()));
+      }
+    }
+    const uint64_t num_interns = num_threads * kRounds * kNumStrings;
+    LOG(INFO) << "Intern benchmark: " << num_threads << " threads, " << num_interns
+              << " interns in " << PrettyDuration(duration_ns) << ", "
+              << num_interns * UINT64_C(1000) / duration_ns << " interns/us";
+  }
+}
+
 }  // namespace art
@@ -18,6 +18,8 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
+
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "base/file_utils.h"
@@ -38,6 +40,7 @@
 #include "interpreter/interpreter.h"
 #include "jit-inl.h"
 #include "jit_code_cache.h"
+#include "jit_warm_start_file.h"
 #include "jni/java_vm_ext.h"
 #include "mirror/method_handle_impl.h"
 #include "mirror/var_handle.h"
@@ -78,6 +81,9 @@ static constexpr uint32_t kJitStressDefaultWarmupThreshold = kJitDefaultWarmupTh
 static constexpr uint32_t kJitSlowStressDefaultWarmupThreshold =
     kJitStressDefaultWarmupThreshold / 2;
 
+// Number of optimized compilations after which the warm start files are first written.
+static constexpr uint32_t kFirstWarmStartWrite = 16;
+
 DEFINE_RUNTIME_DEBUG_FLAG(Jit, kSlowMode);
 
 // JIT compiler
@@ -90,6 +96,8 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
   jit_options->use_jit_compilation_ = options.GetOrDefault(RuntimeArgumentMap::UseJitCompilation);
   jit_options->use_profiled_jit_compilation_ =
       options.GetOrDefault(RuntimeArgumentMap::UseProfiledJitCompilation);
+  jit_options->use_warm_start_file_ =
+      options.GetOrDefault(RuntimeArgumentMap::UseJitWarmStartFile);
 
   jit_options->code_cache_initial_capacity_ =
       options.GetOrDefault(RuntimeArgumentMap::JITCodeCacheInitialCapacity);
@@ -179,13 +187,18 @@ void Jit::AddTimingLogger(const TimingLogger& logger) {
 Jit::Jit(JitCodeCache* code_cache, JitOptions* options)
     : code_cache_(code_cache),
       options_(options),
+      compile_queue_lock_("Jit::compile_queue_lock_"),
+      compile_queue_sequence_number_(0u),
       boot_completed_lock_("Jit::boot_completed_lock_"),
       cumulative_timings_("JIT timings"),
       memory_use_("Memory used for compilation", 16),
       lock_("JIT memory use lock"),
       zygote_mapping_methods_(),
       fd_methods_(-1),
-      fd_methods_size_(0) {}
+      fd_methods_size_(0),
+      warm_start_lock_("Jit::warm_start_lock_"),
+      optimized_compilations_(0u),
+      next_warm_start_write_(kFirstWarmStartWrite) {}
 
 Jit* Jit::Create(JitCodeCache* code_cache, JitOptions* options) {
   if (jit_load_ == nullptr) {
@@ -330,6 +343,8 @@ bool Jit::CompileMethodInternal(ArtMethod* method,
     VLOG(jit) << "Failed to compile method "
               << ArtMethod::PrettyMethod(method_to_compile)
               << " kind=" << compilation_kind;
+  } else if (compilation_kind == CompilationKind::kOptimized && options_->UseWarmStartFile()) {
+    MaybeScheduleWarmStartFilesWrite(self);
   }
   if (kIsDebugBuild) {
     if (self->IsExceptionPending()) {
@@ -364,11 +379,22 @@ void Jit::DeleteThreadPool() {
     if (!kRunningOnMemoryTool) {
       pool->StopWorkers(self);
       pool->RemoveAllTasks(self);
+      ClearCompileQueue(self);
     }
     // We could just suspend all threads, but we know those threads
     // will finish in a short period, so it's not worth adding a suspend logic
     // here. Besides, this is only done for shutdown.
     pool->Wait(self, false, false);
+
+    // No task can use the warm start entries anymore, release their class loaders.
+    std::vector<WarmStartDexFiles> entries;
+    {
+      MutexLock mu(self, warm_start_lock_);
+      entries.swap(warm_start_dex_files_);
+    }
+    for (const WarmStartDexFiles& entry : entries) {
+      Runtime::Current()->GetJavaVM()->DeleteWeakGlobalRef(self, entry.class_loader);
+    }
   }
 }
 
@@ -835,15 +861,67 @@ class JitCompileTask final : public Task {
     delete this;
   }
 
+  ArtMethod* GetMethod() const {
+    return method_;
+  }
+
+  CompilationKind GetCompilationKind() const {
+    return compilation_kind_;
+  }
+
+  // Position of the task in the compile queue of the Jit, see Jit::CompileTaskOrder. The
+  // hotness is the number of requests for the compilation.
+  uint32_t GetHotness() const {
+    return hotness_;
+  }
+
+  uint64_t GetSequenceNumber() const {
+    return sequence_number_;
+  }
+
+  uint64_t GetEnqueueTimeNs() const {
+    return enqueue_time_ns_;
+  }
+
+  void SetQueuePosition(uint32_t hotness, uint64_t sequence_number, uint64_t enqueue_time_ns) {
+    hotness_ = hotness;
+    sequence_number_ = sequence_number;
+    enqueue_time_ns_ = enqueue_time_ns;
+  }
+
+  void IncrementHotness() {
+    if (hotness_ != std::numeric_limits<uint32_t>::max()) {
+      ++hotness_;
+    }
+  }
+
  private:
   ArtMethod* const method_;
   const TaskKind kind_;
   const CompilationKind compilation_kind_;
   ScopedCompilation scoped_compilation_;
+  uint32_t hotness_ = 0u;
+  uint64_t sequence_number_ = 0u;
+  uint64_t enqueue_time_ns_ = 0u;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
 };
 
+// A task of the thread pool running the first compilation in the compile queue of the Jit. The
+// compilation to run is only chosen when the task runs, so that compilations requested later
+// with a higher priority do not wait for this task's turn.
+class JitCompileQueueTask final : public SelfDeletingTask {
+ public:
+  JitCompileQueueTask() {}
+
+  void Run(Thread* self) override {
+    Runtime::Current()->GetJit()->RunNextCompileTask(self);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(JitCompileQueueTask);
+};
+
 static std::string GetProfileFile(const std::string& dex_location) {
   // Hardcoded assumption where the profile file is.
   // TODO(ngeoffray): this is brittle and we would need to change change if we
@@ -1001,6 +1079,64 @@ class ZygoteTask final : public Task {
   DISALLOW_COPY_AND_ASSIGN(ZygoteTask);
 };
 
+class JitWarmStartTask final : public Task {
+ public:
+  JitWarmStartTask(const std::string& path,
+                   const std::vector<std::unique_ptr<const DexFile>>& dex_files,
+                   jobject class_loader)
+      : path_(path) {
+    ScopedObjectAccess soa(Thread::Current());
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::ClassLoader> h_loader(hs.NewHandle(
+        soa.Decode<mirror::ClassLoader>(class_loader)));
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    for (const auto& dex_file : dex_files) {
+      dex_files_.push_back(dex_file.get());
+      // Register the dex file so that we can guarantee it doesn't get deleted
+      // while reading it during the task.
+      class_linker->RegisterDexFile(*dex_file.get(), h_loader.Get());
+    }
+    class_loader_ = soa.Vm()->AddGlobalRef(soa.Self(), h_loader.Get());
+  }
+
+  void Run(Thread* self) override {
+    ScopedObjectAccess soa(self);
+    StackHandleScope<1> hs(self);
+    Handle<mirror::ClassLoader> loader = hs.NewHandle<mirror::ClassLoader>(
+        soa.Decode<mirror::ClassLoader>(class_loader_));
+    Runtime::Current()->GetJit()->CompileMethodsFromWarmStartFile(
+        self, dex_files_, path_, loader);
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+  ~JitWarmStartTask() {
+    ScopedObjectAccess soa(Thread::Current());
+    soa.Vm()->DeleteGlobalRef(soa.Self(), class_loader_);
+  }
+
+ private:
+  const std::string path_;
+  std::vector<const DexFile*> dex_files_;
+  jobject class_loader_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitWarmStartTask);
+};
+
+class JitWriteWarmStartFilesTask final : public SelfDeletingTask {
+ public:
+  JitWriteWarmStartFilesTask() {}
+
+  void Run(Thread* self) override {
+    Runtime::Current()->GetJit()->WriteWarmStartFiles(self);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(JitWriteWarmStartFilesTask);
+};
+
 class JitProfileTask final : public Task {
  public:
   JitProfileTask(const std::vector<std::unique_ptr<const DexFile>>& dex_files,
@@ -1328,12 +1464,178 @@ void Jit::RegisterDexFiles(const std::vector<std::unique_ptr<const DexFile>>& de
     //   system server (though we are in the system server process).
     thread_pool_->AddTask(Thread::Current(), new JitProfileTask(dex_files, class_loader));
   }
+  // Compile the methods that were hot in the previous run of the app, and keep track of the
+  // dex files for updating the warm start file.
+  if (options_->UseWarmStartFile() &&
+      UseJitCompilation() &&
+      class_loader != nullptr &&
+      thread_pool_ != nullptr &&
+      !runtime->IsZygote() &&
+      !runtime->IsJavaDebuggable()) {
+    std::string path = JitWarmStartFile::GetPath(dex_files[0]->GetLocation());
+    if (path.empty()) {
+      return;
+    }
+    Thread* self = Thread::Current();
+    WarmStartDexFiles entry;
+    entry.path = path;
+    for (const auto& dex_file : dex_files) {
+      entry.dex_files.push_back(dex_file.get());
+    }
+    {
+      ScopedObjectAccess soa(self);
+      entry.class_loader =
+          soa.Vm()->AddWeakGlobalRef(self, soa.Decode<mirror::ClassLoader>(class_loader));
+    }
+    {
+      MutexLock mu(self, warm_start_lock_);
+      warm_start_dex_files_.push_back(std::move(entry));
+    }
+    thread_pool_->AddTask(self, new JitWarmStartTask(path, dex_files, class_loader));
+  }
+}
+
+uint32_t Jit::CompileMethodsFromWarmStartFile(Thread* self,
+                                              const std::vector<const DexFile*>& dex_files,
+                                              const std::string& path,
+                                              Handle<mirror::ClassLoader> class_loader) {
+  std::vector<MethodReference> methods;
+  std::string error_msg;
+  if (!JitWarmStartFile::Read(path, dex_files, &methods, &error_msg)) {
+    VLOG(jit) << "Not using JIT warm start file: " << error_msg;
+    return 0u;
+  }
+  StackHandleScope<1> hs(self);
+  MutableHandle<mirror::DexCache> dex_cache = hs.NewHandle<mirror::DexCache>(nullptr);
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  uint32_t added_to_queue = 0u;
+  for (const MethodReference& ref : methods) {
+    if (dex_cache == nullptr || dex_cache->GetDexFile() != ref.dex_file) {
+      dex_cache.Assign(class_linker->FindDexCache(self, *ref.dex_file));
+      CHECK(dex_cache != nullptr) << "Could not find dex cache for " << ref.dex_file->GetLocation();
+    }
+    if (CompileMethodFromProfile(self,
+                                 class_linker,
+                                 ref.index,
+                                 dex_cache,
+                                 class_loader,
+                                 /*add_to_queue=*/ true,
+                                 /*compile_after_boot=*/ false)) {
+      ++added_to_queue;
+    }
+  }
+  VLOG(jit) << "Added " << added_to_queue << " methods from JIT warm start file " << path;
+  return added_to_queue;
+}
+
+void Jit::MaybeScheduleWarmStartFilesWrite(Thread* self) {
+  uint32_t count = optimized_compilations_.fetch_add(1u, std::memory_order_relaxed) + 1u;
+  uint32_t next_write = next_warm_start_write_.load(std::memory_order_relaxed);
+  if (count >= next_write &&
+      next_warm_start_write_.compare_exchange_strong(
+          next_write, 2u * next_write, std::memory_order_relaxed) &&
+      thread_pool_ != nullptr) {
+    thread_pool_->AddTask(self, new JitWriteWarmStartFilesTask());
+  }
+}
+
+void Jit::WriteWarmStartFiles(Thread* self) {
+  std::vector<WarmStartDexFiles> entries;
+  {
+    MutexLock mu(self, warm_start_lock_);
+    entries = warm_start_dex_files_;
+  }
+  for (const WarmStartDexFiles& entry : entries) {
+    std::vector<MethodReference> methods;
+    jobject class_loader;
+    {
+      ScopedObjectAccess soa(self);
+      ObjPtr<mirror::ClassLoader> loader = soa.Decode<mirror::ClassLoader>(entry.class_loader);
+      if (loader == nullptr) {
+        // The class loader and its dex files have been unloaded, drop the entry.
+        bool erased = false;
+        {
+          MutexLock mu(self, warm_start_lock_);
+          auto it = std::find_if(warm_start_dex_files_.begin(),
+                                 warm_start_dex_files_.end(),
+                                 [&](const WarmStartDexFiles& e) {
+                                   return e.class_loader == entry.class_loader;
+                                 });
+          if (it != warm_start_dex_files_.end()) {
+            warm_start_dex_files_.erase(it);
+            erased = true;
+          }
+        }
+        if (erased) {
+          soa.Vm()->DeleteWeakGlobalRef(self, entry.class_loader);
+        }
+        continue;
+      }
+      // Keep the dex files alive while writing the file.
+      class_loader = soa.Vm()->AddGlobalRef(self, loader);
+      code_cache_->GetOptimizedMethods(entry.dex_files, &methods);
+    }
+    std::string error_msg;
+    if (!methods.empty() &&
+        !JitWarmStartFile::Write(entry.path, entry.dex_files, methods, &error_msg)) {
+      VLOG(jit) << "Could not write JIT warm start file: " << error_msg;
+    }
+    ScopedObjectAccess soa(self);
+    soa.Vm()->DeleteGlobalRef(self, class_loader);
+  }
+}
+
+static int GetCompileQueueRank(CompilationKind compilation_kind) {
+  switch (compilation_kind) {
+    case CompilationKind::kOsr:
+      return 0;
+    case CompilationKind::kOptimized:
+      return 1;
+    case CompilationKind::kBaseline:
+      return 2;
+  }
+}
+
+bool Jit::CompileTaskOrder::operator()(const JitCompileTask* lhs,
+                                       const JitCompileTask* rhs) const {
+  int lhs_rank = GetCompileQueueRank(lhs->GetCompilationKind());
+  int rhs_rank = GetCompileQueueRank(rhs->GetCompilationKind());
+  if (lhs_rank != rhs_rank) {
+    return lhs_rank < rhs_rank;
+  }
+  if (lhs->GetHotness() != rhs->GetHotness()) {
+    return lhs->GetHotness() > rhs->GetHotness();
+  }
+  return lhs->GetSequenceNumber() < rhs->GetSequenceNumber();
 }
 
 void Jit::AddCompileTask(Thread* self,
                          ArtMethod* method,
                          CompilationKind compilation_kind,
                          bool precompile) {
+  const std::pair<ArtMethod*, bool> key(method, compilation_kind == CompilationKind::kOsr);
+  // Whether the request can be coalesced with the pending compilation `task`. Only an optimized
+  // request for a pending baseline compilation cannot, it upgrades that compilation instead.
+  auto can_coalesce = [compilation_kind](JitCompileTask* task) {
+    return compilation_kind != CompilationKind::kOptimized ||
+           task->GetCompilationKind() != CompilationKind::kBaseline;
+  };
+  // Move `task` towards the front of the compile queue.
+  auto coalesce = [this](JitCompileTask* task) REQUIRES(compile_queue_lock_) {
+    compile_queue_.erase(task);
+    task->IncrementHotness();
+    compile_queue_.insert(task);
+    Runtime::Current()->GetMetrics()->JitCompileRequestsCoalesced()->AddOne();
+  };
+  {
+    MutexLock mu(self, compile_queue_lock_);
+    auto it = pending_compilations_.find(key);
+    if (it != pending_compilations_.end() && can_coalesce(it->second)) {
+      coalesce(it->second);
+      return;
+    }
+  }
+
   ScopedCompilation sc(this, method, compilation_kind);
   if (!sc.OwnsCompilation()) {
     return;
@@ -1341,8 +1643,124 @@ void Jit::AddCompileTask(Thread* self,
   JitCompileTask::TaskKind task_kind = precompile
       ? JitCompileTask::TaskKind::kPreCompile
       : JitCompileTask::TaskKind::kCompile;
-  thread_pool_->AddTask(
-      self, new JitCompileTask(method, task_kind, compilation_kind, std::move(sc)));
+  std::unique_ptr<JitCompileTask> task(
+      new JitCompileTask(method, task_kind, compilation_kind, std::move(sc)));
+  // Tasks removed from the queue are deleted after releasing the lock, as deleting them takes
+  // the JIT lock.
+  std::unique_ptr<JitCompileTask> upgraded_task;
+  {
+    MutexLock mu(self, compile_queue_lock_);
+    auto it = pending_compilations_.find(key);
+    if (it == pending_compilations_.end()) {
+      task->SetQueuePosition(/*hotness=*/ 1u, compile_queue_sequence_number_++, NanoTime());
+      compile_queue_.insert(task.get());
+      pending_compilations_.emplace(key, task.release());
+    } else if (can_coalesce(it->second)) {
+      // Another thread added a compilation of the method in the meantime.
+      coalesce(it->second);
+      return;
+    } else {
+      // Replace the baseline compilation, keeping its place in the request order. There is
+      // already a thread pool task for it.
+      upgraded_task.reset(it->second);
+      compile_queue_.erase(upgraded_task.get());
+      task->SetQueuePosition(upgraded_task->GetHotness(),
+                             upgraded_task->GetSequenceNumber(),
+                             upgraded_task->GetEnqueueTimeNs());
+      task->IncrementHotness();
+      compile_queue_.insert(task.get());
+      it->second = task.release();
+      Runtime::Current()->GetMetrics()->JitCompileRequestsUpgraded()->AddOne();
+      return;
+    }
+  }
+  thread_pool_->AddTask(self, new JitCompileQueueTask());
+}
+
+void Jit::RunNextCompileTask(Thread* self) {
+  JitCompileTask* task;
+  {
+    MutexLock mu(self, compile_queue_lock_);
+    if (compile_queue_.empty()) {
+      // The queue was cleared while this task was running, see ClearCompileQueue().
+      return;
+    }
+    task = *compile_queue_.begin();
+    compile_queue_.erase(compile_queue_.begin());
+    pending_compilations_.erase(
+        std::make_pair(task->GetMethod(), task->GetCompilationKind() == CompilationKind::kOsr));
+  }
+
+  metrics::ArtMetrics* metrics = Runtime::Current()->GetMetrics();
+  int64_t latency_ms = static_cast<int64_t>(NsToMs(NanoTime() - task->GetEnqueueTimeNs()));
+  switch (task->GetCompilationKind()) {
+    case CompilationKind::kOsr:
+      metrics->JitOsrQueueLatency()->Add(latency_ms);
+      break;
+    case CompilationKind::kOptimized:
+      metrics->JitOptimizedQueueLatency()->Add(latency_ms);
+      break;
+    case CompilationKind::kBaseline:
+      metrics->JitBaselineQueueLatency()->Add(latency_ms);
+      break;
+  }
+
+  bool is_stale;
+  {
+    ScopedObjectAccess soa(self);
+    is_stale = IsStaleCompilation(task->GetMethod(), task->GetCompilationKind());
+    if (is_stale) {
+      VLOG(jit) << "Not compiling " << task->GetMethod()->PrettyMethod()
+                << " kind=" << task->GetCompilationKind()
+                << " because it has been compiled since it was queued";
+    }
+  }
+  if (is_stale) {
+    metrics->JitCompileTasksDropped()->AddOne();
+  } else {
+    task->Run(self);
+  }
+  task->Finalize();
+}
+
+bool Jit::IsStaleCompilation(ArtMethod* method, CompilationKind compilation_kind) {
+  if (compilation_kind == CompilationKind::kOsr) {
+    return code_cache_->IsOsrCompiled(method);
+  }
+  const void* entry_point = method->GetEntryPointFromQuickCompiledCode();
+  if (!code_cache_->ContainsPc(entry_point)) {
+    return false;
+  }
+  if (method->IsNative() || compilation_kind == CompilationKind::kBaseline) {
+    // Either the JNI stub is already in use, or the method has baseline code collecting
+    // profiling info or optimized code, which a baseline compilation would only replace with
+    // slower code.
+    return true;
+  }
+  OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromEntryPoint(entry_point);
+  return !CodeInfo::IsBaseline(method_header->GetOptimizedCodeInfoPtr());
+}
+
+std::vector<Jit::PendingCompilation> Jit::GetPendingCompilations(Thread* self) {
+  MutexLock mu(self, compile_queue_lock_);
+  std::vector<PendingCompilation> result;
+  result.reserve(compile_queue_.size());
+  for (JitCompileTask* task : compile_queue_) {
+    result.push_back({task->GetMethod(), task->GetCompilationKind(), task->GetHotness()});
+  }
+  return result;
+}
+
+void Jit::ClearCompileQueue(Thread* self) {
+  std::set<JitCompileTask*, CompileTaskOrder> tasks;
+  {
+    MutexLock mu(self, compile_queue_lock_);
+    tasks.swap(compile_queue_);
+    pending_compilations_.clear();
+  }
+  for (JitCompileTask* task : tasks) {
+    task->Finalize();
+  }
 }
 
 bool Jit::CompileMethodFromProfile(Thread* self,
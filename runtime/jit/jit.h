@@ -17,6 +17,11 @@
 #ifndef ART_RUNTIME_JIT_JIT_H_
 #define ART_RUNTIME_JIT_JIT_H_
 
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
 #include <android-base/unique_fd.h>
 
 #include "base/histogram-inl.h"
@@ -53,6 +58,8 @@ class String;
 namespace jit {
 
 class JitCodeCache;
+class JitCompileQueueTask;
+class JitCompileQueueTest;
 class JitCompileTask;
 class JitMemoryRegion;
 class JitOptions;
@@ -123,6 +130,10 @@ class JitOptions {
     return use_profiled_jit_compilation_;
   }
 
+  bool UseWarmStartFile() const {
+    return use_warm_start_file_;
+  }
+
   void SetUseJitCompilation(bool b) {
     use_jit_compilation_ = b;
   }
@@ -155,6 +166,7 @@ class JitOptions {
 
   bool use_jit_compilation_;
   bool use_profiled_jit_compilation_;
+  bool use_warm_start_file_;
   bool use_baseline_compiler_;
   size_t code_cache_initial_capacity_;
   size_t code_cache_max_capacity_;
@@ -170,6 +182,7 @@ class JitOptions {
   JitOptions()
       : use_jit_compilation_(false),
         use_profiled_jit_compilation_(false),
+        use_warm_start_file_(false),
         use_baseline_compiler_(false),
         code_cache_initial_capacity_(0),
         code_cache_max_capacity_(0),
@@ -371,6 +384,10 @@ class Jit {
     return thread_pool_.get();
   }
 
+  // Drop the compilations waiting in the compile queue. Must be called whenever the tasks of the
+  // thread pool are removed, as each pending compilation is run by one of these tasks.
+  void ClearCompileQueue(Thread* self) REQUIRES(!compile_queue_lock_);
+
   // Stop the JIT by waiting for all current compilations and enqueued compilations to finish.
   void Stop();
 
@@ -415,6 +432,17 @@ class Jit {
                                          Handle<mirror::ClassLoader> class_loader,
                                          bool add_to_queue);
 
+  // Compile methods from the given warm start file, see JitWarmStartFile. Methods are added
+  // to the JIT queue. Return the number of methods added to the queue.
+  uint32_t CompileMethodsFromWarmStartFile(Thread* self,
+                                           const std::vector<const DexFile*>& dex_files,
+                                           const std::string& path,
+                                           Handle<mirror::ClassLoader> class_loader);
+
+  // Record the methods with optimized code in the warm start files of the dex files registered
+  // so far. Does not hold the mutator lock while writing.
+  void WriteWarmStartFiles(Thread* self);
+
   // Register the dex files to the JIT. This is to perform any compilation/optimization
   // at the point of loading the dex files.
   void RegisterDexFiles(const std::vector<std::unique_ptr<const DexFile>>& dex_files,
@@ -461,12 +489,40 @@ class Jit {
                                 bool compile_after_boot)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Schedule a write of the warm start files after every doubling of the number of optimized
+  // compilations: often during warm up, rarely once the set of hot methods is stable.
+  void MaybeScheduleWarmStartFilesWrite(Thread* self);
+
   static bool BindCompilerMethods(std::string* error_msg);
 
+  // Add a compilation of `method` to the compile queue. If the method already has a pending
+  // compilation of the same kind, or a pending optimized compilation when `compilation_kind` is
+  // baseline, the request is coalesced with it and only raises its hotness. A pending baseline
+  // compilation is upgraded in place by an optimized request.
   void AddCompileTask(Thread* self,
                       ArtMethod* method,
                       CompilationKind compilation_kind,
-                      bool precompile = false);
+                      bool precompile = false)
+      REQUIRES(!compile_queue_lock_);
+
+  // Remove the compilation with the highest priority from the compile queue and run it, unless
+  // another compilation has made it useless in the meantime.
+  void RunNextCompileTask(Thread* self) REQUIRES(!compile_queue_lock_);
+
+  // Whether the method already has the code a compilation of `compilation_kind` would produce.
+  bool IsStaleCompilation(ArtMethod* method, CompilationKind compilation_kind)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // A compilation waiting in the compile queue.
+  struct PendingCompilation {
+    ArtMethod* method;
+    CompilationKind compilation_kind;
+    uint32_t hotness;
+  };
+
+  // Return the compilations in the compile queue, in the order they are run.
+  std::vector<PendingCompilation> GetPendingCompilations(Thread* self)
+      REQUIRES(!compile_queue_lock_);
 
   bool CompileMethodInternal(ArtMethod* method,
                              Thread* self,
@@ -487,6 +543,20 @@ class Jit {
   std::unique_ptr<ThreadPool> thread_pool_;
   std::vector<std::unique_ptr<OatDexFile>> type_lookup_tables_;
 
+  // Compilations requested through AddCompileTask(), ordered by priority: OSR compilations first,
+  // then optimized and baseline ones, and within a kind the hottest method first, in request
+  // order for equally hot methods. The thread pool gets one task per entry, which runs whatever
+  // entry is first in the queue at that time.
+  struct CompileTaskOrder {
+    bool operator()(const JitCompileTask* lhs, const JitCompileTask* rhs) const;
+  };
+  Mutex compile_queue_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::set<JitCompileTask*, CompileTaskOrder> compile_queue_ GUARDED_BY(compile_queue_lock_);
+  // The entries of `compile_queue_`, keyed by method and whether they are OSR compilations.
+  std::map<std::pair<ArtMethod*, bool>, JitCompileTask*> pending_compilations_
+      GUARDED_BY(compile_queue_lock_);
+  uint64_t compile_queue_sequence_number_ GUARDED_BY(compile_queue_lock_);
+
   Mutex boot_completed_lock_;
   bool boot_completed_ GUARDED_BY(boot_completed_lock_) = false;
   std::deque<Task*> tasks_after_boot_ GUARDED_BY(boot_completed_lock_);
@@ -520,6 +590,24 @@ class Jit {
   // between the zygote and apps.
   std::map<ArtMethod*, uint16_t> shared_method_counters_;
 
+  // Dex files registered through RegisterDexFiles() for which we read and update a warm start
+  // file, see JitWarmStartFile.
+  struct WarmStartDexFiles {
+    std::string path;
+    std::vector<const DexFile*> dex_files;
+    // Weak global reference to the class loader owning `dex_files`.
+    jweak class_loader;
+  };
+  Mutex warm_start_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<WarmStartDexFiles> warm_start_dex_files_ GUARDED_BY(warm_start_lock_);
+
+  // The number of successful optimized compilations, and the number at which the warm start
+  // files are next written.
+  std::atomic<uint32_t> optimized_compilations_;
+  std::atomic<uint32_t> next_warm_start_write_;
+
+  friend class art::jit::JitCompileQueueTask;
+  friend class art::jit::JitCompileQueueTest;
   friend class art::jit::JitCompileTask;
 
   DISALLOW_COPY_AND_ASSIGN(Jit);
@@ -16,6 +16,8 @@
 
 #include "jit_code_cache.h"
 
+#include <algorithm>
+#include <numeric>
 #include <sstream>
 
 #include <android-base/logging.h>
@@ -455,6 +457,10 @@ void JitCodeCache::SweepRootTables(IsMarkedVisitor* visitor) {
           mirror::Class* new_klass = down_cast<mirror::Class*>(visitor->IsMarked(klass));
           if (new_klass != klass) {
             cache->classes_[j] = GcRoot<mirror::Class>(new_klass);
+            if (new_klass == nullptr) {
+              // The entry can be reused for another class.
+              cache->counts_[j] = 0u;
+            }
           }
         }
       }
@@ -613,17 +619,21 @@ void JitCodeCache::DisallowInlineCacheAccess() {
 
 void JitCodeCache::CopyInlineCacheInto(
     const InlineCache& ic,
-    /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes) {
+    /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes,
+    /*out*/uint32_t* counts) {
   static_assert(arraysize(ic.classes_) == InlineCache::kIndividualCacheSize);
   DCHECK_EQ(classes->NumberOfReferences(), InlineCache::kIndividualCacheSize);
   DCHECK_EQ(classes->RemainingSlots(), InlineCache::kIndividualCacheSize);
   WaitUntilInlineCacheAccessible(Thread::Current());
   // Note that we don't need to lock `lock_` here, the compiler calling
   // this method has already ensured the inline cache will not be deleted.
-  for (const GcRoot<mirror::Class>& root : ic.classes_) {
-    mirror::Class* object = root.Read();
+  for (size_t i = 0; i != InlineCache::kIndividualCacheSize; ++i) {
+    mirror::Class* object = ic.classes_[i].Read();
     if (object != nullptr) {
       DCHECK_NE(classes->RemainingSlots(), 0u);
+      if (counts != nullptr) {
+        counts[InlineCache::kIndividualCacheSize - classes->RemainingSlots()] = ic.counts_[i];
+      }
       classes->NewHandle(object);
     }
   }
@@ -1485,27 +1495,35 @@ OatQuickMethodHeader* JitCodeCache::LookupOsrMethodHeader(ArtMethod* method) {
   return OatQuickMethodHeader::FromCodePointer(it->second);
 }
 
-ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
-                                              ArtMethod* method,
-                                              const std::vector<uint32_t>& entries) {
+ProfilingInfo* JitCodeCache::AddProfilingInfo(
+    Thread* self,
+    ArtMethod* method,
+    const std::vector<uint32_t>& inline_cache_entries,
+    const std::vector<uint32_t>& branch_cache_entries,
+    const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries) {
   DCHECK(CanAllocateProfilingInfo());
   ProfilingInfo* info = nullptr;
   {
     MutexLock mu(self, *Locks::jit_lock_);
-    info = AddProfilingInfoInternal(self, method, entries);
+    info = AddProfilingInfoInternal(
+        self, method, inline_cache_entries, branch_cache_entries, switch_cache_entries);
   }
 
   if (info == nullptr) {
     GarbageCollectCache(self);
     MutexLock mu(self, *Locks::jit_lock_);
-    info = AddProfilingInfoInternal(self, method, entries);
+    info = AddProfilingInfoInternal(
+        self, method, inline_cache_entries, branch_cache_entries, switch_cache_entries);
   }
   return info;
 }
 
-ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self,
-                                                      ArtMethod* method,
-                                                      const std::vector<uint32_t>& entries) {
+ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(
+    Thread* self,
+    ArtMethod* method,
+    const std::vector<uint32_t>& inline_cache_entries,
+    const std::vector<uint32_t>& branch_cache_entries,
+    const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries) {
   ScopedDebugDisallowReadBarriers sddrb(self);
   // Check whether some other thread has concurrently created it.
   auto it = profiling_infos_.find(method);
@@ -1513,16 +1531,16 @@ ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self,
     return it->second;
   }
 
-  size_t profile_info_size = RoundUp(
-      sizeof(ProfilingInfo) + sizeof(InlineCache) * entries.size(),
-      sizeof(void*));
+  size_t profile_info_size = ProfilingInfo::ComputeSize(
+      inline_cache_entries.size(), branch_cache_entries.size(), switch_cache_entries);
 
   const uint8_t* data = private_region_.AllocateData(profile_info_size);
   if (data == nullptr) {
     return nullptr;
   }
   uint8_t* writable_data = private_region_.GetWritableDataAddress(data);
-  ProfilingInfo* info = new (writable_data) ProfilingInfo(method, entries);
+  ProfilingInfo* info = new (writable_data) ProfilingInfo(
+      method, inline_cache_entries, branch_cache_entries, switch_cache_entries);
 
   profiling_infos_.Put(method, info);
   histogram_profiling_info_memory_use_.AddValue(profile_info_size);
@@ -1555,6 +1573,28 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
     }
     std::vector<ProfileMethodInfo::ProfileInlineCache> inline_caches;
 
+    // Branch counts are only updated by baseline compiled code, save them regardless
+    // of the current code of the method.
+    std::vector<ProfileMethodInfo::ProfileBranchCounts> branch_counts;
+    BranchCache* branch_caches = info->GetBranchCaches();
+    for (size_t i = 0; i < info->number_of_branch_caches_; ++i) {
+      const BranchCache& cache = branch_caches[i];
+      if (cache.GetFalse() != 0u || cache.GetTrue() != 0u) {
+        branch_counts.emplace_back(/*ProfileMethodInfo::ProfileBranchCounts*/
+            cache.GetDexPc(), std::vector<uint32_t>{ cache.GetFalse(), cache.GetTrue() });
+      }
+    }
+    SwitchCache* switch_caches = info->GetSwitchCaches();
+    for (size_t i = 0; i < info->number_of_switch_caches_; ++i) {
+      const SwitchCache& cache = switch_caches[i];
+      const uint16_t* counts = info->GetSwitchCounts(&cache);
+      const uint16_t* counts_end = counts + cache.GetNumberOfEntries() + 1u;
+      if (std::any_of(counts, counts_end, [](uint16_t count) { return count != 0u; })) {
+        branch_counts.emplace_back(/*ProfileMethodInfo::ProfileBranchCounts*/
+            cache.GetDexPc(), std::vector<uint32_t>(counts, counts_end));
+      }
+    }
+
     // If the method is still baseline compiled, don't save the inline caches.
     // They might be incomplete and cause unnecessary deoptimizations.
     // If the inline cache is empty the compiler will generate a regular invoke virtual/interface.
@@ -1563,7 +1603,7 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
         CodeInfo::IsBaseline(
             OatQuickMethodHeader::FromEntryPoint(entry_point)->GetOptimizedCodeInfoPtr())) {
       methods.emplace_back(/*ProfileMethodInfo*/
-          MethodReference(dex_file, method->GetDexMethodIndex()), inline_caches);
+          MethodReference(dex_file, method->GetDexMethodIndex()), inline_caches, branch_counts);
       continue;
     }
 
@@ -1571,6 +1611,7 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
       std::vector<TypeReference> profile_classes;
       const InlineCache& cache = info->cache_[i];
       ArtMethod* caller = info->GetMethod();
+      std::vector<uint32_t> profile_counts;
       bool is_missing_types = false;
       for (size_t k = 0; k < InlineCache::kIndividualCacheSize; k++) {
         mirror::Class* cls = cache.classes_[k].Read();
@@ -1611,17 +1652,25 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
           // Only consider classes from the same apk (including multidex).
           profile_classes.emplace_back(/*ProfileMethodInfo::ProfileClassReference*/
               class_dex_file, type_index);
+          // The last entry counts all the receivers that are not in the other entries.
+          profile_counts.push_back(
+              (k + 1u == InlineCache::kIndividualCacheSize) ? 0u : cache.counts_[k]);
         } else {
           is_missing_types = true;
         }
       }
       if (!profile_classes.empty()) {
         inline_caches.emplace_back(/*ProfileMethodInfo::ProfileInlineCache*/
-            cache.dex_pc_, is_missing_types, profile_classes);
+            cache.dex_pc_,
+            is_missing_types,
+            profile_classes,
+            /*megamorphic=*/ false,
+            profile_counts,
+            std::accumulate(std::begin(cache.counts_), std::end(cache.counts_), 0u));
       }
     }
     methods.emplace_back(/*ProfileMethodInfo*/
-        MethodReference(dex_file, method->GetDexMethodIndex()), inline_caches);
+        MethodReference(dex_file, method->GetDexMethodIndex()), inline_caches, branch_counts);
   }
 }
 
@@ -1792,6 +1841,31 @@ void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self) {
   }
 }
 
+void JitCodeCache::GetOptimizedMethods(const std::vector<const DexFile*>& dex_files,
+                                       std::vector<MethodReference>* methods) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::jit_lock_);
+  ScopedTrace trace(__FUNCTION__);
+  const size_t old_size = methods->size();
+  for (const auto& it : method_code_map_) {
+    ArtMethod* method = it.second;
+    const OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(it.first);
+    if (!method_header->IsOptimized() ||
+        CodeInfo::IsBaseline(method_header->GetOptimizedCodeInfoPtr()) ||
+        method->IsNative() ||
+        method->IsObsolete()) {
+      continue;
+    }
+    const DexFile* dex_file = method->GetDexFile();
+    if (ContainsElement(dex_files, dex_file)) {
+      methods->emplace_back(dex_file, method->GetDexMethodIndex());
+    }
+  }
+  // A method can temporarily have several compiled versions, only record it once.
+  std::sort(methods->begin() + old_size, methods->end());
+  methods->erase(std::unique(methods->begin() + old_size, methods->end()), methods->end());
+}
+
 void JitCodeCache::InvalidateAllCompiledCode() {
   Thread* self = Thread::Current();
   ScopedDebugDisallowReadBarriers sddrb(self);
@@ -1898,6 +1972,7 @@ void JitCodeCache::PostForkChildAction(bool is_system_server, bool is_zygote) {
   ThreadPool* pool = runtime->GetJit()->GetThreadPool();
   if (pool != nullptr) {
     pool->RemoveAllTasks(self);
+    runtime->GetJit()->ClearCompileQueue(self);
   }
 
   MutexLock mu(self, *Locks::jit_lock_);
@@ -39,11 +39,13 @@
 namespace art {
 
 class ArtMethod;
+class DexFile;
 template<class T> class Handle;
 class LinearAlloc;
 class InlineCache;
 class IsMarkedVisitor;
 class JitJniStubTestHelper;
+class MethodReference;
 class OatQuickMethodHeader;
 struct ProfileMethodInfo;
 class ProfilingInfo;
@@ -309,15 +311,21 @@ class JitCodeCache {
       REQUIRES(!Locks::jit_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Copies the classes of `ic` into `classes` and, if `counts` is not null, the number of times
+  // each of them was seen into the matching entries of `counts`.
   void CopyInlineCacheInto(const InlineCache& ic,
-                           /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes)
+                           /*out*/StackHandleScope<InlineCache::kIndividualCacheSize>* classes,
+                           /*out*/uint32_t* counts = nullptr)
       REQUIRES(!Locks::jit_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Create a 'ProfileInfo' for 'method'.
-  ProfilingInfo* AddProfilingInfo(Thread* self,
-                                  ArtMethod* method,
-                                  const std::vector<uint32_t>& entries)
+  ProfilingInfo* AddProfilingInfo(
+      Thread* self,
+      ArtMethod* method,
+      const std::vector<uint32_t>& inline_cache_entries,
+      const std::vector<uint32_t>& branch_cache_entries,
+      const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries)
       REQUIRES(!Locks::jit_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -333,6 +341,13 @@ class JitCodeCache {
       REQUIRES(!Locks::jit_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Adds to `methods` the methods of the given dex files that have optimized (non-baseline,
+  // non-OSR) compiled code. Used for the JIT warm start file, see JitWarmStartFile.
+  void GetOptimizedMethods(const std::vector<const DexFile*>& dex_files,
+                           std::vector<MethodReference>* methods)
+      REQUIRES(!Locks::jit_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void InvalidateAllCompiledCode()
       REQUIRES(!Locks::jit_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -422,9 +437,12 @@ class JitCodeCache {
  private:
   JitCodeCache();
 
-  ProfilingInfo* AddProfilingInfoInternal(Thread* self,
-                                          ArtMethod* method,
-                                          const std::vector<uint32_t>& entries)
+  ProfilingInfo* AddProfilingInfoInternal(
+      Thread* self,
+      ArtMethod* method,
+      const std::vector<uint32_t>& inline_cache_entries,
+      const std::vector<uint32_t>& branch_cache_entries,
+      const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries)
       REQUIRES(Locks::jit_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+
+#include "art_method-inl.h"
+#include "base/metrics/metrics_test.h"
+#include "class_linker-inl.h"
+#include "common_runtime_test.h"
+#include "handle_scope-inl.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace jit {
+
+using metrics::test::CounterValue;
+
+// Keeps a worker of the JIT thread pool busy until released, so that the compilations in the
+// compile queue are only run when the test asks for it.
+class BlockingTask final : public Task {
+ public:
+  explicit BlockingTask(std::atomic<bool>* released) : released_(released) {}
+
+  void Run([[maybe_unused]] Thread* self) override {
+    while (!released_->load(std::memory_order_acquire)) {
+      usleep(1000);
+    }
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  std::atomic<bool>* const released_;
+};
+
+class JitCompileQueueTest : public CommonRuntimeTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) override {
+    callbacks_.reset();
+    CommonRuntimeTest::SetUpRuntimeOptions(options);
+    options->push_back(std::make_pair("-Xusejit:true", nullptr));
+  }
+
+  void SetUp() override {
+    CommonRuntimeTest::SetUp();
+    Thread* self = Thread::Current();
+    self->TransitionFromSuspendedToRunnable();
+    runtime_->Start();
+    jit_ = runtime_->GetJit();
+    ASSERT_TRUE(jit_ != nullptr);
+    ASSERT_TRUE(jit_->GetThreadPool() != nullptr);
+
+    jobject class_loader = LoadDex("StaticLeafMethods");
+    ScopedObjectAccess soa(self);
+    StackHandleScope<2> hs(self);
+    Handle<mirror::ClassLoader> loader(
+        hs.NewHandle(self->DecodeJObject(class_loader)->AsClassLoader()));
+    Handle<mirror::Class> klass(
+        hs.NewHandle(class_linker_->FindClass(self, "LStaticLeafMethods;", loader)));
+    ASSERT_TRUE(klass != nullptr);
+    // Initialize the class so that compiled code is installed as the entry point.
+    ASSERT_TRUE(class_linker_->EnsureInitialized(self, klass, true, true));
+    for (const char* signature : {"(I)I", "(II)I", "(III)I", "(IIII)I"}) {
+      const char* name = (signature[2] == ')') ? "identity" : "sum";
+      ArtMethod* method = klass->FindClassMethod(name, signature, kRuntimePointerSize);
+      ASSERT_TRUE(method != nullptr) << name << signature;
+      methods_.push_back(method);
+    }
+
+    // Keep all workers busy, the compilations queued by the tests are run with
+    // RunNextCompileTask().
+    for (size_t i = 0; i != jit_->GetThreadPool()->GetThreadCount(); ++i) {
+      jit_->GetThreadPool()->AddTask(self, new BlockingTask(&released_));
+    }
+  }
+
+  void TearDown() override {
+    Thread* self = Thread::Current();
+    if (jit_ != nullptr) {
+      jit_->ClearCompileQueue(self);
+    }
+    released_.store(true, std::memory_order_release);
+    if (jit_ != nullptr && jit_->GetThreadPool() != nullptr) {
+      ScopedThreadSuspension sts(self, ThreadState::kNative);
+      jit_->GetThreadPool()->Wait(self, /*do_work=*/ false, /*may_hold_locks=*/ false);
+    }
+    CommonRuntimeTest::TearDown();
+  }
+
+  void AddCompileTask(ArtMethod* method, CompilationKind compilation_kind) {
+    jit_->AddCompileTask(Thread::Current(), method, compilation_kind);
+  }
+
+  void RunNextCompileTask() {
+    Thread* self = Thread::Current();
+    ScopedThreadSuspension sts(self, ThreadState::kNative);
+    jit_->RunNextCompileTask(self);
+  }
+
+  using PendingCompilation = Jit::PendingCompilation;
+
+  std::vector<PendingCompilation> GetPendingCompilations() {
+    return jit_->GetPendingCompilations(Thread::Current());
+  }
+
+  static void ExpectPendingCompilation(const PendingCompilation& pending,
+                                       ArtMethod* method,
+                                       CompilationKind compilation_kind,
+                                       uint32_t hotness) {
+    EXPECT_EQ(method, pending.method);
+    EXPECT_EQ(compilation_kind, pending.compilation_kind);
+    EXPECT_EQ(hotness, pending.hotness);
+  }
+
+  Jit* jit_ = nullptr;
+  std::vector<ArtMethod*> methods_;
+  std::atomic<bool> released_{false};
+};
+
+TEST_F(JitCompileQueueTest, PriorityOrder) {
+  ArtMethod* a = methods_[0];
+  ArtMethod* b = methods_[1];
+  ArtMethod* c = methods_[2];
+  ArtMethod* d = methods_[3];
+  AddCompileTask(a, CompilationKind::kBaseline);
+  AddCompileTask(b, CompilationKind::kOptimized);
+  AddCompileTask(c, CompilationKind::kBaseline);
+  AddCompileTask(d, CompilationKind::kOsr);
+  AddCompileTask(c, CompilationKind::kBaseline);
+
+  // OSR first, then optimized, then baseline with the most requested method first.
+  std::vector<PendingCompilation> pending = GetPendingCompilations();
+  ASSERT_EQ(4u, pending.size());
+  ExpectPendingCompilation(pending[0], d, CompilationKind::kOsr, 1u);
+  ExpectPendingCompilation(pending[1], b, CompilationKind::kOptimized, 1u);
+  ExpectPendingCompilation(pending[2], c, CompilationKind::kBaseline, 2u);
+  ExpectPendingCompilation(pending[3], a, CompilationKind::kBaseline, 1u);
+
+  // Equally hot compilations of the same kind run in request order.
+  jit_->ClearCompileQueue(Thread::Current());
+  AddCompileTask(c, CompilationKind::kBaseline);
+  AddCompileTask(a, CompilationKind::kBaseline);
+  AddCompileTask(b, CompilationKind::kBaseline);
+  pending = GetPendingCompilations();
+  ASSERT_EQ(3u, pending.size());
+  ExpectPendingCompilation(pending[0], c, CompilationKind::kBaseline, 1u);
+  ExpectPendingCompilation(pending[1], a, CompilationKind::kBaseline, 1u);
+  ExpectPendingCompilation(pending[2], b, CompilationKind::kBaseline, 1u);
+}
+
+TEST_F(JitCompileQueueTest, CoalesceRequests) {
+  ArtMethod* a = methods_[0];
+  ArtMethod* b = methods_[1];
+  auto* coalesced = runtime_->GetMetrics()->JitCompileRequestsCoalesced();
+  uint64_t coalesced_before = CounterValue(*coalesced);
+
+  AddCompileTask(a, CompilationKind::kBaseline);
+  AddCompileTask(a, CompilationKind::kBaseline);
+  AddCompileTask(a, CompilationKind::kBaseline);
+  // A baseline request for a pending optimized compilation is coalesced with it.
+  AddCompileTask(b, CompilationKind::kOptimized);
+  AddCompileTask(b, CompilationKind::kBaseline);
+  // OSR compilations are separate from the other kinds.
+  AddCompileTask(a, CompilationKind::kOsr);
+
+  std::vector<PendingCompilation> pending = GetPendingCompilations();
+  ASSERT_EQ(3u, pending.size());
+  ExpectPendingCompilation(pending[0], a, CompilationKind::kOsr, 1u);
+  ExpectPendingCompilation(pending[1], b, CompilationKind::kOptimized, 2u);
+  ExpectPendingCompilation(pending[2], a, CompilationKind::kBaseline, 3u);
+  EXPECT_EQ(coalesced_before + 3u, CounterValue(*coalesced));
+}
+
+TEST_F(JitCompileQueueTest, UpgradeBaselineRequest) {
+  ArtMethod* a = methods_[0];
+  ArtMethod* b = methods_[1];
+  ArtMethod* c = methods_[2];
+  auto* upgraded = runtime_->GetMetrics()->JitCompileRequestsUpgraded();
+  uint64_t upgraded_before = CounterValue(*upgraded);
+
+  AddCompileTask(a, CompilationKind::kBaseline);
+  AddCompileTask(b, CompilationKind::kOptimized);
+  AddCompileTask(b, CompilationKind::kOptimized);
+  AddCompileTask(c, CompilationKind::kBaseline);
+  // The baseline compilation of `a` becomes an optimized one. It keeps its place in the
+  // request order, so it runs before the equally hot `b` that was requested later.
+  AddCompileTask(a, CompilationKind::kOptimized);
+
+  std::vector<PendingCompilation> pending = GetPendingCompilations();
+  ASSERT_EQ(3u, pending.size());
+  ExpectPendingCompilation(pending[0], a, CompilationKind::kOptimized, 2u);
+  ExpectPendingCompilation(pending[1], b, CompilationKind::kOptimized, 2u);
+  ExpectPendingCompilation(pending[2], c, CompilationKind::kBaseline, 1u);
+  EXPECT_EQ(upgraded_before + 1u, CounterValue(*upgraded));
+}
+
+TEST_F(JitCompileQueueTest, DropStaleCompilation) {
+  ArtMethod* a = methods_[0];
+  auto* dropped = runtime_->GetMetrics()->JitCompileTasksDropped();
+  uint64_t dropped_before = CounterValue(*dropped);
+
+  // Compile the method optimized.
+  AddCompileTask(a, CompilationKind::kOptimized);
+  RunNextCompileTask();
+  EXPECT_TRUE(GetPendingCompilations().empty());
+  EXPECT_EQ(dropped_before, CounterValue(*dropped));
+  ASSERT_TRUE(jit_->GetCodeCache()->ContainsPc(a->GetEntryPointFromQuickCompiledCode()));
+
+  // A baseline compilation would replace the optimized code with slower code. It is dropped.
+  const void* entry_point = a->GetEntryPointFromQuickCompiledCode();
+  AddCompileTask(a, CompilationKind::kBaseline);
+  ASSERT_EQ(1u, GetPendingCompilations().size());
+  RunNextCompileTask();
+  EXPECT_TRUE(GetPendingCompilations().empty());
+  EXPECT_EQ(dropped_before + 1u, CounterValue(*dropped));
+  EXPECT_EQ(entry_point, a->GetEntryPointFromQuickCompiledCode());
+}
+
+TEST_F(JitCompileQueueTest, ClearCompileQueue) {
+  AddCompileTask(methods_[0], CompilationKind::kBaseline);
+  AddCompileTask(methods_[1], CompilationKind::kOptimized);
+  ASSERT_EQ(2u, GetPendingCompilations().size());
+  jit_->ClearCompileQueue(Thread::Current());
+  EXPECT_TRUE(GetPendingCompilations().empty());
+
+  // The compilations are no longer being compiled and can be requested again.
+  AddCompileTask(methods_[0], CompilationKind::kBaseline);
+  EXPECT_EQ(1u, GetPendingCompilations().size());
+  // The thread pool task of a cleared compilation finds nothing to run.
+  jit_->ClearCompileQueue(Thread::Current());
+  RunNextCompileTask();
+  EXPECT_TRUE(GetPendingCompilations().empty());
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_warm_start_file.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+#include "arch/instruction_set.h"
+#include "base/bit_utils.h"
+#include "base/file_utils.h"
+#include "base/logging.h"
+#include "base/mem_map.h"
+#include "base/os.h"
+#include "base/unix_file/fd_file.h"
+#include "dex/dex_file.h"
+#include "runtime.h"
+#include "zlib.h"
+
+namespace art {
+namespace jit {
+
+using android::base::StringPrintf;
+
+std::string JitWarmStartFile::GetPath(const std::string& dex_location) {
+  const std::string& data_dir = Runtime::Current()->GetProcessDataDirectory();
+  if (data_dir.empty()) {
+    // The data directory is empty for tests and for the zygote.
+    return "";
+  }
+  // Dex files with the same basename, such as split APKs or APKs from different directories,
+  // need different files, so add a hash of the full location to the name.
+  uint32_t location_hash = crc32(0L, Z_NULL, 0);
+  location_hash = crc32(location_hash,
+                        reinterpret_cast<const Bytef*>(dex_location.data()),
+                        dex_location.size());
+  std::string extension = StringPrintf("%08x.%s.jit",
+                                       location_hash,
+                                       GetInstructionSetString(kRuntimeISA));
+  return data_dir + "/code_cache/" +
+      ReplaceFileExtension(android::base::Basename(dex_location), extension);
+}
+
+bool JitWarmStartFile::Write(const std::string& path,
+                             const std::vector<const DexFile*>& dex_files,
+                             const std::vector<MethodReference>& methods,
+                             std::string* error_msg) {
+  const std::string& boot_checksums = Runtime::Current()->GetBootClassPathChecksums();
+  Header header;
+  std::copy_n(kMagic, sizeof(kMagic), header.magic_);
+  std::copy_n(kVersion, sizeof(kVersion), header.version_);
+  header.isa_ = static_cast<uint32_t>(kRuntimeISA);
+  header.boot_checksums_size_ = boot_checksums.size();
+  header.number_of_dex_files_ = dex_files.size();
+  header.number_of_methods_ = methods.size();
+
+  std::vector<uint8_t> data(sizeof(Header) + RoundUp(boot_checksums.size(), sizeof(uint32_t)));
+  memcpy(data.data(), &header, sizeof(Header));
+  memcpy(data.data() + sizeof(Header), boot_checksums.data(), boot_checksums.size());
+  for (const DexFile* dex_file : dex_files) {
+    DexFileEntry entry = { dex_file->GetLocationChecksum(),
+                           static_cast<uint32_t>(dex_file->NumMethodIds()) };
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&entry);
+    data.insert(data.end(), bytes, bytes + sizeof(entry));
+  }
+  for (const MethodReference& ref : methods) {
+    auto it = std::find(dex_files.begin(), dex_files.end(), ref.dex_file);
+    DCHECK(it != dex_files.end()) << ref.dex_file->GetLocation();
+    MethodEntry entry = { static_cast<uint32_t>(it - dex_files.begin()), ref.index };
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&entry);
+    data.insert(data.end(), bytes, bytes + sizeof(entry));
+  }
+
+  // Write to a temporary file first so that concurrent readers never see a partial file.
+  const std::string temp_path = path + "." + std::to_string(getpid()) + ".tmp";
+  std::unique_ptr<File> file(OS::CreateEmptyFileWriteOnly(temp_path.c_str()));
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Could not create %s: %s", temp_path.c_str(), strerror(errno));
+    return false;
+  }
+  if (!file->WriteFully(data.data(), data.size())) {
+    *error_msg = StringPrintf("Could not write %s: %s", temp_path.c_str(), strerror(errno));
+    file->Erase(/*unlink=*/ true);
+    return false;
+  }
+  if (file->FlushCloseOrErase() != 0) {
+    *error_msg = StringPrintf("Could not flush %s: %s", temp_path.c_str(), strerror(errno));
+    unlink(temp_path.c_str());
+    return false;
+  }
+  if (rename(temp_path.c_str(), path.c_str()) != 0) {
+    *error_msg = StringPrintf("Could not move %s to %s: %s",
+                              temp_path.c_str(),
+                              path.c_str(),
+                              strerror(errno));
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool JitWarmStartFile::Read(const std::string& path,
+                            const std::vector<const DexFile*>& dex_files,
+                            /*out*/ std::vector<MethodReference>* methods,
+                            /*out*/ std::string* error_msg) {
+  std::unique_ptr<File> file(OS::OpenFileForReading(path.c_str()));
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Could not open %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  int64_t file_length = file->GetLength();
+  if (file_length < static_cast<int64_t>(sizeof(Header))) {
+    *error_msg = StringPrintf("File %s is too short", path.c_str());
+    return false;
+  }
+  MemMap map = MemMap::MapFile(static_cast<size_t>(file_length),
+                               PROT_READ,
+                               MAP_PRIVATE,
+                               file->Fd(),
+                               /*start=*/ 0,
+                               /*low_4gb=*/ false,
+                               path.c_str(),
+                               error_msg);
+  if (!map.IsValid()) {
+    return false;
+  }
+
+  Header header;
+  memcpy(&header, map.Begin(), sizeof(Header));
+  if (memcmp(header.magic_, kMagic, sizeof(kMagic)) != 0 ||
+      memcmp(header.version_, kVersion, sizeof(kVersion)) != 0) {
+    *error_msg = StringPrintf("Invalid magic or version in %s", path.c_str());
+    return false;
+  }
+  if (header.isa_ != static_cast<uint32_t>(kRuntimeISA)) {
+    *error_msg = StringPrintf("File %s is for a different instruction set", path.c_str());
+    return false;
+  }
+  const size_t dex_files_offset =
+      sizeof(Header) + RoundUp(static_cast<size_t>(header.boot_checksums_size_), sizeof(uint32_t));
+  const size_t methods_offset =
+      dex_files_offset + static_cast<size_t>(header.number_of_dex_files_) * sizeof(DexFileEntry);
+  const size_t expected_size =
+      methods_offset + static_cast<size_t>(header.number_of_methods_) * sizeof(MethodEntry);
+  if (map.Size() != expected_size) {
+    *error_msg = StringPrintf("Unexpected size %zu of %s, expected %zu",
+                              map.Size(),
+                              path.c_str(),
+                              expected_size);
+    return false;
+  }
+  std::string_view boot_checksums(reinterpret_cast<const char*>(map.Begin() + sizeof(Header)),
+                                  header.boot_checksums_size_);
+  if (boot_checksums != Runtime::Current()->GetBootClassPathChecksums()) {
+    *error_msg = StringPrintf("File %s is for a different boot class path", path.c_str());
+    return false;
+  }
+  if (header.number_of_dex_files_ != dex_files.size()) {
+    *error_msg = StringPrintf("File %s is for %u dex files, expected %zu",
+                              path.c_str(),
+                              header.number_of_dex_files_,
+                              dex_files.size());
+    return false;
+  }
+  for (size_t i = 0; i != dex_files.size(); ++i) {
+    DexFileEntry entry;
+    memcpy(&entry, map.Begin() + dex_files_offset + i * sizeof(DexFileEntry), sizeof(entry));
+    if (entry.location_checksum_ != dex_files[i]->GetLocationChecksum() ||
+        entry.number_of_method_ids_ != dex_files[i]->NumMethodIds()) {
+      *error_msg = StringPrintf("Checksum mismatch for %s in %s",
+                                dex_files[i]->GetLocation().c_str(),
+                                path.c_str());
+      return false;
+    }
+  }
+
+  methods->clear();
+  methods->reserve(header.number_of_methods_);
+  for (size_t i = 0; i != header.number_of_methods_; ++i) {
+    MethodEntry entry;
+    memcpy(&entry, map.Begin() + methods_offset + i * sizeof(MethodEntry), sizeof(entry));
+    if (entry.dex_file_index_ >= dex_files.size() ||
+        entry.method_index_ >= dex_files[entry.dex_file_index_]->NumMethodIds()) {
+      *error_msg = StringPrintf("Invalid method entry %zu in %s", i, path.c_str());
+      return false;
+    }
+    methods->emplace_back(dex_files[entry.dex_file_index_], entry.method_index_);
+  }
+  return true;
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_WARM_START_FILE_H_
+#define ART_RUNTIME_JIT_JIT_WARM_START_FILE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "dex/method_reference.h"
+
+namespace art {
+
+class DexFile;
+
+namespace jit {
+
+// A per-app file recording the methods that had optimized JIT code in a previous run of the app,
+// so that the next run can compile them as soon as their dex files are loaded instead of waiting
+// for them to become hot again.
+//
+// The compiled code itself is not persisted: it embeds the addresses of ArtMethods, classes,
+// strings and of the code cache, which differ from one run to the next.
+//
+// The file is only valid for the exact dex files and boot class path it was written for, and
+// is otherwise ignored. Its layout is:
+//   Header
+//   char boot_class_path_checksums[header.boot_checksums_size] (padded to 4 bytes)
+//   DexFileEntry dex_files[header.number_of_dex_files]
+//   MethodEntry methods[header.number_of_methods]
+class JitWarmStartFile {
+ public:
+  static constexpr uint8_t kMagic[] = { 'j', 'w', 's', '\n' };
+  static constexpr uint8_t kVersion[] = { '0', '0', '1', '\0' };
+
+  // Returns the location of the file for the dex files at `dex_location`, or an empty string if
+  // the process has no data directory. The file lives in the code cache directory of the app,
+  // which is cleared on app updates and OTAs. The name includes a hash of `dex_location`, so that
+  // dex files with the same basename do not share a file.
+  static std::string GetPath(const std::string& dex_location);
+
+  // Writes `methods`, which must all belong to `dex_files`, to the file at `path`.
+  static bool Write(const std::string& path,
+                    const std::vector<const DexFile*>& dex_files,
+                    const std::vector<MethodReference>& methods,
+                    std::string* error_msg);
+
+  // Maps the file at `path` read-only and returns the methods it records, if it was written for
+  // `dex_files`, the current boot class path and instruction set.
+  static bool Read(const std::string& path,
+                   const std::vector<const DexFile*>& dex_files,
+                   /*out*/ std::vector<MethodReference>* methods,
+                   /*out*/ std::string* error_msg);
+
+ private:
+  struct Header {
+    uint8_t magic_[4];
+    uint8_t version_[4];
+    uint32_t isa_;
+    uint32_t boot_checksums_size_;
+    uint32_t number_of_dex_files_;
+    uint32_t number_of_methods_;
+  };
+
+  struct DexFileEntry {
+    uint32_t location_checksum_;
+    uint32_t number_of_method_ids_;
+  };
+
+  struct MethodEntry {
+    uint32_t dex_file_index_;
+    uint32_t method_index_;
+  };
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(JitWarmStartFile);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_WARM_START_FILE_H_
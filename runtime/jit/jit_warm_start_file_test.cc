@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit/jit_warm_start_file.h"
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "android-base/strings.h"
+#include "base/os.h"
+#include "common_runtime_test.h"
+#include "dex/dex_file.h"
+#include "dex/method_reference.h"
+#include "runtime.h"
+
+namespace art {
+namespace jit {
+
+class JitWarmStartFileTest : public CommonRuntimeTest {
+ protected:
+  void SetUp() override {
+    CommonRuntimeTest::SetUp();
+    opened_dex_files_ = OpenTestDexFiles("MultiDex");
+    ASSERT_EQ(opened_dex_files_.size(), 2u);
+    for (const std::unique_ptr<const DexFile>& dex_file : opened_dex_files_) {
+      dex_files_.push_back(dex_file.get());
+    }
+  }
+
+  std::vector<MethodReference> GetSomeMethods() const {
+    std::vector<MethodReference> methods;
+    for (const DexFile* dex_file : dex_files_) {
+      for (uint32_t i = 0; i < dex_file->NumMethodIds(); i += 2) {
+        methods.emplace_back(dex_file, i);
+      }
+    }
+    return methods;
+  }
+
+  std::vector<std::unique_ptr<const DexFile>> opened_dex_files_;
+  std::vector<const DexFile*> dex_files_;
+};
+
+TEST_F(JitWarmStartFileTest, WriteAndRead) {
+  ScratchFile file;
+  std::vector<MethodReference> methods = GetSomeMethods();
+  ASSERT_FALSE(methods.empty());
+  std::string error_msg;
+  ASSERT_TRUE(JitWarmStartFile::Write(file.GetFilename(), dex_files_, methods, &error_msg))
+      << error_msg;
+
+  std::vector<MethodReference> read_methods;
+  ASSERT_TRUE(JitWarmStartFile::Read(file.GetFilename(), dex_files_, &read_methods, &error_msg))
+      << error_msg;
+  EXPECT_EQ(methods, read_methods);
+}
+
+TEST_F(JitWarmStartFileTest, RejectDifferentDexFiles) {
+  ScratchFile file;
+  std::string error_msg;
+  ASSERT_TRUE(
+      JitWarmStartFile::Write(file.GetFilename(), dex_files_, GetSomeMethods(), &error_msg))
+      << error_msg;
+
+  std::vector<MethodReference> read_methods;
+  std::vector<const DexFile*> reversed(dex_files_.rbegin(), dex_files_.rend());
+  EXPECT_FALSE(JitWarmStartFile::Read(file.GetFilename(), reversed, &read_methods, &error_msg));
+  std::vector<const DexFile*> primary_only(dex_files_.begin(), dex_files_.begin() + 1);
+  EXPECT_FALSE(
+      JitWarmStartFile::Read(file.GetFilename(), primary_only, &read_methods, &error_msg));
+  EXPECT_TRUE(read_methods.empty());
+}
+
+TEST_F(JitWarmStartFileTest, RejectTruncatedFile) {
+  ScratchFile file;
+  std::string error_msg;
+  ASSERT_TRUE(
+      JitWarmStartFile::Write(file.GetFilename(), dex_files_, GetSomeMethods(), &error_msg))
+      << error_msg;
+  const char* filename = file.GetFilename().c_str();
+  ASSERT_EQ(0, truncate(filename, OS::GetFileSizeBytes(filename) - 1));
+
+  std::vector<MethodReference> read_methods;
+  EXPECT_FALSE(
+      JitWarmStartFile::Read(file.GetFilename(), dex_files_, &read_methods, &error_msg));
+}
+
+TEST_F(JitWarmStartFileTest, PathDependsOnFullLocation) {
+  EXPECT_EQ("", JitWarmStartFile::GetPath("/a/base.apk"));
+
+  ScratchDir scratch;
+  std::string data_dir = scratch.GetPath();
+  data_dir.pop_back();  // Remove the trailing '/'.
+  Runtime::Current()->SetProcessDataDirectory(data_dir.c_str());
+  std::string path_a = JitWarmStartFile::GetPath("/a/base.apk");
+  std::string path_b = JitWarmStartFile::GetPath("/b/base.apk");
+  std::string path_a_again = JitWarmStartFile::GetPath("/a/base.apk");
+  Runtime::Current()->SetProcessDataDirectory(nullptr);
+
+  EXPECT_TRUE(android::base::StartsWith(path_a, data_dir + "/code_cache/base.")) << path_a;
+  EXPECT_TRUE(android::base::EndsWith(path_a, ".jit")) << path_a;
+  EXPECT_EQ(path_a, path_a_again);
+  EXPECT_NE(path_a, path_b);
+}
+
+}  // namespace jit
+}  // namespace art
@@ -27,6 +27,7 @@
 #include "base/compiler_filter.h"
 #include "base/enums.h"
 #include "base/logging.h"  // For VLOG.
+#include "base/os.h"
 #include "base/scoped_arena_containers.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
@@ -820,6 +821,51 @@ void ProfileSaver::FetchAndCacheResolvedClassesAndMethods(bool startup) {
                  << " in " << PrettyDuration(NanoTime() - start_time);
 }
 
+bool ProfileSaver::HasEnoughNewDataForMappedProfile(
+    const std::string& filename,
+    const std::vector<ProfileMethodInfo>& profile_methods) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  std::unique_ptr<File> file(OS::OpenFileForReading(filename.c_str()));
+  if (file == nullptr) {
+    return true;
+  }
+  std::string error;
+  std::unique_ptr<ProfileCompilationInfo::MappedProfile> mapped_profile =
+      ProfileCompilationInfo::MappedProfile::Open(
+          file->Fd(), /*for_boot_image=*/ options_.GetProfileBootClassPath(), &error);
+  if (mapped_profile == nullptr) {
+    VLOG(profiler) << "Cannot map profile " << filename << ": " << error;
+    return true;
+  }
+
+  // Collect the new methods the same way as the full save does. This only holds the
+  // methods from the JIT code cache, not the data of the existing profile.
+  ProfileCompilationInfo new_info(Runtime::Current()->GetArenaPool(),
+                                  /*for_boot_image=*/ options_.GetProfileBootClassPath());
+  if (!new_info.AddMethods(
+          profile_methods,
+          AnnotateSampleFlags(Hotness::kFlagHot | Hotness::kFlagPostStartup),
+          GetProfileSampleAnnotation())) {
+    return true;
+  }
+  uint32_t new_methods;
+  uint32_t new_classes;
+  mapped_profile->CountNewData(new_info, &new_methods, &new_classes);
+
+  MutexLock mu(Thread::Current(), *Locks::profiler_lock_);
+  auto profile_cache_it = profile_cache_.find(filename);
+  if (profile_cache_it != profile_cache_.end()) {
+    uint32_t cached_new_methods;
+    uint32_t cached_new_classes;
+    mapped_profile->CountNewData(
+        *profile_cache_it->second, &cached_new_methods, &cached_new_classes);
+    new_methods += cached_new_methods;
+    new_classes += cached_new_classes;
+  }
+  return new_methods >= options_.GetMinMethodsToSave() ||
+         new_classes >= options_.GetMinClassesToSave();
+}
+
 bool ProfileSaver::ProcessProfilingInfo(
         bool force_save,
         bool skip_class_and_method_fetching,
@@ -866,9 +912,21 @@ bool ProfileSaver::ProcessProfilingInfo(
       jit_code_cache_->GetProfiledMethods(locations, profile_methods);
       total_number_of_code_cache_queries_++;
     }
+    // A save of the mappable format with little new data is skipped without loading the
+    // existing profile, which avoids reading and parsing it on most periodic saves.
+    if (!force_save &&
+        options_.GetMappableProfile() &&
+        !HasEnoughNewDataForMappedProfile(filename, profile_methods)) {
+      VLOG(profiler) << "Not enough new information to save to mapped profile: " << filename;
+      total_number_of_skipped_writes_++;
+      continue;
+    }
     {
       ProfileCompilationInfo info(Runtime::Current()->GetArenaPool(),
                                   /*for_boot_image=*/options_.GetProfileBootClassPath());
+      // In the mappable format, sections are not compressed and unchanged data is not rewritten,
+      // which keeps the CPU and I/O cost of the periodic saves down.
+      info.SetMappableFormat(options_.GetMappableProfile());
       // Load the existing profile before saving.
       // If the file is updated between `Load` and `Save`, the update will be lost. This is
       // acceptable. The main reason is that the lost entries will eventually come back if the user
@@ -87,6 +87,15 @@ class ProfileSaver {
       REQUIRES(!Locks::profiler_lock_)
       REQUIRES(!Locks::mutator_lock_);
 
+  // Returns whether `profile_methods` and the cached data for `filename` add enough methods or
+  // classes to the existing mappable profile to be worth saving. The existing profile is
+  // checked through a read-only mapping, without loading it. Returns true if the profile
+  // cannot be mapped, so that the caller does the full load and merge.
+  bool HasEnoughNewDataForMappedProfile(const std::string& filename,
+                                        const std::vector<ProfileMethodInfo>& profile_methods)
+      REQUIRES(!Locks::profiler_lock_)
+      REQUIRES(!Locks::mutator_lock_);
+
   void NotifyJitActivityInternal() REQUIRES(!wait_lock_);
   void WakeUpSaver() REQUIRES(wait_lock_);
 
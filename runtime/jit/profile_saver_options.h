@@ -47,7 +47,8 @@ struct ProfileSaverOptions {
     profile_path_(""),
     profile_boot_class_path_(false),
     profile_aot_code_(false),
-    wait_for_jit_notifications_to_save_(true) {}
+    wait_for_jit_notifications_to_save_(true),
+    mappable_profile_(false) {}
 
   ProfileSaverOptions(
       bool enabled,
@@ -62,7 +63,8 @@ struct ProfileSaverOptions {
       const std::string& profile_path,
       bool profile_boot_class_path,
       bool profile_aot_code = false,
-      bool wait_for_jit_notifications_to_save = true)
+      bool wait_for_jit_notifications_to_save = true,
+      bool mappable_profile = false)
   : enabled_(enabled),
     min_save_period_ms_(min_save_period_ms),
     min_first_save_ms_(min_first_save_ms),
@@ -75,7 +77,8 @@ struct ProfileSaverOptions {
     profile_path_(profile_path),
     profile_boot_class_path_(profile_boot_class_path),
     profile_aot_code_(profile_aot_code),
-    wait_for_jit_notifications_to_save_(wait_for_jit_notifications_to_save) {}
+    wait_for_jit_notifications_to_save_(wait_for_jit_notifications_to_save),
+    mappable_profile_(mappable_profile) {}
 
   bool IsEnabled() const {
     return enabled_;
@@ -127,6 +130,9 @@ struct ProfileSaverOptions {
   void SetWaitForJitNotificationsToSave(bool value) {
     wait_for_jit_notifications_to_save_ = value;
   }
+  bool GetMappableProfile() const {
+    return mappable_profile_;
+  }
 
   friend std::ostream & operator<<(std::ostream &os, const ProfileSaverOptions& pso) {
     os << "enabled_" << pso.enabled_
@@ -140,7 +146,8 @@ struct ProfileSaverOptions {
         << ", max_notification_before_wake_" << pso.max_notification_before_wake_
         << ", profile_boot_class_path_" << pso.profile_boot_class_path_
         << ", profile_aot_code_" << pso.profile_aot_code_
-        << ", wait_for_jit_notifications_to_save_" << pso.wait_for_jit_notifications_to_save_;
+        << ", wait_for_jit_notifications_to_save_" << pso.wait_for_jit_notifications_to_save_
+        << ", mappable_profile_" << pso.mappable_profile_;
     return os;
   }
 
@@ -159,6 +166,8 @@ struct ProfileSaverOptions {
   bool profile_boot_class_path_;
   bool profile_aot_code_;
   bool wait_for_jit_notifications_to_save_;
+  // Save profiles in the mappable format, which is updated in place by later saves.
+  bool mappable_profile_;
 };
 
 }  // namespace art
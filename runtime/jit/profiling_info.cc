@@ -16,7 +16,10 @@
 
 #include "profiling_info.h"
 
+#include <algorithm>
+
 #include "art_method-inl.h"
+#include "dex/bytecode_utils.h"
 #include "dex/dex_instruction.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
@@ -25,36 +28,110 @@
 
 namespace art {
 
-ProfilingInfo::ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& entries)
+ProfilingInfo::ProfilingInfo(
+    ArtMethod* method,
+    const std::vector<uint32_t>& inline_cache_entries,
+    const std::vector<uint32_t>& branch_cache_entries,
+    const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries)
       : baseline_hotness_count_(GetOptimizeThreshold()),
         method_(method),
-        number_of_inline_caches_(entries.size()),
+        number_of_inline_caches_(inline_cache_entries.size()),
+        number_of_branch_caches_(branch_cache_entries.size()),
+        number_of_switch_caches_(switch_cache_entries.size()),
         current_inline_uses_(0) {
   memset(&cache_, 0, number_of_inline_caches_ * sizeof(InlineCache));
   for (size_t i = 0; i < number_of_inline_caches_; ++i) {
-    cache_[i].dex_pc_ = entries[i];
+    cache_[i].dex_pc_ = inline_cache_entries[i];
+  }
+  BranchCache* branch_caches = GetBranchCaches();
+  for (size_t i = 0; i < number_of_branch_caches_; ++i) {
+    branch_caches[i].dex_pc_ = branch_cache_entries[i];
+    branch_caches[i].false_ = 0u;
+    branch_caches[i].true_ = 0u;
+  }
+  SwitchCache* switch_caches = GetSwitchCaches();
+  uint32_t number_of_switch_counts = 0u;
+  for (size_t i = 0; i < number_of_switch_caches_; ++i) {
+    switch_caches[i].dex_pc_ = switch_cache_entries[i].first;
+    switch_caches[i].number_of_entries_ = switch_cache_entries[i].second;
+    switch_caches[i].first_count_ = number_of_switch_counts;
+    number_of_switch_counts += switch_cache_entries[i].second + 1u;
+  }
+  memset(GetSwitchCounts(), 0, number_of_switch_counts * sizeof(uint16_t));
+}
+
+size_t ProfilingInfo::ComputeSize(
+    size_t number_of_inline_caches,
+    size_t number_of_branch_caches,
+    const std::vector<std::pair<uint32_t, uint32_t>>& switch_entries) {
+  size_t number_of_switch_counts = 0u;
+  for (const std::pair<uint32_t, uint32_t>& entry : switch_entries) {
+    number_of_switch_counts += entry.second + 1u;
   }
+  return RoundUp(sizeof(ProfilingInfo) +
+                     sizeof(InlineCache) * number_of_inline_caches +
+                     sizeof(BranchCache) * number_of_branch_caches +
+                     sizeof(SwitchCache) * switch_entries.size() +
+                     sizeof(uint16_t) * number_of_switch_counts,
+                 sizeof(void*));
 }
 
 uint16_t ProfilingInfo::GetOptimizeThreshold() {
   return Runtime::Current()->GetJITOptions()->GetOptimizeThreshold();
 }
 
+ProfilingInfo* ProfilingInfo::CreateForTesting(
+    void* storage,
+    ArtMethod* method,
+    const std::vector<uint32_t>& branch_cache_entries,
+    const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries) {
+  DCHECK_ALIGNED(storage, alignof(ProfilingInfo));
+  return new (storage) ProfilingInfo(
+      method, std::vector<uint32_t>(), branch_cache_entries, switch_cache_entries);
+}
+
 ProfilingInfo* ProfilingInfo::Create(Thread* self, ArtMethod* method) {
   // Walk over the dex instructions of the method and keep track of
   // instructions we are interested in profiling.
   DCHECK(!method->IsNative());
 
-  std::vector<uint32_t> entries;
+  std::vector<uint32_t> inline_cache_entries;
+  std::vector<uint32_t> branch_cache_entries;
+  std::vector<std::pair<uint32_t, uint32_t>> switch_cache_entries;
   for (const DexInstructionPcPair& inst : method->DexInstructions()) {
     switch (inst->Opcode()) {
       case Instruction::INVOKE_VIRTUAL:
       case Instruction::INVOKE_VIRTUAL_RANGE:
       case Instruction::INVOKE_INTERFACE:
       case Instruction::INVOKE_INTERFACE_RANGE:
-        entries.push_back(inst.DexPc());
+        inline_cache_entries.push_back(inst.DexPc());
+        break;
+
+      case Instruction::IF_EQ:
+      case Instruction::IF_EQZ:
+      case Instruction::IF_NE:
+      case Instruction::IF_NEZ:
+      case Instruction::IF_LT:
+      case Instruction::IF_LTZ:
+      case Instruction::IF_GE:
+      case Instruction::IF_GEZ:
+      case Instruction::IF_GT:
+      case Instruction::IF_GTZ:
+      case Instruction::IF_LE:
+      case Instruction::IF_LEZ:
+        branch_cache_entries.push_back(inst.DexPc());
         break;
 
+      case Instruction::PACKED_SWITCH: {
+        // Small switches are compiled to a sequence of compares and are not profiled.
+        DexSwitchTable table(inst.Inst(), inst.DexPc());
+        if (!table.ShouldBuildDecisionTree() &&
+            table.GetNumEntries() <= SwitchCache::kMaxEntries) {
+          switch_cache_entries.emplace_back(inst.DexPc(), table.GetNumEntries());
+        }
+        break;
+      }
+
       default:
         break;
     }
@@ -65,7 +142,8 @@ ProfilingInfo* ProfilingInfo::Create(Thread* self, ArtMethod* method) {
 
   // Allocate the `ProfilingInfo` object int the JIT's data space.
   jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
-  return code_cache->AddProfilingInfo(self, method, entries);
+  return code_cache->AddProfilingInfo(
+      self, method, inline_cache_entries, branch_cache_entries, switch_cache_entries);
 }
 
 InlineCache* ProfilingInfo::GetInlineCache(uint32_t dex_pc) {
@@ -80,13 +158,39 @@ InlineCache* ProfilingInfo::GetInlineCache(uint32_t dex_pc) {
   UNREACHABLE();
 }
 
+BranchCache* ProfilingInfo::GetBranchCache(uint32_t dex_pc) {
+  // The caches are sorted by dex pc.
+  BranchCache* begin = GetBranchCaches();
+  BranchCache* end = begin + number_of_branch_caches_;
+  BranchCache* it = std::lower_bound(
+      begin, end, dex_pc, [](const BranchCache& cache, uint32_t pc) { return cache.dex_pc_ < pc; });
+  return (it != end && it->dex_pc_ == dex_pc) ? it : nullptr;
+}
+
+SwitchCache* ProfilingInfo::GetSwitchCache(uint32_t dex_pc) {
+  SwitchCache* caches = GetSwitchCaches();
+  for (size_t i = 0; i < number_of_switch_caches_; ++i) {
+    if (caches[i].dex_pc_ == dex_pc) {
+      return &caches[i];
+    }
+  }
+  return nullptr;
+}
+
 void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
   InlineCache* cache = GetInlineCache(dex_pc);
+  // The counters are racy and saturate, like the ones updated by compiled code.
+  auto increment_count = [cache](size_t index) {
+    if (cache->counts_[index] != std::numeric_limits<uint16_t>::max()) {
+      ++cache->counts_[index];
+    }
+  };
   for (size_t i = 0; i < InlineCache::kIndividualCacheSize; ++i) {
     mirror::Class* existing = cache->classes_[i].Read<kWithoutReadBarrier>();
     mirror::Class* marked = ReadBarrier::IsMarked(existing);
     if (marked == cls) {
-      // Receiver type is already in the cache, nothing else to do.
+      // Receiver type is already in the cache, just count it.
+      increment_count(i);
       return;
     } else if (marked == nullptr) {
       // Cache entry is empty, try to put `cls` in it.
@@ -101,13 +205,16 @@ void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
         // entry in case the entry contains `cls`.
         --i;
       } else {
-        // We successfully set `cls`, just return.
+        // We successfully set `cls`, count it and return.
+        increment_count(i);
         return;
       }
     }
   }
   // Unsuccessfull - cache is full, making it megamorphic. We do not DCHECK it though,
-  // as the garbage collector might clear the entries concurrently.
+  // as the garbage collector might clear the entries concurrently. Count the receiver
+  // with the other receivers not in the cache.
+  increment_count(InlineCache::kIndividualCacheSize - 1u);
 }
 
 ScopedProfilingInfoUse::ScopedProfilingInfoUse(jit::Jit* jit, ArtMethod* method, Thread* self)
@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_JIT_PROFILING_INFO_H_
 #define ART_RUNTIME_JIT_PROFILING_INFO_H_
 
+#include <utility>
 #include <vector>
 
 #include "base/macros.h"
@@ -39,8 +40,10 @@ namespace mirror {
 class Class;
 }  // namespace mirror
 
-// Structure to store the classes seen at runtime for a specific instruction.
-// Once the classes_ array is full, we consider the INVOKE to be megamorphic.
+// Structure to store the classes seen at runtime for a specific instruction,
+// and how many times each of them was seen. Once the classes_ array is full,
+// we consider the INVOKE to be megamorphic: the last entry then holds the latest
+// receiver not in the other entries, and its counter counts all such receivers.
 class InlineCache {
  public:
   // This is hard coded in the assembly stub art_quick_update_inline_cache.
@@ -50,9 +53,15 @@ class InlineCache {
     return MemberOffset(OFFSETOF_MEMBER(InlineCache, classes_));
   }
 
+  static constexpr MemberOffset CountsOffset() {
+    return MemberOffset(OFFSETOF_MEMBER(InlineCache, counts_));
+  }
+
  private:
   uint32_t dex_pc_;
   GcRoot<mirror::Class> classes_[kIndividualCacheSize];
+  // Saturating counters of the receivers seen for each entry of `classes_`.
+  uint16_t counts_[kIndividualCacheSize];
 
   friend class jit::JitCodeCache;
   friend class ProfilingInfo;
@@ -60,6 +69,67 @@ class InlineCache {
   DISALLOW_COPY_AND_ASSIGN(InlineCache);
 };
 
+// Structure to store how many times a conditional branch was not taken and taken,
+// indexed by the value of the branch condition. The counters saturate.
+class BranchCache {
+ public:
+  static constexpr MemberOffset FalseOffset() {
+    return MemberOffset(OFFSETOF_MEMBER(BranchCache, false_));
+  }
+
+  static constexpr MemberOffset TrueOffset() {
+    return MemberOffset(OFFSETOF_MEMBER(BranchCache, true_));
+  }
+
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  uint16_t GetFalse() const {
+    return false_;
+  }
+
+  uint16_t GetTrue() const {
+    return true_;
+  }
+
+ private:
+  uint32_t dex_pc_;
+  uint16_t false_;
+  uint16_t true_;
+
+  friend class ProfilingInfo;
+
+  DISALLOW_COPY_AND_ASSIGN(BranchCache);
+};
+
+// Structure to store how many times each target of a PACKED_SWITCH was taken. The
+// saturating counters, one per switch entry followed by one for the default target,
+// are stored at the end of the ProfilingInfo, see ProfilingInfo::GetSwitchCounts.
+class SwitchCache {
+ public:
+  // Larger switches are not profiled.
+  static constexpr uint32_t kMaxEntries = 256u;
+
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  uint32_t GetNumberOfEntries() const {
+    return number_of_entries_;
+  }
+
+ private:
+  uint32_t dex_pc_;
+  uint32_t number_of_entries_;
+  // Index of the first counter of this switch.
+  uint32_t first_count_;
+
+  friend class ProfilingInfo;
+
+  DISALLOW_COPY_AND_ASSIGN(SwitchCache);
+};
+
 /**
  * Profiling info for a method, created and filled by the interpreter once the
  * method is warm, and used by the compiler to drive optimizations.
@@ -83,6 +153,33 @@ class ProfilingInfo {
 
   InlineCache* GetInlineCache(uint32_t dex_pc);
 
+  // Returns the branch cache of the IF_* instruction at `dex_pc`, or null if there is none.
+  BranchCache* GetBranchCache(uint32_t dex_pc);
+
+  // Returns the switch cache of the PACKED_SWITCH instruction at `dex_pc`, or null if there
+  // is none.
+  SwitchCache* GetSwitchCache(uint32_t dex_pc);
+
+  // Returns the `cache->GetNumberOfEntries() + 1` counters of `cache`.
+  uint16_t* GetSwitchCounts(const SwitchCache* cache) {
+    return GetSwitchCounts() + cache->first_count_;
+  }
+
+  // Create a ProfilingInfo with the given branch and switch caches in `storage`, which must
+  // hold `ComputeSize(0u, branch_cache_entries.size(), switch_cache_entries)` bytes.
+  // This function is exposed for testing purposes.
+  static ProfilingInfo* CreateForTesting(
+      void* storage,
+      ArtMethod* method,
+      const std::vector<uint32_t>& branch_cache_entries,
+      const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries);
+
+  // Returns the size of a ProfilingInfo with the given caches. `switch_entries` holds
+  // the dex pc and the number of entries of each profiled switch.
+  static size_t ComputeSize(size_t number_of_inline_caches,
+                            size_t number_of_branch_caches,
+                            const std::vector<std::pair<uint32_t, uint32_t>>& switch_entries);
+
   // Increments the number of times this method is currently being inlined.
   // Returns whether it was successful, that is it could increment without
   // overflowing.
@@ -120,10 +217,26 @@ class ProfilingInfo {
   }
 
  private:
-  ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& entries);
+  ProfilingInfo(ArtMethod* method,
+                const std::vector<uint32_t>& inline_cache_entries,
+                const std::vector<uint32_t>& branch_cache_entries,
+                const std::vector<std::pair<uint32_t, uint32_t>>& switch_cache_entries);
 
   static uint16_t GetOptimizeThreshold();
 
+  // The branch caches, switch caches and switch counters follow the inline caches.
+  BranchCache* GetBranchCaches() {
+    return reinterpret_cast<BranchCache*>(cache_ + number_of_inline_caches_);
+  }
+
+  SwitchCache* GetSwitchCaches() {
+    return reinterpret_cast<SwitchCache*>(GetBranchCaches() + number_of_branch_caches_);
+  }
+
+  uint16_t* GetSwitchCounts() {
+    return reinterpret_cast<uint16_t*>(GetSwitchCaches() + number_of_switch_caches_);
+  }
+
   // Hotness count for methods compiled with the JIT baseline compiler. Once
   // a threshold is hit (currentily the maximum value of uint16_t), we will
   // JIT compile optimized the method.
@@ -137,11 +250,17 @@ class ProfilingInfo {
   // Number of instructions we are profiling in the ArtMethod.
   const uint32_t number_of_inline_caches_;
 
+  // Number of conditional branches and packed switches we are profiling in the ArtMethod.
+  const uint32_t number_of_branch_caches_;
+  const uint32_t number_of_switch_caches_;
+
   // When the compiler inlines the method associated to this ProfilingInfo,
   // it updates this counter so that the GC does not try to clear the inline caches.
   uint16_t current_inline_uses_;
 
-  // Dynamically allocated array of size `number_of_inline_caches_`.
+  // Dynamically allocated array of size `number_of_inline_caches_`, followed by
+  // `number_of_branch_caches_` BranchCaches, `number_of_switch_caches_` SwitchCaches
+  // and their counters.
   InlineCache cache_[0];
 
   friend class jit::JitCodeCache;
@@ -192,6 +192,14 @@ constexpr std::optional<int32_t> EncodeDatumId(DatumId datum_id) {
       return std::make_optional(
           statsd::
               ART_DATUM_DELTA_REPORTED__KIND__ART_DATUM_DELTA_GC_FULL_HEAP_COLLECTION_DURATION_MS);
+    case DatumId::kJitCompileRequestsCoalesced:
+    case DatumId::kJitCompileRequestsUpgraded:
+    case DatumId::kJitCompileTasksDropped:
+    case DatumId::kJitOsrQueueLatency:
+    case DatumId::kJitOptimizedQueueLatency:
+    case DatumId::kJitBaselineQueueLatency:
+      // There are no atoms for the JIT compile queue metrics yet.
+      return std::nullopt;
   }
 }
 
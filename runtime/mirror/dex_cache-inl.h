@@ -115,6 +115,17 @@ inline void NativeDexCachePair<T>::Initialize(std::atomic<NativeDexCachePair<T>>
   AtomicPairStoreRelease(&array[0], v);
 }
 
+template <typename T, size_t size>
+template <typename ArrayType>
+inline void DexCachePairArray<T, size>::CopyTo(ArrayType* array) {
+  for (uint32_t slot = 0; slot != size; ++slot) {
+    DexCachePair<T> pair = entries_[slot].load(std::memory_order_relaxed);
+    if (pair.index != DexCachePair<T>::InvalidIndexForSlot(slot)) {
+      array->Set(pair.index, pair.object.Read());
+    }
+  }
+}
+
 template <typename T>
 inline void GcRootArray<T>::Set(uint32_t index, T* value) {
   GcRoot<T> root(value);
@@ -126,6 +137,13 @@ inline T* GcRootArray<T>::Get(uint32_t index) {
   return entries_[index].load(std::memory_order_relaxed).Read();
 }
 
+template <typename PairArray, typename Array>
+inline void DexCache::GrowPairArray(PairArray* pairs, Array* array) {
+  pairs->CopyTo(array);
+  // The copied roots are still in `pairs`, but may be evicted from it before the GC visits it.
+  WriteBarrier::ForEveryFieldWrite(this);
+}
+
 inline uint32_t DexCache::ClassSize(PointerSize pointer_size) {
   const uint32_t vtable_entries = Object::kVTableLength;
   return Class::ComputeClassSize(true, vtable_entries, 0, 0, 0, 0, 0, pointer_size);
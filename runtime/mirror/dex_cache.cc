@@ -16,6 +16,8 @@
 
 #include "dex_cache-inl.h"
 
+#include <sstream>
+
 #include "art_method-inl.h"
 #include "class_linker.h"
 #include "gc/accounting/card_table-inl.h"
@@ -214,6 +216,40 @@ void DexCache::UnlinkStartupCaches() {
   UnlinkResolvedMethodTypesArrayIfStartup();
 }
 
+bool DexCache::CanGrowPairArrays() {
+  // To save on memory in dex2oat, we don't grow pair arrays.
+  return !Runtime::Current()->IsAotCompiler();
+}
+
+template <typename PairArray, typename Array>
+static void DumpPairArrayStatistics(std::ostream& os,
+                                    const char* name,
+                                    PairArray* pairs,
+                                    Array* array) REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (pairs != nullptr) {
+    os << " " << name << " misses=" << pairs->GetStat(kDexCachePairMisses)
+       << " evictions=" << pairs->GetStat(kDexCachePairEvictions)
+       << (array != nullptr ? " grown" : "");
+  }
+}
+
+void DexCache::DumpStatistics(std::ostream& os) {
+  if (GetDexFile() == nullptr) {
+    // Unused dex cache.
+    return;
+  }
+  std::ostringstream oss;
+  DumpPairArrayStatistics(oss, "strings", GetStrings(), GetStringsArray());
+  DumpPairArrayStatistics(oss, "types", GetResolvedTypes(), GetResolvedTypesArray());
+  DumpPairArrayStatistics(oss, "methods", GetResolvedMethods(), GetResolvedMethodsArray());
+  DumpPairArrayStatistics(oss, "fields", GetResolvedFields(), GetResolvedFieldsArray());
+  DumpPairArrayStatistics(
+      oss, "method types", GetResolvedMethodTypes(), GetResolvedMethodTypesArray());
+  if (oss.tellp() != 0) {
+    os << GetDexFile()->GetLocation() << ":" << oss.str() << "\n";
+  }
+}
+
 void DexCache::SetResolvedType(dex::TypeIndex type_idx, ObjPtr<Class> resolved) {
   DCHECK(resolved != nullptr);
   DCHECK(resolved->IsResolved()) << resolved->GetStatus();
@@ -118,6 +118,15 @@ template <typename T> struct PACKED(2 * __SIZEOF_POINTER__) NativeDexCachePair {
   }
 };
 
+// Statistics of the pair arrays below, kept in the index fields of extra pairs after the
+// entries of an array. The objects of these pairs stay null, so that visitors of all the pairs
+// of the allocation skip them. The statistics are updated racily and may lose updates.
+enum DexCachePairStat : size_t {
+  kDexCachePairMisses,     // Entries stored in the array.
+  kDexCachePairEvictions,  // Entries that replaced the entry of another index.
+  kNumDexCachePairStats,
+};
+
 template <typename T, size_t size> class NativeDexCachePairArray {
  public:
   NativeDexCachePairArray() {}
@@ -127,9 +136,19 @@ template <typename T, size_t size> class NativeDexCachePairArray {
     return pair.GetObjectForIndex(index);
   }
 
-  void Set(uint32_t index, T* value) {
+  // Stores `value` and returns whether it evicted the entry of another index.
+  bool Set(uint32_t index, T* value) {
+    uint32_t slot = SlotIndex(index);
+    size_t old_index = GetNativePair(entries_, slot).index;
     NativeDexCachePair<T> pair(value, index);
-    SetNativePair(entries_, SlotIndex(index), pair);
+    SetNativePair(entries_, slot, pair);
+    bool evicted = old_index != index &&
+                   old_index != NativeDexCachePair<T>::InvalidIndexForSlot(slot);
+    IncrementStat(kDexCachePairMisses);
+    if (evicted) {
+      IncrementStat(kDexCachePairEvictions);
+    }
+    return evicted;
   }
 
   NativeDexCachePair<T> GetNativePair(uint32_t index) REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -140,7 +159,28 @@ template <typename T, size_t size> class NativeDexCachePairArray {
     SetNativePair(entries_, SlotIndex(index), value);
   }
 
+  size_t GetStat(DexCachePairStat stat) {
+    return GetNativePair(entries_, size + stat).index;
+  }
+
+  // Copies the cached entries to the full `array`.
+  template <typename ArrayType>
+  void CopyTo(ArrayType* array) {
+    for (uint32_t slot = 0; slot != size; ++slot) {
+      NativeDexCachePair<T> pair = GetNativePair(entries_, slot);
+      if (pair.index != NativeDexCachePair<T>::InvalidIndexForSlot(slot)) {
+        array->Set(static_cast<uint32_t>(pair.index), pair.object);
+      }
+    }
+  }
+
  private:
+  void IncrementStat(DexCachePairStat stat) {
+    NativeDexCachePair<T> pair = GetNativePair(entries_, size + stat);
+    ++pair.index;
+    SetNativePair(entries_, size + stat, pair);
+  }
+
   NativeDexCachePair<T> GetNativePair(std::atomic<NativeDexCachePair<T>>* pair_array, size_t idx) {
     auto* array = reinterpret_cast<std::atomic<AtomicPair<uintptr_t>>*>(pair_array);
     AtomicPair<uintptr_t> value = AtomicPairLoadAcquire(&array[idx]);
@@ -173,8 +213,17 @@ template <typename T, size_t size> class DexCachePairArray {
     return GetPair(index).GetObjectForIndex(index);
   }
 
-  void Set(uint32_t index, T* value) REQUIRES_SHARED(Locks::mutator_lock_) {
+  // Stores `value` and returns whether it evicted the entry of another index.
+  bool Set(uint32_t index, T* value) REQUIRES_SHARED(Locks::mutator_lock_) {
+    uint32_t slot = SlotIndex(index);
+    uint32_t old_index = entries_[slot].load(std::memory_order_relaxed).index;
     SetPair(index, DexCachePair<T>(value, index));
+    bool evicted = old_index != index && old_index != DexCachePair<T>::InvalidIndexForSlot(slot);
+    IncrementStat(kDexCachePairMisses);
+    if (evicted) {
+      IncrementStat(kDexCachePairEvictions);
+    }
+    return evicted;
   }
 
   DexCachePair<T> GetPair(uint32_t index) {
@@ -194,7 +243,21 @@ template <typename T, size_t size> class DexCachePairArray {
     }
   }
 
+  size_t GetStat(DexCachePairStat stat) {
+    return entries_[size + stat].load(std::memory_order_relaxed).index;
+  }
+
+  // Copies the cached entries to the full `array`.
+  template <typename ArrayType>
+  void CopyTo(ArrayType* array) REQUIRES_SHARED(Locks::mutator_lock_);
+
  private:
+  void IncrementStat(DexCachePairStat stat) {
+    DexCachePair<T> pair = entries_[size + stat].load(std::memory_order_relaxed);
+    ++pair.index;
+    entries_[size + stat].store(pair, std::memory_order_relaxed);
+  }
+
   uint32_t SlotIndex(uint32_t index) {
     return index % size;
   }
@@ -288,6 +351,11 @@ class MANAGED DexCache final : public Object {
   static_assert(IsPowerOfTwo(kDexCacheMethodTypeCacheSize),
                 "MethodType dex cache size is not a power of 2.");
 
+  // Number of evictions from a pair array, relative to its size, after which the pair array is
+  // replaced by a full array. Hashing the ids of a large dex file into a pair array of fixed
+  // size thrashes when the working set of the app exceeds the size of the pair array.
+  static constexpr size_t kEvictionsToGrowFactor = 4u;
+
   // Size of an instance of java.lang.DexCache not including referenced values.
   static constexpr uint32_t InstanceSize() {
     return sizeof(DexCache);
@@ -386,6 +454,9 @@ class MANAGED DexCache final : public Object {
   // allocator.
   void UnlinkStartupCaches() REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Dumps the misses and evictions of the pair arrays, if any.
+  void DumpStatistics(std::ostream& os) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Returns whether we should allocate a full array given the number of elements.
   // Note: update the image version in image.cc if changing this method.
   static bool ShouldAllocateFullArray(size_t number_of_elements, size_t dex_cache_size) {
@@ -436,7 +507,7 @@ class MANAGED DexCache final : public Object {
       REQUIRES_SHARED(Locks::mutator_lock_) { \
     return reinterpret_cast<pair_kind ##Array<type, size>*>( \
         AllocArray<std::atomic<pair_kind<type>>>( \
-            getter_setter ##Offset(), size, alloc_kind)); \
+            getter_setter ##Offset(), size + kNumDexCachePairStats, alloc_kind)); \
   } \
   template<VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags> \
   size_t Num ##getter_setter() REQUIRES_SHARED(Locks::mutator_lock_) { \
@@ -479,14 +550,18 @@ class MANAGED DexCache final : public Object {
           pairs = Allocate ##getter_setter(); \
           pairs->Set(index, resolved); \
         } \
-      } else { \
-        pairs->Set(index, resolved); \
+      } else if (pairs->Set(index, resolved) && \
+                 pairs->GetStat(kDexCachePairEvictions) >= kEvictionsToGrowFactor * pair_size && \
+                 CanGrowPairArrays()) { \
+        GrowPairArray(pairs, Allocate ##getter_setter ##Array()); \
       } \
     } \
   } \
   void Unlink ##getter_setter ##ArrayIfStartup() \
       REQUIRES_SHARED(Locks::mutator_lock_) { \
-    if (!ShouldAllocateFullArray(GetDexFile()->ids(), pair_size)) { \
+    /* A full array that replaced a pair array was not allocated for startup, keep it. */ \
+    if (!ShouldAllocateFullArray(GetDexFile()->ids(), pair_size) && \
+        Get ##getter_setter() == nullptr) { \
       Set ##getter_setter ##Array(nullptr) ; \
     } \
   }
@@ -573,6 +648,15 @@ class MANAGED DexCache final : public Object {
   // the runtime and oat files.
   bool ShouldAllocateFullArrayAtStartup() REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns whether pair arrays that keep evicting entries may be replaced by full arrays.
+  static bool CanGrowPairArrays();
+
+  // Copies the entries of `pairs` to the full `array` replacing it. The pair array stays
+  // linked, so that concurrent readers and writers that still use it remain correct, and
+  // lookups check the full array first.
+  template <typename PairArray, typename Array>
+  void GrowPairArray(PairArray* pairs, Array* array) REQUIRES_SHARED(Locks::mutator_lock_);
+
   HeapReference<ClassLoader> class_loader_;
   HeapReference<String> location_;
 
@@ -25,6 +25,7 @@
 #include "linear_alloc.h"
 #include "mirror/class_loader-inl.h"
 #include "mirror/dex_cache-inl.h"
+#include "mirror/string.h"
 #include "scoped_thread_state_change-inl.h"
 
 namespace art {
@@ -72,6 +73,45 @@ TEST_F(DexCacheMethodHandlesTest, Open) {
   EXPECT_EQ(0u, dex_cache->NumResolvedMethodTypes());
 }
 
+TEST_F(DexCacheTest, GrowPairArray) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  ASSERT_TRUE(java_lang_dex_file_ != nullptr);
+  Handle<DexCache> dex_cache(
+      hs.NewHandle(class_linker_->AllocAndInitializeDexCache(
+          soa.Self(), *java_lang_dex_file_, /*class_loader=*/nullptr)));
+  ASSERT_TRUE(dex_cache != nullptr);
+  Handle<String> string(hs.NewHandle(String::AllocFromModifiedUtf8(soa.Self(), "string")));
+  ASSERT_TRUE(string != nullptr);
+
+  // Store strings whose indexes map to the same slots until the pair array is replaced.
+  constexpr size_t kCacheSize = DexCache::kDexCacheStringCacheSize;
+  constexpr size_t kNumStrings = (DexCache::kEvictionsToGrowFactor + 1u) * kCacheSize;
+  ASSERT_GE(java_lang_dex_file_->NumStringIds(), kNumStrings);
+  for (size_t i = 0; i != kNumStrings - 1u; ++i) {
+    dex_cache->SetResolvedString(dex::StringIndex(i), string.Get());
+  }
+  ASSERT_TRUE(dex_cache->GetStrings() != nullptr);
+  EXPECT_TRUE(dex_cache->GetStringsArray() == nullptr);
+  EXPECT_EQ(kNumStrings - 1u, dex_cache->GetStrings()->GetStat(kDexCachePairMisses));
+  EXPECT_EQ(kNumStrings - kCacheSize - 1u,
+            dex_cache->GetStrings()->GetStat(kDexCachePairEvictions));
+  dex_cache->SetResolvedString(dex::StringIndex(kNumStrings - 1u), string.Get());
+  ASSERT_TRUE(dex_cache->GetStringsArray() != nullptr);
+
+  // The full array holds the entries of the pair array, and the evicted ones can be stored again.
+  for (size_t i = kNumStrings - kCacheSize; i != kNumStrings; ++i) {
+    EXPECT_OBJ_PTR_EQ(string.Get(), dex_cache->GetResolvedString(dex::StringIndex(i)));
+  }
+  EXPECT_TRUE(dex_cache->GetResolvedString(dex::StringIndex(0u)) == nullptr);
+  dex_cache->SetResolvedString(dex::StringIndex(0u), string.Get());
+  EXPECT_OBJ_PTR_EQ(string.Get(), dex_cache->GetResolvedString(dex::StringIndex(0u)));
+
+  // The full array is not a startup cache.
+  dex_cache->UnlinkStartupCaches();
+  EXPECT_TRUE(dex_cache->GetStringsArray() != nullptr);
+}
+
 TEST_F(DexCacheTest, TestResolvedFieldAccess) {
   ScopedObjectAccess soa(Thread::Current());
   jobject jclass_loader(LoadDex("Packages"));
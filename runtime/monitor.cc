@@ -53,6 +53,34 @@ using android::base::StringPrintf;
 static constexpr uint64_t kDebugThresholdFudgeFactor = kIsDebugBuild ? 10 : 1;
 static constexpr uint64_t kLongWaitMs = 100 * kDebugThresholdFudgeFactor;
 
+// Adaptive thin lock spinning keeps a small history of how spinning went for recently contended
+// locks. Each entry is shared by all objects hashing to it and holds the number of times the spin
+// budget for those objects has been halved. A successful spin lowers it, an inflation caused by
+// spinning for the whole budget raises it. Objects move, so this is only ever a hint.
+static constexpr size_t kSpinHistorySize = 256;
+static constexpr uint8_t kMaxSpinBudgetShift = 3;
+// How often, in contention iterations, to check whether the owner of a thin lock is runnable.
+static constexpr size_t kOwnerCheckInterval = 8;
+static std::atomic<uint8_t> gSpinHistory[kSpinHistorySize];
+
+static std::atomic<uint8_t>* GetSpinHistoryEntry(ObjPtr<mirror::Object> obj)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(obj.Ptr());
+  return &gSpinHistory[((address >> kObjectAlignmentShift) * 0x9e3779b1u) % kSpinHistorySize];
+}
+
+static const char* GetInflationCauseName(InflationCause cause) {
+  switch (cause) {
+    case InflationCause::kContention: return "contention";
+    case InflationCause::kOwnerNotRunnable: return "owner not runnable";
+    case InflationCause::kRecursionOverflow: return "recursion overflow";
+    case InflationCause::kHashCode: return "hash code";
+    case InflationCause::kWait: return "wait";
+  }
+  LOG(FATAL) << "Unexpected inflation cause " << static_cast<size_t>(cause);
+  UNREACHABLE();
+}
+
 /*
  * Every Object has a monitor associated with it, but not every Object is actually locked.  Even
  * the ones that are locked do not need a full-fledged monitor until a) there is actual contention
@@ -83,6 +111,8 @@ static constexpr uint64_t kLongWaitMs = 100 * kDebugThresholdFudgeFactor;
 
 uint32_t Monitor::lock_profiling_threshold_ = 0;
 uint32_t Monitor::stack_dump_lock_profiling_threshold_ = 0;
+std::atomic<uint64_t> Monitor::inflation_counts_[static_cast<size_t>(InflationCause::kLast) + 1];
+std::atomic<uint64_t> Monitor::spin_acquisition_count_(0u);
 
 void Monitor::Init(uint32_t lock_profiling_threshold,
                    uint32_t stack_dump_lock_profiling_threshold) {
@@ -1033,7 +1063,11 @@ bool Monitor::Deflate(Thread* self, ObjPtr<mirror::Object> obj) {
   return true;
 }
 
-void Monitor::Inflate(Thread* self, Thread* owner, ObjPtr<mirror::Object> obj, int32_t hash_code) {
+void Monitor::Inflate(Thread* self,
+                      Thread* owner,
+                      ObjPtr<mirror::Object> obj,
+                      int32_t hash_code,
+                      InflationCause cause) {
   DCHECK(self != nullptr);
   DCHECK(obj != nullptr);
   // Allocate and acquire a new monitor.
@@ -1048,19 +1082,23 @@ void Monitor::Inflate(Thread* self, Thread* owner, ObjPtr<mirror::Object> obj, i
           << " created monitor " << m << " for object " << obj;
     }
     Runtime::Current()->GetMonitorList()->Add(m);
+    inflation_counts_[static_cast<size_t>(cause)].fetch_add(1u, std::memory_order_relaxed);
     CHECK_EQ(obj->GetLockWord(true).GetState(), LockWord::kFatLocked);
   } else {
     MonitorPool::ReleaseMonitor(self, m);
   }
 }
 
-void Monitor::InflateThinLocked(Thread* self, Handle<mirror::Object> obj, LockWord lock_word,
-                                uint32_t hash_code) {
+void Monitor::InflateThinLocked(Thread* self,
+                                Handle<mirror::Object> obj,
+                                LockWord lock_word,
+                                uint32_t hash_code,
+                                InflationCause cause) {
   DCHECK_EQ(lock_word.GetState(), LockWord::kThinLocked);
   uint32_t owner_thread_id = lock_word.ThinLockOwner();
   if (owner_thread_id == self->GetThreadId()) {
     // We own the monitor, we can easily inflate it.
-    Inflate(self, self, obj.Get(), hash_code);
+    Inflate(self, self, obj.Get(), hash_code, cause);
   } else {
     ThreadList* thread_list = Runtime::Current()->GetThreadList();
     // Suspend the owner, inflate. First change to blocked and give up mutator_lock_.
@@ -1079,7 +1117,7 @@ void Monitor::InflateThinLocked(Thread* self, Handle<mirror::Object> obj, LockWo
       if (lock_word.GetState() == LockWord::kThinLocked &&
           lock_word.ThinLockOwner() == owner_thread_id) {
         // Go ahead and inflate the lock.
-        Inflate(self, owner, obj.Get(), hash_code);
+        Inflate(self, owner, obj.Get(), hash_code, cause);
       }
       bool resumed = thread_list->Resume(owner, SuspendReason::kInternal);
       DCHECK(resumed);
@@ -1088,6 +1126,24 @@ void Monitor::InflateThinLocked(Thread* self, Handle<mirror::Object> obj, LockWo
   }
 }
 
+bool Monitor::IsThinLockOwnerRunnable(Thread* self, uint32_t owner_thread_id) {
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  Thread* owner = Runtime::Current()->GetThreadList()->FindThreadByThreadId(owner_thread_id);
+  // A missing owner is exiting; let the caller retry rather than inflate.
+  return owner == nullptr || owner->GetState() == ThreadState::kRunnable;
+}
+
+void Monitor::DumpInflationStats(std::ostream& os) {
+  os << "Thin lock spin acquisitions: " << GetSpinAcquisitionCount() << "\n";
+  for (size_t i = 0; i <= static_cast<size_t>(InflationCause::kLast); ++i) {
+    InflationCause cause = static_cast<InflationCause>(i);
+    uint64_t count = GetInflationCount(cause);
+    if (count != 0u) {
+      os << "Number of " << GetInflationCauseName(cause) << " lock inflations: " << count << "\n";
+    }
+  }
+}
+
 // Fool annotalysis into thinking that the lock on obj is acquired.
 static ObjPtr<mirror::Object> FakeLock(ObjPtr<mirror::Object> obj)
     EXCLUSIVE_LOCK_FUNCTION(obj.Ptr()) NO_THREAD_SAFETY_ANALYSIS {
@@ -1110,6 +1166,8 @@ ObjPtr<mirror::Object> Monitor::MonitorEnter(Thread* self,
   uint32_t thread_id = self->GetThreadId();
   size_t contention_count = 0;
   constexpr size_t kExtraSpinIters = 100;
+  // Spin history entry of a contended lock, only used for adaptive spinning.
+  std::atomic<uint8_t>* spin_history = nullptr;
   StackHandleScope<1> hs(self);
   Handle<mirror::Object> h_obj(hs.NewHandle(obj));
   while (true) {
@@ -1122,6 +1180,15 @@ ObjPtr<mirror::Object> Monitor::MonitorEnter(Thread* self,
         // No ordering required for preceding lockword read, since we retest.
         LockWord thin_locked(LockWord::FromThinLockId(thread_id, 0, lock_word.GCState()));
         if (h_obj->CasLockWord(lock_word, thin_locked, CASMode::kWeak, std::memory_order_acquire)) {
+          if (contention_count != 0) {
+            spin_acquisition_count_.fetch_add(1u, std::memory_order_relaxed);
+            if (spin_history != nullptr) {
+              uint8_t shift = spin_history->load(std::memory_order_relaxed);
+              if (shift != 0u) {
+                spin_history->store(shift - 1u, std::memory_order_relaxed);
+              }
+            }
+          }
           AtraceMonitorLock(self, h_obj.Get(), /* is_wait= */ false);
           return h_obj.Get();  // Success!
         }
@@ -1156,7 +1223,7 @@ ObjPtr<mirror::Object> Monitor::MonitorEnter(Thread* self,
             continue;  // Go again.
           } else {
             // We'd overflow the recursion count, so inflate the monitor.
-            InflateThinLocked(self, h_obj, lock_word, 0);
+            InflateThinLocked(self, h_obj, lock_word, 0, InflationCause::kRecursionOverflow);
           }
         } else {
           if (trylock) {
@@ -1165,8 +1232,23 @@ ObjPtr<mirror::Object> Monitor::MonitorEnter(Thread* self,
           // Contention.
           contention_count++;
           Runtime* runtime = Runtime::Current();
-          if (contention_count
-              <= kExtraSpinIters + runtime->GetMaxSpinsBeforeThinLockInflation()) {
+          size_t max_contention_count =
+              kExtraSpinIters + runtime->GetMaxSpinsBeforeThinLockInflation();
+          if (runtime->UseAdaptiveThinLockSpinning()) {
+            // Spinning only pays off while the owner is running. If it is blocked, suspended
+            // or in native code, inflate right away instead of burning the whole budget.
+            if (contention_count % kOwnerCheckInterval == 0u &&
+                !IsThinLockOwnerRunnable(self, owner_thread_id)) {
+              contention_count = 0;
+              InflateThinLocked(self, h_obj, lock_word, 0, InflationCause::kOwnerNotRunnable);
+              continue;  // Start from the beginning.
+            }
+            if (spin_history == nullptr) {
+              spin_history = GetSpinHistoryEntry(h_obj.Get());
+            }
+            max_contention_count >>= spin_history->load(std::memory_order_relaxed);
+          }
+          if (contention_count <= max_contention_count) {
             // TODO: Consider switching the thread state to kWaitingForLockInflation when we are
             // yielding.  Use sched_yield instead of NanoSleep since NanoSleep can wait much longer
             // than the parameter you pass in. This can cause thread suspension to take excessively
@@ -1176,8 +1258,15 @@ ObjPtr<mirror::Object> Monitor::MonitorEnter(Thread* self,
             }
           } else {
             contention_count = 0;
+            if (spin_history != nullptr) {
+              // Spinning did not work out for this lock, spin less next time.
+              uint8_t shift = spin_history->load(std::memory_order_relaxed);
+              if (shift < kMaxSpinBudgetShift) {
+                spin_history->store(shift + 1u, std::memory_order_relaxed);
+              }
+            }
             // No ordering required for initial lockword read. Install rereads it anyway.
-            InflateThinLocked(self, h_obj, lock_word, 0);
+            InflateThinLocked(self, h_obj, lock_word, 0, InflationCause::kContention);
           }
         }
         continue;  // Start from the beginning.
@@ -1199,7 +1288,7 @@ ObjPtr<mirror::Object> Monitor::MonitorEnter(Thread* self,
         // Inflate with the existing hashcode.
         // Again no ordering required for initial lockword read, since we don't rely
         // on the visibility of any prior computation.
-        Inflate(self, nullptr, h_obj.Get(), lock_word.GetHashCode());
+        Inflate(self, nullptr, h_obj.Get(), lock_word.GetHashCode(), InflationCause::kHashCode);
         continue;  // Start from the beginning.
       default: {
         LOG(FATAL) << "Invalid monitor state " << lock_word.GetState();
@@ -1305,7 +1394,7 @@ void Monitor::Wait(Thread* self,
         } else {
           // We own the lock, inflate to enqueue ourself on the Monitor. May fail spuriously so
           // re-load.
-          Inflate(self, self, h_obj.Get(), 0);
+          Inflate(self, self, h_obj.Get(), 0, InflationCause::kWait);
           lock_word = h_obj->GetLockWord(true);
         }
         break;
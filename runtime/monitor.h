@@ -55,6 +55,16 @@ enum class LockReason {
   kForLock,
 };
 
+// Why a thin lock was inflated to a fat lock.
+enum class InflationCause : uint8_t {
+  kContention,         // Spinning on a lock held by a running thread did not acquire it.
+  kOwnerNotRunnable,   // The owner was not runnable, so spinning could not succeed.
+  kRecursionOverflow,  // The thin lock recursion count overflowed.
+  kHashCode,           // An identity hash code was requested for a locked object.
+  kWait,               // Object.wait() requires a wait set.
+  kLast = kWait,
+};
+
 class Monitor {
  public:
   // The default number of spins that are done before thread suspension is used to forcibly inflate
@@ -131,6 +141,19 @@ class Monitor {
 
   static bool IsValidLockWord(LockWord lock_word);
 
+  // Number of successful inflations for the given cause since the runtime started.
+  static uint64_t GetInflationCount(InflationCause cause) {
+    return inflation_counts_[static_cast<size_t>(cause)].load(std::memory_order_relaxed);
+  }
+
+  // Number of contended thin lock acquisitions that succeeded by spinning without inflating.
+  static uint64_t GetSpinAcquisitionCount() {
+    return spin_acquisition_count_.load(std::memory_order_relaxed);
+  }
+
+  // Dump inflation and spinning statistics, used for SIGQUIT.
+  static void DumpInflationStats(std::ostream& os);
+
   template<ReadBarrierOption kReadBarrierOption = kWithReadBarrier>
   ObjPtr<mirror::Object> GetObject() REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -155,8 +178,11 @@ class Monitor {
   }
 
   // Inflate the lock on obj. May fail to inflate for spurious reasons, always re-check.
-  static void InflateThinLocked(Thread* self, Handle<mirror::Object> obj, LockWord lock_word,
-                                uint32_t hash_code) REQUIRES_SHARED(Locks::mutator_lock_);
+  static void InflateThinLocked(Thread* self,
+                                Handle<mirror::Object> obj,
+                                LockWord lock_word,
+                                uint32_t hash_code,
+                                InflationCause cause) REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Not exclusive because ImageWriter calls this during a Heap::VisitObjects() that
   // does not allow a thread suspension in the middle. TODO: maybe make this exclusive.
@@ -207,10 +233,21 @@ class Monitor {
   // calling thread must own the lock or the owner must be suspended. There's a race with other
   // threads inflating the lock, installing hash codes and spurious failures. The caller should
   // re-read the lock word following the call.
-  static void Inflate(Thread* self, Thread* owner, ObjPtr<mirror::Object> obj, int32_t hash_code)
+  static void Inflate(Thread* self,
+                      Thread* owner,
+                      ObjPtr<mirror::Object> obj,
+                      int32_t hash_code,
+                      InflationCause cause)
       REQUIRES_SHARED(Locks::mutator_lock_)
       NO_THREAD_SAFETY_ANALYSIS;  // For m->Install(self)
 
+  // Returns whether the thread with the given thin lock id is currently runnable. A thread that
+  // is suspended, blocked or in native code will not release a thin lock soon, so there is no
+  // point spinning on it.
+  static bool IsThinLockOwnerRunnable(Thread* self, uint32_t owner_thread_id)
+      REQUIRES(!Locks::thread_list_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void LogContentionEvent(Thread* self,
                           uint32_t wait_ms,
                           uint32_t sample_percent,
@@ -314,6 +351,9 @@ class Monitor {
   static uint32_t stack_dump_lock_profiling_threshold_;
   static bool capture_method_eagerly_;
 
+  static std::atomic<uint64_t> inflation_counts_[static_cast<size_t>(InflationCause::kLast) + 1];
+  static std::atomic<uint64_t> spin_acquisition_count_;
+
   // Holding the monitor N times is represented by holding monitor_lock_ N times.
   Mutex monitor_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
@@ -16,6 +16,9 @@
 
 #include "monitor.h"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -391,5 +394,142 @@ TEST_F(MonitorTest, TestTryLock) {
   thread_pool.StopWorkers(self);
 }
 
+class LockTask : public Task {
+ public:
+  LockTask(jobject obj, size_t iterations, uint64_t hold_us, bool hold_suspended)
+      : obj_(obj), iterations_(iterations), hold_us_(hold_us), hold_suspended_(hold_suspended) {}
+
+  void Run(Thread* self) override {
+    ScopedObjectAccess soa(self);
+    StackHandleScope<1u> hs(self);
+    Handle<mirror::Object> obj = hs.NewHandle(soa.Decode<mirror::Object>(obj_));
+    for (size_t i = 0; i != iterations_; ++i) {
+      ObjectLock<mirror::Object> lock(self, obj);
+      if (hold_suspended_) {
+        // Model an owner blocked in the critical section, e.g. on I/O.
+        ScopedThreadSuspension sts(self, ThreadState::kSleeping);
+        usleep(hold_us_);
+      } else {
+        uint64_t end = NanoTime() + hold_us_ * 1000u;
+        while (NanoTime() < end) {
+          // Busy critical section, the owner stays runnable.
+        }
+      }
+    }
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  jobject obj_;
+  const size_t iterations_;
+  const uint64_t hold_us_;
+  const bool hold_suspended_;
+};
+
+// With adaptive spinning, a thread contending for a thin lock whose owner is not runnable should
+// inflate the lock instead of spinning.
+TEST_F(MonitorTest, AdaptiveSpinningInflatesForSuspendedOwner) {
+  Runtime* runtime = Runtime::Current();
+  bool old_adaptive = runtime->UseAdaptiveThinLockSpinning();
+  runtime->SetAdaptiveThinLockSpinning(true);
+
+  Thread* const self = Thread::Current();
+  ThreadPool thread_pool("Monitor test thread pool", 1);
+  ScopedObjectAccess soa(self);
+  StackHandleScope<1> hs(self);
+  Handle<mirror::Object> obj(
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "hello, world!")));
+  jobject g_obj = soa.Vm()->AddGlobalRef(self, obj.Get());
+  ASSERT_TRUE(g_obj != nullptr);
+  uint64_t old_count = Monitor::GetInflationCount(InflationCause::kOwnerNotRunnable);
+  {
+    ObjectLock<mirror::Object> lock(self, obj);
+    EXPECT_EQ(obj->GetLockWord(true).GetState(), LockWord::kThinLocked);
+    thread_pool.AddTask(self, new LockTask(g_obj, 1u, 0u, false));
+    thread_pool.StartWorkers(self);
+    ScopedThreadSuspension sts(self, ThreadState::kSleeping);
+    // The contending thread inflates the lock as soon as it notices we are not runnable.
+    uint64_t deadline = MilliTime() + 10000u;
+    while (Monitor::GetInflationCount(InflationCause::kOwnerNotRunnable) == old_count &&
+           MilliTime() < deadline) {
+      usleep(1000);
+    }
+  }
+  EXPECT_GT(Monitor::GetInflationCount(InflationCause::kOwnerNotRunnable), old_count);
+  EXPECT_EQ(obj->GetLockWord(true).GetState(), LockWord::kFatLocked);
+  {
+    ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+    thread_pool.Wait(self, /*do_work=*/false, /*may_hold_locks=*/false);
+  }
+  thread_pool.StopWorkers(self);
+  soa.Vm()->DeleteGlobalRef(self, g_obj);
+  runtime->SetAdaptiveThinLockSpinning(old_adaptive);
+}
+
+// Compare fixed and adaptive thin lock spinning for short and long critical sections. This is a
+// benchmark rather than a test, results are only logged.
+TEST_F(MonitorTest, ContentionBenchmark) {
+  static constexpr size_t kNumThreads = 4u;
+  static constexpr size_t kIterations = 200u;
+  struct Config {
+    const char* name;
+    uint64_t hold_us;
+    bool hold_suspended;
+  };
+  static constexpr Config kConfigs[] = {
+      {"short", 1u, false},
+      {"long", 200u, false},
+      {"long suspended", 200u, true},
+  };
+
+  Runtime* runtime = Runtime::Current();
+  bool old_adaptive = runtime->UseAdaptiveThinLockSpinning();
+  Thread* const self = Thread::Current();
+  ThreadPool thread_pool("Monitor benchmark thread pool", kNumThreads);
+  ScopedObjectAccess soa(self);
+  thread_pool.StartWorkers(self);
+  for (const Config& config : kConfigs) {
+    for (bool adaptive : {false, true}) {
+      runtime->SetAdaptiveThinLockSpinning(adaptive);
+      // Use a fresh object for each run, inflated locks stay inflated.
+      jobject g_obj =
+          soa.Vm()->AddGlobalRef(self, mirror::String::AllocFromModifiedUtf8(self, "lock"));
+      ASSERT_TRUE(g_obj != nullptr);
+      uint64_t inflations = 0u;
+      for (size_t i = 0; i <= static_cast<size_t>(InflationCause::kLast); ++i) {
+        inflations -= Monitor::GetInflationCount(static_cast<InflationCause>(i));
+      }
+      uint64_t spin_acquisitions = Monitor::GetSpinAcquisitionCount();
+      uint64_t start = NanoTime();
+      for (size_t i = 0; i != kNumThreads; ++i) {
+        thread_pool.AddTask(
+            self, new LockTask(g_obj, kIterations, config.hold_us, config.hold_suspended));
+      }
+      {
+        ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+        thread_pool.Wait(self, /*do_work=*/false, /*may_hold_locks=*/false);
+      }
+      uint64_t duration = NanoTime() - start;
+      for (size_t i = 0; i <= static_cast<size_t>(InflationCause::kLast); ++i) {
+        inflations += Monitor::GetInflationCount(static_cast<InflationCause>(i));
+      }
+      spin_acquisitions = Monitor::GetSpinAcquisitionCount() - spin_acquisitions;
+      uint64_t acquisitions_per_second =
+          (kNumThreads * kIterations * UINT64_C(1000000000)) / std::max<uint64_t>(duration, 1u);
+      LOG(INFO) << config.name << " critical section, "
+                << (adaptive ? "adaptive" : "fixed") << " spinning: "
+                << PrettyDuration(duration) << ", "
+                << acquisitions_per_second
+                << " acquisitions/s, " << spin_acquisitions << " spin acquisitions, "
+                << inflations << " inflations";
+      soa.Vm()->DeleteGlobalRef(self, g_obj);
+    }
+  }
+  thread_pool.StopWorkers(self);
+  runtime->SetAdaptiveThinLockSpinning(old_adaptive);
+}
 
 }  // namespace art
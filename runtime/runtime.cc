@@ -253,6 +253,7 @@ Runtime::Runtime()
       default_stack_size_(0),
       heap_(nullptr),
       max_spins_before_thin_lock_inflation_(Monitor::kDefaultMaxSpinsBeforeThinLockInflation),
+      adaptive_thin_lock_spinning_(false),
       monitor_list_(nullptr),
       monitor_pool_(nullptr),
       thread_list_(nullptr),
@@ -301,6 +302,7 @@ Runtime::Runtime()
       madvise_willneed_total_dex_size_(0),
       madvise_willneed_odex_filesize_(0),
       madvise_willneed_art_filesize_(0),
+      lazy_app_image_decompression_(false),
       safe_mode_(false),
       hidden_api_policy_(hiddenapi::EnforcementPolicy::kDisabled),
       core_platform_api_policy_(hiddenapi::EnforcementPolicy::kDisabled),
@@ -1531,6 +1533,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   finalizer_timeout_ms_ = runtime_options.GetOrDefault(Opt::FinalizerTimeoutMs);
   max_spins_before_thin_lock_inflation_ =
       runtime_options.GetOrDefault(Opt::MaxSpinsBeforeThinLockInflation);
+  adaptive_thin_lock_spinning_ = runtime_options.GetOrDefault(Opt::AdaptiveThinLockSpinning);
 
   monitor_list_ = new MonitorList;
   monitor_pool_ = MonitorPool::Create();
@@ -1588,6 +1591,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   madvise_willneed_total_dex_size_ = runtime_options.GetOrDefault(Opt::MadviseWillNeedVdexFileSize);
   madvise_willneed_odex_filesize_ = runtime_options.GetOrDefault(Opt::MadviseWillNeedOdexFileSize);
   madvise_willneed_art_filesize_ = runtime_options.GetOrDefault(Opt::MadviseWillNeedArtFileSize);
+  lazy_app_image_decompression_ = runtime_options.GetOrDefault(Opt::LazyAppImageDecompression);
 
   jni_ids_indirection_ = runtime_options.GetOrDefault(Opt::OpaqueJniIds);
   automatically_set_jni_ids_indirection_ =
@@ -1654,6 +1658,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
                        runtime_options.Exists(Opt::IgnoreMaxFootprint),
                        runtime_options.GetOrDefault(Opt::AlwaysLogExplicitGcs),
                        runtime_options.GetOrDefault(Opt::UseTLAB),
+                       runtime_options.GetOrDefault(Opt::AdaptiveTlabSizing),
                        xgc_option.verify_pre_gc_heap_,
                        xgc_option.verify_pre_sweeping_heap_,
                        xgc_option.verify_post_gc_heap_,
@@ -1664,6 +1669,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
                        xgc_option.measure_,
                        runtime_options.GetOrDefault(Opt::EnableHSpaceCompactForOOM),
                        use_generational_cc,
+                       xgc_option.generational_cmc,
                        runtime_options.GetOrDefault(Opt::HSpaceCompactForOOMMinIntervalsMs),
                        runtime_options.Exists(Opt::DumpRegionInfoBeforeGC),
                        runtime_options.Exists(Opt::DumpRegionInfoAfterGC));
@@ -1917,9 +1923,13 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
     trace_config_->trace_file = runtime_options.ReleaseOrDefault(Opt::MethodTraceFile);
     trace_config_->trace_file_size = runtime_options.ReleaseOrDefault(Opt::MethodTraceFileSize);
     trace_config_->trace_mode = Trace::TraceMode::kMethodTracing;
-    trace_config_->trace_output_mode = runtime_options.Exists(Opt::MethodTraceStreaming) ?
-        Trace::TraceOutputMode::kStreaming :
-        Trace::TraceOutputMode::kFile;
+    if (runtime_options.Exists(Opt::MethodTraceStreamingCompressed)) {
+      trace_config_->trace_output_mode = Trace::TraceOutputMode::kStreamingCompressed;
+    } else if (runtime_options.Exists(Opt::MethodTraceStreaming)) {
+      trace_config_->trace_output_mode = Trace::TraceOutputMode::kStreaming;
+    } else {
+      trace_config_->trace_output_mode = Trace::TraceOutputMode::kFile;
+    }
     trace_config_->clock_source = runtime_options.GetOrDefault(Opt::MethodTraceClock);
   }
 
@@ -2332,6 +2342,7 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
     os << "Running non JIT\n";
   }
   DumpDeoptimizations(os);
+  Monitor::DumpInflationStats(os);
   TrackedAllocators::Dump(os);
   GetMetrics()->DumpForSigQuit(os);
   os << "\n";
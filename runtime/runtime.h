@@ -406,6 +406,15 @@ class Runtime {
     return max_spins_before_thin_lock_inflation_;
   }
 
+  bool UseAdaptiveThinLockSpinning() const {
+    return adaptive_thin_lock_spinning_;
+  }
+
+  // For testing purpose only.
+  void SetAdaptiveThinLockSpinning(bool value) {
+    adaptive_thin_lock_spinning_ = value;
+  }
+
   MonitorList* GetMonitorList() const {
     return monitor_list_;
   }
@@ -1016,6 +1025,10 @@ class Runtime {
     return madvise_willneed_art_filesize_;
   }
 
+  bool IsLazyAppImageDecompressionEnabled() const {
+    return lazy_app_image_decompression_;
+  }
+
   const std::string& GetJdwpOptions() {
     return jdwp_options_;
   }
@@ -1308,6 +1321,8 @@ class Runtime {
 
   // The number of spins that are done before thread suspension is used to forcibly inflate.
   size_t max_spins_before_thin_lock_inflation_;
+  // Whether thin lock spinning takes the owner's state and the lock's history into account.
+  bool adaptive_thin_lock_spinning_;
   MonitorList* monitor_list_;
   MonitorPool* monitor_pool_;
 
@@ -1482,6 +1497,9 @@ class Runtime {
   // A 0 for this will turn off madvising to MADV_WILLNEED
   size_t madvise_willneed_art_filesize_;
 
+  // Whether compressed app images are decompressed on first access to their pages.
+  bool lazy_app_image_decompression_;
+
   // Whether the application should run in safe mode, that is, interpreter only.
   bool safe_mode_;
 
@@ -2569,12 +2569,16 @@ void Thread::Destroy(bool should_run_callbacks) {
     }
   }
 
+  if (UNLIKELY(self->GetMethodTraceBuffer() != nullptr)) {
+    // Also done for threads without a peer: in compressed streaming mode the buffer is shared
+    // with the tracing flusher thread and must be handed back before it is freed.
+    ScopedObjectAccess soa(self);
+    Trace::FlushThreadBuffer(self);
+    self->ResetMethodTraceBuffer();
+  }
+
   if (tlsPtr_.opeer != nullptr) {
     ScopedObjectAccess soa(self);
-    if (UNLIKELY(self->GetMethodTraceBuffer() != nullptr)) {
-      Trace::FlushThreadBuffer(self);
-      self->ResetMethodTraceBuffer();
-    }
     // We may need to call user-supplied managed code, do this before final clean-up.
     HandleUncaughtExceptions();
     RemoveFromThreadGroup();
@@ -4599,6 +4603,9 @@ void Thread::ResetTlab() {
                << " adjustment = "
                << (tlsPtr_.thread_local_pos - tlsPtr_.thread_local_start);
   }
+  if (tlsPtr_.thread_local_pos != nullptr) {
+    heap->RetireTlab(this);
+  }
   SetTlab(nullptr, nullptr, nullptr);
 }
 
@@ -86,6 +86,7 @@ class MethodVerifier;
 class VerifierDeps;
 }  // namespace verifier
 
+class ArenaStack;
 class ArtMethod;
 class BaseMutex;
 class ClassLinker;
@@ -1203,6 +1204,18 @@ class Thread {
     tlsPtr_.deps_or_stack_trace_sample.verifier_deps = verifier_deps;
   }
 
+  ArenaStack* GetVerifierArenaStack() const {
+    return verifier_arena_stack_;
+  }
+
+  // Method verifiers on this thread allocate from the given arena stack instead of a private one,
+  // so that arenas are reused across methods and classes. It is the responsibility of the caller
+  // to clear it before destroying the arena stack.
+  void SetVerifierArenaStack(ArenaStack* arena_stack) {
+    DCHECK(arena_stack == nullptr || verifier_arena_stack_ == nullptr);
+    verifier_arena_stack_ = arena_stack;
+  }
+
   uintptr_t* GetMethodTraceBuffer() { return tlsPtr_.method_trace_buffer; }
 
   size_t* GetMethodTraceIndexPtr() { return &tlsPtr_.method_trace_buffer_index; }
@@ -1328,6 +1341,21 @@ class Thread {
     return tlsPtr_.thread_local_objects;
   }
 
+  // State for sizing this thread's TLABs according to its allocation rate, see
+  // Heap::GetAdaptiveTlabSize(). Only accessed by whoever may reset the TLAB.
+  struct TlabSizing {
+    // The GC number (see Heap::GetCurrentGcNum()) the byte count below refers to.
+    uint32_t gc_num = 0;
+    // TLAB bytes used by objects since that GC.
+    size_t bytes_used = 0;
+    // The size of the next TLAB, or 0 if the allocation rate is not known yet.
+    size_t desired_size = 0;
+  };
+
+  TlabSizing* GetTlabSizing() {
+    return &tlab_sizing_;
+  }
+
   void* GetRosAllocRun(size_t index) const {
     return tlsPtr_.rosalloc_runs[index];
   }
@@ -2165,6 +2193,13 @@ class Thread {
   // the caller is allowed to access all fields and methods in the Core Platform API.
   uint32_t core_platform_api_cookie_ = 0;
 
+  // Arena stack shared by the method verifiers running on this thread, see
+  // SetVerifierArenaStack(). Not owned.
+  ArenaStack* verifier_arena_stack_ = nullptr;
+
+  // Adaptive TLAB sizing state, see GetTlabSizing().
+  TlabSizing tlab_sizing_;
+
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
   friend class QuickExceptionHandler;  // For dumping the stack.
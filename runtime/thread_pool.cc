@@ -40,16 +40,113 @@ using android::base::StringPrintf;
 
 static constexpr bool kMeasureWaitTime = false;
 
+// Capacity of the per-worker deques used in work stealing mode. Tasks added by a worker whose
+// deque is full go to the shared queue.
+static constexpr size_t kWorkStealingDequeCapacity = 1024u;
+
+// The worker running on the current thread, if any.
+static thread_local ThreadPoolWorker* current_worker = nullptr;
+
+// A bounded Chase-Lev deque. The owning worker pushes and pops at the bottom without any atomic
+// read-modify-write in the common case, other threads steal from the top with a CAS.
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque() : top_(0), bottom_(0) {
+    for (std::atomic<Task*>& slot : buffer_) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // Only called by the owner. Returns false if the deque is full.
+  bool Push(Task* task) {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(kWorkStealingDequeCapacity)) {
+      return false;
+    }
+    buffer_[bottom & kMask].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Only called by the owner. Returns the most recently pushed task, or null.
+  Task* Pop() {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      // Empty.
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Task* task = buffer_[bottom & kMask].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last task, race against thieves.
+      if (!top_.compare_exchange_strong(top,
+                                        top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        task = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // Called by any thread. Returns the oldest task, or null if the deque is empty or if we lost
+  // a race with the owner or another thief.
+  Task* Steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    Task* task = buffer_[top & kMask].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top,
+                                      top + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+  bool IsEmpty() const {
+    return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static_assert(IsPowerOfTwo(kWorkStealingDequeCapacity), "Capacity must be a power of two");
+  static constexpr int64_t kMask = static_cast<int64_t>(kWorkStealingDequeCapacity) - 1;
+  static constexpr size_t kIndexAlignment = 64u;
+
+  // Keep the index the thieves fight over apart from the one only the owner writes.
+  alignas(kIndexAlignment) std::atomic<int64_t> top_;
+  alignas(kIndexAlignment) std::atomic<int64_t> bottom_;
+  std::atomic<Task*> buffer_[kWorkStealingDequeCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
 #if defined(__BIONIC__)
 static constexpr bool kUseCustomThreadPoolStack = false;
 #else
 static constexpr bool kUseCustomThreadPoolStack = true;
 #endif
 
-ThreadPoolWorker::ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name,
-                                   size_t stack_size)
+ThreadPoolWorker::ThreadPoolWorker(ThreadPool* thread_pool,
+                                   const std::string& name,
+                                   size_t stack_size,
+                                   size_t index)
     : thread_pool_(thread_pool),
-      name_(name) {
+      name_(name),
+      index_(index) {
+  if (thread_pool->IsWorkStealing()) {
+    local_tasks_.reset(new WorkStealingDeque());
+  }
   std::string error_msg;
   // On Bionic, we know pthreads will give us a big-enough stack with
   // a guard page, so don't do anything special on Bionic libc.
@@ -83,6 +180,11 @@ ThreadPoolWorker::ThreadPoolWorker(ThreadPool* thread_pool, const std::string& n
 
 ThreadPoolWorker::~ThreadPoolWorker() {
   CHECK_PTHREAD_CALL(pthread_join, (pthread_, nullptr), "thread pool worker shutdown");
+  DCHECK(local_tasks_ == nullptr || local_tasks_->IsEmpty());
+}
+
+ThreadPoolWorker* ThreadPoolWorker::Current() {
+  return current_worker;
 }
 
 void ThreadPoolWorker::SetPthreadPriority(int priority) {
@@ -110,7 +212,11 @@ void ThreadPoolWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = nullptr;
   thread_pool_->creation_barier_.Pass(self);
-  while ((task = thread_pool_->GetTask(self)) != nullptr) {
+  auto get_task = [&]() {
+    return (local_tasks_ != nullptr) ? thread_pool_->GetTaskWorkStealing(self, this)
+                                     : thread_pool_->GetTask(self);
+  };
+  while ((task = get_task()) != nullptr) {
     task->Run(self);
     task->Finalize();
   }
@@ -140,13 +246,18 @@ void* ThreadPoolWorker::Callback(void* arg) {
   worker->thread_ = Thread::Current();
   // Mark thread pool workers as runtime-threads.
   worker->thread_->SetIsRuntimeThread(true);
+  current_worker = worker;
   // Do work until its time to shut down.
   worker->Run();
+  current_worker = nullptr;
   runtime->DetachCurrentThread(/* should_run_callbacks= */ false);
   return nullptr;
 }
 
 void ThreadPool::AddTask(Thread* self, Task* task) {
+  if (work_stealing_ && TryAddLocalTask(self, task)) {
+    return;
+  }
   MutexLock mu(self, task_queue_lock_);
   tasks_.push_back(task);
   // If we have any waiters, signal one.
@@ -162,14 +273,64 @@ void ThreadPool::RemoveAllTasks(Thread* self) {
   while ((task = TryGetTask(self)) != nullptr) {
     task->Finalize();
   }
+  // Tasks left in worker deques. Only safe once the workers are no longer running tasks.
+  for (ThreadPoolWorker* worker : threads_) {
+    if (worker->local_tasks_ != nullptr) {
+      while ((task = worker->local_tasks_->Steal()) != nullptr) {
+        pending_local_tasks_.fetch_sub(1u, std::memory_order_seq_cst);
+        task->Finalize();
+      }
+    }
+  }
   MutexLock mu(self, task_queue_lock_);
   tasks_.clear();
 }
 
+bool ThreadPool::TryAddLocalTask(Thread* self, Task* task) {
+  ThreadPoolWorker* worker = ThreadPoolWorker::Current();
+  if (worker == nullptr || worker->thread_pool_ != this) {
+    return false;
+  }
+  DCHECK_EQ(worker->GetThread(), self);
+  // Count the task before publishing it so that a worker about to go to sleep either sees the
+  // task or is seen by us below.
+  pending_local_tasks_.fetch_add(1u, std::memory_order_seq_cst);
+  if (!worker->local_tasks_->Push(task)) {
+    pending_local_tasks_.fetch_sub(1u, std::memory_order_seq_cst);
+    return false;
+  }
+  if (sleeping_workers_.load(std::memory_order_seq_cst) != 0u) {
+    MutexLock mu(self, task_queue_lock_);
+    if (started_ && waiting_count_ != 0) {
+      task_queue_condition_.Signal(self);
+    }
+  }
+  return true;
+}
+
+Task* ThreadPool::TryStealTask(ThreadPoolWorker* thief) {
+  const size_t thread_count = GetThreadCount();
+  const size_t start = (thief != nullptr) ? thief->index_ + 1u : 0u;
+  for (size_t i = 0; i != thread_count; ++i) {
+    ThreadPoolWorker* victim = threads_[(start + i) % thread_count];
+    if (victim == thief) {
+      continue;
+    }
+    Task* task = victim->local_tasks_->Steal();
+    if (task != nullptr) {
+      pending_local_tasks_.fetch_sub(1u, std::memory_order_seq_cst);
+      stolen_task_count_.fetch_add(1u, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
 ThreadPool::ThreadPool(const char* name,
                        size_t num_threads,
                        bool create_peers,
-                       size_t worker_stack_size)
+                       size_t worker_stack_size,
+                       bool work_stealing)
   : name_(name),
     task_queue_lock_("task queue lock", kGenericBottomLock),
     task_queue_condition_("task queue condition", task_queue_lock_),
@@ -182,7 +343,11 @@ ThreadPool::ThreadPool(const char* name,
     creation_barier_(0),
     max_active_workers_(num_threads),
     create_peers_(create_peers),
-    worker_stack_size_(worker_stack_size) {
+    worker_stack_size_(worker_stack_size),
+    work_stealing_(work_stealing),
+    pending_local_tasks_(0u),
+    sleeping_workers_(0u),
+    stolen_task_count_(0u) {
   CreateThreads();
 }
 
@@ -198,7 +363,7 @@ void ThreadPool::CreateThreads() {
       const std::string worker_name = StringPrintf("%s worker thread %zu", name_.c_str(),
                                                    GetThreadCount());
       threads_.push_back(
-          new ThreadPoolWorker(this, worker_name, worker_stack_size_));
+          new ThreadPoolWorker(this, worker_name, worker_stack_size_, GetThreadCount()));
     }
   }
 }
@@ -273,6 +438,7 @@ Task* ThreadPool::GetTask(Thread* self) {
     }
 
     ++waiting_count_;
+    sleeping_workers_.fetch_add(1u, std::memory_order_seq_cst);
     if (waiting_count_ == GetThreadCount() && !HasOutstandingTasks()) {
       // We may be done, lets broadcast to the completion condition.
       completion_condition_.Broadcast(self);
@@ -283,6 +449,7 @@ Task* ThreadPool::GetTask(Thread* self) {
       const uint64_t wait_end = NanoTime();
       total_wait_time_ += wait_end - std::max(wait_start, start_time_);
     }
+    sleeping_workers_.fetch_sub(1u, std::memory_order_seq_cst);
     --waiting_count_;
   }
 
@@ -290,9 +457,69 @@ Task* ThreadPool::GetTask(Thread* self) {
   return nullptr;
 }
 
+Task* ThreadPool::GetTaskWorkStealing(Thread* self, ThreadPoolWorker* worker) {
+  DCHECK(work_stealing_);
+  // A worker asking for a new task has just finished one, so it is allowed to keep running.
+  bool may_steal = true;
+  while (true) {
+    // Fast path without the lock: our own tasks first, then the other workers' tasks.
+    Task* task = worker->local_tasks_->Pop();
+    if (task != nullptr) {
+      pending_local_tasks_.fetch_sub(1u, std::memory_order_seq_cst);
+      return task;
+    }
+    if (may_steal) {
+      task = TryStealTask(worker);
+      if (task != nullptr) {
+        return task;
+      }
+    }
+
+    MutexLock mu(self, task_queue_lock_);
+    if (IsShuttingDown()) {
+      // We are shutting down, return null to tell the worker thread to stop looping.
+      return nullptr;
+    }
+    // Ensure that we don't use more threads than the maximum active workers.
+    // <= since self is considered an active worker.
+    may_steal = started_ && GetThreadCount() - waiting_count_ <= max_active_workers_;
+    if (may_steal) {
+      task = TryGetTaskLocked();
+      if (task != nullptr) {
+        return task;
+      }
+    }
+    ++waiting_count_;
+    sleeping_workers_.fetch_add(1u, std::memory_order_seq_cst);
+    // Pairs with the increment in TryAddLocalTask: either we see the pending task here, or the
+    // worker that added it sees us sleeping and signals the condition.
+    if (!may_steal || pending_local_tasks_.load(std::memory_order_seq_cst) == 0u) {
+      if (waiting_count_ == GetThreadCount() && !HasOutstandingTasks()) {
+        // We may be done, lets broadcast to the completion condition.
+        completion_condition_.Broadcast(self);
+      }
+      const uint64_t wait_start = kMeasureWaitTime ? NanoTime() : 0;
+      task_queue_condition_.Wait(self);
+      if (kMeasureWaitTime) {
+        const uint64_t wait_end = NanoTime();
+        total_wait_time_ += wait_end - std::max(wait_start, start_time_);
+      }
+    }
+    sleeping_workers_.fetch_sub(1u, std::memory_order_seq_cst);
+    --waiting_count_;
+    may_steal = started_ && GetThreadCount() - waiting_count_ <= max_active_workers_;
+  }
+}
+
 Task* ThreadPool::TryGetTask(Thread* self) {
-  MutexLock mu(self, task_queue_lock_);
-  return TryGetTaskLocked();
+  {
+    MutexLock mu(self, task_queue_lock_);
+    Task* task = TryGetTaskLocked();
+    if (task != nullptr || !work_stealing_ || !started_) {
+      return task;
+    }
+  }
+  return TryStealTask(ThreadPoolWorker::Current());
 }
 
 Task* ThreadPool::TryGetTaskLocked() {
@@ -326,7 +553,7 @@ void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
 
 size_t ThreadPool::GetTaskCount(Thread* self) {
   MutexLock mu(self, task_queue_lock_);
-  return tasks_.size();
+  return tasks_.size() + pending_local_tasks_.load(std::memory_order_relaxed);
 }
 
 void ThreadPool::SetPthreadPriority(int priority) {
@@ -17,8 +17,10 @@
 #ifndef ART_RUNTIME_THREAD_POOL_H_
 #define ART_RUNTIME_THREAD_POOL_H_
 
+#include <atomic>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "barrier.h"
@@ -28,6 +30,7 @@
 namespace art {
 
 class ThreadPool;
+class WorkStealingDeque;
 
 class Closure {
  public:
@@ -91,13 +94,24 @@ class ThreadPoolWorker {
 
   Thread* GetThread() const { return thread_; }
 
+  // Returns the worker of a thread pool running on the current thread, or null.
+  static ThreadPoolWorker* Current();
+
  protected:
-  ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name, size_t stack_size);
+  ThreadPoolWorker(ThreadPool* thread_pool,
+                   const std::string& name,
+                   size_t stack_size,
+                   size_t index = 0u);
   static void* Callback(void* arg) REQUIRES(!Locks::mutator_lock_);
   virtual void Run();
 
   ThreadPool* const thread_pool_;
   const std::string name_;
+  // Index of this worker in the thread pool, used to pick the first victim when stealing.
+  const size_t index_;
+  // Tasks added by this worker when the pool is in work stealing mode. Only the worker pushes
+  // and pops at the bottom, other threads steal from the top. Null if not work stealing.
+  std::unique_ptr<WorkStealingDeque> local_tasks_;
   MemMap stack_;
   pthread_t pthread_;
   Thread* thread_;
@@ -138,10 +152,16 @@ class ThreadPool {
   // If create_peers is true, all worker threads will have a Java peer object. Note that if the
   // pool is asked to do work on the current thread (see Wait), a peer may not be available. Wait
   // will conservatively abort if create_peers and do_work are true.
+  //
+  // If work_stealing is true, tasks added by a worker of this pool go to a deque owned by that
+  // worker instead of the shared queue, without taking the task queue lock. Workers run their own
+  // tasks in LIFO order and steal the oldest tasks of other workers when they run out of work, so
+  // tasks are not guaranteed to run in the order they were added.
   ThreadPool(const char* name,
              size_t num_threads,
              bool create_peers = false,
-             size_t worker_stack_size = ThreadPoolWorker::kDefaultStackSize);
+             size_t worker_stack_size = ThreadPoolWorker::kDefaultStackSize,
+             bool work_stealing = false);
   virtual ~ThreadPool();
 
   // Create the threads of this pool.
@@ -176,6 +196,15 @@ class ThreadPool {
   // Wait for workers to be created.
   void WaitForWorkersToBeCreated();
 
+  bool IsWorkStealing() const {
+    return work_stealing_;
+  }
+
+  // Returns the number of tasks that were taken from the deque of another worker.
+  uint64_t GetStolenTaskCount() const {
+    return stolen_task_count_.load(std::memory_order_relaxed);
+  }
+
  protected:
   // get a task to run, blocks if there are no tasks left
   virtual Task* GetTask(Thread* self) REQUIRES(!task_queue_lock_);
@@ -184,13 +213,25 @@ class ThreadPool {
   Task* TryGetTask(Thread* self) REQUIRES(!task_queue_lock_);
   Task* TryGetTaskLocked() REQUIRES(task_queue_lock_);
 
+  // Work stealing variant of GetTask, `worker` is the calling worker.
+  Task* GetTaskWorkStealing(Thread* self, ThreadPoolWorker* worker) REQUIRES(!task_queue_lock_);
+
+  // Try to push a task to the deque of the current worker. Returns false if the current thread
+  // is not a worker of this pool or if its deque is full.
+  bool TryAddLocalTask(Thread* self, Task* task) REQUIRES(!task_queue_lock_);
+
+  // Try to steal a task from the deque of a worker other than `thief` (which may be null when
+  // the caller is not a worker of this pool).
+  Task* TryStealTask(ThreadPoolWorker* thief);
+
   // Are we shutting down?
   bool IsShuttingDown() const REQUIRES(task_queue_lock_) {
     return shutting_down_;
   }
 
   bool HasOutstandingTasks() const REQUIRES(task_queue_lock_) {
-    return started_ && !tasks_.empty();
+    return started_ &&
+           (!tasks_.empty() || pending_local_tasks_.load(std::memory_order_seq_cst) != 0u);
   }
 
   const std::string name_;
@@ -210,6 +251,14 @@ class ThreadPool {
   size_t max_active_workers_ GUARDED_BY(task_queue_lock_);
   const bool create_peers_;
   const size_t worker_stack_size_;
+  const bool work_stealing_;
+  // Number of tasks sitting in the deques of workers. Incremented before a task is pushed and
+  // decremented after it is taken, so it never under-counts.
+  std::atomic<size_t> pending_local_tasks_;
+  // Number of workers waiting on `task_queue_condition_`, readable without the lock so that
+  // workers adding tasks to their deque only take the lock if somebody needs to be woken up.
+  std::atomic<size_t> sleeping_workers_;
+  std::atomic<uint64_t> stolen_task_count_;
 
  private:
   friend class ThreadPoolWorker;
@@ -17,8 +17,10 @@
 #include "thread_pool.h"
 
 #include <string>
+#include <thread>
 
 #include "base/atomic.h"
+#include "base/time_utils.h"
 #include "common_runtime_test.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-inl.h"
@@ -160,6 +162,101 @@ TEST_F(ThreadPoolTest, RecursiveTest) {
   EXPECT_EQ((1 << depth) - 1, count.load(std::memory_order_seq_cst));
 }
 
+// Test that tasks added from within a task are run and stolen in work stealing mode.
+TEST_F(ThreadPoolTest, WorkStealingRecursiveTest) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool",
+                         num_threads,
+                         /*create_peers=*/ false,
+                         ThreadPoolWorker::kDefaultStackSize,
+                         /*work_stealing=*/ true);
+  AtomicInteger count(0);
+  static const int depth = 12;
+  thread_pool.AddTask(self, new TreeTask(&thread_pool, &count, depth));
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  EXPECT_EQ((1 << depth) - 1, count.load(std::memory_order_seq_cst));
+  EXPECT_EQ(0u, thread_pool.GetTaskCount(self));
+}
+
+TEST_F(ThreadPoolTest, WorkStealingStopWait) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool",
+                         num_threads,
+                         /*create_peers=*/ false,
+                         ThreadPoolWorker::kDefaultStackSize,
+                         /*work_stealing=*/ true);
+  AtomicInteger count(0);
+  static const int depth = 10;
+  for (int32_t i = 0; i < num_threads; ++i) {
+    thread_pool.AddTask(self, new TreeTask(&thread_pool, &count, depth));
+  }
+  thread_pool.StartWorkers(self);
+  usleep(200);
+  thread_pool.StopWorkers(self);
+  thread_pool.Wait(self, false, false);  // We should not deadlock here.
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, /* do_work= */ true, false);
+  EXPECT_EQ(num_threads * ((1 << depth) - 1), count.load(std::memory_order_seq_cst));
+}
+
+// A very small task, so that the cost of handing out tasks dominates.
+class SpawningTask : public Task {
+ public:
+  SpawningTask(ThreadPool* thread_pool, AtomicInteger* count, size_t children)
+      : thread_pool_(thread_pool), count_(count), children_(children) {}
+
+  void Run(Thread* self) override {
+    for (size_t i = 0; i != children_; ++i) {
+      thread_pool_->AddTask(self, new SpawningTask(thread_pool_, count_, /*children=*/ 0u));
+    }
+    count_->fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  ThreadPool* const thread_pool_;
+  AtomicInteger* const count_;
+  const size_t children_;
+};
+
+// Contention benchmark: workers add many tiny tasks. Reports tasks per second for the shared
+// queue and for work stealing as the worker count grows.
+TEST_F(ThreadPoolTest, ContentionBenchmark) {
+  Thread* self = Thread::Current();
+  static constexpr size_t kRoots = 256u;
+  static constexpr size_t kChildren = 256u;
+  static constexpr int32_t kTotalTasks = kRoots * (kChildren + 1u);
+  const size_t max_workers = std::max<size_t>(2u, std::thread::hardware_concurrency());
+  for (size_t workers = 1u; workers <= max_workers; workers *= 2u) {
+    double tasks_per_second[2];
+    for (bool work_stealing : { false, true }) {
+      ThreadPool thread_pool("Thread pool test thread pool",
+                             workers,
+                             /*create_peers=*/ false,
+                             ThreadPoolWorker::kDefaultStackSize,
+                             work_stealing);
+      AtomicInteger count(0);
+      for (size_t i = 0; i != kRoots; ++i) {
+        thread_pool.AddTask(self, new SpawningTask(&thread_pool, &count, kChildren));
+      }
+      const uint64_t start = NanoTime();
+      thread_pool.StartWorkers(self);
+      thread_pool.Wait(self, /* do_work= */ false, false);
+      const uint64_t duration = std::max<uint64_t>(NanoTime() - start, 1u);
+      EXPECT_EQ(kTotalTasks, count.load(std::memory_order_seq_cst));
+      tasks_per_second[work_stealing ? 1 : 0] =
+          static_cast<double>(kTotalTasks) * 1e9 / static_cast<double>(duration);
+    }
+    LOG(INFO) << "ThreadPool contention with " << workers << " workers: shared queue "
+              << static_cast<uint64_t>(tasks_per_second[0]) << " tasks/s, work stealing "
+              << static_cast<uint64_t>(tasks_per_second[1]) << " tasks/s";
+  }
+}
+
 class PeerTask : public Task {
  public:
   PeerTask() {}
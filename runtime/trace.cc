@@ -16,15 +16,19 @@
 
 #include "trace.h"
 
+#include <lz4.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "android-base/macros.h"
 #include "android-base/stringprintf.h"
 
 #include "art_method-inl.h"
 #include "base/casts.h"
 #include "base/enums.h"
+#include "base/leb128.h"
 #include "base/os.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
@@ -60,6 +64,7 @@ static constexpr size_t TraceActionBits = MinimumBitsToStore(
 static constexpr uint8_t kOpNewMethod = 1U;
 static constexpr uint8_t kOpNewThread = 2U;
 static constexpr uint8_t kOpTraceSummary = 3U;
+static constexpr uint8_t kOpCompressedEvents = 4U;
 
 static const char     kTraceTokenChar             = '*';
 static const uint16_t kTraceHeaderLength          = 32;
@@ -68,6 +73,32 @@ static const uint16_t kTraceVersionSingleClock    = 2;
 static const uint16_t kTraceVersionDualClock      = 3;
 static const uint16_t kTraceRecordSizeSingleClock = 10;  // using v2
 static const uint16_t kTraceRecordSizeDualClock   = 14;  // using v3 with two timestamps
+static const uint32_t kTraceCompressedMagicValue  = 0x5a4f4c53;
+
+// Block types of the compressed streaming format.
+static constexpr uint8_t kCompressedBlockRecords = 1U;
+static constexpr uint8_t kCompressedBlockSummary = 2U;
+static constexpr size_t kCompressedBlockHeaderSize = 9U;
+// Encoded records are compressed and written out once a block reaches this size.
+static constexpr size_t kCompressedBlockSize = 64 * KB;
+// How often the flusher thread drains the per-thread ring buffers.
+static constexpr int64_t kFlusherIntervalMs = 10;
+
+// Layout of the per-thread ring buffers used in compressed streaming mode. The header slots are
+// accessed atomically: the write index is only advanced by the owning thread, the read index only
+// by a consumer holding the tracing_lock_. Both count slots and wrap around kRingBufferCapacity.
+static constexpr size_t kRingBufferWriteSlot = 0U;
+static constexpr size_t kRingBufferReadSlot = 1U;
+static constexpr size_t kRingBufferTidSlot = 2U;
+static constexpr size_t kRingBufferHeaderSlots = 4U;
+static constexpr size_t kRingBufferCapacity = 64 * KB;
+static constexpr uintptr_t kRingBufferMask = kRingBufferCapacity - 1U;
+static_assert(IsPowerOfTwo(kRingBufferCapacity), "Ring buffer capacity must be a power of two");
+// Each event uses a slot for the method and action, one for the thread cpu time and one (two on
+// 32-bit) for the timestamp counter.
+static constexpr size_t kRingBufferSlotsPerEvent =
+    (art::kRuntimePointerSize == PointerSize::k32) ? 4U : 3U;
+static_assert(sizeof(std::atomic<uintptr_t>) == sizeof(uintptr_t), "Unexpected atomic size");
 
 TraceClockSource Trace::default_clock_source_ = kDefaultTraceClockSource;
 
@@ -82,6 +113,10 @@ static TraceAction DecodeTraceAction(uint32_t tmid) {
   return static_cast<TraceAction>(tmid & kTraceMethodActionMask);
 }
 
+static std::atomic<uintptr_t>* GetRingBufferIndex(uintptr_t* buffer, size_t slot) {
+  return reinterpret_cast<std::atomic<uintptr_t>*>(buffer + slot);
+}
+
 namespace {
 // Scaling factor to convert timestamp counter into wall clock time reported in micro seconds.
 // This is initialized at the start of tracing using the timestamp counter update frequency.
@@ -527,6 +562,11 @@ void Trace::Start(std::unique_ptr<File>&& trace_file_in,
     } else {
       enable_stats = (flags & kTraceCountAllocs) != 0;
       the_trace_ = new Trace(trace_file.release(), buffer_size, flags, output_mode, trace_mode);
+      if (output_mode == TraceOutputMode::kStreamingCompressed) {
+        CHECK_PTHREAD_CALL(pthread_create, (&the_trace_->flusher_pthread_, nullptr,
+                                            &RunFlusherThread, the_trace_),
+                                            "Method trace flusher thread");
+      }
       if (trace_mode == TraceMode::kSampling) {
         CHECK_PTHREAD_CALL(pthread_create, (&sampling_pthread_, nullptr, &RunSamplingThread,
                                             reinterpret_cast<void*>(interval_us)),
@@ -615,6 +655,19 @@ void Trace::StopTracing(bool finish_tracing, bool flush_file) {
   // Make a copy of the_trace_, so it can be flushed later. We want to reset
   // the_trace_ to nullptr in suspend all scope to prevent any races
   Trace* the_trace = the_trace_;
+
+  // Stop the flusher thread before suspending all threads, it may be waiting to become runnable.
+  // Events recorded after this point are drained when releasing the ring buffers below.
+  if (the_trace->flusher_pthread_ != 0U) {
+    {
+      MutexLock mu(self, the_trace->tracing_lock_);
+      the_trace->stop_flusher_ = true;
+      the_trace->flusher_cond_.Signal(self);
+    }
+    CHECK_PTHREAD_CALL(pthread_join, (the_trace->flusher_pthread_, nullptr),
+                       "method trace flusher thread shutdown");
+    the_trace->flusher_pthread_ = 0U;
+  }
   bool stop_alloc_counting = (the_trace->flags_ & Trace::kTraceCountAllocs) != 0;
   // Stop the trace sources adding more entries to the trace buffer and synchronise stores.
   {
@@ -643,8 +696,12 @@ void Trace::StopTracing(bool finish_tracing, bool flush_file) {
       MutexLock tl_lock(Thread::Current(), *Locks::thread_list_lock_);
       for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
         if (thread->GetMethodTraceBuffer() != nullptr) {
-          the_trace_->FlushStreamingBuffer(thread);
-          thread->ResetMethodTraceBuffer();
+          if (the_trace->trace_output_mode_ == TraceOutputMode::kStreamingCompressed) {
+            the_trace->ReleaseRingBuffer(thread);
+          } else {
+            the_trace->FlushStreamingBuffer(thread);
+            thread->ResetMethodTraceBuffer();
+          }
         }
         // Record threads here before resetting the_trace_ to prevent any races between
         // unregistering the thread and resetting the_trace_.
@@ -687,7 +744,11 @@ void Trace::StopTracing(bool finish_tracing, bool flush_file) {
 
 void Trace::FlushThreadBuffer(Thread* self) {
   MutexLock mu(self, *Locks::trace_lock_);
-  the_trace_->FlushStreamingBuffer(self);
+  if (the_trace_->trace_output_mode_ == TraceOutputMode::kStreamingCompressed) {
+    the_trace_->ReleaseRingBuffer(self);
+  } else {
+    the_trace_->FlushStreamingBuffer(self);
+  }
 }
 
 void Trace::Abort() {
@@ -763,7 +824,8 @@ Trace::Trace(File* trace_file,
       overflow_(false),
       interval_us_(0),
       stop_tracing_(false),
-      tracing_lock_("tracing lock", LockLevel::kTracingStreamingLock) {
+      tracing_lock_("tracing lock", LockLevel::kTracingStreamingLock),
+      flusher_cond_("tracing flusher condition", tracing_lock_) {
   CHECK_IMPLIES(trace_file == nullptr, output_mode == TraceOutputMode::kDDMS);
 
   uint16_t trace_version = GetTraceVersion(clock_source_);
@@ -784,6 +846,18 @@ Trace::Trace(File* trace_file,
 
   cur_offset_.store(kTraceHeaderLength, std::memory_order_relaxed);
 
+  if (output_mode == TraceOutputMode::kStreamingCompressed) {
+    // Same header with a different magic, followed by the clock source and compressed blocks.
+    Append4LE(buf_.get(), kTraceCompressedMagicValue);
+    Append2LE(buf_.get() + 16, GetRecordSize(clock_source_));
+    Append2LE(buf_.get() + 18, (UseThreadCpuClock() ? 1U : 0U) | (UseWallClock() ? 2U : 0U));
+    if (!trace_file_->WriteFully(buf_.get(), kTraceHeaderLength)) {
+      PLOG(WARNING) << "Failed streaming a tracing event.";
+    }
+    cur_offset_.store(0, std::memory_order_relaxed);
+    compressed_block_.reserve(kCompressedBlockSize);
+  }
+
   if (output_mode == TraceOutputMode::kStreaming) {
     // Flush the header information to the file. We use a per thread buffer, so
     // it is easier to just write the header information directly to file.
@@ -817,8 +891,10 @@ void Trace::DumpBuf(uint8_t* buf, size_t buf_size, TraceClockSource clock_source
 }
 
 void Trace::FinishTracing() {
+  const bool streaming = trace_output_mode_ == TraceOutputMode::kStreaming ||
+                         trace_output_mode_ == TraceOutputMode::kStreamingCompressed;
   size_t final_offset = 0;
-  if (trace_output_mode_ != TraceOutputMode::kStreaming) {
+  if (!streaming) {
     final_offset = cur_offset_.load(std::memory_order_relaxed);
   }
 
@@ -840,7 +916,10 @@ void Trace::FinishTracing() {
     os << StringPrintf("clock=wall\n");
   }
   os << StringPrintf("elapsed-time-usec=%" PRIu64 "\n", elapsed);
-  if (trace_output_mode_ != TraceOutputMode::kStreaming) {
+  if (trace_output_mode_ == TraceOutputMode::kStreamingCompressed) {
+    MutexLock mu(Thread::Current(), tracing_lock_);
+    os << StringPrintf("num-method-calls=%" PRIu64 "\n", num_compressed_events_);
+  } else if (!streaming) {
     size_t num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
     os << StringPrintf("num-method-calls=%zd\n", num_records);
   }
@@ -859,7 +938,14 @@ void Trace::FinishTracing() {
   os << StringPrintf("%cend\n", kTraceTokenChar);
   std::string header(os.str());
 
-  if (trace_output_mode_ == TraceOutputMode::kStreaming) {
+  if (trace_output_mode_ == TraceOutputMode::kStreamingCompressed) {
+    // All ring buffers have been drained, write out the last records and the summary.
+    MutexLock mu(Thread::Current(), tracing_lock_);
+    FlushCompressedBlock();
+    WriteCompressedBlock(kCompressedBlockSummary,
+                         reinterpret_cast<const uint8_t*>(header.c_str()),
+                         header.length());
+  } else if (trace_output_mode_ == TraceOutputMode::kStreaming) {
     // It is expected that this method is called when all other threads are suspended, so there
     // cannot be any writes to trace_file_ after finish tracing.
     // Write a special token to mark the end of trace records and the start of
@@ -1166,6 +1252,208 @@ void Trace::FlushStreamingBuffer(Thread* thread) {
   }
 }
 
+uintptr_t* Trace::RegisterRingBuffer(Thread* thread) {
+  uintptr_t* buffer = new uintptr_t[kRingBufferHeaderSlots + kRingBufferCapacity]();
+  buffer[kRingBufferTidSlot] = static_cast<uintptr_t>(thread->GetTid());
+  std::string thread_name;
+  thread->GetThreadName(thread_name);
+
+  MutexLock mu(Thread::Current(), tracing_lock_);
+  ring_buffers_.push_back(buffer);
+  thread->SetMethodTraceBuffer(buffer);
+  // Record information about the thread before any of its events.
+  compressed_block_.push_back(kOpNewThread);
+  EncodeUnsignedLeb128(&compressed_block_, static_cast<uint32_t>(thread->GetTid()));
+  EncodeUnsignedLeb128(&compressed_block_, static_cast<uint32_t>(thread_name.length()));
+  compressed_block_.insert(compressed_block_.end(), thread_name.begin(), thread_name.end());
+  return buffer;
+}
+
+void Trace::RecordCompressedMethodEvent(Thread* thread,
+                                        ArtMethod* method,
+                                        TraceAction action,
+                                        uint32_t thread_clock_diff,
+                                        uint64_t timestamp_counter) {
+  uintptr_t* buffer = thread->GetMethodTraceBuffer();
+  if (UNLIKELY(buffer == nullptr)) {
+    buffer = RegisterRingBuffer(thread);
+  }
+  std::atomic<uintptr_t>* write_index = GetRingBufferIndex(buffer, kRingBufferWriteSlot);
+  std::atomic<uintptr_t>* read_index = GetRingBufferIndex(buffer, kRingBufferReadSlot);
+  const uintptr_t write = write_index->load(std::memory_order_relaxed);
+  if (UNLIKELY(write + kRingBufferSlotsPerEvent - read_index->load(std::memory_order_acquire) >
+               kRingBufferCapacity)) {
+    // The flusher thread didn't keep up, drain the buffer ourselves.
+    MutexLock mu(Thread::Current(), tracing_lock_);
+    DrainRingBuffer(buffer);
+    if (compressed_block_.size() >= kCompressedBlockSize) {
+      FlushCompressedBlock();
+    }
+  }
+
+  // The low bits of the method pointer are free to record the action.
+  DCHECK_ALIGNED(method, kTraceMethodActionMask + 1);
+  uintptr_t* data = buffer + kRingBufferHeaderSlots;
+  data[write & kRingBufferMask] = reinterpret_cast<uintptr_t>(method) | action;
+  data[(write + 1) & kRingBufferMask] = thread_clock_diff;
+  if (art::kRuntimePointerSize == PointerSize::k32) {
+    // On 32-bit architectures store timestamp counter as two 32-bit values.
+    data[(write + 2) & kRingBufferMask] = timestamp_counter >> 32;
+    data[(write + 3) & kRingBufferMask] = static_cast<uint32_t>(timestamp_counter);
+  } else {
+    data[(write + 2) & kRingBufferMask] = timestamp_counter;
+  }
+  // Publish the event to the consumers.
+  write_index->store(write + kRingBufferSlotsPerEvent, std::memory_order_release);
+}
+
+void Trace::DrainRingBuffer(uintptr_t* buffer) {
+  std::atomic<uintptr_t>* write_index = GetRingBufferIndex(buffer, kRingBufferWriteSlot);
+  std::atomic<uintptr_t>* read_index = GetRingBufferIndex(buffer, kRingBufferReadSlot);
+  const uintptr_t begin = read_index->load(std::memory_order_relaxed);
+  const uintptr_t end = write_index->load(std::memory_order_acquire);
+  if (begin == end) {
+    return;
+  }
+  const uintptr_t* data = buffer + kRingBufferHeaderSlots;
+  event_scratch_.clear();
+  uint32_t num_events = 0;
+  uint32_t previous_method_index = 0;
+  uint32_t previous_thread_time = 0;
+  uint32_t previous_wall_time = 0;
+  for (uintptr_t index = begin; index != end; index += kRingBufferSlotsPerEvent) {
+    const uintptr_t method_and_action = data[index & kRingBufferMask];
+    ArtMethod* method = reinterpret_cast<ArtMethod*>(
+        method_and_action & ~static_cast<uintptr_t>(kTraceMethodActionMask));
+    TraceAction action = DecodeTraceAction(method_and_action);
+
+    auto it = art_method_id_map_.find(method);
+    uint32_t method_index = 0;
+    if (it == art_method_id_map_.end()) {
+      // Method definitions go straight to the block so that they precede this events record.
+      method_index = EncodeTraceMethod(method);
+      std::string method_line(GetMethodLine(method, method_index));
+      compressed_block_.push_back(kOpNewMethod);
+      EncodeUnsignedLeb128(&compressed_block_, method_index);
+      EncodeUnsignedLeb128(&compressed_block_, static_cast<uint32_t>(method_line.length()));
+      compressed_block_.insert(compressed_block_.end(), method_line.begin(), method_line.end());
+    } else {
+      method_index = it->second;
+    }
+    DCHECK_LT(method_index, 1u << 29) << "Method index delta must fit in 30 signed bits";
+    const int32_t method_delta = static_cast<int32_t>(method_index - previous_method_index);
+    EncodeSignedLeb128(&event_scratch_, method_delta * (1 << TraceActionBits) + action);
+    previous_method_index = method_index;
+
+    if (UseThreadCpuClock()) {
+      const uint32_t thread_time = static_cast<uint32_t>(data[(index + 1) & kRingBufferMask]);
+      EncodeSignedLeb128(&event_scratch_, static_cast<int32_t>(thread_time - previous_thread_time));
+      previous_thread_time = thread_time;
+    }
+    if (UseWallClock()) {
+      uint64_t timestamp = data[(index + 2) & kRingBufferMask];
+      if (art::kRuntimePointerSize == PointerSize::k32) {
+        // On 32-bit architectures timestamp is stored as two 32-bit values.
+        timestamp = (timestamp << 32 | data[(index + 3) & kRingBufferMask]);
+      }
+      const uint32_t wall_time = GetMicroTime(timestamp) - start_time_;
+      EncodeSignedLeb128(&event_scratch_, static_cast<int32_t>(wall_time - previous_wall_time));
+      previous_wall_time = wall_time;
+    }
+    ++num_events;
+  }
+  // The slots can now be reused by the producer.
+  read_index->store(end, std::memory_order_release);
+
+  compressed_block_.push_back(kOpCompressedEvents);
+  EncodeUnsignedLeb128(&compressed_block_, static_cast<uint32_t>(buffer[kRingBufferTidSlot]));
+  EncodeUnsignedLeb128(&compressed_block_, num_events);
+  compressed_block_.insert(compressed_block_.end(), event_scratch_.begin(), event_scratch_.end());
+  num_compressed_events_ += num_events;
+}
+
+void Trace::DrainAllRingBuffers() {
+  for (uintptr_t* buffer : ring_buffers_) {
+    DrainRingBuffer(buffer);
+    if (compressed_block_.size() >= kCompressedBlockSize) {
+      FlushCompressedBlock();
+    }
+  }
+}
+
+void Trace::ReleaseRingBuffer(Thread* thread) {
+  uintptr_t* buffer = thread->GetMethodTraceBuffer();
+  if (buffer == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), tracing_lock_);
+  DrainRingBuffer(buffer);
+  auto it = std::find(ring_buffers_.begin(), ring_buffers_.end(), buffer);
+  DCHECK(it != ring_buffers_.end());
+  ring_buffers_.erase(it);
+  // Reset under the lock, the buffer is no longer visible to the flusher thread.
+  thread->ResetMethodTraceBuffer();
+}
+
+void Trace::WriteCompressedBlock(uint8_t type, const uint8_t* data, size_t size) {
+  compression_scratch_.resize(LZ4_compressBound(size));
+  int compressed_size = LZ4_compress_default(reinterpret_cast<const char*>(data),
+                                             reinterpret_cast<char*>(compression_scratch_.data()),
+                                             size,
+                                             compression_scratch_.size());
+  const uint8_t* stored_data = compression_scratch_.data();
+  size_t stored_size = static_cast<size_t>(compressed_size);
+  if (compressed_size <= 0 || stored_size >= size) {
+    // Store the block as is if it doesn't compress.
+    stored_data = data;
+    stored_size = size;
+  }
+  uint8_t header[kCompressedBlockHeaderSize];
+  header[0] = type;
+  Append4LE(header + 1, static_cast<uint32_t>(size));
+  Append4LE(header + 5, static_cast<uint32_t>(stored_size));
+  if (!trace_file_->WriteFully(header, kCompressedBlockHeaderSize) ||
+      !trace_file_->WriteFully(stored_data, stored_size)) {
+    PLOG(WARNING) << "Failed streaming a tracing event.";
+  }
+}
+
+void Trace::FlushCompressedBlock() {
+  if (compressed_block_.empty()) {
+    return;
+  }
+  WriteCompressedBlock(kCompressedBlockRecords, compressed_block_.data(), compressed_block_.size());
+  compressed_block_.clear();
+}
+
+void* Trace::RunFlusherThread(void* arg) {
+  Runtime* runtime = Runtime::Current();
+  Trace* the_trace = reinterpret_cast<Trace*>(arg);
+  CHECK(runtime->AttachCurrentThread("Method trace flusher",
+                                     /* as_daemon= */ true,
+                                     /* thread_group= */ nullptr,
+                                     /* create_peer= */ false));
+  Thread* self = Thread::Current();
+  while (true) {
+    {
+      MutexLock mu(self, the_trace->tracing_lock_);
+      if (!the_trace->stop_flusher_) {
+        the_trace->flusher_cond_.TimedWait(self, kFlusherIntervalMs, 0);
+      }
+      if (the_trace->stop_flusher_) {
+        break;
+      }
+    }
+    ScopedTrace trace("Method trace flush");
+    // Encoding new methods needs the mutator lock.
+    ScopedObjectAccess soa(self);
+    MutexLock mu(self, the_trace->tracing_lock_);
+    the_trace->DrainAllRingBuffers();
+  }
+  runtime->DetachCurrentThread();
+  return nullptr;
+}
+
 void Trace::RecordMethodEvent(Thread* thread,
                               ArtMethod* method,
                               TraceAction action,
@@ -1222,6 +1510,8 @@ void Trace::LogMethodTraceEvent(Thread* thread,
 
   if (trace_output_mode_ == TraceOutputMode::kStreaming) {
     RecordStreamingMethodEvent(thread, method, action, thread_clock_diff, timestamp_counter);
+  } else if (trace_output_mode_ == TraceOutputMode::kStreamingCompressed) {
+    RecordCompressedMethodEvent(thread, method, action, thread_clock_diff, timestamp_counter);
   } else {
     RecordMethodEvent(thread, method, action, thread_clock_diff, timestamp_counter);
   }
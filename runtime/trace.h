@@ -89,6 +89,40 @@ std::ostream& operator<<(std::ostream& os, TracingMode rhs);
 // 32 bits of microseconds is 70 minutes.
 //
 // All values are stored in little-endian order.
+//
+// Compressed streaming file format (TraceOutputMode::kStreamingCompressed):
+//     header
+//     block 0
+//     block 1
+//     ...
+//
+// Header format:
+//     u4  magic ('SLOZ')
+//     u2  version of the records after conversion (2 or 3, see above)
+//     u2  offset to data
+//     u8  start date/time in usec
+//     u2  record size in bytes after conversion
+//     u2  clock source (bit 0: thread cpu, bit 1: wall)
+//     ... padding to 32 bytes
+//
+// Block format:
+//     u1  block type (records or summary)
+//     u4  uncompressed size
+//     u4  stored size, equal to the uncompressed size if the block is not LZ4 compressed
+//     ... data
+//
+// Records in a records block:
+//     u1  op (new thread), uleb128 thread ID, uleb128 name length, name
+//     u1  op (new method), uleb128 method ID, uleb128 line length, method line
+//     u1  op (events), uleb128 thread ID, uleb128 event count, followed by for each event:
+//         sleb128  (method ID delta << 2) | method action
+//         sleb128  thread cpu time delta, in usec (when using the thread cpu clock)
+//         sleb128  wall time delta, in usec (when using the wall clock)
+//
+// Deltas are relative to the previous event of the same events record, the first event of each
+// record is relative to zero. The summary block holds the same text as the header of the
+// non-streaming format. tools/dmtracedump/decompresstrace.cc converts this format back to the
+// non-streaming one.
 
 enum TraceAction {
     kTraceMethodEnter = 0x00,       // method entry
@@ -112,7 +146,10 @@ class Trace final : public instrumentation::InstrumentationListener {
   enum class TraceOutputMode {
     kFile,
     kDDMS,
-    kStreaming
+    kStreaming,
+    // Like kStreaming, but events are recorded in per-thread lock-free ring buffers which are
+    // encoded, compressed and written out by a background flusher thread.
+    kStreamingCompressed
   };
 
   enum class TraceMode {
@@ -320,6 +357,34 @@ class Trace final : public instrumentation::InstrumentationListener {
                   uint8_t* buffer,
                   size_t buffer_size);
 
+  // These methods are used to encode events in compressed streaming mode.
+
+  // Records the method event in the per-thread ring buffer without taking any lock, unless the
+  // ring buffer is full in which case the thread drains it itself.
+  void RecordCompressedMethodEvent(Thread* thread,
+                                   ArtMethod* method,
+                                   TraceAction action,
+                                   uint32_t thread_clock_diff,
+                                   uint64_t timestamp) REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!tracing_lock_);
+  // Allocates the ring buffer of `thread` and records information about the thread.
+  uintptr_t* RegisterRingBuffer(Thread* thread) REQUIRES(!tracing_lock_);
+  // Encodes the pending events of a ring buffer into compressed_block_. Consumers of the ring
+  // buffers are serialized by the tracing_lock_.
+  void DrainRingBuffer(uintptr_t* buffer)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(tracing_lock_);
+  void DrainAllRingBuffers() REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(tracing_lock_);
+  // Drains and frees the ring buffer of a thread, called when the thread detaches or when tracing
+  // stops.
+  void ReleaseRingBuffer(Thread* thread)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!tracing_lock_);
+  // Compresses and writes out a block.
+  void WriteCompressedBlock(uint8_t type, const uint8_t* data, size_t size)
+      REQUIRES(tracing_lock_);
+  void FlushCompressedBlock() REQUIRES(tracing_lock_);
+  // Body of the flusher thread, the argument is the Trace.
+  static void* RunFlusherThread(void* arg) REQUIRES(!Locks::trace_lock_);
+
   uint32_t EncodeTraceMethod(ArtMethod* method) REQUIRES(tracing_lock_);
   ArtMethod* DecodeTraceMethod(uint32_t tmid) REQUIRES(tracing_lock_);
   std::string GetMethodLine(ArtMethod* method, uint32_t method_id) REQUIRES(tracing_lock_)
@@ -414,6 +479,22 @@ class Trace final : public instrumentation::InstrumentationListener {
   std::unordered_map<ArtMethod*, uint32_t> art_method_id_map_ GUARDED_BY(tracing_lock_);
   uint32_t current_method_index_ = 0;
 
+  // Compressed streaming mode data.
+
+  // Ring buffers of the threads that recorded events.
+  std::vector<uintptr_t*> ring_buffers_ GUARDED_BY(tracing_lock_);
+  // Encoded records waiting to be compressed and written out.
+  std::vector<uint8_t> compressed_block_ GUARDED_BY(tracing_lock_);
+  // Scratch buffers, kept to avoid reallocating them for every block.
+  std::vector<uint8_t> event_scratch_ GUARDED_BY(tracing_lock_);
+  std::vector<uint8_t> compression_scratch_ GUARDED_BY(tracing_lock_);
+  // Number of events encoded so far.
+  uint64_t num_compressed_events_ GUARDED_BY(tracing_lock_) = 0u;
+  // Background thread draining the ring buffers, non-zero when running.
+  pthread_t flusher_pthread_ = 0U;
+  ConditionVariable flusher_cond_ GUARDED_BY(tracing_lock_);
+  bool stop_flusher_ GUARDED_BY(tracing_lock_) = false;
+
   DISALLOW_COPY_AND_ASSIGN(Trace);
 };
 
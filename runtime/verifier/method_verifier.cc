@@ -4951,7 +4951,8 @@ MethodVerifier::MethodVerifier(Thread* self,
                                bool aot_mode)
     : self_(self),
       arena_stack_(arena_pool),
-      allocator_(&arena_stack_),
+      allocator_(self->GetVerifierArenaStack() != nullptr ? self->GetVerifierArenaStack()
+                                                           : &arena_stack_),
       reg_types_(class_linker, can_load_classes, allocator_, allow_thread_suspension),
       reg_table_(allocator_),
       work_insn_idx_(dex::kDexNoIndex),
@@ -291,7 +291,8 @@ class MethodVerifier {
   // The thread we're verifying on.
   Thread* const self_;
 
-  // Arena allocator.
+  // Arena allocator. The private arena stack is only used if the thread does not provide one,
+  // see Thread::SetVerifierArenaStack().
   ArenaStack arena_stack_;
   ScopedArenaAllocator allocator_;
 
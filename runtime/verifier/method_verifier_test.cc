@@ -18,16 +18,21 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 #include "android-base/strings.h"
 #include "base/metrics/metrics_test.h"
+#include "base/scoped_arena_allocator.h"
+#include "base/time_utils.h"
 #include "base/utils.h"
 #include "class_linker-inl.h"
 #include "class_verifier.h"
 #include "common_runtime_test.h"
 #include "dex/dex_file-inl.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 #include "verifier_enums.h"
 
 namespace art {
@@ -41,6 +46,7 @@ class MethodVerifierTest : public CommonRuntimeTest {
     use_boot_image_ = true;  // Make the Runtime creation cheaper.
   }
 
+ public:
   void VerifyClass(const std::string& descriptor)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     ASSERT_FALSE(descriptor.empty());
@@ -104,5 +110,68 @@ TEST_F(MethodVerifierTest, VerificationTimeMetrics) {
   ASSERT_GT(CounterValue(*class_verification_count), original_count);
 }
 
+// Verifies classes of a dex file, taking the next class from a shared index, with a private
+// arena stack for the verifier like dex2oat worker threads.
+class VerifyClassesTask : public Task {
+ public:
+  VerifyClassesTask(MethodVerifierTest* test, const DexFile* dex_file, std::atomic<size_t>* index)
+      : test_(test), dex_file_(dex_file), index_(index) {}
+
+  void Run(Thread* self) override {
+    ArenaStack arena_stack(Runtime::Current()->GetArenaPool());
+    self->SetVerifierArenaStack(&arena_stack);
+    {
+      ScopedObjectAccess soa(self);
+      for (size_t i = index_->fetch_add(1u, std::memory_order_relaxed);
+           i < dex_file_->NumClassDefs();
+           i = index_->fetch_add(1u, std::memory_order_relaxed)) {
+        test_->VerifyClass(dex_file_->GetClassDescriptor(dex_file_->GetClassDef(i)));
+      }
+    }
+    self->SetVerifierArenaStack(nullptr);
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  MethodVerifierTest* const test_;
+  const DexFile* const dex_file_;
+  std::atomic<size_t>* const index_;
+};
+
+// Verify core-oj with an increasing number of threads. This is a benchmark rather than a test,
+// results are only logged.
+TEST_F(MethodVerifierTest, ParallelVerificationBenchmark) {
+  ASSERT_TRUE(java_lang_dex_file_ != nullptr);
+  Thread* self = Thread::Current();
+  // Resolve all the classes first so that we only measure verification.
+  {
+    ScopedObjectAccess soa(self);
+    for (size_t i = 0; i != java_lang_dex_file_->NumClassDefs(); ++i) {
+      const dex::ClassDef& class_def = java_lang_dex_file_->GetClassDef(i);
+      ASSERT_TRUE(class_linker_->FindSystemClass(
+          self, java_lang_dex_file_->GetClassDescriptor(class_def)) != nullptr);
+    }
+  }
+  const size_t num_classes = java_lang_dex_file_->NumClassDefs();
+  for (size_t num_threads : {1u, 2u, 4u, 8u}) {
+    ThreadPool thread_pool("Verification benchmark thread pool", num_threads);
+    std::atomic<size_t> index(0u);
+    for (size_t i = 0; i != num_threads; ++i) {
+      thread_pool.AddTask(self, new VerifyClassesTask(this, java_lang_dex_file_, &index));
+    }
+    uint64_t start = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, /* do_work= */ false, /* may_hold_locks= */ false);
+    uint64_t duration = std::max<uint64_t>(NanoTime() - start, 1u);
+    thread_pool.StopWorkers(self);
+    LOG(INFO) << "Verified " << num_classes << " classes with " << num_threads << " threads in "
+              << PrettyDuration(duration) << ": "
+              << num_classes * UINT64_C(1000000000) / duration << " classes/s";
+  }
+}
+
 }  // namespace verifier
 }  // namespace art
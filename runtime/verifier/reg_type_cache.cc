@@ -38,11 +38,69 @@ bool RegTypeCache::primitive_initialized_ = false;
 uint16_t RegTypeCache::primitive_count_ = 0;
 const PreciseConstType* RegTypeCache::small_precise_constants_[kMaxSmallConstant -
                                                                kMinSmallConstant + 1];
+const RegType* RegTypeCache::shared_reference_types_[kMaxSharedReferenceTypes];
+uint16_t RegTypeCache::shared_reference_count_ = 0;
 
 namespace {
 
 ClassLinker* gInitClassLinker = nullptr;
 
+// Boot class path types shared by all caches. Only classes in java.* packages are listed: no
+// class loader other than the boot class loader may define those, so resolving the descriptor
+// from any class loader yields the same class. A class that is final gets a precise type, other
+// classes get an imprecise type.
+constexpr const char* kSharedReferenceDescriptors[] = {
+    "Ljava/lang/Object;",
+    "Ljava/lang/String;",
+    "Ljava/lang/Class;",
+    "Ljava/lang/Throwable;",
+    "Ljava/lang/Exception;",
+    "Ljava/lang/RuntimeException;",
+    "Ljava/lang/Error;",
+    "Ljava/lang/IllegalArgumentException;",
+    "Ljava/lang/IllegalStateException;",
+    "Ljava/lang/NullPointerException;",
+    "Ljava/lang/UnsupportedOperationException;",
+    "Ljava/lang/StringBuilder;",
+    "Ljava/lang/CharSequence;",
+    "Ljava/lang/Boolean;",
+    "Ljava/lang/Integer;",
+    "Ljava/lang/Long;",
+    "Ljava/lang/Float;",
+    "Ljava/lang/Double;",
+    "Ljava/lang/Number;",
+    "Ljava/lang/Enum;",
+    "Ljava/lang/Iterable;",
+    "Ljava/lang/Runnable;",
+    "Ljava/lang/invoke/MethodHandle;",
+    "Ljava/lang/invoke/MethodType;",
+    "Ljava/util/Collection;",
+    "Ljava/util/Iterator;",
+    "Ljava/util/List;",
+    "Ljava/util/ArrayList;",
+    "Ljava/util/Map;",
+    "Ljava/util/HashMap;",
+    "Ljava/util/Set;",
+    "Ljava/util/Objects;",
+    "[Ljava/lang/Object;",
+    "[Ljava/lang/String;",
+    "[Z",
+    "[B",
+    "[C",
+    "[I",
+    "[J",
+};
+
+// Classes that are not final but for which the precise type is requested on the common paths,
+// see JavaLangObject(), JavaLangThrowable(), JavaLangInvokeMethodHandle() and
+// JavaLangInvokeMethodType(). They get a shared precise type in addition to the imprecise one.
+constexpr const char* kSharedPreciseReferenceDescriptors[] = {
+    "Ljava/lang/Object;",
+    "Ljava/lang/Throwable;",
+    "Ljava/lang/invoke/MethodHandle;",
+    "Ljava/lang/invoke/MethodType;",
+};
+
 }  // namespace
 
 ALWAYS_INLINE static inline bool MatchingPrecisionForClass(const RegType* entry, bool precise)
@@ -80,6 +138,10 @@ void RegTypeCache::FillPrimitiveAndSmallConstantTypes() {
     DCHECK_EQ(entries_.size(), small_precise_constants_[i]->GetId());
     entries_.push_back(small_precise_constants_[i]);
   }
+  for (size_t i = 0; i != shared_reference_count_; ++i) {
+    DCHECK_EQ(entries_.size(), shared_reference_types_[i]->GetId());
+    entries_.push_back(shared_reference_types_[i]);
+  }
   DCHECK_EQ(entries_.size(), primitive_count_);
 }
 
@@ -185,9 +247,9 @@ const RegType& RegTypeCache::From(ObjPtr<mirror::ClassLoader> loader,
                                   const char* descriptor,
                                   bool precise) {
   std::string_view sv_descriptor(descriptor);
-  // Try looking up the class in the cache first. We use a std::string_view to avoid
-  // repeated strlen operations on the descriptor.
-  for (size_t i = primitive_count_; i < entries_.size(); i++) {
+  // Try looking up the class in the cache first, including the shared reference types. We use a
+  // std::string_view to avoid repeated strlen operations on the descriptor.
+  for (size_t i = kNumPrimitivesAndSmallConstants; i < entries_.size(); i++) {
     if (MatchDescriptor(i, sv_descriptor, precise)) {
       return *(entries_[i]);
     }
@@ -247,6 +309,12 @@ const RegType* RegTypeCache::FindClass(ObjPtr<mirror::Class> klass, bool precise
     // primitive classes are final.
     return &RegTypeFromPrimitiveType(klass->GetPrimitiveType());
   }
+  for (size_t i = 0; i != shared_reference_count_; ++i) {
+    const RegType* reg_type = shared_reference_types_[i];
+    if (reg_type->GetClass() == klass && MatchingPrecisionForClass(reg_type, precise)) {
+      return reg_type;
+    }
+  }
   for (auto& pair : klass_entries_) {
     const ObjPtr<mirror::Class> reg_klass = pair.first.Read();
     if (reg_klass == klass) {
@@ -329,6 +397,11 @@ void RegTypeCache::ShutDown() {
       delete type;
       small_precise_constants_[value - kMinSmallConstant] = nullptr;
     }
+    for (size_t i = 0; i != shared_reference_count_; ++i) {
+      delete shared_reference_types_[i];
+      shared_reference_types_[i] = nullptr;
+    }
+    RegTypeCache::shared_reference_count_ = 0;
     RegTypeCache::primitive_initialized_ = false;
     RegTypeCache::primitive_count_ = 0;
   }
@@ -391,6 +464,39 @@ void RegTypeCache::CreatePrimitiveAndSmallConstantTypes(ClassLinker* class_linke
   }
 }
 
+void RegTypeCache::CreateSharedReferenceTypes(ClassLinker* class_linker) {
+  // Note: the descriptors have global lifetime, so the types can refer to them directly.
+  Thread* self = Thread::Current();
+  auto add_shared_type = [&](const char* descriptor, ObjPtr<mirror::Class> klass, bool precise)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    CHECK_LT(shared_reference_count_, kMaxSharedReferenceTypes);
+    RegType* entry = precise
+        ? static_cast<RegType*>(new PreciseReferenceType(klass, descriptor, primitive_count_))
+        : new ReferenceType(klass, descriptor, primitive_count_);
+    shared_reference_types_[shared_reference_count_] = entry;
+    shared_reference_count_++;
+    primitive_count_++;
+  };
+  // Only use classes that are already resolved, this must not load classes. Classes that are
+  // not loaded yet, for example when compiling the boot image, are simply not shared.
+  auto lookup_class = [&](const char* descriptor) REQUIRES_SHARED(Locks::mutator_lock_) {
+    ObjPtr<mirror::Class> klass = class_linker->LookupClass(self, descriptor, nullptr);
+    return (klass != nullptr && klass->IsResolved() && !klass->IsErroneous()) ? klass : nullptr;
+  };
+  for (const char* descriptor : kSharedReferenceDescriptors) {
+    ObjPtr<mirror::Class> klass = lookup_class(descriptor);
+    if (klass != nullptr) {
+      add_shared_type(descriptor, klass, klass->CannotBeAssignedFromOtherTypes());
+    }
+  }
+  for (const char* descriptor : kSharedPreciseReferenceDescriptors) {
+    ObjPtr<mirror::Class> klass = lookup_class(descriptor);
+    if (klass != nullptr && !klass->CannotBeAssignedFromOtherTypes()) {
+      add_shared_type(descriptor, klass, /* precise= */ true);
+    }
+  }
+}
+
 const RegType& RegTypeCache::FromUnresolvedMerge(const RegType& left,
                                                  const RegType& right,
                                                  MethodVerifier* verifier) {
@@ -713,6 +819,9 @@ void RegTypeCache::VisitStaticRoots(RootVisitor* visitor) {
     for (int32_t value = kMinSmallConstant; value <= kMaxSmallConstant; ++value) {
       small_precise_constants_[value - kMinSmallConstant]->VisitRoots(visitor, ri);
     }
+    for (size_t i = 0; i != shared_reference_count_; ++i) {
+      shared_reference_types_[i]->VisitRoots(visitor, ri);
+    }
   }
 }
 
@@ -75,6 +75,9 @@ class RegTypeCache {
       CHECK_EQ(RegTypeCache::primitive_count_, 0);
       CreatePrimitiveAndSmallConstantTypes(class_linker);
       CHECK_EQ(RegTypeCache::primitive_count_, kNumPrimitivesAndSmallConstants);
+      CreateSharedReferenceTypes(class_linker);
+      CHECK_EQ(RegTypeCache::primitive_count_,
+               kNumPrimitivesAndSmallConstants + RegTypeCache::shared_reference_count_);
       RegTypeCache::primitive_initialized_ = true;
     }
   }
@@ -189,6 +192,8 @@ class RegTypeCache {
 
   static void CreatePrimitiveAndSmallConstantTypes(ClassLinker* class_linker)
       REQUIRES_SHARED(Locks::mutator_lock_);
+  static void CreateSharedReferenceTypes(ClassLinker* class_linker)
+      REQUIRES_SHARED(Locks::mutator_lock_);
 
   // A quick look up for popular small constants.
   static constexpr int32_t kMinSmallConstant = -1;
@@ -199,10 +204,18 @@ class RegTypeCache {
   static constexpr size_t kNumPrimitivesAndSmallConstants =
       13 + (kMaxSmallConstant - kMinSmallConstant + 1);
 
+  // Reference types for frequently used boot class path classes. They are created once, never
+  // modified and shared by all caches, so that verifier threads do not need to resolve and
+  // allocate them again for every method.
+  static constexpr size_t kMaxSharedReferenceTypes = 48;
+  static const RegType* shared_reference_types_[kMaxSharedReferenceTypes];
+  static uint16_t shared_reference_count_;
+
   // Have the well known global primitives been created?
   static bool primitive_initialized_;
 
-  // Number of well known primitives that will be copied into a RegTypeCache upon construction.
+  // Number of well known primitives and shared reference types that will be copied into a
+  // RegTypeCache upon construction.
   static uint16_t primitive_count_;
 
   // The actual storage for the RegTypes.
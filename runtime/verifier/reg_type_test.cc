@@ -486,6 +486,29 @@ TEST_F(RegTypeReferenceTest, JavalangObject) {
   EXPECT_TRUE(ref_type_3.Equals(ref_type_2));
   EXPECT_EQ(ref_type.GetId(), ref_type_3.GetId());
 }
+TEST_F(RegTypeReferenceTest, SharedTypes) {
+  // Frequently used boot class path types are shared by all caches.
+  ArenaStack stack(Runtime::Current()->GetArenaPool());
+  ScopedArenaAllocator allocator(&stack);
+  ScopedObjectAccess soa(Thread::Current());
+  RegTypeCache cache_1(Runtime::Current()->GetClassLinker(), true, allocator);
+  RegTypeCache cache_2(Runtime::Current()->GetClassLinker(), true, allocator);
+  EXPECT_EQ(&cache_1.JavaLangObject(true), &cache_2.JavaLangObject(true));
+  EXPECT_EQ(&cache_1.JavaLangObject(false), &cache_2.JavaLangObject(false));
+  EXPECT_NE(&cache_1.JavaLangObject(true), &cache_1.JavaLangObject(false));
+  EXPECT_EQ(&cache_1.JavaLangString(), &cache_2.JavaLangString());
+  const RegType& list_1 = cache_1.FromDescriptor(nullptr, "Ljava/util/List;", false);
+  const RegType& list_2 = cache_2.FromDescriptor(nullptr, "Ljava/util/List;", false);
+  EXPECT_TRUE(list_1.IsReference());
+  EXPECT_EQ(&list_1, &list_2);
+  EXPECT_EQ(&list_1, &cache_2.FromClass("Ljava/util/List;", list_1.GetClass(), false));
+  // Types that are not shared are private to each cache.
+  const RegType& linked_list_1 = cache_1.FromDescriptor(nullptr, "Ljava/util/LinkedList;", false);
+  const RegType& linked_list_2 = cache_2.FromDescriptor(nullptr, "Ljava/util/LinkedList;", false);
+  EXPECT_TRUE(linked_list_1.Equals(linked_list_2));
+  EXPECT_NE(&linked_list_1, &linked_list_2);
+}
+
 TEST_F(RegTypeReferenceTest, Merging) {
   // Tests merging logic
   // String and object , LUB is object.
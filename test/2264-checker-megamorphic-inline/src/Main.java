@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class SubA extends Super {
+  int getValue() { return 42; }
+}
+
+class SubB extends Super {
+  int getValue() { return 38; }
+}
+
+class SubC extends Super {
+  int getValue() { return 24; }
+}
+
+class SubD extends Super {
+  int getValue() { return 10; }
+}
+
+class SubE extends Super {
+  int getValue() { return -4; }
+}
+
+public class Main {
+
+  // The profile says that SubA is the receiver of 900 of the 1000 calls: it is inlined
+  // behind a type guard, and the virtual call is kept for the other receivers.
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubA(Super) inliner (before)
+  /// CHECK:       InvokeVirtual method_name:Super.getValue
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubA(Super) inliner (after)
+  /// CHECK-DAG:   <<SubARet:i\d+>>      IntConstant 42
+  /// CHECK-DAG:   <<Obj:l\d+>>          NullCheck
+  /// CHECK-DAG:   <<ObjClass:l\d+>>     InstanceFieldGet [<<Obj>>] field_name:java.lang.Object.shadow$_klass_
+  /// CHECK-DAG:   <<InlineClass:l\d+>>  LoadClass class_name:SubA
+  /// CHECK-DAG:   <<Test:z\d+>>         NotEqual [<<InlineClass>>,<<ObjClass>>]
+  /// CHECK-DAG:                         If [<<Test>>]
+  /// CHECK-DAG:   <<DefaultRet:i\d+>>   InvokeVirtual [<<Obj>>] method_name:Super.getValue
+  /// CHECK-DAG:   <<Ret:i\d+>>          Phi [<<SubARet>>,<<DefaultRet>>]
+  /// CHECK-DAG:                         Return [<<Ret>>]
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubA(Super) inliner (after)
+  /// CHECK-NOT:                         LoadClass class_name:SubB
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubA(Super) inliner (after)
+  /// CHECK-NOT:                         Deoptimize
+  public static int inlineMegamorphicDominantSubA(Super a) {
+    return a.getValue();
+  }
+
+  // SubB and SubA are both dominant receivers. The most frequent one, SubB, is tested first.
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubBSubA(Super) inliner (before)
+  /// CHECK:       InvokeVirtual method_name:Super.getValue
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubBSubA(Super) inliner (after)
+  /// CHECK-DAG:   <<SubARet:i\d+>>          IntConstant 42
+  /// CHECK-DAG:   <<SubBRet:i\d+>>          IntConstant 38
+  /// CHECK-DAG:   <<Obj:l\d+>>              NullCheck
+  /// CHECK-DAG:   <<ObjClassSubB:l\d+>>     InstanceFieldGet [<<Obj>>] field_name:java.lang.Object.shadow$_klass_
+  /// CHECK-DAG:   <<InlineClassSubB:l\d+>>  LoadClass class_name:SubB
+  /// CHECK-DAG:   <<TestSubB:z\d+>>         NotEqual [<<InlineClassSubB>>,<<ObjClassSubB>>]
+  /// CHECK-DAG:                             If [<<TestSubB>>]
+
+  /// CHECK-DAG:   <<ObjClassSubA:l\d+>>     InstanceFieldGet field_name:java.lang.Object.shadow$_klass_
+  /// CHECK-DAG:   <<InlineClassSubA:l\d+>>  LoadClass class_name:SubA
+  /// CHECK-DAG:   <<TestSubA:z\d+>>         NotEqual [<<InlineClassSubA>>,<<ObjClassSubA>>]
+  /// CHECK-DAG:                             If [<<TestSubA>>]
+  /// CHECK-DAG:   <<DefaultRet:i\d+>>       InvokeVirtual [<<Obj>>] method_name:Super.getValue
+
+  /// CHECK-DAG:   <<FirstMerge:i\d+>>       Phi [<<SubARet>>,<<DefaultRet>>]
+  /// CHECK-DAG:   <<Ret:i\d+>>              Phi [<<SubBRet>>,<<FirstMerge>>]
+  /// CHECK-DAG:                             Return [<<Ret>>]
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubBSubA(Super) inliner (after)
+  /// CHECK-NOT:                             LoadClass class_name:SubC
+
+  /// CHECK-START: int Main.inlineMegamorphicDominantSubBSubA(Super) inliner (after)
+  /// CHECK-NOT:                             Deoptimize
+  public static int inlineMegamorphicDominantSubBSubA(Super a) {
+    return a.getValue();
+  }
+
+  // No receiver is seen in a quarter of the calls: nothing is inlined.
+
+  /// CHECK-START: int Main.noInlineMegamorphicNoDominant(Super) inliner (before)
+  /// CHECK:       InvokeVirtual method_name:Super.getValue
+
+  /// CHECK-START: int Main.noInlineMegamorphicNoDominant(Super) inliner (after)
+  /// CHECK:       InvokeVirtual method_name:Super.getValue
+
+  /// CHECK-START: int Main.noInlineMegamorphicNoDominant(Super) inliner (after)
+  /// CHECK-NOT:   LoadClass
+  public static int noInlineMegamorphicNoDominant(Super a) {
+    return a.getValue();
+  }
+
+  // Too few calls were profiled for the receiver counts to be meaningful.
+
+  /// CHECK-START: int Main.noInlineMegamorphicFewCalls(Super) inliner (before)
+  /// CHECK:       InvokeVirtual method_name:Super.getValue
+
+  /// CHECK-START: int Main.noInlineMegamorphicFewCalls(Super) inliner (after)
+  /// CHECK:       InvokeVirtual method_name:Super.getValue
+
+  /// CHECK-START: int Main.noInlineMegamorphicFewCalls(Super) inliner (after)
+  /// CHECK-NOT:   LoadClass
+  public static int noInlineMegamorphicFewCalls(Super a) {
+    return a.getValue();
+  }
+
+  public static void assertEquals(int expected, int actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  public static void main(String[] args) {
+    // Call every method with every receiver, to go through both the inlined
+    // targets and the virtual call.
+    Super[] receivers = { new SubA(), new SubB(), new SubC(), new SubD(), new SubE() };
+    int[] values = { 42, 38, 24, 10, -4 };
+    for (int i = 0; i < receivers.length; ++i) {
+      assertEquals(values[i], inlineMegamorphicDominantSubA(receivers[i]));
+      assertEquals(values[i], inlineMegamorphicDominantSubBSubA(receivers[i]));
+      assertEquals(values[i], noInlineMegamorphicNoDominant(receivers[i]));
+      assertEquals(values[i], noInlineMegamorphicFewCalls(receivers[i]));
+    }
+  }
+}
@@ -551,6 +551,96 @@ public class Main {
     return sum;
   }
 
+  //
+  // Min/max reductions.
+  //
+
+  /// CHECK-START-ARM64: int Main.reductionMinInt(int[]) loop_optimization (after)
+  /// CHECK-IF:     not hasIsaFeature("sve")
+  //
+  ///     CHECK-DAG: <<Rep:d\d+>>    VecReplicateScalar [{{i\d+}}] loop:none
+  ///     CHECK-DAG: <<Phi:d\d+>>    Phi [<<Rep>>,{{d\d+}}]        loop:<<Loop:B\d+>> outer_loop:none
+  ///     CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG:                 VecMin [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  ///     CHECK-DAG: <<Extr:i\d+>>   VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-FI:
+  private static int reductionMinInt(int[] x) {
+    int min = Integer.MAX_VALUE;
+    for (int i = 0; i < x.length; i++) {
+      min = Math.min(min, x[i]);
+    }
+    return min;
+  }
+
+  /// CHECK-START-ARM64: int Main.reductionMaxInt(int[]) loop_optimization (after)
+  /// CHECK-IF:     not hasIsaFeature("sve")
+  //
+  ///     CHECK-DAG: <<Rep:d\d+>>    VecReplicateScalar [{{i\d+}}] loop:none
+  ///     CHECK-DAG: <<Phi:d\d+>>    Phi [<<Rep>>,{{d\d+}}]        loop:<<Loop:B\d+>> outer_loop:none
+  ///     CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG:                 VecMax [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  ///     CHECK-DAG: <<Extr:i\d+>>   VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-FI:
+  private static int reductionMaxInt(int[] x) {
+    int max = Integer.MIN_VALUE;
+    for (int i = 0; i < x.length; i++) {
+      max = Math.max(max, x[i]);
+    }
+    return max;
+  }
+
+  /// CHECK-START-ARM64: float Main.reductionMinFloat(float[]) loop_optimization (after)
+  /// CHECK-IF:     not hasIsaFeature("sve")
+  //
+  ///     CHECK-DAG: <<Phi:d\d+>>    Phi [{{d\d+}},{{d\d+}}]       loop:<<Loop:B\d+>> outer_loop:none
+  ///     CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG:                 VecMin [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  ///     CHECK-DAG: <<Extr:f\d+>>   VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-FI:
+  private static float reductionMinFloat(float[] x) {
+    float min = Float.POSITIVE_INFINITY;
+    for (int i = 0; i < x.length; i++) {
+      min = Math.min(min, x[i]);
+    }
+    return min;
+  }
+
+  /// CHECK-START-ARM64: double Main.reductionMaxDouble(double[]) loop_optimization (after)
+  /// CHECK-IF:     not hasIsaFeature("sve")
+  //
+  ///     CHECK-DAG: <<Phi:d\d+>>    Phi [{{d\d+}},{{d\d+}}]       loop:<<Loop:B\d+>> outer_loop:none
+  ///     CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG:                 VecMax [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  ///     CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  ///     CHECK-DAG: <<Extr:d\d+>>   VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-FI:
+  private static double reductionMaxDouble(double[] x) {
+    double max = Double.NEGATIVE_INFINITY;
+    for (int i = 0; i < x.length; i++) {
+      max = Math.max(max, x[i]);
+    }
+    return max;
+  }
+
+  // Floating-point addition is not associative, so this must stay sequential.
+
+  /// CHECK-START: float Main.reductionFloat(float[]) loop_optimization (after)
+  /// CHECK-NOT: VecReduce
+  private static float reductionFloat(float[] x) {
+    float sum = 0;
+    for (int i = 0; i < x.length; i++) {
+      sum += x[i];
+    }
+    return sum;
+  }
+
   //
   // A few special cases.
   //
@@ -585,11 +675,15 @@ public class Main {
     char[] xc = new char[N];
     int[] xi = new int[N];
     long[] xl = new long[N];
+    float[] xf = new float[N];
+    double[] xd = new double[N];
     for (int i = 0, k = -17; i < N; i++, k += 3) {
       xb[i] = (byte) k;
       xs[i] = (short) k;
       xc[i] = (char) k;
       xi[i] = k;
+      xf[i] = k;
+      xd[i] = k;
       xl[i] = k;
     }
 
@@ -654,6 +748,18 @@ public class Main {
     expectEquals(-365750, reductionMinusInt(xi));
     expectEquals(-365750L, reductionMinusLong(xl));
 
+    // Test min/max reductions.
+    expectEquals(-17, reductionMinInt(xi));
+    expectEquals(1480, reductionMaxInt(xi));
+    expectEquals(-17.0f, reductionMinFloat(xf));
+    expectEquals(1480.0, reductionMaxDouble(xd));
+    expectEquals(4.0f, reductionFloat(new float[] { 0.5f, 1.0f, 1.5f, 1.0f }));
+    xf[N / 2] = Float.NaN;
+    xd[N / 2] = Double.NaN;
+    expectEquals(Float.NaN, reductionMinFloat(xf));
+    expectEquals(Double.NaN, reductionMaxDouble(xd));
+    expectEquals(-0.0f, reductionMinFloat(new float[] { 0.0f, -0.0f, 0.0f, 0.0f, 1.0f }));
+
     // Test special cases.
     expectEquals(13, reductionInt10(xi));
     expectEquals(-13, reductionMinusInt10(xi));
@@ -672,4 +778,16 @@ public class Main {
       throw new Error("Expected: " + expected + ", found: " + result);
     }
   }
+
+  private static void expectEquals(float expected, float result) {
+    if (Float.compare(expected, result) != 0) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  private static void expectEquals(double expected, double result) {
+    if (Double.compare(expected, result) != 0) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
 }
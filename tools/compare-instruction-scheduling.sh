@@ -0,0 +1,68 @@
+#!/bin/bash
+#
+# Copyright (C) 2023 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# This script runs the loop kernels of benchmark/loop-kernels on the host, compiled ahead of
+# time once with instruction scheduling and once without, and reports the time per iteration
+# of each kernel for both compilations. Use it to validate changes to the latency models of
+# the instruction scheduler (compiler/optimizing/scheduler_*.cc).
+#
+# The first argument is a dex jar of the benchmark, built for example with:
+#   javac -d classes art/benchmark/loop-kernels/src/LoopKernelsBenchmark.java
+#   d8 --output loop-kernels.jar classes/LoopKernelsBenchmark.class
+#
+# Extra arguments are passed on to tools/art, e.g. to use the debug runtime:
+#   $0 loop-kernels.jar 2000 -d
+#
+
+if [[ "$#" -lt 1 ]]; then
+  echo "Usage $0 <dex jar> [iterations] [args]+"
+  echo "Example $0 loop-kernels.jar 2000"
+  exit 1
+fi
+
+JAR=$1
+shift
+COUNT=${1:-1000}
+[[ "$#" -gt 0 ]] && shift
+
+OUT_DIR=$(mktemp -d)
+trap 'rm -rf "$OUT_DIR"' EXIT
+
+for scheduling in true false; do
+  LOG="$OUT_DIR/$scheduling.log"
+  if ! $ANDROID_BUILD_TOP/art/tools/art --64 "$@" \
+      -Xusejit:false \
+      -Xcompiler-option --compiler-filter=speed \
+      -Xcompiler-option --instruction-scheduling=$scheduling \
+      -cp "$JAR" LoopKernelsBenchmark "$COUNT" > "$LOG" 2>&1; then
+    echo "Run with --instruction-scheduling=$scheduling failed, see the log below."
+    cat "$LOG"
+    exit 1
+  fi
+done
+
+printf "%-24s %14s %16s %8s\n" "kernel" "scheduled(ns)" "unscheduled(ns)" "ratio"
+grep -o "^[A-Za-z]*: [0-9]* ns" "$OUT_DIR/true.log" | while read -r kernel scheduled unit; do
+  kernel=${kernel%:}
+  unscheduled=$(grep -o "^$kernel: [0-9]*" "$OUT_DIR/false.log" | awk '{ print $2 }')
+  if [[ -z "$unscheduled" || "$unscheduled" -eq 0 ]]; then
+    ratio="-"
+  else
+    ratio=$(echo "scale=3; $scheduled / $unscheduled" | bc)
+  fi
+  printf "%-24s %14s %16s %8s\n" "$kernel" "$scheduled" "${unscheduled:--}" "$ratio"
+done
@@ -0,0 +1,67 @@
+#!/bin/bash
+#
+# Copyright (C) 2023 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# This script compiles a provided JAR or APK on the host once per register allocation
+# strategy and reports, for each strategy, the compile time, the number of moves to and
+# from the stack inserted by the register allocator, and the size of the generated code.
+#
+# Extra arguments are passed on to compile-jar.py, e.g. to compile with a profile:
+#   $0 Maps.apk arm64 --profile-file=maps.prof --compiler-filter=speed-profile
+#
+
+if [[ "$#" -lt 2 ]]; then
+  echo "Usage $0 <jar|apk> <isa> [args]+"
+  echo "Example $0 Maps.apk arm64"
+  exit 1
+fi
+
+FILE=$1
+shift
+ISA=$1
+shift
+
+STRATEGIES=${STRATEGIES:-"linear-scan graph-color-hot graph-color"}
+STATS="RegisterAllocatorGraphColor RegisterAllocatorGraphColorOverBudget"
+STATS="$STATS RegisterAllocatorStackMoves CompiledBytecodeCodeSize"
+
+OUT_DIR=$(mktemp -d)
+trap 'rm -rf "$OUT_DIR"' EXIT
+
+printf "%-20s %10s" "strategy" "time(s)"
+for stat in $STATS; do
+  printf " %s" "$stat"
+done
+printf "\n"
+
+for strategy in $STRATEGIES; do
+  LOG="$OUT_DIR/$strategy.log"
+  START=$(date +%s.%N)
+  if ! $ANDROID_BUILD_TOP/art/tools/compile-jar.py --arch=$ISA \
+      --odex-file="$OUT_DIR/$strategy.odex" "$FILE" \
+      --dump-stats --register-allocation-strategy=$strategy "$@" > "$LOG" 2>&1; then
+    echo "Compilation with $strategy failed, see the log below."
+    cat "$LOG"
+    exit 1
+  fi
+  END=$(date +%s.%N)
+  printf "%-20s %10.2f" "$strategy" "$(echo "$END - $START" | bc)"
+  for stat in $STATS; do
+    VALUE=$(grep -o "OptStat#$stat: [0-9]*" "$LOG" | awk '{ print $2 }')
+    printf " %${#stat}s" "${VALUE:-0}"
+  done
+  printf "\n"
+done
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Convert a compressed streaming method trace (-Xmethod-trace-stream-compressed) into the
+ * non-streaming format read by dmtracedump and other trace viewers. See runtime/trace.h for a
+ * description of both formats.
+ */
+#include <errno.h>
+#include <lz4.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kTraceMagicValue = 0x574f4c53;
+constexpr uint32_t kTraceCompressedMagicValue = 0x5a4f4c53;
+constexpr uint16_t kTraceHeaderLength = 32;
+constexpr uint16_t kTraceVersionDualClock = 3;
+
+constexpr uint8_t kOpNewMethod = 1;
+constexpr uint8_t kOpNewThread = 2;
+constexpr uint8_t kOpCompressedEvents = 4;
+
+constexpr uint8_t kCompressedBlockRecords = 1;
+constexpr uint8_t kCompressedBlockSummary = 2;
+constexpr size_t kCompressedBlockHeaderSize = 9;
+
+constexpr uint16_t kClockThreadCpu = 1;
+constexpr uint16_t kClockWall = 2;
+
+constexpr int kTraceActionBits = 2;
+
+uint32_t Read2LE(const uint8_t* buf) {
+  return buf[0] | (buf[1] << 8);
+}
+
+uint32_t Read4LE(const uint8_t* buf) {
+  return buf[0] | (buf[1] << 8) | (buf[2] << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+}
+
+void Append2LE(std::vector<uint8_t>* out, uint16_t val) {
+  out->push_back(static_cast<uint8_t>(val));
+  out->push_back(static_cast<uint8_t>(val >> 8));
+}
+
+void Append4LE(std::vector<uint8_t>* out, uint32_t val) {
+  out->push_back(static_cast<uint8_t>(val));
+  out->push_back(static_cast<uint8_t>(val >> 8));
+  out->push_back(static_cast<uint8_t>(val >> 16));
+  out->push_back(static_cast<uint8_t>(val >> 24));
+}
+
+// Bounds-checked reader of a decompressed records block.
+class BlockReader {
+ public:
+  BlockReader(const uint8_t* data, size_t size) : ptr_(data), end_(data + size) {}
+
+  bool AtEnd() const { return ptr_ == end_; }
+
+  bool ReadByte(uint8_t* value) {
+    if (ptr_ == end_) {
+      return false;
+    }
+    *value = *ptr_++;
+    return true;
+  }
+
+  bool ReadUnsignedLeb128(uint32_t* value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(&byte)) {
+        return false;
+      }
+      result |= static_cast<uint32_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadSignedLeb128(int32_t* value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(&byte)) {
+        return false;
+      }
+      result |= static_cast<uint32_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        shift += 7;
+        if (shift < 32 && (byte & 0x40) != 0) {
+          // Sign extend.
+          result |= ~0u << shift;
+        }
+        *value = static_cast<int32_t>(result);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadString(size_t length, std::string* value) {
+    if (static_cast<size_t>(end_ - ptr_) < length) {
+      return false;
+    }
+    value->assign(reinterpret_cast<const char*>(ptr_), length);
+    ptr_ += length;
+    return true;
+  }
+
+ private:
+  const uint8_t* ptr_;
+  const uint8_t* const end_;
+};
+
+class TraceConverter {
+ public:
+  bool ReadHeader(FILE* in) {
+    uint8_t header[kTraceHeaderLength];
+    if (fread(header, 1, sizeof(header), in) != sizeof(header)) {
+      fprintf(stderr, "Truncated trace header\n");
+      return false;
+    }
+    if (Read4LE(header) != kTraceCompressedMagicValue) {
+      fprintf(stderr, "Not a compressed method trace\n");
+      return false;
+    }
+    version_ = Read2LE(header + 4);
+    uint32_t data_offset = Read2LE(header + 6);
+    start_time_ = Read4LE(header + 8) | (static_cast<uint64_t>(Read4LE(header + 12)) << 32);
+    record_size_ = Read2LE(header + 16);
+    clock_ = Read2LE(header + 18);
+    if (data_offset != kTraceHeaderLength) {
+      fprintf(stderr, "Unexpected data offset %u\n", data_offset);
+      return false;
+    }
+    return true;
+  }
+
+  bool ReadBlocks(FILE* in) {
+    std::vector<uint8_t> stored;
+    std::vector<uint8_t> block;
+    while (true) {
+      uint8_t header[kCompressedBlockHeaderSize];
+      size_t read = fread(header, 1, sizeof(header), in);
+      if (read == 0) {
+        return true;
+      }
+      if (read != sizeof(header)) {
+        fprintf(stderr, "Warning: truncated block header, ignoring the rest of the trace\n");
+        return true;
+      }
+      uint8_t type = header[0];
+      uint32_t size = Read4LE(header + 1);
+      uint32_t stored_size = Read4LE(header + 5);
+      stored.resize(stored_size);
+      if (fread(stored.data(), 1, stored_size, in) != stored_size) {
+        fprintf(stderr, "Warning: truncated block, ignoring the rest of the trace\n");
+        return true;
+      }
+      if (stored_size == size) {
+        block.swap(stored);
+      } else {
+        block.resize(size);
+        int decompressed = LZ4_decompress_safe(reinterpret_cast<const char*>(stored.data()),
+                                               reinterpret_cast<char*>(block.data()),
+                                               stored_size,
+                                               size);
+        if (decompressed < 0 || static_cast<uint32_t>(decompressed) != size) {
+          fprintf(stderr, "Corrupted block\n");
+          return false;
+        }
+      }
+      if (type == kCompressedBlockSummary) {
+        summary_.assign(reinterpret_cast<const char*>(block.data()), block.size());
+      } else if (type == kCompressedBlockRecords) {
+        if (!DecodeRecords(block.data(), block.size())) {
+          fprintf(stderr, "Corrupted records block\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr, "Unknown block type %u\n", type);
+        return false;
+      }
+    }
+  }
+
+  bool Write(FILE* out) {
+    if (summary_.empty()) {
+      // The trace did not finish properly, rebuild the summary from the records.
+      fprintf(stderr, "Warning: no trace summary, the trace may be incomplete\n");
+      summary_ = BuildSummary();
+    }
+    std::vector<uint8_t> header;
+    Append4LE(&header, kTraceMagicValue);
+    Append2LE(&header, version_);
+    Append2LE(&header, kTraceHeaderLength);
+    for (int i = 0; i < 8; ++i) {
+      header.push_back(static_cast<uint8_t>(start_time_ >> (i * 8)));
+    }
+    if (version_ >= kTraceVersionDualClock) {
+      Append2LE(&header, record_size_);
+    }
+    header.resize(kTraceHeaderLength, 0);
+    return fwrite(summary_.data(), 1, summary_.size(), out) == summary_.size() &&
+           fwrite(header.data(), 1, header.size(), out) == header.size() &&
+           fwrite(records_.data(), 1, records_.size(), out) == records_.size();
+  }
+
+ private:
+  bool DecodeRecords(const uint8_t* data, size_t size) {
+    BlockReader reader(data, size);
+    while (!reader.AtEnd()) {
+      uint8_t op;
+      uint32_t id;
+      uint32_t length;
+      std::string text;
+      if (!reader.ReadByte(&op) || !reader.ReadUnsignedLeb128(&id)) {
+        return false;
+      }
+      switch (op) {
+        case kOpNewThread:
+        case kOpNewMethod:
+          if (!reader.ReadUnsignedLeb128(&length) || !reader.ReadString(length, &text)) {
+            return false;
+          }
+          if (op == kOpNewThread) {
+            threads_[static_cast<uint16_t>(id)] = text;
+          } else {
+            methods_.push_back(text);
+          }
+          break;
+        case kOpCompressedEvents:
+          if (!reader.ReadUnsignedLeb128(&length) || !DecodeEvents(&reader, id, length)) {
+            return false;
+          }
+          break;
+        default:
+          return false;
+      }
+    }
+    return true;
+  }
+
+  bool DecodeEvents(BlockReader* reader, uint32_t tid, uint32_t num_events) {
+    uint32_t method_index = 0;
+    uint32_t thread_time = 0;
+    uint32_t wall_time = 0;
+    for (uint32_t i = 0; i != num_events; ++i) {
+      int32_t value;
+      if (!reader->ReadSignedLeb128(&value)) {
+        return false;
+      }
+      uint32_t action = static_cast<uint32_t>(value) & ((1u << kTraceActionBits) - 1u);
+      method_index += static_cast<uint32_t>(value >> kTraceActionBits);
+      if ((clock_ & kClockThreadCpu) != 0) {
+        if (!reader->ReadSignedLeb128(&value)) {
+          return false;
+        }
+        thread_time += static_cast<uint32_t>(value);
+      }
+      if ((clock_ & kClockWall) != 0) {
+        if (!reader->ReadSignedLeb128(&value)) {
+          return false;
+        }
+        wall_time += static_cast<uint32_t>(value);
+      }
+      // Same layout as Trace::EncodeEventEntry.
+      Append2LE(&records_, static_cast<uint16_t>(tid));
+      Append4LE(&records_, (method_index << kTraceActionBits) | action);
+      if ((clock_ & kClockThreadCpu) != 0) {
+        Append4LE(&records_, thread_time);
+      }
+      if ((clock_ & kClockWall) != 0) {
+        Append4LE(&records_, wall_time);
+      }
+      ++num_events_;
+    }
+    return true;
+  }
+
+  std::string BuildSummary() const {
+    std::string summary = "*version\n" + std::to_string(version_) + "\n";
+    summary += "data-file-overflow=false\n";
+    if ((clock_ & kClockThreadCpu) != 0) {
+      summary += ((clock_ & kClockWall) != 0) ? "clock=dual\n" : "clock=thread-cpu\n";
+    } else {
+      summary += "clock=wall\n";
+    }
+    summary += "num-method-calls=" + std::to_string(num_events_) + "\n";
+    summary += "vm=art\n";
+    summary += "*threads\n";
+    for (const auto& thread : threads_) {
+      summary += std::to_string(thread.first) + "\t" + thread.second + "\n";
+    }
+    summary += "*methods\n";
+    for (const std::string& method_line : methods_) {
+      // Method lines already end with a newline.
+      summary += method_line;
+    }
+    summary += "*end\n";
+    return summary;
+  }
+
+  uint16_t version_ = 0;
+  uint16_t record_size_ = 0;
+  uint16_t clock_ = 0;
+  uint64_t start_time_ = 0;
+  uint64_t num_events_ = 0;
+  std::string summary_;
+  std::map<uint16_t, std::string> threads_;
+  std::vector<std::string> methods_;
+  std::vector<uint8_t> records_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <compressed trace> <output trace>\n", argv[0]);
+    return 2;
+  }
+  FILE* in = fopen(argv[1], "rb");
+  if (in == nullptr) {
+    fprintf(stderr, "Could not open %s: %s\n", argv[1], strerror(errno));
+    return 1;
+  }
+  TraceConverter converter;
+  bool success = converter.ReadHeader(in) && converter.ReadBlocks(in);
+  fclose(in);
+  if (!success) {
+    return 1;
+  }
+  FILE* out = fopen(argv[2], "wb");
+  if (out == nullptr) {
+    fprintf(stderr, "Could not open %s: %s\n", argv[2], strerror(errno));
+    return 1;
+  }
+  success = converter.Write(out);
+  if (fclose(out) != 0 || !success) {
+    fprintf(stderr, "Could not write %s\n", argv[2]);
+    return 1;
+  }
+  return 0;
+}